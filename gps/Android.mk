@@ -1,9 +1,13 @@
 ifneq ($(BOARD_VENDOR_QCOM_GPS_LOC_API_HARDWARE),)
 
+# Highest LOC_LOGx level compiled in, 1 (error) through 5 (verbose)
+GNSS_LOG_COMPILE_LEVEL ?= 5
+
 # Set required flags
 GNSS_CFLAGS := \
     -Werror \
-    -Wno-undefined-bool-conversion
+    -Wno-undefined-bool-conversion \
+    -DLOC_LOG_COMPILE_LEVEL=$(GNSS_LOG_COMPILE_LEVEL)
 
 LOCAL_PATH := $(call my-dir)
 include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -20,6 +20,7 @@
 
 #define LOG_TAG "LocSvc__AGnssRilInterface"
 
+#include <inttypes.h>
 #include <log_util.h>
 #include <dlfcn.h>
 #include <sys/types.h>
@@ -30,6 +31,8 @@
 #include "Gnss.h"
 #include "AGnssRil.h"
 #include <DataItemConcreteTypesBase.h>
+#include <loc_cfg.h>
+#include <loc_misc_utils.h>
 
 typedef void* (getLocationInterface)();
 
@@ -40,12 +43,82 @@ namespace V2_1 {
 namespace implementation {
 
 
-AGnssRil::AGnssRil(Gnss* gnss) : mGnss(gnss) {
+AGnssRil::AGnssRil(Gnss* gnss) : mGnss(gnss), mCoalesceTimer(*this) {
     ENTRY_LOG_CALLFLOW();
+    const loc_param_s_type coalesceConfTable[] =
+    {
+        {"NETWORK_STATE_COALESCE_MSEC", &mCoalesceMsec, NULL, 'n'}
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, coalesceConfTable);
+    LOC_LOGd("NETWORK_STATE_COALESCE_MSEC: %u", mCoalesceMsec);
 }
 
 AGnssRil::~AGnssRil() {
     ENTRY_LOG_CALLFLOW();
+    mCoalesceTimer.stop();
+}
+
+// called with mMutex held, so states reach the adapter in the order they are sent
+void AGnssRil::sendNetworkState(NetworkHandle handle, NetworkState& state) {
+    if (nullptr != mGnss && (nullptr != mGnss->getGnssInterface())) {
+        mGnss->getGnssInterface()->updateConnectionStatus(state.mConnected, state.mType,
+                state.mRoaming, handle, state.mApn);
+    }
+}
+
+void AGnssRil::reportNetworkState(NetworkHandle handle, NetworkState&& state) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (0 == mCoalesceMsec) {
+        sendNetworkState(handle, state);
+        return;
+    }
+
+    for (auto& pending : mPending) {
+        if (pending.first == handle) {
+            LOC_LOGv("network %" PRIu64 " coalesced", (uint64_t)handle);
+            pending.second = std::move(state);
+            return;
+        }
+    }
+    uint64_t nowMs = getBootTimeMilliSec();
+    auto titer = mSentTimeMs.find(handle);
+    if (titer == mSentTimeMs.end() || nowMs - titer->second >= mCoalesceMsec) {
+        mSentTimeMs[handle] = nowMs;
+        sendNetworkState(handle, state);
+        mSent[handle] = std::move(state);
+        return;
+    }
+
+    LOC_LOGv("network %" PRIu64 " coalesced", (uint64_t)handle);
+    mPending.emplace_back(handle, std::move(state));
+    if (!mCoalesceTimerArmed) {
+        mCoalesceTimerArmed = true;
+        mCoalesceTimer.start(mCoalesceMsec, false);
+    }
+}
+
+void AGnssRil::flushCoalesced() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCoalesceTimerArmed = false;
+
+    uint64_t nowMs = getBootTimeMilliSec();
+    for (auto& pending : mPending) {
+        auto siter = mSent.find(pending.first);
+        if (siter != mSent.end() && siter->second == pending.second) {
+            LOC_LOGv("network %" PRIu64 " back to last sent state, dropped",
+                     (uint64_t)pending.first);
+            continue;
+        }
+        sendNetworkState(pending.first, pending.second);
+        mSentTimeMs[pending.first] = nowMs;
+        mSent[pending.first] = std::move(pending.second);
+    }
+    mPending.clear();
+}
+
+// Called in the context of LocTimer thread
+void AGnssRil::CoalesceTimer::timeOutCallback() {
+    mRil.flushCoalesced();
 }
 
 Return<bool> AGnssRil::updateNetworkState(bool connected, NetworkType type, bool /*roaming*/) {
@@ -103,7 +176,7 @@ Return<bool> AGnssRil::updateNetworkState(bool connected, NetworkType type, bool
                 }
                 break;
         }
-        mGnss->getGnssInterface()->updateConnectionStatus(connected, typeout, false, 0, apn);
+        reportNetworkState(0, { connected, typeout, false, std::move(apn) });
     }
     return true;
 }
@@ -122,8 +195,8 @@ Return<bool> AGnssRil::updateNetworkState_2_0(const V2_0::IAGnssRil::NetworkAttr
             roaming = false;
         }
         LOC_LOGd("apn string received is: %s", apn.c_str());
-        mGnss->getGnssInterface()->updateConnectionStatus(attributes.isConnected,
-                typeout, roaming, (NetworkHandle) attributes.networkHandle, apn);
+        reportNetworkState((NetworkHandle) attributes.networkHandle,
+                { attributes.isConnected, typeout, roaming, std::move(apn) });
     }
     return true;
 }
@@ -24,6 +24,11 @@
 #include <android/hardware/gnss/2.0/IAGnssRil.h>
 #include <hidl/Status.h>
 #include <location_interface.h>
+#include <LocTimer.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 namespace android {
 namespace hardware {
@@ -73,6 +78,39 @@ struct AGnssRil : public V2_0::IAGnssRil {
 
  private:
     Gnss* mGnss = nullptr;
+
+    struct NetworkState {
+        bool mConnected;
+        int8_t mType;
+        bool mRoaming;
+        std::string mApn;
+        inline bool operator==(const NetworkState& peer) const {
+            return mConnected == peer.mConnected && mType == peer.mType &&
+                    mRoaming == peer.mRoaming && mApn == peer.mApn;
+        }
+    };
+    // Burst coalescing, per network handle: the first change after a quiet
+    // period goes to the adapter right away, further changes within
+    // NETWORK_STATE_COALESCE_MSEC of it are held back and only the latest
+    // one is sent when the window closes, unless it is what was last sent.
+    class CoalesceTimer : public loc_util::LocTimer {
+        AGnssRil& mRil;
+    public:
+        inline CoalesceTimer(AGnssRil& ril) : LocTimer(), mRil(ril) {}
+        virtual void timeOutCallback() override;
+    };
+    void reportNetworkState(NetworkHandle handle, NetworkState&& state);
+    void sendNetworkState(NetworkHandle handle, NetworkState& state);
+    void flushCoalesced();
+
+    std::mutex mMutex;
+    uint32_t mCoalesceMsec = 0;
+    CoalesceTimer mCoalesceTimer;
+    bool mCoalesceTimerArmed = false;
+    std::unordered_map<NetworkHandle, NetworkState> mSent;
+    std::unordered_map<NetworkHandle, uint64_t> mSentTimeMs;
+    // in arrival order, at most one per handle
+    std::vector<std::pair<NetworkHandle, NetworkState>> mPending;
 };
 
 }  // namespace implementation
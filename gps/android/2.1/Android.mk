@@ -25,7 +25,9 @@ LOCAL_SRC_FILES += \
     location_api/MeasurementAPIClient.cpp \
     location_api/GeofenceAPIClient.cpp \
     location_api/BatchingAPIClient.cpp \
+    location_api/HidlCallbackDispatcher.cpp \
     location_api/LocationUtil.cpp \
+    location_api/MeasurementUtil.cpp \
 
 ifeq ($(GNSS_HIDL_LEGACY_MEASURMENTS),true)
 LOCAL_CFLAGS += \
@@ -113,3 +115,68 @@ LOCAL_CFLAGS += -DLOC_HIDL_VERSION='"$(LOC_HIDL_VERSION)"'
 endif
 
 include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_location_util_bench
+LOCAL_VENDOR_MODULE := true
+LOCAL_SRC_FILES := \
+    location_api/LocationUtilBench.cpp \
+    location_api/LocationUtil.cpp \
+
+LOCAL_C_INCLUDES:= \
+    $(LOCAL_PATH)/location_api
+
+LOCAL_HEADER_LIBRARIES := \
+    libgps.utils_headers \
+    libloc_core_headers \
+    libloc_pla_headers \
+    liblocation_api_headers
+
+LOCAL_SHARED_LIBRARIES := \
+    liblog \
+    libhidlbase \
+    libcutils \
+    libutils \
+    libgps.utils \
+    android.hardware.gnss@1.0 \
+    android.hardware.gnss@1.1 \
+    android.hardware.gnss@2.0 \
+    android.hardware.gnss@2.1 \
+    android.hardware.gnss.measurement_corrections@1.0 \
+    android.hardware.gnss.measurement_corrections@1.1 \
+
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := loc_measurement_util_bench
+LOCAL_VENDOR_MODULE := true
+LOCAL_SRC_FILES := \
+    location_api/MeasurementUtilBench.cpp \
+    location_api/MeasurementUtil.cpp \
+    location_api/LocationUtil.cpp \
+
+LOCAL_C_INCLUDES:= \
+    $(LOCAL_PATH)/location_api
+
+LOCAL_HEADER_LIBRARIES := \
+    libgps.utils_headers \
+    libloc_core_headers \
+    libloc_pla_headers \
+    liblocation_api_headers
+
+LOCAL_SHARED_LIBRARIES := \
+    liblog \
+    libhidlbase \
+    libcutils \
+    libutils \
+    libgps.utils \
+    android.hardware.gnss@1.0 \
+    android.hardware.gnss@1.1 \
+    android.hardware.gnss@2.0 \
+    android.hardware.gnss@2.1 \
+    android.hardware.gnss.measurement_corrections@1.0 \
+    android.hardware.gnss.measurement_corrections@1.1 \
+
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+include $(BUILD_EXECUTABLE)
@@ -22,11 +22,19 @@
 #define LOG_NDEBUG 0
 
 #include <fstream>
+#include <functional>
 #include <log_util.h>
 #include <dlfcn.h>
+#include <unistd.h>
 #include <cutils/properties.h>
+#include <inttypes.h>
+#include <MsgTask.h>
+#include <LocIpc.h>
+#include <LocMemStats.h>
+#include <LocationAPI.h>
 #include "Gnss.h"
 #include "LocationUtil.h"
+#include "HidlCallbackDispatcher.h"
 #include "battery_listener.h"
 #include "loc_misc_utils.h"
 
@@ -34,6 +42,8 @@ typedef const GnssInterface* (getLocationInterface)();
 
 #define IMAGES_INFO_FILE "/sys/devices/soc0/images"
 #define DELIMITER ";"
+// bumped whenever the framing of the debug dump changes
+#define GNSS_DEBUG_DUMP_VERSION 1
 
 namespace android {
 namespace hardware {
@@ -88,6 +98,26 @@ void Gnss::GnssDeathRecipient::serviceDied(uint64_t cookie, const wp<IBase>& who
     if (mGnss != nullptr) {
         mGnss->getGnssInterface()->resetNetworkInfo();
         mGnss->cleanup();
+        mGnss->detachClient();
+    }
+}
+
+// The GnssAPIClient, with its LocationAPI and adapter registration, outlives
+// the framework client, so a restarted system_server is back to getting
+// fixes as soon as it calls setCallback and start again.
+void Gnss::detachClient() {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+    if (mApi != nullptr) {
+        mApi->gnssDetachCallbacks();
+    }
+    mClientDiedMs = getBootTimeMilliSec();
+}
+
+void Gnss::onClientAttached() {
+    if (0 != mClientDiedMs) {
+        LOC_LOGi("framework client attached %" PRIu64 " ms after the previous one died",
+                 getBootTimeMilliSec() - mClientDiedMs);
+        mClientDiedMs = 0;
     }
 }
 
@@ -119,6 +149,7 @@ Gnss::~Gnss() {
 }
 
 GnssAPIClient* Gnss::getApi() {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mApi != nullptr) {
         return mApi;
     }
@@ -150,6 +181,7 @@ GnssAPIClient* Gnss::getApi() {
 }
 
 const GnssInterface* Gnss::getGnssInterface() {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     static bool getGnssInterfaceFailed = false;
     if (mGnssInterface == nullptr && !getGnssInterfaceFailed) {
         void * libHandle = nullptr;
@@ -166,6 +198,7 @@ const GnssInterface* Gnss::getGnssInterface() {
 
 Return<bool> Gnss::setCallback(const sp<V1_0::IGnssCallback>& callback)  {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
 
     // In case where previous call to setCallback_1_1/setCallback_2_0/setCallback_2_1, then
     // we need to cleanup these interfaces/callbacks here since we no longer
@@ -201,12 +234,14 @@ Return<bool> Gnss::setCallback(const sp<V1_0::IGnssCallback>& callback)  {
         api->gnssUpdateCallbacks(mGnssCbIface, mGnssNiCbIface);
         api->gnssEnable(LOCATION_TECHNOLOGY_TYPE_GNSS);
         api->requestCapabilities();
+        onClientAttached();
     }
     return true;
 }
 
 Return<bool> Gnss::setGnssNiCb(const sp<IGnssNiCallback>& callback) {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     mGnssNiCbIface = callback;
     GnssAPIClient* api = getApi();
     if (api != nullptr) {
@@ -217,6 +252,7 @@ Return<bool> Gnss::setGnssNiCb(const sp<IGnssNiCallback>& callback) {
 
 Return<bool> Gnss::updateConfiguration(GnssConfig& gnssConfig) {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     GnssAPIClient* api = getApi();
     if (api) {
         api->gnssConfigurationUpdate(gnssConfig);
@@ -305,6 +341,7 @@ Return<bool> Gnss::stop()  {
 
 Return<void> Gnss::cleanup()  {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
 
     if (mApi != nullptr) {
         mApi->gnssStop();
@@ -370,6 +407,7 @@ Return<sp<V1_0::IGnssNi>> Gnss::getExtensionGnssNi()  {
 
 Return<sp<V1_0::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssMeasurement == nullptr) {
         mGnssMeasurement = new GnssMeasurement();
     }
@@ -378,6 +416,7 @@ Return<sp<V1_0::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement() {
 
 Return<sp<V1_0::IGnssConfiguration>> Gnss::getExtensionGnssConfiguration()  {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssConfig == nullptr) {
         mGnssConfig = new GnssConfiguration(this);
     }
@@ -386,6 +425,7 @@ Return<sp<V1_0::IGnssConfiguration>> Gnss::getExtensionGnssConfiguration()  {
 
 Return<sp<V1_0::IGnssGeofencing>> Gnss::getExtensionGnssGeofencing()  {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssGeofencingIface == nullptr) {
         mGnssGeofencingIface = new GnssGeofencing();
     }
@@ -394,6 +434,7 @@ Return<sp<V1_0::IGnssGeofencing>> Gnss::getExtensionGnssGeofencing()  {
 
 Return<sp<V1_0::IGnssBatching>> Gnss::getExtensionGnssBatching()  {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssBatching == nullptr) {
         mGnssBatching = new GnssBatching();
     }
@@ -402,6 +443,7 @@ Return<sp<V1_0::IGnssBatching>> Gnss::getExtensionGnssBatching()  {
 
 Return<sp<V1_0::IGnssDebug>> Gnss::getExtensionGnssDebug() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssDebug == nullptr) {
         mGnssDebug = new GnssDebug(this);
     }
@@ -410,6 +452,7 @@ Return<sp<V1_0::IGnssDebug>> Gnss::getExtensionGnssDebug() {
 
 Return<sp<V1_0::IAGnssRil>> Gnss::getExtensionAGnssRil() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssRil == nullptr) {
         mGnssRil = new AGnssRil(this);
     }
@@ -425,6 +468,7 @@ Return<bool> Gnss::setCallback_1_1(const sp<V1_1::IGnssCallback>& callback) {
                 __func__, r.description().c_str());
     }
 
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     // In case where previous call to setCallback/setCallback_2_0/setCallback_2_1, then
     // we need to cleanup these interfaces/callbacks here since we no longer
     // do so in cleanup() function to keep callbacks around after cleanup()
@@ -467,6 +511,7 @@ Return<bool> Gnss::setCallback_1_1(const sp<V1_1::IGnssCallback>& callback) {
         api->gnssUpdateCallbacks(mGnssCbIface_1_1, mGnssNiCbIface);
         api->gnssEnable(LOCATION_TECHNOLOGY_TYPE_GNSS);
         api->requestCapabilities();
+        onClientAttached();
     }
 
     return true;
@@ -492,6 +537,7 @@ Return<bool> Gnss::setPositionMode_1_1(V1_0::IGnss::GnssPositionMode mode,
 
 Return<sp<V1_1::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement_1_1() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
 #ifdef GNSS_HIDL_LEGACY_MEASURMENTS
     return nullptr;
 #else
@@ -503,6 +549,7 @@ Return<sp<V1_1::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement_1_1() {
 
 Return<sp<V1_1::IGnssConfiguration>> Gnss::getExtensionGnssConfiguration_1_1() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssConfig == nullptr)
         mGnssConfig = new GnssConfiguration(this);
     return mGnssConfig;
@@ -524,37 +571,46 @@ void Gnss::odcpiRequestCb(const OdcpiRequestInfo& request) {
     if (ODCPI_REQUEST_TYPE_STOP == request.type) {
         return;
     }
-    if (mGnssCbIface_2_1 != nullptr) {
+    sp<V1_1::IGnssCallback> gnssCbIface_1_1;
+    sp<V2_0::IGnssCallback> gnssCbIface_2_0;
+    sp<V2_1::IGnssCallback> gnssCbIface_2_1;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        gnssCbIface_1_1 = mGnssCbIface_1_1;
+        gnssCbIface_2_0 = mGnssCbIface_2_0;
+        gnssCbIface_2_1 = mGnssCbIface_2_1;
+    }
+    if (gnssCbIface_2_1 != nullptr) {
         // For emergency mode, request DBH (Device based hybrid) location
         // Mark Independent from GNSS flag to false.
         if (ODCPI_REQUEST_TYPE_START == request.type) {
             LOC_LOGd("gnssRequestLocationCb_2_1 isUserEmergency = %d", request.isEmergencyMode);
-            auto r = mGnssCbIface_2_1->gnssRequestLocationCb_2_0(!request.isEmergencyMode,
-                                                                 request.isEmergencyMode);
+            auto r = gnssCbIface_2_1->gnssRequestLocationCb_2_0(!request.isEmergencyMode,
+                                                                request.isEmergencyMode);
             if (!r.isOk()) {
                 LOC_LOGe("Error invoking gnssRequestLocationCb_2_0 %s", r.description().c_str());
             }
         } else {
             LOC_LOGv("Unsupported ODCPI request type: %d", request.type);
         }
-    } else if (mGnssCbIface_2_0 != nullptr) {
+    } else if (gnssCbIface_2_0 != nullptr) {
         // For emergency mode, request DBH (Device based hybrid) location
         // Mark Independent from GNSS flag to false.
         if (ODCPI_REQUEST_TYPE_START == request.type) {
             LOC_LOGd("gnssRequestLocationCb_2_0 isUserEmergency = %d", request.isEmergencyMode);
-            auto r = mGnssCbIface_2_0->gnssRequestLocationCb_2_0(!request.isEmergencyMode,
-                                                                 request.isEmergencyMode);
+            auto r = gnssCbIface_2_0->gnssRequestLocationCb_2_0(!request.isEmergencyMode,
+                                                                request.isEmergencyMode);
             if (!r.isOk()) {
                 LOC_LOGe("Error invoking gnssRequestLocationCb_2_0 %s", r.description().c_str());
             }
         } else {
             LOC_LOGv("Unsupported ODCPI request type: %d", request.type);
         }
-    } else if (mGnssCbIface_1_1 != nullptr) {
+    } else if (gnssCbIface_1_1 != nullptr) {
         // For emergency mode, request DBH (Device based hybrid) location
         // Mark Independent from GNSS flag to false.
         if (ODCPI_REQUEST_TYPE_START == request.type) {
-            auto r = mGnssCbIface_1_1->gnssRequestLocationCb(!request.isEmergencyMode);
+            auto r = gnssCbIface_1_1->gnssRequestLocationCb(!request.isEmergencyMode);
             if (!r.isOk()) {
                 LOC_LOGe("Error invoking gnssRequestLocationCb %s", r.description().c_str());
             }
@@ -575,6 +631,7 @@ Return<bool> Gnss::setCallback_2_0(const sp<V2_0::IGnssCallback>& callback) {
                 __func__, r.description().c_str());
     }
 
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     // In case where previous call to setCallback/setCallback_1_1/setCallback_2_1, then
     // we need to cleanup these interfaces/callbacks here since we no longer
     // do so in cleanup() function to keep callbacks around after cleanup()
@@ -618,6 +675,7 @@ Return<bool> Gnss::setCallback_2_0(const sp<V2_0::IGnssCallback>& callback) {
         api->gnssUpdateCallbacks_2_0(mGnssCbIface_2_0);
         api->gnssEnable(LOCATION_TECHNOLOGY_TYPE_GNSS);
         api->requestCapabilities();
+        onClientAttached();
     }
 
     return true;
@@ -625,13 +683,14 @@ Return<bool> Gnss::setCallback_2_0(const sp<V2_0::IGnssCallback>& callback) {
 
 Return<sp<V2_0::IAGnss>> Gnss::getExtensionAGnss_2_0() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mAGnssIface_2_0 == nullptr) {
         mAGnssIface_2_0 = new AGnss(this);
     }
     return mAGnssIface_2_0;
 }
 Return<sp<V2_0::IAGnssRil>> Gnss::getExtensionAGnssRil_2_0() {
-
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssRil == nullptr) {
         mGnssRil = new AGnssRil(this);
     }
@@ -640,6 +699,7 @@ Return<sp<V2_0::IAGnssRil>> Gnss::getExtensionAGnssRil_2_0() {
 
 Return<sp<V2_0::IGnssConfiguration>> Gnss::getExtensionGnssConfiguration_2_0() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssConfig == nullptr) {
         mGnssConfig = new GnssConfiguration(this);
     }
@@ -647,6 +707,7 @@ Return<sp<V2_0::IGnssConfiguration>> Gnss::getExtensionGnssConfiguration_2_0() {
 }
 Return<sp<V2_0::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement_2_0() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
 #ifdef GNSS_HIDL_LEGACY_MEASURMENTS
     return nullptr;
 #else
@@ -659,6 +720,7 @@ Return<sp<V2_0::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement_2_0() {
 Return<sp<IMeasurementCorrectionsV1_0>>
         Gnss::getExtensionMeasurementCorrections() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssMeasCorr == nullptr) {
         mGnssMeasCorr = new MeasurementCorrections(this);
     }
@@ -668,6 +730,7 @@ Return<sp<IMeasurementCorrectionsV1_0>>
 Return<sp<IMeasurementCorrectionsV1_1>>
         Gnss::getExtensionMeasurementCorrections_1_1() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssMeasCorr == nullptr) {
         mGnssMeasCorr = new MeasurementCorrections(this);
     }
@@ -677,6 +740,7 @@ Return<sp<IMeasurementCorrectionsV1_1>>
 Return<sp<::android::hardware::gnss::visibility_control::V1_0::IGnssVisibilityControl>>
         Gnss::getExtensionVisibilityControl() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mVisibCtrl == nullptr) {
         mVisibCtrl = new GnssVisibilityControl(this);
     }
@@ -696,6 +760,7 @@ Return<bool> Gnss::injectBestLocation_2_0(const V2_0::GnssLocation& gnssLocation
 
 Return<sp<V2_0::IGnssDebug>> Gnss::getExtensionGnssDebug_2_0() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssDebug == nullptr) {
         mGnssDebug = new GnssDebug(this);
     }
@@ -715,6 +780,7 @@ Return<bool> Gnss::setCallback_2_1(const sp<V2_1::IGnssCallback>& callback) {
                 __func__, r.description().c_str());
     }
 
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     // In case where previous call to setCallback/setCallback_1_1/setCallback_2_0, then
     // we need to cleanup these interfaces/callbacks here since we no longer
     // do so in cleanup() function to keep callbacks around after cleanup()
@@ -756,12 +822,14 @@ Return<bool> Gnss::setCallback_2_1(const sp<V2_1::IGnssCallback>& callback) {
         api->gnssUpdateCallbacks_2_1(mGnssCbIface_2_1);
         api->gnssEnable(LOCATION_TECHNOLOGY_TYPE_GNSS);
         api->requestCapabilities();
+        onClientAttached();
     }
 
     return true;
 }
 Return<sp<V2_1::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement_2_1() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssMeasurement == nullptr) {
         mGnssMeasurement = new GnssMeasurement();
     }
@@ -769,6 +837,7 @@ Return<sp<V2_1::IGnssMeasurement>> Gnss::getExtensionGnssMeasurement_2_1() {
 }
 Return<sp<V2_1::IGnssConfiguration>> Gnss::getExtensionGnssConfiguration_2_1() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssConfig == nullptr) {
         mGnssConfig = new GnssConfiguration(this);
     }
@@ -777,12 +846,77 @@ Return<sp<V2_1::IGnssConfiguration>> Gnss::getExtensionGnssConfiguration_2_1() {
 
 Return<sp<V2_1::IGnssAntennaInfo>> Gnss::getExtensionGnssAntennaInfo() {
     ENTRY_LOG_CALLFLOW();
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     if (mGnssAntennaInfo == nullptr) {
         mGnssAntennaInfo = new GnssAntennaInfo(this);
     }
     return mGnssAntennaInfo;
 }
 
+/*
+ * The dump is a header line, "gnss_debug version=<n> boot_ms=<ms>", then each
+ * section as a "[<name>]" line followed by its lines, and a closing "[end]"
+ * line, so a collector can split it without knowing what each section holds.
+ * No line of a section starts with '['.
+ */
+Return<void> Gnss::debug(const hidl_handle& fd, const hidl_vec<hidl_string>& options) {
+    if (fd == nullptr || fd->numFds < 1) {
+        LOC_LOGe("invalid fd");
+        return Void();
+    }
+
+    const GnssInterface* gnssInterface = getGnssInterface();
+    const struct {
+        const char* name;
+        std::function<void(std::string&)> dump;
+    } sections[] = {
+        {"msgtask", [](std::string& out) { loc_util::MsgTask::dumpAllStats(out); }},
+        {"ipc", [](std::string& out) { loc_util::LocIpc::dumpStats(out); }},
+        {"memory", [](std::string& out) { loc_util::LocMemStats::dump(out); }},
+        {"hidl_callbacks", [](std::string& out) {
+            HidlCallbackDispatcher::getInstance().dumpStats(out);
+        }},
+        {"api_client", [](std::string& out) { GnssAPIClient::dumpStats(out); }},
+        {"visibility_control", [](std::string& out) { GnssVisibilityControl::dumpStats(out); }},
+        // GnssAdapter, LocApiBase and SystemStatus
+        {"gnss", [gnssInterface](std::string& out) {
+            if (gnssInterface != nullptr && gnssInterface->dumpStats != nullptr) {
+                gnssInterface->dumpStats(out);
+            }
+        }},
+        {"batching", [](std::string& out) {
+            LocationAPI::dumpStats(LOCATION_ADAPTER_BATCHING_TYPE_BIT, out);
+        }},
+        {"geofence", [](std::string& out) {
+            LocationAPI::dumpStats(LOCATION_ADAPTER_GEOFENCE_TYPE_BIT, out);
+        }},
+    };
+
+    std::string out = "gnss_debug version=" + std::to_string(GNSS_DEBUG_DUMP_VERSION) +
+            " boot_ms=" + std::to_string(getBootTimeMilliSec()) + "\n";
+    for (const auto& section : sections) {
+        bool selected = (options.size() == 0);
+        for (size_t i = 0; i < options.size() && !selected; i++) {
+            selected = (options[i] == section.name);
+        }
+        if (!selected) {
+            continue;
+        }
+        out += "[";
+        out += section.name;
+        out += "]\n";
+        section.dump(out);
+        if (out.back() != '\n') {
+            out += "\n";
+        }
+    }
+    out += "[end]\n";
+    if (write(fd->data[0], out.c_str(), out.size()) < 0) {
+        LOC_LOGe("failed to write debug output");
+    }
+    return Void();
+}
+
 V1_0::IGnss* HIDL_FETCH_IGnss(const char* hal) {
     ENTRY_LOG_CALLFLOW();
     V1_0::IGnss* iface = nullptr;
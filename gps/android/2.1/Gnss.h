@@ -36,6 +36,7 @@
 #include <MeasurementCorrections.h>
 #include <GnssVisibilityControl.h>
 #include <hidl/MQDescriptor.h>
+#include <mutex>
 #include <hidl/Status.h>
 
 #include "GnssAPIClient.h"
@@ -47,6 +48,7 @@ namespace V2_1 {
 namespace implementation {
 
 using ::android::hardware::hidl_array;
+using ::android::hardware::hidl_handle;
 using ::android::hardware::hidl_memory;
 using ::android::hardware::hidl_string;
 using ::android::hardware::hidl_vec;
@@ -138,6 +140,11 @@ struct Gnss : public IGnss {
     Return<sp<V2_1::IGnssConfiguration>> getExtensionGnssConfiguration_2_1() override;
     Return<sp<V2_1::IGnssAntennaInfo>> getExtensionGnssAntennaInfo() override;
 
+    // Methods from ::android::hidl::base::V1_0::IBase follow.
+    // Prints location HAL runtime stats, e.g. via lshal debug, as the sections
+    // named in options, or all of them without options.
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& options) override;
+
     // These methods are not part of the IGnss base class.
     GnssAPIClient* getApi();
     Return<bool> setGnssNiCb(const sp<IGnssNiCallback>& niCb);
@@ -157,6 +164,11 @@ struct Gnss : public IGnss {
     };
 
  private:
+    // the framework client died, see GnssDeathRecipient
+    void detachClient();
+    // logs how long location delivery was down, if a client died before
+    void onClientAttached();
+
     sp<GnssDeathRecipient> mGnssDeathRecipient = nullptr;
 
     sp<V1_0::IGnssNi> mGnssNi = nullptr;
@@ -177,7 +189,13 @@ struct Gnss : public IGnss {
     sp<IMeasurementCorrectionsV1_1> mGnssMeasCorr = nullptr;
     sp<IGnssVisibilityControl> mVisibCtrl = nullptr;
 
+    // Guards the callbacks, lazily created interfaces and mApi against
+    // concurrent calls from the binder threadpool. Recursive since e.g.
+    // setCallback_2_1() reaches getApi() and getGnssInterface().
+    std::recursive_mutex mMutex;
     GnssAPIClient* mApi = nullptr;
+    // boot time the last framework client died, 0 once another attached
+    uint64_t mClientDiedMs = 0;
     GnssConfig mPendingConfig;
     const GnssInterface* mGnssInterface = nullptr;
 };
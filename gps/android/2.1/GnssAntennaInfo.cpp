@@ -41,7 +41,7 @@ namespace implementation {
 
 static GnssAntennaInfo* spGnssAntennaInfo = nullptr;
 
-static void convertGnssAntennaInfo(std::vector<GnssAntennaInformation>& in,
+static void convertGnssAntennaInfo(const std::vector<GnssAntennaInformation>& in,
         hidl_vec<IGnssAntennaInfoCallback::GnssAntennaInfo>& antennaInfos);
 
 void GnssAntennaInfo::GnssAntennaInfoDeathRecipient::serviceDied(uint64_t cookie,
@@ -63,7 +63,7 @@ void GnssAntennaInfo::GnssAntennaInfoDeathRecipient::serviceDied(uint64_t cookie
     spGnssAntennaInfo->mGnss->getGnssInterface()->antennaInfoClose();
 }
 
-static void convertGnssAntennaInfo(std::vector<GnssAntennaInformation>& in,
+static void convertGnssAntennaInfo(const std::vector<GnssAntennaInformation>& in,
         hidl_vec<IGnssAntennaInfoCallback::GnssAntennaInfo>& out) {
 
     uint32_t vecSize, numberOfRows, numberOfColumns;
@@ -148,8 +148,15 @@ Return<GnssAntennaInfo::GnssAntennaInfoStatus>
         return GnssAntennaInfoStatus::ERROR_GENERIC;
     }
 
-    mGnssAntennaInfoCbIface = callback;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mGnssAntennaInfoCbIface = callback;
+    }
     retValue = mGnss->getGnssInterface()->antennaInfoInit(aiGnssAntennaInfoCb);
+    if (ANTENNA_INFO_ERROR_ALREADY_INIT == retValue) {
+        // the adapter reports once per init, a later subscriber gets that report
+        sendCachedAntennaInfo(callback);
+    }
 
     switch (retValue) {
     case ANTENNA_INFO_SUCCESS: return GnssAntennaInfoStatus::SUCCESS;
@@ -171,27 +178,45 @@ Return<void> GnssAntennaInfo::close(void)  {
 }
 
 void GnssAntennaInfo::aiGnssAntennaInfoCb
-        (std::vector<GnssAntennaInformation> gnssAntennaInformations) {
+        (const std::vector<GnssAntennaInformation>& gnssAntennaInformations) {
     if (nullptr != spGnssAntennaInfo) {
         spGnssAntennaInfo->gnssAntennaInfoCb(gnssAntennaInformations);
     }
 }
 
 void GnssAntennaInfo::gnssAntennaInfoCb
-        (std::vector<GnssAntennaInformation> gnssAntennaInformations) {
-
-    if (mGnssAntennaInfoCbIface != nullptr) {
-        hidl_vec<IGnssAntennaInfoCallback::GnssAntennaInfo> antennaInfos;
+        (const std::vector<GnssAntennaInformation>& gnssAntennaInformations) {
+
+    sp<IGnssAntennaInfoCallback> callback;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mAntennaInfosValid) {
+            // Convert from one structure to another
+            convertGnssAntennaInfo(gnssAntennaInformations, mAntennaInfos);
+            mAntennaInfosValid = true;
+        }
+        callback = mGnssAntennaInfoCbIface;
+    }
+    sendCachedAntennaInfo(callback);
+}
 
-        // Convert from one structure to another
-        convertGnssAntennaInfo(gnssAntennaInformations, antennaInfos);
+void GnssAntennaInfo::sendCachedAntennaInfo(const sp<IGnssAntennaInfoCallback>& callback) {
 
-        auto r = mGnssAntennaInfoCbIface->gnssAntennaInfoCb(antennaInfos);
-        if (!r.isOk()) {
-            LOC_LOGw("Error antenna info cb %s", r.description().c_str());
-        }
-    } else {
+    if (callback == nullptr) {
         LOC_LOGw("setCallback has not been called yet");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mAntennaInfosValid) {
+            LOC_LOGd("no antenna info reported yet");
+            return;
+        }
+    }
+    // mAntennaInfos is left alone once valid, no need to hold mMutex over the call
+    auto r = callback->gnssAntennaInfoCb(mAntennaInfos);
+    if (!r.isOk()) {
+        LOC_LOGw("Error antenna info cb %s", r.description().c_str());
     }
 }
 
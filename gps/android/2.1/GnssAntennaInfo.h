@@ -33,6 +33,7 @@
 
 #include <android/hardware/gnss/2.1/IGnssAntennaInfo.h>
 #include <hidl/Status.h>
+#include <mutex>
 
 namespace android {
 namespace hardware {
@@ -61,9 +62,10 @@ struct GnssAntennaInfo : public IGnssAntennaInfo {
             setCallback(const sp<IGnssAntennaInfoCallback>& callback) override;
     Return<void> close(void) override;
 
-    void gnssAntennaInfoCb(std::vector<GnssAntennaInformation> gnssAntennaInformations);
+    void gnssAntennaInfoCb(const std::vector<GnssAntennaInformation>& gnssAntennaInformations);
 
-    static void aiGnssAntennaInfoCb(std::vector<GnssAntennaInformation> gnssAntennaInformations);
+    static void aiGnssAntennaInfoCb(
+            const std::vector<GnssAntennaInformation>& gnssAntennaInformations);
 
  private:
     struct GnssAntennaInfoDeathRecipient : hidl_death_recipient {
@@ -79,6 +81,13 @@ struct GnssAntennaInfo : public IGnssAntennaInfo {
     sp<GnssAntennaInfoDeathRecipient> mGnssAntennaInfoDeathRecipient = nullptr;
     sp<IGnssAntennaInfoCallback> mGnssAntennaInfoCbIface = nullptr;
     Gnss* mGnss = nullptr;
+
+    // the antenna data is static per device, so it is converted at the first
+    // report and never changes after mAntennaInfosValid is set
+    void sendCachedAntennaInfo(const sp<IGnssAntennaInfoCallback>& callback);
+    std::mutex mMutex;
+    bool mAntennaInfosValid = false;
+    hidl_vec<IGnssAntennaInfoCallback::GnssAntennaInfo> mAntennaInfos;
 };
 
 }  // namespace implementation
@@ -55,15 +55,16 @@ GnssBatching::~GnssBatching() {
 // Methods from ::android::hardware::gnss::V1_0::IGnssBatching follow.
 Return<bool> GnssBatching::init(const sp<V1_0::IGnssBatchingCallback>& callback) {
     if (mApi != nullptr) {
-        LOC_LOGD("%s]: mApi is NOT nullptr, delete it first", __FUNCTION__);
-        mApi->destroy();
-        mApi = nullptr;
-    }
-
-    mApi = new BatchingAPIClient(callback);
-    if (mApi == nullptr) {
-        LOC_LOGE("%s]: failed to create mApi", __FUNCTION__);
-        return false;
+        // every init of either version goes to the same client, which keeps
+        // its LocationAPI registration
+        LOC_LOGD("%s]: mApi is NOT nullptr, update its callback", __FUNCTION__);
+        mApi->gnssUpdateCallbacks(callback);
+    } else {
+        mApi = new BatchingAPIClient(callback);
+        if (mApi == nullptr) {
+            LOC_LOGE("%s]: failed to create mApi", __FUNCTION__);
+            return false;
+        }
     }
 
     if (mGnssBatchingCbIface != nullptr) {
@@ -134,15 +135,16 @@ Return<void> GnssBatching::cleanup() {
 // Methods from ::android::hardware::gnss::V2_0::IGnssBatching follow.
 Return<bool> GnssBatching::init_2_0(const sp<V2_0::IGnssBatchingCallback>& callback) {
     if (mApi != nullptr) {
-        LOC_LOGD("%s]: mApi is NOT nullptr, delete it first", __FUNCTION__);
-        mApi->destroy();
-        mApi = nullptr;
-    }
-
-    mApi = new BatchingAPIClient(callback);
-    if (mApi == nullptr) {
-        LOC_LOGE("%s]: failed to create mApi", __FUNCTION__);
-        return false;
+        // every init of either version goes to the same client, which keeps
+        // its LocationAPI registration
+        LOC_LOGD("%s]: mApi is NOT nullptr, update its callback", __FUNCTION__);
+        mApi->gnssUpdateCallbacks_2_0(callback);
+    } else {
+        mApi = new BatchingAPIClient(callback);
+        if (mApi == nullptr) {
+            LOC_LOGE("%s]: failed to create mApi", __FUNCTION__);
+            return false;
+        }
     }
 
     if (mGnssBatchingCbIface_2_0 != nullptr) {
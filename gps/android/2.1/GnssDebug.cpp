@@ -22,6 +22,7 @@
 
 #include <log/log.h>
 #include <log_util.h>
+#include <inttypes.h>
 #include "Gnss.h"
 #include "GnssDebug.h"
 #include "LocationUtil.h"
@@ -49,127 +50,152 @@ GnssDebug::GnssDebug(Gnss* gnss) : mGnss(gnss)
 {
 }
 
-/*
- * This methods requests position, time and satellite ephemeris debug information
- * from the HAL.
- *
- * @return void
-*/
-Return<void> GnssDebug::getDebugData(getDebugData_cb _hidl_cb)
+// everything in the position block but ageSeconds, which ages by the call
+static void convertDebugPosition(const GnssDebugReport& reports,
+        V1_0::IGnssDebug::PositionDebug& position)
 {
-    LOC_LOGD("%s]: ", __func__);
-
-    V1_0::IGnssDebug::DebugData data = { };
-
-    if((nullptr == mGnss) || (nullptr == mGnss->getGnssInterface())){
-        LOC_LOGE("GnssDebug - Null GNSS interface");
-        _hidl_cb(data);
-        return Void();
-    }
-
-    // get debug report snapshot via hal interface
-    GnssDebugReport reports = { };
-    mGnss->getGnssInterface()->getDebugReport(reports);
-
-    // location block
     if (reports.mLocation.mValid) {
-        data.position.valid = true;
-        data.position.latitudeDegrees = reports.mLocation.mLocation.latitude;
-        data.position.longitudeDegrees = reports.mLocation.mLocation.longitude;
-        data.position.altitudeMeters = reports.mLocation.mLocation.altitude;
+        position.valid = true;
+        position.latitudeDegrees = reports.mLocation.mLocation.latitude;
+        position.longitudeDegrees = reports.mLocation.mLocation.longitude;
+        position.altitudeMeters = reports.mLocation.mLocation.altitude;
 
-        data.position.speedMetersPerSec =
+        position.speedMetersPerSec =
             (double)(reports.mLocation.mLocation.speed);
-        data.position.bearingDegrees =
+        position.bearingDegrees =
             (double)(reports.mLocation.mLocation.bearing);
-        data.position.horizontalAccuracyMeters =
+        position.horizontalAccuracyMeters =
             (double)(reports.mLocation.mLocation.accuracy);
-        data.position.verticalAccuracyMeters =
+        position.verticalAccuracyMeters =
             reports.mLocation.verticalAccuracyMeters;
-        data.position.speedAccuracyMetersPerSecond =
+        position.speedAccuracyMetersPerSecond =
             reports.mLocation.speedAccuracyMetersPerSecond;
-        data.position.bearingAccuracyDegrees =
+        position.bearingAccuracyDegrees =
             reports.mLocation.bearingAccuracyDegrees;
-
-        timeval tv_now, tv_report;
-        tv_report.tv_sec  = reports.mLocation.mUtcReported.tv_sec;
-        tv_report.tv_usec = reports.mLocation.mUtcReported.tv_nsec / 1000ULL;
-        gettimeofday(&tv_now, NULL);
-        data.position.ageSeconds =
-            (tv_now.tv_sec - tv_report.tv_sec) +
-            (float)((tv_now.tv_usec - tv_report.tv_usec)) / 1000000;
     }
     else {
-        data.position.valid = false;
+        position.valid = false;
     }
 
-    if (data.position.horizontalAccuracyMeters <= 0 ||
-        data.position.horizontalAccuracyMeters > GNSS_DEBUG_UNKNOWN_HORIZONTAL_ACCURACY_METERS) {
-        data.position.horizontalAccuracyMeters = GNSS_DEBUG_UNKNOWN_HORIZONTAL_ACCURACY_METERS;
+    if (position.horizontalAccuracyMeters <= 0 ||
+        position.horizontalAccuracyMeters > GNSS_DEBUG_UNKNOWN_HORIZONTAL_ACCURACY_METERS) {
+        position.horizontalAccuracyMeters = GNSS_DEBUG_UNKNOWN_HORIZONTAL_ACCURACY_METERS;
     }
-    if (data.position.verticalAccuracyMeters <= 0 ||
-        data.position.verticalAccuracyMeters > GNSS_DEBUG_UNKNOWN_VERTICAL_ACCURACY_METERS) {
-        data.position.verticalAccuracyMeters = GNSS_DEBUG_UNKNOWN_VERTICAL_ACCURACY_METERS;
+    if (position.verticalAccuracyMeters <= 0 ||
+        position.verticalAccuracyMeters > GNSS_DEBUG_UNKNOWN_VERTICAL_ACCURACY_METERS) {
+        position.verticalAccuracyMeters = GNSS_DEBUG_UNKNOWN_VERTICAL_ACCURACY_METERS;
     }
-    if (data.position.speedAccuracyMetersPerSecond <= 0 ||
-        data.position.speedAccuracyMetersPerSecond > GNSS_DEBUG_UNKNOWN_SPEED_ACCURACY_PER_SEC) {
-        data.position.speedAccuracyMetersPerSecond = GNSS_DEBUG_UNKNOWN_SPEED_ACCURACY_PER_SEC;
+    if (position.speedAccuracyMetersPerSecond <= 0 ||
+        position.speedAccuracyMetersPerSecond > GNSS_DEBUG_UNKNOWN_SPEED_ACCURACY_PER_SEC) {
+        position.speedAccuracyMetersPerSecond = GNSS_DEBUG_UNKNOWN_SPEED_ACCURACY_PER_SEC;
     }
-    if (data.position.bearingAccuracyDegrees <= 0 ||
-        data.position.bearingAccuracyDegrees > GNSS_DEBUG_UNKNOWN_BEARING_ACCURACY_DEG) {
-        data.position.bearingAccuracyDegrees = GNSS_DEBUG_UNKNOWN_BEARING_ACCURACY_DEG;
+    if (position.bearingAccuracyDegrees <= 0 ||
+        position.bearingAccuracyDegrees > GNSS_DEBUG_UNKNOWN_BEARING_ACCURACY_DEG) {
+        position.bearingAccuracyDegrees = GNSS_DEBUG_UNKNOWN_BEARING_ACCURACY_DEG;
     }
+}
 
-    // time block
+static void setDebugPositionAge(const timespec& utcReported,
+        V1_0::IGnssDebug::PositionDebug& position)
+{
+    if (position.valid) {
+        timeval tv_now, tv_report;
+        tv_report.tv_sec  = utcReported.tv_sec;
+        tv_report.tv_usec = utcReported.tv_nsec / 1000ULL;
+        gettimeofday(&tv_now, NULL);
+        position.ageSeconds =
+            (tv_now.tv_sec - tv_report.tv_sec) +
+            (float)((tv_now.tv_usec - tv_report.tv_usec)) / 1000000;
+    }
+}
+
+static void convertDebugTime(const GnssDebugReport& reports, V1_0::IGnssDebug::TimeDebug& time)
+{
     if (reports.mTime.mValid) {
-        data.time.timeEstimate = reports.mTime.timeEstimate;
-        data.time.timeUncertaintyNs = reports.mTime.timeUncertaintyNs;
-        data.time.frequencyUncertaintyNsPerSec =
+        time.timeEstimate = reports.mTime.timeEstimate;
+        time.timeUncertaintyNs = reports.mTime.timeUncertaintyNs;
+        time.frequencyUncertaintyNsPerSec =
             reports.mTime.frequencyUncertaintyNsPerSec;
     }
 
-    if (data.time.timeEstimate < GNSS_DEBUG_UNKNOWN_UTC_TIME) {
-        data.time.timeEstimate = GNSS_DEBUG_UNKNOWN_UTC_TIME;
+    if (time.timeEstimate < GNSS_DEBUG_UNKNOWN_UTC_TIME) {
+        time.timeEstimate = GNSS_DEBUG_UNKNOWN_UTC_TIME;
     }
-    if (data.time.timeUncertaintyNs <= 0) {
-        data.time.timeUncertaintyNs = (float)GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MIN;
-    } else if (data.time.timeUncertaintyNs > GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MAX) {
-        data.time.timeUncertaintyNs = (float)GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MAX;
+    if (time.timeUncertaintyNs <= 0) {
+        time.timeUncertaintyNs = (float)GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MIN;
+    } else if (time.timeUncertaintyNs > GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MAX) {
+        time.timeUncertaintyNs = (float)GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MAX;
     }
-    if (data.time.frequencyUncertaintyNsPerSec <= 0 ||
-        data.time.frequencyUncertaintyNsPerSec > (float)GNSS_DEBUG_UNKNOWN_FREQ_UNC_NS_PER_SEC) {
-        data.time.frequencyUncertaintyNsPerSec = (float)GNSS_DEBUG_UNKNOWN_FREQ_UNC_NS_PER_SEC;
+    if (time.frequencyUncertaintyNsPerSec <= 0 ||
+        time.frequencyUncertaintyNsPerSec > (float)GNSS_DEBUG_UNKNOWN_FREQ_UNC_NS_PER_SEC) {
+        time.frequencyUncertaintyNsPerSec = (float)GNSS_DEBUG_UNKNOWN_FREQ_UNC_NS_PER_SEC;
     }
+}
 
-    // satellite data block
-    V1_0::IGnssDebug::SatelliteData s = { };
-    std::vector<V1_0::IGnssDebug::SatelliteData> s_array;
-
-    for (uint32_t i=0; i<reports.mSatelliteInfo.size(); i++) {
-        memset(&s, 0, sizeof(s));
-        s.svid = reports.mSatelliteInfo[i].svid;
-        convertGnssConstellationType(
-            reports.mSatelliteInfo[i].constellation, s.constellation);
-        convertGnssEphemerisType(
-            reports.mSatelliteInfo[i].mEphemerisType, s.ephemerisType);
-        convertGnssEphemerisSource(
-            reports.mSatelliteInfo[i].mEphemerisSource, s.ephemerisSource);
-        convertGnssEphemerisHealth(
-            reports.mSatelliteInfo[i].mEphemerisHealth, s.ephemerisHealth);
+/*
+ * This methods requests position, time and satellite ephemeris debug information
+ * from the HAL.
+ *
+ * @return void
+*/
+Return<void> GnssDebug::getDebugData(getDebugData_cb _hidl_cb)
+{
+    LOC_LOGD("%s]: ", __func__);
 
-        s.ephemerisAgeSeconds =
-            reports.mSatelliteInfo[i].ephemerisAgeSeconds;
-        s.serverPredictionIsAvailable =
-            reports.mSatelliteInfo[i].serverPredictionIsAvailable;
-        s.serverPredictionAgeSeconds =
-            reports.mSatelliteInfo[i].serverPredictionAgeSeconds;
+    if((nullptr == mGnss) || (nullptr == mGnss->getGnssInterface())){
+        LOC_LOGE("GnssDebug - Null GNSS interface");
+        V1_0::IGnssDebug::DebugData data = { };
+        _hidl_cb(data);
+        return Void();
+    }
 
-        s_array.push_back(s);
+    std::lock_guard<std::mutex> lock(mCacheLock);
+    // read before the report, so an update racing with it rebuilds next time
+    uint64_t generation = mGnss->getGnssInterface()->getDebugReportGeneration();
+    if (mCacheValid_1_0 && generation == mCacheGeneration_1_0) {
+        LOC_LOGV("%s]: generation %" PRIu64 " unchanged", __func__, generation);
+    } else {
+        // get debug report snapshot via hal interface
+        GnssDebugReport reports = { };
+        mGnss->getGnssInterface()->getDebugReport(reports);
+
+        V1_0::IGnssDebug::DebugData& data = mCache_1_0;
+        data.position = { };
+        data.time = { };
+        convertDebugPosition(reports, data.position);
+        convertDebugTime(reports, data.time);
+
+        // satellite data block
+        data.satelliteDataArray.resize(reports.mSatelliteInfo.size());
+        for (uint32_t i=0; i<reports.mSatelliteInfo.size(); i++) {
+            V1_0::IGnssDebug::SatelliteData& s = data.satelliteDataArray[i];
+            memset(&s, 0, sizeof(s));
+            s.svid = reports.mSatelliteInfo[i].svid;
+            convertGnssConstellationType(
+                reports.mSatelliteInfo[i].constellation, s.constellation);
+            convertGnssEphemerisType(
+                reports.mSatelliteInfo[i].mEphemerisType, s.ephemerisType);
+            convertGnssEphemerisSource(
+                reports.mSatelliteInfo[i].mEphemerisSource, s.ephemerisSource);
+            convertGnssEphemerisHealth(
+                reports.mSatelliteInfo[i].mEphemerisHealth, s.ephemerisHealth);
+
+            s.ephemerisAgeSeconds =
+                reports.mSatelliteInfo[i].ephemerisAgeSeconds;
+            s.serverPredictionIsAvailable =
+                reports.mSatelliteInfo[i].serverPredictionIsAvailable;
+            s.serverPredictionAgeSeconds =
+                reports.mSatelliteInfo[i].serverPredictionAgeSeconds;
+        }
+
+        mCacheUtcReported_1_0 = reports.mLocation.mUtcReported;
+        mCacheGeneration_1_0 = generation;
+        mCacheValid_1_0 = true;
     }
-    data.satelliteDataArray = s_array;
+    setDebugPositionAge(mCacheUtcReported_1_0, mCache_1_0.position);
 
     // callback HIDL with collected debug data
-    _hidl_cb(data);
+    _hidl_cb(mCache_1_0);
     return Void();
 }
 
@@ -177,118 +203,60 @@ Return<void> GnssDebug::getDebugData_2_0(getDebugData_2_0_cb _hidl_cb)
 {
     LOC_LOGD("%s]: ", __func__);
 
-    V2_0::IGnssDebug::DebugData data = { };
-
     if((nullptr == mGnss) || (nullptr == mGnss->getGnssInterface())){
         LOC_LOGE("GnssDebug - Null GNSS interface");
+        V2_0::IGnssDebug::DebugData data = { };
         _hidl_cb(data);
         return Void();
     }
 
-    // get debug report snapshot via hal interface
-    GnssDebugReport reports = { };
-    mGnss->getGnssInterface()->getDebugReport(reports);
-
-    // location block
-    if (reports.mLocation.mValid) {
-        data.position.valid = true;
-        data.position.latitudeDegrees = reports.mLocation.mLocation.latitude;
-        data.position.longitudeDegrees = reports.mLocation.mLocation.longitude;
-        data.position.altitudeMeters = reports.mLocation.mLocation.altitude;
-
-        data.position.speedMetersPerSec =
-            (double)(reports.mLocation.mLocation.speed);
-        data.position.bearingDegrees =
-            (double)(reports.mLocation.mLocation.bearing);
-        data.position.horizontalAccuracyMeters =
-            (double)(reports.mLocation.mLocation.accuracy);
-        data.position.verticalAccuracyMeters =
-            reports.mLocation.verticalAccuracyMeters;
-        data.position.speedAccuracyMetersPerSecond =
-            reports.mLocation.speedAccuracyMetersPerSecond;
-        data.position.bearingAccuracyDegrees =
-            reports.mLocation.bearingAccuracyDegrees;
-
-        timeval tv_now, tv_report;
-        tv_report.tv_sec  = reports.mLocation.mUtcReported.tv_sec;
-        tv_report.tv_usec = reports.mLocation.mUtcReported.tv_nsec / 1000ULL;
-        gettimeofday(&tv_now, NULL);
-        data.position.ageSeconds =
-            (tv_now.tv_sec - tv_report.tv_sec) +
-            (float)((tv_now.tv_usec - tv_report.tv_usec)) / 1000000;
-    }
-    else {
-        data.position.valid = false;
-    }
-
-    if (data.position.horizontalAccuracyMeters <= 0 ||
-        data.position.horizontalAccuracyMeters > GNSS_DEBUG_UNKNOWN_HORIZONTAL_ACCURACY_METERS) {
-        data.position.horizontalAccuracyMeters = GNSS_DEBUG_UNKNOWN_HORIZONTAL_ACCURACY_METERS;
-    }
-    if (data.position.verticalAccuracyMeters <= 0 ||
-        data.position.verticalAccuracyMeters > GNSS_DEBUG_UNKNOWN_VERTICAL_ACCURACY_METERS) {
-        data.position.verticalAccuracyMeters = GNSS_DEBUG_UNKNOWN_VERTICAL_ACCURACY_METERS;
-    }
-    if (data.position.speedAccuracyMetersPerSecond <= 0 ||
-        data.position.speedAccuracyMetersPerSecond > GNSS_DEBUG_UNKNOWN_SPEED_ACCURACY_PER_SEC) {
-        data.position.speedAccuracyMetersPerSecond = GNSS_DEBUG_UNKNOWN_SPEED_ACCURACY_PER_SEC;
-    }
-    if (data.position.bearingAccuracyDegrees <= 0 ||
-        data.position.bearingAccuracyDegrees > GNSS_DEBUG_UNKNOWN_BEARING_ACCURACY_DEG) {
-        data.position.bearingAccuracyDegrees = GNSS_DEBUG_UNKNOWN_BEARING_ACCURACY_DEG;
-    }
-
-    // time block
-    if (reports.mTime.mValid) {
-        data.time.timeEstimate = reports.mTime.timeEstimate;
-        data.time.timeUncertaintyNs = reports.mTime.timeUncertaintyNs;
-        data.time.frequencyUncertaintyNsPerSec =
-            reports.mTime.frequencyUncertaintyNsPerSec;
-    }
-
-    if (data.time.timeEstimate < GNSS_DEBUG_UNKNOWN_UTC_TIME) {
-        data.time.timeEstimate = GNSS_DEBUG_UNKNOWN_UTC_TIME;
-    }
-    if (data.time.timeUncertaintyNs <= 0) {
-        data.time.timeUncertaintyNs = (float)GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MIN;
-    }
-    else if (data.time.timeUncertaintyNs > GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MAX) {
-        data.time.timeUncertaintyNs = (float)GNSS_DEBUG_UNKNOWN_UTC_TIME_UNC_MAX;
-    }
-    if (data.time.frequencyUncertaintyNsPerSec <= 0 ||
-        data.time.frequencyUncertaintyNsPerSec > (float)GNSS_DEBUG_UNKNOWN_FREQ_UNC_NS_PER_SEC) {
-        data.time.frequencyUncertaintyNsPerSec = (float)GNSS_DEBUG_UNKNOWN_FREQ_UNC_NS_PER_SEC;
-    }
-
-    // satellite data block
-    V2_0::IGnssDebug::SatelliteData s = { };
-    std::vector<V2_0::IGnssDebug::SatelliteData> s_array;
-
-    for (uint32_t i=0; i<reports.mSatelliteInfo.size(); i++) {
-        memset(&s, 0, sizeof(s));
-        s.v1_0.svid = reports.mSatelliteInfo[i].svid;
-        convertGnssConstellationType(
-            reports.mSatelliteInfo[i].constellation, s.constellation);
-        convertGnssEphemerisType(
-            reports.mSatelliteInfo[i].mEphemerisType, s.v1_0.ephemerisType);
-        convertGnssEphemerisSource(
-            reports.mSatelliteInfo[i].mEphemerisSource, s.v1_0.ephemerisSource);
-        convertGnssEphemerisHealth(
-            reports.mSatelliteInfo[i].mEphemerisHealth, s.v1_0.ephemerisHealth);
-
-        s.v1_0.ephemerisAgeSeconds =
-            reports.mSatelliteInfo[i].ephemerisAgeSeconds;
-        s.v1_0.serverPredictionIsAvailable =
-            reports.mSatelliteInfo[i].serverPredictionIsAvailable;
-        s.v1_0.serverPredictionAgeSeconds =
-            reports.mSatelliteInfo[i].serverPredictionAgeSeconds;
-
-        s_array.push_back(s);
+    std::lock_guard<std::mutex> lock(mCacheLock);
+    // read before the report, so an update racing with it rebuilds next time
+    uint64_t generation = mGnss->getGnssInterface()->getDebugReportGeneration();
+    if (mCacheValid_2_0 && generation == mCacheGeneration_2_0) {
+        LOC_LOGV("%s]: generation %" PRIu64 " unchanged", __func__, generation);
+    } else {
+        // get debug report snapshot via hal interface
+        GnssDebugReport reports = { };
+        mGnss->getGnssInterface()->getDebugReport(reports);
+
+        V2_0::IGnssDebug::DebugData& data = mCache_2_0;
+        data.position = { };
+        data.time = { };
+        convertDebugPosition(reports, data.position);
+        convertDebugTime(reports, data.time);
+
+        // satellite data block
+        data.satelliteDataArray.resize(reports.mSatelliteInfo.size());
+        for (uint32_t i=0; i<reports.mSatelliteInfo.size(); i++) {
+            V2_0::IGnssDebug::SatelliteData& s = data.satelliteDataArray[i];
+            memset(&s, 0, sizeof(s));
+            s.v1_0.svid = reports.mSatelliteInfo[i].svid;
+            convertGnssConstellationType(
+                reports.mSatelliteInfo[i].constellation, s.constellation);
+            convertGnssEphemerisType(
+                reports.mSatelliteInfo[i].mEphemerisType, s.v1_0.ephemerisType);
+            convertGnssEphemerisSource(
+                reports.mSatelliteInfo[i].mEphemerisSource, s.v1_0.ephemerisSource);
+            convertGnssEphemerisHealth(
+                reports.mSatelliteInfo[i].mEphemerisHealth, s.v1_0.ephemerisHealth);
+
+            s.v1_0.ephemerisAgeSeconds =
+                reports.mSatelliteInfo[i].ephemerisAgeSeconds;
+            s.v1_0.serverPredictionIsAvailable =
+                reports.mSatelliteInfo[i].serverPredictionIsAvailable;
+            s.v1_0.serverPredictionAgeSeconds =
+                reports.mSatelliteInfo[i].serverPredictionAgeSeconds;
+        }
+
+        mCacheUtcReported_2_0 = reports.mLocation.mUtcReported;
+        mCacheGeneration_2_0 = generation;
+        mCacheValid_2_0 = true;
     }
-    data.satelliteDataArray = s_array;
+    setDebugPositionAge(mCacheUtcReported_2_0, mCache_2_0.position);
 
     // callback HIDL with collected debug data
-    _hidl_cb(data);
+    _hidl_cb(mCache_2_0);
     return Void();
 }
 
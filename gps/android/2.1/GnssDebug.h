@@ -24,6 +24,7 @@
 
 #include <android/hardware/gnss/2.0/IGnssDebug.h>
 #include <hidl/Status.h>
+#include <mutex>
 
 namespace android {
 namespace hardware {
@@ -51,6 +52,19 @@ struct GnssDebug : public IGnssDebug {
 
 private:
     Gnss* mGnss = nullptr;
+
+    // The converted debug data of the SystemStatus generation it was built
+    // from, handed out again until SystemStatus publishes anything new.
+    // Only position.ageSeconds is redone per call, from mUtcReported.
+    std::mutex mCacheLock;
+    bool mCacheValid_1_0 = false;
+    uint64_t mCacheGeneration_1_0 = 0;
+    timespec mCacheUtcReported_1_0 = { };
+    V1_0::IGnssDebug::DebugData mCache_1_0;
+    bool mCacheValid_2_0 = false;
+    uint64_t mCacheGeneration_2_0 = 0;
+    timespec mCacheUtcReported_2_0 = { };
+    V2_0::IGnssDebug::DebugData mCache_2_0;
 };
 
 }  // namespace implementation
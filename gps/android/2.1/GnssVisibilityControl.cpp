@@ -30,7 +30,9 @@
 #include <android/hardware/gnss/visibility_control/1.0/IGnssVisibilityControl.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
+#include <inttypes.h>
 #include "GnssVisibilityControl.h"
+#include "HidlCallbackDispatcher.h"
 #include <location_interface.h>
 
 namespace android {
@@ -47,13 +49,18 @@ using ::android::hardware::hidl_vec;
 using ::android::hardware::Return;
 using ::android::hardware::Void;
 using ::android::sp;
+using ::android::hardware::gnss::V2_1::implementation::HidlCallbackDispatcher;
+using ::android::hardware::gnss::V2_1::implementation::HIDL_CB_NFW;
 
 static GnssVisibilityControl* spGnssVisibilityControl = nullptr;
+std::atomic<uint64_t> GnssVisibilityControl::sNfwPosted(0);
+std::atomic<uint64_t> GnssVisibilityControl::sNfwAggregated(0);
 
 static void convertGnssNfwNotification(GnssNfwNotification& in,
     IGnssVisibilityControlCallback::NfwNotification& out);
 
-GnssVisibilityControl::GnssVisibilityControl(Gnss* gnss) : mGnss(gnss) {
+GnssVisibilityControl::GnssVisibilityControl(Gnss* gnss) :
+        mGnss(gnss), mNfwPending(std::make_shared<NfwPending>()) {
     spGnssVisibilityControl = this;
 }
 GnssVisibilityControl::~GnssVisibilityControl() {
@@ -87,21 +94,75 @@ static void convertGnssNfwNotification(GnssNfwNotification& in,
     out.isCachedLocation = in.isCachedLocation;
 }
 
+// what tells two notifications apart, for folding repeats into a pending one
+static std::string nfwNotificationKey(const GnssNfwNotification& in)
+{
+    char fields[64];
+    snprintf(fields, sizeof(fields), "|%d|%d|%d|%d|%d", (int)in.protocolStack,
+             (int)in.requestor, (int)in.responseType, in.inEmergencyMode, in.isCachedLocation);
+    std::string key(in.proxyAppPackageName,
+                    strnlen(in.proxyAppPackageName, GNSS_MAX_NFW_APP_STRING_LEN));
+    key.append(1, '|').append(in.requestorId, strnlen(in.requestorId, GNSS_MAX_NFW_STRING_LEN));
+    key.append(1, '|').append(in.otherProtocolStackName,
+                              strnlen(in.otherProtocolStackName, GNSS_MAX_NFW_STRING_LEN));
+    return key.append(fields);
+}
+
+// Called on the adapter thread; the binder call is made on the HIDL callback
+// dispatcher, so a burst of notifications does not hold up the adapter.
 void GnssVisibilityControl::statusCb(GnssNfwNotification notification) {
 
-    if (mGnssVisibilityControlCbIface != nullptr) {
+    sp<IGnssVisibilityControlCallback> cbIface = mGnssVisibilityControlCbIface;
+    if (cbIface == nullptr) {
+        LOC_LOGw("setCallback has not been called yet");
+        return;
+    }
+
+    // Marks the notification pending until its delivery starts
+    struct PendingToken {
+        std::shared_ptr<NfwPending> mPending;
+        std::string mKey;
+        inline ~PendingToken() {
+            std::lock_guard<std::mutex> lock(mPending->mLock);
+            mPending->mKeys.erase(mKey);
+        }
+    };
+    std::string key = nfwNotificationKey(notification);
+    {
+        std::lock_guard<std::mutex> lock(mNfwPending->mLock);
+        if (!mNfwPending->mKeys.insert(key).second) {
+            sNfwAggregated.fetch_add(1, std::memory_order_relaxed);
+            LOC_LOGd("NFW notification of %s already pending", key.c_str());
+            return;
+        }
+    }
+    auto token = std::make_shared<PendingToken>();
+    token->mPending = mNfwPending;
+    token->mKey = std::move(key);
+    sNfwPosted.fetch_add(1, std::memory_order_relaxed);
+
+    HidlCallbackDispatcher::getInstance().post(HIDL_CB_NFW,
+            [cbIface, notification, token]() mutable {
+        // a repeat coming in from now on is delivered on its own
+        token.reset();
         IGnssVisibilityControlCallback::NfwNotification nfwNotification;
 
         // Convert from one structure to another
         convertGnssNfwNotification(notification, nfwNotification);
 
-        auto r = mGnssVisibilityControlCbIface->nfwNotifyCb(nfwNotification);
+        auto r = cbIface->nfwNotifyCb(nfwNotification);
         if (!r.isOk()) {
             LOC_LOGw("Error invoking NFW status cb %s", r.description().c_str());
         }
-    } else {
-        LOC_LOGw("setCallback has not been called yet");
-    }
+    });
+}
+
+void GnssVisibilityControl::dumpStats(std::string& out) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "NFW notifications: posted=%" PRIu64 " aggregated=%" PRIu64 "\n",
+             sNfwPosted.load(std::memory_order_relaxed),
+             sNfwAggregated.load(std::memory_order_relaxed));
+    out += buf;
 }
 
 bool GnssVisibilityControl::isE911Session() {
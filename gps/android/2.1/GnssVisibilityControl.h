@@ -34,6 +34,11 @@
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
 #include <gps_extended_c.h>
 #include <location_interface.h>
 #include "Gnss.h"
@@ -73,10 +78,23 @@ struct GnssVisibilityControl : public IGnssVisibilityControl {
     /* Data call setup callback passed down to GNSS HAL implementation */
     static void nfwStatusCb(GnssNfwNotification notification);
     static bool isInEmergencySession();
+    // appends the NFW notification counters
+    static void dumpStats(std::string& out);
 
 private:
+    // The notifications posted to the HIDL callback dispatcher and not
+    // delivered yet, so another one alike from the same proxy app is
+    // folded into it. Shared with the posted callbacks, which may run
+    // after this object is gone.
+    struct NfwPending {
+        std::mutex mLock;
+        std::unordered_set<std::string> mKeys;
+    };
     Gnss* mGnss = nullptr;
     sp<IGnssVisibilityControlCallback> mGnssVisibilityControlCbIface = nullptr;
+    std::shared_ptr<NfwPending> mNfwPending;
+    static std::atomic<uint64_t> sNfwPosted;
+    static std::atomic<uint64_t> sNfwAggregated;
 };
 
 
@@ -124,7 +124,9 @@ Return<bool> MeasurementCorrections::setCorrections(
 
     V2_1::implementation::convertMeasurementCorrections(corrections, gnssMeasurementCorrections);
 
-    return mGnss->getGnssInterface()->measCorrSetCorrections(gnssMeasurementCorrections);
+    // moved through to the adapter, which applies it on its own thread
+    return mGnss->getGnssInterface()->measCorrSetCorrections(
+            std::move(gnssMeasurementCorrections));
 }
 
 Return<bool> MeasurementCorrections::setCorrections_1_1(
@@ -141,8 +143,11 @@ Return<bool> MeasurementCorrections::setCorrections_1_1(
     gnssMeasurementCorrections.environmentBearingUncertaintyDegrees =
             corrections.environmentBearingUncertaintyDegrees;
 
-    for (int i = 0; i < corrections.satCorrections.size(); i++) {
-        GnssSingleSatCorrection gnssSingleSatCorrection = {};
+    size_t base = gnssMeasurementCorrections.satCorrections.size();
+    gnssMeasurementCorrections.satCorrections.resize(base + corrections.satCorrections.size());
+    for (size_t i = 0; i < corrections.satCorrections.size(); i++) {
+        GnssSingleSatCorrection& gnssSingleSatCorrection =
+                gnssMeasurementCorrections.satCorrections[base + i];
 
         V2_1::implementation::convertSingleSatCorrections(
                 corrections.satCorrections[i].v1_0, gnssSingleSatCorrection);
@@ -173,10 +178,11 @@ Return<bool> MeasurementCorrections::setCorrections_1_1(
             gnssSingleSatCorrection.svType = GNSS_SV_TYPE_UNKNOWN;
             break;
         }
-        gnssMeasurementCorrections.satCorrections.push_back(gnssSingleSatCorrection);
     }
 
-    return mGnss->getGnssInterface()->measCorrSetCorrections(gnssMeasurementCorrections);
+    // moved through to the adapter, which applies it on its own thread
+    return mGnss->getGnssInterface()->measCorrSetCorrections(
+            std::move(gnssMeasurementCorrections));
 }
 
 Return<bool> MeasurementCorrections::setCallback(
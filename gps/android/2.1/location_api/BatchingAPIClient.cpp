@@ -34,8 +34,11 @@
 #include <log_util.h>
 #include <loc_cfg.h>
 #include <thread>
+#include <memory>
+#include <LocDeltaBatch.h>
 #include "LocationUtil.h"
 #include "BatchingAPIClient.h"
+#include "HidlCallbackDispatcher.h"
 
 #include "limits.h"
 
@@ -53,12 +56,69 @@ using ::android::hardware::gnss::V2_0::GnssLocation;
 static void convertBatchOption(const IGnssBatching::Options& in, LocationOptions& out,
         LocationCapabilitiesMask mask);
 
+// Most locations handed to the framework per gnssLocationBatchCb call,
+// BATCH_FLUSH_CHUNK_SIZE in flp.conf; 0 reports a batch in one call
+static size_t getFlushChunkSize()
+{
+    static const size_t sFlushChunkSize = [] {
+        uint32_t chunkSize = 0;
+        const loc_param_s_type flp_conf_param_table[] =
+        {
+            {"BATCH_FLUSH_CHUNK_SIZE", &chunkSize, NULL, 'n'},
+        };
+        UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
+        LOC_LOGd("BATCH_FLUSH_CHUNK_SIZE: %u", chunkSize);
+        return (size_t)chunkSize;
+    }();
+    return sFlushChunkSize;
+}
+
+// Posts the batch as consecutive gnssLocationBatchCb calls of at most
+// getFlushChunkSize() locations, each decoded and converted on the dispatcher
+// right before its call, so only the encoded batch and one chunk of HIDL
+// locations are alive at a time and no single binder transaction grows with
+// the batch. The chunks run in the order posted, on the never dropping
+// location lane, so they share one reader. An empty batch is still reported,
+// flush() expects an answer.
+template <typename GNSS_LOCATION, typename CALLBACK>
+static void postLocationBatch(const sp<CALLBACK>& cbIface,
+        std::shared_ptr<loc_util::LocDeltaBatch> batch, const char* version)
+{
+    size_t total = batch->size();
+    size_t chunkSize = getFlushChunkSize();
+    if (0 == chunkSize || chunkSize > total) {
+        chunkSize = total;
+    }
+    auto reader = std::make_shared<loc_util::LocDeltaBatch::Reader>(*batch);
+    size_t begin = 0;
+    do {
+        size_t end = begin + chunkSize;
+        HidlCallbackDispatcher::getInstance().post(HIDL_CB_LOCATION,
+                [cbIface, batch, reader, begin, end, version]() {
+            hidl_vec<GNSS_LOCATION> locationVec;
+            locationVec.resize(end - begin);
+            Location location;
+            for (size_t i = begin; i < end && reader->next(location); i++) {
+                convertGnssLocation(location, locationVec[i - begin]);
+            }
+            auto r = cbIface->gnssLocationBatchCb(locationVec);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssLocationBatchCb %s description=%s",
+                        __func__, version, r.description().c_str());
+            }
+        });
+        begin = end;
+    } while (begin < total);
+    LOC_LOGd("(total: %zu chunkSize: %zu bytes: %zu)", total, chunkSize, batch->byteSize());
+}
+
 BatchingAPIClient::BatchingAPIClient(const sp<V1_0::IGnssBatchingCallback>& callback) :
     LocationAPIClientBase(),
     mGnssBatchingCbIface(nullptr),
     mDefaultId(UINT_MAX),
     mLocationCapabilitiesMask(0),
-    mGnssBatchingCbIface_2_0(nullptr)
+    mGnssBatchingCbIface_2_0(nullptr),
+    mCallbacksSet(false)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &callback);
 
@@ -70,7 +130,8 @@ BatchingAPIClient::BatchingAPIClient(const sp<V2_0::IGnssBatchingCallback>& call
     mGnssBatchingCbIface(nullptr),
     mDefaultId(UINT_MAX),
     mLocationCapabilitiesMask(0),
-    mGnssBatchingCbIface_2_0(nullptr)
+    mGnssBatchingCbIface_2_0(nullptr),
+    mCallbacksSet(false)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &callback);
 
@@ -90,6 +151,13 @@ int BatchingAPIClient::getBatchSize() {
 
 void BatchingAPIClient::setCallbacks()
 {
+    // the LocationAPI callbacks do not depend on the framework callback,
+    // a client reused for a new one keeps its registration
+    if (mCallbacksSet) {
+        return;
+    }
+    mCallbacksSet = true;
+
     LocationCallbacks locationCallbacks;
     memset(&locationCallbacks, 0, sizeof(LocationCallbacks));
     locationCallbacks.size = sizeof(LocationCallbacks);
@@ -111,10 +179,12 @@ void BatchingAPIClient::setCallbacks()
     locAPISetCallbacks(locationCallbacks);
 }
 
+// the batches go to the callback of the version set last
 void BatchingAPIClient::gnssUpdateCallbacks(const sp<V1_0::IGnssBatchingCallback>& callback)
 {
     mMutex.lock();
     mGnssBatchingCbIface = callback;
+    mGnssBatchingCbIface_2_0 = nullptr;
     mMutex.unlock();
 
     if (mGnssBatchingCbIface != nullptr) {
@@ -126,6 +196,7 @@ void BatchingAPIClient::gnssUpdateCallbacks_2_0(const sp<V2_0::IGnssBatchingCall
 {
     mMutex.lock();
     mGnssBatchingCbIface_2_0 = callback;
+    mGnssBatchingCbIface = nullptr;
     mMutex.unlock();
 
     if (mGnssBatchingCbIface_2_0 != nullptr) {
@@ -216,9 +287,7 @@ void BatchingAPIClient::onBatchingCb(size_t count, Location* location,
     switch (mState) {
         case STOPPING:
             mState = STOPPED;
-            for (size_t i = 0; i < count; i++) {
-                mBatchedLocationInCache.push_back(location[i]);
-            }
+            mBatchedLocationInCache.append(location, count);
             break;
         case STARTED:
         case STOPPED: // flush() always trigger report, even on a stopped session
@@ -233,37 +302,17 @@ void BatchingAPIClient::onBatchingCb(size_t count, Location* location,
         auto gnssBatchingCbIface_2_0(mGnssBatchingCbIface_2_0);
         size_t batchCacheCnt = mBatchedLocationInCache.size();
         LOC_LOGd("(batchCacheCnt: %zu)", batchCacheCnt);
-        if (gnssBatchingCbIface_2_0 != nullptr) {
-            hidl_vec<V2_0::GnssLocation> locationVec;
-            if (count+batchCacheCnt > 0) {
-                locationVec.resize(count+batchCacheCnt);
-                for (size_t i = 0; i < batchCacheCnt; ++i) {
-                    convertGnssLocation(mBatchedLocationInCache[i], locationVec[i]);
-                }
-                for (size_t i = 0; i < count; i++) {
-                    convertGnssLocation(location[i], locationVec[i+batchCacheCnt]);
-                }
-            }
-            auto r = gnssBatchingCbIface_2_0->gnssLocationBatchCb(locationVec);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssLocationBatchCb 2_0 description=%s",
-                        __func__, r.description().c_str());
-            }
-        } else if (gnssBatchingCbIface != nullptr) {
-            hidl_vec<V1_0::GnssLocation> locationVec;
-            if (count+batchCacheCnt > 0) {
-                locationVec.resize(count+batchCacheCnt);
-                for (size_t i = 0; i < batchCacheCnt; ++i) {
-                    convertGnssLocation(mBatchedLocationInCache[i], locationVec[i]);
-                }
-                for (size_t i = 0; i < count; i++) {
-                    convertGnssLocation(location[i], locationVec[i+batchCacheCnt]);
-                }
-            }
-            auto r = gnssBatchingCbIface->gnssLocationBatchCb(locationVec);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssLocationBatchCb 1.0 description=%s",
-                        __func__, r.description().c_str());
+        // the cached locations first, then this report, encoded once as location is
+        // only good for this call; posted, so neither the decoding, the conversion
+        // nor the binder call is made under mMutex
+        if (gnssBatchingCbIface_2_0 != nullptr || gnssBatchingCbIface != nullptr) {
+            auto batch = std::make_shared<loc_util::LocDeltaBatch>();
+            std::swap(*batch, mBatchedLocationInCache);
+            batch->append(location, count);
+            if (gnssBatchingCbIface_2_0 != nullptr) {
+                postLocationBatch<V2_0::GnssLocation>(gnssBatchingCbIface_2_0, batch, "2_0");
+            } else {
+                postLocationBatch<V1_0::GnssLocation>(gnssBatchingCbIface, batch, "1.0");
             }
         }
         mBatchedLocationInCache.clear();
@@ -36,6 +36,7 @@
 #include <pthread.h>
 
 #include <LocationAPIClientBase.h>
+#include <LocDeltaBatch.h>
 
 namespace android {
 namespace hardware {
@@ -76,8 +77,11 @@ private:
     LocationCapabilitiesMask mLocationCapabilitiesMask;
     sp<V2_0::IGnssBatchingCallback> mGnssBatchingCbIface_2_0;
     volatile BATCHING_STATE mState = STOPPED;
+    bool mCallbacksSet;
 
-    std::vector<Location> mBatchedLocationInCache;
+    // the report of the last stop(), kept encoded until the flush() it goes
+    // out with, which for a long trip can be a large batch
+    loc_util::LocDeltaBatch mBatchedLocationInCache;
 };
 
 }  // namespace implementation
@@ -35,6 +35,7 @@
 
 #include "LocationUtil.h"
 #include "GeofenceAPIClient.h"
+#include "HidlCallbackDispatcher.h"
 
 namespace android {
 namespace hardware {
@@ -142,30 +143,38 @@ void GeofenceAPIClient::geofenceRemoveAll()
 void GeofenceAPIClient::onGeofenceBreachCb(GeofenceBreachNotification geofenceBreachNotification)
 {
     LOC_LOGD("%s]: (%d)", __FUNCTION__, geofenceBreachNotification.count);
-    if (mGnssGeofencingCbIface != nullptr) {
-        for (size_t i = 0; i < geofenceBreachNotification.count; i++) {
-            GnssLocation gnssLocation;
-            convertGnssLocation(geofenceBreachNotification.location, gnssLocation);
+    if (mGnssGeofencingCbIface != nullptr && geofenceBreachNotification.count > 0) {
+        IGnssGeofenceCallback::GeofenceTransition transition;
+        if (geofenceBreachNotification.type == GEOFENCE_BREACH_ENTER)
+            transition = IGnssGeofenceCallback::GeofenceTransition::ENTERED;
+        else if (geofenceBreachNotification.type == GEOFENCE_BREACH_EXIT)
+            transition = IGnssGeofenceCallback::GeofenceTransition::EXITED;
+        else {
+            // nothing to report if transition is
+            // nether GPS_GEOFENCE_ENTERED nor GPS_GEOFENCE_EXITED
+            return;
+        }
 
-            IGnssGeofenceCallback::GeofenceTransition transition;
-            if (geofenceBreachNotification.type == GEOFENCE_BREACH_ENTER)
-                transition = IGnssGeofenceCallback::GeofenceTransition::ENTERED;
-            else if (geofenceBreachNotification.type == GEOFENCE_BREACH_EXIT)
-                transition = IGnssGeofenceCallback::GeofenceTransition::EXITED;
-            else {
-                // continue with other breach if transition is
-                // nether GPS_GEOFENCE_ENTERED nor GPS_GEOFENCE_EXITED
-                continue;
-            }
+        // every geofence of a breach shares its fix, type and timestamp
+        GnssLocation gnssLocation;
+        convertGnssLocation(geofenceBreachNotification.location, gnssLocation);
+        std::vector<uint32_t> ids(geofenceBreachNotification.ids,
+                geofenceBreachNotification.ids + geofenceBreachNotification.count);
 
-            auto r = mGnssGeofencingCbIface->gnssGeofenceTransitionCb(
-                    geofenceBreachNotification.ids[i], gnssLocation, transition,
-                    static_cast<V1_0::GnssUtcTime>(geofenceBreachNotification.timestamp));
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssGeofenceTransitionCb description=%s",
-                    __func__, r.description().c_str());
+        // one dispatch for the whole breach, its transitions back to back
+        HidlCallbackDispatcher::getInstance().post(HIDL_CB_LOCATION,
+                [gnssGeofencingCbIface = mGnssGeofencingCbIface, ids = std::move(ids),
+                 gnssLocation, transition,
+                 timestamp = geofenceBreachNotification.timestamp]() {
+            for (auto id : ids) {
+                auto r = gnssGeofencingCbIface->gnssGeofenceTransitionCb(
+                        id, gnssLocation, transition, static_cast<V1_0::GnssUtcTime>(timestamp));
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssGeofenceTransitionCb description=%s",
+                        __func__, r.description().c_str());
+                }
             }
-        }
+        });
     }
 }
 
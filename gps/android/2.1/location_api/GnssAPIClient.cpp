@@ -32,12 +32,18 @@
 #define SINGLE_SHOT_MIN_TRACKING_INTERVAL_MSEC (590 * 60 * 60 * 1000) // 590 hours
 
 #include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#include <atomic>
 #include <log_util.h>
 #include <loc_cfg.h>
 
 #include "LocationUtil.h"
 #include "GnssAPIClient.h"
+#include "HidlCallbackDispatcher.h"
 #include <LocContext.h>
+#include <LocTrace.h>
+#include <LocHistogram.h>
 
 namespace android {
 namespace hardware {
@@ -51,10 +57,19 @@ using ::android::hardware::gnss::V1_0::IGnssNiCallback;
 using ::android::hardware::gnss::V2_0::GnssLocation;
 
 static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out);
+static void extrapolateLocation(Location& location, uint32_t maxMs);
+
+// time the fixes were moved forward, and by how far
+static loc_util::LocHistogram sExtrapolationMs;
+static loc_util::LocHistogram sExtrapolationCm;
+// fixes delivered as reported, for lack of speed / bearing / elapsed real time or being too old
+static std::atomic<uint64_t> sExtrapolationSkipped(0);
 static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out);
+        hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out,
+        HidlScratchVector<V2_0::IGnssCallback::GnssSvInfo>& svInfos);
 static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out);
+        hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out,
+        HidlScratchVector<V2_1::IGnssCallback::GnssSvInfo>& svInfos);
 
 GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
         const sp<V1_0::IGnssNiCallback>& niCb) :
@@ -65,6 +80,10 @@ GnssAPIClient::GnssAPIClient(const sp<V1_0::IGnssCallback>& gpsCb,
     mLocationCapabilitiesMask(0),
     mLocationCapabilitiesCached(false),
     mTracking(false),
+    mNmeaEpochBatching(false),
+    mExtrapolationMaxMs(0),
+    mCallbacksSet(false),
+    mNiCbSet(false),
     mGnssCbIface_2_0(nullptr)
 {
     LOC_LOGD("%s]: (%p %p)", __FUNCTION__, &gpsCb, &niCb);
@@ -81,6 +100,10 @@ GnssAPIClient::GnssAPIClient(const sp<V2_0::IGnssCallback>& gpsCb) :
     mLocationCapabilitiesMask(0),
     mLocationCapabilitiesCached(false),
     mTracking(false),
+    mNmeaEpochBatching(false),
+    mExtrapolationMaxMs(0),
+    mCallbacksSet(false),
+    mNiCbSet(false),
     mGnssCbIface_2_0(nullptr)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
@@ -97,6 +120,10 @@ GnssAPIClient::GnssAPIClient(const sp<V2_1::IGnssCallback>& gpsCb) :
     mLocationCapabilitiesMask(0),
     mLocationCapabilitiesCached(false),
     mTracking(false),
+    mNmeaEpochBatching(false),
+    mExtrapolationMaxMs(0),
+    mCallbacksSet(false),
+    mNiCbSet(false),
     mGnssCbIface_2_1(nullptr)
 {
     LOC_LOGD("%s]: (%p)", __FUNCTION__, &gpsCb);
@@ -122,10 +149,31 @@ void GnssAPIClient::initLocationOptions()
     mTrackingOptions.minInterval = 1000;
     mTrackingOptions.minDistance = 0;
     mTrackingOptions.mode = GNSS_SUPL_MODE_STANDALONE;
+
+    uint32_t nmeaEpochBatching = 0;
+    loc_param_s_type nmea_conf_table[] =
+    {
+        { "NMEA_EPOCH_BATCHING_ENABLED", &nmeaEpochBatching, NULL, 'n' },
+        { "POSITION_EXTRAPOLATION_MAX_MS", &mExtrapolationMaxMs, NULL, 'n' }
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, nmea_conf_table);
+    mNmeaEpochBatching = (1 == nmeaEpochBatching);
 }
 
 void GnssAPIClient::setCallbacks()
 {
+    bool niCb = false;
+    if (mGnssNiCbIface != nullptr) {
+        loc_core::ContextBase* context =
+                loc_core::LocContext::getLocContext(loc_core::LocContext::mLocationHalName);
+        niCb = !context->hasAgpsExtendedCapabilities();
+    }
+    if (mCallbacksSet && (mNiCbSet || !niCb)) {
+        // e.g. a framework client attaching after the previous one died
+        LOC_LOGD("%s]: registered callbacks unchanged", __FUNCTION__);
+        return;
+    }
+
     LocationCallbacks locationCallbacks;
     memset(&locationCallbacks, 0, sizeof(LocationCallbacks));
     locationCallbacks.size = sizeof(LocationCallbacks);
@@ -140,15 +188,11 @@ void GnssAPIClient::setCallbacks()
     locationCallbacks.geofenceStatusCb = nullptr;
     locationCallbacks.gnssLocationInfoCb = nullptr;
     locationCallbacks.gnssNiCb = nullptr;
-    if (mGnssNiCbIface != nullptr) {
-        loc_core::ContextBase* context =
-                loc_core::LocContext::getLocContext(loc_core::LocContext::mLocationHalName);
-        if (!context->hasAgpsExtendedCapabilities()) {
-            LOC_LOGD("Registering NI CB");
-            locationCallbacks.gnssNiCb = [this](uint32_t id, GnssNiNotification gnssNiNotify) {
-                onGnssNiCb(id, gnssNiNotify);
-            };
-        }
+    if (niCb || mNiCbSet) {
+        LOC_LOGD("Registering NI CB");
+        locationCallbacks.gnssNiCb = [this](uint32_t id, GnssNiNotification gnssNiNotify) {
+            onGnssNiCb(id, gnssNiNotify);
+        };
     }
 
     locationCallbacks.gnssSvCb = nullptr;
@@ -164,6 +208,8 @@ void GnssAPIClient::setCallbacks()
     locationCallbacks.gnssMeasurementsCb = nullptr;
 
     locAPISetCallbacks(locationCallbacks);
+    mCallbacksSet = true;
+    mNiCbSet = (nullptr != locationCallbacks.gnssNiCb);
 }
 
 // for GpsInterface
@@ -208,6 +254,18 @@ void GnssAPIClient::gnssUpdateCallbacks_2_1(const sp<V2_1::IGnssCallback>& gpsCb
     }
 }
 
+void GnssAPIClient::gnssDetachCallbacks()
+{
+    LOC_LOGD("%s]: ()", __FUNCTION__);
+
+    mMutex.lock();
+    mGnssCbIface = nullptr;
+    mGnssNiCbIface = nullptr;
+    mGnssCbIface_2_0 = nullptr;
+    mGnssCbIface_2_1 = nullptr;
+    mMutex.unlock();
+}
+
 bool GnssAPIClient::gnssStart()
 {
     LOC_LOGD("%s]: ()", __FUNCTION__);
@@ -486,6 +544,7 @@ void GnssAPIClient::onCapabilitiesCb(LocationCapabilitiesMask capabilitiesMask)
 
 void GnssAPIClient::onTrackingCb(Location location)
 {
+    loc_util::LocTraceHop traceHop("GnssAPIClient::onTrackingCb");
     mMutex.lock();
     auto gnssCbIface(mGnssCbIface);
     auto gnssCbIface_2_0(mGnssCbIface_2_0);
@@ -499,34 +558,43 @@ void GnssAPIClient::onTrackingCb(Location location)
         return;
     }
 
-    if (gnssCbIface_2_1 != nullptr) {
-        V2_0::GnssLocation gnssLocation;
-        convertGnssLocation(location, gnssLocation);
-        auto r = gnssCbIface_2_1->gnssLocationCb_2_0(gnssLocation);
-        if (!r.isOk()) {
-            LOC_LOGE("%s] Error from gnssLocationCb_2_0 description=%s",
-                __func__, r.description().c_str());
+    uint32_t extrapolationMaxMs = mExtrapolationMaxMs;
+    HidlCallbackDispatcher::getInstance().post(HIDL_CB_LOCATION,
+            [gnssCbIface, gnssCbIface_2_0, gnssCbIface_2_1, location,
+             extrapolationMaxMs]() mutable {
+        // the HIDL hop ends when the framework returns from the callback
+        loc_util::LocTraceHop hidlTraceHop("IGnssCallback::gnssLocationCb");
+        if (extrapolationMaxMs > 0) {
+            extrapolateLocation(location, extrapolationMaxMs);
         }
-    } else if (gnssCbIface_2_0 != nullptr) {
-        V2_0::GnssLocation gnssLocation;
-        convertGnssLocation(location, gnssLocation);
-        auto r = gnssCbIface_2_0->gnssLocationCb_2_0(gnssLocation);
-        if (!r.isOk()) {
-            LOC_LOGE("%s] Error from gnssLocationCb_2_0 description=%s",
-                __func__, r.description().c_str());
-        }
-    } else if (gnssCbIface != nullptr) {
-        V1_0::GnssLocation gnssLocation;
-        convertGnssLocation(location, gnssLocation);
-        auto r = gnssCbIface->gnssLocationCb(gnssLocation);
-        if (!r.isOk()) {
-            LOC_LOGE("%s] Error from gnssLocationCb description=%s",
-                __func__, r.description().c_str());
+        if (gnssCbIface_2_1 != nullptr) {
+            V2_0::GnssLocation gnssLocation;
+            convertGnssLocation(location, gnssLocation);
+            auto r = gnssCbIface_2_1->gnssLocationCb_2_0(gnssLocation);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssLocationCb_2_0 description=%s",
+                    __func__, r.description().c_str());
+            }
+        } else if (gnssCbIface_2_0 != nullptr) {
+            V2_0::GnssLocation gnssLocation;
+            convertGnssLocation(location, gnssLocation);
+            auto r = gnssCbIface_2_0->gnssLocationCb_2_0(gnssLocation);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssLocationCb_2_0 description=%s",
+                    __func__, r.description().c_str());
+            }
+        } else if (gnssCbIface != nullptr) {
+            V1_0::GnssLocation gnssLocation;
+            convertGnssLocation(location, gnssLocation);
+            auto r = gnssCbIface->gnssLocationCb(gnssLocation);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssLocationCb description=%s",
+                    __func__, r.description().c_str());
+            }
+        } else {
+            LOC_LOGW("%s] No GNSS Interface ready for gnssLocationCb ", __FUNCTION__);
         }
-    } else {
-        LOC_LOGW("%s] No GNSS Interface ready for gnssLocationCb ", __FUNCTION__);
-    }
-
+    });
 }
 
 void GnssAPIClient::onGnssNiCb(uint32_t id, GnssNiNotification gnssNiNotification)
@@ -611,33 +679,40 @@ void GnssAPIClient::onGnssSvCb(GnssSvNotification gnssSvNotification)
     auto gnssCbIface(mGnssCbIface);
     auto gnssCbIface_2_0(mGnssCbIface_2_0);
     auto gnssCbIface_2_1(mGnssCbIface_2_1);
+    std::shared_ptr<SvScratch> svScratch(mSvScratch);
     mMutex.unlock();
 
-    if (gnssCbIface_2_1 != nullptr) {
-        hidl_vec<V2_1::IGnssCallback::GnssSvInfo> svInfoList;
-        convertGnssSvStatus(gnssSvNotification, svInfoList);
-        auto r = gnssCbIface_2_1->gnssSvStatusCb_2_1(svInfoList);
-        if (!r.isOk()) {
-            LOC_LOGE("%s] Error from gnssSvStatusCb_2_1 description=%s",
-                __func__, r.description().c_str());
-        }
-    } else if (gnssCbIface_2_0 != nullptr) {
-        hidl_vec<V2_0::IGnssCallback::GnssSvInfo> svInfoList;
-        convertGnssSvStatus(gnssSvNotification, svInfoList);
-        auto r = gnssCbIface_2_0->gnssSvStatusCb_2_0(svInfoList);
-        if (!r.isOk()) {
-            LOC_LOGE("%s] Error from gnssSvStatusCb_2_0 description=%s",
-                __func__, r.description().c_str());
-        }
-    } else if (gnssCbIface != nullptr) {
-        V1_0::IGnssCallback::GnssSvStatus svStatus;
-        convertGnssSvStatus(gnssSvNotification, svStatus);
-        auto r = gnssCbIface->gnssSvStatusCb(svStatus);
-        if (!r.isOk()) {
-            LOC_LOGE("%s] Error from gnssSvStatusCb description=%s",
-                __func__, r.description().c_str());
+    // the closure may run after this client is gone, so it shares the scratch
+    // vectors instead of reaching them through this
+    HidlCallbackDispatcher::getInstance().post(HIDL_CB_SV,
+            [svScratch, gnssCbIface, gnssCbIface_2_0, gnssCbIface_2_1,
+             gnssSvNotification]() mutable {
+        if (gnssCbIface_2_1 != nullptr) {
+            hidl_vec<V2_1::IGnssCallback::GnssSvInfo> svInfoList;
+            convertGnssSvStatus(gnssSvNotification, svInfoList, svScratch->mSvInfos_2_1);
+            auto r = gnssCbIface_2_1->gnssSvStatusCb_2_1(svInfoList);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssSvStatusCb_2_1 description=%s",
+                    __func__, r.description().c_str());
+            }
+        } else if (gnssCbIface_2_0 != nullptr) {
+            hidl_vec<V2_0::IGnssCallback::GnssSvInfo> svInfoList;
+            convertGnssSvStatus(gnssSvNotification, svInfoList, svScratch->mSvInfos_2_0);
+            auto r = gnssCbIface_2_0->gnssSvStatusCb_2_0(svInfoList);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssSvStatusCb_2_0 description=%s",
+                    __func__, r.description().c_str());
+            }
+        } else if (gnssCbIface != nullptr) {
+            V1_0::IGnssCallback::GnssSvStatus svStatus;
+            convertGnssSvStatus(gnssSvNotification, svStatus);
+            auto r = gnssCbIface->gnssSvStatusCb(svStatus);
+            if (!r.isOk()) {
+                LOC_LOGE("%s] Error from gnssSvStatusCb description=%s",
+                    __func__, r.description().c_str());
+            }
         }
-    }
+    });
 }
 
 void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
@@ -648,40 +723,64 @@ void GnssAPIClient::onGnssNmeaCb(GnssNmeaNotification gnssNmeaNotification)
     auto gnssCbIface_2_1(mGnssCbIface_2_1);
     mMutex.unlock();
 
-    if (gnssCbIface != nullptr || gnssCbIface_2_0 != nullptr || gnssCbIface_2_1 != nullptr) {
-        const std::string s(gnssNmeaNotification.nmea);
-        std::stringstream ss(s);
-        std::string each;
-        while(std::getline(ss, each, '\n')) {
-            each += '\n';
+    if (gnssCbIface == nullptr && gnssCbIface_2_0 == nullptr && gnssCbIface_2_1 == nullptr) {
+        return;
+    }
+
+    // each binder transaction is posted with its own copy of the text, the
+    // notification buffer is only valid until this callback returns
+    auto timestamp = gnssNmeaNotification.timestamp;
+    auto sendNmea = [&](std::string&& nmea) {
+        HidlCallbackDispatcher::getInstance().post(HIDL_CB_NMEA,
+                [gnssCbIface, gnssCbIface_2_0, gnssCbIface_2_1, timestamp,
+                 nmea = std::move(nmea)]() {
             android::hardware::hidl_string nmeaString;
-            nmeaString.setToExternal(each.c_str(), each.length());
+            nmeaString.setToExternal(nmea.c_str(), nmea.length());
             if (gnssCbIface_2_1 != nullptr) {
                 auto r = gnssCbIface_2_1->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
+                        static_cast<V1_0::GnssUtcTime>(timestamp), nmeaString);
                 if (!r.isOk()) {
-                    LOC_LOGE("%s] Error from gnssCbIface_2_1 nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
-                             r.description().c_str());
+                    LOC_LOGE("%s] Error from gnssCbIface_2_1 nmea=%s length=%zu description=%s",
+                             __func__, nmea.c_str(), nmea.length(), r.description().c_str());
                 }
             } else if (gnssCbIface_2_0 != nullptr) {
                 auto r = gnssCbIface_2_0->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
+                        static_cast<V1_0::GnssUtcTime>(timestamp), nmeaString);
                 if (!r.isOk()) {
-                    LOC_LOGE("%s] Error from gnssCbIface_2_0 nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
-                             r.description().c_str());
+                    LOC_LOGE("%s] Error from gnssCbIface_2_0 nmea=%s length=%zu description=%s",
+                             __func__, nmea.c_str(), nmea.length(), r.description().c_str());
                 }
             } else if (gnssCbIface != nullptr) {
                 auto r = gnssCbIface->gnssNmeaCb(
-                        static_cast<V1_0::GnssUtcTime>(gnssNmeaNotification.timestamp), nmeaString);
+                        static_cast<V1_0::GnssUtcTime>(timestamp), nmeaString);
                 if (!r.isOk()) {
-                    LOC_LOGE("%s] Error from gnssNmeaCb nmea=%s length=%u description=%s",
-                             __func__, gnssNmeaNotification.nmea, gnssNmeaNotification.length,
-                             r.description().c_str());
+                    LOC_LOGE("%s] Error from gnssNmeaCb nmea=%s length=%zu description=%s",
+                             __func__, nmea.c_str(), nmea.length(), r.description().c_str());
                 }
             }
+        });
+    };
+
+    if (mNmeaEpochBatching) {
+        // one binder transaction for the whole epoch
+        sendNmea(std::string(gnssNmeaNotification.nmea,
+                strnlen(gnssNmeaNotification.nmea, gnssNmeaNotification.length)));
+        return;
+    }
+
+    // one sentence per call, each with its '\n'. hidl_string sends the NUL
+    // after the string too, so every sentence is copied to be terminated.
+    const char* each = gnssNmeaNotification.nmea;
+    const char* end = each + strnlen(each, gnssNmeaNotification.length);
+    while (each < end) {
+        const char* newline = (const char*)memchr(each, '\n', end - each);
+        const char* next = (nullptr != newline) ? newline + 1 : end;
+        std::string sentence(each, next - each);
+        if (nullptr == newline) {
+            sentence += '\n';
         }
+        sendNmea(std::move(sentence));
+        each = next;
     }
 }
 
@@ -694,42 +793,45 @@ void GnssAPIClient::onStartTrackingCb(LocationError error)
     auto gnssCbIface_2_1(mGnssCbIface_2_1);
     mMutex.unlock();
 
-    if (error == LOCATION_ERROR_SUCCESS) {
-        if (gnssCbIface_2_1 != nullptr) {
-            auto r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_ON description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_BEGIN description=%s",
-                    __func__, r.description().c_str());
-            }
-        } else if (gnssCbIface_2_0 != nullptr) {
-            auto r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_ON description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_BEGIN description=%s",
-                    __func__, r.description().c_str());
-            }
-        } else if (gnssCbIface != nullptr) {
-            auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb ENGINE_ON description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb SESSION_BEGIN description=%s",
-                    __func__, r.description().c_str());
+    HidlCallbackDispatcher::getInstance().post(HIDL_CB_LOCATION,
+            [gnssCbIface, gnssCbIface_2_0, gnssCbIface_2_1, error]() mutable {
+        if (error == LOCATION_ERROR_SUCCESS) {
+            if (gnssCbIface_2_1 != nullptr) {
+                auto r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_ON description=%s",
+                        __func__, r.description().c_str());
+                }
+                r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_BEGIN description=%s",
+                        __func__, r.description().c_str());
+                }
+            } else if (gnssCbIface_2_0 != nullptr) {
+                auto r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_ON description=%s",
+                        __func__, r.description().c_str());
+                }
+                r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_BEGIN description=%s",
+                        __func__, r.description().c_str());
+                }
+            } else if (gnssCbIface != nullptr) {
+                auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_ON);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb ENGINE_ON description=%s",
+                        __func__, r.description().c_str());
+                }
+                r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_BEGIN);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb SESSION_BEGIN description=%s",
+                        __func__, r.description().c_str());
+                }
             }
         }
-    }
+    });
 }
 
 void GnssAPIClient::onStopTrackingCb(LocationError error)
@@ -741,43 +843,113 @@ void GnssAPIClient::onStopTrackingCb(LocationError error)
     auto gnssCbIface_2_1(mGnssCbIface_2_1);
     mMutex.unlock();
 
-    if (error == LOCATION_ERROR_SUCCESS) {
-        if (gnssCbIface_2_1 != nullptr) {
-            auto r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_END description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_OFF description=%s",
-                    __func__, r.description().c_str());
-            }
-        } else if (gnssCbIface_2_0 != nullptr) {
-            auto r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_END description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_OFF description=%s",
-                    __func__, r.description().c_str());
-            }
+    HidlCallbackDispatcher::getInstance().post(HIDL_CB_LOCATION,
+            [gnssCbIface, gnssCbIface_2_0, gnssCbIface_2_1, error]() mutable {
+        if (error == LOCATION_ERROR_SUCCESS) {
+            if (gnssCbIface_2_1 != nullptr) {
+                auto r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_END description=%s",
+                        __func__, r.description().c_str());
+                }
+                r = gnssCbIface_2_1->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_OFF description=%s",
+                        __func__, r.description().c_str());
+                }
+            } else if (gnssCbIface_2_0 != nullptr) {
+                auto r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 SESSION_END description=%s",
+                        __func__, r.description().c_str());
+                }
+                r = gnssCbIface_2_0->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb 2_0 ENGINE_OFF description=%s",
+                        __func__, r.description().c_str());
+                }
 
-        } else if (gnssCbIface != nullptr) {
-            auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb SESSION_END description=%s",
-                    __func__, r.description().c_str());
-            }
-            r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
-            if (!r.isOk()) {
-                LOC_LOGE("%s] Error from gnssStatusCb ENGINE_OFF description=%s",
-                    __func__, r.description().c_str());
+            } else if (gnssCbIface != nullptr) {
+                auto r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::SESSION_END);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb SESSION_END description=%s",
+                        __func__, r.description().c_str());
+                }
+                r = gnssCbIface->gnssStatusCb(IGnssCallback::GnssStatusValue::ENGINE_OFF);
+                if (!r.isOk()) {
+                    LOC_LOGE("%s] Error from gnssStatusCb ENGINE_OFF description=%s",
+                        __func__, r.description().c_str());
+                }
             }
         }
+    });
+}
+
+void GnssAPIClient::dumpStats(std::string& out)
+{
+    char buf[96];
+    snprintf(buf, sizeof(buf), "Position extrapolation: skipped=%" PRIu64 "\n",
+             sExtrapolationSkipped.load(std::memory_order_relaxed));
+    out += buf;
+    out += "    delay: ";
+    sExtrapolationMs.dump(out, "ms");
+    out += "\n    shift: ";
+    sExtrapolationCm.dump(out, "cm");
+    out += "\n";
+}
+
+// Moves location from the time the engine reported it to now, dead reckoning
+// along its speed and bearing on a sphere, which is plenty over the few hundred
+// msec a fix spends in the pipeline. Timestamps move with it and the horizontal
+// accuracy grows by the speed uncertainty over that time.
+static void extrapolateLocation(Location& location, uint32_t maxMs)
+{
+    const LocationFlagsMask needed = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_SPEED_BIT |
+            LOCATION_HAS_BEARING_BIT | LOCATION_HAS_ELAPSED_REAL_TIME;
+    struct timespec ts = {};
+    if ((location.flags & needed) != needed ||
+            0 != clock_gettime(CLOCK_BOOTTIME, &ts)) {
+        sExtrapolationSkipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t nowNs = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    if (nowNs <= location.elapsedRealTime ||
+            nowNs - location.elapsedRealTime > (uint64_t)maxMs * 1000000ULL) {
+        sExtrapolationSkipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t delayNs = nowNs - location.elapsedRealTime;
+    double delaySec = delayNs / 1e9;
+    double distance = location.speed * delaySec;
+    double bearingRad = location.bearing * M_PI / 180.0;
+    double latRad = location.latitude * M_PI / 180.0;
+    const double earthRadius = 6371008.8;
+
+    location.latitude += (distance * cos(bearingRad) / earthRadius) * 180.0 / M_PI;
+    double cosLat = cos(latRad);
+    if (cosLat > 1e-6) {
+        location.longitude += (distance * sin(bearingRad) / (earthRadius * cosLat)) *
+                180.0 / M_PI;
+        if (location.longitude > 180.0) {
+            location.longitude -= 360.0;
+        } else if (location.longitude < -180.0) {
+            location.longitude += 360.0;
+        }
+    }
+    if (location.latitude > 90.0) {
+        location.latitude = 90.0;
+    } else if (location.latitude < -90.0) {
+        location.latitude = -90.0;
     }
+    if ((location.flags & LOCATION_HAS_ACCURACY_BIT) &&
+            (location.flags & LOCATION_HAS_SPEED_ACCURACY_BIT)) {
+        location.accuracy += location.speedAccuracy * delaySec;
+    }
+    location.timestamp += delayNs / 1000000ULL;
+    location.elapsedRealTime = nowNs;
+
+    sExtrapolationMs.record(delayNs / 1000000ULL);
+    sExtrapolationCm.record((uint64_t)(distance * 100.0));
 }
 
 static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::GnssSvStatus& out)
@@ -809,9 +981,11 @@ static void convertGnssSvStatus(GnssSvNotification& in, V1_0::IGnssCallback::Gns
 }
 
 static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out)
+        hidl_vec<V2_0::IGnssCallback::GnssSvInfo>& out,
+        HidlScratchVector<V2_0::IGnssCallback::GnssSvInfo>& svInfos)
 {
-    out.resize(in.count);
+    svInfos.resize(in.count);
+    out.setToExternal(svInfos.data(), svInfos.size());
     for (size_t i = 0; i < in.count; i++) {
         convertGnssSvid(in.gnssSvs[i], out[i].v1_0.svid);
         out[i].v1_0.cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
@@ -833,9 +1007,11 @@ static void convertGnssSvStatus(GnssSvNotification& in,
 }
 
 static void convertGnssSvStatus(GnssSvNotification& in,
-        hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out)
+        hidl_vec<V2_1::IGnssCallback::GnssSvInfo>& out,
+        HidlScratchVector<V2_1::IGnssCallback::GnssSvInfo>& svInfos)
 {
-    out.resize(in.count);
+    svInfos.resize(in.count);
+    out.setToExternal(svInfos.data(), svInfos.size());
     for (size_t i = 0; i < in.count; i++) {
         convertGnssSvid(in.gnssSvs[i], out[i].v2_0.v1_0.svid);
         out[i].v2_0.v1_0.cN0Dbhz = in.gnssSvs[i].cN0Dbhz;
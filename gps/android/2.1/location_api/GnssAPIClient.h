@@ -31,10 +31,14 @@
 #define GNSS_API_CLINET_H
 
 
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 #include <android/hardware/gnss/2.1/IGnss.h>
 #include <android/hardware/gnss/2.1/IGnssCallback.h>
 #include <LocationAPIClientBase.h>
+#include "LocationUtil.h"
 
 namespace android {
 namespace hardware {
@@ -59,6 +63,9 @@ public:
             const sp<V1_0::IGnssNiCallback>& niCb);
     void gnssUpdateCallbacks_2_0(const sp<V2_0::IGnssCallback>& gpsCb);
     void gnssUpdateCallbacks_2_1(const sp<V2_1::IGnssCallback>& gpsCb);
+    // drops the callbacks of a framework client that died, keeping the
+    // LocationAPI registration and the session options for the next one
+    void gnssDetachCallbacks();
     bool gnssStart();
     bool gnssStop();
     bool gnssSetPositionMode(V1_0::IGnss::GnssPositionMode mode,
@@ -93,6 +100,9 @@ public:
     void onStartTrackingCb(LocationError error) final;
     void onStopTrackingCb(LocationError error) final;
 
+    // appends how far fixes were extrapolated to their delivery time
+    static void dumpStats(std::string& out);
+
 private:
     virtual ~GnssAPIClient();
     void setCallbacks();
@@ -106,8 +116,26 @@ private:
     bool mLocationCapabilitiesCached;
     TrackingOptions mTrackingOptions;
     bool mTracking;
+    // the adapter delivers an epoch's NMEA at once, forward it in one call
+    bool mNmeaEpochBatching;
+    // fixes up to this old are moved along their speed and bearing to the time
+    // they reach the framework, 0 delivers them as reported
+    uint32_t mExtrapolationMaxMs;
+    // what setCallbacks() registered with the LocationAPI; the callbacks look
+    // their interfaces up when called, so a new client only needs registering
+    // if it brings an NI callback the registration does not have yet
+    bool mCallbacksSet;
+    bool mNiCbSet;
     sp<V2_0::IGnssCallback> mGnssCbIface_2_0;
     sp<V2_1::IGnssCallback> mGnssCbIface_2_1;
+    // Backing storage for the SV list handed to the framework, only touched
+    // on the HidlCallbackDispatcher thread; it keeps its capacity between SV
+    // reports. Shared with the posted callbacks, which may outlive the client.
+    struct SvScratch {
+        HidlScratchVector<V2_0::IGnssCallback::GnssSvInfo> mSvInfos_2_0;
+        HidlScratchVector<V2_1::IGnssCallback::GnssSvInfo> mSvInfos_2_1;
+    };
+    const std::shared_ptr<SvScratch> mSvScratch = std::make_shared<SvScratch>();
 };
 
 }  // namespace implementation
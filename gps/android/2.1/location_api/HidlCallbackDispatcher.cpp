@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_HidlCallbackDispatcher"
+
+#include <inttypes.h>
+#include <time.h>
+#include <log_util.h>
+#include <LocMemStats.h>
+
+#include "HidlCallbackDispatcher.h"
+
+namespace android {
+namespace hardware {
+namespace gnss {
+namespace V2_1 {
+namespace implementation {
+
+// NMEA comes one sentence per callback unless epoch batching is on, so its
+// lane holds a few epochs worth; SV and measurements only need the latest
+#define HIDL_CB_NMEA_LANE_CAPACITY 64
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+HidlCallbackDispatcher& HidlCallbackDispatcher::getInstance() {
+    // never destroyed, callbacks may still be posted while the process exits
+    static HidlCallbackDispatcher* sInstance = new HidlCallbackDispatcher();
+    return *sInstance;
+}
+
+HidlCallbackDispatcher::HidlCallbackDispatcher() :
+    mMsgTask("HidlCbDispatch")
+{
+    static const struct {
+        const char* name;
+        uint32_t capacity;
+    } sLaneConfig[HIDL_CB_TYPE_COUNT] = {
+        { "location", 0 },
+        { "sv", 1 },
+        { "nmea", HIDL_CB_NMEA_LANE_CAPACITY },
+        { "measurements", 1 },
+        // each one is a user visible privacy record, so not bounded; bursts
+        // during emergency and carrier sessions are kept down to one per
+        // proxy app by the aggregation in GnssVisibilityControl
+        { "nfw", 0 },
+    };
+    for (int i = 0; i < HIDL_CB_TYPE_COUNT; i++) {
+        mLanes[i].mName = sLaneConfig[i].name;
+        mLanes[i].mCapacity = sLaneConfig[i].capacity;
+        mLanes[i].mPosted = 0;
+        mLanes[i].mDropped = 0;
+        mLanes[i].mHighWater = 0;
+    }
+}
+
+void HidlCallbackDispatcher::post(HidlCallbackType type, std::function<void()>&& callback) {
+    Lane& lane = mLanes[type];
+    bool dropped = false;
+    {
+        std::lock_guard<std::mutex> lock(lane.mLock);
+        lane.mPosted++;
+        if (lane.mCapacity > 0 && lane.mPending.size() >= lane.mCapacity) {
+            // the dispatch msg of the dropped callback is already queued and
+            // runs whichever callback is first in the lane by then
+            lane.mPending.pop_front();
+            lane.mDropped++;
+            dropped = true;
+        } else {
+            loc_util::LocMemStats::allocated(loc_util::LOC_MEM_HIDL, sizeof(Pending));
+        }
+        lane.mPending.push_back({std::move(callback), monotonicNs()});
+        if (lane.mPending.size() > lane.mHighWater) {
+            lane.mHighWater = lane.mPending.size();
+        }
+    }
+    if (!dropped) {
+        mMsgTask.sendMsg([this, type]() {
+            dispatch(type);
+        });
+    }
+}
+
+void HidlCallbackDispatcher::dispatch(HidlCallbackType type) {
+    Lane& lane = mLanes[type];
+    Pending pending;
+    {
+        std::lock_guard<std::mutex> lock(lane.mLock);
+        if (lane.mPending.empty()) {
+            return;
+        }
+        pending = std::move(lane.mPending.front());
+        lane.mPending.pop_front();
+    }
+    loc_util::LocMemStats::released(loc_util::LOC_MEM_HIDL, sizeof(Pending));
+    uint64_t startNs = monotonicNs();
+    lane.mQueueUs.record((startNs - pending.mPostNs) / 1000);
+    pending.mCallback();
+    lane.mCallbackUs.record((monotonicNs() - startNs) / 1000);
+}
+
+void HidlCallbackDispatcher::dumpStats(std::string& out) {
+    char buf[160];
+    out += "HIDL callbacks:\n";
+    for (int i = 0; i < HIDL_CB_TYPE_COUNT; i++) {
+        Lane& lane = mLanes[i];
+        uint64_t posted, dropped;
+        size_t pending;
+        uint32_t highWater;
+        {
+            std::lock_guard<std::mutex> lock(lane.mLock);
+            posted = lane.mPosted;
+            dropped = lane.mDropped;
+            pending = lane.mPending.size();
+            highWater = lane.mHighWater;
+        }
+        snprintf(buf, sizeof(buf),
+                 "  %s: posted=%" PRIu64 " dropped=%" PRIu64 " pending=%zu high_water=%u\n",
+                 lane.mName, posted, dropped, pending, highWater);
+        out += buf;
+        out += "    queue wait: ";
+        lane.mQueueUs.dump(out, "us");
+        out += "\n    round trip: ";
+        lane.mCallbackUs.dump(out, "us");
+        out += "\n";
+    }
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace gnss
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HIDL_CALLBACK_DISPATCHER_H
+#define HIDL_CALLBACK_DISPATCHER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+#include <MsgTask.h>
+#include <LocHistogram.h>
+
+namespace android {
+namespace hardware {
+namespace gnss {
+namespace V2_1 {
+namespace implementation {
+
+// Framework callback kinds, each queued in a lane of its own
+typedef enum {
+    // fixes, session status, batched fixes and geofence breaches, never dropped
+    HIDL_CB_LOCATION = 0,
+    // SV status, coalesced to the latest report
+    HIDL_CB_SV,
+    // NMEA, the oldest sentences make room once the lane is full
+    HIDL_CB_NMEA,
+    // raw measurements, coalesced to the latest epoch
+    HIDL_CB_MEASUREMENTS,
+    // non-framework location access notifications, never dropped, repeats
+    // of a pending one are aggregated before they are posted
+    HIDL_CB_NFW,
+    HIDL_CB_TYPE_COUNT
+} HidlCallbackType;
+
+// Runs framework (binder) callbacks on a thread of their own, so a slow or
+// stuck system_server backs up bounded lanes here instead of stalling the
+// LocationAPI callback thread and everything queued behind it.
+class HidlCallbackDispatcher {
+public:
+    static HidlCallbackDispatcher& getInstance();
+
+    // Queues callback to run on the dispatcher thread. If the lane of type
+    // is full its oldest pending callback is dropped.
+    void post(HidlCallbackType type, std::function<void()>&& callback);
+    // appends per lane post / drop counts, queue wait and callback times
+    void dumpStats(std::string& out);
+
+private:
+    struct Pending {
+        std::function<void()> mCallback;
+        uint64_t mPostNs;
+    };
+    struct Lane {
+        const char* mName;
+        // pending callbacks kept, 0 for no bound
+        uint32_t mCapacity;
+        std::mutex mLock;
+        std::deque<Pending> mPending;
+        uint64_t mPosted;
+        uint64_t mDropped;
+        uint32_t mHighWater;
+        // from post() until the callback starts, in usec
+        loc_util::LocHistogram mQueueUs;
+        // callback round trip into the framework, in usec
+        loc_util::LocHistogram mCallbackUs;
+    };
+
+    HidlCallbackDispatcher();
+    HidlCallbackDispatcher(const HidlCallbackDispatcher&) = delete;
+    HidlCallbackDispatcher& operator=(const HidlCallbackDispatcher&) = delete;
+    void dispatch(HidlCallbackType type);
+
+    Lane mLanes[HIDL_CB_TYPE_COUNT];
+    loc_util::MsgTask mMsgTask;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace gnss
+}  // namespace hardware
+}  // namespace android
+#endif // HIDL_CALLBACK_DISPATCHER_H
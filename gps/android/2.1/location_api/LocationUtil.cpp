@@ -45,43 +45,78 @@ using ::android::hardware::gnss::V2_0::GnssConstellationType;
 using ::android::hardware::gnss::V1_0::GnssLocationFlags;
 using ::android::hardware::gnss::measurement_corrections::V1_0::GnssSingleSatCorrectionFlags;
 
-void convertGnssLocation(Location& in, V1_0::GnssLocation& out)
+// A Location field that maps 1:1 onto a V1_0::GnssLocation field, with the
+// flag bit marking it valid on either side. Both directions of
+// convertGnssLocation() run off the same tables, one per field type.
+template <typename T>
+struct GnssLocationFieldMap {
+    LocationFlagsMask locationFlag;
+    uint16_t gnssLocationFlag;
+    T Location::* locationField;
+    T V1_0::GnssLocation::* gnssLocationField;
+};
+
+#define GNSS_LOCATION_FLAG(flag) static_cast<uint16_t>(GnssLocationFlags::flag)
+
+static constexpr GnssLocationFieldMap<double> sGnssLocationDoubleFields[] = {
+    { LOCATION_HAS_LAT_LONG_BIT, GNSS_LOCATION_FLAG(HAS_LAT_LONG),
+      &Location::latitude, &V1_0::GnssLocation::latitudeDegrees },
+    { LOCATION_HAS_LAT_LONG_BIT, GNSS_LOCATION_FLAG(HAS_LAT_LONG),
+      &Location::longitude, &V1_0::GnssLocation::longitudeDegrees },
+    { LOCATION_HAS_ALTITUDE_BIT, GNSS_LOCATION_FLAG(HAS_ALTITUDE),
+      &Location::altitude, &V1_0::GnssLocation::altitudeMeters },
+};
+
+static constexpr GnssLocationFieldMap<float> sGnssLocationFloatFields[] = {
+    { LOCATION_HAS_SPEED_BIT, GNSS_LOCATION_FLAG(HAS_SPEED),
+      &Location::speed, &V1_0::GnssLocation::speedMetersPerSec },
+    { LOCATION_HAS_BEARING_BIT, GNSS_LOCATION_FLAG(HAS_BEARING),
+      &Location::bearing, &V1_0::GnssLocation::bearingDegrees },
+    { LOCATION_HAS_ACCURACY_BIT, GNSS_LOCATION_FLAG(HAS_HORIZONTAL_ACCURACY),
+      &Location::accuracy, &V1_0::GnssLocation::horizontalAccuracyMeters },
+    { LOCATION_HAS_VERTICAL_ACCURACY_BIT, GNSS_LOCATION_FLAG(HAS_VERTICAL_ACCURACY),
+      &Location::verticalAccuracy, &V1_0::GnssLocation::verticalAccuracyMeters },
+    { LOCATION_HAS_SPEED_ACCURACY_BIT, GNSS_LOCATION_FLAG(HAS_SPEED_ACCURACY),
+      &Location::speedAccuracy, &V1_0::GnssLocation::speedAccuracyMetersPerSecond },
+    { LOCATION_HAS_BEARING_ACCURACY_BIT, GNSS_LOCATION_FLAG(HAS_BEARING_ACCURACY),
+      &Location::bearingAccuracy, &V1_0::GnssLocation::bearingAccuracyDegrees },
+};
+
+#undef GNSS_LOCATION_FLAG
+
+// The tables are small and known at compile time, so these loops unroll
+// into straight line selects instead of a branch per field.
+template <typename T, size_t N>
+static inline uint16_t toGnssLocationFields(const Location& in, V1_0::GnssLocation& out,
+        const GnssLocationFieldMap<T> (&fields)[N])
 {
-    memset(&out, 0, sizeof(V1_0::GnssLocation));
-    if (in.flags & LOCATION_HAS_LAT_LONG_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_LAT_LONG;
-        out.latitudeDegrees = in.latitude;
-        out.longitudeDegrees = in.longitude;
-    }
-    if (in.flags & LOCATION_HAS_ALTITUDE_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_ALTITUDE;
-        out.altitudeMeters = in.altitude;
-    }
-    if (in.flags & LOCATION_HAS_SPEED_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_SPEED;
-        out.speedMetersPerSec = in.speed;
-    }
-    if (in.flags & LOCATION_HAS_BEARING_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_BEARING;
-        out.bearingDegrees = in.bearing;
+    uint16_t flags = 0;
+    for (size_t i = 0; i < N; i++) {
+        bool valid = (0 != (in.flags & fields[i].locationFlag));
+        flags |= valid ? fields[i].gnssLocationFlag : 0;
+        out.*(fields[i].gnssLocationField) = valid ? in.*(fields[i].locationField) : T(0);
     }
-    if (in.flags & LOCATION_HAS_ACCURACY_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_HORIZONTAL_ACCURACY;
-        out.horizontalAccuracyMeters = in.accuracy;
-    }
-    if (in.flags & LOCATION_HAS_VERTICAL_ACCURACY_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_VERTICAL_ACCURACY;
-        out.verticalAccuracyMeters = in.verticalAccuracy;
-    }
-    if (in.flags & LOCATION_HAS_SPEED_ACCURACY_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_SPEED_ACCURACY;
-        out.speedAccuracyMetersPerSecond = in.speedAccuracy;
-    }
-    if (in.flags & LOCATION_HAS_BEARING_ACCURACY_BIT) {
-        out.gnssLocationFlags |= GnssLocationFlags::HAS_BEARING_ACCURACY;
-        out.bearingAccuracyDegrees = in.bearingAccuracy;
+    return flags;
+}
+
+template <typename T, size_t N>
+static inline LocationFlagsMask fromGnssLocationFields(const V1_0::GnssLocation& in,
+        Location& out, const GnssLocationFieldMap<T> (&fields)[N])
+{
+    LocationFlagsMask flags = 0;
+    for (size_t i = 0; i < N; i++) {
+        bool valid = (0 != (in.gnssLocationFlags & fields[i].gnssLocationFlag));
+        flags |= valid ? fields[i].locationFlag : 0;
+        out.*(fields[i].locationField) = valid ? in.*(fields[i].gnssLocationField) : T(0);
     }
+    return flags;
+}
 
+void convertGnssLocation(Location& in, V1_0::GnssLocation& out)
+{
+    memset(&out, 0, sizeof(V1_0::GnssLocation));
+    out.gnssLocationFlags = toGnssLocationFields(in, out, sGnssLocationDoubleFields) |
+            toGnssLocationFields(in, out, sGnssLocationFloatFields);
     out.timestamp = static_cast<V1_0::GnssUtcTime>(in.timestamp);
 }
 
@@ -91,9 +126,9 @@ void convertGnssLocation(Location& in, V2_0::GnssLocation& out)
     convertGnssLocation(in, out.v1_0);
 
     if (in.flags & LOCATION_HAS_ELAPSED_REAL_TIME) {
-        out.elapsedRealtime.flags |= ElapsedRealtimeFlags::HAS_TIMESTAMP_NS;
+        out.elapsedRealtime.flags = ElapsedRealtimeFlags::HAS_TIMESTAMP_NS |
+                ElapsedRealtimeFlags::HAS_TIME_UNCERTAINTY_NS;
         out.elapsedRealtime.timestampNs = in.elapsedRealTime;
-        out.elapsedRealtime.flags |= ElapsedRealtimeFlags::HAS_TIME_UNCERTAINTY_NS;
         out.elapsedRealtime.timeUncertaintyNs = in.elapsedRealTimeUnc;
         LOC_LOGd("out.elapsedRealtime.timestampNs=%" PRIi64 ""
                  " out.elapsedRealtime.timeUncertaintyNs=%" PRIi64 ""
@@ -106,40 +141,8 @@ void convertGnssLocation(Location& in, V2_0::GnssLocation& out)
 void convertGnssLocation(const V1_0::GnssLocation& in, Location& out)
 {
     memset(&out, 0, sizeof(out));
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_LAT_LONG) {
-        out.flags |= LOCATION_HAS_LAT_LONG_BIT;
-        out.latitude = in.latitudeDegrees;
-        out.longitude = in.longitudeDegrees;
-    }
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_ALTITUDE) {
-        out.flags |= LOCATION_HAS_ALTITUDE_BIT;
-        out.altitude = in.altitudeMeters;
-    }
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_SPEED) {
-        out.flags |= LOCATION_HAS_SPEED_BIT;
-        out.speed = in.speedMetersPerSec;
-    }
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_BEARING) {
-        out.flags |= LOCATION_HAS_BEARING_BIT;
-        out.bearing = in.bearingDegrees;
-    }
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_HORIZONTAL_ACCURACY) {
-        out.flags |= LOCATION_HAS_ACCURACY_BIT;
-        out.accuracy = in.horizontalAccuracyMeters;
-    }
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_VERTICAL_ACCURACY) {
-        out.flags |= LOCATION_HAS_VERTICAL_ACCURACY_BIT;
-        out.verticalAccuracy = in.verticalAccuracyMeters;
-    }
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_SPEED_ACCURACY) {
-        out.flags |= LOCATION_HAS_SPEED_ACCURACY_BIT;
-        out.speedAccuracy = in.speedAccuracyMetersPerSecond;
-    }
-    if (in.gnssLocationFlags & GnssLocationFlags::HAS_BEARING_ACCURACY) {
-        out.flags |= LOCATION_HAS_BEARING_ACCURACY_BIT;
-        out.bearingAccuracy = in.bearingAccuracyDegrees;
-    }
-
+    out.flags = fromGnssLocationFields(in, out, sGnssLocationDoubleFields) |
+            fromGnssLocationFields(in, out, sGnssLocationFloatFields);
     out.timestamp = static_cast<uint64_t>(in.timestamp);
 }
 
@@ -149,131 +152,83 @@ void convertGnssLocation(const V2_0::GnssLocation& in, Location& out)
     convertGnssLocation(in.v1_0, out);
 }
 
+// HIDL constellation of each GnssSvType, indexed by the GnssSvType value
+static constexpr V1_0::GnssConstellationType sConstellationTypes_1_0[] = {
+    V1_0::GnssConstellationType::UNKNOWN,  // GNSS_SV_TYPE_UNKNOWN
+    V1_0::GnssConstellationType::GPS,      // GNSS_SV_TYPE_GPS
+    V1_0::GnssConstellationType::SBAS,     // GNSS_SV_TYPE_SBAS
+    V1_0::GnssConstellationType::GLONASS,  // GNSS_SV_TYPE_GLONASS
+    V1_0::GnssConstellationType::QZSS,     // GNSS_SV_TYPE_QZSS
+    V1_0::GnssConstellationType::BEIDOU,   // GNSS_SV_TYPE_BEIDOU
+    V1_0::GnssConstellationType::GALILEO,  // GNSS_SV_TYPE_GALILEO
+    V1_0::GnssConstellationType::UNKNOWN,  // GNSS_SV_TYPE_NAVIC, not in 1.0
+};
+
+static constexpr V2_0::GnssConstellationType sConstellationTypes_2_0[] = {
+    V2_0::GnssConstellationType::UNKNOWN,  // GNSS_SV_TYPE_UNKNOWN
+    V2_0::GnssConstellationType::GPS,      // GNSS_SV_TYPE_GPS
+    V2_0::GnssConstellationType::SBAS,     // GNSS_SV_TYPE_SBAS
+    V2_0::GnssConstellationType::GLONASS,  // GNSS_SV_TYPE_GLONASS
+    V2_0::GnssConstellationType::QZSS,     // GNSS_SV_TYPE_QZSS
+    V2_0::GnssConstellationType::BEIDOU,   // GNSS_SV_TYPE_BEIDOU
+    V2_0::GnssConstellationType::GALILEO,  // GNSS_SV_TYPE_GALILEO
+    V2_0::GnssConstellationType::IRNSS,    // GNSS_SV_TYPE_NAVIC
+};
+
+static_assert(sizeof(sConstellationTypes_1_0) / sizeof(sConstellationTypes_1_0[0]) ==
+              GNSS_SV_TYPE_NAVIC + 1, "sConstellationTypes_1_0 misses a GnssSvType");
+static_assert(sizeof(sConstellationTypes_2_0) / sizeof(sConstellationTypes_2_0[0]) ==
+              GNSS_SV_TYPE_NAVIC + 1, "sConstellationTypes_2_0 misses a GnssSvType");
+
 void convertGnssConstellationType(GnssSvType& in, V1_0::GnssConstellationType& out)
 {
-    switch(in) {
-        case GNSS_SV_TYPE_GPS:
-            out = V1_0::GnssConstellationType::GPS;
-            break;
-        case GNSS_SV_TYPE_SBAS:
-            out = V1_0::GnssConstellationType::SBAS;
-            break;
-        case GNSS_SV_TYPE_GLONASS:
-            out = V1_0::GnssConstellationType::GLONASS;
-            break;
-        case GNSS_SV_TYPE_QZSS:
-            out = V1_0::GnssConstellationType::QZSS;
-            break;
-        case GNSS_SV_TYPE_BEIDOU:
-            out = V1_0::GnssConstellationType::BEIDOU;
-            break;
-        case GNSS_SV_TYPE_GALILEO:
-            out = V1_0::GnssConstellationType::GALILEO;
-            break;
-        case GNSS_SV_TYPE_UNKNOWN:
-        default:
-            out = V1_0::GnssConstellationType::UNKNOWN;
-            break;
-    }
+    uint32_t type = static_cast<uint32_t>(in);
+    out = (type <= GNSS_SV_TYPE_NAVIC) ?
+            sConstellationTypes_1_0[type] : V1_0::GnssConstellationType::UNKNOWN;
 }
 
 void convertGnssConstellationType(GnssSvType& in, V2_0::GnssConstellationType& out)
 {
-    switch(in) {
-        case GNSS_SV_TYPE_GPS:
-            out = V2_0::GnssConstellationType::GPS;
-            break;
-        case GNSS_SV_TYPE_SBAS:
-            out = V2_0::GnssConstellationType::SBAS;
-            break;
-        case GNSS_SV_TYPE_GLONASS:
-            out = V2_0::GnssConstellationType::GLONASS;
-            break;
-        case GNSS_SV_TYPE_QZSS:
-            out = V2_0::GnssConstellationType::QZSS;
-            break;
-        case GNSS_SV_TYPE_BEIDOU:
-            out = V2_0::GnssConstellationType::BEIDOU;
-            break;
-        case GNSS_SV_TYPE_GALILEO:
-            out = V2_0::GnssConstellationType::GALILEO;
-            break;
-        case GNSS_SV_TYPE_NAVIC:
-            out = V2_0::GnssConstellationType::IRNSS;
-            break;
-        case GNSS_SV_TYPE_UNKNOWN:
-        default:
-            out = V2_0::GnssConstellationType::UNKNOWN;
-            break;
+    uint32_t type = static_cast<uint32_t>(in);
+    out = (type <= GNSS_SV_TYPE_NAVIC) ?
+            sConstellationTypes_2_0[type] : V2_0::GnssConstellationType::UNKNOWN;
+}
+
+// What to take off an SV ID of each GnssSvType for the svid the framework
+// expects: the first PRN of the constellation minus one, or 0 for those
+// reported as they are. Indexed by the GnssSvType value.
+static constexpr int16_t sSvIdOffsets[] = {
+    0,                      // GNSS_SV_TYPE_UNKNOWN
+    0,                      // GNSS_SV_TYPE_GPS
+    0,                      // GNSS_SV_TYPE_SBAS
+    GLO_SV_PRN_MIN - 1,     // GNSS_SV_TYPE_GLONASS, when the slot is known
+    0,                      // GNSS_SV_TYPE_QZSS
+    BDS_SV_PRN_MIN - 1,     // GNSS_SV_TYPE_BEIDOU
+    GAL_SV_PRN_MIN - 1,     // GNSS_SV_TYPE_GALILEO
+    NAVIC_SV_PRN_MIN - 1,   // GNSS_SV_TYPE_NAVIC
+};
+
+static_assert(sizeof(sSvIdOffsets) / sizeof(sSvIdOffsets[0]) == GNSS_SV_TYPE_NAVIC + 1,
+              "sSvIdOffsets misses a GnssSvType");
+
+static inline int16_t toGnssSvid(GnssSvType svType, uint16_t svId, int32_t gloFrequency)
+{
+    uint32_t type = static_cast<uint32_t>(svType);
+    if (GNSS_SV_TYPE_GLONASS == svType && isGloSlotUnknown(svId)) {
+        // OSN is not known, report FCN
+        return gloFrequency + 92;
     }
+    return svId - ((type <= GNSS_SV_TYPE_NAVIC) ? sSvIdOffsets[type] : 0);
 }
 
 void convertGnssSvid(GnssSv& in, int16_t& out)
 {
-    switch (in.type) {
-        case GNSS_SV_TYPE_GPS:
-            out = in.svId;
-            break;
-        case GNSS_SV_TYPE_SBAS:
-            out = in.svId;
-            break;
-        case GNSS_SV_TYPE_GLONASS:
-            if (!isGloSlotUnknown(in.svId)) { // OSN is known
-                out = in.svId - GLO_SV_PRN_MIN + 1;
-            } else { // OSN is not known, report FCN
-                out = in.gloFrequency + 92;
-            }
-            break;
-        case GNSS_SV_TYPE_QZSS:
-            out = in.svId;
-            break;
-        case GNSS_SV_TYPE_BEIDOU:
-            out = in.svId - BDS_SV_PRN_MIN + 1;
-            break;
-        case GNSS_SV_TYPE_GALILEO:
-            out = in.svId - GAL_SV_PRN_MIN + 1;
-            break;
-        case GNSS_SV_TYPE_NAVIC:
-            out = in.svId - NAVIC_SV_PRN_MIN + 1;
-            break;
-        default:
-            out = in.svId;
-            break;
-    }
+    out = toGnssSvid(in.type, in.svId, in.gloFrequency);
 }
 
 void convertGnssSvid(GnssMeasurementsData& in, int16_t& out)
 {
-    switch (in.svType) {
-        case GNSS_SV_TYPE_GPS:
-            out = in.svId;
-            break;
-        case GNSS_SV_TYPE_SBAS:
-            out = in.svId;
-            break;
-        case GNSS_SV_TYPE_GLONASS:
-            if (!isGloSlotUnknown(in.svId)) { // OSN is known
-                out = in.svId - GLO_SV_PRN_MIN + 1;
-            } else { // OSN is not known, report FCN
-                out = in.gloFrequency + 92;
-            }
-            break;
-        case GNSS_SV_TYPE_QZSS:
-            out = in.svId;
-            break;
-        case GNSS_SV_TYPE_BEIDOU:
-            out = in.svId - BDS_SV_PRN_MIN + 1;
-            break;
-        case GNSS_SV_TYPE_GALILEO:
-            out = in.svId - GAL_SV_PRN_MIN + 1;
-            break;
-        case GNSS_SV_TYPE_NAVIC:
-            out = in.svId - NAVIC_SV_PRN_MIN + 1;
-            break;
-        default:
-            out = in.svId;
-            break;
-    }
+    out = toGnssSvid(in.svType, in.svId, in.gloFrequency);
 }
 
 void convertGnssEphemerisType(GnssEphemerisType& in, GnssDebug::SatelliteEphemerisType& out)
@@ -382,7 +337,8 @@ void convertSingleSatCorrections(const SingleSatCorrection& in, GnssSingleSatCor
 void convertMeasurementCorrections(const MeasurementCorrectionsV1_0& in,
                                    GnssMeasurementCorrections& out)
 {
-    memset(&out, 0, sizeof(GnssMeasurementCorrections));
+    // not memset, out owns the satCorrections vector
+    out = {};
     out.latitudeDegrees = in.latitudeDegrees;
     out.longitudeDegrees = in.longitudeDegrees;
     out.altitudeMeters = in.altitudeMeters;
@@ -390,11 +346,10 @@ void convertMeasurementCorrections(const MeasurementCorrectionsV1_0& in,
     out.verticalPositionUncertaintyMeters = in.verticalPositionUncertaintyMeters;
     out.toaGpsNanosecondsOfWeek = in.toaGpsNanosecondsOfWeek;
 
-    for (int i = 0; i < in.satCorrections.size(); i++) {
-        GnssSingleSatCorrection gnssSingleSatCorrection = {};
-
-        convertSingleSatCorrections(in.satCorrections[i], gnssSingleSatCorrection);
-        out.satCorrections.push_back(gnssSingleSatCorrection);
+    // converted in place, one allocation for the whole set
+    out.satCorrections.resize(in.satCorrections.size());
+    for (size_t i = 0; i < in.satCorrections.size(); i++) {
+        convertSingleSatCorrections(in.satCorrections[i], out.satCorrections[i]);
     }
 }
 
@@ -34,6 +34,8 @@
 #include <android/hardware/gnss/measurement_corrections/1.0/IMeasurementCorrections.h>
 #include <LocationAPI.h>
 #include <GnssDebug.h>
+#include <LocMemStats.h>
+#include <vector>
 
 namespace android {
 namespace hardware {
@@ -45,6 +47,10 @@ using MeasurementCorrectionsV1_0 =
         ::android::hardware::gnss::measurement_corrections::V1_0::MeasurementCorrections;
 using ::android::hardware::gnss::measurement_corrections::V1_0::SingleSatCorrection;
 
+// the conversion buffers the API clients keep, accounted as LOC_MEM_HIDL
+template <typename T>
+using HidlScratchVector = std::vector<T, loc_util::LocMemAllocator<T, loc_util::LOC_MEM_HIDL>>;
+
 void convertGnssLocation(Location& in, V1_0::GnssLocation& out);
 void convertGnssLocation(Location& in, V2_0::GnssLocation& out);
 void convertGnssLocation(const V1_0::GnssLocation& in, Location& out);
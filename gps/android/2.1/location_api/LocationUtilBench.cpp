@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// loc_location_util_bench - runs a synthesized stream of fixes and SV
+// reports through the LocationUtil conversions a tracking session makes
+// per epoch, and reports the cost per fix and per SV.
+//
+// usage: loc_location_util_bench [-n iterations] [-s svs per fix]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <gps_extended_c.h>
+#include <LocationUtil.h>
+
+using namespace android::hardware::gnss;
+using namespace android::hardware::gnss::V2_1::implementation;
+
+#define BENCH_FIXES 1024
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void synthesizeFixes(std::vector<Location>& fixes) {
+    fixes.resize(BENCH_FIXES);
+    for (size_t i = 0; i < fixes.size(); i++) {
+        Location& fix = fixes[i];
+        memset(&fix, 0, sizeof(fix));
+        fix.size = sizeof(fix);
+        // most fixes carry everything, every fourth one drops the optional fields
+        fix.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ACCURACY_BIT |
+                LOCATION_HAS_ELAPSED_REAL_TIME;
+        if (0 != (i % 4)) {
+            fix.flags |= LOCATION_HAS_ALTITUDE_BIT | LOCATION_HAS_SPEED_BIT |
+                    LOCATION_HAS_BEARING_BIT | LOCATION_HAS_VERTICAL_ACCURACY_BIT |
+                    LOCATION_HAS_SPEED_ACCURACY_BIT | LOCATION_HAS_BEARING_ACCURACY_BIT;
+        }
+        fix.timestamp = 1600000000000ULL + i * 1000;
+        fix.latitude = 37.4 + i * 1e-6;
+        fix.longitude = -122.1 - i * 1e-6;
+        fix.altitude = 12.5;
+        fix.speed = 1.5f;
+        fix.bearing = (float)(i % 360);
+        fix.accuracy = 3.0f;
+        fix.verticalAccuracy = 5.0f;
+        fix.speedAccuracy = 0.5f;
+        fix.bearingAccuracy = 10.0f;
+        fix.elapsedRealTime = (int64_t)i * 1000000000LL;
+        fix.elapsedRealTimeUnc = 1000000;
+    }
+}
+
+static void synthesizeSvs(std::vector<GnssSv>& svs, int count) {
+    static const struct {
+        GnssSvType type;
+        uint16_t firstSvId;
+    } sConstellations[] = {
+        { GNSS_SV_TYPE_GPS, 1 },
+        { GNSS_SV_TYPE_GLONASS, GLO_SV_PRN_MIN },
+        { GNSS_SV_TYPE_BEIDOU, BDS_SV_PRN_MIN },
+        { GNSS_SV_TYPE_GALILEO, GAL_SV_PRN_MIN },
+        { GNSS_SV_TYPE_QZSS, 193 },
+        { GNSS_SV_TYPE_SBAS, 120 },
+        { GNSS_SV_TYPE_NAVIC, NAVIC_SV_PRN_MIN },
+    };
+    size_t constellations = sizeof(sConstellations) / sizeof(sConstellations[0]);
+    svs.resize(count);
+    for (int i = 0; i < count; i++) {
+        GnssSv& sv = svs[i];
+        memset(&sv, 0, sizeof(sv));
+        sv.size = sizeof(sv);
+        sv.type = sConstellations[i % constellations].type;
+        sv.svId = sConstellations[i % constellations].firstSvId + i / constellations;
+        sv.gloFrequency = i % 14;
+        if (GNSS_SV_TYPE_GLONASS == sv.type && 0 == (i % 3)) {
+            sv.svId = GLO_SV_PRN_SLOT_UNKNOWN;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = 1000;
+    int svsPerFix = 40;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+            svsPerFix = atoi(argv[++i]);
+        } else {
+            iterations = 0;
+            break;
+        }
+    }
+    if (iterations <= 0 || svsPerFix <= 0) {
+        fprintf(stderr, "usage: %s [-n iterations] [-s svs per fix]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Location> fixes;
+    std::vector<GnssSv> svs;
+    synthesizeFixes(fixes);
+    synthesizeSvs(svs, svsPerFix);
+
+    // folds every output into one value so no conversion is optimized out
+    uint64_t checksum = 0;
+    V2_0::GnssLocation gnssLocation;
+    Location location;
+
+    uint64_t start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        for (auto& fix : fixes) {
+            convertGnssLocation(fix, gnssLocation);
+            checksum += gnssLocation.v1_0.gnssLocationFlags;
+        }
+    }
+    uint64_t toHidlNs = nowNs() - start;
+
+    std::vector<V2_0::GnssLocation> gnssLocations(fixes.size());
+    for (size_t i = 0; i < fixes.size(); i++) {
+        convertGnssLocation(fixes[i], gnssLocations[i]);
+    }
+    start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        for (const auto& each : gnssLocations) {
+            convertGnssLocation(each, location);
+            checksum += location.flags;
+        }
+    }
+    uint64_t fromHidlNs = nowNs() - start;
+
+    start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        for (auto& sv : svs) {
+            int16_t svid;
+            V2_0::GnssConstellationType constellation;
+            convertGnssSvid(sv, svid);
+            convertGnssConstellationType(sv.type, constellation);
+            checksum += svid + (uint8_t)constellation;
+        }
+    }
+    uint64_t svNs = nowNs() - start;
+
+    uint64_t conversions = (uint64_t)fixes.size() * iterations;
+    uint64_t svConversions = (uint64_t)svs.size() * iterations;
+    printf("%llu fixes, %llu SVs, checksum %llu\n", (unsigned long long)conversions,
+            (unsigned long long)svConversions, (unsigned long long)checksum);
+    printf("Location -> GnssLocation: %.1f ns/fix\n", (double)toHidlNs / conversions);
+    printf("GnssLocation -> Location: %.1f ns/fix\n", (double)fromHidlNs / conversions);
+    printf("svid + constellation:     %.1f ns/SV, %.1f ns/epoch of %d SVs\n",
+            (double)svNs / svConversions, (double)svNs / iterations, svsPerFix);
+    return 0;
+}
@@ -30,11 +30,14 @@
 #ifndef MEASUREMENT_API_CLINET_H
 #define MEASUREMENT_API_CLINET_H
 
+#include <memory>
 #include <mutex>
+#include <vector>
 #include <android/hardware/gnss/2.1/IGnssMeasurement.h>
 //#include <android/hardware/gnss/1.1/IGnssMeasurementCallback.h>
 #include <android/hardware/gnss/2.1/IGnssMeasurementCallback.h>
 #include <LocationAPIClientBase.h>
+#include "LocationUtil.h"
 #include <hidl/Status.h>
 #include <gps_extended_c.h>
 
@@ -69,9 +72,12 @@ public:
             GnssPowerMode powerMode = GNSS_POWER_MODE_INVALID,
             uint32_t timeBetweenMeasurement = GPS_DEFAULT_FIX_INTERVAL_MS);
     void measurementClose();
+    // measurements come at most every minIntervalMs, unless powerMode is
+    // GNSS_POWER_MODE_M1 (full tracking), which takes every epoch of the engine
     Return<IGnssMeasurement::GnssMeasurementStatus> startTracking(
             GnssPowerMode powerMode = GNSS_POWER_MODE_INVALID,
-            uint32_t timeBetweenMeasurement = GPS_DEFAULT_FIX_INTERVAL_MS);
+            uint32_t timeBetweenMeasurement = GPS_DEFAULT_FIX_INTERVAL_MS,
+            uint32_t minIntervalMs = GPS_DEFAULT_FIX_INTERVAL_MS);
 
     // callbacks we are interested in
     void onGnssMeasurementsCb(GnssMeasurementsNotification gnssMeasurementsNotification) final;
@@ -84,7 +90,24 @@ private:
     sp<V1_1::IGnssMeasurementCallback> mGnssMeasurementCbIface_1_1;
     sp<V2_0::IGnssMeasurementCallback> mGnssMeasurementCbIface_2_0;
     sp<V2_1::IGnssMeasurementCallback> mGnssMeasurementCbIface_2_1;
+    // which of the interfaces above is set, so a report converts for just that
+    enum MeasurementCbVersion {
+        MEASUREMENT_CB_NONE,
+        MEASUREMENT_CB_1_0,
+        MEASUREMENT_CB_1_1,
+        MEASUREMENT_CB_2_0,
+        MEASUREMENT_CB_2_1,
+    } mCbVersion;
     bool mTracking;
+    // Backing storage for the converted measurements; it only grows to the
+    // largest epoch seen, so a report does not allocate a new vector each time.
+    // Shared with the posted callbacks, which may outlive the client.
+    struct MeasurementScratch {
+        HidlScratchVector<V1_1::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_1_1;
+        HidlScratchVector<V2_0::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_2_0;
+        HidlScratchVector<V2_1::IGnssMeasurementCallback::GnssMeasurement> mMeasurements_2_1;
+    };
+    const std::shared_ptr<MeasurementScratch> mScratch = std::make_shared<MeasurementScratch>();
     void clearInterfaces();
 };
 
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_MeasurementUtil"
+
+#include <log_util.h>
+#include <inttypes.h>
+#include <string.h>
+#include <initializer_list>
+
+#include "MeasurementUtil.h"
+
+namespace android {
+namespace hardware {
+namespace gnss {
+namespace V2_1 {
+namespace implementation {
+
+using ::android::hardware::hidl_string;
+
+typedef V1_0::IGnssMeasurementCallback::GnssMeasurementFlags FlagsV1_0;
+typedef V2_1::IGnssMeasurementCallback::GnssMeasurementFlags FlagsV2_1;
+typedef V2_0::IGnssMeasurementCallback::GnssMeasurementState StateV2_0;
+typedef V1_1::IGnssMeasurementCallback::GnssAccumulatedDeltaRangeState AdrStateV1_1;
+typedef V1_0::IGnssMeasurementCallback::GnssMultipathIndicator MultipathIndicator;
+
+// Translates a location API bit mask into its HIDL bits with one table lookup
+// per input byte, where testing every bit would cost a branch per bit of every
+// measurement. The masks converted here all fit in the low 24 bits.
+class MaskRemap {
+public:
+    struct Bit {
+        uint32_t in;
+        uint32_t out;
+    };
+    MaskRemap(std::initializer_list<Bit> bits) {
+        memset(mLut, 0, sizeof(mLut));
+        for (const Bit& bit : bits) {
+            for (uint32_t b = 0; b < MASK_BYTES; b++) {
+                uint32_t inByte = (bit.in >> (b * 8)) & 0xff;
+                for (uint32_t v = 0; 0 != inByte && v < 256; v++) {
+                    if (v & inByte) {
+                        mLut[b][v] |= bit.out;
+                    }
+                }
+            }
+        }
+    }
+    inline uint32_t operator()(uint32_t in) const {
+        return mLut[0][in & 0xff] | mLut[1][(in >> 8) & 0xff] | mLut[2][(in >> 16) & 0xff];
+    }
+private:
+    static const uint32_t MASK_BYTES = 3;
+    uint32_t mLut[MASK_BYTES][256];
+};
+
+#define HIDL_BIT(bit) static_cast<uint32_t>(bit)
+
+static const MaskRemap sMeasurementFlags_1_0 = {
+    { GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT, HIDL_BIT(FlagsV1_0::HAS_SNR) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT,
+            HIDL_BIT(FlagsV1_0::HAS_CARRIER_FREQUENCY) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT, HIDL_BIT(FlagsV1_0::HAS_CARRIER_CYCLES) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT, HIDL_BIT(FlagsV1_0::HAS_CARRIER_PHASE) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT,
+            HIDL_BIT(FlagsV1_0::HAS_CARRIER_PHASE_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT,
+            HIDL_BIT(FlagsV1_0::HAS_AUTOMATIC_GAIN_CONTROL) },
+};
+
+static const MaskRemap sMeasurementFlags_2_1 = {
+    { GNSS_MEASUREMENTS_DATA_SIGNAL_TO_NOISE_RATIO_BIT, HIDL_BIT(FlagsV2_1::HAS_SNR) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT,
+            HIDL_BIT(FlagsV2_1::HAS_CARRIER_FREQUENCY) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_CYCLES_BIT, HIDL_BIT(FlagsV2_1::HAS_CARRIER_CYCLES) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT, HIDL_BIT(FlagsV2_1::HAS_CARRIER_PHASE) },
+    { GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_UNCERTAINTY_BIT,
+            HIDL_BIT(FlagsV2_1::HAS_CARRIER_PHASE_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT,
+            HIDL_BIT(FlagsV2_1::HAS_AUTOMATIC_GAIN_CONTROL) },
+    { GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT, HIDL_BIT(FlagsV2_1::HAS_FULL_ISB) },
+    { GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT,
+            HIDL_BIT(FlagsV2_1::HAS_FULL_ISB_UNCERTAINTY) },
+    { GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT, HIDL_BIT(FlagsV2_1::HAS_SATELLITE_ISB) },
+    { GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT,
+            HIDL_BIT(FlagsV2_1::HAS_SATELLITE_ISB_UNCERTAINTY) },
+};
+
+// V1_0 knows the states up to SBAS_SYNC, V2_0 adds the last three
+#define MEASUREMENT_STATE_BITS_1_0 \
+    { GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT, HIDL_BIT(StateV2_0::STATE_CODE_LOCK) }, \
+    { GNSS_MEASUREMENTS_STATE_BIT_SYNC_BIT, HIDL_BIT(StateV2_0::STATE_BIT_SYNC) }, \
+    { GNSS_MEASUREMENTS_STATE_SUBFRAME_SYNC_BIT, HIDL_BIT(StateV2_0::STATE_SUBFRAME_SYNC) }, \
+    { GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT, HIDL_BIT(StateV2_0::STATE_TOW_DECODED) }, \
+    { GNSS_MEASUREMENTS_STATE_MSEC_AMBIGUOUS_BIT, HIDL_BIT(StateV2_0::STATE_MSEC_AMBIGUOUS) }, \
+    { GNSS_MEASUREMENTS_STATE_SYMBOL_SYNC_BIT, HIDL_BIT(StateV2_0::STATE_SYMBOL_SYNC) }, \
+    { GNSS_MEASUREMENTS_STATE_GLO_STRING_SYNC_BIT, \
+            HIDL_BIT(StateV2_0::STATE_GLO_STRING_SYNC) }, \
+    { GNSS_MEASUREMENTS_STATE_GLO_TOD_DECODED_BIT, \
+            HIDL_BIT(StateV2_0::STATE_GLO_TOD_DECODED) }, \
+    { GNSS_MEASUREMENTS_STATE_BDS_D2_BIT_SYNC_BIT, \
+            HIDL_BIT(StateV2_0::STATE_BDS_D2_BIT_SYNC) }, \
+    { GNSS_MEASUREMENTS_STATE_BDS_D2_SUBFRAME_SYNC_BIT, \
+            HIDL_BIT(StateV2_0::STATE_BDS_D2_SUBFRAME_SYNC) }, \
+    { GNSS_MEASUREMENTS_STATE_GAL_E1BC_CODE_LOCK_BIT, \
+            HIDL_BIT(StateV2_0::STATE_GAL_E1BC_CODE_LOCK) }, \
+    { GNSS_MEASUREMENTS_STATE_GAL_E1C_2ND_CODE_LOCK_BIT, \
+            HIDL_BIT(StateV2_0::STATE_GAL_E1C_2ND_CODE_LOCK) }, \
+    { GNSS_MEASUREMENTS_STATE_GAL_E1B_PAGE_SYNC_BIT, \
+            HIDL_BIT(StateV2_0::STATE_GAL_E1B_PAGE_SYNC) }, \
+    { GNSS_MEASUREMENTS_STATE_SBAS_SYNC_BIT, HIDL_BIT(StateV2_0::STATE_SBAS_SYNC) }
+
+static const MaskRemap sMeasurementState_1_0 = {
+    MEASUREMENT_STATE_BITS_1_0,
+};
+
+static const MaskRemap sMeasurementState_2_0 = {
+    MEASUREMENT_STATE_BITS_1_0,
+    { GNSS_MEASUREMENTS_STATE_TOW_KNOWN_BIT, HIDL_BIT(StateV2_0::STATE_TOW_KNOWN) },
+    { GNSS_MEASUREMENTS_STATE_GLO_TOD_KNOWN_BIT, HIDL_BIT(StateV2_0::STATE_GLO_TOD_KNOWN) },
+    { GNSS_MEASUREMENTS_STATE_2ND_CODE_LOCK_BIT, HIDL_BIT(StateV2_0::STATE_2ND_CODE_LOCK) },
+};
+
+// V1_1 adds HALF_CYCLE_RESOLVED
+#define ADR_STATE_BITS_1_0 \
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT, \
+            HIDL_BIT(AdrStateV1_1::ADR_STATE_VALID) }, \
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_RESET_BIT, \
+            HIDL_BIT(AdrStateV1_1::ADR_STATE_RESET) }, \
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_CYCLE_SLIP_BIT, \
+            HIDL_BIT(AdrStateV1_1::ADR_STATE_CYCLE_SLIP) }
+
+static const MaskRemap sAdrState_1_0 = {
+    ADR_STATE_BITS_1_0,
+};
+
+static const MaskRemap sAdrState_1_1 = {
+    ADR_STATE_BITS_1_0,
+    { GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_HALF_CYCLE_RESOLVED_BIT,
+            HIDL_BIT(AdrStateV1_1::ADR_STATE_HALF_CYCLE_RESOLVED) },
+};
+
+// the multipath indicator is passed through as is
+static_assert(HIDL_BIT(MultipathIndicator::INDICATOR_PRESENT) ==
+        GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_PRESENT, "multipath indicator mismatch");
+static_assert(HIDL_BIT(MultipathIndicator::INDICATIOR_NOT_PRESENT) ==
+        GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_NOT_PRESENT, "multipath indicator mismatch");
+
+// the single letter code types, indexed by GnssMeasurementsCodeType
+static const char* const sCodeTypes[] = {
+    "A", "B", "C", "I", "L", "M", "P", "Q", "S", "W", "X", "Y", "Z", "N"
+};
+
+static void convertGnssMeasurementsCodeType(const GnssMeasurementsCodeType inCodeType,
+        const char* inOtherCodeTypeName, hidl_string& out)
+{
+    if (static_cast<size_t>(inCodeType) < sizeof(sCodeTypes) / sizeof(sCodeTypes[0])) {
+        // the letters are static, so the string does not need its own copy
+        out.setToExternal(sCodeTypes[inCodeType], 1);
+    } else {
+        out = inOtherCodeTypeName;
+    }
+}
+
+static inline void convertGnssMeasurement(GnssMeasurementsData& in,
+        V1_0::IGnssMeasurementCallback::GnssMeasurement& out)
+{
+    // HIDL copies the struct with its padding
+    memset(&out, 0, sizeof(out));
+    out.flags = sMeasurementFlags_1_0(in.flags);
+    convertGnssSvid(in, out.svid);
+    convertGnssConstellationType(in.svType, out.constellation);
+    out.timeOffsetNs = in.timeOffsetNs;
+    out.state = sMeasurementState_1_0(in.stateMask);
+    out.receivedSvTimeInNs = in.receivedSvTimeNs;
+    out.receivedSvTimeUncertaintyInNs = in.receivedSvTimeUncertaintyNs;
+    out.cN0DbHz = in.carrierToNoiseDbHz;
+    out.pseudorangeRateMps = in.pseudorangeRateMps;
+    out.pseudorangeRateUncertaintyMps = in.pseudorangeRateUncertaintyMps;
+    out.accumulatedDeltaRangeState = sAdrState_1_0(in.adrStateMask);
+    out.accumulatedDeltaRangeM = in.adrMeters;
+    out.accumulatedDeltaRangeUncertaintyM = in.adrUncertaintyMeters;
+    out.carrierFrequencyHz = in.carrierFrequencyHz;
+    out.carrierCycles = in.carrierCycles;
+    out.carrierPhase = in.carrierPhase;
+    out.carrierPhaseUncertainty = in.carrierPhaseUncertainty;
+    out.multipathIndicator = static_cast<MultipathIndicator>(
+            in.multipathIndicator & (GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_PRESENT |
+                                     GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_NOT_PRESENT));
+    out.snrDb = in.signalToNoiseRatioDb;
+    out.agcLevelDb = in.agcLevelDb;
+}
+
+static inline void convertGnssMeasurement_2_0(GnssMeasurementsData& in,
+        V2_0::IGnssMeasurementCallback::GnssMeasurement& out)
+{
+    convertGnssMeasurement(in, out.v1_1.v1_0);
+    out.v1_1.accumulatedDeltaRangeState = sAdrState_1_1(in.adrStateMask);
+    convertGnssMeasurementsCodeType(in.codeType, in.otherCodeTypeName, out.codeType);
+    convertGnssConstellationType(in.svType, out.constellation);
+    out.state = sMeasurementState_2_0(in.stateMask);
+}
+
+static void convertGnssClock(GnssMeasurementsClock& in,
+        V1_0::IGnssMeasurementCallback::GnssClock& out)
+{
+    memset(&out, 0, sizeof(out));
+    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_LEAP_SECOND_BIT)
+        out.gnssClockFlags |= V1_0::IGnssMeasurementCallback::GnssClockFlags::HAS_LEAP_SECOND;
+    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_TIME_UNCERTAINTY_BIT)
+        out.gnssClockFlags |=
+                V1_0::IGnssMeasurementCallback::GnssClockFlags::HAS_TIME_UNCERTAINTY;
+    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT)
+        out.gnssClockFlags |= V1_0::IGnssMeasurementCallback::GnssClockFlags::HAS_FULL_BIAS;
+    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT)
+        out.gnssClockFlags |= V1_0::IGnssMeasurementCallback::GnssClockFlags::HAS_BIAS;
+    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_UNCERTAINTY_BIT)
+        out.gnssClockFlags |=
+                V1_0::IGnssMeasurementCallback::GnssClockFlags::HAS_BIAS_UNCERTAINTY;
+    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_BIT)
+        out.gnssClockFlags |= V1_0::IGnssMeasurementCallback::GnssClockFlags::HAS_DRIFT;
+    if (in.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_DRIFT_UNCERTAINTY_BIT)
+        out.gnssClockFlags |=
+                V1_0::IGnssMeasurementCallback::GnssClockFlags::HAS_DRIFT_UNCERTAINTY;
+    out.leapSecond = in.leapSecond;
+    out.timeNs = in.timeNs;
+    out.timeUncertaintyNs = in.timeUncertaintyNs;
+    out.fullBiasNs = in.fullBiasNs;
+    out.biasNs = in.biasNs;
+    out.biasUncertaintyNs = in.biasUncertaintyNs;
+    out.driftNsps = in.driftNsps;
+    out.driftUncertaintyNsps = in.driftUncertaintyNsps;
+    out.hwClockDiscontinuityCount = in.hwClockDiscontinuityCount;
+}
+
+static void convertGnssClock_2_1(GnssMeasurementsClock& in,
+        V2_1::IGnssMeasurementCallback::GnssClock& out)
+{
+    memset(&out, 0, sizeof(out));
+    convertGnssClock(in, out.v1_0);
+    convertGnssConstellationType(in.referenceSignalTypeForIsb.svType,
+            out.referenceSignalTypeForIsb.constellation);
+    out.referenceSignalTypeForIsb.carrierFrequencyHz =
+            in.referenceSignalTypeForIsb.carrierFrequencyHz;
+    convertGnssMeasurementsCodeType(in.referenceSignalTypeForIsb.codeType,
+            in.referenceSignalTypeForIsb.otherCodeTypeName,
+            out.referenceSignalTypeForIsb.codeType);
+}
+
+static void convertElapsedRealtimeNanos(GnssMeasurementsNotification& in,
+        V2_0::ElapsedRealtime& elapsedRealtime)
+{
+    if (in.clock.flags & GNSS_MEASUREMENTS_CLOCK_FLAGS_ELAPSED_REAL_TIME_BIT) {
+        elapsedRealtime.flags |= V2_0::ElapsedRealtimeFlags::HAS_TIMESTAMP_NS;
+        elapsedRealtime.timestampNs = in.clock.elapsedRealTime;
+        elapsedRealtime.flags |= V2_0::ElapsedRealtimeFlags::HAS_TIME_UNCERTAINTY_NS;
+        elapsedRealtime.timeUncertaintyNs = in.clock.elapsedRealTimeUnc;
+        LOC_LOGd("elapsedRealtime.timestampNs=%" PRIi64 ""
+                 " elapsedRealtime.timeUncertaintyNs=%" PRIi64 " elapsedRealtime.flags=0x%X",
+                 elapsedRealtime.timestampNs,
+                 elapsedRealtime.timeUncertaintyNs, elapsedRealtime.flags);
+    }
+}
+
+void convertGnssData(GnssMeasurementsNotification& in,
+        V1_0::IGnssMeasurementCallback::GnssData& out)
+{
+    memset(&out, 0, sizeof(out));
+    out.measurementCount = in.count;
+    if (out.measurementCount > static_cast<uint32_t>(V1_0::GnssMax::SVS_COUNT)) {
+        LOC_LOGW("%s]: Too many measurement %u. Clamps to %d.",
+                __FUNCTION__,  out.measurementCount, V1_0::GnssMax::SVS_COUNT);
+        out.measurementCount = static_cast<uint32_t>(V1_0::GnssMax::SVS_COUNT);
+    }
+    for (uint32_t i = 0; i < out.measurementCount; i++) {
+        convertGnssMeasurement(in.measurements[i], out.measurements[i]);
+    }
+    convertGnssClock(in.clock, out.clock);
+}
+
+void convertGnssData_1_1(GnssMeasurementsNotification& in,
+        V1_1::IGnssMeasurementCallback::GnssData& out,
+        HidlScratchVector<V1_1::IGnssMeasurementCallback::GnssMeasurement>& measurements)
+{
+    memset(&out, 0, sizeof(out));
+    measurements.resize(in.count);
+    out.measurements.setToExternal(measurements.data(), measurements.size());
+    V1_1::IGnssMeasurementCallback::GnssMeasurement* dst = measurements.data();
+    for (uint32_t i = 0; i < in.count; i++) {
+        convertGnssMeasurement(in.measurements[i], dst[i].v1_0);
+        dst[i].accumulatedDeltaRangeState = sAdrState_1_1(in.measurements[i].adrStateMask);
+    }
+    convertGnssClock(in.clock, out.clock);
+}
+
+void convertGnssData_2_0(GnssMeasurementsNotification& in,
+        V2_0::IGnssMeasurementCallback::GnssData& out,
+        HidlScratchVector<V2_0::IGnssMeasurementCallback::GnssMeasurement>& measurements)
+{
+    memset(&out, 0, sizeof(out));
+    measurements.resize(in.count);
+    out.measurements.setToExternal(measurements.data(), measurements.size());
+    V2_0::IGnssMeasurementCallback::GnssMeasurement* dst = measurements.data();
+    for (uint32_t i = 0; i < in.count; i++) {
+        convertGnssMeasurement_2_0(in.measurements[i], dst[i]);
+    }
+    convertGnssClock(in.clock, out.clock);
+    convertElapsedRealtimeNanos(in, out.elapsedRealtime);
+}
+
+void convertGnssData_2_1(GnssMeasurementsNotification& in,
+        V2_1::IGnssMeasurementCallback::GnssData& out,
+        HidlScratchVector<V2_1::IGnssMeasurementCallback::GnssMeasurement>& measurements)
+{
+    memset(&out, 0, sizeof(out));
+    measurements.resize(in.count);
+    out.measurements.setToExternal(measurements.data(), measurements.size());
+    V2_1::IGnssMeasurementCallback::GnssMeasurement* dst = measurements.data();
+    for (uint32_t i = 0; i < in.count; i++) {
+        GnssMeasurementsData& src = in.measurements[i];
+        uint32_t flags = src.flags;
+        convertGnssMeasurement_2_0(src, dst[i].v2_0);
+        dst[i].flags = sMeasurementFlags_2_1(flags);
+        dst[i].basebandCN0DbHz = src.basebandCarrierToNoiseDbHz;
+        // the biases are only valid with their flag
+        dst[i].fullInterSignalBiasNs = (flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT) ?
+                src.fullInterSignalBiasNs : 0;
+        dst[i].fullInterSignalBiasUncertaintyNs =
+                (flags & GNSS_MEASUREMENTS_DATA_FULL_ISB_UNCERTAINTY_BIT) ?
+                src.fullInterSignalBiasUncertaintyNs : 0;
+        dst[i].satelliteInterSignalBiasNs = (flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT) ?
+                src.satelliteInterSignalBiasNs : 0;
+        dst[i].satelliteInterSignalBiasUncertaintyNs =
+                (flags & GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_UNCERTAINTY_BIT) ?
+                src.satelliteInterSignalBiasUncertaintyNs : 0;
+    }
+    convertGnssClock_2_1(in.clock, out.clock);
+    convertElapsedRealtimeNanos(in, out.elapsedRealtime);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace gnss
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef MEASUREMENT_UTIL_H
+#define MEASUREMENT_UTIL_H
+
+#include <android/hardware/gnss/2.1/IGnssMeasurementCallback.h>
+#include <LocationAPI.h>
+#include "LocationUtil.h"
+
+namespace android {
+namespace hardware {
+namespace gnss {
+namespace V2_1 {
+namespace implementation {
+
+// Each call converts a whole epoch: the measurements are walked once, in the
+// order GnssMeasurementsNotification stores them, and every output field is
+// written once. The V1_1 and later arrays point into the scratch vector, which
+// has to outlive the GnssData handed to the framework.
+void convertGnssData(GnssMeasurementsNotification& in,
+        V1_0::IGnssMeasurementCallback::GnssData& out);
+void convertGnssData_1_1(GnssMeasurementsNotification& in,
+        V1_1::IGnssMeasurementCallback::GnssData& out,
+        HidlScratchVector<V1_1::IGnssMeasurementCallback::GnssMeasurement>& measurements);
+void convertGnssData_2_0(GnssMeasurementsNotification& in,
+        V2_0::IGnssMeasurementCallback::GnssData& out,
+        HidlScratchVector<V2_0::IGnssMeasurementCallback::GnssMeasurement>& measurements);
+void convertGnssData_2_1(GnssMeasurementsNotification& in,
+        V2_1::IGnssMeasurementCallback::GnssData& out,
+        HidlScratchVector<V2_1::IGnssMeasurementCallback::GnssMeasurement>& measurements);
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace gnss
+}  // namespace hardware
+}  // namespace android
+#endif // MEASUREMENT_UTIL_H
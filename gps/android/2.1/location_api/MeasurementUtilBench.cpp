@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// loc_measurement_util_bench - runs synthesized measurement epochs through
+// the MeasurementUtil conversions of every callback version, and reports the
+// cost per epoch and per measurement.
+//
+// usage: loc_measurement_util_bench [-n iterations] [-m measurements per epoch]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gps_extended_c.h>
+#include <MeasurementUtil.h>
+
+using namespace android::hardware::gnss;
+using namespace android::hardware::gnss::V2_1::implementation;
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void synthesizeEpoch(GnssMeasurementsNotification& epoch, uint32_t count) {
+    static const GnssSvType sConstellations[] = {
+        GNSS_SV_TYPE_GPS, GNSS_SV_TYPE_GLONASS, GNSS_SV_TYPE_BEIDOU,
+        GNSS_SV_TYPE_GALILEO, GNSS_SV_TYPE_QZSS, GNSS_SV_TYPE_NAVIC,
+    };
+    uint32_t constellations = sizeof(sConstellations) / sizeof(sConstellations[0]);
+    memset(&epoch, 0, sizeof(epoch));
+    epoch.size = sizeof(epoch);
+    epoch.count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        GnssMeasurementsData& m = epoch.measurements[i];
+        m.size = sizeof(m);
+        m.svType = sConstellations[i % constellations];
+        m.svId = 1 + i / constellations;
+        m.flags = GNSS_MEASUREMENTS_DATA_SV_ID_BIT | GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT |
+                GNSS_MEASUREMENTS_DATA_STATE_BIT | GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT |
+                GNSS_MEASUREMENTS_DATA_CARRIER_FREQUENCY_BIT |
+                GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
+        // every other measurement has carrier phase and the biases of 2.1
+        if (0 == (i % 2)) {
+            m.flags |= GNSS_MEASUREMENTS_DATA_ADR_STATE_BIT | GNSS_MEASUREMENTS_DATA_ADR_BIT |
+                    GNSS_MEASUREMENTS_DATA_CARRIER_PHASE_BIT |
+                    GNSS_MEASUREMENTS_DATA_FULL_ISB_BIT |
+                    GNSS_MEASUREMENTS_DATA_SATELLITE_ISB_BIT;
+            m.adrStateMask = GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT |
+                    GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_HALF_CYCLE_RESOLVED_BIT;
+        }
+        m.stateMask = GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT | GNSS_MEASUREMENTS_STATE_BIT_SYNC_BIT |
+                GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT | GNSS_MEASUREMENTS_STATE_TOW_KNOWN_BIT;
+        m.receivedSvTimeNs = 100000000LL + i;
+        m.receivedSvTimeUncertaintyNs = 10;
+        m.carrierToNoiseDbHz = 20.0 + (i % 25);
+        m.basebandCarrierToNoiseDbHz = 18.0 + (i % 25);
+        m.pseudorangeRateMps = -100.0 + i;
+        m.adrMeters = 1000.0 * i;
+        m.carrierFrequencyHz = 1575420000.0f;
+        m.carrierPhase = 0.25 * (i % 4);
+        m.multipathIndicator = GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_NOT_PRESENT;
+        // an unusual code type now and then takes the copying path
+        m.codeType = (0 == (i % 16)) ? GNSS_MEASUREMENTS_CODE_TYPE_OTHER :
+                (GnssMeasurementsCodeType)(i % (GNSS_MEASUREMENTS_CODE_TYPE_N + 1));
+        snprintf(m.otherCodeTypeName, sizeof(m.otherCodeTypeName), "E5");
+        m.fullInterSignalBiasNs = 1.5;
+        m.satelliteInterSignalBiasNs = 0.5;
+    }
+    epoch.clock.size = sizeof(epoch.clock);
+    epoch.clock.flags = GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT |
+            GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT |
+            GNSS_MEASUREMENTS_CLOCK_FLAGS_ELAPSED_REAL_TIME_BIT;
+    epoch.clock.timeNs = 1000000000LL;
+    epoch.clock.fullBiasNs = -1200000000000000000LL;
+    epoch.clock.elapsedRealTime = 5000000000ULL;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10000;
+    int measurementsPerEpoch = 128;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (0 == strcmp(argv[i], "-m") && i + 1 < argc) {
+            measurementsPerEpoch = atoi(argv[++i]);
+        } else {
+            iterations = 0;
+            break;
+        }
+    }
+    if (iterations <= 0 || measurementsPerEpoch <= 0 ||
+            measurementsPerEpoch > GNSS_MEASUREMENTS_MAX) {
+        fprintf(stderr, "usage: %s [-n iterations] [-m measurements per epoch, at most %d]\n",
+                argv[0], GNSS_MEASUREMENTS_MAX);
+        return 1;
+    }
+
+    // the notification is too large for the stack
+    GnssMeasurementsNotification* epoch = new GnssMeasurementsNotification;
+    synthesizeEpoch(*epoch, measurementsPerEpoch);
+
+    // the scratch vectors are kept across epochs, as the client does
+    HidlScratchVector<V1_1::IGnssMeasurementCallback::GnssMeasurement> measurements_1_1;
+    HidlScratchVector<V2_0::IGnssMeasurementCallback::GnssMeasurement> measurements_2_0;
+    HidlScratchVector<V2_1::IGnssMeasurementCallback::GnssMeasurement> measurements_2_1;
+    // folds every output into one value so no conversion is optimized out
+    uint64_t checksum = 0;
+    uint64_t elapsedNs[4];
+
+    uint64_t start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        V1_0::IGnssMeasurementCallback::GnssData gnssData;
+        convertGnssData(*epoch, gnssData);
+        checksum += gnssData.measurementCount + gnssData.measurements[0].state;
+    }
+    elapsedNs[0] = nowNs() - start;
+
+    start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        V1_1::IGnssMeasurementCallback::GnssData gnssData;
+        convertGnssData_1_1(*epoch, gnssData, measurements_1_1);
+        checksum += gnssData.measurements.size() +
+                gnssData.measurements[0].accumulatedDeltaRangeState;
+    }
+    elapsedNs[1] = nowNs() - start;
+
+    start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        V2_0::IGnssMeasurementCallback::GnssData gnssData;
+        convertGnssData_2_0(*epoch, gnssData, measurements_2_0);
+        checksum += gnssData.measurements.size() + gnssData.measurements[0].state +
+                gnssData.measurements[0].codeType.size();
+    }
+    elapsedNs[2] = nowNs() - start;
+
+    start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        V2_1::IGnssMeasurementCallback::GnssData gnssData;
+        convertGnssData_2_1(*epoch, gnssData, measurements_2_1);
+        checksum += gnssData.measurements.size() + gnssData.measurements[0].flags;
+    }
+    elapsedNs[3] = nowNs() - start;
+
+    // V1_0 carries at most SVS_COUNT measurements
+    uint32_t count_1_0 = (uint32_t)measurementsPerEpoch;
+    if (count_1_0 > static_cast<uint32_t>(V1_0::GnssMax::SVS_COUNT)) {
+        count_1_0 = static_cast<uint32_t>(V1_0::GnssMax::SVS_COUNT);
+    }
+    static const char* const sVersions[] = { "1.0", "1.1", "2.0", "2.1" };
+    printf("%d epochs of %d measurements, checksum %llu\n", iterations, measurementsPerEpoch,
+            (unsigned long long)checksum);
+    for (int v = 0; v < 4; v++) {
+        uint32_t count = (0 == v) ? count_1_0 : (uint32_t)measurementsPerEpoch;
+        printf("GnssData %s: %.1f ns/epoch, %.1f ns/measurement\n", sVersions[v],
+                (double)elapsedNs[v] / iterations,
+                (double)elapsedNs[v] / ((uint64_t)iterations * count));
+    }
+    delete epoch;
+    return 0;
+}
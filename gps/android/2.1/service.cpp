@@ -33,6 +33,8 @@ extern "C" {
 #define DEFAULT_HW_BINDER_MEM_SIZE 65536
 #endif
 
+#define DEFAULT_HAL_BINDER_THREADS 1
+
 using android::hardware::gnss::V2_1::IGnss;
 
 using android::hardware::configureRpcThreadpool;
@@ -55,7 +57,17 @@ int main() {
 #ifdef ARCH_ARM_32
     android::hardware::ProcessState::initWithMmapSize((size_t)(DEFAULT_HW_BINDER_MEM_SIZE));
 #endif
-    configureRpcThreadpool(1, true);
+    uint32_t halBinderThreads = DEFAULT_HAL_BINDER_THREADS;
+    const loc_param_s_type binderConfTable[] =
+    {
+        {"HAL_BINDER_THREADS", &halBinderThreads, NULL, 'n'}
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, binderConfTable);
+    if (halBinderThreads < 1) {
+        halBinderThreads = DEFAULT_HAL_BINDER_THREADS;
+    }
+    ALOGI("HAL_BINDER_THREADS: %u", halBinderThreads);
+    configureRpcThreadpool(halBinderThreads, true);
     status_t status;
 
     status = registerPassthroughServiceImplementation<IGnss>();
@@ -57,6 +57,7 @@ namespace android {
 
 #define GET_HEALTH_SVC_RETRY_CNT 5
 #define GET_HEALTH_SVC_WAIT_TIME_MS 500
+#define NOT_CHARGING_DEBOUNCE_TIME 3s
 
 struct BatteryListenerImpl : public hardware::health::V2_1::IHealthInfoCallback,
                              public hardware::hidl_death_recipient {
@@ -76,94 +77,72 @@ struct BatteryListenerImpl : public hardware::health::V2_1::IHealthInfoCallback,
   private:
     sp<hardware::health::V2_1::IHealth> mHealth;
     status_t init();
+    void run();
     BatteryStatus mStatus;
     cb_fn_t mCb;
     std::mutex mLock;
     std::condition_variable mCond;
     std::unique_ptr<std::thread> mThread;
     bool mDone;
+    // set by serviceDied, the cb thread gets the health service again
+    bool mReconnect;
+    // charging state last given to mCb
+    bool mCharging;
     bool statusToBool(const BatteryStatus& s) const {
         return (s == BatteryStatus::CHARGING) || (s == BatteryStatus::FULL);
     }
 };
 
+// gets the health service and registers with it, called without mLock held
 status_t BatteryListenerImpl::init() {
     int tries = 0;
-
-    if (mHealth != NULL) return INVALID_OPERATION;
+    sp<IHealth> health;
 
     do {
-        mHealth = IHealth::getService();
-        if (mHealth != NULL) break;
+        health = IHealth::getService();
+        if (health != NULL) break;
         usleep(GET_HEALTH_SVC_WAIT_TIME_MS * 1000);
         tries++;
     } while (tries < GET_HEALTH_SVC_RETRY_CNT);
 
-    if (mHealth == NULL) {
+    if (health == NULL) {
         LOC_LOGe("no health service found, retries %d", tries);
         return NO_INIT;
     } else {
         LOC_LOGi("Get health service in %d tries", tries);
     }
-    mStatus = BatteryStatus::UNKNOWN;
-    auto ret = mHealth->getChargeStatus([&](Result r, BatteryStatus status) {
+    BatteryStatus chargeStatus = BatteryStatus::UNKNOWN;
+    auto ret = health->getChargeStatus([&](Result r, BatteryStatus status) {
         if (r != Result::SUCCESS) {
             LOC_LOGe("batterylistener: cannot get battery status");
             return;
         }
-        mStatus = status;
+        chargeStatus = status;
     });
     if (!ret.isOk()) {
         LOC_LOGe("batterylistener: get charge status transaction error");
     }
-    if (mStatus == BatteryStatus::UNKNOWN) {
+    if (chargeStatus == BatteryStatus::UNKNOWN) {
         LOC_LOGw("batterylistener: init: invalid battery status");
     }
-    mDone = false;
-    mThread = std::make_unique<std::thread>([this]() {
-        std::unique_lock<std::mutex> l(mLock);
-        BatteryStatus local_status = mStatus;
-        while (!mDone) {
-            if (local_status == mStatus) {
-                mCond.wait(l);
-                continue;
-            }
-            local_status = mStatus;
-            switch (local_status) {
-                // NOT_CHARGING is a special event that indicates, a battery is connected,
-                // but not charging. This is seen for approx a second
-                // after charger is plugged in. A charging event is eventually received.
-                // We must try to avoid an unnecessary cb to HAL
-                // only to call it again shortly.
-                // An option to deal with this transient event would be to ignore this.
-                // Or process this event with a slight delay (i.e cancel this event
-                // if a different event comes in within a timeout
-                case BatteryStatus::NOT_CHARGING: {
-                    auto mStatusnot_ncharging = [this, local_status]() {
-                        return mStatus != local_status;
-                    };
-                    mCond.wait_for(l, 3s, mStatusnot_ncharging);
-                    if (mStatusnot_ncharging())  // i.e event changed
-                        break;
-                    [[clang::fallthrough]];  // explicit fall-through between switch labels
-                }
-                default:
-                    bool c = statusToBool(local_status);
-                    LOC_LOGi("healthInfo cb thread: cb %s", c ? "CHARGING" : "NOT CHARGING");
-                    l.unlock();
-                    mCb(c);
-                    l.lock();
-                    break;
-            }
+    {
+        std::lock_guard<std::mutex> _l(mLock);
+        if (mDone) {
+            return INVALID_OPERATION;
         }
-    });
-    auto reg = mHealth->registerCallback(this);
+        mHealth = health;
+        if (chargeStatus != BatteryStatus::UNKNOWN) {
+            mStatus = chargeStatus;
+        }
+    }
+
+    auto reg = health->registerCallback(this);
     if (!reg.isOk()) {
         LOC_LOGe("Transaction error in registeringCb to HealthHAL death: %s",
                  reg.description().c_str());
     }
 
-    auto linked = mHealth->linkToDeath(this, 0 /* cookie */);
+    auto linked = health->linkToDeath(this, 0 /* cookie */);
     if (!linked.isOk() || linked == false) {
         LOC_LOGe("Transaction error in linking to HealthHAL death: %s",
                  linked.description().c_str());
@@ -171,21 +150,70 @@ status_t BatteryListenerImpl::init() {
     return NO_ERROR;
 }
 
-BatteryListenerImpl::BatteryListenerImpl(cb_fn_t cb) : mCb(cb) {
+// cb thread: calls mCb only when the charging state changes, and also takes
+// the health service re-registration off the HIDL death notification thread
+void BatteryListenerImpl::run() {
+    std::unique_lock<std::mutex> l(mLock);
+    while (!mDone) {
+        if (mReconnect) {
+            mReconnect = false;
+            l.unlock();
+            init();
+            l.lock();
+            continue;
+        }
+        bool charging = statusToBool(mStatus);
+        if (charging == mCharging) {
+            // battery level ticks and CHARGING <-> FULL end up here
+            mCond.wait(l);
+            continue;
+        }
+        // NOT_CHARGING is a special event that indicates, a battery is connected,
+        // but not charging. This is seen for approx a second
+        // after charger is plugged in. A charging event is eventually received.
+        // Hold it back, so the HAL is not called only to be called again shortly.
+        if (mStatus == BatteryStatus::NOT_CHARGING) {
+            BatteryStatus pending = mStatus;
+            if (mCond.wait_for(l, NOT_CHARGING_DEBOUNCE_TIME, [this, pending]() {
+                    return mDone || mReconnect || mStatus != pending;
+                })) {
+                continue;
+            }
+        }
+        mCharging = charging;
+        LOC_LOGi("healthInfo cb thread: cb %s", charging ? "CHARGING" : "NOT CHARGING");
+        l.unlock();
+        mCb(charging);
+        l.lock();
+    }
+}
+
+BatteryListenerImpl::BatteryListenerImpl(cb_fn_t cb) :
+        mStatus(BatteryStatus::UNKNOWN), mCb(cb), mDone(false), mReconnect(false),
+        mCharging(false) {
     init();
+    {
+        std::lock_guard<std::mutex> _l(mLock);
+        // the initial state is reported by batteryPropertiesListenerInit
+        mCharging = statusToBool(mStatus);
+    }
+    mThread = std::make_unique<std::thread>([this]() { run(); });
 }
 
 BatteryListenerImpl::~BatteryListenerImpl() {
     {
         std::lock_guard<std::mutex> _l(mLock);
-        if (mHealth != NULL) mHealth->unregisterCallback(this);
-        auto r = mHealth->unlinkToDeath(this);
-        if (!r.isOk() || r == false) {
-            LOC_LOGe("Transaction error in unregister to HealthHAL death: %s",
-                     r.description().c_str());
+        if (mHealth != NULL) {
+            mHealth->unregisterCallback(this);
+            auto r = mHealth->unlinkToDeath(this);
+            if (!r.isOk() || r == false) {
+                LOC_LOGe("Transaction error in unregister to HealthHAL death: %s",
+                         r.description().c_str());
+            }
         }
+        mDone = true;
     }
-    mDone = true;
+    mCond.notify_one();
     mThread->join();
 }
 
@@ -198,13 +226,10 @@ void BatteryListenerImpl::serviceDied(uint64_t cookie __unused,
             return;
         }
         LOC_LOGi("health service died, reinit");
-        mDone = true;
+        mHealth = NULL;
+        mReconnect = true;
     }
-    mHealth = NULL;
     mCond.notify_one();
-    mThread->join();
-    std::lock_guard<std::mutex> _l(mLock);
-    init();
 }
 
 // this callback seems to be a SYNC callback and so
@@ -33,6 +33,10 @@
 #include <log_util.h>
 #include <LocContext.h>
 #include <BatchingAdapter.h>
+#include <SystemStatus.h>
+#include <DataItemId.h>
+#include <DataItemConcreteTypesBase.h>
+#include <LocConfWatcher.h>
 
 using namespace loc_core;
 
@@ -40,6 +44,9 @@ BatchingAdapter::BatchingAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
                    false, nullptr, true),
+    mAutoReportBatchingSessions(0),
+    mTripOdometerBase(0),
+    mTripBatchDistance(0),
     mOngoingTripDistance(0),
     mOngoingTripTBFInterval(0),
     mTripWithOngoingTBFDropped(false),
@@ -47,17 +54,74 @@ BatchingAdapter::BatchingAdapter() :
     mBatchingTimeout(0),
     mBatchingAccuracy(1),
     mBatchSize(0),
-    mTripBatchSize(0)
+    mTripBatchSize(0),
+    mLocationBatchPool(LOCATION_BATCH_POOL_SIZE),
+    mApStateObserver(*this),
+    mOpportunisticFlushTimer(*this),
+    mOsObserver(nullptr),
+    mOpportunisticFlushSec(0),
+    mOpportunisticFlushSize(0),
+    mScreenOn(false),
+    mPowerConnected(false),
+    mOpportunisticFlushArmed(false),
+    mFlpConfListener(0)
 {
+    mReportedBatches.store(0, std::memory_order_relaxed);
+    mReportedLocations.store(0, std::memory_order_relaxed);
+    mOpportunisticFlushes.store(0, std::memory_order_relaxed);
     LOC_LOGD("%s]: Constructor", __func__);
     readConfigCommand();
     setConfigCommand();
 
+    mFlpConfListener = LocConfWatcher::getInstance().addListener(LOC_PATH_FLP_CONF,
+            [this] (const char* /*confPath*/, const LocConfNames& changed) {
+        struct MsgFlpConfChange : public LocMsg {
+            BatchingAdapter& mAdapter;
+            const LocConfNames mChanged;
+            inline MsgFlpConfChange(BatchingAdapter& adapter, const LocConfNames& changed) :
+                LocMsg(),
+                mAdapter(adapter),
+                mChanged(changed) {}
+            inline virtual void proc() const {
+                mAdapter.handleFlpConfChange(mChanged);
+            }
+        };
+        sendMsg(new MsgFlpConfChange(*this, changed));
+    });
+
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
     doneInit();
 }
 
+BatchingAdapter::~BatchingAdapter()
+{
+    LocConfWatcher::getInstance().removeListener(mFlpConfListener);
+}
+
+void
+BatchingAdapter::handleFlpConfChange(const LocConfNames& changed)
+{
+    static const char* const batchingParams[] = {
+        "BATCH_SIZE", "OUTDOOR_TRIP_BATCH_SIZE", "BATCH_SESSION_TIMEOUT", "ACCURACY",
+        "BATCH_OPPORTUNISTIC_FLUSH_SEC", "BATCH_OPPORTUNISTIC_FLUSH_SIZE"
+    };
+    bool batchingChanged = false;
+    for (auto param : batchingParams) {
+        batchingChanged = batchingChanged || (changed.count(param) > 0);
+    }
+    if (!batchingChanged) {
+        return;
+    }
+
+    LOC_LOGD("%s]: ", __func__);
+    // re-reads the cached flp.conf; only the sizes need to go to the modem
+    readConfigCommand();
+    if (changed.count("BATCH_SIZE") > 0 || changed.count("OUTDOOR_TRIP_BATCH_SIZE") > 0) {
+        setConfigCommand();
+    }
+}
+
 void
 BatchingAdapter::readConfigCommand()
 {
@@ -73,12 +137,16 @@ BatchingAdapter::readConfigCommand()
             uint32_t batchingAccuracy = 0;
             uint32_t batchSize = 0;
             uint32_t tripBatchSize = 0;
+            uint32_t opportunisticFlushSec = 0;
+            uint32_t opportunisticFlushSize = 0;
             static const loc_param_s_type flp_conf_param_table[] =
             {
                 {"BATCH_SIZE", &batchSize, NULL, 'n'},
                 {"OUTDOOR_TRIP_BATCH_SIZE", &tripBatchSize, NULL, 'n'},
                 {"BATCH_SESSION_TIMEOUT", &batchingTimeout, NULL, 'n'},
                 {"ACCURACY", &batchingAccuracy, NULL, 'n'},
+                {"BATCH_OPPORTUNISTIC_FLUSH_SEC", &opportunisticFlushSec, NULL, 'n'},
+                {"BATCH_OPPORTUNISTIC_FLUSH_SIZE", &opportunisticFlushSize, NULL, 'n'},
             };
             UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
 
@@ -89,6 +157,7 @@ BatchingAdapter::readConfigCommand()
              mAdapter.setTripBatchSize(tripBatchSize);
              mAdapter.setBatchingTimeout(batchingTimeout);
              mAdapter.setBatchingAccuracy(batchingAccuracy);
+             mAdapter.setOpportunisticFlush(opportunisticFlushSec, opportunisticFlushSize);
         }
     };
 
@@ -179,10 +248,7 @@ BatchingAdapter::handleEngineUpEvent()
             mApi.setBatchSize(mAdapter.getBatchSize());
             mApi.setTripBatchSize(mAdapter.getTripBatchSize());
             mAdapter.restartSessions();
-            for (auto msg: mAdapter.mPendingMsgs) {
-                mAdapter.sendMsg(msg);
-            }
-            mAdapter.mPendingMsgs.clear();
+            mAdapter.replayPendingMsgs();
         }
     };
 
@@ -209,31 +275,11 @@ BatchingAdapter::restartSessions()
     }
 
     if (mTripSessions.size() > 0) {
-        // restart outdoor trip batching session if any.
-        mOngoingTripDistance = 0;
-        mOngoingTripTBFInterval = 0;
-
-        // record the min trip distance and min tbf interval of all ongoing sessions
-        for (auto tripSession : mTripSessions) {
-
-            TripSessionStatus &tripSessStatus = tripSession.second;
-
-            if ((0 == mOngoingTripDistance) ||
-                (mOngoingTripDistance >
-                 (tripSessStatus.tripDistance - tripSessStatus.accumulatedDistanceThisTrip))) {
-                mOngoingTripDistance = tripSessStatus.tripDistance -
-                    tripSessStatus.accumulatedDistanceThisTrip;
-            }
-
-            if ((0 == mOngoingTripTBFInterval) ||
-                (mOngoingTripTBFInterval > tripSessStatus.tripTBFInterval)) {
-                mOngoingTripTBFInterval = tripSessStatus.tripTBFInterval;
-            }
-
-            // reset the accumulatedDistanceOngoingBatch for each session
-            tripSessStatus.accumulatedDistanceOngoingBatch = 0;
-
-        }
+        // restart outdoor trip batching session if any, the engine starts from an empty
+        // batch, with the min remaining trip distance and min tbf interval of all sessions
+        rebaseTripOdometer(mTripBatchDistance);
+        mOngoingTripDistance = getTripRemainingDistance(0);
+        mOngoingTripTBFInterval = getTripMinInterval();
 
         mLocApi->startOutdoorTripBatching(mOngoingTripDistance, mOngoingTripTBFInterval,
                 getBatchingTimeout(), new LocApiResponse(*getContext(), [this] (LocationError err) {
@@ -270,7 +316,19 @@ BatchingAdapter::saveBatchingSession(LocationAPI* client, uint32_t sessionId,
         const BatchingOptions& batchingOptions)
 {
     LocationSessionKey key(client, sessionId);
-    mBatchingSessions[key] = batchingOptions;
+    auto it = mBatchingSessions.find(key);
+    if (it != mBatchingSessions.end()) {
+        if (it->second.batchingMode != BATCHING_MODE_NO_AUTO_REPORT) {
+            mAutoReportBatchingSessions--;
+        }
+        it->second = batchingOptions;
+    } else {
+        mBatchingSessions.insert(std::make_pair(key, batchingOptions));
+    }
+    if (batchingOptions.batchingMode != BATCHING_MODE_NO_AUTO_REPORT) {
+        mAutoReportBatchingSessions++;
+    }
+    updateOpportunisticFlush();
 }
 
 void
@@ -279,8 +337,12 @@ BatchingAdapter::eraseBatchingSession(LocationAPI* client, uint32_t sessionId)
     LocationSessionKey key(client, sessionId);
     auto it = mBatchingSessions.find(key);
     if (it != mBatchingSessions.end()) {
+        if (it->second.batchingMode != BATCHING_MODE_NO_AUTO_REPORT) {
+            mAutoReportBatchingSessions--;
+        }
         mBatchingSessions.erase(it);
     }
+    updateOpportunisticFlush();
 }
 
 void
@@ -300,14 +362,7 @@ BatchingAdapter::reportResponse(LocationAPI* client, LocationError err, uint32_t
 uint32_t
 BatchingAdapter::autoReportBatchingSessionsCount()
 {
-    uint32_t count = 0;
-    for (auto batchingSession: mBatchingSessions) {
-        if (batchingSession.second.batchingMode != BATCHING_MODE_NO_AUTO_REPORT) {
-            count++;
-        }
-    }
-    count += mTripSessions.size();
-    return count;
+    return mAutoReportBatchingSessions + mTripSessions.size();
 }
 
 uint32_t
@@ -338,7 +393,7 @@ BatchingAdapter::startBatchingCommand(
             mBatchingOptions(batchOptions) {}
         inline virtual void proc() const {
             if (!mAdapter.isEngineCapabilitiesKnown()) {
-                mAdapter.mPendingMsgs.push_back(new MsgStartBatching(*this));
+                mAdapter.queuePendingMsg(new MsgStartBatching(*this));
                 return;
             }
             LocationError err = LOCATION_ERROR_SUCCESS;
@@ -431,7 +486,7 @@ BatchingAdapter::updateBatchingOptionsCommand(LocationAPI* client, uint32_t id,
             mBatchOptions(batchOptions) {}
         inline virtual void proc() const {
             if (!mAdapter.isEngineCapabilitiesKnown()) {
-                mAdapter.mPendingMsgs.push_back(new MsgUpdateBatching(*this));
+                mAdapter.queuePendingMsg(new MsgUpdateBatching(*this));
                 return;
             }
             LocationError err = LOCATION_ERROR_SUCCESS;
@@ -475,7 +530,7 @@ BatchingAdapter::stopBatchingCommand(LocationAPI* client, uint32_t id)
             mSessionId(sessionId) {}
         inline virtual void proc() const {
             if (!mAdapter.isEngineCapabilitiesKnown()) {
-                mAdapter.mPendingMsgs.push_back(new MsgStopBatching(*this));
+                mAdapter.queuePendingMsg(new MsgStopBatching(*this));
                 return;
             }
             LocationError err = LOCATION_ERROR_SUCCESS;
@@ -558,7 +613,7 @@ BatchingAdapter::getBatchedLocationsCommand(LocationAPI* client, uint32_t id, si
             mCount(count) {}
         inline virtual void proc() const {
             if (!mAdapter.isEngineCapabilitiesKnown()) {
-                mAdapter.mPendingMsgs.push_back(new MsgGetBatchedLocations(*this));
+                mAdapter.queuePendingMsg(new MsgGetBatchedLocations(*this));
                 return;
             }
             LocationError err = LOCATION_ERROR_SUCCESS;
@@ -599,37 +654,24 @@ BatchingAdapter::reportLocationsEvent(const Location* locations, size_t count,
 
     struct MsgReportLocations : public LocMsg {
         BatchingAdapter& mAdapter;
-        Location* mLocations;
-        size_t mCount;
+        LocationBatch mLocations;
         BatchingMode mBatchingMode;
         inline MsgReportLocations(BatchingAdapter& adapter,
-                                  const Location* locations,
-                                  size_t count,
+                                  LocationBatch&& locations,
                                   BatchingMode batchingMode) :
             LocMsg(),
             mAdapter(adapter),
-            mLocations(new Location[count]),
-            mCount(count),
-            mBatchingMode(batchingMode)
-        {
-            if (nullptr == mLocations) {
-                LOC_LOGE("%s]: new failed to allocate mLocations", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
-                mLocations[i] = locations[i];
-            }
-        }
-        inline virtual ~MsgReportLocations() {
-            if (nullptr != mLocations)
-                delete[] mLocations;
-        }
+            mLocations(std::move(locations)),
+            mBatchingMode(batchingMode) {}
         inline virtual void proc() const {
-            mAdapter.reportLocations(mLocations, mCount, mBatchingMode);
+            mAdapter.reportLocations(mLocations->data(), mLocations->size(), mBatchingMode);
         }
     };
 
-    sendMsg(new MsgReportLocations(*this, locations, count, batchingMode));
+    // the engine's array is only good for this call; this is the one copy made of it,
+    // into pooled storage, and every client is then handed that same copy
+    sendMsg(new MsgReportLocations(*this, mLocationBatchPool.acquire(locations, count),
+                                   batchingMode));
 }
 
 void
@@ -637,6 +679,8 @@ BatchingAdapter::reportLocations(Location* locations, size_t count, BatchingMode
 {
     BatchingOptions batchOptions = {sizeof(BatchingOptions), batchingMode};
 
+    mReportedBatches.fetch_add(1, std::memory_order_relaxed);
+    mReportedLocations.fetch_add(count, std::memory_order_relaxed);
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.batchingCb) {
             it->second.batchingCb(count, locations, batchOptions);
@@ -661,22 +705,18 @@ BatchingAdapter::reportCompletedTripsEvent(uint32_t accumulated_distance)
         }
         inline virtual void proc() const {
 
-            // Check if any trips are completed
+            // Check if any trips are completed, those are the ones at the front
+            // of the targets whose odometer reading is reached
             std::list<uint32_t> completedTripsList;
-            completedTripsList.clear();
-
-            for(auto itt = mAdapter.mTripSessions.begin(); itt != mAdapter.mTripSessions.end();)
-            {
-                TripSessionStatus &tripSession = itt->second;
-
-                tripSession.accumulatedDistanceThisTrip =
-                        tripSession.accumulatedDistanceOnTripRestart
-                        + (mAccumulatedDistance - tripSession.accumulatedDistanceOngoingBatch);
-                if (tripSession.tripDistance <= tripSession.accumulatedDistanceThisTrip) {
-                    // trip is completed
-                    completedTripsList.push_back(itt->first);
-                    itt = mAdapter.mTripSessions.erase(itt);
-
+            mAdapter.mTripBatchDistance = mAccumulatedDistance;
+            uint64_t odometer = mAdapter.mTripOdometerBase + mAccumulatedDistance;
+
+            while (!mAdapter.mTripTargets.empty() &&
+                   mAdapter.mTripTargets.begin()->first <= odometer) {
+                uint32_t sessionId = mAdapter.mTripTargets.begin()->second;
+                auto itt = mAdapter.mTripSessions.find(sessionId);
+                if (itt != mAdapter.mTripSessions.end()) {
+                    TripSessionStatus &tripSession = itt->second;
                     if (tripSession.tripTBFInterval == mAdapter.mOngoingTripTBFInterval) {
                         // trip with ongoing TBF interval is completed
                         mAdapter.mTripWithOngoingTBFDropped = true;
@@ -686,9 +726,10 @@ BatchingAdapter::reportCompletedTripsEvent(uint32_t accumulated_distance)
                         // trip with ongoing trip distance is completed
                         mAdapter.mTripWithOngoingTripDistanceDropped = true;
                     }
-                } else {
-                    itt++;
                 }
+                // trip is completed
+                completedTripsList.push_back(sessionId);
+                mAdapter.eraseTripSession(sessionId);
             }
 
             if (completedTripsList.size() > 0) {
@@ -761,8 +802,10 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
         // Assume start will be OK, remove session if not
         saveBatchingSession(client, sessionId, batchingOptions);
 
-        mTripSessions[sessionId] = { 0, 0, 0, batchingOptions.minDistance,
-                batchingOptions.minInterval};
+        // first trip, the odometer starts over
+        mTripOdometerBase = 0;
+        mTripBatchDistance = 0;
+        saveTripSession(sessionId, batchingOptions, 0);
         mLocApi->startOutdoorTripBatching(batchingOptions.minDistance,
                 batchingOptions.minInterval, getBatchingTimeout(), new LocApiResponse(*getContext(),
                 [this, client, sessionId, batchingOptions] (LocationError err) {
@@ -773,7 +816,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                 printTripReport();
             } else {
                 eraseBatchingSession(client, sessionId);
-                mTripSessions.erase(sessionId);
+                eraseTripSession(sessionId);
                 // if we fail to start batching and we have already registered batch full event
                 // we need to undo that since no sessions are now interested in batch full event
                 if (0 == autoReportBatchingSessionsCount()) {
@@ -789,8 +832,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                 new LocApiResponseData<LocApiBatchData>(*getContext(),
                 [this, batchingOptions, sessionId, client]
                 (LocationError err, LocApiBatchData data) {
-            uint32_t accumulatedDistanceOngoingBatch = 0;
-            uint32_t numOfBatchedPositions = 0;
+            uint32_t accumulatedDistanceOngoingBatch = mTripBatchDistance;
             uint32_t ongoingTripDistance = mOngoingTripDistance;
             uint32_t ongoingTripInterval = mOngoingTripTBFInterval;
             bool needsRestart = false;
@@ -800,11 +842,6 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                 ongoingTripInterval = batchingOptions.minInterval;
                 needsRestart = true;
             }
-            accumulatedDistanceOngoingBatch = data.accumulatedDistance;
-            numOfBatchedPositions = data.numOfBatchedPositions;
-            TripSessionStatus newTripSession = { accumulatedDistanceOngoingBatch, 0, 0,
-                                                 batchingOptions.minDistance,
-                                                 batchingOptions.minInterval};
             if (err != LOCATION_ERROR_SUCCESS) {
                 // unable to query accumulated distance, assume remaining distance in
                 // ongoing batch is mongoingTripDistance.
@@ -813,6 +850,9 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                     needsRestart = true;
                 }
             } else {
+                accumulatedDistanceOngoingBatch = data.accumulatedDistance;
+                mTripBatchDistance = accumulatedDistanceOngoingBatch;
+
                 // compute the remaining distance
                 uint32_t ongoing_trip_remaining_distance = ongoingTripDistance -
                         accumulatedDistanceOngoingBatch;
@@ -825,23 +865,19 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                     // needsRestart is anyways true , may be because of lesser TBF of new session.
                     ongoingTripDistance = ongoing_trip_remaining_distance;
                 }
-                mTripSessions[sessionId] = newTripSession;
-                LOC_LOGD("%s] New Trip started ...", __func__);
-                printTripReport();
             }
+            // without the accumulated distance, the last one reported is assumed
+            saveTripSession(sessionId, batchingOptions, accumulatedDistanceOngoingBatch);
+            LOC_LOGD("%s] New Trip started ...", __func__);
+            printTripReport();
 
             if (needsRestart) {
                 mOngoingTripDistance = ongoingTripDistance;
                 mOngoingTripTBFInterval = ongoingTripInterval;
 
-                // reset the accumulatedDistanceOngoingBatch for each session,
-                // and record the total accumulated distance so far for the session.
-                for (auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
-                    TripSessionStatus &tripSessStatus = itt->second;
-                    tripSessStatus.accumulatedDistanceOngoingBatch = 0;
-                    tripSessStatus.accumulatedDistanceOnTripRestart =
-                            tripSessStatus.accumulatedDistanceThisTrip;
-                }
+                // the engine restarts from an empty batch, keep what the ongoing one
+                // accumulated so far in the odometer
+                rebaseTripOdometer(accumulatedDistanceOngoingBatch);
                 mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
                         getBatchingTimeout(), new LocApiResponse(*getContext(),
                         [this, client, sessionId] (LocationError err) {
@@ -888,18 +924,22 @@ BatchingAdapter::stopTripBatchingMultiplexCommon(LocationError err, LocationAPI*
         uint32_t sessionId, bool restartNeeded, const BatchingOptions& batchOptions)
 {
     auto itt = mTripSessions.find(sessionId);
-    TripSessionStatus tripSess = itt->second;
-    if (tripSess.tripTBFInterval == mOngoingTripTBFInterval) {
-        // trip with ongoing trip interval is stopped
-        mTripWithOngoingTBFDropped = true;
-    }
+    if (itt != mTripSessions.end()) {
+        TripSessionStatus& tripSess = itt->second;
+        if (tripSess.tripTBFInterval == mOngoingTripTBFInterval) {
+            // trip with ongoing trip interval is stopped
+            mTripWithOngoingTBFDropped = true;
+        }
 
-    if (tripSess.tripDistance == mOngoingTripDistance) {
-        // trip with ongoing trip distance is stopped
-        mTripWithOngoingTripDistanceDropped = true;
-    }
+        if (tripSess.tripDistance == mOngoingTripDistance) {
+            // trip with ongoing trip distance is stopped
+            mTripWithOngoingTripDistanceDropped = true;
+        }
 
-    mTripSessions.erase(sessionId);
+        eraseTripSession(sessionId);
+    } else {
+        LOC_LOGE("%s]: trip session %u not found", __func__, sessionId);
+    }
 
     if (mTripSessions.size() == 0) {
         mOngoingTripDistance = 0;
@@ -925,10 +965,6 @@ void
 BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t accDist,
         uint32_t numbatchedPos)
 {
-    // does batch need restart with new trip distance / TBF interval
-    uint32_t minRemainingDistance = 0;
-    uint32_t minTBFInterval = 0;
-
     // if no more trips left, stop the ongoing trip
     if (mTripSessions.size() == 0) {
         mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getContext(),
@@ -944,29 +980,15 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
         return;
     }
 
-    // record the min trip distance and min tbf interval of all ongoing sessions
-    for (auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
-
-        TripSessionStatus tripSessStatus = itt->second;
-
-        if ((minRemainingDistance == 0) ||
-                (minRemainingDistance > (tripSessStatus.tripDistance
-                - tripSessStatus.accumulatedDistanceThisTrip))) {
-            minRemainingDistance = tripSessStatus.tripDistance -
-                    tripSessStatus.accumulatedDistanceThisTrip;
-        }
-
-        if ((minTBFInterval == 0) ||
-            (minTBFInterval > tripSessStatus.tripTBFInterval)) {
-            minTBFInterval = tripSessStatus.tripTBFInterval;
-        }
-    }
-
     mLocApi->queryAccumulatedTripDistance(
             new LocApiResponseData<LocApiBatchData>(*getContext(),
-            [this, queryAccumulatedDistance, minRemainingDistance, minTBFInterval, accDist,
-            numbatchedPos] (LocationError /*err*/, LocApiBatchData data) {
+            [this, queryAccumulatedDistance, accDist, numbatchedPos]
+            (LocationError /*err*/, LocApiBatchData data) {
         bool needsRestart = false;
+        if (mTripSessions.size() == 0) {
+            // the last trip went away while querying, and its stop has handled it
+            return;
+        }
 
         uint32_t ongoingTripDistance = mOngoingTripDistance;
         uint32_t ongoingTripInterval = mOngoingTripTBFInterval;
@@ -976,8 +998,14 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
         if (queryAccumulatedDistance) {
             accumulatedDistance = data.accumulatedDistance;
             numOfBatchedPositions = data.numOfBatchedPositions;
+            mTripBatchDistance = accumulatedDistance;
         }
 
+        // does batch need restart with new trip distance / TBF interval,
+        // taken from the min remaining trip distance and min tbf interval of all sessions
+        uint32_t minRemainingDistance = getTripRemainingDistance(accumulatedDistance);
+        uint32_t minTBFInterval = getTripMinInterval();
+
         if ((!mTripWithOngoingTripDistanceDropped) &&
                 (ongoingTripDistance - accumulatedDistance != 0)) {
             // if ongoing trip is already not completed still,
@@ -1008,17 +1036,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
                     (LocationError err) {
 
                 if (err == LOCATION_ERROR_SUCCESS) {
-                    for(auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
-                        TripSessionStatus &tripSessStatus = itt->second;
-                        tripSessStatus.accumulatedDistanceThisTrip =
-                                tripSessStatus.accumulatedDistanceOnTripRestart +
-                                (accumulatedDistance -
-                                 tripSessStatus.accumulatedDistanceOngoingBatch);
-
-                        tripSessStatus.accumulatedDistanceOngoingBatch = 0;
-                        tripSessStatus.accumulatedDistanceOnTripRestart =
-                                tripSessStatus.accumulatedDistanceThisTrip;
-                    }
+                    rebaseTripOdometer(accumulatedDistance);
 
                     mOngoingTripDistance = ongoingTripDistance;
                     mOngoingTripTBFInterval = ongoingTripInterval;
@@ -1028,6 +1046,54 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
     }));
 }
 
+void
+BatchingAdapter::saveTripSession(uint32_t sessionId, const BatchingOptions& batchingOptions,
+        uint32_t batchDistance)
+{
+    eraseTripSession(sessionId);
+    uint64_t target = mTripOdometerBase + batchDistance + batchingOptions.minDistance;
+    TripSessionStatus tripSession = { batchingOptions.minDistance,
+                                      batchingOptions.minInterval,
+                                      mTripTargets.insert(std::make_pair(target, sessionId)),
+                                      mTripIntervals.insert(batchingOptions.minInterval) };
+    mTripSessions.insert(std::make_pair(sessionId, tripSession));
+}
+
+void
+BatchingAdapter::eraseTripSession(uint32_t sessionId)
+{
+    auto itt = mTripSessions.find(sessionId);
+    if (itt != mTripSessions.end()) {
+        mTripTargets.erase(itt->second.target);
+        mTripIntervals.erase(itt->second.interval);
+        mTripSessions.erase(itt);
+    }
+}
+
+void
+BatchingAdapter::rebaseTripOdometer(uint32_t batchDistance)
+{
+    mTripOdometerBase += batchDistance;
+    mTripBatchDistance = 0;
+}
+
+uint32_t
+BatchingAdapter::getTripRemainingDistance(uint32_t batchDistance)
+{
+    if (mTripTargets.empty()) {
+        return 0;
+    }
+    uint64_t odometer = mTripOdometerBase + batchDistance;
+    uint64_t target = mTripTargets.begin()->first;
+    return (target > odometer) ? (uint32_t)(target - odometer) : 0;
+}
+
+uint32_t
+BatchingAdapter::getTripMinInterval()
+{
+    return mTripIntervals.empty() ? 0 : *mTripIntervals.begin();
+}
+
 void
 BatchingAdapter::printTripReport()
 {
@@ -1035,17 +1101,182 @@ BatchingAdapter::printTripReport()
         LOC_LOGD("Ongoing Trip Distance = %u, Ongoing Trip TBF Interval = %u",
                 mOngoingTripDistance, mOngoingTripTBFInterval);
 
+        uint64_t odometer = mTripOdometerBase + mTripBatchDistance;
         for (auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
-            TripSessionStatus tripSessStatus = itt->second;
+            TripSessionStatus& tripSessStatus = itt->second;
+            uint64_t target = tripSessStatus.target->first;
+            uint32_t remaining = (target > odometer) ? (uint32_t)(target - odometer) : 0;
 
             LOC_LOGD("tripDistance:%u tripTBFInterval:%u"
                     " trip accumulated Distance:%u"
-                    " trip accumualted distance ongoing batch:%u"
-                    " trip accumulated distance on trip restart %u \r\n",
+                    " trip remaining distance:%u \r\n",
                     tripSessStatus.tripDistance, tripSessStatus.tripTBFInterval,
-                    tripSessStatus.accumulatedDistanceThisTrip,
-                    tripSessStatus.accumulatedDistanceOngoingBatch,
-                    tripSessStatus.accumulatedDistanceOnTripRestart);
+                    tripSessStatus.tripDistance - std::min(remaining,
+                                                           tripSessStatus.tripDistance),
+                    remaining);
+        }
+    }
+}
+
+void
+BatchingAdapter::setOpportunisticFlush(uint32_t flushSec, uint32_t flushSize)
+{
+    LOC_LOGD("%s]: flushSec %u flushSize %u", __func__, flushSec, flushSize);
+    mOpportunisticFlushSec = flushSec;
+    mOpportunisticFlushSize = (0 == flushSize) ? getBatchSize() : flushSize;
+    if (mOpportunisticFlushSec > 0 && nullptr == mOsObserver) {
+        mOsObserver = SystemStatus::getInstance(mMsgTask)->getOsObserver();
+        if (nullptr != mOsObserver) {
+            list<DataItemId> subItemIdList = {SCREEN_STATE_DATA_ITEM_ID,
+                                              POWER_CONNECTED_STATE_DATA_ITEM_ID};
+            mOsObserver->subscribe(subItemIdList, &mApStateObserver);
+        }
+    }
+    updateOpportunisticFlush();
+}
+
+void
+BatchingAdapter::ApStateObserver::notify(const list<IDataItemCore*>& dlist)
+{
+    bool hasScreenState = false;
+    bool screenOn = false;
+    bool hasPowerConnectState = false;
+    bool powerConnected = false;
+    for (auto each : dlist) {
+        switch (each->getId()) {
+            case SCREEN_STATE_DATA_ITEM_ID:
+                hasScreenState = true;
+                screenOn = static_cast<ScreenStateDataItemBase*>(each)->mState;
+                break;
+            case POWER_CONNECTED_STATE_DATA_ITEM_ID:
+                hasPowerConnectState = true;
+                powerConnected = static_cast<PowerConnectStateDataItemBase*>(each)->mState;
+                break;
+            default:
+                break;
         }
     }
+    if (hasScreenState || hasPowerConnectState) {
+        mAdapter.reportApStateEvent(hasScreenState, screenOn,
+                                    hasPowerConnectState, powerConnected);
+    }
+}
+
+void
+BatchingAdapter::reportApStateEvent(bool hasScreenState, bool screenOn,
+        bool hasPowerConnectState, bool powerConnected)
+{
+    struct MsgReportApState : public LocMsg {
+        BatchingAdapter& mAdapter;
+        bool mHasScreenState;
+        bool mScreenOn;
+        bool mHasPowerConnectState;
+        bool mPowerConnected;
+        inline MsgReportApState(BatchingAdapter& adapter,
+                                bool hasScreenState, bool screenOn,
+                                bool hasPowerConnectState, bool powerConnected) :
+            LocMsg(),
+            mAdapter(adapter),
+            mHasScreenState(hasScreenState),
+            mScreenOn(screenOn),
+            mHasPowerConnectState(hasPowerConnectState),
+            mPowerConnected(powerConnected) {}
+        inline virtual void proc() const {
+            if (mHasScreenState) {
+                mAdapter.mScreenOn = mScreenOn;
+            }
+            if (mHasPowerConnectState) {
+                mAdapter.mPowerConnected = mPowerConnected;
+            }
+            LOC_LOGD("%s]: screenOn %d powerConnected %d", __func__,
+                     mAdapter.mScreenOn, mAdapter.mPowerConnected);
+            mAdapter.updateOpportunisticFlush();
+        }
+    };
+
+    sendMsg(new MsgReportApState(*this, hasScreenState, screenOn,
+                                 hasPowerConnectState, powerConnected));
+}
+
+void
+BatchingAdapter::updateOpportunisticFlush()
+{
+    /* Only routine sessions are flushed early: trip batches are pulled when a trip
+       completes, and a NO_AUTO_REPORT client expects its locations when it asks for
+       them, which an early flush, delivered to every client, would break. */
+    bool routineSession = false;
+    bool noAutoReportSession = false;
+    for (auto& session : mBatchingSessions) {
+        if (BATCHING_MODE_ROUTINE == session.second.batchingMode) {
+            routineSession = true;
+        } else if (BATCHING_MODE_NO_AUTO_REPORT == session.second.batchingMode) {
+            noAutoReportSession = true;
+        }
+    }
+    bool wanted = mOpportunisticFlushSec > 0 && (mScreenOn || mPowerConnected) &&
+            routineSession && !noAutoReportSession;
+
+    if (wanted && !mOpportunisticFlushArmed) {
+        // non wakeup, with the whole interval as slack so it rides on other wakeups
+        uint32_t intervalMs = mOpportunisticFlushSec * 1000;
+        mOpportunisticFlushArmed = mOpportunisticFlushTimer.start(intervalMs, false, intervalMs);
+    } else if (!wanted && mOpportunisticFlushArmed) {
+        mOpportunisticFlushTimer.stop();
+        mOpportunisticFlushArmed = false;
+    }
+}
+
+void
+BatchingAdapter::OpportunisticFlushTimer::timeOutCallback()
+{
+    mAdapter.opportunisticFlushEvent();
+}
+
+void
+BatchingAdapter::opportunisticFlushEvent()
+{
+    struct MsgOpportunisticFlush : public LocMsg {
+        BatchingAdapter& mAdapter;
+        inline MsgOpportunisticFlush(BatchingAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.opportunisticFlush();
+        }
+    };
+
+    sendMsg(new MsgOpportunisticFlush(*this));
+}
+
+void
+BatchingAdapter::opportunisticFlush()
+{
+    mOpportunisticFlushArmed = false;
+    if (!isEngineCapabilitiesKnown()) {
+        updateOpportunisticFlush();
+        return;
+    }
+    // re-check, the state may have changed since the timer was armed
+    updateOpportunisticFlush();
+    if (!mOpportunisticFlushArmed) {
+        return;
+    }
+    LOC_LOGD("%s]: pulling up to %u batched locations", __func__, mOpportunisticFlushSize);
+    mOpportunisticFlushes.fetch_add(1, std::memory_order_relaxed);
+    mLocApi->getBatchedLocations(mOpportunisticFlushSize,
+            new LocApiResponse(*getContext(), [] (LocationError err) {
+        if (LOCATION_ERROR_SUCCESS != err) {
+            LOC_LOGD("%s]: opportunistic flush failed, err %u", __func__, err);
+        }
+    }));
+}
+
+void
+BatchingAdapter::dumpStats(std::string& out) const
+{
+    out += "Batching: batches=" +
+            std::to_string(mReportedBatches.load(std::memory_order_relaxed)) +
+            " locations=" + std::to_string(mReportedLocations.load(std::memory_order_relaxed)) +
+            " opportunistic_flushes=" +
+            std::to_string(mOpportunisticFlushes.load(std::memory_order_relaxed)) + "\n";
 }
@@ -32,25 +32,60 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <LocFlatMap.h>
+#include <LocMemStats.h>
+#include <LocBufferPool.h>
+#include <LocTimer.h>
+#include <IDataItemObserver.h>
+#include <IOsObserver.h>
+#include <atomic>
 #include <map>
+#include <set>
 
 using namespace loc_core;
 
+// batch buffers kept for reuse between reports; two would do for back to back
+// batch full and flush reports, the rest covers clients still holding one
+#define LOCATION_BATCH_POOL_SIZE 4
+
+typedef loc_util::LocBufferPool<Location>::Buffer LocationBatch;
+
 class BatchingAdapter : public LocAdapterBase {
 
     /* ==== BATCHING ======================================================================= */
+    /* Trip progress is kept against an odometer: mTripOdometerBase, the distance of the
+       trip batches the engine has restarted from, plus the distance it accumulated in the
+       ongoing one. A trip is completed once the odometer reaches its target, so a report
+       only pops targets off the front of mTripTargets, and the least remaining distance
+       and TBF interval among the trips are the first entries of the ordered sets. */
+    // the session maps are accounted as LOC_MEM_BATCHING, see MEM_ACCOUNTING_ENABLED
+    template <typename T>
+    using BatchingAllocator = loc_util::LocMemAllocator<T, loc_util::LOC_MEM_BATCHING>;
+    typedef std::multimap<uint64_t, uint32_t, std::less<uint64_t>,
+            BatchingAllocator<std::pair<const uint64_t, uint32_t>>>
+            TripTargetMap; //target odometer to sessionId
+    typedef std::multiset<uint32_t, std::less<uint32_t>, BatchingAllocator<uint32_t>>
+            TripIntervalSet;
     typedef struct {
-        uint32_t accumulatedDistanceOngoingBatch;
-        uint32_t accumulatedDistanceThisTrip;
-        uint32_t accumulatedDistanceOnTripRestart;
         uint32_t tripDistance;
         uint32_t tripTBFInterval;
+        TripTargetMap::iterator target;
+        TripIntervalSet::iterator interval;
     } TripSessionStatus;
-    typedef std::map<uint32_t, TripSessionStatus> TripSessionStatusMap;
-    typedef std::map<LocationSessionKey, BatchingOptions> BatchingSessionMap;
+    typedef loc_util::LocFlatMap<uint32_t, TripSessionStatus, std::less<uint32_t>,
+            BatchingAllocator<std::pair<uint32_t, TripSessionStatus>>> TripSessionStatusMap;
+    typedef loc_util::LocFlatMap<LocationSessionKey, BatchingOptions,
+            std::less<LocationSessionKey>,
+            BatchingAllocator<std::pair<LocationSessionKey, BatchingOptions>>>
+            BatchingSessionMap;
 
     BatchingSessionMap mBatchingSessions;
+    uint32_t mAutoReportBatchingSessions; //sessions of mBatchingSessions not NO_AUTO_REPORT
     TripSessionStatusMap mTripSessions;
+    TripTargetMap mTripTargets;
+    TripIntervalSet mTripIntervals;
+    uint64_t mTripOdometerBase;
+    uint32_t mTripBatchDistance; //last known distance accumulated in the ongoing trip batch
     uint32_t mOngoingTripDistance;
     uint32_t mOngoingTripTBFInterval;
     bool mTripWithOngoingTBFDropped;
@@ -72,6 +107,12 @@ class BatchingAdapter : public LocAdapterBase {
                                          const BatchingOptions& batchOptions);
     void restartTripBatching(bool queryAccumulatedDistance, uint32_t accDist = 0,
                              uint32_t numbatchedPos = 0);
+    void saveTripSession(uint32_t sessionId, const BatchingOptions& batchingOptions,
+                         uint32_t batchDistance);
+    void eraseTripSession(uint32_t sessionId);
+    void rebaseTripOdometer(uint32_t batchDistance);
+    uint32_t getTripRemainingDistance(uint32_t batchDistance);
+    uint32_t getTripMinInterval();
     void printTripReport();
 
     /* ==== CONFIGURATION ================================================================== */
@@ -80,6 +121,48 @@ class BatchingAdapter : public LocAdapterBase {
     size_t mBatchSize;
     size_t mTripBatchSize;
 
+    /* ==== REPORTS ======================================================================== */
+    loc_util::LocBufferPool<Location> mLocationBatchPool;
+    // written on the adapter thread, read by dumpStats()
+    std::atomic<uint64_t> mReportedBatches;
+    std::atomic<uint64_t> mReportedLocations;
+    std::atomic<uint64_t> mOpportunisticFlushes;
+
+    /* ==== OPPORTUNISTIC FLUSH ============================================================ */
+    /* With BATCH_OPPORTUNISTIC_FLUSH_SEC set, routine batches are pulled early in chunks
+       of BATCH_OPPORTUNISTIC_FLUSH_SIZE while the screen is on or power is connected,
+       i.e. while the AP is awake anyway. The timer never wakes the AP by itself. */
+    class ApStateObserver : public IDataItemObserver {
+        BatchingAdapter& mAdapter;
+    public:
+        inline ApStateObserver(BatchingAdapter& adapter) : mAdapter(adapter) {}
+        inline virtual void getName(string& name) override { name = "BatchingAdapter"; }
+        virtual void notify(const list<IDataItemCore*>& dlist) override;
+    };
+    class OpportunisticFlushTimer : public loc_util::LocTimer {
+        BatchingAdapter& mAdapter;
+    public:
+        inline OpportunisticFlushTimer(BatchingAdapter& adapter) :
+            LocTimer(), mAdapter(adapter) {}
+        virtual void timeOutCallback() override;
+    };
+    ApStateObserver mApStateObserver;
+    OpportunisticFlushTimer mOpportunisticFlushTimer;
+    IOsObserver* mOsObserver;
+    uint32_t mOpportunisticFlushSec;
+    uint32_t mOpportunisticFlushSize;
+    bool mScreenOn;
+    bool mPowerConnected;
+    bool mOpportunisticFlushArmed;
+
+    void setOpportunisticFlush(uint32_t flushSec, uint32_t flushSize);
+    void updateOpportunisticFlush();
+    void opportunisticFlush();
+
+    // flp.conf edits are applied as they happen, see handleFlpConfChange()
+    uint32_t mFlpConfListener;
+    void handleFlpConfChange(const LocConfNames& changed);
+
 protected:
 
     /* ==== CLIENT ========================================================================= */
@@ -88,7 +171,7 @@ protected:
 
 public:
     BatchingAdapter();
-    virtual ~BatchingAdapter() {}
+    virtual ~BatchingAdapter();
 
     /* ==== SSR ============================================================================ */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
@@ -128,10 +211,15 @@ public:
             BatchingMode batchingMode);
     void reportCompletedTripsEvent(uint32_t accumulatedDistance);
     void reportBatchStatusChangeEvent(BatchingStatus batchStatus);
+    void reportApStateEvent(bool hasScreenState, bool screenOn,
+                            bool hasPowerConnectState, bool powerConnected);
+    void opportunisticFlushEvent();
     /* ======== UTILITIES ================================================================== */
     void reportLocations(Location* locations, size_t count, BatchingMode batchingMode);
     void reportBatchStatusChange(BatchingStatus batchStatus,
             std::list<uint32_t> & completedTripsList);
+    // appends the batches reported and the opportunistic flushes, callable from any thread
+    void dumpStats(std::string& out) const;
 
     /* ==== CONFIGURATION ================================================================== */
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
@@ -42,6 +42,7 @@ static uint32_t startBatching(LocationAPI* client, BatchingOptions&);
 static void stopBatching(LocationAPI* client, uint32_t id);
 static void updateBatchingOptions(LocationAPI* client, uint32_t id, BatchingOptions&);
 static void getBatchedLocations(LocationAPI* client, uint32_t id, size_t count);
+static void dumpStats(std::string& out);
 
 static const BatchingInterface gBatchingInterface = {
     sizeof(BatchingInterface),
@@ -53,7 +54,8 @@ static const BatchingInterface gBatchingInterface = {
     startBatching,
     stopBatching,
     updateBatchingOptions,
-    getBatchedLocations
+    getBatchedLocations,
+    dumpStats
 };
 
 #ifndef DEBUG_X86
@@ -75,7 +77,17 @@ static void initialize()
 static void deinitialize()
 {
     if (NULL != gBatchingAdapter) {
-        delete gBatchingAdapter;
+        // deleted on its own thread, after the msgs already queued for it
+        struct MsgDeinit : public LocMsg {
+            BatchingAdapter* mAdapter;
+            inline MsgDeinit(BatchingAdapter* adapter) :
+                LocMsg(),
+                mAdapter(adapter) {}
+            inline virtual void proc() const {
+                delete mAdapter;
+            }
+        };
+        gBatchingAdapter->sendMsg(new MsgDeinit(gBatchingAdapter));
         gBatchingAdapter = NULL;
     }
 }
@@ -132,3 +144,9 @@ static void getBatchedLocations(LocationAPI* client, uint32_t id, size_t count)
     }
 }
 
+static void dumpStats(std::string& out)
+{
+    if (NULL != gBatchingAdapter) {
+        gBatchingAdapter->dumpStats(out);
+    }
+}
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// loc_hal_benchmark - micro benchmarks of the hot paths of the location HAL,
+// built for the host so they run in CI: MsgTask message passing, LocTimer
+// start / stop, LocHeap, NMEA generation, SystemStatus debug NMEA parsing
+// and the fan-out of a LocApi position report through GnssAdapter to a
+// client.
+//
+// On the host there is no LocApi library to load, so the context ends up
+// with the LocApiBase stub and the benchmark plays the engine by calling
+// its report methods. The conf files are read from the working directory.
+
+#include <math.h>
+#include <string.h>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <MsgTask.h>
+#include <LocTimer.h>
+#include <LocHeap.h>
+#include <loc_nmea.h>
+#include <LocContext.h>
+#include <LocApiBase.h>
+#include <SystemStatus.h>
+#include <location_interface.h>
+
+using namespace loc_core;
+using namespace loc_util;
+
+extern "C" const GnssInterface* getGnssInterface();
+
+// Fix number i of a drive around a circle
+static void fillFix(UlpLocation& location, GpsLocationExtended& locationExtended, uint32_t i) {
+    double t = (double)i;
+
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+    LocGpsLocation& gps = location.gpsLocation;
+    gps.size = sizeof(gps);
+    gps.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    gps.latitude = 32.9 + 0.01 * sin(t / 300.0);
+    gps.longitude = -117.2 + 0.01 * cos(t / 300.0);
+    gps.altitude = 100.0 + 5.0 * sin(t / 60.0);
+    gps.speed = 13.8 + sin(t / 20.0);
+    gps.bearing = fmod(t * 0.6, 360.0);
+    gps.accuracy = 3.5f;
+    gps.timestamp = 1600000000000LL + (int64_t)i * 1000;
+
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    locationExtended.size = sizeof(locationExtended);
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_DOP |
+            GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL |
+            GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA |
+            GPS_LOCATION_EXTENDED_HAS_POS_TECH_MASK;
+    locationExtended.pdop = 1.8f;
+    locationExtended.hdop = 0.9f;
+    locationExtended.vdop = 1.5f;
+    locationExtended.altitudeMeanSeaLevel = gps.altitude - 35.0;
+    locationExtended.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+    locationExtended.gnss_sv_used_ids.gps_sv_used_ids_mask = 0x0000db6dULL;
+    locationExtended.gnss_sv_used_ids.glo_sv_used_ids_mask = 0x00000db6ULL;
+    locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask = 0x000036dbULL;
+    locationExtended.gnss_sv_used_ids.bds_sv_used_ids_mask = 0x0001b6dbULL;
+}
+
+// A sky of 40 SVs over five constellations
+static void fillSv(GnssSvNotification& svNotify) {
+    static const GnssSvType types[] = { GNSS_SV_TYPE_GPS, GNSS_SV_TYPE_GLONASS,
+        GNSS_SV_TYPE_GALILEO, GNSS_SV_TYPE_BEIDOU, GNSS_SV_TYPE_QZSS };
+    static const uint16_t firstSvIds[] = { 1, 65, 301, 201, 193 };
+
+    memset(&svNotify, 0, sizeof(svNotify));
+    svNotify.size = sizeof(svNotify);
+    for (int c = 0; c < 5; c++) {
+        for (uint16_t n = 0; n < 8; n++) {
+            GnssSv& sv = svNotify.gnssSvs[svNotify.count++];
+            sv.size = sizeof(sv);
+            sv.svId = firstSvIds[c] + n;
+            sv.type = types[c];
+            sv.cN0Dbhz = 20.0f + n * 3;
+            sv.elevation = 10.0f + n * 9;
+            sv.azimuth = n * 45.0f;
+            sv.gnssSvOptionsMask = (n % 3 != 2) ? GNSS_SV_OPTIONS_USED_IN_FIX_BIT : 0;
+        }
+    }
+}
+
+// Waits until msgTask has handled everything sent to it before
+static void drain(const MsgTask& msgTask) {
+    std::promise<void> done;
+    std::future<void> handled = done.get_future();
+    msgTask.sendMsg([&done]() { done.set_value(); }, LOC_MSG_PRIORITY_HOUSEKEEPING);
+    handled.wait();
+}
+
+/*
+ * MsgTask
+ */
+
+// messages a second through one MsgTask, range(0) messages per batch
+static void BM_MsgTaskThroughput(benchmark::State& state) {
+    static MsgTask msgTask("LocBenchMsg", eMSG_Q_TYPE_RING);
+    std::atomic<uint64_t> handled(0);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < state.range(0); i++) {
+            msgTask.sendMsg([&handled]() { handled++; });
+        }
+        drain(msgTask);
+    }
+    state.SetItemsProcessed(handled.load());
+}
+BENCHMARK(BM_MsgTaskThroughput)->Arg(1)->Arg(64)->Arg(1024)->UseRealTime();
+
+/*
+ * LocTimer
+ */
+
+class BenchTimer : public LocTimer {
+public:
+    inline virtual void timeOutCallback() override {}
+};
+
+// start and stop of one timer, with range(0) other timers armed
+static void BM_LocTimerStartStop(benchmark::State& state) {
+    std::vector<std::unique_ptr<BenchTimer>> armed;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        armed.emplace_back(new BenchTimer());
+        armed.back()->start(60000 + (uint32_t)i * 7, false);
+    }
+    BenchTimer timer;
+    for (auto _ : state) {
+        timer.start(30000, false);
+        timer.stop();
+    }
+    for (auto& each : armed) {
+        each->stop();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LocTimerStartStop)->Arg(0)->Arg(64)->Arg(1024);
+
+/*
+ * LocHeap
+ */
+
+class BenchRankable : public LocRankable {
+public:
+    uint32_t mRank;
+    inline virtual int ranks(LocRankable& rankable) override {
+        uint32_t other = static_cast<BenchRankable&>(rankable).mRank;
+        // lower value ranks higher, as with timer expiry
+        return (mRank < other) ? 1 : ((mRank > other) ? -1 : 0);
+    }
+};
+
+// push range(0) nodes in scrambled order, remove every other one, pop the rest
+static void BM_LocHeapPushRemovePop(benchmark::State& state) {
+    std::vector<BenchRankable> nodes(state.range(0));
+    for (size_t i = 0; i < nodes.size(); i++) {
+        nodes[i].mRank = (uint32_t)(i * 2654435761u);
+    }
+    LocHeap heap;
+    for (auto _ : state) {
+        for (auto& node : nodes) {
+            heap.push(node);
+        }
+        for (size_t i = 0; i < nodes.size(); i += 2) {
+            heap.remove(nodes[i]);
+        }
+        while (nullptr != heap.pop()) {}
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LocHeapPushRemovePop)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+/*
+ * NMEA generation
+ */
+
+static void BM_NmeaGeneratePos(benchmark::State& state) {
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    LocationSystemInfo systemInfo = {};
+    std::vector<std::string> nmeaArraystr;
+    uint32_t i = 0;
+    for (auto _ : state) {
+        fillFix(location, locationExtended, i++);
+        int indexOfGGA = -1;
+        nmeaArraystr.clear();
+        loc_nmea_generate_pos(location, locationExtended, systemInfo, true, false,
+                              nmeaArraystr, indexOfGGA, false);
+        benchmark::DoNotOptimize(nmeaArraystr.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NmeaGeneratePos);
+
+static void BM_NmeaGenerateSv(benchmark::State& state) {
+    GnssSvNotification svNotify;
+    fillSv(svNotify);
+    std::vector<std::string> nmeaArraystr;
+    for (auto _ : state) {
+        nmeaArraystr.clear();
+        loc_nmea_generate_sv(svNotify, nmeaArraystr);
+        benchmark::DoNotOptimize(nmeaArraystr.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NmeaGenerateSv);
+
+/*
+ * SystemStatus
+ */
+
+// one epoch of the debug NMEA the engine sends along with each fix
+static void BM_SystemStatusNmeaParse(benchmark::State& state) {
+    static const char* const sentences[] = {
+        "$PQWM1,2139,345600123,1,2,1200,500,30,1,-8,100,100,2000,2000,0,0,0,0,0,"
+                "-3.2,-3.1,-3.0,-2.9,18,1,100,100,100,100,100,100,15*5C",
+        "$PQWP1,123519.00,1,32.9,-117.2,100.0,5.0,3.0,1*33",
+        "$PQWP2,123519.00,1,32.9,-117.2,100.0,5.0,3.0,1*30",
+        "$PQWS1,0,0*3A",
+    };
+    static MsgTask msgTask("LocBenchSs");
+    SystemStatus* systemStatus = SystemStatus::getInstance(&msgTask);
+    std::vector<uint32_t> lengths;
+    for (const char* sentence : sentences) {
+        lengths.push_back(strlen(sentence));
+    }
+    for (auto _ : state) {
+        for (size_t i = 0; i < lengths.size(); i++) {
+            systemStatus->setNmeaString(sentences[i], lengths[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * lengths.size());
+}
+BENCHMARK(BM_SystemStatusNmeaParse);
+
+/*
+ * GnssAdapter
+ */
+
+// GnssAdapter with one tracking client, whose callbacks count the fixes
+struct BenchGnss {
+    std::atomic<uint64_t> mFixes;
+    // the adapter only uses the client as a key
+    char mClientKey;
+    LocationAPI* mClient;
+    LocApiBase* mLocApi;
+    const MsgTask* mMsgTask;
+
+    BenchGnss() : mFixes(0), mClient(reinterpret_cast<LocationAPI*>(&mClientKey)) {
+        const GnssInterface* gnss = getGnssInterface();
+        gnss->initialize();
+
+        LocationCallbacks callbacks = {};
+        callbacks.size = sizeof(callbacks);
+        callbacks.capabilitiesCb = [](LocationCapabilitiesMask) {};
+        callbacks.responseCb = [](LocationError, uint32_t) {};
+        callbacks.collectiveResponseCb = [](uint32_t, LocationError*, uint32_t*) {};
+        callbacks.trackingCb = [this](Location) { mFixes++; };
+        gnss->addClient(mClient, callbacks);
+
+        TrackingOptions options;
+        options.size = sizeof(options);
+        options.minInterval = 100;
+        options.mode = GNSS_SUPL_MODE_STANDALONE;
+        gnss->startTracking(mClient, options);
+
+        ContextBase* context = LocContext::getLocContext(LocContext::mLocationHalName);
+        mLocApi = context->getLocApi();
+        mMsgTask = context->getMsgTask();
+        drain(*mMsgTask);
+    }
+};
+
+// position reports a second from the LocApi to the client, range(0) per batch
+static void BM_GnssAdapterReportPosition(benchmark::State& state) {
+    static BenchGnss* bench = new BenchGnss();
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    static uint32_t fix = 0;
+    uint64_t fixes = bench->mFixes;
+    for (auto _ : state) {
+        for (int64_t i = 0; i < state.range(0); i++) {
+            fillFix(location, locationExtended, fix++);
+            bench->mLocApi->reportPosition(location, locationExtended, LOC_SESS_SUCCESS,
+                                           LOC_POS_TECH_MASK_SATELLITE);
+        }
+        drain(*bench->mMsgTask);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    // reports the adapter throttled away don't reach the client
+    state.counters["delivered"] = benchmark::Counter(bench->mFixes - fixes);
+}
+BENCHMARK(BM_GnssAdapterReportPosition)->Arg(1)->Arg(32)->UseRealTime();
+
+BENCHMARK_MAIN();
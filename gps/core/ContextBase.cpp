@@ -36,6 +36,10 @@
 #include <loc_target.h>
 #include <loc_pla.h>
 #include <loc_log.h>
+#include <LocConfWatcher.h>
+#include <LocLibPreloader.h>
+#include <LocApiReplay.h>
+#include <DataItemsFactoryProxy.h>
 
 namespace loc_core {
 
@@ -94,6 +98,15 @@ const loc_param_s_type ContextBase::mGps_conf_table[] =
   {"CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED",
            &mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED, NULL, 'n'},
   {"NMEA_TAG_BLOCK_GROUPING_ENABLED", &mGps_conf.NMEA_TAG_BLOCK_GROUPING_ENABLED, NULL, 'n'},
+  {"NMEA_EPOCH_BATCHING_ENABLED", &mGps_conf.NMEA_EPOCH_BATCHING_ENABLED, NULL, 'n'},
+  {"LAST_FIX_CACHE_MAX_AGE_SEC", &mGps_conf.LAST_FIX_CACHE_MAX_AGE_SEC, NULL, 'n'},
+  {"AGPS_PREWARM_MODE", &mGps_conf.AGPS_PREWARM_MODE, NULL, 'n'},
+  {"DGNSS_NTRIP_GGA_INTERVAL_SEC", &mGps_conf.DGNSS_NTRIP_GGA_INTERVAL_SEC, NULL, 'n'},
+  {"ODCPI_CACHED_LOCATION_MAX_AGE_SEC", &mGps_conf.ODCPI_CACHED_LOCATION_MAX_AGE_SEC, NULL, 'n'},
+  {"GNSS_ENERGY_PROFILE_ENABLED", &mGps_conf.GNSS_ENERGY_PROFILE_ENABLED, NULL, 'n'},
+  {"SUSPEND_TRACKING_MIN_TBF_MS", &mGps_conf.SUSPEND_TRACKING_MIN_TBF_MS, NULL, 'n'},
+  {"HIGH_RATE_DECIMATION_ENABLED", &mGps_conf.HIGH_RATE_DECIMATION_ENABLED, NULL, 'n'},
+  {"SCREEN_OFF_REPORT_INTERVAL_MS", &mGps_conf.SCREEN_OFF_REPORT_INTERVAL_MS, NULL, 'n'},
   {"NI_SUPL_DENY_ON_NFW_LOCKED",  &mGps_conf.NI_SUPL_DENY_ON_NFW_LOCKED, NULL, 'n'},
   {"ENABLE_NMEA_PRINT",  &mGps_conf.ENABLE_NMEA_PRINT, NULL, 'n'}
 };
@@ -195,6 +208,24 @@ void ContextBase::readConfig()
         mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED = 0;
         /* default NMEA Tag Block Grouping is disabled */
         mGps_conf.NMEA_TAG_BLOCK_GROUPING_ENABLED = 0;
+        /* default NMEA is delivered per report, not per epoch */
+        mGps_conf.NMEA_EPOCH_BATCHING_ENABLED = 0;
+        /* default the last fix is not cached across HAL restarts */
+        mGps_conf.LAST_FIX_CACHE_MAX_AGE_SEC = 0;
+        /* default the SUPL data call is only brought up on engine request */
+        mGps_conf.AGPS_PREWARM_MODE = 0;
+        /* default GGA goes to the NTRIP caster every 10 minutes */
+        mGps_conf.DGNSS_NTRIP_GGA_INTERVAL_SEC = 600;
+        /* default every ODCPI request goes to the framework */
+        mGps_conf.ODCPI_CACHED_LOCATION_MAX_AGE_SEC = 0;
+        /* default the engine energy is only read on client request */
+        mGps_conf.GNSS_ENERGY_PROFILE_ENABLED = 0;
+        /* default tracking runs at the requested TBF while suspended */
+        mGps_conf.SUSPEND_TRACKING_MIN_TBF_MS = 0;
+        /* default SV and NMEA reports follow the TBF of sub-second sessions */
+        mGps_conf.HIGH_RATE_DECIMATION_ENABLED = 0;
+        /* default SV and data reports keep their rate with the screen off */
+        mGps_conf.SCREEN_OFF_REPORT_INTERVAL_MS = 0;
         /* default configuration for NI_SUPL_DENY_ON_NFW_LOCKED */
         mGps_conf.NI_SUPL_DENY_ON_NFW_LOCKED = 1;
         /* By default NMEA Printing is disabled */
@@ -202,26 +233,69 @@ void ContextBase::readConfig()
 
         UTIL_READ_CONF(LOC_PATH_GPS_CONF, mGps_conf_table);
         UTIL_READ_CONF(LOC_PATH_SAP_CONF, mSap_conf_table);
-
-        if (strncmp(mGps_conf.NMEA_REPORT_RATE, "1HZ", sizeof(mGps_conf.NMEA_REPORT_RATE)) == 0) {
-            /* NMEA reporting is configured at 1Hz*/
-            sNmeaReportRate = GNSS_NMEA_REPORT_RATE_1HZ;
-        } else {
-            sNmeaReportRate = GNSS_NMEA_REPORT_RATE_NHZ;
-        }
+        updateDerivedConfig();
         LOC_LOGI("%s] GNSS Deployment: %s", __FUNCTION__,
                 ((mGps_conf.GNSS_DEPLOYMENT == 1) ? "SS5" :
                 ((mGps_conf.GNSS_DEPLOYMENT == 2) ? "QFUSION" : "QGNSS")));
 
-        switch (getTargetGnssType(loc_get_target())) {
-          case GNSS_GSS:
-          case GNSS_AUTO:
-             // For APQ targets, MSA/MSB capabilities should be reset
-             mGps_conf.CAPABILITIES &= ~(LOC_GPS_CAPABILITY_MSA | LOC_GPS_CAPABILITY_MSB);
-             break;
-          default:
-             break;
+        // from here on, only changed parameters are re-read, as the files change
+        LocConfWatcher::ChangeListener listener =
+                [this] (const char* confPath, const LocConfNames& changed) {
+            struct MsgConfigChange : public LocMsg {
+                ContextBase& mContext;
+                const std::string mConfPath;
+                const LocConfNames mChanged;
+                inline MsgConfigChange(ContextBase& context, const char* confPath,
+                                       const LocConfNames& changed) :
+                        LocMsg(), mContext(context), mConfPath(confPath), mChanged(changed) {}
+                inline virtual void proc() const {
+                    mContext.handleConfigChange(mConfPath.c_str(), mChanged);
+                }
+            };
+            sendMsg(new MsgConfigChange(*this, confPath, changed));
+        };
+        LocConfWatcher::getInstance().addListener(LOC_PATH_GPS_CONF, listener);
+        LocConfWatcher::getInstance().addListener(LOC_PATH_SAP_CONF, listener);
+    }
+}
+
+void ContextBase::updateDerivedConfig()
+{
+    if (strncmp(mGps_conf.NMEA_REPORT_RATE, "1HZ", sizeof(mGps_conf.NMEA_REPORT_RATE)) == 0) {
+        /* NMEA reporting is configured at 1Hz*/
+        sNmeaReportRate = GNSS_NMEA_REPORT_RATE_1HZ;
+    } else {
+        sNmeaReportRate = GNSS_NMEA_REPORT_RATE_NHZ;
+    }
+
+    switch (getTargetGnssType(loc_get_target())) {
+      case GNSS_GSS:
+      case GNSS_AUTO:
+         // For APQ targets, MSA/MSB capabilities should be reset
+         mGps_conf.CAPABILITIES &= ~(LOC_GPS_CAPABILITY_MSA | LOC_GPS_CAPABILITY_MSB);
+         break;
+      default:
+         break;
+    }
+}
+
+// Sets just the changed parameters, so that values adapters have since
+// overridden at run time (e.g. SUPL_VER) survive unrelated edits
+void ContextBase::handleConfigChange(const char* confPath, const LocConfNames& changed)
+{
+    int count = 0;
+    if (0 == strcmp(confPath, LOC_PATH_GPS_CONF)) {
+        count = UTIL_READ_CONF_SUBSET(LOC_PATH_GPS_CONF, mGps_conf_table, changed);
+        if (changed.count("NMEA_REPORT_RATE") > 0 || changed.count("CAPABILITIES") > 0) {
+            updateDerivedConfig();
         }
+    } else if (0 == strcmp(confPath, LOC_PATH_SAP_CONF)) {
+        count = UTIL_READ_CONF_SUBSET(LOC_PATH_SAP_CONF, mSap_conf_table, changed);
+    }
+    LOC_LOGi("%s: %d of %zu changed parameters applied", confPath, count, changed.size());
+
+    if (count > 0 && nullptr != mLocApi) {
+        mLocApi->reportConfigChange(confPath, changed);
     }
 }
 
@@ -247,7 +321,7 @@ LBSProxyBase* ContextBase::getLBSProxy(const char* libName)
 {
     LBSProxyBase* proxy = NULL;
     LOC_LOGD("%s:%d]: getLBSProxy libname: %s\n", __func__, __LINE__, libName);
-    void* lib = dlopen(libName, RTLD_NOW);
+    void* lib = LocLibPreloader::open(libName);
 
     if ((void*)NULL != lib) {
         getLBSProxy_t* getter = (getLBSProxy_t*)dlsym(lib, "getLBSProxy");
@@ -266,10 +340,29 @@ LBSProxyBase* ContextBase::getLBSProxy(const char* libName)
     return proxy;
 }
 
+const char* ContextBase::getLocApiLibName()
+{
+    return (IS_SS5_HW_ENABLED == mGps_conf.GNSS_DEPLOYMENT) ?
+            SLL_LOC_API_LIB_NAME : LOC_APIV2_0_LIB_NAME;
+}
+
+void ContextBase::preloadLibraries(const char* libName)
+{
+    if (TARGET_NO_GNSS != loc_get_target()) {
+        const char* const libs[] = {libName, getLocApiLibName(), DATA_ITEMS_LIB_NAME};
+        LocLibPreloader::preload(libs);
+    }
+}
+
 LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
 {
     LocApiBase* locApi = NULL;
-    const char* libname = LOC_APIV2_0_LIB_NAME;
+    const char* libname = getLocApiLibName();
+
+    // a captured log stands in for the modem, whatever the target
+    if (NULL != (locApi = LocApiReplay::create(exMask, this))) {
+        return locApi;
+    }
 
     // Check the target
     if (TARGET_NO_GNSS != loc_get_target()){
@@ -277,11 +370,7 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
         if (NULL == (locApi = mLBSProxy->getLocApi(exMask, this))) {
             void *handle = NULL;
 
-            if (IS_SS5_HW_ENABLED == mGps_conf.GNSS_DEPLOYMENT) {
-                libname = SLL_LOC_API_LIB_NAME;
-            }
-
-            if ((handle = dlopen(libname, RTLD_NOW)) != NULL) {
+            if ((handle = LocLibPreloader::open(libname)) != NULL) {
                 LOC_LOGD("%s:%d]: %s is present", __func__, __LINE__, libname);
                 getLocApi_t* getter = (getLocApi_t*) dlsym(handle, "getLocApi");
                 if (getter != NULL) {
@@ -294,7 +383,7 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
             else {
                 LOC_LOGD("%s:%d]: libloc_api_v02.so is NOT present. Trying RPC",
                         __func__, __LINE__);
-                handle = dlopen("libloc_api-rpc-qc.so", RTLD_NOW);
+                handle = LocLibPreloader::open("libloc_api-rpc-qc.so");
                 if (NULL != handle) {
                     getLocApi_t* getter = (getLocApi_t*) dlsym(handle, "getLocApi");
                     if (NULL != getter) {
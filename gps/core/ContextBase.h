@@ -83,6 +83,15 @@ typedef struct loc_gps_cfg_s
     uint32_t       NI_SUPL_DENY_ON_NFW_LOCKED;
     uint32_t       ENABLE_NMEA_PRINT;
     uint32_t       NMEA_TAG_BLOCK_GROUPING_ENABLED;
+    uint32_t       NMEA_EPOCH_BATCHING_ENABLED;
+    uint32_t       LAST_FIX_CACHE_MAX_AGE_SEC;
+    uint32_t       AGPS_PREWARM_MODE;
+    uint32_t       DGNSS_NTRIP_GGA_INTERVAL_SEC;
+    uint32_t       ODCPI_CACHED_LOCATION_MAX_AGE_SEC;
+    uint32_t       GNSS_ENERGY_PROFILE_ENABLED;
+    uint32_t       SUSPEND_TRACKING_MIN_TBF_MS;
+    uint32_t       HIGH_RATE_DECIMATION_ENABLED;
+    uint32_t       SCREEN_OFF_REPORT_INTERVAL_MS;
 } loc_gps_cfg_s_type;
 
 /* NOTE: the implementation of the parser casts number
@@ -124,9 +133,12 @@ class LocAdapterBase;
 
 class ContextBase {
     static LBSProxyBase* getLBSProxy(const char* libName);
+    static const char* getLocApiLibName();
     LocApiBase* createLocApi(LOC_API_ADAPTER_EVENT_MASK_T excludedMask);
     static const loc_param_s_type mGps_conf_table[];
     static const loc_param_s_type mSap_conf_table[];
+    static void updateDerivedConfig();
+    void handleConfigChange(const char* confPath, const LocConfNames& changed);
 protected:
     const LBSProxyBase* mLBSProxy;
     const MsgTask* mMsgTask;
@@ -148,6 +160,10 @@ public:
         }
     }
 
+    // Starts loading, in the background, the libraries a ContextBase
+    // with the LBS proxy libName is going to open
+    static void preloadLibraries(const char* libName);
+
     inline const MsgTask* getMsgTask() { return mMsgTask; }
     inline LocApiBase* getLocApi() { return mLocApi; }
     inline LocApiProxyBase* getLocApiProxy() { return mLocApiProxy; }
@@ -157,7 +173,10 @@ public:
     inline IzatDevId_t getIzatDevId() const {
         return mLBSProxy->getIzatDevId();
     }
-    inline void sendMsg(const LocMsg *msg) { getMsgTask()->sendMsg(msg); }
+    inline void sendMsg(const LocMsg *msg,
+                        LocMsgPriority priority = LOC_MSG_PRIORITY_CONTROL) {
+        getMsgTask()->sendMsg(msg, priority);
+    }
 
     static loc_gps_cfg_s_type mGps_conf;
     static loc_sap_cfg_s_type mSap_conf;
@@ -34,6 +34,8 @@
 #include <loc_target.h>
 #include <log_util.h>
 #include <LocAdapterProxyBase.h>
+#include <unordered_set>
+#include <mutex>
 
 namespace loc_core {
 
@@ -59,14 +61,17 @@ LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
     }
 }
 
-uint32_t LocAdapterBase::mSessionIdCounter(1);
+std::atomic<uint32_t> LocAdapterBase::mSessionIdCounter(1);
 
 uint32_t LocAdapterBase::generateSessionId()
 {
-    if (++mSessionIdCounter == 0xFFFFFFFF)
-        mSessionIdCounter = 1;
+    uint32_t sessionId;
+    // 0 and 0xFFFFFFFF are never handed out, a wrap just skips them
+    do {
+        sessionId = mSessionIdCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+    } while (0 == sessionId || 0xFFFFFFFF == sessionId);
 
-     return mSessionIdCounter;
+    return sessionId;
 }
 
 void LocAdapterBase::handleEngineUpEvent()
@@ -400,6 +405,89 @@ LocAdapterBase::removeClientCommand(LocationAPI* client,
     sendMsg(new MsgRemoveClient(*this, client, rmClientCb));
 }
 
+// A pending msg queued with a type tag. It sits in mPendingMsgs as a plain
+// LocMsg, so the prebuilt adapters can still replay it; sTaggedPendingMsgs
+// tells it apart from the msgs they queue themselves.
+struct LocTaggedPendingMsg : public LocMsg {
+    static std::mutex sMutex;
+    static std::unordered_set<const LocMsg*> sTaggedPendingMsgs;
+    LocMsg* mMsg;
+    const void* mTypeTag;
+    const void* mClient;
+    inline LocTaggedPendingMsg(LocMsg* msg, const void* typeTag, const void* client) :
+            LocMsg(), mMsg(msg), mTypeTag(typeTag), mClient(client) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sTaggedPendingMsgs.insert(this);
+    }
+    inline virtual ~LocTaggedPendingMsg() {
+        {
+            std::lock_guard<std::mutex> lock(sMutex);
+            sTaggedPendingMsgs.erase(this);
+        }
+        delete mMsg;
+    }
+    inline virtual void proc() const {
+        mMsg->proc();
+    }
+    static inline LocTaggedPendingMsg* from(LocMsg* msg) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sTaggedPendingMsgs.count(msg) > 0 ?
+                static_cast<LocTaggedPendingMsg*>(msg) : nullptr;
+    }
+};
+
+std::mutex LocTaggedPendingMsg::sMutex;
+std::unordered_set<const LocMsg*> LocTaggedPendingMsg::sTaggedPendingMsgs;
+
+void
+LocAdapterBase::queuePendingMsg(LocMsg* msg, const void* typeTag, const void* client)
+{
+    if (nullptr == typeTag) {
+        mPendingMsgs.push_back(msg);
+        return;
+    }
+    // the earlier duplicate goes, so the msg keeps its place after what was queued since
+    for (auto it = mPendingMsgs.begin(); it != mPendingMsgs.end(); ++it) {
+        LocTaggedPendingMsg* tagged = LocTaggedPendingMsg::from(*it);
+        if (nullptr != tagged && tagged->mTypeTag == typeTag && tagged->mClient == client) {
+            delete tagged;
+            mPendingMsgs.erase(it);
+            break;
+        }
+    }
+    mPendingMsgs.push_back(new LocTaggedPendingMsg(msg, typeTag, client));
+}
+
+void
+LocAdapterBase::replayPendingMsgs()
+{
+    if (mPendingMsgs.empty()) {
+        return;
+    }
+
+    struct MsgReplayPendingMsgs : public LocMsg {
+        std::vector<LocMsg*> mMsgs;
+        inline MsgReplayPendingMsgs(std::vector<LocMsg*>& pendingMsgs) :
+            LocMsg() {
+            mMsgs.swap(pendingMsgs);
+        }
+        inline virtual ~MsgReplayPendingMsgs() {
+            for (auto msg : mMsgs) {
+                delete msg;
+            }
+        }
+        // a msg that still finds the engine down queues a copy of itself again
+        inline virtual void proc() const {
+            for (auto msg : mMsgs) {
+                msg->proc();
+            }
+        }
+    };
+
+    LOC_LOGd("replaying %zu pending msgs", mPendingMsgs.size());
+    sendMsg(new MsgReplayPendingMsgs(mPendingMsgs));
+}
+
 void
 LocAdapterBase::requestCapabilitiesCommand(LocationAPI* client)
 {
@@ -415,7 +503,8 @@ LocAdapterBase::requestCapabilitiesCommand(LocationAPI* client)
             mClient(client) {}
         inline virtual void proc() const {
             if (!mAdapter.isEngineCapabilitiesKnown()) {
-                mAdapter.mPendingMsgs.push_back(new MsgRequestCapabilities(*this));
+                mAdapter.queueIdempotentPendingMsg(new MsgRequestCapabilities(*this),
+                                                   mClient);
                 return;
             }
             LocationCallbacks callbacks = mAdapter.getClientCallbacks(mClient);
@@ -33,6 +33,7 @@
 #include <ContextBase.h>
 #include <LocationAPI.h>
 #include <map>
+#include <atomic>
 
 #define MIN_TRACKING_INTERVAL (100) // 100 msec
 
@@ -58,9 +59,29 @@ namespace loc_core {
 
 class LocAdapterProxyBase;
 
+// Adapter events that came after the prebuilt adapters, so they can not be
+// LocAdapterBase virtuals. An adapter derives from this too and hands itself
+// to LocApiBase::setAdapterListener to get them.
+class LocAdapterListener {
+public:
+    inline virtual ~LocAdapterListener() {}
+    // Called on the context msg task once ContextBase::mGps_conf / mSap_conf
+    // hold the new values of the changed parameters of confPath
+    inline virtual void handleConfigChangeEvent(const char* /*confPath*/,
+                                                const LocConfNames& /*changed*/) {}
+    // The report LocApiBase made for all the position adapters, instead of
+    // their reportPositionEvent; one keeping it past the call holds on to the
+    // reference instead of copying it.
+    virtual void reportPositionReportEvent(const LocPositionReportPtr& report,
+                                           LocPosTechMask loc_technology_mask,
+                                           GnssDataNotification* pDataNotify,
+                                           int msInWeek) = 0;
+};
+
 class LocAdapterBase {
 private:
-    static uint32_t mSessionIdCounter;
+    // API calls on several client threads generate ids at once
+    static std::atomic<uint32_t> mSessionIdCounter;
     const bool mIsMaster;
     bool mIsEngineCapabilitiesKnown = false;
 
@@ -80,6 +101,21 @@ protected:
     typedef std::map<LocationAPI*, LocationCallbacks> ClientDataMap;
     ClientDataMap mClientData;
     std::vector<LocMsg*> mPendingMsgs; // For temporal storage of msgs before Open is completed
+    // A msg queued with a type tag is idempotent, only the last one per tag and
+    // client is kept.
+    template <typename MSG>
+    static inline const void* pendingMsgTypeTag() {
+        static const char tag = 0;
+        return &tag;
+    }
+    void queuePendingMsg(LocMsg* msg, const void* typeTag = nullptr,
+                         const void* client = nullptr);
+    template <typename MSG>
+    inline void queueIdempotentPendingMsg(MSG* msg, const void* client) {
+        queuePendingMsg(msg, pendingMsgTypeTag<MSG>(), client);
+    }
+    // sends all pending msgs as one msg, which handles them in the order queued
+    void replayPendingMsgs();
     /* ======== UTILITIES ================================================================== */
     void saveClient(LocationAPI* client, const LocationCallbacks& callbacks);
     void eraseClient(LocationAPI* client);
@@ -122,12 +158,20 @@ public:
         return mEvtMask;
     }
 
-    inline void sendMsg(const LocMsg* msg) const {
-        mMsgTask->sendMsg(msg);
+    inline void sendMsg(const LocMsg* msg,
+                        LocMsgPriority priority = LOC_MSG_PRIORITY_CONTROL) const {
+        mMsgTask->sendMsg(msg, priority);
+    }
+
+    inline void sendMsg(const LocMsg* msg,
+                        LocMsgPriority priority = LOC_MSG_PRIORITY_CONTROL) {
+        mMsgTask->sendMsg(msg, priority);
     }
 
-    inline void sendMsg(const LocMsg* msg) {
-        mMsgTask->sendMsg(msg);
+    // msg supersedes the one in slot, see MsgTask::sendConflatedMsg
+    inline void sendConflatedMsg(LocMsgSlot& slot, const LocMsg* msg,
+                                 LocMsgPriority priority = LOC_MSG_PRIORITY_CONTROL) const {
+        mMsgTask->sendConflatedMsg(slot, msg, priority);
     }
 
     inline void updateEvtMask(LOC_API_ADAPTER_EVENT_MASK_T event,
@@ -31,17 +31,49 @@
 
 #include <dlfcn.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <atomic>
 #include <gps_extended_c.h>
 #include <LocApiBase.h>
 #include <LocAdapterBase.h>
 #include <log_util.h>
 #include <LocContext.h>
 #include <loc_misc_utils.h>
+#include <LocTrace.h>
+#include <LocApiReplay.h>
 
 namespace loc_core {
 
 #define TO_ALL_LOCADAPTERS(call) TO_ALL_ADAPTERS(mLocAdapters, (call))
 #define TO_1ST_HANDLING_LOCADAPTERS(call) TO_1ST_HANDLING_ADAPTER(mLocAdapters, (call))
+// call reaches the adapter as evtAdapters[i]
+#define TO_EVT_LOCADAPTERS(evtType, call) {                                         \
+    LocApiBaseExt& ext = getExt();                                                \
+    uint32_t idx = ext.mEvtAdaptersIdx.load(std::memory_order_acquire);          \
+    LocAdapterBase* const* evtAdapters = ext.mEvtAdapters[idx][(evtType)];        \
+    ext.countReport(evtType);                                                     \
+    for (int i = 0; NULL != evtAdapters[i]; i++) {                                \
+        call;                                                                     \
+    }                                                                             \
+}
+
+// event mask bits that subscribe an adapter to each LocApiEvtType
+static const LOC_API_ADAPTER_EVENT_MASK_T sEvtTypeMasks[LOC_API_EVT_TYPE_MAX] = {
+    // LOC_API_EVT_TYPE_POSITION
+    LOC_API_ADAPTER_BIT_PARSED_POSITION_REPORT |
+            LOC_API_ADAPTER_BIT_PARSED_UNPROPAGATED_POSITION_REPORT,
+    // LOC_API_EVT_TYPE_SV
+    LOC_API_ADAPTER_BIT_SATELLITE_REPORT,
+    // LOC_API_EVT_TYPE_NMEA
+    LOC_API_ADAPTER_BIT_NMEA_1HZ_REPORT | LOC_API_ADAPTER_BIT_NMEA_POSITION_REPORT,
+    // LOC_API_EVT_TYPE_MEASUREMENT
+    LOC_API_ADAPTER_BIT_GNSS_MEASUREMENT | LOC_API_ADAPTER_BIT_GNSS_MEASUREMENT_REPORT |
+            LOC_API_ADAPTER_BIT_GNSS_NHZ_MEASUREMENT,
+    // LOC_API_EVT_TYPE_SV_POLYNOMIAL
+    LOC_API_ADAPTER_BIT_GNSS_SV_POLYNOMIAL_REPORT,
+    // LOC_API_EVT_TYPE_SV_EPHEMERIS
+    LOC_API_ADAPTER_BIT_GNSS_SV_EPHEMERIS_REPORT,
+};
 
 int hexcode(char *hexstring, int string_size,
             const char *data, int data_size)
@@ -119,6 +151,8 @@ struct LocOpenMsg : public LocMsg {
         locallog();
     }
     inline virtual void proc() const {
+        // the adapters or their masks changed
+        mLocApi->updateEvtAdapters();
         if (LOC_API_ADAPTER_ERR_SUCCESS == mLocApi->open(mLocApi->getEvtMask()) &&
             nullptr != mAdapter) {
             mAdapter->handleEngineUpEvent();
@@ -149,6 +183,104 @@ struct LocCloseMsg : public LocMsg {
     }
 };
 
+// The LocApiBase state that can not be a LocApiBase member without changing the
+// layout libloc_api_v02 derives LocApiV02 from. There is one per live LocApiBase,
+// found by its address. The list is only ever prepended to and an ext of a gone
+// LocApiBase is reused, so the reports find theirs without a lock.
+struct LocApiBaseExt {
+    std::atomic<const LocApiBase*> mOwner;
+    LocApiBaseExt* mNext;
+    // Per LocApiEvtType, the subscribed adapters in mLocAdapters order, null
+    // terminated. Writers rebuild the idle copy under mEvtAdaptersMutex and then
+    // flip mEvtAdaptersIdx, so the reports walk their list without a lock.
+    LocAdapterBase* mEvtAdapters[2][LOC_API_EVT_TYPE_MAX][MAX_ADAPTERS + 1];
+    std::atomic<uint32_t> mEvtAdaptersIdx;
+    pthread_mutex_t mEvtAdaptersMutex;
+    // the adapters with a LocAdapterListener, under mEvtAdaptersMutex
+    LocAdapterBase* mListenerAdapters[MAX_ADAPTERS];
+    LocAdapterListener* mListeners[MAX_ADAPTERS];
+    // the listener of each adapter in the position list, nullptr for none
+    LocAdapterListener* mPositionListeners[2][MAX_ADAPTERS + 1];
+    // reportPosition makes one report for all the adapters out of these
+    LocPositionReportPool<LOC_POSITION_REPORT_POOL_SIZE> mPositionReports;
+    // reports from the engine since start, by LocApiReportType
+    std::atomic<uint64_t> mReportCounts[LOC_API_REPORT_MAX];
+    // captures the engine reports, if LOC_API_CAPTURE_FILE is set
+    LocApiRecorder* mRecorder;
+
+    inline LocApiBaseExt() : mOwner(nullptr), mNext(nullptr), mEvtAdaptersIdx(0) {
+        pthread_mutex_init(&mEvtAdaptersMutex, nullptr);
+        reset();
+    }
+    inline void reset() {
+        memset(mEvtAdapters, 0, sizeof(mEvtAdapters));
+        memset(mListenerAdapters, 0, sizeof(mListenerAdapters));
+        memset(mListeners, 0, sizeof(mListeners));
+        memset(mPositionListeners, 0, sizeof(mPositionListeners));
+        mEvtAdaptersIdx.store(0, std::memory_order_relaxed);
+        mRecorder = LocApiRecorder::get();
+        for (uint32_t i = 0; i < LOC_API_REPORT_MAX; i++) {
+            mReportCounts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    inline void countReport(uint32_t type) {
+        mReportCounts[type].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+static std::atomic<LocApiBaseExt*> sExts(nullptr);
+static pthread_mutex_t sExtsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+void LocApiBase::acquireExt()
+{
+    pthread_mutex_lock(&sExtsMutex);
+    LocApiBaseExt* ext = nullptr;
+    for (LocApiBaseExt* e = sExts.load(std::memory_order_relaxed);
+         nullptr != e; e = e->mNext) {
+        const LocApiBase* owner = e->mOwner.load(std::memory_order_relaxed);
+        // LocApiV02 is destroyed by the inline ~LocApiBase it was built with,
+        // which leaves its ext owned by the address it had
+        if (this == owner) {
+            ext = e;
+            break;
+        }
+        if (nullptr == owner && nullptr == ext) {
+            ext = e;
+        }
+    }
+    if (nullptr == ext) {
+        ext = new LocApiBaseExt();
+        ext->mNext = sExts.load(std::memory_order_relaxed);
+        sExts.store(ext, std::memory_order_release);
+    } else {
+        ext->reset();
+    }
+    ext->mOwner.store(this, std::memory_order_release);
+    pthread_mutex_unlock(&sExtsMutex);
+}
+
+void LocApiBase::releaseExt()
+{
+    pthread_mutex_lock(&sExtsMutex);
+    getExt().mOwner.store(nullptr, std::memory_order_release);
+    pthread_mutex_unlock(&sExtsMutex);
+}
+
+LocApiBaseExt& LocApiBase::getExt() const
+{
+    // acquireExt has put it in the list before this LocApiBase can be used
+    LocApiBaseExt* ext = sExts.load(std::memory_order_acquire);
+    while (this != ext->mOwner.load(std::memory_order_acquire)) {
+        ext = ext->mNext;
+    }
+    return *ext;
+}
+
+void LocApiBase::setRecorder(LocApiRecorder* recorder)
+{
+    getExt().mRecorder = recorder;
+}
+
 MsgTask* LocApiBase::mMsgTask = nullptr;
 volatile int32_t LocApiBase::mMsgTaskRefCount = 0;
 
@@ -158,10 +290,11 @@ LocApiBase::LocApiBase(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
     mMask(0), mExcludedMask(excludedMask)
 {
     memset(mLocAdapters, 0, sizeof(mLocAdapters));
+    acquireExt();
 
     android_atomic_inc(&mMsgTaskRefCount);
     if (nullptr == mMsgTask) {
-        mMsgTask = new MsgTask("LocApiMsgTask");
+        mMsgTask = new MsgTask("LocApiMsgTask", eMSG_Q_TYPE_RING);
     }
 }
 
@@ -239,8 +372,60 @@ void LocApiBase::addAdapter(LocAdapterBase* adapter)
     }
 }
 
+void LocApiBase::updateEvtAdapters()
+{
+    LocApiBaseExt& ext = getExt();
+    pthread_mutex_lock(&ext.mEvtAdaptersMutex);
+    uint32_t idle = 1 - ext.mEvtAdaptersIdx.load(std::memory_order_relaxed);
+    for (int type = 0; type < LOC_API_EVT_TYPE_MAX; type++) {
+        int n = 0;
+        for (int i = 0; i < MAX_ADAPTERS && NULL != mLocAdapters[i]; i++) {
+            if (mLocAdapters[i]->checkMask(sEvtTypeMasks[type])) {
+                ext.mEvtAdapters[idle][type][n++] = mLocAdapters[i];
+            }
+        }
+        ext.mEvtAdapters[idle][type][n] = NULL;
+    }
+    LocAdapterBase* const* positionAdapters = ext.mEvtAdapters[idle][LOC_API_EVT_TYPE_POSITION];
+    for (int n = 0; NULL != positionAdapters[n]; n++) {
+        ext.mPositionListeners[idle][n] = NULL;
+        for (int i = 0; i < MAX_ADAPTERS; i++) {
+            if (ext.mListenerAdapters[i] == positionAdapters[n]) {
+                ext.mPositionListeners[idle][n] = ext.mListeners[i];
+                break;
+            }
+        }
+    }
+    ext.mEvtAdaptersIdx.store(idle, std::memory_order_release);
+    pthread_mutex_unlock(&ext.mEvtAdaptersMutex);
+}
+
+void LocApiBase::setAdapterListener(LocAdapterBase* adapter, LocAdapterListener* listener)
+{
+    LocApiBaseExt& ext = getExt();
+    pthread_mutex_lock(&ext.mEvtAdaptersMutex);
+    int slot = -1;
+    for (int i = 0; i < MAX_ADAPTERS; i++) {
+        if (ext.mListenerAdapters[i] == adapter) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 && NULL == ext.mListenerAdapters[i]) {
+            slot = i;
+        }
+    }
+    if (slot >= 0) {
+        ext.mListenerAdapters[slot] = (NULL == listener) ? NULL : adapter;
+        ext.mListeners[slot] = listener;
+    }
+    pthread_mutex_unlock(&ext.mEvtAdaptersMutex);
+    // the position list goes to the listener from here on
+    updateEvtAdapters();
+}
+
 void LocApiBase::removeAdapter(LocAdapterBase* adapter)
 {
+    setAdapterListener(adapter, NULL);
     for (int i = 0;
          i < MAX_ADAPTERS && NULL != mLocAdapters[i];
          i++) {
@@ -264,6 +449,10 @@ void LocApiBase::removeAdapter(LocAdapterBase* adapter)
             // this makes sure that we exit the for loop
             mLocAdapters[i] = NULL;
 
+            // the adapter is going away, so it must not wait for the msg below
+            // to drop out of the event lists
+            updateEvtAdapters();
+
             // if we have an empty list of adapters
             if (0 == i) {
                 sendMsg(new LocCloseMsg(this));
@@ -312,12 +501,26 @@ void LocApiBase::handleEngineUpEvent()
 
 void LocApiBase::handleEngineDownEvent()
 {    // This will take care of renegotiating the loc handle
+    getExt().countReport(LOC_API_REPORT_ENGINE_DOWN);
     sendMsg(new LocSsrMsg(this));
 
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->handleEngineDownEvent());
 }
 
+void LocApiBase::reportConfigChange(const char* confPath, const LocConfNames& changed)
+{
+    // loop through the listeners, and deliver to all of them.
+    LocApiBaseExt& ext = getExt();
+    pthread_mutex_lock(&ext.mEvtAdaptersMutex);
+    for (int i = 0; i < MAX_ADAPTERS; i++) {
+        if (NULL != ext.mListeners[i]) {
+            ext.mListeners[i]->handleConfigChangeEvent(confPath, changed);
+        }
+    }
+    pthread_mutex_unlock(&ext.mEvtAdaptersMutex);
+}
+
 void LocApiBase::reportPosition(UlpLocation& location,
                                 GpsLocationExtended& locationExtended,
                                 enum loc_sess_status status,
@@ -325,6 +528,12 @@ void LocApiBase::reportPosition(UlpLocation& location,
                                 GnssDataNotification* pDataNotify,
                                 int msInWeek)
 {
+    LocApiRecorder* recorder = getExt().mRecorder;
+    if (nullptr != recorder) {
+        recorder->recordPosition(location, locationExtended, status, loc_technology_mask,
+                                 pDataNotify, msInWeek);
+    }
+    loc_util::LocTraceHop traceHop("LocApiBase::reportPosition", loc_util::LocTrace::startFix());
     // print the location info before delivering
     LOC_LOGD("flags: %d\n  source: %d\n  latitude: %f\n  longitude: %f\n  "
              "altitude: %f\n  speed: %f\n  bearing: %f\n  accuracy: %f\n  "
@@ -343,11 +552,19 @@ void LocApiBase::reportPosition(UlpLocation& location,
              locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.qzss_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.navic_sv_used_ids_mask);
-    // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportPositionEvent(location, locationExtended,
-                                             status, loc_technology_mask,
-                                             pDataNotify, msInWeek)
+    // loop through the adapters subscribed to positions, and deliver to them.
+    // They all get the same report, any of them may keep it past the call.
+    LocPositionReportPtr report =
+            getExt().mPositionReports.make(location, locationExtended, status);
+    TO_EVT_LOCADAPTERS(LOC_API_EVT_TYPE_POSITION,
+        LocAdapterListener* listener = ext.mPositionListeners[idx][i];
+        if (NULL != listener) {
+            listener->reportPositionReportEvent(report, loc_technology_mask,
+                                                pDataNotify, msInWeek);
+        } else {
+            evtAdapters[i]->reportPositionEvent(location, locationExtended, status,
+                                                loc_technology_mask, pDataNotify, msInWeek);
+        }
     );
 }
 
@@ -403,6 +620,10 @@ void LocApiBase::sendNfwNotification(GnssNfwNotification& notification)
 
 void LocApiBase::reportSv(GnssSvNotification& svNotify)
 {
+    LocApiRecorder* recorder = getExt().mRecorder;
+    if (nullptr != recorder) {
+        recorder->recordSv(svNotify);
+    }
     const char* constellationString[] = { "Unknown", "GPS", "SBAS", "GLONASS",
         "QZSS", "BEIDOU", "GALILEO", "NAVIC" };
 
@@ -430,44 +651,61 @@ void LocApiBase::reportSv(GnssSvNotification& svNotify)
             svNotify.gnssSvs[i].gnssSvOptionsMask,
             svNotify.gnssSvs[i].gnssSignalTypeMask);
     }
-    // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportSvEvent(svNotify)
+    // loop through the adapters subscribed to SVs, and deliver to them.
+    TO_EVT_LOCADAPTERS(LOC_API_EVT_TYPE_SV,
+        evtAdapters[i]->reportSvEvent(svNotify)
         );
 }
 
 void LocApiBase::reportSvPolynomial(GnssSvPolynomial &svPolynomial)
 {
+    LocApiRecorder* recorder = getExt().mRecorder;
+    if (nullptr != recorder) {
+        recorder->recordSvPolynomial(svPolynomial);
+    }
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportSvPolynomialEvent(svPolynomial)
+    TO_EVT_LOCADAPTERS(LOC_API_EVT_TYPE_SV_POLYNOMIAL,
+        evtAdapters[i]->reportSvPolynomialEvent(svPolynomial)
     );
 }
 
 void LocApiBase::reportSvEphemeris(GnssSvEphemerisReport & svEphemeris)
 {
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportSvEphemerisEvent(svEphemeris)
+    TO_EVT_LOCADAPTERS(LOC_API_EVT_TYPE_SV_EPHEMERIS,
+        evtAdapters[i]->reportSvEphemerisEvent(svEphemeris)
     );
 }
 
 void LocApiBase::reportStatus(LocGpsStatusValue status)
 {
+    LocApiRecorder* recorder = getExt().mRecorder;
+    if (nullptr != recorder) {
+        recorder->recordStatus(status);
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportStatus(status));
 }
 
 void LocApiBase::reportData(GnssDataNotification& dataNotify, int msInWeek)
 {
+    LocApiRecorder* recorder = getExt().mRecorder;
+    if (nullptr != recorder) {
+        recorder->recordData(dataNotify, msInWeek);
+    }
+    getExt().countReport(LOC_API_REPORT_DATA);
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportDataEvent(dataNotify, msInWeek));
 }
 
 void LocApiBase::reportNmea(const char* nmea, int length)
 {
+    LocApiRecorder* recorder = getExt().mRecorder;
+    if (nullptr != recorder) {
+        recorder->recordNmea(nmea, length);
+    }
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportNmeaEvent(nmea, length));
+    TO_EVT_LOCADAPTERS(LOC_API_EVT_TYPE_NMEA, evtAdapters[i]->reportNmeaEvent(nmea, length));
 }
 
 void LocApiBase::reportXtraServer(const char* url1, const char* url2,
@@ -542,8 +780,13 @@ LocApiProxyBase* LocApiBase :: getLocApiProxy()
 
 void LocApiBase::reportGnssMeasurements(GnssMeasurements& gnssMeasurements, int msInWeek)
 {
+    LocApiRecorder* recorder = getExt().mRecorder;
+    if (nullptr != recorder) {
+        recorder->recordMeasurements(gnssMeasurements, msInWeek);
+    }
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportGnssMeasurementsEvent(gnssMeasurements, msInWeek));
+    TO_EVT_LOCADAPTERS(LOC_API_EVT_TYPE_MEASUREMENT,
+        evtAdapters[i]->reportGnssMeasurementsEvent(gnssMeasurements, msInWeek));
 }
 
 void LocApiBase::reportGnssSvIdConfig(const GnssSvIdConfig& config)
@@ -572,6 +815,7 @@ void LocApiBase::reportGnssSvTypeConfig(const GnssSvTypeConfig& config)
 void LocApiBase::geofenceBreach(size_t count, uint32_t* hwIds, Location& location,
                                 GeofenceBreachType breachType, uint64_t timestamp)
 {
+    getExt().countReport(LOC_API_REPORT_GEOFENCE_BREACH);
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->geofenceBreachEvent(count, hwIds, location, breachType,
                                                             timestamp));
 }
@@ -590,6 +834,7 @@ void LocApiBase::reportDBTPosition(UlpLocation &location, GpsLocationExtended &l
 
 void LocApiBase::reportLocations(Location* locations, size_t count, BatchingMode batchingMode)
 {
+    getExt().countReport(LOC_API_REPORT_LOCATIONS);
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportLocationsEvent(locations, count, batchingMode));
 }
 
@@ -615,6 +860,24 @@ void LocApiBase::reportLatencyInfo(GnssLatencyInfo& gnssLatencyInfo)
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportLatencyInfoEvent(gnssLatencyInfo));
 }
 
+static const char* const sReportNames[LOC_API_REPORT_MAX] = {
+    "position", "sv", "nmea", "measurement", "sv_polynomial", "sv_ephemeris",
+    "data", "locations", "geofence_breach", "engine_down"
+};
+
+void LocApiBase::dumpStats(std::string& out) const
+{
+    const LocApiBaseExt& ext = getExt();
+    out += "Engine reports:";
+    for (uint32_t i = 0; i < LOC_API_REPORT_MAX; i++) {
+        out += " ";
+        out += sReportNames[i];
+        out += "=";
+        out += std::to_string(ext.mReportCounts[i].load(std::memory_order_relaxed));
+    }
+    out += "\n";
+}
+
 enum loc_api_adapter_err LocApiBase::
    open(LOC_API_ADAPTER_EVENT_MASK_T /*mask*/)
 DEFAULT_IMPL(LOC_API_ADAPTER_ERR_SUCCESS)
@@ -929,8 +1192,71 @@ void LocApiBase::
     getConstellationMultiBandConfig(uint32_t /*sessionId*/, LocApiResponse* /*adapterResponse*/)
 DEFAULT_IMPL()
 
+ElapsedRealtimeClock::ElapsedRealtimeClock(int64_t resampleNanos) :
+        mResampleNanos(resampleNanos),
+        mQTimerFreq(getQTimerFreq()),
+        mSampleUtcOffsetNanos(0),
+        mSampleBootTimeNanos(0),
+        mSampleTicks(0)
+{
+}
+
+bool ElapsedRealtimeClock::getTime(int64_t& currentTimeNanos, int64_t& sinceBootTimeNanos)
+{
+    if (0 != mSampleTicks) {
+        uint64_t ticks = getQTimerTickCount();
+        if (ticks >= mSampleTicks) {
+            uint64_t diff = ticks - mSampleTicks;
+            int64_t elapsedNanos = (int64_t)((diff / mQTimerFreq) * 1000000000ULL +
+                    (diff % mQTimerFreq) * 1000000000ULL / mQTimerFreq);
+            if (elapsedNanos < mResampleNanos) {
+                sinceBootTimeNanos = mSampleBootTimeNanos + elapsedNanos;
+                currentTimeNanos = sinceBootTimeNanos + mSampleUtcOffsetNanos;
+                return true;
+            }
+        }
+    }
+
+    struct timespec currentTime;
+    if (!ElapsedRealtimeEstimator::getCurrentTime(currentTime, sinceBootTimeNanos)) {
+        mSampleTicks = 0;
+        return false;
+    }
+    currentTimeNanos = (int64_t)currentTime.tv_sec * 1000000000 + currentTime.tv_nsec;
+    if (mResampleNanos > 0 && 0 != mQTimerFreq) {
+        mSampleUtcOffsetNanos = currentTimeNanos - sinceBootTimeNanos;
+        mSampleBootTimeNanos = sinceBootTimeNanos;
+        mSampleTicks = getQTimerTickCount();
+    }
+    return true;
+}
+
 int64_t ElapsedRealtimeEstimator::getElapsedRealtimeEstimateNanos(int64_t curDataTimeNanos,
             bool isCurDataTimeTrustable, int64_t tbf) {
+    struct timespec currentTime;
+    int64_t sinceBootTimeNanos;
+    if (!getCurrentTime(currentTime, sinceBootTimeNanos)) {
+        return -1;
+    }
+    int64_t currentTimeNanos = (int64_t)currentTime.tv_sec*1000000000 + currentTime.tv_nsec;
+    return estimate(curDataTimeNanos, isCurDataTimeTrustable, tbf,
+                    currentTimeNanos, sinceBootTimeNanos);
+}
+
+int64_t ElapsedRealtimeEstimator::getElapsedRealtimeEstimateNanos(int64_t curDataTimeNanos,
+            bool isCurDataTimeTrustable, int64_t tbf, ElapsedRealtimeClock& clock) {
+    int64_t currentTimeNanos;
+    int64_t sinceBootTimeNanos;
+    if (!clock.getTime(currentTimeNanos, sinceBootTimeNanos)) {
+        return -1;
+    }
+    return estimate(curDataTimeNanos, isCurDataTimeTrustable, tbf,
+                    currentTimeNanos, sinceBootTimeNanos);
+}
+
+int64_t ElapsedRealtimeEstimator::estimate(int64_t curDataTimeNanos,
+            bool isCurDataTimeTrustable, int64_t tbf,
+            int64_t currentTimeNanos, int64_t sinceBootTimeNanos) {
     //The algorithm works follow below steps:
     //When isCurDataTimeTrustable is meet (means Modem timestamp is already stable),
     //1, Wait for mFixTimeStablizationThreshold fixes; While waiting for modem time
@@ -949,35 +1275,28 @@ int64_t ElapsedRealtimeEstimator::getElapsedRealtimeEstimateNanos(int64_t curDat
     //   reset mFixTimeStablizationThreshold to default value, jump to step 2 to continue.
 
     int64_t currentTravelTimeNanos = mInitialTravelTime;
-    struct timespec currentTime;
-    int64_t sinceBootTimeNanos;
-    if (getCurrentTime(currentTime, sinceBootTimeNanos)) {
-        if (isCurDataTimeTrustable) {
-            if (tbf > 0 && tbf != curDataTimeNanos - mPrevDataTimeNanos) {
-                mFixTimeStablizationThreshold = 5;
-            }
-            int64_t currentTimeNanos = (int64_t)currentTime.tv_sec*1000000000 + currentTime.tv_nsec;
-            LOC_LOGd("sinceBootTimeNanos:%" PRIi64 " currentTimeNanos:%" PRIi64 ""
-                     " locationTimeNanos:%" PRIi64 "",
-                     sinceBootTimeNanos, currentTimeNanos, curDataTimeNanos);
-            if (mFixTimeStablizationThreshold == 0) {
-                currentTravelTimeNanos = mInitialTravelTime;
-                mCurrentClockDiff = currentTimeNanos - curDataTimeNanos - currentTravelTimeNanos;
-            } else if (mFixTimeStablizationThreshold < 0) {
-                mCurrentClockDiff = mCurrentClockDiff + (currentTimeNanos - sinceBootTimeNanos)
-                        - (mPrevUtcTimeNanos - mPrevBootTimeNanos);
-                currentTravelTimeNanos = currentTimeNanos - curDataTimeNanos - mCurrentClockDiff;
-            }
-
-            mPrevUtcTimeNanos = currentTimeNanos;
-            mPrevBootTimeNanos = sinceBootTimeNanos;
-            mPrevDataTimeNanos = curDataTimeNanos;
-            mFixTimeStablizationThreshold--;
+    if (isCurDataTimeTrustable) {
+        if (tbf > 0 && tbf != curDataTimeNanos - mPrevDataTimeNanos) {
+            mFixTimeStablizationThreshold = 5;
         }
-    } else {
-        return -1;
+        LOC_LOGv("sinceBootTimeNanos:%" PRIi64 " currentTimeNanos:%" PRIi64 ""
+                 " locationTimeNanos:%" PRIi64 "",
+                 sinceBootTimeNanos, currentTimeNanos, curDataTimeNanos);
+        if (mFixTimeStablizationThreshold == 0) {
+            currentTravelTimeNanos = mInitialTravelTime;
+            mCurrentClockDiff = currentTimeNanos - curDataTimeNanos - currentTravelTimeNanos;
+        } else if (mFixTimeStablizationThreshold < 0) {
+            mCurrentClockDiff = mCurrentClockDiff + (currentTimeNanos - sinceBootTimeNanos)
+                    - (mPrevUtcTimeNanos - mPrevBootTimeNanos);
+            currentTravelTimeNanos = currentTimeNanos - curDataTimeNanos - mCurrentClockDiff;
+        }
+
+        mPrevUtcTimeNanos = currentTimeNanos;
+        mPrevBootTimeNanos = sinceBootTimeNanos;
+        mPrevDataTimeNanos = curDataTimeNanos;
+        mFixTimeStablizationThreshold--;
     }
-    LOC_LOGd("Estimated travel time: %" PRIi64 "", currentTravelTimeNanos);
+    LOC_LOGv("Estimated travel time: %" PRIi64 "", currentTravelTimeNanos);
     return (sinceBootTimeNanos - currentTravelTimeNanos);
 }
 
@@ -990,17 +1309,19 @@ void ElapsedRealtimeEstimator::reset() {
 }
 
 int64_t ElapsedRealtimeEstimator::getElapsedRealtimeQtimer(int64_t qtimerTicksAtOrigin) {
-    struct timespec currentTime;
+    struct timespec sinceBootTime;
     int64_t sinceBootTimeNanos;
     int64_t elapsedRealTimeNanos;
 
-    if (getCurrentTime(currentTime, sinceBootTimeNanos)) {
+    // only the boot time is needed here, no CLOCK_REALTIME to read along
+    if (0 == clock_gettime(CLOCK_BOOTTIME, &sinceBootTime)) {
+       sinceBootTimeNanos = (int64_t)sinceBootTime.tv_sec * 1000000000 + sinceBootTime.tv_nsec;
        uint64_t qtimerDiff = 0;
        uint64_t qTimerTickCount = getQTimerTickCount();
        if (qTimerTickCount >= qtimerTicksAtOrigin) {
            qtimerDiff = qTimerTickCount - qtimerTicksAtOrigin;
        }
-       LOC_LOGd("sinceBootTimeNanos:%" PRIi64 " qtimerTicksAtOrigin=%" PRIi64 ""
+       LOC_LOGv("sinceBootTimeNanos:%" PRIi64 " qtimerTicksAtOrigin=%" PRIi64 ""
                 " qTimerTickCount=%" PRIi64 " qtimerDiff=%" PRIi64 "",
                 sinceBootTimeNanos, qtimerTicksAtOrigin, qTimerTickCount, qtimerDiff);
        uint64_t qTimerDiffNanos = qTimerTicksToNanos(double(qtimerDiff));
@@ -1016,7 +1337,7 @@ int64_t ElapsedRealtimeEstimator::getElapsedRealtimeQtimer(int64_t qtimerTicksAt
            }
        }
 
-       LOC_LOGd("Qtimer travel time: %" PRIi64 "", qTimerDiffNanos);
+       LOC_LOGv("Qtimer travel time: %" PRIi64 "", qTimerDiffNanos);
        if (sinceBootTimeNanos >= qTimerDiffNanos) {
            elapsedRealTimeNanos = sinceBootTimeNanos - qTimerDiffNanos;
        } else {
@@ -35,7 +35,9 @@
 #include <LocationAPI.h>
 #include <MsgTask.h>
 #include <LocSharedLock.h>
+#include <LocPositionReport.h>
 #include <log_util.h>
+#include <loc_cfg.h>
 #ifdef NO_UNORDERED_SET_OR_MAP
     #include <map>
 #else
@@ -68,7 +70,31 @@ int decodeAddress(char *addr_string, int string_size,
 #define TO_1ST_HANDLING_ADAPTER(adapters, call)                              \
     for (int i = 0; i <MAX_ADAPTERS && NULL != (adapters)[i] && !(call); i++);
 
+// The high rate reports, each delivered only to the adapters whose event mask
+// has one of the bits of that report
+enum LocApiEvtType {
+    LOC_API_EVT_TYPE_POSITION = 0,
+    LOC_API_EVT_TYPE_SV,
+    LOC_API_EVT_TYPE_NMEA,
+    LOC_API_EVT_TYPE_MEASUREMENT,
+    LOC_API_EVT_TYPE_SV_POLYNOMIAL,
+    LOC_API_EVT_TYPE_SV_EPHEMERIS,
+    LOC_API_EVT_TYPE_MAX
+};
+
+// The reports counted for the debug dump, the LocApiEvtType ones first
+enum LocApiReportType {
+    LOC_API_REPORT_DATA = LOC_API_EVT_TYPE_MAX,
+    LOC_API_REPORT_LOCATIONS,
+    LOC_API_REPORT_GEOFENCE_BREACH,
+    LOC_API_REPORT_ENGINE_DOWN,
+    LOC_API_REPORT_MAX
+};
+
 class LocAdapterBase;
+class LocAdapterListener;
+class LocApiRecorder;
+struct LocApiBaseExt;
 struct LocSsrMsg;
 struct LocOpenMsg;
 
@@ -115,6 +141,12 @@ class LocApiBase {
     static MsgTask* mMsgTask;
     static volatile int32_t mMsgTaskRefCount;
     LocAdapterBase* mLocAdapters[MAX_ADAPTERS];
+    // The state that is not in the layout the prebuilt LocApiBase subclasses
+    // are built against, see LocApiBase.cpp
+    void acquireExt();
+    void releaseExt();
+    LocApiBaseExt& getExt() const;
+    void updateEvtAdapters();
 
 protected:
     ContextBase *mContext;
@@ -125,9 +157,12 @@ protected:
     LOC_API_ADAPTER_EVENT_MASK_T getEvtMask();
     LOC_API_ADAPTER_EVENT_MASK_T mMask;
     uint32_t mNmeaMask;
+    // the capture of the engine reports, if LOC_API_CAPTURE_FILE is set
+    void setRecorder(LocApiRecorder* recorder);
     LocApiBase(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
                ContextBase* context = NULL);
     inline virtual ~LocApiBase() {
+        releaseExt();
         android_atomic_dec(&mMsgTaskRefCount);
         if (nullptr != mMsgTask && 0 == mMsgTaskRefCount) {
             delete mMsgTask;
@@ -162,10 +197,13 @@ public:
 
     void addAdapter(LocAdapterBase* adapter);
     void removeAdapter(LocAdapterBase* adapter);
+    // listener gets the LocAdapterListener events for adapter, nullptr stops them
+    void setAdapterListener(LocAdapterBase* adapter, LocAdapterListener* listener);
 
     // upward calls
     void handleEngineUpEvent();
     void handleEngineDownEvent();
+    void reportConfigChange(const char* confPath, const LocConfNames& changed);
     void reportPosition(UlpLocation& location,
                         GpsLocationExtended& locationExtended,
                         enum loc_sess_status status,
@@ -203,6 +241,8 @@ public:
     void sendNfwNotification(GnssNfwNotification& notification);
     void reportGnssConfig(uint32_t sessionId, const GnssConfig& gnssConfig);
     void reportLatencyInfo(GnssLatencyInfo& gnssLatencyInfo);
+    // appends the engine report counts, callable from any thread
+    void dumpStats(std::string& out) const;
     void reportQwesCapabilities
     (
         const std::unordered_map<LocationQwesFeatureType, bool> &featureMap
@@ -347,6 +387,33 @@ public:
                                         LocApiResponse* adapterResponse=nullptr);
 };
 
+// how long the CLOCK_REALTIME / CLOCK_BOOTTIME pair is extrapolated from the
+// QTimer before both clocks are read again
+#define ELAPSED_REALTIME_RESAMPLE_NANOS 10000000000LL
+
+// The clocks an ElapsedRealtimeEstimator estimate can be given instead of
+// reading them on every call
+class ElapsedRealtimeClock {
+private:
+    // CLOCK_REALTIME - CLOCK_BOOTTIME as last read together, with the boot
+    // time and QTimer tick it was read at; mSampleTicks is 0 until then
+    const int64_t mResampleNanos;
+    const uint64_t mQTimerFreq;
+    int64_t mSampleUtcOffsetNanos;
+    int64_t mSampleBootTimeNanos;
+    uint64_t mSampleTicks;
+public:
+    // resampleNanos 0 reads both clocks on every call
+    ElapsedRealtimeClock(int64_t resampleNanos = ELAPSED_REALTIME_RESAMPLE_NANOS);
+    // Current CLOCK_REALTIME and CLOCK_BOOTTIME in nsec. Within mResampleNanos
+    // of the last read of both, they are the boot time of that read plus the
+    // QTimer ticks since and the UTC offset of that read, which takes no
+    // syscall. Without a QTimer (x86) both clocks are read every time.
+    bool getTime(int64_t& currentTimeNanos, int64_t& sinceBootTimeNanos);
+    // read both clocks again with the next getTime
+    inline void reset() { mSampleTicks = 0; }
+};
+
 class ElapsedRealtimeEstimator {
 private:
     int64_t mCurrentClockDiff;
@@ -355,12 +422,17 @@ private:
     int64_t mFixTimeStablizationThreshold;
     int64_t mInitialTravelTime;
     int64_t mPrevDataTimeNanos;
+    int64_t estimate(int64_t curDataTimeNanos, bool isCurDataTimeTrustable, int64_t tbf,
+            int64_t currentTimeNanos, int64_t sinceBootTimeNanos);
 public:
 
     ElapsedRealtimeEstimator(int64_t travelTimeNanosEstimate):
             mInitialTravelTime(travelTimeNanosEstimate) {reset();}
     int64_t getElapsedRealtimeEstimateNanos(int64_t curDataTimeNanos,
             bool isCurDataTimeTrustable, int64_t tbf);
+    // the same estimate, with the current time from clock
+    int64_t getElapsedRealtimeEstimateNanos(int64_t curDataTimeNanos,
+            bool isCurDataTimeTrustable, int64_t tbf, ElapsedRealtimeClock& clock);
     inline int64_t getElapsedRealtimeUncNanos() { return 5000000;}
     void reset();
 
@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_LocApiReplay"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+#include <chrono>
+#include <condition_variable>
+#include <vector>
+#include <loc_cfg.h>
+#include <log_util.h>
+#include <ContextBase.h>
+#include <LocApiReplay.h>
+
+namespace loc_core {
+
+using namespace loc_util;
+using std::chrono::steady_clock;
+
+// a record longer than this is taken for a corrupt log
+#define LOC_API_LOG_MAX_PAYLOAD (1024 * 1024)
+
+struct LocApiReplayConf {
+    char captureFile[LOC_MAX_PARAM_STRING];
+    char replayFile[LOC_MAX_PARAM_STRING];
+    uint32_t speedPct;
+};
+
+static LocApiReplayConf readReplayConf() {
+    LocApiReplayConf conf = {};
+    conf.speedPct = 100;
+    const loc_param_s_type replayConfTable[] =
+    {
+        {"LOC_API_CAPTURE_FILE",     &conf.captureFile, NULL, 's'},
+        {"LOC_API_REPLAY_FILE",      &conf.replayFile,  NULL, 's'},
+        {"LOC_API_REPLAY_SPEED_PCT", &conf.speedPct,    NULL, 'n'},
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, replayConfTable);
+    return conf;
+}
+
+static const LocApiReplayConf& getReplayConf() {
+    static const LocApiReplayConf conf = readReplayConf();
+    return conf;
+}
+
+static void fillLogHeader(LocApiLogHeader& header) {
+    memset(&header, 0, sizeof(header));
+    header.magic = LOC_API_LOG_MAGIC;
+    header.version = LOC_API_LOG_VERSION;
+    header.structCount = LOC_API_LOG_STRUCT_MAX;
+    header.structSize[LOC_API_LOG_STRUCT_ULP_LOCATION] = sizeof(UlpLocation);
+    header.structSize[LOC_API_LOG_STRUCT_LOCATION_EXTENDED] = sizeof(GpsLocationExtended);
+    header.structSize[LOC_API_LOG_STRUCT_DATA_NOTIFICATION] = sizeof(GnssDataNotification);
+    header.structSize[LOC_API_LOG_STRUCT_SV_NOTIFICATION] = sizeof(GnssSvNotification);
+    header.structSize[LOC_API_LOG_STRUCT_MEASUREMENTS] = sizeof(GnssMeasurements);
+    header.structSize[LOC_API_LOG_STRUCT_SV_POLYNOMIAL] = sizeof(GnssSvPolynomial);
+}
+
+// Opens path and checks its header is the one this build writes
+static FILE* openLog(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (nullptr == file) {
+        LOC_LOGe("can't open %s: %s", path, strerror(errno));
+        return nullptr;
+    }
+
+    LocApiLogHeader header, expected;
+    fillLogHeader(expected);
+    if (1 != fread(&header, sizeof(header), 1, file)) {
+        LOC_LOGe("%s: no header", path);
+    } else if (header.magic != expected.magic || header.version != expected.version) {
+        LOC_LOGe("%s: magic 0x%x version %u, expected 0x%x version %u", path,
+                 header.magic, header.version, expected.magic, expected.version);
+    } else if (0 != memcmp(&header, &expected, sizeof(header))) {
+        LOC_LOGe("%s: captured by a build with other struct layouts", path);
+    } else {
+        return file;
+    }
+    fclose(file);
+    return nullptr;
+}
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * LocApiRecorder
+ */
+
+LocApiRecorder::LocApiRecorder(FILE* file) : mFile(file) {
+    // the high rate reports land in the buffer, each fix flushes it
+    setvbuf(mFile, nullptr, _IOFBF, 64 * 1024);
+    LocApiLogHeader header;
+    fillLogHeader(header);
+    fwrite(&header, sizeof(header), 1, mFile);
+    fflush(mFile);
+}
+
+LocApiRecorder* LocApiRecorder::get() {
+    static LocApiRecorder* recorder = []() -> LocApiRecorder* {
+        const char* path = getReplayConf().captureFile;
+        if ('\0' == path[0]) {
+            return nullptr;
+        }
+        // the replay LocApi must not capture what it replays
+        if (0 == strcmp(path, getReplayConf().replayFile)) {
+            LOC_LOGe("%s is the replay file, not capturing", path);
+            return nullptr;
+        }
+        FILE* file = fopen(path, "wb");
+        if (nullptr == file) {
+            LOC_LOGe("can't create %s: %s", path, strerror(errno));
+            return nullptr;
+        }
+        LOC_LOGi("capturing LocApi events to %s", path);
+        // never deleted, reports may come in up to the end of the process
+        return new LocApiRecorder(file);
+    }();
+    return recorder;
+}
+
+void LocApiRecorder::write(uint16_t type, uint16_t flags, const void* const* parts,
+                           const uint32_t* sizes, int count) {
+    LocApiLogRecord record = {};
+    record.type = type;
+    record.flags = flags;
+    for (int i = 0; i < count; i++) {
+        record.length += sizes[i];
+    }
+    record.timeNs = monotonicNs();
+
+    std::lock_guard<std::mutex> lock(mLock);
+    fwrite(&record, sizeof(record), 1, mFile);
+    for (int i = 0; i < count; i++) {
+        fwrite(parts[i], sizes[i], 1, mFile);
+    }
+    if (LOC_API_LOG_POSITION == type) {
+        fflush(mFile);
+    }
+}
+
+void LocApiRecorder::recordPosition(const UlpLocation& location,
+                                    const GpsLocationExtended& locationExtended,
+                                    enum loc_sess_status status, LocPosTechMask techMask,
+                                    const GnssDataNotification* pDataNotify, int msInWeek) {
+    LocApiLogPositionInfo info = {};
+    info.status = status;
+    info.techMask = techMask;
+    info.msInWeek = msInWeek;
+    const void* parts[] = { &location, &locationExtended, &info, pDataNotify };
+    const uint32_t sizes[] = { sizeof(location), sizeof(locationExtended), sizeof(info),
+                               sizeof(GnssDataNotification) };
+    write(LOC_API_LOG_POSITION, nullptr != pDataNotify ? LOC_API_LOG_FLAG_DATA : 0,
+          parts, sizes, nullptr != pDataNotify ? 4 : 3);
+}
+
+void LocApiRecorder::recordSv(const GnssSvNotification& svNotify) {
+    const void* parts[] = { &svNotify };
+    const uint32_t sizes[] = { sizeof(svNotify) };
+    write(LOC_API_LOG_SV, 0, parts, sizes, 1);
+}
+
+void LocApiRecorder::recordNmea(const char* nmea, int length) {
+    if (nullptr == nmea || length <= 0 || length > LOC_API_LOG_MAX_PAYLOAD) {
+        return;
+    }
+    const void* parts[] = { nmea };
+    const uint32_t sizes[] = { (uint32_t)length };
+    write(LOC_API_LOG_NMEA, 0, parts, sizes, 1);
+}
+
+void LocApiRecorder::recordData(const GnssDataNotification& dataNotify, int msInWeek) {
+    int32_t week = msInWeek;
+    const void* parts[] = { &dataNotify, &week };
+    const uint32_t sizes[] = { sizeof(dataNotify), sizeof(week) };
+    write(LOC_API_LOG_DATA, 0, parts, sizes, 2);
+}
+
+void LocApiRecorder::recordMeasurements(const GnssMeasurements& measurements, int msInWeek) {
+    int32_t week = msInWeek;
+    const void* parts[] = { &measurements, &week };
+    const uint32_t sizes[] = { sizeof(measurements), sizeof(week) };
+    write(LOC_API_LOG_MEASUREMENTS, 0, parts, sizes, 2);
+}
+
+void LocApiRecorder::recordSvPolynomial(const GnssSvPolynomial& svPolynomial) {
+    const void* parts[] = { &svPolynomial };
+    const uint32_t sizes[] = { sizeof(svPolynomial) };
+    write(LOC_API_LOG_SV_POLYNOMIAL, 0, parts, sizes, 1);
+}
+
+void LocApiRecorder::recordStatus(LocGpsStatusValue status) {
+    const void* parts[] = { &status };
+    const uint32_t sizes[] = { sizeof(status) };
+    write(LOC_API_LOG_STATUS, 0, parts, sizes, 1);
+}
+
+/*
+ * LocApiReplayRunner, one playback of the log on the thread of the
+ * LocApiReplay. Once interrupted it no longer touches the LocApiReplay,
+ * which may then go away while the thread winds down.
+ */
+
+class LocApiReplayRunner : public LocRunnable {
+    std::mutex mLock;
+    std::condition_variable mCond;
+    LocApiBase* mLocApi;
+    FILE* mFile;
+    const std::string mPath;
+    const uint32_t mSpeedPct;
+    std::vector<uint8_t> mPayload;
+    uint64_t mFirstTimeNs;
+    uint64_t mLastTimeNs;
+    steady_clock::time_point mStart;
+    uint32_t mEvents;
+    bool mStarted;
+    // the reports are delivered from members, some are too large for the stack
+    UlpLocation mLocation;
+    GpsLocationExtended mLocationExtended;
+    GnssDataNotification mDataNotify;
+    GnssSvNotification mSvNotify;
+    GnssMeasurements mMeasurements;
+    GnssSvPolynomial mSvPolynomial;
+
+    bool readRecord(LocApiLogRecord& record);
+    void deliver(const LocApiLogRecord& record);
+
+public:
+    LocApiReplayRunner(LocApiBase* locApi, FILE* file, const std::string& path,
+                       uint32_t speedPct) :
+        mLocApi(locApi), mFile(file), mPath(path), mSpeedPct(speedPct),
+        mFirstTimeNs(0), mLastTimeNs(0), mEvents(0), mStarted(false) {}
+    inline virtual ~LocApiReplayRunner() {
+        fclose(mFile);
+    }
+
+    virtual bool run() override;
+    virtual void postrun() override;
+    inline virtual void interrupt() override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mLocApi = nullptr;
+        mCond.notify_all();
+    }
+};
+
+bool LocApiReplayRunner::readRecord(LocApiLogRecord& record) {
+    if (1 != fread(&record, sizeof(record), 1, mFile)) {
+        return false;
+    }
+    if (record.length > LOC_API_LOG_MAX_PAYLOAD) {
+        LOC_LOGe("%s: record of %u bytes, log corrupt", mPath.c_str(), record.length);
+        return false;
+    }
+    mPayload.resize(record.length);
+    // a capture cut short by the end of its process ends in a partial record
+    return 0 == record.length || 1 == fread(mPayload.data(), record.length, 1, mFile);
+}
+
+bool LocApiReplayRunner::run() {
+    LocApiLogRecord record;
+    if (!readRecord(record)) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mLock);
+    if (!mStarted) {
+        mStarted = true;
+        mStart = steady_clock::now();
+        mFirstTimeNs = record.timeNs;
+    }
+    mLastTimeNs = record.timeNs;
+    if (mSpeedPct > 0 && record.timeNs > mFirstTimeNs) {
+        uint64_t offsetNs = (record.timeNs - mFirstTimeNs) * 100 / mSpeedPct;
+        mCond.wait_until(lock, mStart + std::chrono::nanoseconds(offsetNs),
+                         [this] { return nullptr == mLocApi; });
+    }
+    if (nullptr == mLocApi) {
+        return false;
+    }
+    // under mLock, so interrupt() returns only once the LocApi is no longer used
+    deliver(record);
+    return true;
+}
+
+void LocApiReplayRunner::deliver(const LocApiLogRecord& record) {
+    const uint8_t* payload = mPayload.data();
+    const uint32_t length = record.length;
+    int32_t msInWeek = -1;
+
+    switch (record.type) {
+    case LOC_API_LOG_POSITION: {
+        LocApiLogPositionInfo info;
+        const uint32_t size = sizeof(mLocation) + sizeof(mLocationExtended) + sizeof(info);
+        const bool hasData = (record.flags & LOC_API_LOG_FLAG_DATA) != 0;
+        if (length != size + (hasData ? sizeof(mDataNotify) : 0)) {
+            break;
+        }
+        memcpy(&mLocation, payload, sizeof(mLocation));
+        payload += sizeof(mLocation);
+        memcpy(&mLocationExtended, payload, sizeof(mLocationExtended));
+        payload += sizeof(mLocationExtended);
+        memcpy(&info, payload, sizeof(info));
+        payload += sizeof(info);
+        if (hasData) {
+            memcpy(&mDataNotify, payload, sizeof(mDataNotify));
+        }
+        mLocApi->reportPosition(mLocation, mLocationExtended, (loc_sess_status)info.status,
+                                info.techMask, hasData ? &mDataNotify : nullptr,
+                                info.msInWeek);
+        mEvents++;
+        break;
+    }
+    case LOC_API_LOG_SV:
+        if (length == sizeof(mSvNotify)) {
+            memcpy(&mSvNotify, payload, sizeof(mSvNotify));
+            mLocApi->reportSv(mSvNotify);
+            mEvents++;
+        }
+        break;
+    case LOC_API_LOG_NMEA: {
+        // the adapters take the sentences as a string
+        std::string nmea((const char*)payload, length);
+        mLocApi->reportNmea(nmea.c_str(), (int)nmea.length());
+        mEvents++;
+        break;
+    }
+    case LOC_API_LOG_DATA:
+        if (length == sizeof(mDataNotify) + sizeof(msInWeek)) {
+            memcpy(&mDataNotify, payload, sizeof(mDataNotify));
+            memcpy(&msInWeek, payload + sizeof(mDataNotify), sizeof(msInWeek));
+            mLocApi->reportData(mDataNotify, msInWeek);
+            mEvents++;
+        }
+        break;
+    case LOC_API_LOG_MEASUREMENTS:
+        if (length == sizeof(mMeasurements) + sizeof(msInWeek)) {
+            memcpy(&mMeasurements, payload, sizeof(mMeasurements));
+            memcpy(&msInWeek, payload + sizeof(mMeasurements), sizeof(msInWeek));
+            mLocApi->reportGnssMeasurements(mMeasurements, msInWeek);
+            mEvents++;
+        }
+        break;
+    case LOC_API_LOG_SV_POLYNOMIAL:
+        if (length == sizeof(mSvPolynomial)) {
+            memcpy(&mSvPolynomial, payload, sizeof(mSvPolynomial));
+            mLocApi->reportSvPolynomial(mSvPolynomial);
+            mEvents++;
+        }
+        break;
+    case LOC_API_LOG_STATUS: {
+        LocGpsStatusValue status;
+        if (length == sizeof(status)) {
+            memcpy(&status, payload, sizeof(status));
+            mLocApi->reportStatus(status);
+            mEvents++;
+        }
+        break;
+    }
+    default:
+        // a record type of a later build of the same version, skip it
+        break;
+    }
+}
+
+void LocApiReplayRunner::postrun() {
+    std::lock_guard<std::mutex> lock(mLock);
+    uint64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            steady_clock::now() - mStart).count();
+    uint64_t capturedUs = (mLastTimeNs - mFirstTimeNs) / 1000;
+    LOC_LOGi("%s: replayed %u events of %" PRIu64 " ms in %" PRIu64 " ms, "
+             "%" PRIu64 " events/s%s", mPath.c_str(), mEvents, capturedUs / 1000,
+             elapsedUs / 1000, elapsedUs > 0 ? (uint64_t)mEvents * 1000000 / elapsedUs : 0,
+             nullptr == mLocApi ? ", stopped" : "");
+}
+
+/*
+ * LocApiReplay
+ */
+
+LocApiReplay::LocApiReplay(LOC_API_ADAPTER_EVENT_MASK_T exMask, ContextBase* context,
+                           const char* path, uint32_t speedPct) :
+    LocApiBase(exMask, context), mPath(path), mSpeedPct(speedPct)
+{
+    setRecorder(nullptr);
+}
+
+LocApiReplay::~LocApiReplay() {
+    stopPlayback();
+}
+
+LocApiBase* LocApiReplay::create(LOC_API_ADAPTER_EVENT_MASK_T exMask, ContextBase* context) {
+    const LocApiReplayConf& conf = getReplayConf();
+    if ('\0' == conf.replayFile[0]) {
+        return nullptr;
+    }
+    FILE* file = openLog(conf.replayFile);
+    if (nullptr == file) {
+        return nullptr;
+    }
+    fclose(file);
+    LOC_LOGi("replaying LocApi events of %s at %u%%", conf.replayFile, conf.speedPct);
+    return new LocApiReplay(exMask, context, conf.replayFile, conf.speedPct);
+}
+
+void LocApiReplay::stopPlayback() {
+    if (nullptr != mRunner) {
+        mThread.stop();
+        mRunner->interrupt();
+        mRunner = nullptr;
+    }
+}
+
+enum loc_api_adapter_err LocApiReplay::close() {
+    stopPlayback();
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+void LocApiReplay::startFix(const LocPosMode& /*fixCriteria*/, LocApiResponse* adapterResponse) {
+    // a new session replays the log from its start
+    stopPlayback();
+    FILE* file = openLog(mPath.c_str());
+    LocationError err = LOCATION_ERROR_GENERAL_FAILURE;
+    if (nullptr != file) {
+        mRunner = std::make_shared<LocApiReplayRunner>(this, file, mPath, mSpeedPct);
+        if (mThread.start("LocApiReplay", mRunner)) {
+            err = LOCATION_ERROR_SUCCESS;
+        } else {
+            mRunner = nullptr;
+        }
+    }
+    if (nullptr != adapterResponse) {
+        adapterResponse->returnToSender(err);
+    }
+}
+
+void LocApiReplay::stopFix(LocApiResponse* adapterResponse) {
+    stopPlayback();
+    if (nullptr != adapterResponse) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    }
+}
+
+} // namespace loc_core
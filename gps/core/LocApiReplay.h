@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef LOC_API_REPLAY_H
+#define LOC_API_REPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <mutex>
+#include <string>
+#include <LocApiBase.h>
+#include <LocThread.h>
+
+/*
+ * Capture and replay of the events entering LocApiBase.
+ *
+ * With LOC_API_CAPTURE_FILE set in gps.conf, the position, SV, NMEA, data,
+ * measurement, SV polynomial and status reports LocApiBase gets from the
+ * engine are appended to that file. With LOC_API_REPLAY_FILE set, the HAL
+ * uses LocApiReplay in place of the modem LocApi, which feeds such a file
+ * back into the adapters between startFix and stopFix, so the adapter and
+ * HIDL layers can be benchmarked without a modem.
+ *
+ * The file is a LocApiLogHeader followed by records, each a LocApiLogRecord
+ * and its payload. Payloads are the raw structs, so a log only replays on a
+ * build with the same struct layouts, which the header records.
+ */
+
+namespace loc_core {
+
+#define LOC_API_LOG_MAGIC   0x4950414cU /* "LAPI" */
+#define LOC_API_LOG_VERSION 1
+
+enum LocApiLogType {
+    // UlpLocation, GpsLocationExtended, LocApiLogPositionInfo
+    // [, GnssDataNotification with LOC_API_LOG_FLAG_DATA]
+    LOC_API_LOG_POSITION = 0,
+    // GnssSvNotification
+    LOC_API_LOG_SV,
+    // the sentences, not NUL terminated
+    LOC_API_LOG_NMEA,
+    // GnssDataNotification, int32_t msInWeek
+    LOC_API_LOG_DATA,
+    // GnssMeasurements, int32_t msInWeek
+    LOC_API_LOG_MEASUREMENTS,
+    // GnssSvPolynomial
+    LOC_API_LOG_SV_POLYNOMIAL,
+    // LocGpsStatusValue
+    LOC_API_LOG_STATUS,
+    LOC_API_LOG_TYPE_MAX
+};
+
+#define LOC_API_LOG_FLAG_DATA 0x1
+
+// the structs whose sizeof() the header records
+enum LocApiLogStruct {
+    LOC_API_LOG_STRUCT_ULP_LOCATION = 0,
+    LOC_API_LOG_STRUCT_LOCATION_EXTENDED,
+    LOC_API_LOG_STRUCT_DATA_NOTIFICATION,
+    LOC_API_LOG_STRUCT_SV_NOTIFICATION,
+    LOC_API_LOG_STRUCT_MEASUREMENTS,
+    LOC_API_LOG_STRUCT_SV_POLYNOMIAL,
+    LOC_API_LOG_STRUCT_MAX
+};
+
+struct LocApiLogHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t structCount;
+    uint32_t structSize[LOC_API_LOG_STRUCT_MAX];
+};
+
+struct LocApiLogRecord {
+    uint16_t type;
+    uint16_t flags;
+    // of the payload following the record
+    uint32_t length;
+    // CLOCK_MONOTONIC of the capture
+    uint64_t timeNs;
+};
+
+struct LocApiLogPositionInfo {
+    int32_t status;
+    uint32_t techMask;
+    int32_t msInWeek;
+};
+
+class LocApiRecorder {
+    std::mutex mLock;
+    FILE* mFile;
+    LocApiRecorder(FILE* file);
+    void write(uint16_t type, uint16_t flags, const void* const* parts,
+               const uint32_t* sizes, int count);
+public:
+    // The recorder of the process, nullptr if LOC_API_CAPTURE_FILE is not
+    // set or the file can't be created
+    static LocApiRecorder* get();
+
+    void recordPosition(const UlpLocation& location,
+                        const GpsLocationExtended& locationExtended,
+                        enum loc_sess_status status, LocPosTechMask techMask,
+                        const GnssDataNotification* pDataNotify, int msInWeek);
+    void recordSv(const GnssSvNotification& svNotify);
+    void recordNmea(const char* nmea, int length);
+    void recordData(const GnssDataNotification& dataNotify, int msInWeek);
+    void recordMeasurements(const GnssMeasurements& measurements, int msInWeek);
+    void recordSvPolynomial(const GnssSvPolynomial& svPolynomial);
+    void recordStatus(LocGpsStatusValue status);
+};
+
+class LocApiReplayRunner;
+
+// LocApi playing back a LOC_API_CAPTURE_FILE log. Every fix session replays
+// the log from its start, at LOC_API_REPLAY_SPEED_PCT percent of the captured
+// pace, 0 for as fast as the adapters take it. The throughput of each run is
+// logged when it ends.
+class LocApiReplay : public LocApiBase {
+    const std::string mPath;
+    const uint32_t mSpeedPct;
+    std::shared_ptr<LocApiReplayRunner> mRunner;
+    loc_util::LocThread mThread;
+
+    LocApiReplay(LOC_API_ADAPTER_EVENT_MASK_T exMask, ContextBase* context,
+                 const char* path, uint32_t speedPct);
+    void stopPlayback();
+
+protected:
+    virtual enum loc_api_adapter_err close() override;
+    virtual ~LocApiReplay();
+
+public:
+    // The replay LocApi if LOC_API_REPLAY_FILE is set and holds a log this
+    // build can play, nullptr otherwise
+    static LocApiBase* create(LOC_API_ADAPTER_EVENT_MASK_T exMask,
+                              ContextBase* context);
+
+    virtual void startFix(const LocPosMode& fixCriteria,
+                          LocApiResponse* adapterResponse) override;
+    virtual void stopFix(LocApiResponse* adapterResponse) override;
+};
+
+} // namespace loc_core
+
+#endif // LOC_API_REPLAY_H
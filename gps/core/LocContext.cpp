@@ -29,7 +29,6 @@
 #define LOG_NDEBUG 0
 #define LOG_TAG "LocSvc_Ctx"
 
-#include <cutils/sched_policy.h>
 #include <unistd.h>
 #include <LocContext.h>
 #include <msg_q.h>
@@ -53,7 +52,7 @@ pthread_mutex_t LocContext::mGetLocContextMutex = PTHREAD_MUTEX_INITIALIZER;
 const MsgTask* LocContext::getMsgTask(const char* name)
 {
     if (NULL == mMsgTask) {
-        mMsgTask = new MsgTask(name);
+        mMsgTask = new MsgTask(name, eMSG_Q_TYPE_RING);
     }
     return mMsgTask;
 }
@@ -64,6 +63,8 @@ ContextBase* LocContext::getLocContext(const char* name)
     LOC_LOGD("%s:%d]: querying ContextBase with tCreator", __func__, __LINE__);
     if (NULL == mContext) {
         LOC_LOGD("%s:%d]: creating msgTask with tCreator", __func__, __LINE__);
+        // the LBS proxy, LocApi and data item libraries load side by side
+        ContextBase::preloadLibraries(mLBSLibName);
         const MsgTask* msgTask = getMsgTask(name);
         mContext = new LocContext(msgTask);
     }
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// loc_elapsed_realtime_bench - cost per call and jitter of the
+// ElapsedRealtimeEstimator estimate on an ElapsedRealtimeClock, reading both
+// clocks on every call (resample 0, as the estimate does without one) and with
+// the default ELAPSED_REALTIME_RESAMPLE_NANOS.
+//
+// usage: loc_elapsed_realtime_bench [-n calls] [-p paced calls] [-i interval usec]
+//
+// The cost is the mean over n calls back to back. The jitter runs paced
+// calls on a simulated fix stream, 50 msec behind UTC, and reports the
+// spread of the estimate against CLOCK_BOOTTIME read right after it, plus
+// how far the calibrated boot time is off the real one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <LocApiBase.h>
+#include <loc_misc_utils.h>
+
+using loc_core::ElapsedRealtimeClock;
+using loc_core::ElapsedRealtimeEstimator;
+
+#define BENCH_TRAVEL_TIME_NANOS 50000000LL
+
+static int64_t clockNanos(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct BenchSpread {
+    uint64_t mCount;
+    double mSum;
+    double mSumSquares;
+    int64_t mMaxAbs;
+    inline BenchSpread() : mCount(0), mSum(0), mSumSquares(0), mMaxAbs(0) {}
+    inline void add(int64_t value) {
+        mCount++;
+        mSum += value;
+        mSumSquares += (double)value * value;
+        if (llabs(value) > mMaxAbs) {
+            mMaxAbs = llabs(value);
+        }
+    }
+    inline double mean() const { return mCount ? mSum / mCount : 0.0; }
+    inline double stddev() const {
+        double m = mean();
+        return mCount ? sqrt(fmax(0.0, mSumSquares / mCount - m * m)) : 0.0;
+    }
+};
+
+static void runBench(const char* name, int64_t resampleNanos,
+                     uint32_t calls, uint32_t pacedCalls, uint32_t intervalUs) {
+    ElapsedRealtimeEstimator estimator(BENCH_TRAVEL_TIME_NANOS);
+    ElapsedRealtimeClock rtClock(resampleNanos);
+
+    int64_t startNs = clockNanos(CLOCK_MONOTONIC);
+    int64_t sink = 0;
+    for (uint32_t i = 0; i < calls; i++) {
+        int64_t dataTimeNanos = clockNanos(CLOCK_REALTIME) - BENCH_TRAVEL_TIME_NANOS;
+        sink += estimator.getElapsedRealtimeEstimateNanos(dataTimeNanos, true, 0, rtClock);
+    }
+    int64_t loopNs = clockNanos(CLOCK_MONOTONIC) - startNs;
+    // the data time of each call costs one clock read, take it out
+    startNs = clockNanos(CLOCK_MONOTONIC);
+    for (uint32_t i = 0; i < calls; i++) {
+        sink += clockNanos(CLOCK_REALTIME);
+    }
+    int64_t dataNs = clockNanos(CLOCK_MONOTONIC) - startNs;
+
+    BenchSpread estimate, calibration;
+    estimator.reset();
+    rtClock.reset();
+    for (uint32_t i = 0; i < pacedCalls; i++) {
+        int64_t dataTimeNanos = clockNanos(CLOCK_REALTIME) - BENCH_TRAVEL_TIME_NANOS;
+        int64_t elapsed = estimator.getElapsedRealtimeEstimateNanos(dataTimeNanos, true, 0, rtClock);
+        int64_t bootNanos = clockNanos(CLOCK_BOOTTIME);
+        // the first fixes go by the default travel time, leave them out
+        if (i >= 10) {
+            estimate.add(bootNanos - elapsed - BENCH_TRAVEL_TIME_NANOS);
+        }
+        int64_t currentNanos, calibratedBootNanos;
+        if (rtClock.getTime(currentNanos, calibratedBootNanos)) {
+            calibration.add(calibratedBootNanos - clockNanos(CLOCK_BOOTTIME));
+        }
+        usleep(intervalUs);
+    }
+
+    printf("%s (resample %" PRIi64 " ms):\n", name, resampleNanos / 1000000);
+    printf("  cost:        %.1f ns/call\n",
+           calls ? (double)(loopNs - dataNs) / calls : 0.0);
+    printf("  estimate:    error mean %.0f ns, stddev %.0f ns, max %" PRIi64 " ns\n",
+           estimate.mean(), estimate.stddev(), estimate.mMaxAbs);
+    printf("  calibration: boot time off by mean %.0f ns, max %" PRIi64 " ns\n",
+           calibration.mean(), calibration.mMaxAbs);
+    if (0 == sink) {
+        printf("\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t calls = 1000000;
+    uint32_t pacedCalls = 2000;
+    uint32_t intervalUs = 1000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:i:")) != -1) {
+        switch (opt) {
+            case 'n': calls = strtoul(optarg, nullptr, 0); break;
+            case 'p': pacedCalls = strtoul(optarg, nullptr, 0); break;
+            case 'i': intervalUs = strtoul(optarg, nullptr, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n calls] [-p paced calls] [-i interval usec]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    if (0 == getQTimerFreq()) {
+        printf("no QTimer on this CPU, both runs read the clocks every call\n");
+    }
+    runBench("clocks every call", 0, calls, pacedCalls, intervalUs);
+    runBench("QTimer calibrated", ELAPSED_REALTIME_RESAMPLE_NANOS, calls, pacedCalls,
+             intervalUs);
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOC_POSITION_REPORT_H
+#define LOC_POSITION_REPORT_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <gps_extended.h>
+
+// engine positions in flight between the LocApi thread, the adapters and the engine hub
+#define LOC_POSITION_REPORT_POOL_SIZE 4
+
+namespace loc_core {
+
+// An engine position as LocApiBase::reportPosition makes it, once, for all the
+// adapters subscribed to positions. It is not changed after it is handed out,
+// an adapter or the engine hub that needs it past the call keeps a reference
+// instead of copying the UlpLocation / GpsLocationExtended pair.
+struct LocPositionReport {
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    enum loc_sess_status status;
+};
+typedef std::shared_ptr<const LocPositionReport> LocPositionReportPtr;
+
+// Ring of reports, each reused once all its owners have let go of it, so a
+// high rate session does not allocate one per fix. Only to be used by one
+// thread, the one reporting the positions.
+template <uint32_t SIZE>
+class LocPositionReportPool {
+    std::shared_ptr<LocPositionReport> mReports[SIZE];
+    uint32_t mNext;
+public:
+    inline LocPositionReportPool() : mNext(0) {}
+
+    inline LocPositionReportPtr make(const UlpLocation& location,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status) {
+        std::shared_ptr<LocPositionReport>& report = mReports[mNext];
+        mNext = (mNext + 1) % SIZE;
+        if (nullptr != report && 1 == report.use_count()) {
+            // pairs with the release of the last other owner dropping its reference
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } else {
+            // still held by a queued msg or the engine hub, leave it to them
+            report = std::make_shared<LocPositionReport>();
+        }
+        report->location = location;
+        report->locationExtended = locationExtended;
+        report->status = status;
+        return report;
+    }
+};
+
+} // namespace loc_core
+
+#endif // LOC_POSITION_REPORT_H
@@ -37,6 +37,7 @@
 #include <loc_pla.h>
 #include <log_util.h>
 #include <loc_nmea.h>
+#include <loc_misc_utils.h>
 #include <DataItemsFactoryProxy.h>
 #include <SystemStatus.h>
 #include <SystemStatusOsObserver.h>
@@ -51,44 +52,55 @@ namespace loc_core
 class SystemStatusNmeaBase
 {
 protected:
-    std::vector<std::string> mField;
-
-    SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
+    // Fields are kept as offsets into the caller's sentence, which must
+    // outlive the parser. Every field ends at the next ',' or at the '*'
+    // of the checksum, both of which stop atoi/atof/strtol, so the fields
+    // are parsed in place without being copied or terminated.
+    SystemStatusNmeaBase(const char *str_in, uint32_t len_in) :
+        mStr(str_in), mFieldCount(0)
     {
         // check size and talker
         if (!loc_nmea_is_debug(str_in, len_in)) {
             return;
         }
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
-
         // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+        size_t len = strnlen(str_in, NMEA_MAXSIZE);
+        const char* star = (const char*)memchr(str_in, '*', len);
+        if (nullptr == star) {
             return;
         }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
+
+        // tokenize, the checksum '*' counting as one more ',' delimiter
+        uint32_t start = 0;
+        for (uint32_t i = 0; i < len && mFieldCount < NMEA_MAX_FIELDS; i++) {
+            if (',' == str_in[i] || star == str_in + i) {
+                mFieldOffset[mFieldCount++] = start;
+                start = i + 1;
             }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
         }
     }
 
     virtual ~SystemStatusNmeaBase() { }
 
+    inline uint32_t fieldCount() const { return mFieldCount; }
+    inline const char* field(uint32_t index) const { return mStr + mFieldOffset[index]; }
+
 public:
     static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
     static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // enough for the longest sentence, PQWP7 with 2 + SV_ALL_NUM*3 fields
+    static const uint32_t NMEA_MAX_FIELDS = 512;
+
+private:
+    const char* mStr;
+    uint32_t mFieldCount;
+    uint16_t mFieldOffset[NMEA_MAX_FIELDS];
 };
+static_assert(SystemStatusNmeaBase::NMEA_MAX_FIELDS >= 2 + SV_ALL_NUM*3,
+              "NMEA_MAX_FIELDS too small for PQWP7");
+static_assert(SystemStatusNmeaBase::NMEA_MAXSIZE <= UINT16_MAX,
+              "NMEA field offsets are 16 bit");
 
 /******************************************************************************
  SystemStatusPQWM1
@@ -209,47 +221,47 @@ public:
         : SystemStatusNmeaBase(str_in, len_in)
     {
         memset(&mM1, 0, sizeof(mM1));
-        if (mField.size() <= eMax0) {
-            LOC_LOGE("PQWM1parser - invalid size=%zu", mField.size());
+        if (fieldCount() <= eMax0) {
+            LOC_LOGE("PQWM1parser - invalid size=%u", fieldCount());
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
-        if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+        mM1.mGpsWeek = atoi(field(eGpsWeek));
+        mM1.mGpsTowMs = atoi(field(eGpsTowMs));
+        mM1.mTimeValid = atoi(field(eTimeValid));
+        mM1.mTimeSource = atoi(field(eTimeSource));
+        mM1.mTimeUnc = atoi(field(eTimeUnc));
+        mM1.mClockFreqBias = atoi(field(eClockFreqBias));
+        mM1.mClockFreqBiasUnc = atoi(field(eClockFreqBiasUnc));
+        mM1.mXoState = atoi(field(eXoState));
+        mM1.mPgaGain = atoi(field(ePgaGain));
+        mM1.mGpsBpAmpI = atoi(field(eGpsBpAmpI));
+        mM1.mGpsBpAmpQ = atoi(field(eGpsBpAmpQ));
+        mM1.mAdcI = atoi(field(eAdcI));
+        mM1.mAdcQ = atoi(field(eAdcQ));
+        mM1.mJammerGps = atoi(field(eJammerGps));
+        mM1.mJammerGlo = atoi(field(eJammerGlo));
+        mM1.mJammerBds = atoi(field(eJammerBds));
+        mM1.mJammerGal = atoi(field(eJammerGal));
+        mM1.mRecErrorRecovery = atoi(field(eRecErrorRecovery));
+        mM1.mAgcGps = atof(field(eAgcGps));
+        mM1.mAgcGlo = atof(field(eAgcGlo));
+        mM1.mAgcBds = atof(field(eAgcBds));
+        mM1.mAgcGal = atof(field(eAgcGal));
+        if (fieldCount() > eLeapSecUnc) {
+            mM1.mLeapSeconds = atoi(field(eLeapSeconds));
+            mM1.mLeapSecUnc = atoi(field(eLeapSecUnc));
         }
-        if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
+        if (fieldCount() > eGalBpAmpQ) {
+            mM1.mGloBpAmpI = atoi(field(eGloBpAmpI));
+            mM1.mGloBpAmpQ = atoi(field(eGloBpAmpQ));
+            mM1.mBdsBpAmpI = atoi(field(eBdsBpAmpI));
+            mM1.mBdsBpAmpQ = atoi(field(eBdsBpAmpQ));
+            mM1.mGalBpAmpI = atoi(field(eGalBpAmpI));
+            mM1.mGalBpAmpQ = atoi(field(eGalBpAmpQ));
         }
-        if (mField.size() > eTimeUncNs) {
-            mM1.mTimeUncNs = strtoull(mField[eTimeUncNs].c_str(), nullptr, 10);
+        if (fieldCount() > eTimeUncNs) {
+            mM1.mTimeUncNs = strtoull(field(eTimeUncNs), nullptr, 10);
         }
     }
 
@@ -301,17 +313,17 @@ public:
     SystemStatusPQWP1parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = strtol(field(eEpiValidity), NULL, 16);
+        mP1.mEpiLat = atof(field(eEpiLat));
+        mP1.mEpiLon = atof(field(eEpiLon));
+        mP1.mEpiAlt = atof(field(eEpiAlt));
+        mP1.mEpiHepe = atoi(field(eEpiHepe));
+        mP1.mEpiAltUnc = atof(field(eEpiAltUnc));
+        mP1.mEpiSrc = atoi(field(eEpiSrc));
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -356,15 +368,15 @@ public:
     SystemStatusPQWP2parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = atof(field(eBestLat));
+        mP2.mBestLon = atof(field(eBestLon));
+        mP2.mBestAlt = atof(field(eBestAlt));
+        mP2.mBestHepe = atof(field(eBestHepe));
+        mP2.mBestAltUnc = atof(field(eBestAltUnc));
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -432,22 +444,22 @@ public:
     SystemStatusPQWP3parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             return;
         }
         memset(&mP3, 0, sizeof(mP3));
         // todo: update for navic once available
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = strtol(field(eXtraValidMask), NULL, 16);
+        mP3.mGpsXtraAge = atoi(field(eGpsXtraAge));
+        mP3.mGloXtraAge = atoi(field(eGloXtraAge));
+        mP3.mBdsXtraAge = atoi(field(eBdsXtraAge));
+        mP3.mGalXtraAge = atoi(field(eGalXtraAge));
+        mP3.mQzssXtraAge = atoi(field(eQzssXtraAge));
+        mP3.mGpsXtraValid = strtol(field(eGpsXtraValid), NULL, 16);
+        mP3.mGloXtraValid = strtol(field(eGloXtraValid), NULL, 16);
+        mP3.mBdsXtraValid = strtol(field(eBdsXtraValid), NULL, 16);
+        mP3.mGalXtraValid = strtol(field(eGalXtraValid), NULL, 16);
+        mP3.mQzssXtraValid = strtol(field(eQzssXtraValid), NULL, 16);
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -492,15 +504,15 @@ public:
     SystemStatusPQWP4parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = strtol(field(eGpsEpheValid), NULL, 16);
+        mP4.mGloEpheValid = strtol(field(eGloEpheValid), NULL, 16);
+        mP4.mBdsEpheValid = strtol(field(eBdsEpheValid), NULL, 16);
+        mP4.mGalEpheValid = strtol(field(eGalEpheValid), NULL, 16);
+        mP4.mQzssEpheValid = strtol(field(eQzssEpheValid), NULL, 16);
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -582,26 +594,26 @@ public:
     SystemStatusPQWP5parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             return;
         }
         memset(&mP5, 0, sizeof(mP5));
         // todo: update for navic once available
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = strtol(field(eGpsUnknownMask), NULL, 16);
+        mP5.mGloUnknownMask = strtol(field(eGloUnknownMask), NULL, 16);
+        mP5.mBdsUnknownMask = strtol(field(eBdsUnknownMask), NULL, 16);
+        mP5.mGalUnknownMask = strtol(field(eGalUnknownMask), NULL, 16);
+        mP5.mQzssUnknownMask = strtol(field(eQzssUnknownMask), NULL, 16);
+        mP5.mGpsGoodMask = strtol(field(eGpsGoodMask), NULL, 16);
+        mP5.mGloGoodMask = strtol(field(eGloGoodMask), NULL, 16);
+        mP5.mBdsGoodMask = strtol(field(eBdsGoodMask), NULL, 16);
+        mP5.mGalGoodMask = strtol(field(eGalGoodMask), NULL, 16);
+        mP5.mQzssGoodMask = strtol(field(eQzssGoodMask), NULL, 16);
+        mP5.mGpsBadMask = strtol(field(eGpsBadMask), NULL, 16);
+        mP5.mGloBadMask = strtol(field(eGloBadMask), NULL, 16);
+        mP5.mBdsBadMask = strtol(field(eBdsBadMask), NULL, 16);
+        mP5.mGalBadMask = strtol(field(eGalBadMask), NULL, 16);
+        mP5.mQzssBadMask = strtol(field(eQzssBadMask), NULL, 16);
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -634,11 +646,11 @@ public:
     SystemStatusPQWP6parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = strtol(field(eFixInfoMask), NULL, 16);
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -670,20 +682,20 @@ public:
         : SystemStatusNmeaBase(str_in, len_in)
     {
         uint32_t svLimit = SV_ALL_NUM;
-        if (mField.size() < eMin) {
-            LOC_LOGE("PQWP7parser - invalid size=%zu", mField.size());
+        if (fieldCount() < eMin) {
+            LOC_LOGE("PQWP7parser - invalid size=%u", fieldCount());
             return;
         }
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             // Try reducing limit, accounting for possibly missing NAVIC support
             svLimit = SV_ALL_NUM_MIN;
         }
 
         memset(mP7.mNav, 0, sizeof(mP7.mNav));
         for (uint32_t i=0; i<svLimit; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(atoi(field(i*3+2)));
+            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(field(i*3+3)));
+            mP7.mNav[i].mAgeSec = atoi(field(i*3+4));
         }
     }
 
@@ -720,12 +732,12 @@ public:
     SystemStatusPQWS1parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (fieldCount() < eMax) {
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = atoi(field(eFixInfoMask));
+        mS1.mHepeLimit = atoi(field(eHepeLimit));
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1261,6 +1273,105 @@ void SystemStatusLocation::dump()
 ******************************************************************************/
 pthread_mutex_t   SystemStatus::mMutexSystemStatus = PTHREAD_MUTEX_INITIALIZER;
 SystemStatus*     SystemStatus::mInstance = NULL;
+uint64_t          SystemStatus::mLockedAtNs = 0;
+loc_util::LocHistogram SystemStatus::mLockWaitUs;
+loc_util::LocHistogram SystemStatus::mLockHoldUs;
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void SystemStatus::lockCache()
+{
+    uint64_t startNs = monotonicNs();
+    pthread_mutex_lock(&mMutexSystemStatus);
+    mLockedAtNs = monotonicNs();
+    mLockWaitUs.record((mLockedAtNs - startNs) / 1000);
+}
+
+void SystemStatus::unlockCache()
+{
+    mLockHoldUs.record((monotonicNs() - mLockedAtNs) / 1000);
+    pthread_mutex_unlock(&mMutexSystemStatus);
+}
+
+void SystemStatus::dumpStats(std::string& out)
+{
+    out += "SystemStatus cache lock:\n  wait: ";
+    mLockWaitUs.dump(out, "us");
+    out += "\n  hold: ";
+    mLockHoldUs.dump(out, "us");
+    out += "\n";
+}
+
+/******************************************************************************
+ SystemStatusLocationTrack
+******************************************************************************/
+void SystemStatusLocationTrack::append(const UlpLocation& location, uint64_t bootTimeMs)
+{
+    // the boot time does not go back, keep the ring sorted if a clock read did
+    if (!empty() && bootTimeMs < back().mBootTimeMs) {
+        bootTimeMs = back().mBootTimeMs;
+    }
+    while (!empty() && front().mBootTimeMs + SYSTEM_STATUS_TRACK_WINDOW_MS < bootTimeMs) {
+        pop_front();
+    }
+
+    SystemStatusTrackFix& fix = emplace_back();
+    fix.mBootTimeMs = bootTimeMs;
+    fix.mUtcTimeMs = location.gpsLocation.timestamp;
+    fix.mLatitude = location.gpsLocation.latitude;
+    fix.mLongitude = location.gpsLocation.longitude;
+    fix.mAltitude = (float)location.gpsLocation.altitude;
+    fix.mAccuracy = location.gpsLocation.accuracy;
+    fix.mSpeed = location.gpsLocation.speed;
+    fix.mBearing = location.gpsLocation.bearing;
+    fix.mFlags = location.gpsLocation.flags;
+}
+
+uint32_t SystemStatusLocationTrack::lowerBound(uint64_t bootTimeMs) const
+{
+    uint32_t low = 0;
+    uint32_t high = size();
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if ((*this)[mid].mBootTimeMs < bootTimeMs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool SystemStatus::getRecentTrackFix(uint64_t maxAgeMs, SystemStatusTrackFix& fix) const
+{
+    bool found = false;
+    uint64_t nowMs = getBootTimeMilliSec();
+    lockCache();
+    if (!mTrack.empty() && mTrack.back().mBootTimeMs + maxAgeMs >= nowMs) {
+        fix = mTrack.back();
+        found = true;
+    }
+    unlockCache();
+    return found;
+}
+
+void SystemStatus::dumpTrack(std::string& out) const
+{
+    uint32_t count = 0;
+    uint64_t spanMs = 0;
+    lockCache();
+    count = mTrack.size();
+    if (count > 0) {
+        spanMs = mTrack.back().mBootTimeMs - mTrack.front().mBootTimeMs;
+    }
+    unlockCache();
+    out += "SystemStatus location track: " + std::to_string(count) + " fixes over " +
+            std::to_string(spanMs / 1000) + " s\n";
+}
 
 SystemStatus* SystemStatus::getInstance(const MsgTask* msgTask)
 {
@@ -1301,7 +1412,8 @@ IOsObserver* SystemStatus::getOsObserver()
 }
 
 SystemStatus::SystemStatus(const MsgTask* msgTask) :
-    mSysStatusObsvr(this, msgTask)
+    mSysStatusObsvr(this, msgTask),
+    mGeneration(0)
 {
     int result = 0;
     ENTRY_LOG ();
@@ -1358,26 +1470,33 @@ bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
         return false;
     }
     if (!report.empty() && report.back().equals(static_cast<TYPE_ITEM&>(s.collate(report.back())))) {
-        // there is no change - just update reported timestamp
+        // there is no change - just update reported timestamp, the published
+        // copy keeps the time of the last change rather than being copied again
         report.back().mUtcReported = s.mUtcReported;
         return false;
     }
 
-    // first event or updated
-    report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
+    // first event or updated, replaces the oldest once the history is full
+    report.push_back(std::forward<TYPE_ITEM>(s));
+    report.publish();
+    mGeneration.fetch_add(1, std::memory_order_release);
     return true;
 }
 
+template <typename TYPE_REPORT, typename TYPE_ITEM>
+void SystemStatus::setNmeaItem(TYPE_REPORT& report, TYPE_ITEM&& s)
+{
+    lockCache();
+    setIteminReport(report, std::forward<TYPE_ITEM>(s));
+    unlockCache();
+}
+
 template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
+    report.publish();
+    mGeneration.fetch_add(1, std::memory_order_release);
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
@@ -1398,62 +1517,69 @@ void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) c
 
 @return     true when the NMEA is consumed by the method.
 ******************************************************************************/
+// debug sentences are "$PQW" followed by a 2 character type
+#define PQW_TAG(a, b) ((uint16_t)(((uint8_t)(a) << 8) | (uint8_t)(b)))
+
 bool SystemStatus::setNmeaString(const char *data, uint32_t len)
 {
     if (!loc_nmea_is_debug(data, len)) {
         return false;
     }
 
-    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
-    strlcpy(buf, data, sizeof(buf));
-
-    pthread_mutex_lock(&mMutexSystemStatus);
-
-    // parse the received nmea strings here
-    if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
-        setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
-        setIteminReport(mCache.mXoState, SystemStatusXoState(s));
-        setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
-        setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
-    }
-    else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mInjectedPosition,
-                SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mBestPosition,
-                SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()));
+    // parse the received nmea strings here, in place and without the lock,
+    // which is only needed to insert the results into the cache
+    switch (PQW_TAG(data[4], data[5])) {
+    case PQW_TAG('M', '1'): {
+        SystemStatusPQWM1 s = SystemStatusPQWM1parser(data, len).get();
+        SystemStatusTimeAndClock timeAndClock(s);
+        SystemStatusXoState xoState(s);
+        SystemStatusRfAndParams rfAndParams(s);
+        SystemStatusErrRecovery errRecovery(s);
+        lockCache();
+        setIteminReport(mCache.mTimeAndClock, std::move(timeAndClock));
+        setIteminReport(mCache.mXoState, std::move(xoState));
+        setIteminReport(mCache.mRfAndParams, std::move(rfAndParams));
+        setIteminReport(mCache.mErrRecovery, std::move(errRecovery));
+        unlockCache();
+        break;
     }
-    else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mXtra,
-                SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mEphemeris,
-                SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mSvHealth,
-                SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPdr,
-                SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mNavData,
-                SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPositionFailure,
-                SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()));
-    }
-    else {
+    case PQW_TAG('P', '1'):
+        setNmeaItem(mCache.mInjectedPosition,
+                SystemStatusInjectedPosition(SystemStatusPQWP1parser(data, len).get()));
+        break;
+    case PQW_TAG('P', '2'):
+        setNmeaItem(mCache.mBestPosition,
+                SystemStatusBestPosition(SystemStatusPQWP2parser(data, len).get()));
+        break;
+    case PQW_TAG('P', '3'):
+        setNmeaItem(mCache.mXtra,
+                SystemStatusXtra(SystemStatusPQWP3parser(data, len).get()));
+        break;
+    case PQW_TAG('P', '4'):
+        setNmeaItem(mCache.mEphemeris,
+                SystemStatusEphemeris(SystemStatusPQWP4parser(data, len).get()));
+        break;
+    case PQW_TAG('P', '5'):
+        setNmeaItem(mCache.mSvHealth,
+                SystemStatusSvHealth(SystemStatusPQWP5parser(data, len).get()));
+        break;
+    case PQW_TAG('P', '6'):
+        setNmeaItem(mCache.mPdr,
+                SystemStatusPdr(SystemStatusPQWP6parser(data, len).get()));
+        break;
+    case PQW_TAG('P', '7'):
+        setNmeaItem(mCache.mNavData,
+                SystemStatusNavData(SystemStatusPQWP7parser(data, len).get()));
+        break;
+    case PQW_TAG('S', '1'):
+        setNmeaItem(mCache.mPositionFailure,
+                SystemStatusPositionFailure(SystemStatusPQWS1parser(data, len).get()));
+        break;
+    default:
         // do nothing
+        break;
     }
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
 }
 
@@ -1468,16 +1594,19 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
                                  const GpsLocationExtended& locationEx)
 {
     bool ret = false;
-    pthread_mutex_lock(&mMutexSystemStatus);
+    lockCache();
 
     ret = setIteminReport(mCache.mLocation, SystemStatusLocation(location, locationEx));
+    if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG) {
+        mTrack.append(location, getBootTimeMilliSec());
+    }
     LOC_LOGV("eventPosition - lat=%f lon=%f alt=%f speed=%f",
              location.gpsLocation.latitude,
              location.gpsLocation.longitude,
              location.gpsLocation.altitude,
              location.gpsLocation.speed);
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    unlockCache();
     return ret;
 }
 
@@ -1491,7 +1620,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
 bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 {
     bool ret = false;
-    pthread_mutex_lock(&mMutexSystemStatus);
+    lockCache();
     switch(dataitem->getId())
     {
         case AIRPLANEMODE_DATA_ITEM_ID:
@@ -1585,7 +1714,7 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
         default:
             break;
     }
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    unlockCache();
     LOC_LOGv("DataItemId: %d, whether to record dateitem in cache: %d", dataitem->getId(), ret);
     return ret;
 }
@@ -1600,7 +1729,7 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 ******************************************************************************/
 bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
+    lockCache();
 
     if (isLatestOnly) {
         // push back only the latest report and return it
@@ -1689,7 +1818,7 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
         report = mCache;
     }
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    unlockCache();
     return true;
 }
 
@@ -1702,7 +1831,7 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
 ******************************************************************************/
 bool SystemStatus::setDefaultGnssEngineStates(void)
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
+    lockCache();
 
     setDefaultIteminReport(mCache.mLocation, SystemStatusLocation());
 
@@ -1721,7 +1850,7 @@ bool SystemStatus::setDefaultGnssEngineStates(void)
 
     setDefaultIteminReport(mCache.mPositionFailure, SystemStatusPositionFailure());
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    unlockCache();
     return true;
 }
 
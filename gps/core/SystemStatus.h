@@ -32,10 +32,15 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <vector>
+#include <memory>
+#include <atomic>
 #include <algorithm>
 #include <iterator>
 #include <loc_pla.h>
 #include <log_util.h>
+#include <LocFixedRing.h>
+#include <LocMemStats.h>
+#include <LocHistogram.h>
 #include <MsgTask.h>
 #include <IDataItemCore.h>
 #include <IOsObserver.h>
@@ -90,12 +95,27 @@ public:
     inline virtual bool ignore() { return false; };
 };
 
+// The GpsLocationExtended fields read back from the history. The whole struct
+// is several KB, mostly measurement usage info, and every fix is copied into
+// the history and its published snapshot.
+struct SystemStatusLocationEx {
+    float vert_unc;
+    float speed_unc;
+    float bearing_unc;
+    inline SystemStatusLocationEx() :
+        vert_unc(0.0f), speed_unc(0.0f), bearing_unc(0.0f) {}
+    inline SystemStatusLocationEx(const GpsLocationExtended& locationEx) :
+        vert_unc(locationEx.vert_unc),
+        speed_unc(locationEx.speed_unc),
+        bearing_unc(locationEx.bearing_unc) {}
+};
+
 class SystemStatusLocation : public SystemStatusItemBase
 {
 public:
     bool mValid;
     UlpLocation mLocation;
-    GpsLocationExtended mLocationEx;
+    SystemStatusLocationEx mLocationEx;
     inline SystemStatusLocation() :
         mValid(false) {}
     inline SystemStatusLocation(const UlpLocation& location,
@@ -106,6 +126,8 @@ public:
     bool equals(const SystemStatusLocation& peer);
     void dump(void) override;
 };
+// taken on every fix under the cache lock, keep it to a few cache lines
+static_assert(sizeof(SystemStatusLocation) <= 256, "SystemStatusLocation grew");
 
 class SystemStatusPQWM1;
 class SystemStatusTimeAndClock : public SystemStatusItemBase
@@ -826,53 +848,113 @@ public:
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
+// The last SystemStatusItemBase::maxItem items of each kind, oldest first,
+// plus an immutable copy of the latest one. Writers change the history under
+// the SystemStatus lock and then publish() a fresh copy; readers grab
+// latest() without the lock and keep using their copy no matter how many
+// updates are published after it (RCU style, the shared_ptr reclaims it).
+template <typename TYPE_ITEM>
+class SystemStatusHistory :
+        public loc_util::LocFixedRing<TYPE_ITEM, SystemStatusItemBase::maxItem>
+{
+    std::shared_ptr<const TYPE_ITEM> mLatest;
+public:
+    inline void publish() {
+        std::shared_ptr<const TYPE_ITEM> latest;
+        if (!this->empty()) {
+            // accounted, a reader holding on to old copies shows up there
+            latest = std::allocate_shared<TYPE_ITEM>(
+                    loc_util::LocMemAllocator<TYPE_ITEM, loc_util::LOC_MEM_SYSTEM_STATUS>(),
+                    this->back());
+        }
+        std::atomic_store(&mLatest, latest);
+    }
+    // nullptr until the first item is published
+    inline std::shared_ptr<const TYPE_ITEM> latest() const {
+        return std::atomic_load(&mLatest);
+    }
+};
+
 class SystemStatusReports
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    SystemStatusHistory<SystemStatusLocation>        mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    SystemStatusHistory<SystemStatusTimeAndClock>    mTimeAndClock;
+    SystemStatusHistory<SystemStatusXoState>         mXoState;
+    SystemStatusHistory<SystemStatusRfAndParams>     mRfAndParams;
+    SystemStatusHistory<SystemStatusErrRecovery>     mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    SystemStatusHistory<SystemStatusInjectedPosition> mInjectedPosition;
+    SystemStatusHistory<SystemStatusBestPosition>    mBestPosition;
+    SystemStatusHistory<SystemStatusXtra>            mXtra;
+    SystemStatusHistory<SystemStatusEphemeris>       mEphemeris;
+    SystemStatusHistory<SystemStatusSvHealth>        mSvHealth;
+    SystemStatusHistory<SystemStatusPdr>             mPdr;
+    SystemStatusHistory<SystemStatusNavData>         mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    SystemStatusHistory<SystemStatusPositionFailure> mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+    SystemStatusHistory<SystemStatusAirplaneMode>    mAirplaneMode;
+    SystemStatusHistory<SystemStatusENH>             mENH;
+    SystemStatusHistory<SystemStatusGpsState>        mGPSState;
+    SystemStatusHistory<SystemStatusNLPStatus>       mNLPStatus;
+    SystemStatusHistory<SystemStatusWifiHardwareState> mWifiHardwareState;
+    SystemStatusHistory<SystemStatusNetworkInfo>     mNetworkInfo;
+    SystemStatusHistory<SystemStatusServiceInfo>     mRilServiceInfo;
+    SystemStatusHistory<SystemStatusRilCellInfo>     mRilCellInfo;
+    SystemStatusHistory<SystemStatusServiceStatus>   mServiceStatus;
+    SystemStatusHistory<SystemStatusModel>           mModel;
+    SystemStatusHistory<SystemStatusManufacturer>    mManufacturer;
+    SystemStatusHistory<SystemStatusAssistedGps>     mAssistedGps;
+    SystemStatusHistory<SystemStatusScreenState>     mScreenState;
+    SystemStatusHistory<SystemStatusPowerConnectState> mPowerConnectState;
+    SystemStatusHistory<SystemStatusTimeZoneChange>  mTimeZoneChange;
+    SystemStatusHistory<SystemStatusTimeChange>      mTimeChange;
+    SystemStatusHistory<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
+    SystemStatusHistory<SystemStatusShutdownState>   mShutdownState;
+    SystemStatusHistory<SystemStatusTac>             mTac;
+    SystemStatusHistory<SystemStatusMccMnc>          mMccMnc;
+    SystemStatusHistory<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
+    SystemStatusHistory<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+};
+
+/******************************************************************************
+ SystemStatusLocationTrack
+******************************************************************************/
+// how far back the track goes, and the fixes it holds at most to get there
+#define SYSTEM_STATUS_TRACK_WINDOW_MS   (10 * 60 * 1000)
+#define SYSTEM_STATUS_TRACK_MAX_FIXES   600
+
+// A fix as the track keeps it, where the device was and when
+struct SystemStatusTrackFix {
+    uint64_t mBootTimeMs;  // boot time eventPosition got the fix
+    int64_t mUtcTimeMs;    // LocGpsLocation::timestamp
+    double mLatitude;
+    double mLongitude;
+    float mAltitude;
+    float mAccuracy;
+    float mSpeed;
+    float mBearing;
+    uint16_t mFlags;       // LocGpsLocationFlags
+};
+
+// The fixes of the last SYSTEM_STATUS_TRACK_WINDOW_MS, in boot time order, in
+// storage allocated once. A fix is appended in O(1), dropping the ones gone out
+// of the window or the oldest if full, and a time range is found by binary
+// search. Not thread safe, SystemStatus guards it with its cache lock.
+class SystemStatusLocationTrack :
+        public loc_util::LocFixedRing<SystemStatusTrackFix, SYSTEM_STATUS_TRACK_MAX_FIXES>
+{
+public:
+    void append(const UlpLocation& location, uint64_t bootTimeMs);
+    // index of the first fix got at or after bootTimeMs, size() if none
+    uint32_t lowerBound(uint64_t bootTimeMs) const;
 };
 
 /******************************************************************************
@@ -891,10 +973,26 @@ private:
     // Data members
     static pthread_mutex_t                    mMutexSystemStatus;
     SystemStatusReports mCache;
+    // beside mCache, so getReport() does not copy it
+    SystemStatusLocationTrack mTrack;
+
+    // mMutexSystemStatus, with wait and hold times recorded in usec
+    static void lockCache();
+    static void unlockCache();
+    static uint64_t                           mLockedAtNs;
+    static loc_util::LocHistogram             mLockWaitUs;
+    static loc_util::LocHistogram             mLockHoldUs;
+
+    // bumped after every publish() into mCache
+    std::atomic<uint64_t>                     mGeneration;
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     bool setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s);
 
+    // setIteminReport under mMutexSystemStatus, for items parsed outside of it
+    template <typename TYPE_REPORT, typename TYPE_ITEM>
+    void setNmeaItem(TYPE_REPORT& report, TYPE_ITEM&& s);
+
     // set default dataitem derived item in report cache
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     void setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s);
@@ -913,6 +1011,39 @@ public:
     bool eventDataItemNotify(IDataItemCore* dataitem);
     bool setNmeaString(const char *data, uint32_t len);
     bool getReport(SystemStatusReports& reports, bool isLatestonly = false) const;
+    // lock free snapshot of the latest item of one kind, nullptr if none yet,
+    // e.g. getLatest(&SystemStatusReports::mTimeAndClock)
+    template <typename TYPE_ITEM>
+    inline std::shared_ptr<const TYPE_ITEM> getLatest(
+            SystemStatusHistory<TYPE_ITEM> SystemStatusReports::* history) const {
+        return (mCache.*history).latest();
+    }
+    // Calls visit(const SystemStatusTrackFix&) for the fixes of the track got
+    // from fromBootTimeMs to toBootTimeMs, oldest first, under the cache lock
+    // and without copying them. Returns how many were visited.
+    template <typename VISIT>
+    uint32_t forEachTrackFix(uint64_t fromBootTimeMs, uint64_t toBootTimeMs,
+                             VISIT visit) const {
+        uint32_t count = 0;
+        lockCache();
+        for (uint32_t i = mTrack.lowerBound(fromBootTimeMs);
+                i < mTrack.size() && mTrack[i].mBootTimeMs <= toBootTimeMs; i++, count++) {
+            visit(mTrack[i]);
+        }
+        unlockCache();
+        return count;
+    }
+    // the latest fix of the track if not older than maxAgeMs
+    bool getRecentTrackFix(uint64_t maxAgeMs, SystemStatusTrackFix& fix) const;
+    // appends the span and fix count of the track
+    void dumpTrack(std::string& out) const;
+    // changes whenever any latest item may have, so a reader can keep what it
+    // derived from the items until then
+    inline uint64_t getGeneration() const {
+        return mGeneration.load(std::memory_order_acquire);
+    }
+    // appends the cache lock wait / hold time histograms
+    static void dumpStats(std::string& out);
     bool setDefaultGnssEngineStates(void);
     bool eventConnectionStatus(bool connected, int8_t type,
                                bool roaming, NetworkHandle networkHandle, string& apn);
@@ -33,19 +33,45 @@
 #include <SystemStatusOsObserver.h>
 #include <IDataItemCore.h>
 #include <DataItemsFactoryProxy.h>
+#include <loc_cfg.h>
+#include <loc_misc_utils.h>
 
 namespace loc_core
 {
-template <typename CINT, typename COUT>
-COUT SystemStatusOsObserver::containerTransfer(CINT& inContainer) {
-    COUT outContainer = {};
-    for (auto item : inContainer) {
-        outContainer.insert(outContainer.begin(), item);
-    }
-    return outContainer;
+SystemStatusOsObserver::SystemStatusOsObserver(SystemStatus* systemstatus,
+                                               const MsgTask* msgTask) :
+        mSystemStatus(systemstatus), mContext(msgTask, this),
+        mAddress("SystemStatusOsObserver"),
+        mCoalesceMsec(0), mCoalesceTimer(*this), mCoalesceTimerArmed(false),
+        mActionDebounceMsec(0), mActionDebounceTimer(*this), mActionDebounceTimerArmed(false)
+{
+    const loc_param_s_type coalesceConfTable[] =
+    {
+        {"DATA_ITEM_COALESCE_MSEC", &mCoalesceMsec, NULL, 'n'},
+        {"FRAMEWORK_ACTION_DEBOUNCE_MSEC", &mActionDebounceMsec, NULL, 'n'}
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, coalesceConfTable);
+    LOC_LOGd("DATA_ITEM_COALESCE_MSEC: %u FRAMEWORK_ACTION_DEBOUNCE_MSEC: %u",
+             mCoalesceMsec, mActionDebounceMsec);
+
+    // Load the data-item library off the caller's thread now, rather than
+    // in the middle of the first notify()
+    struct LoadDataItemLibrary : public LocMsg {
+        inline LoadDataItemLibrary() {}
+        void proc() const {
+            DataItemsFactoryProxy::loadDataItemLibrary();
+        }
+    };
+    mContext.mMsgTask->sendMsg(new (nothrow) LoadDataItemLibrary());
 }
 
 SystemStatusOsObserver::~SystemStatusOsObserver() {
+    mCoalesceTimer.stop();
+    mActionDebounceTimer.stop();
+
+    // Pooled items come out of the data-item library; free them first
+    mDataItemPool.clear();
+
     // Close data-item library handle
     DataItemsFactoryProxy::closeDataItemLibraryHandle();
 
@@ -55,8 +81,14 @@ SystemStatusOsObserver::~SystemStatusOsObserver() {
             delete each.second;
         }
     }
+    for (auto each : mDeliveredCache) {
+        if (nullptr != each.second) {
+            delete each.second;
+        }
+    }
 
     mDataItemCache.clear();
+    mDeliveredCache.clear();
 }
 
 void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscriptionObj)
@@ -70,10 +102,9 @@ void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscript
             LOC_LOGi("SetSubsObj::enter");
             mContext.mSubscriptionObj = mSubsObj;
 
-            if (!mContext.mSSObserver->mDataItemToClients.empty()) {
+            if (mContext.mSSObserver->mSubscribedDataItems.any()) {
                 list<DataItemId> dis(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                mContext.mSSObserver->mDataItemToClients.getKeys()));
+                        toDataItemIdList(mContext.mSSObserver->mSubscribedDataItems));
                 mContext.mSubscriptionObj->subscribe(dis, mContext.mSSObserver);
                 mContext.mSubscriptionObj->requestData(dis, mContext.mSSObserver);
             }
@@ -98,14 +129,16 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
         inline HandleSubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client, bool requestData) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)),
+                mDataItemSet(toDataItemIdSet(l)),
                 diItemlist(l),
                 mToRequestData(requestData) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            mParent->mDataItemToClients.add(mDataItemSet, {mClient}, &dataItemsToSubscribe);
-            mParent->mClientToDataItems.add(mClient, mDataItemSet);
+            DataItemIdSet dataItemsToSubscribe;
+            DataItemIdSet dataItemsToUnsubscribe;
+            mParent->setClientDataItems(mClient,
+                                        mParent->mClientToDataItems[mClient] | mDataItemSet,
+                                        dataItemsToSubscribe, dataItemsToUnsubscribe);
 
             mParent->sendCachedDataItems(mDataItemSet, mClient);
 
@@ -114,19 +147,17 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
                 if (mToRequestData) {
                     LOC_LOGD("Request Data sent to framework for the following");
                     mParent->mContext.mSubscriptionObj->requestData(diItemlist, mParent);
-                } else if (!dataItemsToSubscribe.empty()) {
+                } else if (dataItemsToSubscribe.any()) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToSubscribe), mParent);
                 }
             }
         }
         mutable SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        const unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
         const list<DataItemId> diItemlist;
         bool mToRequestData;
     };
@@ -146,61 +177,46 @@ void SystemStatusOsObserver::updateSubscription(
         HandleUpdateSubscriptionReq(SystemStatusOsObserver* parent,
                                     list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(toDataItemIdSet(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            unordered_set<IDataItemObserver*> clients({mClient});
-            // below removes clients from all entries keyed with the return of the
-            // mClientToDataItems.update() call. If leaving an empty set of clients as the
-            // result, the entire entry will be removed. dataItemsToUnsubscribe will be
-            // populated to keep the keys of the removed entries.
-            mParent->mDataItemToClients.trimOrRemove(
-                    // this call updates <IDataItemObserver*, DataItemId> map; removes
-                    // the DataItemId's that are not new to the clietn from mDataItemSet;
-                    // and returns a set of mDataItemSet's that are no longer used by client.
-                    // This unused set of mDataItemSet's is passed to trimOrRemove method of
-                    // <DataItemId, IDataItemObserver*> map to remove the client from the
-                    // corresponding entries, and gets a set of the entries that are
-                    // removed from the <DataItemId, IDataItemObserver*> map as a result.
-                    mParent->mClientToDataItems.update(mClient,
-                                                       (unordered_set<DataItemId>&)mDataItemSet),
-                    clients, &dataItemsToUnsubscribe, nullptr);
-            // below adds mClient to <DataItemId, IDataItemObserver*> map, and populates
-            // new keys added to that map, which are DataItemIds to be subscribed.
-            mParent->mDataItemToClients.add(mDataItemSet, clients, &dataItemsToSubscribe);
+            DataItemIdSet dataItemsToSubscribe;
+            DataItemIdSet dataItemsToUnsubscribe;
+            // only the items that are new to the client get a first response
+            DataItemIdSet dataItemsNewToClient = mDataItemSet;
+            auto citer = mParent->mClientToDataItems.find(mClient);
+            if (citer != mParent->mClientToDataItems.end()) {
+                dataItemsNewToClient &= ~citer->second;
+            }
+            mParent->setClientDataItems(mClient, mDataItemSet,
+                                        dataItemsToSubscribe, dataItemsToUnsubscribe);
 
             // Send First Response
-            mParent->sendCachedDataItems(mDataItemSet, mClient);
+            mParent->sendCachedDataItems(dataItemsNewToClient, mClient);
 
             if (nullptr != mParent->mContext.mSubscriptionObj) {
                 // Send subscription set to framework
-                if (!dataItemsToSubscribe.empty()) {
+                if (dataItemsToSubscribe.any()) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
 
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToSubscribe), mParent);
                 }
 
                 // Send unsubscribe to framework
-                if (!dataItemsToUnsubscribe.empty()) {
+                if (dataItemsToUnsubscribe.any()) {
                     LOC_LOGD("Unsubscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToUnsubscribe);
 
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToUnsubscribe), mParent);
                 }
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -218,31 +234,30 @@ void SystemStatusOsObserver::unsubscribe(
         HandleUnsubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(toDataItemIdSet(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsUnusedByClient = {};
-            unordered_set<IDataItemObserver*> clientToRemove = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            mParent->mClientToDataItems.trimOrRemove({mClient}, mDataItemSet,  &clientToRemove,
-                                                     &dataItemsUnusedByClient);
-            mParent->mDataItemToClients.trimOrRemove(dataItemsUnusedByClient, {mClient},
-                                                     &dataItemsToUnsubscribe, nullptr);
-
-            if (nullptr != mParent->mContext.mSubscriptionObj && !dataItemsToUnsubscribe.empty()) {
+            auto citer = mParent->mClientToDataItems.find(mClient);
+            if (citer == mParent->mClientToDataItems.end()) {
+                return;
+            }
+            DataItemIdSet dataItemsToSubscribe;
+            DataItemIdSet dataItemsToUnsubscribe;
+            mParent->setClientDataItems(mClient, citer->second & ~mDataItemSet,
+                                        dataItemsToSubscribe, dataItemsToUnsubscribe);
+
+            if (nullptr != mParent->mContext.mSubscriptionObj && dataItemsToUnsubscribe.any()) {
                 LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
                 mParent->logMe(dataItemsToUnsubscribe);
 
                 // Send unsubscribe to framework
                 mParent->mContext.mSubscriptionObj->unsubscribe(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                  std::move(dataItemsToUnsubscribe)),
-                        mParent);
+                        toDataItemIdList(dataItemsToUnsubscribe), mParent);
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -260,26 +275,20 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
                 mParent(parent), mClient(client) {}
 
         void proc() const {
-            unordered_set<DataItemId> diByClient = mParent->mClientToDataItems.getValSet(mClient);
-
-            if (!diByClient.empty()) {
-                unordered_set<DataItemId> dataItemsToUnsubscribe;
-                mParent->mClientToDataItems.remove(mClient);
-                mParent->mDataItemToClients.trimOrRemove(diByClient, {mClient},
-                                                         &dataItemsToUnsubscribe, nullptr);
+            DataItemIdSet dataItemsToSubscribe;
+            DataItemIdSet dataItemsToUnsubscribe;
+            mParent->setClientDataItems(mClient, DataItemIdSet(),
+                                        dataItemsToSubscribe, dataItemsToUnsubscribe);
 
-                if (!dataItemsToUnsubscribe.empty() &&
-                    nullptr != mParent->mContext.mSubscriptionObj) {
+            if (dataItemsToUnsubscribe.any() &&
+                nullptr != mParent->mContext.mSubscriptionObj) {
 
-                    LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
-                    mParent->logMe(dataItemsToUnsubscribe);
+                LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
+                mParent->logMe(dataItemsToUnsubscribe);
 
-                    // Send unsubscribe to framework
-                    mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
-                }
+                // Send unsubscribe to framework
+                mParent->mContext.mSubscriptionObj->unsubscribe(
+                        toDataItemIdList(dataItemsToUnsubscribe), mParent);
             }
         }
         SystemStatusOsObserver* mParent;
@@ -304,60 +313,41 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
 
         inline virtual ~HandleNotify() {
             for (auto item : mDiVec) {
-                delete item;
+                mParent->mDataItemPool.release(item);
             }
         }
 
         void proc() const {
             // Update Cache with received data items and prepare
             // list of data items to be sent.
-            unordered_set<DataItemId> dataItemIdsToBeSent = {};
+            DataItemIdSet dataItemIdsToBeSent;
             for (auto item : mDiVec) {
                 if (mParent->updateCache(item)) {
-                    dataItemIdsToBeSent.insert(item->getId());
+                    dataItemIdsToBeSent.set(item->getId());
                 }
             }
 
-            // Send data item to all subscribed clients
-            unordered_set<IDataItemObserver*> clientSet = {};
-            for (auto each : dataItemIdsToBeSent) {
-                auto clients = mParent->mDataItemToClients.getValSetPtr(each);
-                if (nullptr != clients) {
-                    clientSet.insert(clients->begin(), clients->end());
-                }
-            }
-
-            for (auto client : clientSet) {
-                unordered_set<DataItemId> dataItemIdsForThisClient(
-                        mParent->mClientToDataItems.getValSet(client));
-                for (auto itr = dataItemIdsForThisClient.begin();
-                        itr != dataItemIdsForThisClient.end(); ) {
-                    if (dataItemIdsToBeSent.find(*itr) == dataItemIdsToBeSent.end()) {
-                        itr = dataItemIdsForThisClient.erase(itr);
-                    } else {
-                        itr++;
-                    }
-                }
-
-                mParent->sendCachedDataItems(dataItemIdsForThisClient, client);
-            }
+            // Send data item to all subscribed clients, now or once its
+            // coalescing window closes
+            mParent->deliverChanges(dataItemIdsToBeSent);
         }
         SystemStatusOsObserver* mParent;
         const vector<IDataItemCore*> mDiVec;
     };
 
     if (!dlist.empty()) {
-        vector<IDataItemCore*> dataItemVec(dlist.size());
+        vector<IDataItemCore*> dataItemVec;
+        dataItemVec.reserve(dlist.size());
 
         for (auto each : dlist) {
 
-            IDataItemCore* di = DataItemsFactoryProxy::createNewDataItem(each->getId());
+            IDataItemCore* di = mDataItemPool.acquire(each->getId());
             if (nullptr == di) {
                 LOC_LOGw("Unable to create dataitem:%d", each->getId());
                 continue;
             }
 
-            // Copy contents into the newly created data item
+            // Copy contents into the pooled data item
             di->copy(each);
 
             // add this dataitem if updated from last one
@@ -385,36 +375,18 @@ void SystemStatusOsObserver::turnOn(DataItemId dit, int timeOut)
         return;
     }
 
-    // Check if data item exists in mActiveRequestCount
-    DataItemIdToInt::iterator citer = mActiveRequestCount.find(dit);
-    if (citer == mActiveRequestCount.end()) {
-        // Data item not found in map
-        // Add reference count as 1 and add dataitem to map
-        pair<DataItemId, int> cpair(dit, 1);
-        mActiveRequestCount.insert(cpair);
-        LOC_LOGD("Sending turnOn request");
-
-        // Send action turn on to framework
-        struct HandleTurnOnMsg : public LocMsg {
-            HandleTurnOnMsg(IFrameworkActionReq* framework,
-                    DataItemId dit, int timeOut) :
-                    mFrameworkActionReqObj(framework), mDataItemId(dit), mTimeOut(timeOut) {}
-            virtual ~HandleTurnOnMsg() {}
-            void proc() const {
-                mFrameworkActionReqObj->turnOn(mDataItemId, mTimeOut);
-            }
-            IFrameworkActionReq* mFrameworkActionReqObj;
-            DataItemId mDataItemId;
-            int mTimeOut;
-        };
-        mContext.mMsgTask->sendMsg(
-                new (nothrow) HandleTurnOnMsg(mContext.mFrameworkActionReqObj, dit, timeOut));
-    }
-    else {
-        // Found in map, update reference count
-        citer->second++;
-        LOC_LOGD("turnOn - Data item:%d Num_refs:%d", dit, citer->second);
-    }
+    struct HandleTurnOnMsg : public LocMsg {
+        HandleTurnOnMsg(SystemStatusOsObserver* parent, DataItemId dit, int timeOut) :
+                mParent(parent), mDataItemId(dit), mTimeOut(timeOut) {}
+        virtual ~HandleTurnOnMsg() {}
+        void proc() const {
+            mParent->handleTurnOn(mDataItemId, mTimeOut);
+        }
+        SystemStatusOsObserver* mParent;
+        DataItemId mDataItemId;
+        int mTimeOut;
+    };
+    mContext.mMsgTask->sendMsg(new (nothrow) HandleTurnOnMsg(this, dit, timeOut));
 }
 
 void SystemStatusOsObserver::turnOff(DataItemId dit)
@@ -424,31 +396,17 @@ void SystemStatusOsObserver::turnOff(DataItemId dit)
         return;
     }
 
-    // Check if data item exists in mActiveRequestCount
-    DataItemIdToInt::iterator citer = mActiveRequestCount.find(dit);
-    if (citer != mActiveRequestCount.end()) {
-        // found
-        citer->second--;
-        LOC_LOGD("turnOff - Data item:%d Remaining:%d", dit, citer->second);
-        if(citer->second == 0) {
-            // if this was last reference, remove item from map and turn off module
-            mActiveRequestCount.erase(citer);
-
-            // Send action turn off to framework
-            struct HandleTurnOffMsg : public LocMsg {
-                HandleTurnOffMsg(IFrameworkActionReq* framework, DataItemId dit) :
-                    mFrameworkActionReqObj(framework), mDataItemId(dit) {}
-                virtual ~HandleTurnOffMsg() {}
-                void proc() const {
-                    mFrameworkActionReqObj->turnOff(mDataItemId);
-                }
-                IFrameworkActionReq* mFrameworkActionReqObj;
-                DataItemId mDataItemId;
-            };
-            mContext.mMsgTask->sendMsg(
-                    new (nothrow) HandleTurnOffMsg(mContext.mFrameworkActionReqObj, dit));
+    struct HandleTurnOffMsg : public LocMsg {
+        HandleTurnOffMsg(SystemStatusOsObserver* parent, DataItemId dit) :
+                mParent(parent), mDataItemId(dit) {}
+        virtual ~HandleTurnOffMsg() {}
+        void proc() const {
+            mParent->handleTurnOff(mDataItemId);
         }
-    }
+        SystemStatusOsObserver* mParent;
+        DataItemId mDataItemId;
+    };
+    mContext.mMsgTask->sendMsg(new (nothrow) HandleTurnOffMsg(this, dit));
 }
 
 #ifdef USE_GLIB
@@ -458,19 +416,16 @@ bool SystemStatusOsObserver::connectBackhaul(const string& clientName)
 
     if (mContext.mFrameworkActionReqObj != NULL) {
         struct HandleConnectBackhaul : public LocMsg {
-            HandleConnectBackhaul(IFrameworkActionReq* fwkActReq, const string& clientName) :
-                    mClientName(clientName), mFwkActionReqObj(fwkActReq) {}
+            HandleConnectBackhaul(SystemStatusOsObserver* parent, const string& clientName) :
+                    mParent(parent), mClientName(clientName) {}
             virtual ~HandleConnectBackhaul() {}
             void proc() const {
-                LOC_LOGi("HandleConnectBackhaul::enter");
-                mFwkActionReqObj->connectBackhaul(mClientName);
-                LOC_LOGi("HandleConnectBackhaul::exit");
+                mParent->handleConnectBackhaul(mClientName);
             }
-            IFrameworkActionReq* mFwkActionReqObj;
+            SystemStatusOsObserver* mParent;
             string mClientName;
         };
-        mContext.mMsgTask->sendMsg(
-                new (nothrow) HandleConnectBackhaul(mContext.mFrameworkActionReqObj, clientName));
+        mContext.mMsgTask->sendMsg(new (nothrow) HandleConnectBackhaul(this, clientName));
         result = true;
     }
     else {
@@ -494,20 +449,16 @@ bool SystemStatusOsObserver::disconnectBackhaul(const string& clientName)
 
     if (mContext.mFrameworkActionReqObj != NULL) {
         struct HandleDisconnectBackhaul : public LocMsg {
-            HandleDisconnectBackhaul(IFrameworkActionReq* fwkActReq, const string& clientName) :
-                    mClientName(clientName), mFwkActionReqObj(fwkActReq) {}
+            HandleDisconnectBackhaul(SystemStatusOsObserver* parent, const string& clientName) :
+                    mParent(parent), mClientName(clientName) {}
             virtual ~HandleDisconnectBackhaul() {}
             void proc() const {
-                LOC_LOGi("HandleDisconnectBackhaul::enter");
-                mFwkActionReqObj->disconnectBackhaul(mClientName);
-                LOC_LOGi("HandleDisconnectBackhaul::exit");
+                mParent->handleDisconnectBackhaul(mClientName);
             }
-            IFrameworkActionReq* mFwkActionReqObj;
+            SystemStatusOsObserver* mParent;
             string mClientName;
         };
-        mContext.mMsgTask->sendMsg(
-                new (nothrow) HandleDisconnectBackhaul(mContext.mFrameworkActionReqObj,
-                        clientName));
+        mContext.mMsgTask->sendMsg(new (nothrow) HandleDisconnectBackhaul(this, clientName));
     }
     else {
         LOC_LOGe("Framework action request object is NULL.Caching disconnect request: %s",
@@ -524,37 +475,445 @@ bool SystemStatusOsObserver::disconnectBackhaul(const string& clientName)
     return result;
 }
 #endif
+
+/******************************************************************************
+ Framework action requests, in the context of the msg task
+******************************************************************************/
+void SystemStatusOsObserver::handleTurnOn(DataItemId dit, int timeOut)
+{
+    int& refs = mActiveRequestCount[dit];
+    refs++;
+    LOC_LOGD("turnOn - Data item:%d Num_refs:%d", dit, refs);
+    if (refs > 1) {
+        // already on for an earlier request
+        return;
+    }
+    if (mTurnOffDueMs.erase(dit) > 0) {
+        LOC_LOGd("DataItem:%d held back turnOff dropped, stays on", dit);
+        return;
+    }
+    if (nullptr != mContext.mFrameworkActionReqObj) {
+        LOC_LOGD("Sending turnOn request");
+        mContext.mFrameworkActionReqObj->turnOn(dit, timeOut);
+    }
+}
+
+void SystemStatusOsObserver::handleTurnOff(DataItemId dit)
+{
+    DataItemIdToInt::iterator citer = mActiveRequestCount.find(dit);
+    if (citer == mActiveRequestCount.end()) {
+        return;
+    }
+    citer->second--;
+    LOC_LOGD("turnOff - Data item:%d Remaining:%d", dit, citer->second);
+    if (citer->second > 0) {
+        return;
+    }
+    // the last reference, turn the module off
+    mActiveRequestCount.erase(citer);
+    if (0 == mActionDebounceMsec) {
+        if (nullptr != mContext.mFrameworkActionReqObj) {
+            mContext.mFrameworkActionReqObj->turnOff(dit);
+        }
+        return;
+    }
+    uint64_t nowMs = getBootTimeMilliSec();
+    mTurnOffDueMs[dit] = nowMs + mActionDebounceMsec;
+    armActionDebounceTimer(nowMs);
+}
+
+#ifdef USE_GLIB
+void SystemStatusOsObserver::handleConnectBackhaul(const string& clientName)
+{
+    int& refs = mBackhaulRefs[clientName];
+    refs++;
+    if (refs > 1) {
+        LOC_LOGd("client %s already connected, refs %d", clientName.c_str(), refs);
+        return;
+    }
+    if (mBackhaulDisconnectDueMs.erase(clientName) > 0) {
+        LOC_LOGd("client %s held back disconnect dropped, stays connected",
+                 clientName.c_str());
+        return;
+    }
+    if (nullptr != mContext.mFrameworkActionReqObj) {
+        LOC_LOGi("HandleConnectBackhaul::enter");
+        mContext.mFrameworkActionReqObj->connectBackhaul(clientName);
+        LOC_LOGi("HandleConnectBackhaul::exit");
+    }
+}
+
+void SystemStatusOsObserver::handleDisconnectBackhaul(const string& clientName)
+{
+    auto iter = mBackhaulRefs.find(clientName);
+    if (iter == mBackhaulRefs.end()) {
+        LOC_LOGd("client %s not connected", clientName.c_str());
+        return;
+    }
+    if (--iter->second > 0) {
+        LOC_LOGd("client %s still connected, refs %d", clientName.c_str(), iter->second);
+        return;
+    }
+    mBackhaulRefs.erase(iter);
+    if (0 == mActionDebounceMsec) {
+        if (nullptr != mContext.mFrameworkActionReqObj) {
+            LOC_LOGi("HandleDisconnectBackhaul::enter");
+            mContext.mFrameworkActionReqObj->disconnectBackhaul(clientName);
+            LOC_LOGi("HandleDisconnectBackhaul::exit");
+        }
+        return;
+    }
+    uint64_t nowMs = getBootTimeMilliSec();
+    mBackhaulDisconnectDueMs[clientName] = nowMs + mActionDebounceMsec;
+    armActionDebounceTimer(nowMs);
+}
+#endif
+
+void SystemStatusOsObserver::armActionDebounceTimer(uint64_t nowMs)
+{
+    if (mActionDebounceTimerArmed) {
+        // fires for the earliest one, and is armed again for the rest then
+        return;
+    }
+    uint64_t dueMs = UINT64_MAX;
+    for (auto& each : mTurnOffDueMs) {
+        dueMs = std::min(dueMs, each.second);
+    }
+#ifdef USE_GLIB
+    for (auto& each : mBackhaulDisconnectDueMs) {
+        dueMs = std::min(dueMs, each.second);
+    }
+#endif
+    if (UINT64_MAX == dueMs) {
+        return;
+    }
+    uint32_t timeOutMs = (dueMs > nowMs) ? (uint32_t)(dueMs - nowMs) : 1;
+    mActionDebounceTimerArmed = mActionDebounceTimer.start(timeOutMs, false);
+}
+
+void SystemStatusOsObserver::flushDebouncedActions()
+{
+    mActionDebounceTimerArmed = false;
+
+    uint64_t nowMs = getBootTimeMilliSec();
+    IFrameworkActionReq* frameworkActionReqObj = mContext.mFrameworkActionReqObj;
+    for (auto iter = mTurnOffDueMs.begin(); iter != mTurnOffDueMs.end();) {
+        if (iter->second > nowMs) {
+            ++iter;
+            continue;
+        }
+        if (nullptr != frameworkActionReqObj) {
+            LOC_LOGd("DataItem:%d held back turnOff sent", iter->first);
+            frameworkActionReqObj->turnOff(iter->first);
+        }
+        iter = mTurnOffDueMs.erase(iter);
+    }
+#ifdef USE_GLIB
+    for (auto iter = mBackhaulDisconnectDueMs.begin();
+         iter != mBackhaulDisconnectDueMs.end();) {
+        if (iter->second > nowMs) {
+            ++iter;
+            continue;
+        }
+        if (nullptr != frameworkActionReqObj) {
+            LOC_LOGi("HandleDisconnectBackhaul::enter");
+            frameworkActionReqObj->disconnectBackhaul(iter->first);
+            LOC_LOGi("HandleDisconnectBackhaul::exit");
+        }
+        iter = mBackhaulDisconnectDueMs.erase(iter);
+    }
+#endif
+    armActionDebounceTimer(nowMs);
+}
+
+// Called in the context of LocTimer thread
+void SystemStatusOsObserver::ActionDebounceTimer::timeOutCallback()
+{
+    struct HandleActionDebounceTimeout : public LocMsg {
+        SystemStatusOsObserver& mObserver;
+        inline HandleActionDebounceTimeout(SystemStatusOsObserver& observer) :
+                mObserver(observer) {}
+        void proc() const {
+            mObserver.flushDebouncedActions();
+        }
+    };
+    mObserver.mContext.mMsgTask->sendMsg(new (nothrow) HandleActionDebounceTimeout(mObserver));
+}
+
 /******************************************************************************
  Helpers
 ******************************************************************************/
+DataItemIdSet SystemStatusOsObserver::toDataItemIdSet(
+        const list<DataItemId>& l)
+{
+    DataItemIdSet s;
+    for (auto id : l) {
+        if (id > INVALID_DATA_ITEM_ID && id < MAX_DATA_ITEM_ID_1_1) {
+            s.set(id);
+        }
+    }
+    return s;
+}
+
+list<DataItemId> SystemStatusOsObserver::toDataItemIdList(const DataItemIdSet& s)
+{
+    list<DataItemId> l;
+    for (size_t id = 0; id < s.size(); id++) {
+        if (s.test(id)) {
+            l.push_back((DataItemId)id);
+        }
+    }
+    return l;
+}
+
+void SystemStatusOsObserver::setClientDataItems(IDataItemObserver* client,
+        const DataItemIdSet& s, DataItemIdSet& added, DataItemIdSet& removed)
+{
+    if (s.none()) {
+        mClientToDataItems.erase(client);
+    } else {
+        mClientToDataItems[client] = s;
+    }
+
+    DataItemIdSet subscribed;
+    for (auto& each : mClientToDataItems) {
+        subscribed |= each.second;
+    }
+    added = subscribed & ~mSubscribedDataItems;
+    removed = mSubscribedDataItems & ~subscribed;
+    mSubscribedDataItems = subscribed;
+}
+
+void SystemStatusOsObserver::getCachedDataItems(
+        const DataItemIdSet& s, list<IDataItemCore*>& dataItems)
+{
+    for (auto& each : mDataItemCache) {
+        if (s.test(each.first)) {
+            dataItems.push_front(each.second);
+        }
+    }
+}
+
 void SystemStatusOsObserver::sendCachedDataItems(
-        const unordered_set<DataItemId>& s, IDataItemObserver* to)
+        const DataItemIdSet& s, IDataItemObserver* to)
 {
     if (nullptr == to) {
         LOC_LOGv("client pointer is NULL.");
     } else {
-        string clientName;
-        to->getName(clientName);
         list<IDataItemCore*> dataItems = {};
-
-        for (auto each : s) {
-            auto citer = mDataItemCache.find(each);
-            if (citer != mDataItemCache.end()) {
-                string dv;
-                citer->second->stringify(dv);
-                LOC_LOGI("DataItem: %s >> %s", dv.c_str(), clientName.c_str());
-                dataItems.push_front(citer->second);
-            }
-        }
+        getCachedDataItems(s, dataItems);
 
         if (dataItems.empty()) {
             LOC_LOGv("No items to notify.");
         } else {
+            IF_LOC_LOGI {
+                string clientName;
+                to->getName(clientName);
+                for (auto item : dataItems) {
+                    string dv;
+                    item->stringify(dv);
+                    LOC_LOGI("DataItem: %s >> %s", dv.c_str(), clientName.c_str());
+                }
+            }
             to->notify(dataItems);
         }
     }
 }
 
+void SystemStatusOsObserver::sendToClients(const DataItemIdSet& dataItemIdsToBeSent)
+{
+    // Clients get the cached items themselves, not copies. Most of them
+    // are subscribed to everything that changed, so they all share one
+    // list; only the rest get a list of their own.
+    list<IDataItemCore*> allDataItems = {};
+    getCachedDataItems(dataItemIdsToBeSent, allDataItems);
+
+    for (auto& each : mClientToDataItems) {
+        IDataItemObserver* client = each.first;
+        DataItemIdSet dataItemIdsForThisClient = each.second & dataItemIdsToBeSent;
+
+        if (dataItemIdsForThisClient.none()) {
+            continue;
+        } else if (dataItemIdsForThisClient == dataItemIdsToBeSent) {
+            if (!allDataItems.empty()) {
+                IF_LOC_LOGV {
+                    string clientName;
+                    client->getName(clientName);
+                    LOC_LOGv("%zu DataItems >> %s", allDataItems.size(), clientName.c_str());
+                }
+                client->notify(allDataItems);
+            }
+        } else {
+            sendCachedDataItems(dataItemIdsForThisClient, client);
+        }
+    }
+}
+
+// Records the cached value of id as the one the clients last received.
+// Returns false if that is what they had already.
+bool SystemStatusOsObserver::updateDeliveredCache(DataItemId id)
+{
+    bool changed = false;
+    auto citer = mDataItemCache.find(id);
+    if (citer != mDataItemCache.end()) {
+        auto diter = mDeliveredCache.find(id);
+        if (diter == mDeliveredCache.end()) {
+            IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(id);
+            if (nullptr != dataitem) {
+                dataitem->copy(citer->second);
+                mDeliveredCache.insert(std::make_pair(id, dataitem));
+            }
+            changed = true;
+        } else {
+            diter->second->copy(citer->second, &changed);
+        }
+    }
+    return changed;
+}
+
+void SystemStatusOsObserver::deliverChanges(const DataItemIdSet& changed)
+{
+    if (0 == mCoalesceMsec) {
+        sendToClients(changed);
+        return;
+    }
+
+    // the first change after a quiet period goes out right away, repeats
+    // within the window are held back until flushCoalesced()
+    uint64_t nowMs = getBootTimeMilliSec();
+    bool wasPending = mCoalescePending.any();
+    DataItemIdSet dataItemIdsToBeSent;
+    for (size_t i = 0; i < changed.size(); i++) {
+        if (!changed.test(i) || mCoalescePending.test(i)) {
+            continue;
+        }
+        DataItemId id = (DataItemId)i;
+        auto titer = mDeliveredTimeMs.find(id);
+        if (titer == mDeliveredTimeMs.end() || nowMs - titer->second >= mCoalesceMsec) {
+            updateDeliveredCache(id);
+            mDeliveredTimeMs[id] = nowMs;
+            dataItemIdsToBeSent.set(id);
+        } else {
+            LOC_LOGv("DataItem:%d coalesced", id);
+            mCoalescePending.set(id);
+        }
+    }
+
+    // armed only by the first change held back in this window, later ones
+    // ride on it until flushCoalesced() empties mCoalescePending
+    if (!wasPending && mCoalescePending.any() && !mCoalesceTimerArmed) {
+        mCoalesceTimerArmed = mCoalesceTimer.start(mCoalesceMsec, false);
+        if (!mCoalesceTimerArmed) {
+            flushCoalesced();
+        }
+    }
+
+    if (dataItemIdsToBeSent.any()) {
+        sendToClients(dataItemIdsToBeSent);
+    }
+}
+
+void SystemStatusOsObserver::flushCoalesced()
+{
+    mCoalesceTimerArmed = false;
+
+    uint64_t nowMs = getBootTimeMilliSec();
+    DataItemIdSet dataItemIdsToBeSent;
+    for (size_t i = 0; i < mCoalescePending.size(); i++) {
+        if (!mCoalescePending.test(i)) {
+            continue;
+        }
+        DataItemId id = (DataItemId)i;
+        if (updateDeliveredCache(id)) {
+            mDeliveredTimeMs[id] = nowMs;
+            dataItemIdsToBeSent.set(id);
+        } else {
+            LOC_LOGv("DataItem:%d back to last delivered value, dropped", id);
+        }
+    }
+    mCoalescePending.reset();
+
+    if (dataItemIdsToBeSent.any()) {
+        sendToClients(dataItemIdsToBeSent);
+    }
+}
+
+// Called in the context of LocTimer thread
+void SystemStatusOsObserver::CoalesceTimer::timeOutCallback()
+{
+    struct HandleCoalesceTimeout : public LocMsg {
+        SystemStatusOsObserver& mObserver;
+        inline HandleCoalesceTimeout(SystemStatusOsObserver& observer) :
+                mObserver(observer) {}
+        void proc() const {
+            mObserver.flushCoalesced();
+        }
+    };
+    mObserver.mContext.mMsgTask->sendMsg(new (nothrow) HandleCoalesceTimeout(mObserver));
+}
+
+SystemStatusOsObserver::DataItemPool::DataItemPool()
+{
+    pthread_mutex_init(&mMutex, nullptr);
+}
+
+SystemStatusOsObserver::DataItemPool::~DataItemPool()
+{
+    clear();
+    pthread_mutex_destroy(&mMutex);
+}
+
+IDataItemCore* SystemStatusOsObserver::DataItemPool::acquire(DataItemId id)
+{
+    IDataItemCore* item = nullptr;
+    pthread_mutex_lock(&mMutex);
+    auto fiter = mFree.find(id);
+    if (fiter != mFree.end() && !fiter->second.empty()) {
+        item = fiter->second.back();
+        fiter->second.pop_back();
+    }
+    pthread_mutex_unlock(&mMutex);
+
+    if (nullptr == item) {
+        item = DataItemsFactoryProxy::createNewDataItem(id);
+    }
+    return item;
+}
+
+void SystemStatusOsObserver::DataItemPool::release(IDataItemCore* item)
+{
+    if (nullptr == item) {
+        return;
+    }
+    bool pooled = false;
+    pthread_mutex_lock(&mMutex);
+    vector<IDataItemCore*>& freeItems = mFree[item->getId()];
+    if (freeItems.size() < MAX_FREE_PER_ID) {
+        if (freeItems.capacity() < MAX_FREE_PER_ID) {
+            freeItems.reserve(MAX_FREE_PER_ID);
+        }
+        freeItems.push_back(item);
+        pooled = true;
+    }
+    pthread_mutex_unlock(&mMutex);
+
+    if (!pooled) {
+        delete item;
+    }
+}
+
+void SystemStatusOsObserver::DataItemPool::clear()
+{
+    pthread_mutex_lock(&mMutex);
+    for (auto& each : mFree) {
+        for (auto item : each.second) {
+            delete item;
+        }
+    }
+    mFree.clear();
+    pthread_mutex_unlock(&mMutex);
+}
+
 bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
 {
     bool dataItemUpdated = false;
@@ -30,18 +30,22 @@
 #define __SYSTEM_STATUS_OSOBSERVER__
 
 #include <cinttypes>
+#include <bitset>
 #include <string>
 #include <list>
 #include <map>
 #include <new>
 #include <vector>
+#include <pthread.h>
 
 #include <MsgTask.h>
 #include <DataItemId.h>
 #include <IOsObserver.h>
 #include <loc_pla.h>
 #include <log_util.h>
-#include <LocUnorderedSetMap.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <LocTimer.h>
 
 namespace loc_core
 {
@@ -56,10 +60,12 @@ class IDataItemCore;
 class SystemStatus;
 class SystemStatusOsObserver;
 typedef map<IDataItemObserver*, list<DataItemId>> ObserverReqCache;
-typedef LocUnorderedSetMap<IDataItemObserver*, DataItemId> ClientToDataItems;
-typedef LocUnorderedSetMap<DataItemId, IDataItemObserver*> DataItemToClients;
+// DataItemId is small and dense, so a set of them is a bitset indexed by id
+typedef bitset<MAX_DATA_ITEM_ID_1_1> DataItemIdSet;
+typedef unordered_map<IDataItemObserver*, DataItemIdSet> ClientToDataItems;
 typedef unordered_map<DataItemId, IDataItemCore*> DataItemIdToCore;
 typedef unordered_map<DataItemId, int> DataItemIdToInt;
+typedef unordered_map<DataItemId, uint64_t> DataItemIdToTime;
 #ifdef USE_GLIB
 // Cache details of backhaul client requests
 typedef unordered_set<string> ClientBackhaulReqCache;
@@ -84,21 +90,11 @@ class SystemStatusOsObserver : public IOsObserver {
 
 public:
     // ctor
-    inline SystemStatusOsObserver(SystemStatus* systemstatus, const MsgTask* msgTask) :
-            mSystemStatus(systemstatus), mContext(msgTask, this),
-            mAddress("SystemStatusOsObserver"),
-            mClientToDataItems(MAX_DATA_ITEM_ID), mDataItemToClients(MAX_DATA_ITEM_ID) {}
+    SystemStatusOsObserver(SystemStatus* systemstatus, const MsgTask* msgTask);
 
     // dtor
     ~SystemStatusOsObserver();
 
-    template <typename CINT, typename COUT>
-    static COUT containerTransfer(CINT& s);
-    template <typename CINT, typename COUT>
-    inline static COUT containerTransfer(CINT&& s) {
-        return containerTransfer<CINT, COUT>(s);
-    }
-
     // To set the subscription object
     virtual void setSubscriptionObj(IDataItemSubscription* subscriptionObj);
 
@@ -149,10 +145,69 @@ private:
     ObserverContext                                  mContext;
     const string                                     mAddress;
     ClientToDataItems                                mClientToDataItems;
-    DataItemToClients                                mDataItemToClients;
+    // union of all of mClientToDataItems, i.e. what the framework is asked for
+    DataItemIdSet                                    mSubscribedDataItems;
     DataItemIdToCore                                 mDataItemCache;
     DataItemIdToInt                                  mActiveRequestCount;
 
+    // Recycles the per notify() copies of incoming data items, so that a
+    // steady stream of network / screen state updates settles down to no
+    // factory allocations. acquire() is called on the notifier's thread,
+    // release() on the msg task thread once HandleNotify is done with it.
+    class DataItemPool {
+        static const size_t MAX_FREE_PER_ID = 4;
+        pthread_mutex_t mMutex;
+        unordered_map<DataItemId, vector<IDataItemCore*>> mFree;
+    public:
+        DataItemPool();
+        ~DataItemPool();
+        IDataItemCore* acquire(DataItemId id);
+        void release(IDataItemCore* item);
+        void clear();
+    };
+    DataItemPool                                     mDataItemPool;
+
+    // Change coalescing: an item that changes again within mCoalesceMsec
+    // of its last delivery is held back and delivered once, with its
+    // latest value, when the window closes. Items that changed and then
+    // flapped back to what the clients last saw are not delivered at all.
+    class CoalesceTimer : public LocTimer {
+        SystemStatusOsObserver& mObserver;
+    public:
+        inline CoalesceTimer(SystemStatusOsObserver& observer) :
+                LocTimer(), mObserver(observer) {}
+        virtual void timeOutCallback() override;
+    };
+    uint32_t                                         mCoalesceMsec;
+    CoalesceTimer                                    mCoalesceTimer;
+    bool                                             mCoalesceTimerArmed;
+    DataItemIdSet                                    mCoalescePending;
+    DataItemIdToCore                                 mDeliveredCache;
+    DataItemIdToTime                                 mDeliveredTimeMs;
+
+    // Framework action requests are reference counted per item and per
+    // backhaul client, only the first turnOn() / connectBackhaul() and the
+    // last turnOff() / disconnectBackhaul() reach the framework. The last
+    // one is held back for mActionDebounceMsec, and dropped together with
+    // the request that undoes it if that comes within the window.
+    class ActionDebounceTimer : public LocTimer {
+        SystemStatusOsObserver& mObserver;
+    public:
+        inline ActionDebounceTimer(SystemStatusOsObserver& observer) :
+                LocTimer(), mObserver(observer) {}
+        virtual void timeOutCallback() override;
+    };
+    uint32_t                                         mActionDebounceMsec;
+    ActionDebounceTimer                              mActionDebounceTimer;
+    bool                                             mActionDebounceTimerArmed;
+    // held back turnOff() per item, with when it is due
+    DataItemIdToTime                                 mTurnOffDueMs;
+#ifdef USE_GLIB
+    unordered_map<string, int>                       mBackhaulRefs;
+    // held back disconnectBackhaul() per client, with when it is due
+    unordered_map<string, uint64_t>                  mBackhaulDisconnectDueMs;
+#endif
+
     // Cache the subscribe and requestData till subscription obj is obtained
     void cacheObserverRequest(ObserverReqCache& reqCache,
             const list<DataItemId>& l, IDataItemObserver* client);
@@ -163,13 +218,36 @@ private:
 
     void subscribe(const list<DataItemId>& l, IDataItemObserver* client, bool toRequestData);
 
+    void handleTurnOn(DataItemId dit, int timeOut);
+    void handleTurnOff(DataItemId dit);
+#ifdef USE_GLIB
+    void handleConnectBackhaul(const string& clientName);
+    void handleDisconnectBackhaul(const string& clientName);
+#endif
+    void armActionDebounceTimer(uint64_t nowMs);
+    void flushDebouncedActions();
+
     // Helpers
-    void sendCachedDataItems(const unordered_set<DataItemId>& s, IDataItemObserver* to);
+    static DataItemIdSet toDataItemIdSet(const list<DataItemId>& l);
+    static list<DataItemId> toDataItemIdList(const DataItemIdSet& s);
+    // Sets the items client is subscribed to, an empty set dropping the
+    // client, and returns through added / removed how mSubscribedDataItems
+    // changed as a result
+    void setClientDataItems(IDataItemObserver* client, const DataItemIdSet& s,
+                            DataItemIdSet& added, DataItemIdSet& removed);
+    void sendCachedDataItems(const DataItemIdSet& s, IDataItemObserver* to);
+    void getCachedDataItems(const DataItemIdSet& s, list<IDataItemCore*>& dataItems);
     bool updateCache(IDataItemCore* d);
-    inline void logMe(const unordered_set<DataItemId>& l) {
+    void deliverChanges(const DataItemIdSet& changed);
+    void flushCoalesced();
+    bool updateDeliveredCache(DataItemId id);
+    void sendToClients(const DataItemIdSet& dataItemIdsToBeSent);
+    inline void logMe(const DataItemIdSet& s) {
         IF_LOC_LOGD {
-            for (auto id : l) {
-                LOC_LOGD("DataItem %d", id);
+            for (size_t id = 0; id < s.size(); id++) {
+                if (s.test(id)) {
+                    LOC_LOGD("DataItem %zu", id);
+                }
             }
         }
     }
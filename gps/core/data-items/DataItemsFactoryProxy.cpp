@@ -29,6 +29,7 @@
 #define LOG_TAG "DataItemsFactoryProxy"
 
 #include <dlfcn.h>
+#include <pthread.h>
 #include <DataItemId.h>
 #include <IDataItemCore.h>
 #include <DataItemsFactoryProxy.h>
@@ -39,22 +40,52 @@
 namespace loc_core
 {
 void* DataItemsFactoryProxy::dataItemLibHandle = NULL;
-get_concrete_data_item_fn* DataItemsFactoryProxy::getConcreteDIFunc = NULL;
+std::atomic<get_concrete_data_item_fn*> DataItemsFactoryProxy::getConcreteDIFunc(NULL);
+std::atomic<get_concrete_data_item_fn*>
+        DataItemsFactoryProxy::sFactoryTable[MAX_DATA_ITEM_ID_1_1] = {};
+
+static pthread_mutex_t sLibMutex = PTHREAD_MUTEX_INITIALIZER;
 
 IDataItemCore* DataItemsFactoryProxy::createNewDataItem(DataItemId id)
 {
     IDataItemCore *mydi = nullptr;
+    get_concrete_data_item_fn* fn = nullptr;
+
+    if (id > INVALID_DATA_ITEM_ID && id < MAX_DATA_ITEM_ID_1_1) {
+        fn = sFactoryTable[id].load(std::memory_order_acquire);
+    }
+    if (NULL == fn) {
+        fn = getConcreteDIFunc.load(std::memory_order_acquire);
+    }
+    if (NULL == fn && loadDataItemLibrary()) {
+        fn = getConcreteDIFunc.load(std::memory_order_acquire);
+    }
+
+    if (NULL != fn) {
+        mydi = (*fn)(id);
+    }
+    return mydi;
+}
 
-    if (NULL != getConcreteDIFunc) {
-        mydi = (*getConcreteDIFunc)(id);
+void DataItemsFactoryProxy::registerDataItemFactory(DataItemId id,
+                                                    get_concrete_data_item_fn* fn)
+{
+    if (id > INVALID_DATA_ITEM_ID && id < MAX_DATA_ITEM_ID_1_1) {
+        sFactoryTable[id].store(fn, std::memory_order_release);
     }
-    else {
-        getConcreteDIFunc = (get_concrete_data_item_fn * )
+}
+
+bool DataItemsFactoryProxy::loadDataItemLibrary()
+{
+    pthread_mutex_lock(&sLibMutex);
+    get_concrete_data_item_fn* fn = getConcreteDIFunc.load(std::memory_order_relaxed);
+    if (NULL == fn) {
+        fn = (get_concrete_data_item_fn * )
                 dlGetSymFromLib(dataItemLibHandle, DATA_ITEMS_LIB_NAME, DATA_ITEMS_GET_CONCRETE_DI);
 
-        if (NULL != getConcreteDIFunc) {
-            LOC_LOGd("Loaded function %s : %p", DATA_ITEMS_GET_CONCRETE_DI, getConcreteDIFunc);
-            mydi = (*getConcreteDIFunc)(id);
+        if (NULL != fn) {
+            LOC_LOGd("Loaded function %s : %p", DATA_ITEMS_GET_CONCRETE_DI, fn);
+            getConcreteDIFunc.store(fn, std::memory_order_release);
         }
         else {
             // dlysm failed.
@@ -66,15 +97,19 @@ IDataItemCore* DataItemsFactoryProxy::createNewDataItem(DataItemId id)
             LOC_LOGe("failed to find symbol %s; error=%s", DATA_ITEMS_GET_CONCRETE_DI, err);
         }
     }
-    return mydi;
+    pthread_mutex_unlock(&sLibMutex);
+    return (NULL != fn);
 }
 
 void DataItemsFactoryProxy::closeDataItemLibraryHandle()
 {
+    pthread_mutex_lock(&sLibMutex);
     if (NULL != dataItemLibHandle) {
+        getConcreteDIFunc.store(NULL, std::memory_order_release);
         dlclose(dataItemLibHandle);
         dataItemLibHandle = NULL;
     }
+    pthread_mutex_unlock(&sLibMutex);
 }
 
 } // namespace loc_core
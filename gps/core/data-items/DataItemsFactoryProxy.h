@@ -30,6 +30,7 @@
 #ifndef __DATAITEMFACTORYBASE__
 #define __DATAITEMFACTORYBASE__
 
+#include <atomic>
 #include <DataItemId.h>
 #include <IDataItemCore.h>
 
@@ -44,9 +45,24 @@ typedef IDataItemCore * (get_concrete_data_item_fn)(DataItemId);
 class DataItemsFactoryProxy {
 public:
     static IDataItemCore* createNewDataItem(DataItemId id);
+    // Statically linked concrete data items register their constructors
+    // here, per id, normally through a DataItemsFactoryRegistrar. Those ids
+    // are then created with an indexed call and never go through
+    // DATA_ITEMS_LIB_NAME, which stays the fallback for everything else.
+    static void registerDataItemFactory(DataItemId id, get_concrete_data_item_fn* fn);
+    // Resolves the library factory now instead of on first use
+    static bool loadDataItemLibrary();
     static void closeDataItemLibraryHandle();
     static void *dataItemLibHandle;
-    static get_concrete_data_item_fn *getConcreteDIFunc;
+    static std::atomic<get_concrete_data_item_fn*> getConcreteDIFunc;
+private:
+    static std::atomic<get_concrete_data_item_fn*> sFactoryTable[MAX_DATA_ITEM_ID_1_1];
+};
+
+struct DataItemsFactoryRegistrar {
+    inline DataItemsFactoryRegistrar(DataItemId id, get_concrete_data_item_fn* fn) {
+        DataItemsFactoryProxy::registerDataItemFactory(id, fn);
+    }
 };
 
 } // namespace loc_core
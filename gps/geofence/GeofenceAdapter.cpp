@@ -31,16 +31,43 @@
 #include <GeofenceAdapter.h>
 #include "loc_log.h"
 #include <log_util.h>
+#include <loc_cfg.h>
+#include <loc_misc_utils.h>
 #include <string>
+#include <new>
+#include <cstddef>
+#include <vector>
 
 using namespace loc_core;
 
 GeofenceAdapter::GeofenceAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   true /*isMaster*/, nullptr, true)
+                   true /*isMaster*/, nullptr, true),
+    mHwSlots(0),
+    mLastCell(0),
+    mSwapNeeded(false),
+    mSwOverflow(false),
+    mHasLastPosition(false),
+    mLastLatitude(0.0),
+    mLastLongitude(0.0)
 {
     LOC_LOGD("%s]: Constructor", __func__);
+    mReportedBreaches.store(0, std::memory_order_relaxed);
+    mEngineBreaches.store(0, std::memory_order_relaxed);
+
+    uint32_t hwSlots = 0;
+    uint32_t swOverflow = 0;
+    static const loc_param_s_type gps_conf_param_table[] =
+    {
+        {"GEOFENCE_HW_SLOTS", &hwSlots, NULL, 'n'},
+        {"GEOFENCE_SW_OVERFLOW", &swOverflow, NULL, 'n'},
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, gps_conf_param_table);
+    mHwSlots = hwSlots;
+    mSwOverflow = (0 != swOverflow);
+    LOC_LOGD("%s]: GEOFENCE_HW_SLOTS %u GEOFENCE_SW_OVERFLOW %d",
+             __func__, mHwSlots, mSwOverflow);
 
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
@@ -58,6 +85,7 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
         GeofenceKey key(it->first);
         if (client == key.client) {
             it = mGeofenceIds.erase(it);
+            mGrid.erase(key);
             mLocApi->removeGeofence(hwId, key.id,
                     new LocApiResponse(*getContext(),
                     [this, hwId] (LocationError err) {
@@ -75,6 +103,16 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
         ++it; // increment only when not erasing an iterator
     }
 
+    for (auto it = mParkedGeofences.begin(); it != mParkedGeofences.end();) {
+        if (client == it->first.client) {
+            mGrid.erase(it->first);
+            unwatchParkedGeofence(it->first);
+            it = mParkedGeofences.erase(it);
+            continue;
+        }
+        ++it;
+    }
+    mSwapNeeded = true;
 }
 
 void
@@ -85,6 +123,9 @@ GeofenceAdapter::updateClientsEventMask()
         if (it->second.geofenceBreachCb != nullptr) {
             mask |= LOC_API_ADAPTER_BIT_BATCHED_GENFENCE_BREACH_REPORT;
             mask |= LOC_API_ADAPTER_BIT_REPORT_GENFENCE_DWELL;
+            // positions feed the nearest geofence swap and the restore order
+            // after SSR, and only subscribed adapters get them from LocApiBase
+            mask |= LOC_API_ADAPTER_BIT_PARSED_POSITION_REPORT;
         }
         if (it->second.geofenceStatusCb != nullptr) {
             mask |= LOC_API_ADAPTER_BIT_GEOFENCE_GEN_ALERT;
@@ -128,10 +169,7 @@ GeofenceAdapter::handleEngineUpEvent()
             mAdapter.setEngineCapabilitiesKnown(true);
             mAdapter.broadcastCapabilities(mAdapter.getCapabilities());
             mAdapter.restartGeofences();
-            for (auto msg: mAdapter.mPendingMsgs) {
-                mAdapter.sendMsg(msg);
-            }
-            mAdapter.mPendingMsgs.clear();
+            mAdapter.replayPendingMsgs();
         }
     };
 
@@ -145,12 +183,46 @@ GeofenceAdapter::restartGeofences()
         return;
     }
 
-    GeofencesMap oldGeofences(mGeofences);
+    std::vector<GeofenceObject> oldGeofences;
+    oldGeofences.reserve(mGeofences.size());
+    for (auto it = mGeofences.begin(); it != mGeofences.end(); it++) {
+        oldGeofences.push_back(it->second);
+    }
     mGeofences.clear();
     mGeofenceIds.clear();
+    // loads in flight are lost with the engine; their fences are still parked
+    mLoadingGeofences.clear();
+    mSwapNeeded = true;
 
-    for (auto it = oldGeofences.begin(); it != oldGeofences.end(); it++) {
-        GeofenceObject object = it->second;
+    /* The engine takes the adds in the order issued, so restore the active fences
+       nearest to the last position first and the paused ones, which detect nothing,
+       last. A paused fence is paused again from its own add response. */
+    double latitude = 0.0;
+    double longitude = 0.0;
+    bool hasPosition = getLastPosition(latitude, longitude);
+    std::vector<std::pair<double, size_t>> order;
+    order.reserve(oldGeofences.size());
+    for (size_t i = 0; i < oldGeofences.size(); ++i) {
+        const GeofenceObject& object = oldGeofences[i];
+        double distance = 0.0;
+        if (hasPosition) {
+            distance = std::max(0.0, GeofenceGrid<GeofenceKey, GeofenceKeyHash>::distance(
+                    latitude, longitude, object.latitude, object.longitude) - object.radius);
+        }
+        if (object.paused) {
+            distance = HUGE_VAL;
+        }
+        order.emplace_back(distance, i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+            [] (const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) {
+        return a.first < b.first;
+    });
+    LOC_LOGD("%s]: restoring %zu geofences, %s", __func__, order.size(),
+             hasPosition ? "nearest first" : "no position known");
+
+    for (auto& entry : order) {
+        GeofenceObject object = oldGeofences[entry.second];
         GeofenceOption options = {sizeof(GeofenceOption),
                                    object.breachMask,
                                    object.responsiveness,
@@ -165,11 +237,18 @@ GeofenceAdapter::restartGeofences()
                               new LocApiResponseData<LocApiGeofenceData>(*getContext(),
                 [this, object, options, info] (LocationError err, LocApiGeofenceData data) {
             if (LOCATION_ERROR_SUCCESS == err) {
+                saveGeofenceItem(object.key.client, object.key.id, data.hwId, options, info);
                 if (true == object.paused) {
                     mLocApi->pauseGeofence(data.hwId, object.key.id,
                             new LocApiResponse(*getContext(), [] (LocationError err __unused) {}));
+                    pauseGeofenceItem(data.hwId);
+                }
+            } else if (LOCATION_ERROR_GEOFENCES_AT_MAX == err &&
+                       parkGeofenceItem(object.key.client, object.key.id, options, info, true)) {
+                // the engine came back with less room, the host watches the rest
+                if (true == object.paused) {
+                    pauseParkedGeofenceItem(object.key.client, object.key.id);
                 }
-                saveGeofenceItem(object.key.client, object.key.id, data.hwId, options, info);
             }
         }));
     }
@@ -203,6 +282,77 @@ GeofenceAdapter::reportResponse(LocationAPI* client, size_t count, LocationError
     }
 }
 
+void
+GeofenceAdapter::reportResponse(GeofenceBatch* batch, size_t index)
+{
+    // Send aggregated response on last item and cleanup
+    if (index == batch->count-1) {
+        reportResponse(batch->client, batch->count, batch->errs, batch->ids);
+        GeofenceBatch::destroy(batch);
+    }
+}
+
+// blocks of GEOFENCE_BATCH_CACHED_SIZE bytes; commands are created on client
+// threads and destroyed on the msg task
+static std::mutex sBatchCacheMutex;
+static std::vector<uint8_t*> sBatchCache;
+
+GeofenceBatch*
+GeofenceBatch::create(LocationAPI* client, size_t count, bool withOptions, bool withInfos)
+{
+    // one block: the header, then options, infos, errs and ids, each kept aligned
+    auto align = [] (size_t size) {
+        return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    };
+    size_t optionsOffset = align(sizeof(GeofenceBatch));
+    size_t infosOffset = optionsOffset + (withOptions ? align(count * sizeof(GeofenceOption)) : 0);
+    size_t errsOffset = infosOffset + (withInfos ? align(count * sizeof(GeofenceInfo)) : 0);
+    size_t idsOffset = errsOffset + align(count * sizeof(LocationError));
+    size_t size = idsOffset + count * sizeof(uint32_t);
+
+    bool cached = (size <= GEOFENCE_BATCH_CACHED_SIZE);
+    uint8_t* block = nullptr;
+    if (cached) {
+        std::lock_guard<std::mutex> lock(sBatchCacheMutex);
+        if (!sBatchCache.empty()) {
+            block = sBatchCache.back();
+            sBatchCache.pop_back();
+        }
+    }
+    if (nullptr == block) {
+        block = static_cast<uint8_t*>(
+                ::operator new(cached ? GEOFENCE_BATCH_CACHED_SIZE : size, std::nothrow));
+    }
+    if (nullptr == block) {
+        LOC_LOGE("%s]: new failed to allocate %zu bytes for %zu geofences",
+                 __func__, size, count);
+        return nullptr;
+    }
+    GeofenceBatch* batch = reinterpret_cast<GeofenceBatch*>(block);
+    batch->client = client;
+    batch->count = count;
+    batch->options = withOptions ?
+            reinterpret_cast<GeofenceOption*>(block + optionsOffset) : NULL;
+    batch->infos = withInfos ? reinterpret_cast<GeofenceInfo*>(block + infosOffset) : NULL;
+    batch->errs = reinterpret_cast<LocationError*>(block + errsOffset);
+    batch->ids = reinterpret_cast<uint32_t*>(block + idsOffset);
+    batch->cached = cached;
+    return batch;
+}
+
+void
+GeofenceBatch::destroy(GeofenceBatch* batch)
+{
+    if (batch->cached) {
+        std::lock_guard<std::mutex> lock(sBatchCacheMutex);
+        if (sBatchCache.size() < GEOFENCE_BATCH_MAX_CACHED) {
+            sBatchCache.push_back(reinterpret_cast<uint8_t*>(batch));
+            return;
+        }
+    }
+    ::operator delete(batch);
+}
+
 uint32_t*
 GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, GeofenceOption* options,
         GeofenceInfo* infos)
@@ -212,65 +362,53 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
     struct MsgAddGeofences : public LocMsg {
         GeofenceAdapter& mAdapter;
         LocApiBase& mApi;
-        LocationAPI* mClient;
-        size_t mCount;
-        uint32_t* mIds;
-        GeofenceOption* mOptions;
-        GeofenceInfo* mInfos;
+        GeofenceBatch* mBatch;
         inline MsgAddGeofences(GeofenceAdapter& adapter,
                                LocApiBase& api,
-                               LocationAPI* client,
-                               size_t count,
-                               uint32_t* ids,
-                               GeofenceOption* options,
-                               GeofenceInfo* infos) :
+                               GeofenceBatch* batch) :
             LocMsg(),
             mAdapter(adapter),
             mApi(api),
-            mClient(client),
-            mCount(count),
-            mIds(ids),
-            mOptions(options),
-            mInfos(infos) {}
+            mBatch(batch) {}
         inline virtual void proc() const {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
+            if (NULL == mBatch->options || NULL == mBatch->infos) {
+                for (size_t i=0; i < mBatch->count; ++i) {
+                    mBatch->errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
+                }
+                mAdapter.reportResponse(mBatch, mBatch->count-1);
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
-                if (NULL == mIds || NULL == mOptions || NULL == mInfos) {
-                    errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
-                } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                            mOptions = mOptions, mInfos = mInfos, mIds = mIds, &mApi = mApi,
-                            errs, i] (LocationError err __unused) {
-                        mApi.addGeofence(mIds[i], mOptions[i], mInfos[i],
-                        new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mOptions = mOptions, mClient = mClient,
-                        mCount = mCount, mIds = mIds, mInfos = mInfos, errs, i]
-                        (LocationError err, LocApiGeofenceData data) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                mAdapter.saveGeofenceItem(mClient,
-                                mIds[i],
-                                data.hwId,
-                                mOptions[i],
-                                mInfos[i]);
-                            }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                                delete[] mOptions;
-                                delete[] mInfos;
-                            }
-                        }));
+            mAdapter.mGeofences.reserve(mAdapter.mGeofences.size() + mBatch->count);
+            mAdapter.mGeofenceIds.reserve(mAdapter.mGeofenceIds.size() + mBatch->count);
+            for (size_t i=0; i < mBatch->count; ++i) {
+                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, &mApi = mApi, batch = mBatch, i]
+                        (LocationError err __unused) {
+                    if (mAdapter.parkGeofenceItem(batch->client, batch->ids[i],
+                                                  batch->options[i], batch->infos[i])) {
+                        batch->errs[i] = LOCATION_ERROR_SUCCESS;
+                        mAdapter.reportResponse(batch, i);
+                        return;
+                    }
+                    mApi.addGeofence(batch->ids[i], batch->options[i], batch->infos[i],
+                            new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
+                            [&mAdapter = mAdapter, batch, i]
+                            (LocationError err, LocApiGeofenceData data) {
+                        if (LOCATION_ERROR_SUCCESS == err) {
+                            mAdapter.saveGeofenceItem(batch->client,
+                                                      batch->ids[i],
+                                                      data.hwId,
+                                                      batch->options[i],
+                                                      batch->infos[i]);
+                        } else if (LOCATION_ERROR_GEOFENCES_AT_MAX == err &&
+                                   mAdapter.parkGeofenceItem(batch->client, batch->ids[i],
+                                           batch->options[i], batch->infos[i], true)) {
+                            err = LOCATION_ERROR_SUCCESS;
+                        }
+                        batch->errs[i] = err;
+                        mAdapter.reportResponse(batch, i);
                     }));
-                }
+                }));
             }
         }
     };
@@ -278,40 +416,18 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
     if (0 == count) {
         return NULL;
     }
-    uint32_t* ids = new uint32_t[count];
-    if (nullptr == ids) {
-        LOC_LOGE("%s]: new failed to allocate ids", __func__);
+    GeofenceBatch* batch = GeofenceBatch::create(client, count, options != NULL, infos != NULL);
+    if (nullptr == batch) {
         return NULL;
     }
-    if (NULL != ids) {
-        for (size_t i=0; i < count; ++i) {
-            ids[i] = generateSessionId();
-        }
-    }
-    GeofenceOption* optionsCopy;
-    if (options == NULL) {
-        optionsCopy = NULL;
-    } else {
-        optionsCopy = new GeofenceOption[count];
-        if (nullptr == optionsCopy) {
-            LOC_LOGE("%s]: new failed to allocate optionsCopy", __func__);
-            return NULL;
-        }
-        COPY_IF_NOT_NULL(optionsCopy, options, count);
-    }
-    GeofenceInfo* infosCopy;
-    if (infos == NULL) {
-        infosCopy = NULL;
-    } else {
-        infosCopy = new GeofenceInfo[count];
-        if (nullptr == infosCopy) {
-            LOC_LOGE("%s]: new failed to allocate infosCopy", __func__);
-            return NULL;
-        }
-        COPY_IF_NOT_NULL(infosCopy, infos, count);
+    for (size_t i=0; i < count; ++i) {
+        batch->ids[i] = generateSessionId();
     }
+    COPY_IF_NOT_NULL(batch->options, options, count);
+    COPY_IF_NOT_NULL(batch->infos, infos, count);
 
-    sendMsg(new MsgAddGeofences(*this, *mLocApi, client, count, ids, optionsCopy, infosCopy));
+    uint32_t* ids = batch->ids;
+    sendMsg(new MsgAddGeofences(*this, *mLocApi, batch));
     return ids;
 }
 
@@ -323,56 +439,35 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
     struct MsgRemoveGeofences : public LocMsg {
         GeofenceAdapter& mAdapter;
         LocApiBase& mApi;
-        LocationAPI* mClient;
-        size_t mCount;
-        uint32_t* mIds;
+        GeofenceBatch* mBatch;
         inline MsgRemoveGeofences(GeofenceAdapter& adapter,
                                   LocApiBase& api,
-                                  LocationAPI* client,
-                                  size_t count,
-                                  uint32_t* ids) :
+                                  GeofenceBatch* batch) :
             LocMsg(),
             mAdapter(adapter),
             mApi(api),
-            mClient(client),
-            mCount(count),
-            mIds(ids) {}
+            mBatch(batch) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
+            for (size_t i=0; i < mBatch->count; ++i) {
                 mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err __unused) {
+                        [&mAdapter = mAdapter, &mApi = mApi, batch = mBatch, i]
+                        (LocationError err __unused) {
                     uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.removeGeofence(hwId, mIds[i],
+                    batch->errs[i] = mAdapter.getHwIdFromClient(batch->client, batch->ids[i], hwId);
+                    if (LOCATION_ERROR_SUCCESS == batch->errs[i]) {
+                        mApi.removeGeofence(hwId, batch->ids[i],
                         new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
+                        [&mAdapter = mAdapter, batch, hwId, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.removeGeofenceItem(hwId);
                             }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                            }
+                            batch->errs[i] = err;
+                            mAdapter.reportResponse(batch, i);
                         }));
                     } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
-                        }
+                        batch->errs[i] = mAdapter.removeParkedGeofenceItem(batch->client,
+                                                                           batch->ids[i]);
+                        mAdapter.reportResponse(batch, i);
                     }
                 }));
             }
@@ -382,13 +477,12 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
     if (0 == count) {
         return;
     }
-    uint32_t* idsCopy = new uint32_t[count];
-    if (nullptr == idsCopy) {
-        LOC_LOGE("%s]: new failed to allocate idsCopy", __func__);
+    GeofenceBatch* batch = GeofenceBatch::create(client, count, false, false);
+    if (nullptr == batch) {
         return;
     }
-    COPY_IF_NOT_NULL(idsCopy, ids, count);
-    sendMsg(new MsgRemoveGeofences(*this, *mLocApi, client, count, idsCopy));
+    COPY_IF_NOT_NULL(batch->ids, ids, count);
+    sendMsg(new MsgRemoveGeofences(*this, *mLocApi, batch));
 }
 
 void
@@ -399,55 +493,35 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
     struct MsgPauseGeofences : public LocMsg {
         GeofenceAdapter& mAdapter;
         LocApiBase& mApi;
-        LocationAPI* mClient;
-        size_t mCount;
-        uint32_t* mIds;
+        GeofenceBatch* mBatch;
         inline MsgPauseGeofences(GeofenceAdapter& adapter,
                                  LocApiBase& api,
-                                 LocationAPI* client,
-                                 size_t count,
-                                 uint32_t* ids) :
+                                 GeofenceBatch* batch) :
             LocMsg(),
             mAdapter(adapter),
             mApi(api),
-            mClient(client),
-            mCount(count),
-            mIds(ids) {}
+            mBatch(batch) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
+            for (size_t i=0; i < mBatch->count; ++i) {
                 mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err __unused) {
+                        [&mAdapter = mAdapter, &mApi = mApi, batch = mBatch, i]
+                        (LocationError err __unused) {
                     uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.pauseGeofence(hwId, mIds[i], new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
+                    batch->errs[i] = mAdapter.getHwIdFromClient(batch->client, batch->ids[i], hwId);
+                    if (LOCATION_ERROR_SUCCESS == batch->errs[i]) {
+                        mApi.pauseGeofence(hwId, batch->ids[i],
+                        new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, batch, hwId, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
                                 mAdapter.pauseGeofenceItem(hwId);
                             }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                            }
+                            batch->errs[i] = err;
+                            mAdapter.reportResponse(batch, i);
                         }));
                     } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
-                        }
+                        batch->errs[i] = mAdapter.pauseParkedGeofenceItem(batch->client,
+                                                                          batch->ids[i]);
+                        mAdapter.reportResponse(batch, i);
                     }
                 }));
             }
@@ -457,13 +531,12 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
     if (0 == count) {
         return;
     }
-    uint32_t* idsCopy = new uint32_t[count];
-    if (nullptr == idsCopy) {
-        LOC_LOGE("%s]: new failed to allocate idsCopy", __func__);
+    GeofenceBatch* batch = GeofenceBatch::create(client, count, false, false);
+    if (nullptr == batch) {
         return;
     }
-    COPY_IF_NOT_NULL(idsCopy, ids, count);
-    sendMsg(new MsgPauseGeofences(*this, *mLocApi, client, count, idsCopy));
+    COPY_IF_NOT_NULL(batch->ids, ids, count);
+    sendMsg(new MsgPauseGeofences(*this, *mLocApi, batch));
 }
 
 void
@@ -474,56 +547,35 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
     struct MsgResumeGeofences : public LocMsg {
         GeofenceAdapter& mAdapter;
         LocApiBase& mApi;
-        LocationAPI* mClient;
-        size_t mCount;
-        uint32_t* mIds;
+        GeofenceBatch* mBatch;
         inline MsgResumeGeofences(GeofenceAdapter& adapter,
                                   LocApiBase& api,
-                                  LocationAPI* client,
-                                  size_t count,
-                                  uint32_t* ids) :
+                                  GeofenceBatch* batch) :
             LocMsg(),
             mAdapter(adapter),
             mApi(api),
-            mClient(client),
-            mCount(count),
-            mIds(ids) {}
+            mBatch(batch) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
-                return;
-            }
-            for (size_t i=0; i < mCount; ++i) {
+            for (size_t i=0; i < mBatch->count; ++i) {
                 mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError err __unused) {
+                        [&mAdapter = mAdapter, &mApi = mApi, batch = mBatch, i]
+                        (LocationError err __unused) {
                     uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.resumeGeofence(hwId, mIds[i],
-                                new LocApiResponse(*mAdapter.getContext(),
-                                [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, hwId,
-                                errs, mIds = mIds, i] (LocationError err ) {
+                    batch->errs[i] = mAdapter.getHwIdFromClient(batch->client, batch->ids[i], hwId);
+                    if (LOCATION_ERROR_SUCCESS == batch->errs[i]) {
+                        mApi.resumeGeofence(hwId, batch->ids[i],
+                        new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, batch, hwId, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
-                                errs[i] = err;
-
                                 mAdapter.resumeGeofenceItem(hwId);
-                                // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
-                                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                    delete[] errs;
-                                    delete[] mIds;
-                                }
                             }
+                            batch->errs[i] = err;
+                            mAdapter.reportResponse(batch, i);
                         }));
                     } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
-                        }
+                        batch->errs[i] = mAdapter.resumeParkedGeofenceItem(batch->client,
+                                                                           batch->ids[i]);
+                        mAdapter.reportResponse(batch, i);
                     }
                 }));
             }
@@ -533,13 +585,12 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
     if (0 == count) {
         return;
     }
-    uint32_t* idsCopy = new uint32_t[count];
-    if (nullptr == idsCopy) {
-        LOC_LOGE("%s]: new failed to allocate idsCopy", __func__);
+    GeofenceBatch* batch = GeofenceBatch::create(client, count, false, false);
+    if (nullptr == batch) {
         return;
     }
-    COPY_IF_NOT_NULL(idsCopy, ids, count);
-    sendMsg(new MsgResumeGeofences(*this, *mLocApi, client, count, idsCopy));
+    COPY_IF_NOT_NULL(batch->ids, ids, count);
+    sendMsg(new MsgResumeGeofences(*this, *mLocApi, batch));
 }
 
 void
@@ -551,68 +602,44 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
     struct MsgModifyGeofences : public LocMsg {
         GeofenceAdapter& mAdapter;
         LocApiBase& mApi;
-        LocationAPI* mClient;
-        size_t mCount;
-        uint32_t* mIds;
-        GeofenceOption* mOptions;
+        GeofenceBatch* mBatch;
         inline MsgModifyGeofences(GeofenceAdapter& adapter,
                                   LocApiBase& api,
-                                  LocationAPI* client,
-                                  size_t count,
-                                  uint32_t* ids,
-                                  GeofenceOption* options) :
+                                  GeofenceBatch* batch) :
             LocMsg(),
             mAdapter(adapter),
             mApi(api),
-            mClient(client),
-            mCount(count),
-            mIds(ids),
-            mOptions(options) {}
+            mBatch(batch) {}
         inline virtual void proc() const  {
-            LocationError* errs = new LocationError[mCount];
-            if (nullptr == errs) {
-                LOC_LOGE("%s]: new failed to allocate errs", __func__);
+            if (NULL == mBatch->options) {
+                for (size_t i=0; i < mBatch->count; ++i) {
+                    mBatch->errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
+                }
+                mAdapter.reportResponse(mBatch, mBatch->count-1);
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
-                if (NULL == mIds || NULL == mOptions) {
-                    errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
-                } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                            &mApi = mApi, mOptions = mOptions, errs, i] (LocationError err __unused) {
-                        uint32_t hwId = 0;
-                        errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                        if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                            mApi.modifyGeofence(hwId, mIds[i], mOptions[i],
-                                    new LocApiResponse(*mAdapter.getContext(),
-                                    [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                                    mIds = mIds, mOptions = mOptions, hwId, errs, i]
-                                    (LocationError err ) {
-                                if (LOCATION_ERROR_SUCCESS == err) {
-                                    errs[i] = err;
-
-                                    mAdapter.modifyGeofenceItem(hwId, mOptions[i]);
-                                }
-                                // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
-                                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                    delete[] errs;
-                                    delete[] mIds;
-                                    delete[] mOptions;
-                                }
-                            }));
-                        } else {
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                                delete[] mOptions;
+            for (size_t i=0; i < mBatch->count; ++i) {
+                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, &mApi = mApi, batch = mBatch, i]
+                        (LocationError err __unused) {
+                    uint32_t hwId = 0;
+                    batch->errs[i] = mAdapter.getHwIdFromClient(batch->client, batch->ids[i], hwId);
+                    if (LOCATION_ERROR_SUCCESS == batch->errs[i]) {
+                        mApi.modifyGeofence(hwId, batch->ids[i], batch->options[i],
+                        new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, batch, hwId, i] (LocationError err ) {
+                            if (LOCATION_ERROR_SUCCESS == err) {
+                                mAdapter.modifyGeofenceItem(hwId, batch->options[i]);
                             }
-                        }
-                    }));
-                }
+                            batch->errs[i] = err;
+                            mAdapter.reportResponse(batch, i);
+                        }));
+                    } else {
+                        batch->errs[i] = mAdapter.modifyParkedGeofenceItem(batch->client,
+                                batch->ids[i], batch->options[i]);
+                        mAdapter.reportResponse(batch, i);
+                    }
+                }));
             }
         }
     };
@@ -620,25 +647,13 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
     if (0 == count) {
         return;
     }
-    uint32_t* idsCopy = new uint32_t[count];
-    if (nullptr == idsCopy) {
-        LOC_LOGE("%s]: new failed to allocate idsCopy", __func__);
+    GeofenceBatch* batch = GeofenceBatch::create(client, count, options != NULL, false);
+    if (nullptr == batch) {
         return;
     }
-    COPY_IF_NOT_NULL(idsCopy, ids, count);
-    GeofenceOption* optionsCopy;
-    if (options == NULL) {
-        optionsCopy = NULL;
-    } else {
-        optionsCopy = new GeofenceOption[count];
-        if (nullptr == optionsCopy) {
-            LOC_LOGE("%s]: new failed to allocate optionsCopy", __func__);
-            return;
-        }
-        COPY_IF_NOT_NULL(optionsCopy, options, count);
-    }
-
-    sendMsg(new MsgModifyGeofences(*this, *mLocApi, client, count, idsCopy, optionsCopy));
+    COPY_IF_NOT_NULL(batch->ids, ids, count);
+    COPY_IF_NOT_NULL(batch->options, options, count);
+    sendMsg(new MsgModifyGeofences(*this, *mLocApi, batch));
 }
 
 void
@@ -657,6 +672,7 @@ GeofenceAdapter::saveGeofenceItem(LocationAPI* client, uint32_t clientId, uint32
                              false};
     mGeofences[hwId] = object;
     mGeofenceIds[key] = hwId;
+    mGrid.insert(key, info.latitude, info.longitude, info.radius);
     dump();
 }
 
@@ -671,6 +687,8 @@ GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
         auto it1 = mGeofenceIds.find(key);
         if (it1 != mGeofenceIds.end()) {
             mGeofenceIds.erase(it1);
+            mGrid.erase(key);
+            mSwapNeeded = true;
 
             auto it2 = mGeofences.find(hwId);
             if (it2 != mGeofences.end()) {
@@ -691,6 +709,8 @@ GeofenceAdapter::pauseGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = true;
+        mGrid.erase(it->second.key);
+        mSwapNeeded = true;
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to pause not found. hwId %u", __func__, hwId);
@@ -703,6 +723,9 @@ GeofenceAdapter::resumeGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = false;
+        mGrid.insert(it->second.key, it->second.latitude, it->second.longitude,
+                     it->second.radius);
+        mSwapNeeded = true;
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to resume not found. hwId %u", __func__, hwId);
@@ -723,6 +746,369 @@ GeofenceAdapter::modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options
     }
 }
 
+bool
+GeofenceAdapter::parkGeofenceItem(LocationAPI* client, uint32_t clientId,
+        const GeofenceOption& options, const GeofenceInfo& info, bool engineFull)
+{
+    if (engineFull) {
+        // only watched fences may be left out of the engine
+        if (!mSwOverflow) {
+            return false;
+        }
+    } else if (0 == mHwSlots || mGeofences.size() + mLoadingGeofences.size() < mHwSlots) {
+        return false;
+    }
+    LOC_LOGD("%s]: client %p clientId %u%s", __func__, client, clientId,
+             engineFull ? ", engine full" : "");
+    GeofenceKey key(client, clientId);
+    GeofenceObject object = {key,
+                             options.breachTypeMask,
+                             options.responsiveness,
+                             options.dwellTime,
+                             info.latitude,
+                             info.longitude,
+                             info.radius,
+                             false};
+    mParkedGeofences[key] = object;
+    mGrid.insert(key, info.latitude, info.longitude, info.radius);
+    watchParkedGeofence(object);
+    mSwapNeeded = true;
+    return true;
+}
+
+LocationError
+GeofenceAdapter::removeParkedGeofenceItem(LocationAPI* client, uint32_t clientId)
+{
+    GeofenceKey key(client, clientId);
+    auto it = mParkedGeofences.find(key);
+    if (it == mParkedGeofences.end()) {
+        return LOCATION_ERROR_ID_UNKNOWN;
+    }
+    mParkedGeofences.erase(it);
+    mGrid.erase(key);
+    unwatchParkedGeofence(key);
+    return LOCATION_ERROR_SUCCESS;
+}
+
+LocationError
+GeofenceAdapter::pauseParkedGeofenceItem(LocationAPI* client, uint32_t clientId)
+{
+    GeofenceKey key(client, clientId);
+    auto it = mParkedGeofences.find(key);
+    if (it == mParkedGeofences.end()) {
+        return LOCATION_ERROR_ID_UNKNOWN;
+    }
+    it->second.paused = true;
+    mGrid.erase(key);
+    unwatchParkedGeofence(key);
+    return LOCATION_ERROR_SUCCESS;
+}
+
+LocationError
+GeofenceAdapter::resumeParkedGeofenceItem(LocationAPI* client, uint32_t clientId)
+{
+    GeofenceKey key(client, clientId);
+    auto it = mParkedGeofences.find(key);
+    if (it == mParkedGeofences.end()) {
+        return LOCATION_ERROR_ID_UNKNOWN;
+    }
+    it->second.paused = false;
+    mGrid.insert(key, it->second.latitude, it->second.longitude, it->second.radius);
+    watchParkedGeofence(it->second);
+    mSwapNeeded = true;
+    return LOCATION_ERROR_SUCCESS;
+}
+
+LocationError
+GeofenceAdapter::modifyParkedGeofenceItem(LocationAPI* client, uint32_t clientId,
+        const GeofenceOption& options)
+{
+    auto it = mParkedGeofences.find(GeofenceKey(client, clientId));
+    if (it == mParkedGeofences.end()) {
+        return LOCATION_ERROR_ID_UNKNOWN;
+    }
+    it->second.breachMask = options.breachTypeMask;
+    it->second.responsiveness = options.responsiveness;
+    it->second.dwellTime = options.dwellTime;
+    mEvaluator.modify(it->first, options.breachTypeMask, options.dwellTime);
+    return LOCATION_ERROR_SUCCESS;
+}
+
+void
+GeofenceAdapter::reportPositionEvent(const UlpLocation& location,
+                                     const GpsLocationExtended& /*locationExtended*/,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask /*loc_technology_mask*/,
+                                     GnssDataNotification* /*pDataNotify*/,
+                                     int /*msInWeek*/)
+{
+    if (LOC_SESS_FAILURE == status ||
+        !(location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(mLastPositionLock);
+        mHasLastPosition = true;
+        mLastLatitude = location.gpsLocation.latitude;
+        mLastLongitude = location.gpsLocation.longitude;
+    }
+    if (0 == mHwSlots && !mSwOverflow) {
+        return;
+    }
+
+    struct MsgGeofencePosition : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        Location mLocation;
+        inline MsgGeofencePosition(GeofenceAdapter& adapter,
+                                   const Location& location) :
+            LocMsg(),
+            mAdapter(adapter),
+            mLocation(location) {}
+        inline virtual void proc() const {
+            // the parked fences see the position before a swap hands some to the engine
+            mAdapter.evaluateParkedGeofences(mLocation);
+            mAdapter.swapGeofences(mLocation.latitude, mLocation.longitude);
+        }
+    };
+
+    Location position = {};
+    position.size = sizeof(Location);
+    position.flags = LOCATION_HAS_LAT_LONG_BIT;
+    position.timestamp = location.gpsLocation.timestamp;
+    position.latitude = location.gpsLocation.latitude;
+    position.longitude = location.gpsLocation.longitude;
+    if (LOC_GPS_LOCATION_HAS_ALTITUDE & location.gpsLocation.flags) {
+        position.flags |= LOCATION_HAS_ALTITUDE_BIT;
+        position.altitude = location.gpsLocation.altitude;
+    }
+    if (LOC_GPS_LOCATION_HAS_SPEED & location.gpsLocation.flags) {
+        position.flags |= LOCATION_HAS_SPEED_BIT;
+        position.speed = location.gpsLocation.speed;
+    }
+    if (LOC_GPS_LOCATION_HAS_BEARING & location.gpsLocation.flags) {
+        position.flags |= LOCATION_HAS_BEARING_BIT;
+        position.bearing = location.gpsLocation.bearing;
+    }
+    if (LOC_GPS_LOCATION_HAS_ACCURACY & location.gpsLocation.flags) {
+        position.flags |= LOCATION_HAS_ACCURACY_BIT;
+        position.accuracy = location.gpsLocation.accuracy;
+    }
+    sendMsg(new MsgGeofencePosition(*this, position));
+}
+
+void
+GeofenceAdapter::reportLocationsEvent(const Location* locations, size_t count,
+                                      BatchingMode /*batchingMode*/)
+{
+    if (!mSwOverflow || nullptr == locations || 0 == count) {
+        return;
+    }
+
+    struct MsgGeofenceLocations : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        std::vector<Location> mLocations;
+        inline MsgGeofenceLocations(GeofenceAdapter& adapter,
+                                    const Location* locations,
+                                    size_t count) :
+            LocMsg(),
+            mAdapter(adapter),
+            mLocations(locations, locations + count) {}
+        inline virtual void proc() const {
+            // batched fixes only catch the parked fences up, the engine saw them already
+            for (const Location& location : mLocations) {
+                if (location.flags & LOCATION_HAS_LAT_LONG_BIT) {
+                    mAdapter.evaluateParkedGeofences(location);
+                }
+            }
+        }
+    };
+
+    sendMsg(new MsgGeofenceLocations(*this, locations, count));
+}
+
+void
+GeofenceAdapter::evaluateParkedGeofences(const Location& location)
+{
+    if (0 == mEvaluator.size()) {
+        return;
+    }
+    double accuracy = (location.flags & LOCATION_HAS_ACCURACY_BIT) ? location.accuracy : 0.0;
+    std::vector<GeofenceEvaluator<GeofenceKey, GeofenceKeyHash>::Breach> breaches;
+    mEvaluator.evaluate(location.latitude, location.longitude, accuracy,
+                        location.timestamp, breaches);
+    if (breaches.empty()) {
+        return;
+    }
+    LOC_LOGD("%s]: %zu breaches of %zu watched fences", __func__,
+             breaches.size(), mEvaluator.size());
+
+    // one report per breach type, as from the engine
+    std::vector<GeofenceKey> keys;
+    keys.reserve(breaches.size());
+    for (int type = GEOFENCE_BREACH_ENTER; type < GEOFENCE_BREACH_UNKNOWN; ++type) {
+        keys.clear();
+        for (auto& breach : breaches) {
+            if (type == breach.type) {
+                keys.push_back(breach.key);
+            }
+        }
+        if (!keys.empty()) {
+            geofenceBreach(keys, location, (GeofenceBreachType)type, location.timestamp);
+        }
+    }
+}
+
+void
+GeofenceAdapter::watchParkedGeofence(const GeofenceObject& object)
+{
+    if (mSwOverflow && !object.paused) {
+        mEvaluator.insert(object.key, object.latitude, object.longitude, object.radius,
+                          object.breachMask, object.dwellTime);
+    }
+}
+
+void
+GeofenceAdapter::unwatchParkedGeofence(const GeofenceKey& key)
+{
+    mEvaluator.erase(key);
+}
+
+bool
+GeofenceAdapter::getLastPosition(double& latitude, double& longitude)
+{
+    std::lock_guard<std::mutex> guard(mLastPositionLock);
+    latitude = mLastLatitude;
+    longitude = mLastLongitude;
+    return mHasLastPosition;
+}
+
+void
+GeofenceAdapter::swapGeofences(double latitude, double longitude)
+{
+    // re-select only when the device changes grid cell or the fences changed
+    uint64_t cell = mGrid.cellOf(latitude, longitude);
+    if (0 == mHwSlots || (!mSwapNeeded && cell == mLastCell)) {
+        return;
+    }
+    mLastCell = cell;
+    mSwapNeeded = false;
+    if (mParkedGeofences.empty()) {
+        return;
+    }
+
+    std::vector<GeofenceKey> nearest;
+    mGrid.nearest(latitude, longitude, mHwSlots, nearest);
+    GeofenceKeySet wanted(nearest.begin(), nearest.end());
+
+    std::vector<GeofenceKey> toLoad;
+    for (auto& key : nearest) {
+        if (mParkedGeofences.count(key) > 0 && mLoadingGeofences.count(key) == 0) {
+            toLoad.push_back(key);
+        }
+    }
+    if (toLoad.empty()) {
+        return;
+    }
+
+    size_t used = mGeofences.size() + mLoadingGeofences.size();
+    size_t freeSlots = (used < mHwSlots) ? mHwSlots - used : 0;
+    std::vector<uint32_t> toUnload;
+    for (auto it = mGeofences.begin();
+         it != mGeofences.end() && freeSlots + toUnload.size() < toLoad.size(); ++it) {
+        if (wanted.count(it->second.key) == 0) {
+            toUnload.push_back(it->first);
+        }
+    }
+    LOC_LOGD("%s]: load %zu unload %zu of %zu fences, %zu parked", __func__,
+             toLoad.size(), toUnload.size(), mGrid.size(), mParkedGeofences.size());
+
+    for (uint32_t hwId : toUnload) {
+        unloadGeofence(hwId);
+    }
+    toLoad.resize(std::min(toLoad.size(), freeSlots + toUnload.size()));
+    for (auto& key : toLoad) {
+        loadGeofence(key);
+    }
+}
+
+void
+GeofenceAdapter::unloadGeofence(uint32_t hwId)
+{
+    auto it = mGeofences.find(hwId);
+    if (it == mGeofences.end()) {
+        return;
+    }
+    // parked right away, so client commands issued meanwhile apply to the parked copy
+    GeofenceObject object = it->second;
+    mGeofences.erase(it);
+    mGeofenceIds.erase(object.key);
+    mParkedGeofences[object.key] = object;
+    watchParkedGeofence(object);
+
+    mLocApi->removeGeofence(hwId, object.key.id,
+            new LocApiResponse(*getContext(), [hwId] (LocationError err) {
+        if (LOCATION_ERROR_SUCCESS != err) {
+            LOC_LOGE("%s]: failed to unload hwId %u err %u", __func__, hwId, err);
+        }
+    }));
+}
+
+void
+GeofenceAdapter::loadGeofence(const GeofenceKey& key)
+{
+    auto it = mParkedGeofences.find(key);
+    if (it == mParkedGeofences.end()) {
+        return;
+    }
+    GeofenceObject object = it->second;
+    GeofenceOption options = {sizeof(GeofenceOption),
+                               object.breachMask,
+                               object.responsiveness,
+                               object.dwellTime};
+    GeofenceInfo info = {sizeof(GeofenceInfo),
+                         object.latitude,
+                         object.longitude,
+                         object.radius};
+    mLoadingGeofences.insert(key);
+    mLocApi->addGeofence(key.id, options, info,
+            new LocApiResponseData<LocApiGeofenceData>(*getContext(),
+            [this, key, options, info] (LocationError err, LocApiGeofenceData data) {
+        mLoadingGeofences.erase(key);
+        if (LOCATION_ERROR_SUCCESS != err) {
+            LOC_LOGE("%s]: failed to load clientId %u err %u", __func__, key.id, err);
+            return;
+        }
+        auto it = mParkedGeofences.find(key);
+        if (it == mParkedGeofences.end()) {
+            // removed by its client while loading
+            mLocApi->removeGeofence(data.hwId, key.id,
+                    new LocApiResponse(*getContext(), [] (LocationError err __unused) {}));
+            return;
+        }
+        GeofenceObject object = it->second;
+        mParkedGeofences.erase(it);
+        unwatchParkedGeofence(key);
+        saveGeofenceItem(key.client, key.id, data.hwId, options, info);
+        if (object.breachMask != options.breachTypeMask ||
+            object.responsiveness != options.responsiveness ||
+            object.dwellTime != options.dwellTime) {
+            // modified by its client while loading
+            GeofenceOption modified = {sizeof(GeofenceOption),
+                                       object.breachMask,
+                                       object.responsiveness,
+                                       object.dwellTime};
+            mLocApi->modifyGeofence(data.hwId, key.id, modified,
+                    new LocApiResponse(*getContext(), [] (LocationError err __unused) {}));
+            modifyGeofenceItem(data.hwId, modified);
+        }
+        if (true == object.paused) {
+            mLocApi->pauseGeofence(data.hwId, key.id,
+                    new LocApiResponse(*getContext(), [] (LocationError err __unused) {}));
+            pauseGeofenceItem(data.hwId);
+        }
+    }));
+}
+
 
 void
 GeofenceAdapter::geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
@@ -747,7 +1133,7 @@ GeofenceAdapter::geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& lo
     struct MsgGeofenceBreach : public LocMsg {
         GeofenceAdapter& mAdapter;
         size_t mCount;
-        uint32_t* mHwIds;
+        loc_util::LocInlineArray<uint32_t, GEOFENCE_BREACH_INLINE_IDS> mHwIds;
         Location mLocation;
         GeofenceBreachType mBreachType;
         uint64_t mTimestamp;
@@ -760,22 +1146,19 @@ GeofenceAdapter::geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& lo
             LocMsg(),
             mAdapter(adapter),
             mCount(count),
-            mHwIds(new uint32_t[count]),
+            mHwIds(hwIds, count),
             mLocation(location),
             mBreachType(breachType),
             mTimestamp(timestamp)
         {
-            if (nullptr == mHwIds) {
+            if (mHwIds.size() != mCount) {
                 LOC_LOGE("%s]: new failed to allocate mHwIds", __func__);
-                return;
+                mCount = 0;
             }
-            COPY_IF_NOT_NULL(mHwIds, hwIds, mCount);
-        }
-        inline virtual ~MsgGeofenceBreach() {
-            delete[] mHwIds;
         }
         inline virtual void proc() const {
-            mAdapter.geofenceBreach(mCount, mHwIds, mLocation, mBreachType, mTimestamp);
+            mAdapter.geofenceBreach(mCount, (uint32_t*)mHwIds.data(), mLocation, mBreachType,
+                                    mTimestamp);
         }
     };
 
@@ -788,32 +1171,47 @@ GeofenceAdapter::geofenceBreach(size_t count, uint32_t* hwIds, const Location& l
         GeofenceBreachType breachType, uint64_t timestamp)
 {
 
+    // translate every hwId once, then hand each client its own ids
+    std::vector<GeofenceKey> keys;
+    keys.reserve(count);
+    for (size_t i=0; i < count; ++i) {
+        GeofenceKey key;
+        if (LOCATION_ERROR_SUCCESS == getGeofenceKeyFromHwId(hwIds[i], key)) {
+            keys.push_back(key);
+        }
+    }
+    if (!keys.empty()) {
+        mEngineBreaches.fetch_add(keys.size(), std::memory_order_relaxed);
+        geofenceBreach(keys, location, breachType, timestamp);
+    }
+}
+
+void
+GeofenceAdapter::geofenceBreach(const std::vector<GeofenceKey>& keys, const Location& location,
+        GeofenceBreachType breachType, uint64_t timestamp)
+{
+    mReportedBreaches.fetch_add(keys.size(), std::memory_order_relaxed);
+    std::vector<uint32_t> clientIds(keys.size());
     for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        uint32_t* clientIds = new uint32_t[count];
-        if (nullptr == clientIds) {
-            return;
+        if (it->second.geofenceBreachCb == nullptr) {
+            continue;
         }
         uint32_t index = 0;
-        for (size_t i=0; i < count; ++i) {
-            GeofenceKey key;
-            LocationError err = getGeofenceKeyFromHwId(hwIds[i], key);
-            if (LOCATION_ERROR_SUCCESS == err) {
-                if (key.client == it->first) {
-                    clientIds[index++] = key.id;
-                }
+        for (auto& key : keys) {
+            if (key.client == it->first) {
+                clientIds[index++] = key.id;
             }
         }
-        if (index > 0 && it->second.geofenceBreachCb != nullptr) {
+        if (index > 0) {
             GeofenceBreachNotification notify = {sizeof(GeofenceBreachNotification),
                                                  index,
-                                                 clientIds,
+                                                 clientIds.data(),
                                                  location,
                                                  breachType,
                                                  timestamp};
 
             it->second.geofenceBreachCb(notify);
         }
-        delete[] clientIds;
     }
 }
 
@@ -865,6 +1263,22 @@ GeofenceAdapter::dump()
                     object.latitude, object.longitude, object.radius,
                     object.paused, object.key.id, object.key.client);
         }
+        for (auto it = mParkedGeofences.begin(); it != mParkedGeofences.end(); ++it) {
+            GeofenceObject object = it->second;
+            LOC_LOGV("    | park  | %4u | %6u | %8.2f | %9.2f | %6.2f | %6u | %04x | %p ",
+                    object.breachMask, object.responsiveness,
+                    object.latitude, object.longitude, object.radius,
+                    object.paused, object.key.id, object.key.client);
+        }
     }
 }
 
+void
+GeofenceAdapter::dumpStats(std::string& out) const
+{
+    uint64_t reported = mReportedBreaches.load(std::memory_order_relaxed);
+    uint64_t engine = mEngineBreaches.load(std::memory_order_relaxed);
+    out += "Geofence: breaches=" + std::to_string(reported) + " engine=" +
+            std::to_string(engine) + " host=" +
+            std::to_string((reported > engine) ? reported - engine : 0) + "\n";
+}
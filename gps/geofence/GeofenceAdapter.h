@@ -32,10 +32,20 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
-#include <map>
+#include <GeofenceGrid.h>
+#include <GeofenceEvaluator.h>
+#include <LocMemStats.h>
+#include <LocInlineArray.h>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
 
 using namespace loc_core;
 
+// hw ids of a breach report held inline, more come only when many fences share it
+#define GEOFENCE_BREACH_INLINE_IDS 8
+
 #define COPY_IF_NOT_NULL(dest, src, len) do { \
     if (NULL!=dest && NULL!=src) { \
         for (size_t i=0; i<len; ++i) { \
@@ -61,6 +71,12 @@ inline bool operator ==(GeofenceKey const& left, GeofenceKey const& right) {
 inline bool operator !=(GeofenceKey const& left, GeofenceKey const& right) {
     return left.id != right.id || left.client != right.client;
 }
+struct GeofenceKeyHash {
+    inline size_t operator()(GeofenceKey const& key) const {
+        return std::hash<uintptr_t>()((uintptr_t)key.client) ^
+                (std::hash<uint32_t>()(key.id) * 0x9E3779B1u);
+    }
+};
 typedef struct {
     GeofenceKey key;
     GeofenceBreachTypeMask breachMask;
@@ -71,14 +87,70 @@ typedef struct {
     double radius;
     bool paused;
 } GeofenceObject;
-typedef std::map<uint32_t, GeofenceObject> GeofencesMap; //map of hwId to GeofenceObject
-typedef std::map<GeofenceKey, uint32_t> GeofenceIdMap; //map of GeofenceKey to hwId
+// the maps are accounted as LOC_MEM_GEOFENCE, see MEM_ACCOUNTING_ENABLED
+template <typename T>
+using GeofenceAllocator = loc_util::LocMemAllocator<T, loc_util::LOC_MEM_GEOFENCE>;
+typedef std::unordered_map<uint32_t, GeofenceObject, std::hash<uint32_t>,
+        std::equal_to<uint32_t>, GeofenceAllocator<std::pair<const uint32_t, GeofenceObject>>>
+        GeofencesMap; //map of hwId to GeofenceObject
+typedef std::unordered_map<GeofenceKey, uint32_t, GeofenceKeyHash, std::equal_to<GeofenceKey>,
+        GeofenceAllocator<std::pair<const GeofenceKey, uint32_t>>>
+        GeofenceIdMap; //map of GeofenceKey to hwId
+typedef std::unordered_map<GeofenceKey, GeofenceObject, GeofenceKeyHash,
+        std::equal_to<GeofenceKey>, GeofenceAllocator<std::pair<const GeofenceKey, GeofenceObject>>>
+        ParkedGeofencesMap; //fences not loaded in engine
+typedef std::unordered_set<GeofenceKey, GeofenceKeyHash, std::equal_to<GeofenceKey>,
+        GeofenceAllocator<GeofenceKey>> GeofenceKeySet;
+
+/* State of one add/remove/pause/resume/modify command, carried from the client thread
+   to the last engine response. The arrays are laid out in the same allocation; ids is
+   what addGeofencesCommand returns, valid until the collective response is reported.
+   Blocks of up to GEOFENCE_BATCH_CACHED_SIZE bytes, which covers commands of a few
+   fences, are kept for the next command rather than freed. */
+#define GEOFENCE_BATCH_CACHED_SIZE 1024
+#define GEOFENCE_BATCH_MAX_CACHED 8
+struct GeofenceBatch {
+    LocationAPI* client;
+    size_t count;
+    uint32_t* ids;
+    LocationError* errs;
+    GeofenceOption* options; // NULL if the command has none
+    GeofenceInfo* infos;     // NULL if the command has none
+    bool cached;             // block is GEOFENCE_BATCH_CACHED_SIZE bytes
+
+    static GeofenceBatch* create(LocationAPI* client, size_t count,
+                                 bool withOptions, bool withInfos);
+    static void destroy(GeofenceBatch* batch);
+};
 
 class GeofenceAdapter : public LocAdapterBase {
 
     /* ==== GEOFENCES ====================================================================== */
     GeofencesMap mGeofences; //map hwId to GeofenceObject
     GeofenceIdMap mGeofenceIds; //map of GeofenceKey to hwId
+    /* With GEOFENCE_HW_SLOTS set, at most that many fences are loaded in the engine,
+       the ones nearest to the last position; the others are parked here until the
+       device moves near them. mGrid indexes every fence that is not paused. */
+    ParkedGeofencesMap mParkedGeofences;
+    GeofenceKeySet mLoadingGeofences; //parked fences being loaded in engine
+    GeofenceGrid<GeofenceKey, GeofenceKeyHash> mGrid;
+    uint32_t mHwSlots;
+    uint64_t mLastCell;
+    bool mSwapNeeded;
+    /* With GEOFENCE_SW_OVERFLOW set, the parked fences are watched on the host from
+       the positions the engine reports, and a fence the engine has no room for is
+       parked instead of failing. mEvaluator holds every parked fence not paused. */
+    GeofenceEvaluator<GeofenceKey, GeofenceKeyHash> mEvaluator;
+    bool mSwOverflow;
+    // last position reported by the engine, written from the QMI thread
+    std::mutex mLastPositionLock;
+    bool mHasLastPosition;
+    double mLastLatitude;
+    double mLastLongitude;
+    // fences in the breaches reported, and those of them the engine found;
+    // written on the adapter thread, read by dumpStats()
+    std::atomic<uint64_t> mReportedBreaches;
+    std::atomic<uint64_t> mEngineBreaches;
 
 protected:
 
@@ -97,6 +169,25 @@ public:
     /* ======== UTILITIES ================================================================== */
     void restartGeofences();
 
+    /* ==== POSITION ======================================================================= */
+    /* ======== EVENTS ====(Called from QMI Thread)========================================= */
+    virtual void reportPositionEvent(const UlpLocation& location,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask loc_technology_mask,
+                                     GnssDataNotification* pDataNotify = nullptr,
+                                     int msInWeek = -1);
+    virtual void reportLocationsEvent(const Location* locations, size_t count,
+                                      BatchingMode batchingMode);
+    /* ======== UTILITIES ================================================================== */
+    bool getLastPosition(double& latitude, double& longitude);
+    void evaluateParkedGeofences(const Location& location);
+    void watchParkedGeofence(const GeofenceObject& object);
+    void unwatchParkedGeofence(const GeofenceKey& key);
+    void swapGeofences(double latitude, double longitude);
+    void loadGeofence(const GeofenceKey& key);
+    void unloadGeofence(uint32_t hwId);
+
     /* ==== GEOFENCES ====================================================================== */
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
     uint32_t* addGeofencesCommand(LocationAPI* client, size_t count,
@@ -108,6 +199,7 @@ public:
                                 GeofenceOption* options);
     /* ======== RESPONSES ================================================================== */
     void reportResponse(LocationAPI* client, size_t count, LocationError* errs, uint32_t* ids);
+    void reportResponse(GeofenceBatch* batch, size_t index);
     /* ======== UTILITIES ================================================================== */
     void saveGeofenceItem(LocationAPI* client,
                           uint32_t clientId,
@@ -118,9 +210,21 @@ public:
     void pauseGeofenceItem(uint32_t hwId);
     void resumeGeofenceItem(uint32_t hwId);
     void modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options);
+    bool parkGeofenceItem(LocationAPI* client,
+                          uint32_t clientId,
+                          const GeofenceOption& options,
+                          const GeofenceInfo& info,
+                          bool engineFull = false);
+    LocationError removeParkedGeofenceItem(LocationAPI* client, uint32_t clientId);
+    LocationError pauseParkedGeofenceItem(LocationAPI* client, uint32_t clientId);
+    LocationError resumeParkedGeofenceItem(LocationAPI* client, uint32_t clientId);
+    LocationError modifyParkedGeofenceItem(LocationAPI* client, uint32_t clientId,
+                                           const GeofenceOption& options);
     LocationError getHwIdFromClient(LocationAPI* client, uint32_t clientId, uint32_t& hwId);
     LocationError getGeofenceKeyFromHwId(uint32_t hwId, GeofenceKey& key);
     void dump();
+    // appends the breaches reported, callable from any thread
+    void dumpStats(std::string& out) const;
 
     /* ==== REPORTS ======================================================================== */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
@@ -130,6 +234,8 @@ public:
     /* ======== UTILITIES ================================================================== */
     void geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
                         GeofenceBreachType breachType, uint64_t timestamp);
+    void geofenceBreach(const std::vector<GeofenceKey>& keys, const Location& location,
+                        GeofenceBreachType breachType, uint64_t timestamp);
     void geofenceStatus(GeofenceStatusAvailable available);
 };
 
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef GEOFENCE_EVALUATOR_H
+#define GEOFENCE_EVALUATOR_H
+
+#include <stdint.h>
+#include <math.h>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <LocationDataTypes.h>
+#include <GeofenceGrid.h>
+
+// margin on the flat earth distance below which the great circle one is computed
+#define GEOFENCE_EVALUATOR_NEAR_MARGIN 1.02
+
+/* Host side breach detection for the fences the engine has no slot for. Every
+   position is tested against every fence, and enter, exit and dwell are
+   reported as the engine would. The circles are kept in parallel arrays so a
+   position is tested against all of them in one branch free pass, with the
+   equirectangular distance; the great circle distance is only computed for the
+   few fences that pass comes out near or inside of. */
+template <typename Key, typename Hash = std::hash<Key>>
+class GeofenceEvaluator {
+
+    enum State : uint8_t {
+        STATE_UNKNOWN,
+        STATE_INSIDE,
+        STATE_OUTSIDE,
+    };
+
+    struct Fence {
+        Key key;
+        double latitude;
+        double longitude;
+        double radius;
+        GeofenceBreachTypeMask breachMask;
+        uint64_t dwellTimeMs;
+        State state;
+        bool dwellReported;
+        uint64_t sinceMs; // when state was entered
+    };
+
+    // hot, one element per fence, in the order of mFences
+    std::vector<double> mLatRad;
+    std::vector<double> mLonRad;
+    std::vector<double> mCosLat;
+    std::vector<double> mRadius;
+    std::vector<double> mDistance2; // scratch, squared flat earth distance in m^2
+    // cold
+    std::vector<Fence> mFences;
+    std::unordered_map<Key, size_t, Hash> mIndex;
+
+    static inline double toRadians(double deg) { return deg * M_PI / 180.0; }
+
+public:
+    struct Breach {
+        Key key;
+        GeofenceBreachType type;
+    };
+
+    inline size_t size() const { return mFences.size(); }
+
+    /* Adds the fence, or replaces it; a replaced fence keeps its state when
+       its circle did not change. dwellTime is in seconds. */
+    void insert(const Key& key, double latitude, double longitude, double radius,
+                GeofenceBreachTypeMask breachMask, uint32_t dwellTime) {
+        auto it = mIndex.find(key);
+        if (it != mIndex.end()) {
+            Fence& fence = mFences[it->second];
+            if (fence.latitude == latitude && fence.longitude == longitude &&
+                    fence.radius == radius) {
+                modify(key, breachMask, dwellTime);
+                return;
+            }
+            erase(key);
+        }
+        mIndex[key] = mFences.size();
+        mFences.push_back({key, latitude, longitude, radius, breachMask,
+                           (uint64_t)dwellTime * 1000, STATE_UNKNOWN, false, 0});
+        mLatRad.push_back(toRadians(latitude));
+        mLonRad.push_back(toRadians(longitude));
+        mCosLat.push_back(cos(toRadians(latitude)));
+        mRadius.push_back(radius);
+        mDistance2.push_back(0.0);
+    }
+
+    void modify(const Key& key, GeofenceBreachTypeMask breachMask, uint32_t dwellTime) {
+        auto it = mIndex.find(key);
+        if (it != mIndex.end()) {
+            mFences[it->second].breachMask = breachMask;
+            mFences[it->second].dwellTimeMs = (uint64_t)dwellTime * 1000;
+        }
+    }
+
+    // the last fence takes the place of the erased one, so the arrays stay dense
+    void erase(const Key& key) {
+        auto it = mIndex.find(key);
+        if (it == mIndex.end()) {
+            return;
+        }
+        size_t index = it->second;
+        size_t last = mFences.size() - 1;
+        mIndex.erase(it);
+        if (index != last) {
+            mFences[index] = mFences[last];
+            mLatRad[index] = mLatRad[last];
+            mLonRad[index] = mLonRad[last];
+            mCosLat[index] = mCosLat[last];
+            mRadius[index] = mRadius[last];
+            mIndex[mFences[index].key] = index;
+        }
+        mFences.pop_back();
+        mLatRad.pop_back();
+        mLonRad.pop_back();
+        mCosLat.pop_back();
+        mRadius.pop_back();
+        mDistance2.pop_back();
+    }
+
+    inline void clear() {
+        mFences.clear();
+        mLatRad.clear();
+        mLonRad.clear();
+        mCosLat.clear();
+        mRadius.clear();
+        mDistance2.clear();
+        mIndex.clear();
+    }
+
+    /* Tests the position against every fence and appends the breaches found.
+       accuracy is the horizontal uncertainty in meters: a fence is entered
+       once the position is within its radius, and exited once farther than
+       its radius plus the accuracy, at most twice the radius, so a position
+       wandering on the boundary does not flap. The first position inside a
+       fence reports ENTER. DWELL_IN follows dwell time inside without an exit,
+       DWELL_OUT dwell time outside after an exit, timed by the position
+       timestamps in ms; a timestamp going back counts as no time passed. */
+    void evaluate(double latitude, double longitude, double accuracy, uint64_t nowMs,
+                  std::vector<Breach>& breaches) {
+        const size_t count = mFences.size();
+        if (0 == count) {
+            return;
+        }
+        const double latRad = toRadians(latitude);
+        const double lonRad = toRadians(longitude);
+        const double earth2 = GEOFENCE_GRID_EARTH_RADIUS_METERS * GEOFENCE_GRID_EARTH_RADIUS_METERS;
+        accuracy = std::max(0.0, accuracy);
+
+        const double* fenceLat = mLatRad.data();
+        const double* fenceLon = mLonRad.data();
+        const double* cosLat = mCosLat.data();
+        double* distance2 = mDistance2.data();
+        for (size_t i = 0; i < count; i++) {
+            double dLat = latRad - fenceLat[i];
+            double dLon = fabs(lonRad - fenceLon[i]);
+            dLon = std::min(dLon, 2 * M_PI - dLon);
+            double x = dLon * cosLat[i];
+            distance2[i] = (x * x + dLat * dLat) * earth2;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const double radius = mRadius[i];
+            const double exitRadius = radius + std::min(accuracy, radius);
+            const double nearRadius = exitRadius * GEOFENCE_EVALUATOR_NEAR_MARGIN;
+            Fence& fence = mFences[i];
+            State state = STATE_OUTSIDE;
+            if (distance2[i] <= nearRadius * nearRadius) {
+                double d = GeofenceGrid<Key, Hash>::distance(latitude, longitude,
+                        fence.latitude, fence.longitude);
+                if (d <= radius) {
+                    state = STATE_INSIDE;
+                } else if (d <= exitRadius) {
+                    // between the radii nothing changes
+                    state = (STATE_UNKNOWN == fence.state) ? STATE_OUTSIDE : fence.state;
+                }
+            }
+            transition(fence, state, nowMs, breaches);
+        }
+    }
+
+private:
+    void transition(Fence& fence, State state, uint64_t nowMs, std::vector<Breach>& breaches) {
+        if (state != fence.state) {
+            if (STATE_INSIDE == state && (fence.breachMask & GEOFENCE_BREACH_ENTER_BIT)) {
+                breaches.push_back({fence.key, GEOFENCE_BREACH_ENTER});
+            } else if (STATE_OUTSIDE == state && STATE_INSIDE == fence.state &&
+                       (fence.breachMask & GEOFENCE_BREACH_EXIT_BIT)) {
+                breaches.push_back({fence.key, GEOFENCE_BREACH_EXIT});
+            }
+            // no DWELL_OUT without having been inside
+            fence.dwellReported = (STATE_OUTSIDE == state && STATE_UNKNOWN == fence.state);
+            fence.state = state;
+            fence.sinceMs = nowMs;
+        } else if (!fence.dwellReported && nowMs >= fence.sinceMs &&
+                   nowMs - fence.sinceMs >= fence.dwellTimeMs) {
+            fence.dwellReported = true;
+            if (STATE_INSIDE == state && (fence.breachMask & GEOFENCE_BREACH_DWELL_IN_BIT)) {
+                breaches.push_back({fence.key, GEOFENCE_BREACH_DWELL_IN});
+            } else if (STATE_OUTSIDE == state &&
+                       (fence.breachMask & GEOFENCE_BREACH_DWELL_OUT_BIT)) {
+                breaches.push_back({fence.key, GEOFENCE_BREACH_DWELL_OUT});
+            }
+        }
+    }
+};
+
+#endif /* GEOFENCE_EVALUATOR_H */
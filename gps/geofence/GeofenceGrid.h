@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef GEOFENCE_GRID_H
+#define GEOFENCE_GRID_H
+
+#include <stdint.h>
+#include <math.h>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+// edge length of a grid cell; fences are filed under the cell of their center
+#define GEOFENCE_GRID_CELL_METERS 2000.0
+#define GEOFENCE_GRID_EARTH_RADIUS_METERS 6371008.8
+
+/* Host side spatial index of geofences: an equal angle latitude/longitude grid,
+   so that the fences nearest a position can be found without measuring the
+   distance to every fence registered. */
+template <typename Key, typename Hash = std::hash<Key>>
+class GeofenceGrid {
+
+    struct Entry {
+        double latitude;
+        double longitude;
+        double radius;
+        uint64_t cell;
+    };
+
+    double mCellDeg;
+    uint32_t mColumns;
+    std::unordered_map<Key, Entry, Hash> mEntries;
+    std::unordered_map<uint64_t, std::vector<Key>> mCells;
+    std::multiset<double> mRadii;
+
+    inline uint32_t row(double latitude) const {
+        double r = floor((std::min(std::max(latitude, -90.0), 90.0) + 90.0) / mCellDeg);
+        return (uint32_t)r;
+    }
+    inline uint32_t column(double longitude) const {
+        double c = floor(fmod(fmod(longitude + 180.0, 360.0) + 360.0, 360.0) / mCellDeg);
+        return std::min((uint32_t)c, mColumns - 1);
+    }
+    static inline double toRadians(double deg) { return deg * M_PI / 180.0; }
+
+public:
+    inline GeofenceGrid(double cellMeters = GEOFENCE_GRID_CELL_METERS) :
+        mCellDeg(cellMeters * 180.0 / (M_PI * GEOFENCE_GRID_EARTH_RADIUS_METERS)),
+        mColumns((uint32_t)ceil(360.0 / mCellDeg)) {}
+
+    inline size_t size() const { return mEntries.size(); }
+
+    inline uint64_t cellOf(double latitude, double longitude) const {
+        return ((uint64_t)row(latitude) << 32) | column(longitude);
+    }
+
+    // great circle distance between two points, in meters
+    static double distance(double lat1, double lon1, double lat2, double lon2) {
+        double dLat = toRadians(lat2 - lat1);
+        double dLon = toRadians(lon2 - lon1);
+        double a = sin(dLat / 2) * sin(dLat / 2) +
+                cos(toRadians(lat1)) * cos(toRadians(lat2)) * sin(dLon / 2) * sin(dLon / 2);
+        return 2 * GEOFENCE_GRID_EARTH_RADIUS_METERS * atan2(sqrt(a), sqrt(1 - a));
+    }
+
+    void insert(const Key& key, double latitude, double longitude, double radius) {
+        erase(key);
+        uint64_t cell = cellOf(latitude, longitude);
+        mEntries[key] = {latitude, longitude, radius, cell};
+        mCells[cell].push_back(key);
+        mRadii.insert(radius);
+    }
+
+    void erase(const Key& key) {
+        auto it = mEntries.find(key);
+        if (it == mEntries.end()) {
+            return;
+        }
+        auto cellIt = mCells.find(it->second.cell);
+        if (cellIt != mCells.end()) {
+            std::vector<Key>& keys = cellIt->second;
+            keys.erase(std::remove(keys.begin(), keys.end(), key), keys.end());
+            if (keys.empty()) {
+                mCells.erase(cellIt);
+            }
+        }
+        auto radiusIt = mRadii.find(it->second.radius);
+        if (radiusIt != mRadii.end()) {
+            mRadii.erase(radiusIt);
+        }
+        mEntries.erase(it);
+    }
+
+    inline void clear() {
+        mEntries.clear();
+        mCells.clear();
+        mRadii.clear();
+    }
+
+    /* Fills keys with up to count fences whose boundary is nearest to the
+       position, nearest first; a position inside a fence is at distance 0.
+       Occupied cells are visited in the order of the least distance to them,
+       estimated from the grid, and the search stops once no cell left can hold
+       a fence nearer than the count-th found so far. */
+    void nearest(double latitude, double longitude, size_t count, std::vector<Key>& keys) const {
+        keys.clear();
+        if (0 == count || mEntries.empty()) {
+            return;
+        }
+        const double cellMeters = toRadians(mCellDeg) * GEOFENCE_GRID_EARTH_RADIUS_METERS;
+        const double maxRadius = mRadii.empty() ? 0.0 : *mRadii.rbegin();
+        const int64_t pointRow = row(latitude);
+        const int64_t pointColumn = column(longitude);
+
+        std::vector<std::pair<double, const std::vector<Key>*>> cells;
+        cells.reserve(mCells.size());
+        for (auto& cell : mCells) {
+            int64_t cellRow = (int64_t)(cell.first >> 32);
+            int64_t cellColumn = (int64_t)(cell.first & 0xFFFFFFFF);
+            int64_t dRow = std::abs(cellRow - pointRow);
+            int64_t dColumn = std::abs(cellColumn - pointColumn);
+            dColumn = std::min(dColumn, (int64_t)mColumns - dColumn);
+            // columns are narrowest at the latitude farthest from the equator
+            double edgeLat = std::max(fabs(latitude),
+                    std::max(fabs(cellRow * mCellDeg - 90.0), fabs((cellRow + 1) * mCellDeg - 90.0)));
+            double columnMeters = cellMeters * cos(toRadians(std::min(edgeLat, 90.0)));
+            double bound = std::max(std::max<int64_t>(dRow - 1, 0) * cellMeters,
+                                    std::max<int64_t>(dColumn - 1, 0) * columnMeters);
+            cells.emplace_back(bound - maxRadius, &cell.second);
+        }
+        std::sort(cells.begin(), cells.end(),
+                [] (const std::pair<double, const std::vector<Key>*>& a,
+                    const std::pair<double, const std::vector<Key>*>& b) {
+            return a.first < b.first;
+        });
+
+        // max-heap of the count nearest fences found so far
+        std::vector<std::pair<double, Key>> found;
+        auto farther = [] (const std::pair<double, Key>& a, const std::pair<double, Key>& b) {
+            return a.first < b.first;
+        };
+        for (auto& cell : cells) {
+            if (found.size() == count && cell.first > found.front().first) {
+                break;
+            }
+            for (const Key& key : *cell.second) {
+                const Entry& entry = mEntries.at(key);
+                double d = std::max(0.0, distance(latitude, longitude,
+                        entry.latitude, entry.longitude) - entry.radius);
+                if (found.size() < count) {
+                    found.emplace_back(d, key);
+                    std::push_heap(found.begin(), found.end(), farther);
+                } else if (d < found.front().first) {
+                    std::pop_heap(found.begin(), found.end(), farther);
+                    found.back() = std::make_pair(d, key);
+                    std::push_heap(found.begin(), found.end(), farther);
+                }
+            }
+        }
+        std::sort_heap(found.begin(), found.end(), farther);
+        keys.reserve(found.size());
+        for (auto& f : found) {
+            keys.push_back(f.second);
+        }
+    }
+};
+
+#endif /* GEOFENCE_GRID_H */
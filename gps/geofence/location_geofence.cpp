@@ -44,6 +44,7 @@ static void modifyGeofences(LocationAPI* client, size_t count, uint32_t* ids,
                                GeofenceOption* options);
 static void pauseGeofences(LocationAPI* client, size_t count, uint32_t* ids);
 static void resumeGeofences(LocationAPI* client, size_t count, uint32_t* ids);
+static void dumpStats(std::string& out);
 
 static const GeofenceInterface gGeofenceInterface = {
     sizeof(GeofenceInterface),
@@ -56,7 +57,8 @@ static const GeofenceInterface gGeofenceInterface = {
     removeGeofences,
     modifyGeofences,
     pauseGeofences,
-    resumeGeofences
+    resumeGeofences,
+    dumpStats
 };
 
 #ifndef DEBUG_X86
@@ -78,7 +80,17 @@ static void initialize()
 static void deinitialize()
 {
     if (NULL != gGeofenceAdapter) {
-        delete gGeofenceAdapter;
+        // deleted on its own thread, after the msgs already queued for it
+        struct MsgDeinit : public LocMsg {
+            GeofenceAdapter* mAdapter;
+            inline MsgDeinit(GeofenceAdapter* adapter) :
+                LocMsg(),
+                mAdapter(adapter) {}
+            inline virtual void proc() const {
+                delete mAdapter;
+            }
+        };
+        gGeofenceAdapter->sendMsg(new MsgDeinit(gGeofenceAdapter));
         gGeofenceAdapter = NULL;
     }
 }
@@ -143,3 +155,9 @@ static void resumeGeofences(LocationAPI* client, size_t count, uint32_t* ids)
     }
 }
 
+static void dumpStats(std::string& out)
+{
+    if (NULL != gGeofenceAdapter) {
+        gGeofenceAdapter->dumpStats(out);
+    }
+}
@@ -121,7 +121,7 @@ void AgpsStateMachine::processAgpsEventUnsubscribe(){
              * before being removed from list, move to inactive state
              * and notify */
             if (mCurrentSubscriber->mWaitForCloseComplete) {
-                mCurrentSubscriber->mIsInactive = true;
+                setSubscriberInactive(mCurrentSubscriber);
             }
             else {
                 /* Notify only current subscriber and then delete it from
@@ -148,7 +148,7 @@ void AgpsStateMachine::processAgpsEventUnsubscribe(){
              * before being removed from list, move to inactive state
              * and notify */
             if (mCurrentSubscriber->mWaitForCloseComplete) {
-                mCurrentSubscriber->mIsInactive = true;
+                setSubscriberInactive(mCurrentSubscriber);
             }
             else {
                 /* Notify only current subscriber and then delete it from
@@ -315,7 +315,15 @@ void AgpsStateMachine::notifyAllSubscribers(
             "SM %p, Event %d Delete %d Notification Type %d",
             this, event, deleteSubscriberPostNotify, notificationType);
 
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
+    /* Nothing to notify if no subscriber is in the requested state */
+    if ((notificationType == AGPS_NOTIFICATION_TYPE_FOR_ACTIVE_SUBSCRIBERS &&
+                0 == mActiveSubscriberCount) ||
+            (notificationType == AGPS_NOTIFICATION_TYPE_FOR_INACTIVE_SUBSCRIBERS &&
+                mSubscriberIndex.size() == mActiveSubscriberCount)) {
+        return;
+    }
+
+    std::list<AgpsSubscriber*>::iterator it = mSubscriberList.begin();
     while ( it != mSubscriberList.end() ) {
 
         AgpsSubscriber* subscriber = *it;
@@ -331,8 +339,7 @@ void AgpsStateMachine::notifyAllSubscribers(
             notifyEventToSubscriber(event, subscriber, false);
 
             if (deleteSubscriberPostNotify) {
-                it = mSubscriberList.erase(it);
-                delete subscriber;
+                it = eraseSubscriber(it);
             } else {
                 it++;
             }
@@ -350,7 +357,12 @@ void AgpsStateMachine::notifyEventToSubscriber(
             "SM %p, Event %d Subscriber %p Delete %d",
             this, event, subscriberToNotify, deleteSubscriberPostNotify);
 
-    switch (event) {
+    /* The prewarm subscriber was never requested by the engine */
+    switch (AGPS_PREWARM_CONN_HANDLE == subscriberToNotify->mConnHandle ?
+            AGPS_EVENT_INVALID : event) {
+
+        case AGPS_EVENT_INVALID:
+            break;
 
         case AGPS_EVENT_GRANTED:
             mAgpsManager->mAtlOpenStatusCb(
@@ -396,18 +408,19 @@ void AgpsStateMachine::addSubscriber(AgpsSubscriber* subscriberToAdd){
 
     // Check if subscriber is already present in the current list
     // If not, then add
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    for (; it != mSubscriberList.end(); it++) {
-        AgpsSubscriber* subscriber = *it;
-        if (subscriber->equals(subscriberToAdd)) {
-            LOC_LOGE("Subscriber already in list");
-            return;
-        }
+    if (mSubscriberIndex.find(subscriberToAdd->mConnHandle) !=
+            mSubscriberIndex.end()) {
+        LOC_LOGE("Subscriber already in list");
+        return;
     }
 
     AgpsSubscriber* cloned = subscriberToAdd->clone();
     LOC_LOGD("addSubscriber(): cloned subscriber: %p", cloned);
-    mSubscriberList.push_back(cloned);
+    mSubscriberIndex[cloned->mConnHandle] =
+            mSubscriberList.insert(mSubscriberList.end(), cloned);
+    if (!cloned->mIsInactive) {
+        mActiveSubscriberCount++;
+    }
 }
 
 void AgpsStateMachine::deleteSubscriber(AgpsSubscriber* subscriberToDelete){
@@ -415,30 +428,35 @@ void AgpsStateMachine::deleteSubscriber(AgpsSubscriber* subscriberToDelete){
     LOC_LOGD("deleteSubscriber(): SM %p, Subscriber %p",
                this, subscriberToDelete);
 
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    while ( it != mSubscriberList.end() ) {
+    auto indexIt = mSubscriberIndex.find(subscriberToDelete->mConnHandle);
+    if (indexIt != mSubscriberIndex.end()) {
+        eraseSubscriber(indexIt->second);
+    }
+}
 
-        AgpsSubscriber* subscriber = *it;
-        if (subscriber && subscriber->equals(subscriberToDelete)) {
+std::list<AgpsSubscriber*>::iterator AgpsStateMachine::eraseSubscriber(
+        std::list<AgpsSubscriber*>::iterator it){
 
-            it = mSubscriberList.erase(it);
-            delete subscriber;
-        } else {
-            it++;
-        }
+    AgpsSubscriber* subscriber = *it;
+    if (!subscriber->mIsInactive) {
+        mActiveSubscriberCount--;
     }
+    mSubscriberIndex.erase(subscriber->mConnHandle);
+    it = mSubscriberList.erase(it);
+    delete subscriber;
+    return it;
 }
 
-bool AgpsStateMachine::anyActiveSubscribers(){
+void AgpsStateMachine::setSubscriberInactive(AgpsSubscriber* subscriber){
 
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    for (; it != mSubscriberList.end(); it++) {
-        AgpsSubscriber* subscriber = *it;
-        if (!subscriber->mIsInactive) {
-            return true;
+    if (!subscriber->mIsInactive) {
+        subscriber->mIsInactive = true;
+        /* Only listed subscribers are counted */
+        auto it = mSubscriberIndex.find(subscriber->mConnHandle);
+        if (it != mSubscriberIndex.end() && *(it->second) == subscriber) {
+            mActiveSubscriberCount--;
         }
     }
-    return false;
 }
 
 void AgpsStateMachine::setAPN(char* apn, unsigned int len){
@@ -464,13 +482,9 @@ void AgpsStateMachine::setAPN(char* apn, unsigned int len){
 
 AgpsSubscriber* AgpsStateMachine::getSubscriber(int connHandle){
 
-    /* Go over the subscriber list */
-    std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
-    for (; it != mSubscriberList.end(); it++) {
-        AgpsSubscriber* subscriber = *it;
-        if (subscriber->mConnHandle == connHandle) {
-            return subscriber;
-        }
+    auto it = mSubscriberIndex.find(connHandle);
+    if (it != mSubscriberIndex.end()) {
+        return *(it->second);
     }
 
     /* Not found, return NULL */
@@ -479,6 +493,12 @@ AgpsSubscriber* AgpsStateMachine::getSubscriber(int connHandle){
 
 AgpsSubscriber* AgpsStateMachine::getFirstSubscriber(bool isInactive){
 
+    /* No subscriber in the requested state */
+    if ((!isInactive && 0 == mActiveSubscriberCount) ||
+            (isInactive && mSubscriberIndex.size() == mActiveSubscriberCount)) {
+        return NULL;
+    }
+
     /* Go over the subscriber list */
     std::list<AgpsSubscriber*>::const_iterator it = mSubscriberList.begin();
     for (; it != mSubscriberList.end(); it++) {
@@ -503,6 +523,8 @@ void AgpsStateMachine::dropAllSubscribers(){
         it = mSubscriberList.erase(it);
         delete subscriber;
     }
+    mSubscriberIndex.clear();
+    mActiveSubscriberCount = 0;
 }
 
 /* --------------------------------------------------------------------
@@ -576,6 +598,11 @@ void AgpsManager::requestATL(int connHandle, AGpsExtType agpsType,
                  "agpsType 0x%X apnTypeMask : 0x%X",
                  agpsType, apnTypeMask);
     }
+    /* Emergency SUPL gets its own PDN, not the prewarmed SUPL one */
+    if (LOC_AGPS_TYPE_SUPL_ES == agpsType && isPrewarmed()) {
+        LOC_LOGD("Dropping prewarmed SUPL data call for emergency SUPL");
+        setPrewarm(false);
+    }
     AgpsStateMachine* sm = getAgpsStateMachine(agpsType);
 
     if (sm == NULL) {
@@ -619,6 +646,12 @@ void AgpsManager::releaseATL(int connHandle){
         return;
     }
 
+    /* The data call stays up for the prewarm subscriber, waiting for it
+     * to close would hold back the engine's release indefinitely */
+    if (sm == mAgnssNif && isPrewarmed()) {
+        subscriber->mWaitForCloseComplete = false;
+    }
+
     /* Now send unsubscribe event */
     sm->setCurrentSubscriber(subscriber);
     sm->processAgpsEvent(AGPS_EVENT_UNSUBSCRIBE);
@@ -673,3 +706,35 @@ void AgpsManager::handleModemSSR(){
         mInternetNif->dropAllSubscribers();
     }
 }
+
+bool AgpsManager::isPrewarmed(){
+
+    return (NULL != mAgnssNif &&
+            NULL != mAgnssNif->getSubscriber(AGPS_PREWARM_CONN_HANDLE));
+}
+
+void AgpsManager::setPrewarm(bool prewarm){
+
+    if (NULL == mAgnssNif || prewarm == isPrewarmed()) {
+        return;
+    }
+
+    LOC_LOGD("AgpsManager::setPrewarm(): %d", prewarm);
+
+    if (prewarm) {
+        /* With other subscribers the data call is already up or being
+         * brought up for them, just stay subscribed to it */
+        if (!mAgnssNif->hasSubscribers()) {
+            mAgnssNif->setType(LOC_AGPS_TYPE_SUPL);
+            mAgnssNif->setApnTypeMask(LOC_APN_TYPE_MASK_SUPL);
+        }
+        AgpsSubscriber subscriber(
+                AGPS_PREWARM_CONN_HANDLE, false, false, LOC_APN_TYPE_MASK_SUPL);
+        mAgnssNif->setCurrentSubscriber(&subscriber);
+        mAgnssNif->processAgpsEvent(AGPS_EVENT_SUBSCRIBE);
+    } else {
+        mAgnssNif->setCurrentSubscriber(
+                mAgnssNif->getSubscriber(AGPS_PREWARM_CONN_HANDLE));
+        mAgnssNif->processAgpsEvent(AGPS_EVENT_UNSUBSCRIBE);
+    }
+}
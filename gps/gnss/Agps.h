@@ -32,6 +32,7 @@
 
 #include <functional>
 #include <list>
+#include <unordered_map>
 #include <MsgTask.h>
 #include <gps_extended_c.h>
 #include <loc_pla.h>
@@ -51,6 +52,11 @@ typedef std::function<void(int handle, int isSuccess)> AgpsAtlCloseStatusCb;
 /* Post message to adapter's message queue */
 typedef std::function<void(LocMsg* msg)>     SendMsgToAdapterMsgQueueFn;
 
+/* Connection handle of the subscriber AgpsManager adds on its own to keep
+ * the SUPL data call up ahead of engine requests. Engine handles are never
+ * negative, and no ATL status is reported to the engine for this one. */
+#define AGPS_PREWARM_CONN_HANDLE (-1)
+
 /* AGPS States */
 typedef enum {
     AGPS_STATE_INVALID = 0,
@@ -132,6 +138,12 @@ protected:
      * it is deleted */
     std::list<AgpsSubscriber*> mSubscriberList;
 
+    /* Subscriber list entries indexed by connection handle, and the
+     * number of them not in inactive state; both are kept in sync with
+     * mSubscriberList by addSubscriber/deleteSubscriber */
+    std::unordered_map<int, std::list<AgpsSubscriber*>::iterator> mSubscriberIndex;
+    uint32_t mActiveSubscriberCount;
+
     /* Current subscriber, whose request this State Machine is
      * currently processing */
     AgpsSubscriber* mCurrentSubscriber;
@@ -157,8 +169,8 @@ private:
 public:
     /* CONSTRUCTOR */
     AgpsStateMachine(AgpsManager* agpsManager, AGpsExtType agpsType):
-        mAgpsManager(agpsManager), mSubscriberList(),
-        mCurrentSubscriber(NULL), mState(AGPS_STATE_RELEASED),
+        mAgpsManager(agpsManager), mSubscriberList(), mSubscriberIndex(),
+        mActiveSubscriberCount(0), mCurrentSubscriber(NULL), mState(AGPS_STATE_RELEASED),
         mFrameworkStatusV4Cb(NULL),
         mAgpsType(agpsType), mAPN(NULL), mAPNLen(0),
         mBearer(AGPS_APN_BEARER_INVALID) {};
@@ -178,6 +190,7 @@ public:
     inline AGpsExtType getType() const { return mAgpsType; }
     inline void setCurrentSubscriber(AgpsSubscriber* subscriber)
     { mCurrentSubscriber = subscriber; }
+    inline bool hasSubscribers() const { return !mSubscriberList.empty(); }
 
     inline void registerFrameworkStatusCallback(AgnssStatusIpV4Cb frameworkStatusV4Cb) {
         mFrameworkStatusV4Cb = frameworkStatusV4Cb;
@@ -229,7 +242,14 @@ private:
             bool deleteSubscriberPostNotify);
 
     /* Do we have any subscribers in active state */
-    bool anyActiveSubscribers();
+    inline bool anyActiveSubscribers() const { return mActiveSubscriberCount > 0; }
+
+    /* Move a listed subscriber to inactive state */
+    void setSubscriberInactive(AgpsSubscriber* subscriber);
+
+    /* Unlink the subscriber at the specified list position and delete it */
+    std::list<AgpsSubscriber*>::iterator eraseSubscriber(
+            std::list<AgpsSubscriber*>::iterator it);
 
     /* Transition state */
     void transitionState(AgpsState newState);
@@ -271,6 +291,11 @@ public:
     /* Handle Modem SSR */
     void handleModemSSR();
 
+    /* Keep the SUPL data call up without an engine request, or stop doing
+     * so; a later SUPL requestATL is then granted without call setup */
+    void setPrewarm(bool prewarm);
+    bool isPrewarmed();
+
 protected:
 
     AgpsAtlOpenStatusCb   mAtlOpenStatusCb;
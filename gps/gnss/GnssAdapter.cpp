@@ -41,6 +41,7 @@
 #include <GnssAdapter.h>
 #include <string>
 #include <sstream>
+#include <algorithm>
 #include <loc_log.h>
 #include <loc_nmea.h>
 #include <Agps.h>
@@ -48,6 +49,8 @@
 #include <vector>
 #include <loc_misc_utils.h>
 #include <gps_extended_c.h>
+#include <LocTrace.h>
+#include <dlfcn.h>
 
 #define RAD2DEG    (180.0 / M_PI)
 #define DEG2RAD    (M_PI / 180.0)
@@ -58,7 +61,6 @@
 #define NMEA_MIN_THRESHOLD_MSEC (99)
 #define NMEA_MAX_THRESHOLD_MSEC (975)
 
-#define DGNSS_RANGE_UPDATE_TIME_10MIN_IN_MILLI  600000
 
 using namespace loc_core;
 
@@ -89,10 +91,218 @@ inline void GnssReportLoggerUtil::log(const GnssLatencyInfo& gnssLatencyMeasInfo
     }
 }
 
+#define FIX_LATENCY_WINDOW_NSEC (600 * BILLION_NSEC)
+
+GnssFixLatencyStats::GnssFixLatencyStats() :
+    mQTimerFreq(getQTimerFreq()),
+    mMeasToEngineUs(FIX_LATENCY_WINDOW_NSEC),
+    mEngineToAdapterUs(FIX_LATENCY_WINDOW_NSEC),
+    mAdapterToClientUs(FIX_LATENCY_WINDOW_NSEC),
+    mTotalUs(FIX_LATENCY_WINDOW_NSEC) {
+}
+
+void GnssFixLatencyStats::record(const GnssLatencyInfo& info) {
+    if (0 == mQTimerFreq) {
+        return;
+    }
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t nowNs = (uint64_t)ts.tv_sec * BILLION_NSEC + ts.tv_nsec;
+
+    auto recordStage = [this, nowNs](loc_util::LocRollingHistogram& hist,
+                                     uint64_t from, uint64_t to) {
+        if (0 != from && to >= from) {
+            hist.record((to - from) * 1000000 / mQTimerFreq, nowNs);
+        }
+    };
+    recordStage(mMeasToEngineUs, info.meQtimer1, info.peQtimer3);
+    recordStage(mEngineToAdapterUs, info.peQtimer3, info.hlosQtimer2);
+    recordStage(mAdapterToClientUs, info.hlosQtimer2, info.hlosQtimer5);
+    recordStage(mTotalUs, info.meQtimer1, info.hlosQtimer5);
+}
+
+void GnssFixLatencyStats::dump(std::string& out) const {
+    out += "Fix latency (10 min windows):\n";
+    out += "  meas->engine:     ";
+    mMeasToEngineUs.dump(out, "us");
+    out += "\n  engine->adapter:  ";
+    mEngineToAdapterUs.dump(out, "us");
+    out += "\n  adapter->client:  ";
+    mAdapterToClientUs.dump(out, "us");
+    out += "\n  total:            ";
+    mTotalUs.dump(out, "us");
+    out += "\n";
+}
+
+#define HIGH_RATE_WINDOW_NSEC (60 * BILLION_NSEC)
+
+GnssHighRateStats::GnssHighRateStats() :
+    mLastFixNs(0),
+    mIntervalUs(HIGH_RATE_WINDOW_NSEC),
+    mDeliveryUs(HIGH_RATE_WINDOW_NSEC),
+    mDecimatedSv(0) {
+}
+
+void GnssHighRateStats::record(uint64_t startNs) {
+    uint64_t nowNs = GnssInitTimings::nowNs();
+    // a gap of a second or more is a new session, or a lost fix, not the rate
+    if (0 != mLastFixNs && startNs > mLastFixNs && startNs - mLastFixNs < BILLION_NSEC) {
+        mIntervalUs.record((startNs - mLastFixNs) / 1000, nowNs);
+    }
+    mLastFixNs = startNs;
+    mDeliveryUs.record((nowNs - startNs) / 1000, nowNs);
+}
+
+void GnssHighRateStats::dump(std::string& out) const {
+    const loc_util::LocHistogram& interval = (mIntervalUs.getCurrent().getCount() > 0) ?
+            mIntervalUs.getCurrent() : mIntervalUs.getPrevious();
+    const loc_util::LocHistogram& delivery = (mDeliveryUs.getCurrent().getCount() > 0) ?
+            mDeliveryUs.getCurrent() : mDeliveryUs.getPrevious();
+    uint64_t meanUs = interval.getMean();
+    uint64_t p99Us = delivery.getPercentile(99);
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "High rate tracking (1 min windows): rate=%.1fHz headroom=%" PRIi64
+             "%% sv_decimated=%" PRIu64 "\n",
+             (0 == meanUs) ? 0.0 : 1000000.0 / meanUs,
+             (0 == meanUs) ? (int64_t)0 : 100 - (int64_t)(p99Us * 100 / meanUs),
+             mDecimatedSv.load(std::memory_order_relaxed));
+    out += buf;
+    out += "  fix interval: ";
+    mIntervalUs.dump(out, "us");
+    out += "\n  delivery:     ";
+    mDeliveryUs.dump(out, "us");
+    out += "\n";
+}
+
+static const char* const sInitStepNames[GNSS_INIT_STEP_COUNT] = {
+    "read config", "default agps", "eng hub proxy", "engine up", "cdfw service"
+};
+
+GnssInitTimings::GnssInitTimings() {
+    for (uint32_t i = 0; i < GNSS_INIT_STEP_COUNT; i++) {
+        mStepUs[i].store(UINT64_MAX, std::memory_order_relaxed);
+    }
+}
+
+uint64_t GnssInitTimings::nowNs() {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * BILLION_NSEC + ts.tv_nsec;
+}
+
+void GnssInitTimings::record(GnssInitStep step, uint64_t startNs) {
+    uint64_t us = (nowNs() - startNs) / 1000;
+    mStepUs[step].store(us, std::memory_order_relaxed);
+    LOC_LOGi("init step %s took %" PRIu64 " us", sInitStepNames[step], us);
+}
+
+void GnssInitTimings::dump(std::string& out) const {
+    out += "Startup steps (last run):\n";
+    for (uint32_t i = 0; i < GNSS_INIT_STEP_COUNT; i++) {
+        uint64_t us = mStepUs[i].load(std::memory_order_relaxed);
+        out += "  ";
+        out += sInitStepNames[i];
+        out += ": ";
+        out += (UINT64_MAX == us) ? std::string("not run") : (std::to_string(us) + " us");
+        out += "\n";
+    }
+}
+
+#define GNSS_ENERGY_PROFILE_MAX_BUCKETS (32)
+
+GnssEnergyProfile::GnssEnergyProfile() :
+    mState{0, GNSS_POWER_MODE_INVALID, 0, 0, -1},
+    mSampleState(mState),
+    mSampleBootTimeMs(0),
+    mSampleEnergy(0),
+    mIntervalFixes(0) {
+}
+
+bool GnssEnergyProfile::setState(const GnssEnergyProfileState& state) {
+    if (state == mState) {
+        return false;
+    }
+    mState = state;
+    return true;
+}
+
+void GnssEnergyProfile::addSample(uint64_t energy) {
+    uint64_t nowMs = getBootTimeMilliSec();
+    // the first reading, or the engine restarted its count
+    if (0 == mSampleBootTimeMs || energy < mSampleEnergy) {
+        mSampleState = mState;
+        mSampleBootTimeMs = nowMs;
+        mSampleEnergy = energy;
+        mIntervalFixes = 0;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mBuckets.begin();
+        while (it != mBuckets.end() && !(it->state == mSampleState)) {
+            ++it;
+        }
+        if (it == mBuckets.end()) {
+            if (mBuckets.size() < GNSS_ENERGY_PROFILE_MAX_BUCKETS) {
+                mBuckets.push_back({mSampleState, 0, 0, 0});
+            }
+            it = mBuckets.end() - 1;
+        }
+        it->energy += energy - mSampleEnergy;
+        it->durationMs += nowMs - mSampleBootTimeMs;
+        it->fixes += mIntervalFixes;
+    }
+
+    mSampleState = mState;
+    mSampleBootTimeMs = nowMs;
+    mSampleEnergy = energy;
+    mIntervalFixes = 0;
+}
+
+void GnssEnergyProfile::dump(std::string& out) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    out += "Engine energy by tracking state:\n";
+    if (mBuckets.empty()) {
+        out += "  no readings\n";
+        return;
+    }
+    for (const Bucket& bucket : mBuckets) {
+        char line[200];
+        // energy is in 0.1 mWs, i.e. 0.1 mJ
+        snprintf(line, sizeof(line),
+                 "  sessions %u mode %d tbf %u ms sv 0x%" PRIx64 " screen %d: "
+                 "%" PRIu64 ".%" PRIu64 " mJ in %" PRIu64 " s, %" PRIu64 " fixes",
+                 bucket.state.sessions, bucket.state.powerMode, bucket.state.tbfMs,
+                 (uint64_t)bucket.state.enabledSvTypes, bucket.state.screenOn,
+                 bucket.energy / 10, bucket.energy % 10, bucket.durationMs / 1000,
+                 bucket.fixes);
+        out += line;
+        if (bucket.fixes > 0) {
+            snprintf(line, sizeof(line), ", %.1f mJ/fix",
+                     bucket.energy / 10.0 / bucket.fixes);
+            out += line;
+        }
+        out += "\n";
+    }
+}
+
+// Libraries the startup steps always dlopen on the adapter thread. Loading
+// them here first, in parallel with the adapter thread, leaves only the
+// dlsym for those steps.
+static const char* const sPrefetchLibs[] = {
+    "libloc_net_iface.so", // initDefaultAgps
+    "libcdfw.so",          // initCDFWService
+};
+
 GnssAdapter::GnssAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
                    true, nullptr, true),
+    mFlpLocationInfoNeeded(false),
+    mGnssLocationInfoNeeded(false),
+    mEngineLocationsNeededMask(0),
     mEngHubProxy(new EngineHubProxyBase()),
     mNHzNeeded(false),
     mSPEAlreadyRunningAtHighestInterval(false),
@@ -115,7 +325,11 @@ GnssAdapter::GnssAdapter() :
     mNfwCb(NULL),
     mIsE911Session(NULL),
     mIsMeasCorrInterfaceOpen(false),
+    mPendingMeasCorr(),
+    mMeasCorrPending(false),
+    mMeasCorrDropped(0),
     mIsAntennaInfoInterfaceOpened(false),
+    mGnssAntennaInformationsRead(false),
     mQDgnssListenerHDL(nullptr),
     mCdfwInterface(nullptr),
     mDGnssNeedReport(false),
@@ -125,16 +339,30 @@ GnssAdapter::GnssAdapter() :
     mCallbackPriority(OdcpiPrioritytype::ODCPI_HANDLER_PRIORITY_LOW),
     mOdcpiTimer(this),
     mOdcpiRequest(),
+    mOdcpiFrameworkStarted(false),
+    mOdcpiLastLocation(),
+    mOdcpiLastLocationBootTimeMilli(0),
     mLastDeleteAidingDataTime(0),
     mSystemStatus(SystemStatus::getInstance(mMsgTask)),
     mServerUrl(":"),
     mXtraObserver(mSystemStatus->getOsObserver(), mMsgTask),
     mLocSystemInfo{},
+    mEngineConfigShadow{},
     mSystemPowerState(POWER_STATE_UNKNOWN),
+    mSuspendTrackingThrottled(false),
     mBlockCPIInfo{},
     mPowerOn(false),
     mAllowFlpNetworkFixes(0),
     mDreIntEnabled(false),
+    mTimeInjectValid(false),
+    mTimeInjectOffsetMs(0),
+    mTimeInjectUncMs(0),
+    mPrevSvRptTimeNsec(0),
+    mScreenOffSvRptNs(0),
+    mScreenOffDataRptNs(0),
+    mScreenOffDroppedSv(0),
+    mScreenOffDroppedData(0),
+    mDataInfo(),
     mNativeAgpsHandler(mSystemStatus->getOsObserver(), *this),
     mGnssEnergyConsumedCb(nullptr),
     mPowerStateCb(nullptr),
@@ -167,10 +395,14 @@ GnssAdapter::GnssAdapter() :
             };
     mAgpsManager.registerATLCallbacks(atlOpenStatusCb, atlCloseStatusCb);
 
+    LocLibPreloader::preload(sPrefetchLibs);
+
     readConfigCommand();
     initDefaultAgpsCommand();
     initEngHubProxyCommand();
 
+    mLocApi->setAdapterListener(this, this);
+
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
     doneInit();
@@ -239,6 +471,74 @@ GnssAdapter::checkAndSetSPEToRunforNHz(TrackingOptions & out) {
     return isSPERunningAtHighestInterval;
 }
 
+// While suspended, raise the TBF going to the engine so that sessions of FLP
+// clients run no faster than SUSPEND_TRACKING_MIN_TBF_MS. A session of a GNSS
+// client below the floor still sets the TBF. key is the session being started,
+// updated or stopped, if any; a session being started is not saved yet, and
+// one being stopped sits below options.minInterval. Returns true if options
+// was changed.
+bool
+GnssAdapter::applySuspendTrackingThrottle(const LocationSessionKey* key,
+                                          TrackingOptions& options)
+{
+    uint32_t floorMs = ContextBase::mGps_conf.SUSPEND_TRACKING_MIN_TBF_MS;
+    if (POWER_STATE_SUSPEND != mSystemPowerState || 0 == floorMs ||
+            options.minInterval >= floorMs) {
+        return false;
+    }
+
+    uint32_t interval = floorMs;
+    if (nullptr != key &&
+            mTimeBasedTrackingSessions.find(*key) == mTimeBasedTrackingSessions.end()) {
+        LocationCallbacks callbacks = getClientCallbacks(key->client);
+        if (!isFlpClient(callbacks)) {
+            interval = options.minInterval;
+        }
+    }
+    // ordered by interval, so the first GNSS client session found is the fastest one
+    for (auto it = mTimeBasedTrackingIntervals.lower_bound(
+                std::make_pair(options.minInterval, LocationSessionKey(nullptr, 0)));
+            it != mTimeBasedTrackingIntervals.end() && it->first < interval; ++it) {
+        LocationCallbacks callbacks = getClientCallbacks(it->second.client);
+        if (!isFlpClient(callbacks)) {
+            interval = it->first;
+            break;
+        }
+    }
+
+    if (interval <= options.minInterval) {
+        return false;
+    }
+    LOC_LOGd("suspended, TBF %u raised to %u", options.minInterval, interval);
+    options.minInterval = interval;
+    return true;
+}
+
+// Move the running time based session onto or off the suspend TBF with a
+// single in place update of the engine, instead of a stop and restart.
+void
+GnssAdapter::updateSuspendTrackingThrottle()
+{
+    if (mTimeBasedTrackingSessions.empty() || mNHzNeeded) {
+        mSuspendTrackingThrottled = false;
+        return;
+    }
+
+    TrackingOptions options;
+    GnssPowerMode powerMode;
+    getMultiplexedTrackingOptions(nullptr, options, powerMode);
+    if (GNSS_POWER_MODE_INVALID != powerMode) {
+        options.powerMode = powerMode;
+    }
+    bool throttled = applySuspendTrackingThrottle(nullptr, options);
+    if (throttled || mSuspendTrackingThrottled) {
+        LOC_LOGi("%s suspend TBF, engine TBF %u", throttled ? "apply" : "release",
+                 options.minInterval);
+        mLocApi->startTimeBasedTracking(options, nullptr);
+    }
+    mSuspendTrackingThrottled = throttled;
+}
+
 
 void
 GnssAdapter::convertLocation(Location& out, const UlpLocation& ulpLocation,
@@ -801,6 +1101,7 @@ GnssAdapter::readConfigCommand()
             static bool confReadDone = false;
             if (!confReadDone) {
                 confReadDone = true;
+                uint64_t startNs = GnssInitTimings::nowNs();
                 // reads config into mContext->mGps_conf
                 mContext.readConfig();
 
@@ -812,6 +1113,7 @@ GnssAdapter::readConfigCommand()
                 UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
                 LOC_LOGd("allowFlpNetworkFixes %u", allowFlpNetworkFixes);
                 mAdapter->setAllowFlpNetworkFixes(allowFlpNetworkFixes);
+                mAdapter->mInitTimings.record(GNSS_INIT_STEP_READ_CONFIG, startNs);
             }
         }
     };
@@ -942,6 +1244,8 @@ GnssAdapter::setConfig()
     mLocApi->sendMsg(new LocApiMsg(
             [this, gpsConf, sapConf, oldMoServerUrl, moServerUrl,
             serverUrl, gnssConfigRequested] () mutable {
+        // engine state is unknown after a (re)start, inject every item
+        mEngineConfigShadow.flags = 0;
         gnssUpdateConfig(oldMoServerUrl, moServerUrl, serverUrl,
                 gnssConfigRequested, gnssConfigRequested);
 
@@ -1044,6 +1348,20 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     int serverUrlLen = serverUrl.length();
     int moServerUrlLen = moServerUrl.length();
 
+    // Items already holding the requested value in the engine are not written
+    // again. The shadow is updated on success and dropped on failure, so a
+    // failed write is retried by the next request.
+    auto engineHas = [this] (GnssConfigFlagsBits bit, bool sameValue) {
+        return (0 != (mEngineConfigShadow.flags & bit)) && sameValue;
+    };
+    auto updateShadow = [this] (GnssConfigFlagsBits bit, LocationError result) {
+        if (LOCATION_ERROR_SUCCESS == result) {
+            mEngineConfigShadow.flags |= bit;
+        } else {
+            mEngineConfigShadow.flags &= ~bit;
+        }
+    };
+
     if (!ContextBase::mGps_conf.AGPS_CONFIG_INJECT) {
         LOC_LOGd("AGPS_CONFIG_INJECT is 0. Not setting flags for AGPS configurations");
         gnssConfigRequested.flags &= ~(GNSS_CONFIG_FLAGS_SET_ASSISTANCE_DATA_VALID_BIT |
@@ -1125,9 +1443,13 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     }
 
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) {
-        if (gnssConfigNeedEngineUpdate.flags &
-                GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) {
+        if ((gnssConfigNeedEngineUpdate.flags &
+                GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) &&
+            !engineHas(GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT,
+                       mEngineConfigShadow.suplVersion == gnssConfigRequested.suplVersion)) {
             err = mLocApi->setSUPLVersionSync(gnssConfigRequested.suplVersion);
+            mEngineConfigShadow.suplVersion = gnssConfigRequested.suplVersion;
+            updateShadow(GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT, err);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1136,9 +1458,13 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     }
 
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) {
-        if (gnssConfigNeedEngineUpdate.flags &
-                GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) {
+        if ((gnssConfigNeedEngineUpdate.flags &
+                GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) &&
+            !engineHas(GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT,
+                       mEngineConfigShadow.lppProfileMask == gnssConfigRequested.lppProfileMask)) {
             err = mLocApi->setLPPConfigSync(gnssConfigRequested.lppProfileMask);
+            mEngineConfigShadow.lppProfileMask = gnssConfigRequested.lppProfileMask;
+            updateShadow(GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT, err);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1147,10 +1473,15 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     }
 
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) {
-        if (gnssConfigNeedEngineUpdate.flags &
-                GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) {
+        if ((gnssConfigNeedEngineUpdate.flags &
+                GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) &&
+            !engineHas(GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT,
+                       mEngineConfigShadow.lppeControlPlaneMask ==
+                       gnssConfigRequested.lppeControlPlaneMask)) {
             err = mLocApi->setLPPeProtocolCpSync(
                     gnssConfigRequested.lppeControlPlaneMask);
+            mEngineConfigShadow.lppeControlPlaneMask = gnssConfigRequested.lppeControlPlaneMask;
+            updateShadow(GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT, err);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1159,10 +1490,15 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     }
 
     if (gnssConfigRequested.flags & GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) {
-        if (gnssConfigNeedEngineUpdate.flags &
-                GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) {
+        if ((gnssConfigNeedEngineUpdate.flags &
+                GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) &&
+            !engineHas(GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT,
+                       mEngineConfigShadow.lppeUserPlaneMask ==
+                       gnssConfigRequested.lppeUserPlaneMask)) {
             err = mLocApi->setLPPeProtocolUpSync(
                     gnssConfigRequested.lppeUserPlaneMask);
+            mEngineConfigShadow.lppeUserPlaneMask = gnssConfigRequested.lppeUserPlaneMask;
+            updateShadow(GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT, err);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1172,10 +1508,16 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
 
     if (gnssConfigRequested.flags &
             GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) {
-        if (gnssConfigNeedEngineUpdate.flags &
-                GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) {
+        if ((gnssConfigNeedEngineUpdate.flags &
+                GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) &&
+            !engineHas(GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT,
+                       mEngineConfigShadow.aGlonassPositionProtocolMask ==
+                       gnssConfigRequested.aGlonassPositionProtocolMask)) {
             err = mLocApi->setAGLONASSProtocolSync(
                     gnssConfigRequested.aGlonassPositionProtocolMask);
+            mEngineConfigShadow.aGlonassPositionProtocolMask =
+                    gnssConfigRequested.aGlonassPositionProtocolMask;
+            updateShadow(GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT, err);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1189,12 +1531,23 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
             LOC_LOGe("Feature constellation enablement not supported.");
             err = LOCATION_ERROR_NOT_SUPPORTED;
         } else {
-            // Send the SV ID Config to Modem
             mBlacklistedSvIds.assign(gnssConfigRequested.blacklistedSvIds.begin(),
                     gnssConfigRequested.blacklistedSvIds.end());
-            err = gnssSvIdConfigUpdateSync(gnssConfigRequested.blacklistedSvIds);
-            if (LOCATION_ERROR_SUCCESS != err) {
-                LOC_LOGe("Failed to send config to modem, err %d", err);
+            GnssSvIdConfig svIdConfig = {};
+            convertToGnssSvIdConfig(gnssConfigRequested.blacklistedSvIds, svIdConfig);
+            // the masks are compared, so the same SVs listed in another order
+            // or twice are not sent again either
+            if (engineHas(GNSS_CONFIG_FLAGS_BLACKLISTED_SV_IDS_BIT,
+                          svIdConfig.equals(mGnssSvIdConfig))) {
+                LOC_LOGd("SV blacklist unchanged, not sent to modem");
+            } else {
+                // Send the SV ID Config to Modem
+                mGnssSvIdConfig = svIdConfig;
+                err = gnssSvIdConfigUpdateSync();
+                updateShadow(GNSS_CONFIG_FLAGS_BLACKLISTED_SV_IDS_BIT, err);
+                if (LOCATION_ERROR_SUCCESS != err) {
+                    LOC_LOGe("Failed to send config to modem, err %d", err);
+                }
             }
         }
         if (index < count) {
@@ -1204,10 +1557,16 @@ std::vector<LocationError> GnssAdapter::gnssUpdateConfig(const std::string& oldM
     }
     if (gnssConfigRequested.flags &
             GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) {
-        if (gnssConfigNeedEngineUpdate.flags &
-                GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) {
+        if ((gnssConfigNeedEngineUpdate.flags &
+                GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) &&
+            !engineHas(GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT,
+                       mEngineConfigShadow.emergencyExtensionSeconds ==
+                       gnssConfigRequested.emergencyExtensionSeconds)) {
             err = mLocApi->setEmergencyExtensionWindowSync(
                     gnssConfigRequested.emergencyExtensionSeconds);
+            mEngineConfigShadow.emergencyExtensionSeconds =
+                    gnssConfigRequested.emergencyExtensionSeconds;
+            updateShadow(GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT, err);
             if (index < count) {
                 errsList[index] = err;
             }
@@ -1265,42 +1624,27 @@ GnssAdapter::gnssUpdateConfigCommand(const GnssConfig& config)
         LocApiBase& mApi;
         GnssConfig mConfig;
         size_t mCount;
-        uint32_t* mIds;
+        GnssConfigIdArray mIds;
         inline MsgGnssUpdateConfig(GnssAdapter& adapter,
                                    LocApiBase& api,
                                    GnssConfig config,
-                                   uint32_t* ids,
+                                   const uint32_t* ids,
                                    size_t count) :
             LocMsg(),
             mAdapter(adapter),
             mApi(api),
             mConfig(config),
             mCount(count),
-            mIds(nullptr) {
-                if (mCount > 0) {
-                    mIds = new uint32_t[count];
-                    if (mIds) {
-                        for (uint32_t index = 0; index < count; index++) {
-                            mIds[index] = ids[index];
-                        }
-                    } else {
-                        LOC_LOGe("memory allocation for mIds failed");
-                    }
+            mIds(ids, count) {
+                if (mIds.size() != count) {
+                    LOC_LOGe("memory allocation for mIds failed");
+                    mCount = 0;
                 }
         }
 
-        inline MsgGnssUpdateConfig(const MsgGnssUpdateConfig& obj) :
-                MsgGnssUpdateConfig(obj.mAdapter, obj.mApi, obj.mConfig,
-                        obj.mIds, obj.mCount) {}
-
-        inline virtual ~MsgGnssUpdateConfig()
-        {
-            if (nullptr != mIds) delete[] mIds;
-        }
-
         inline virtual void proc() const {
             if (!mAdapter.isEngineCapabilitiesKnown()) {
-                mAdapter.mPendingMsgs.push_back(new MsgGnssUpdateConfig(*this));
+                mAdapter.queuePendingMsg(new MsgGnssUpdateConfig(*this));
                 return;
             }
             GnssAdapter& adapter = mAdapter;
@@ -1309,7 +1653,7 @@ GnssAdapter::gnssUpdateConfigCommand(const GnssConfig& config)
             GnssConfig gnssConfigNeedEngineUpdate = mConfig;
 
             std::vector<uint32_t> sessionIds;
-            sessionIds.assign(mIds, mIds + mCount);
+            sessionIds.assign(mIds.begin(), mIds.end());
             std::vector<LocationError> errs(mCount, LOCATION_ERROR_SUCCESS);
             int index = 0;
             bool needSuspendResume = false;
@@ -1485,19 +1829,6 @@ GnssAdapter::gnssSvIdConfigUpdate()
     mLocApi->setBlacklistSv(mGnssSvIdConfig);
 }
 
-LocationError
-GnssAdapter::gnssSvIdConfigUpdateSync(const std::vector<GnssSvIdSource>& blacklistedSvIds)
-{
-    // Clear the existing config
-    memset(&mGnssSvIdConfig, 0, sizeof(GnssSvIdConfig));
-
-    // Convert the sv id lists to masks
-    convertToGnssSvIdConfig(blacklistedSvIds, mGnssSvIdConfig);
-
-    // Now send to Modem
-    return gnssSvIdConfigUpdateSync();
-}
-
 LocationError
 GnssAdapter::gnssSvIdConfigUpdateSync()
 {
@@ -1559,52 +1890,63 @@ GnssAdapter::gnssGetConfigCommand(GnssConfigFlagsMask configMask) {
         GnssAdapter& mAdapter;
         LocApiBase& mApi;
         GnssConfigFlagsMask mConfigMask;
-        uint32_t* mIds;
+        GnssConfigIdArray mIds;
         size_t mCount;
         inline MsgGnssGetConfig(GnssAdapter& adapter,
                                 LocApiBase& api,
                                 GnssConfigFlagsMask configMask,
-                                uint32_t* ids,
+                                const uint32_t* ids,
                                 size_t count) :
             LocMsg(),
             mAdapter(adapter),
             mApi(api),
             mConfigMask(configMask),
-            mIds(nullptr),
+            mIds(ids, count),
             mCount(count) {
-                if (mCount > 0) {
-                    mIds = new uint32_t[count];
-                    if (mIds) {
-                        for (uint32_t index = 0; index < count; index++) {
-                            mIds[index] = ids[index];
-                        }
-                    } else {
-                        LOC_LOGe("memory allocation for mIds failed");
-                    }
+                if (mIds.size() != count) {
+                    LOC_LOGe("memory allocation for mIds failed");
+                    mCount = 0;
                 }
         }
-
-        inline MsgGnssGetConfig(const MsgGnssGetConfig& obj) :
-                MsgGnssGetConfig(obj.mAdapter, obj.mApi, obj.mConfigMask,
-                        obj.mIds, obj.mCount) {}
-
-        inline virtual ~MsgGnssGetConfig()
-        {
-            if (nullptr != mIds) delete[] mIds;
-        }
         inline virtual void proc() const {
             if (!mAdapter.isEngineCapabilitiesKnown()) {
-                mAdapter.mPendingMsgs.push_back(new MsgGnssGetConfig(*this));
+                mAdapter.queuePendingMsg(new MsgGnssGetConfig(*this));
                 return;
             }
-            LocationError* errs = new LocationError[mCount];
-            LocationError err = LOCATION_ERROR_SUCCESS;
-            uint32_t index = 0;
-
-            if (nullptr == errs) {
-                LOC_LOGE("%s] new allocation failed, fatal error.", __func__);
+            // The engine queries below all go out before any of them is
+            // answered. Their responses come back on this thread in any
+            // order and the collective response waits for the last one.
+            struct GetConfigJoin {
+                GnssAdapter& mAdapter;
+                loc_util::LocInlineArray<LocationError, GNSS_CONFIG_INLINE_IDS> mErrs;
+                GnssConfigIdArray mIds;
+                size_t mPending;
+                inline GetConfigJoin(GnssAdapter& adapter, const uint32_t* ids, size_t count) :
+                        mAdapter(adapter), mErrs(count, LOCATION_ERROR_SUCCESS),
+                        mIds(ids, count), mPending(1) {}
+                inline void done() {
+                    if (0 == --mPending) {
+                        mAdapter.reportResponse(mErrs.size(), mErrs.data(), mIds.data());
+                    }
+                }
+            };
+            if (mIds.empty()) {
                 return;
             }
+            std::shared_ptr<GetConfigJoin> join =
+                    std::make_shared<GetConfigJoin>(mAdapter, mIds.data(), mCount);
+            // a query answers into its slot and releases the join
+            auto issue = [this, &join] (uint32_t slot) -> LocApiResponse* {
+                join->mPending++;
+                return new LocApiResponse(*mAdapter.getContext(),
+                        [join, slot] (LocationError err) {
+                    join->mErrs[slot] = err;
+                    join->done();
+                });
+            };
+            LocationError* errs = join->mErrs.data();
+            LocationError err = LOCATION_ERROR_SUCCESS;
+            uint32_t index = 0;
 
             if (mConfigMask & GNSS_CONFIG_FLAGS_GPS_LOCK_VALID_BIT) {
                 if (index < mCount) {
@@ -1679,50 +2021,47 @@ GnssAdapter::gnssGetConfigCommand(GnssConfigFlagsMask configMask) {
                 }
             }
             if (mConfigMask & GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT) {
-                uint32_t sessionId = *(mIds+index);
-                LocApiResponse* locApiResponse =
-                        new LocApiResponse(*mAdapter.getContext(),
-                                           [this, sessionId] (LocationError err) {
-                                           mAdapter.reportResponse(err, sessionId);});
-                if (!locApiResponse) {
-                    LOC_LOGe("memory alloc failed");
-                    mAdapter.reportResponse(LOCATION_ERROR_GENERAL_FAILURE, sessionId);
-                } else {
-                   mApi.getRobustLocationConfig(sessionId, locApiResponse);
+                const RobustLocationConfigInfo& cached =
+                        mAdapter.mLocConfigInfo.robustLocationConfigInfo;
+                if (index < mCount) {
+                    uint32_t slot = index++;
+                    if (cached.isValid && cached.versionValid) {
+                        // the engine has what was set last, no need to ask it
+                        GnssConfig config = {};
+                        config.size = sizeof(GnssConfig);
+                        config.flags = GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT;
+                        config.robustLocationConfig.validMask =
+                                (GnssConfigRobustLocationValidMask)
+                                (GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT |
+                                 GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT |
+                                 GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT);
+                        config.robustLocationConfig.enabled = cached.enable;
+                        config.robustLocationConfig.enabledForE911 = cached.enableFor911;
+                        config.robustLocationConfig.version = cached.version;
+                        mAdapter.reportGnssConfigEvent(mIds[slot], config);
+                        errs[slot] = LOCATION_ERROR_SUCCESS;
+                    } else {
+                        mApi.getRobustLocationConfig(mIds[slot], issue(slot));
+                    }
                 }
             }
 
             if (mConfigMask & GNSS_CONFIG_FLAGS_MIN_GPS_WEEK_BIT) {
-                uint32_t sessionId = *(mIds+index);
-                LocApiResponse* locApiResponse =
-                        new LocApiResponse(*mAdapter.getContext(),
-                                           [this, sessionId] (LocationError err) {
-                                           mAdapter.reportResponse(err, sessionId);});
-                if (!locApiResponse) {
-                    LOC_LOGe("memory alloc failed");
-                    mAdapter.reportResponse(LOCATION_ERROR_GENERAL_FAILURE, sessionId);
-                } else {
-                   mApi.getMinGpsWeek(sessionId, locApiResponse);
+                if (index < mCount) {
+                    uint32_t slot = index++;
+                    mApi.getMinGpsWeek(mIds[slot], issue(slot));
                 }
             }
 
             if (mConfigMask & GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT) {
-                uint32_t sessionId = *(mIds+index);
-                LocApiResponse* locApiResponse =
-                        new LocApiResponse(*mAdapter.getContext(),
-                                           [this, sessionId] (LocationError err) {
-                                           mAdapter.reportResponse(err, sessionId);});
-                if (!locApiResponse) {
-                    LOC_LOGe("memory alloc failed");
-                    mAdapter.reportResponse(LOCATION_ERROR_GENERAL_FAILURE, sessionId);
-                } else {
-                    mApi.getParameter(sessionId, GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT,
-                                      locApiResponse);
+                if (index < mCount) {
+                    uint32_t slot = index++;
+                    mApi.getParameter(mIds[slot], GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT,
+                                      issue(slot));
                 }
             }
 
-            mAdapter.reportResponse(index, errs, mIds);
-            delete[] errs;
+            join->done();
 
         }
     };
@@ -1736,101 +2075,87 @@ GnssAdapter::gnssGetConfigCommand(GnssConfigFlagsMask configMask) {
     return ids;
 }
 
+// Where the SV ids of each constellation sit in the GnssSvIdConfig masks. SBAS
+// has two ranges, SV 120 to 158 map to bits 0 to 38, SV 183 onwards to bit 39
+// onwards. The order is the one blacklists are reported in.
+static const struct {
+    GnssSvType constellation;
+    uint64_t GnssSvIdConfig::* svMask;
+    GnssSvId firstSvId;
+    uint32_t firstBit;
+    uint32_t svIdCount;
+} sGnssSvIdConfigRanges[] = {
+    { GNSS_SV_TYPE_BEIDOU, &GnssSvIdConfig::bdsBlacklistSvMask,
+      GNSS_SV_CONFIG_BDS_INITIAL_SV_ID, 0, 64 },
+    { GNSS_SV_TYPE_GALILEO, &GnssSvIdConfig::galBlacklistSvMask,
+      GNSS_SV_CONFIG_GAL_INITIAL_SV_ID, 0, 64 },
+    { GNSS_SV_TYPE_GLONASS, &GnssSvIdConfig::gloBlacklistSvMask,
+      GNSS_SV_CONFIG_GLO_INITIAL_SV_ID, 0, 64 },
+    { GNSS_SV_TYPE_QZSS, &GnssSvIdConfig::qzssBlacklistSvMask,
+      GNSS_SV_CONFIG_QZSS_INITIAL_SV_ID, 0, 64 },
+    { GNSS_SV_TYPE_SBAS, &GnssSvIdConfig::sbasBlacklistSvMask,
+      GNSS_SV_CONFIG_SBAS_INITIAL_SV_ID, 0, GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH },
+    { GNSS_SV_TYPE_SBAS, &GnssSvIdConfig::sbasBlacklistSvMask,
+      GNSS_SV_CONFIG_SBAS_INITIAL2_SV_ID, GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH,
+      64 - GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH },
+    { GNSS_SV_TYPE_NAVIC, &GnssSvIdConfig::navicBlacklistSvMask,
+      GNSS_SV_CONFIG_NAVIC_INITIAL_SV_ID, 0, 64 },
+};
+
 bool
 GnssAdapter::convertToGnssSvIdConfig(
         const std::vector<GnssSvIdSource>& blacklistedSvIds, GnssSvIdConfig& config)
 {
-    bool retVal = false;
     config.size = sizeof(GnssSvIdConfig);
+    config.gloBlacklistSvMask = 0;
+    config.bdsBlacklistSvMask = 0;
+    config.qzssBlacklistSvMask = 0;
+    config.galBlacklistSvMask = 0;
+    config.sbasBlacklistSvMask = 0;
+    config.navicBlacklistSvMask = 0;
 
     // Empty vector => Clear any previous blacklisted SVs
-    if (0 == blacklistedSvIds.size()) {
-        config.gloBlacklistSvMask = 0;
-        config.bdsBlacklistSvMask = 0;
-        config.qzssBlacklistSvMask = 0;
-        config.galBlacklistSvMask = 0;
-        config.sbasBlacklistSvMask = 0;
-        config.navicBlacklistSvMask = 0;
-        retVal = true;
-    } else {
-        // Parse the vector and convert SV IDs to mask values
-        for (GnssSvIdSource source : blacklistedSvIds) {
-            uint64_t* svMaskPtr = NULL;
-            GnssSvId initialSvId = 0;
-            uint16_t svIndexOffset = 0;
-            switch(source.constellation) {
-            case GNSS_SV_TYPE_GLONASS:
-                svMaskPtr = &config.gloBlacklistSvMask;
-                initialSvId = GNSS_SV_CONFIG_GLO_INITIAL_SV_ID;
-                break;
-            case GNSS_SV_TYPE_BEIDOU:
-                svMaskPtr = &config.bdsBlacklistSvMask;
-                initialSvId = GNSS_SV_CONFIG_BDS_INITIAL_SV_ID;
-                break;
-            case GNSS_SV_TYPE_QZSS:
-                svMaskPtr = &config.qzssBlacklistSvMask;
-                initialSvId = GNSS_SV_CONFIG_QZSS_INITIAL_SV_ID;
-                break;
-            case GNSS_SV_TYPE_GALILEO:
-                svMaskPtr = &config.galBlacklistSvMask;
-                initialSvId = GNSS_SV_CONFIG_GAL_INITIAL_SV_ID;
-                break;
-            case GNSS_SV_TYPE_SBAS:
-                // SBAS does not support enable/disable whole constellation
-                // so do not set up svTypeMask for SBAS
-                svMaskPtr = &config.sbasBlacklistSvMask;
-                // SBAS currently has two ranges, [120, 158] and [183, 191]
-                if (0 == source.svId) {
-                    LOC_LOGd("blacklist all SBAS SV");
-                } else if (source.svId >= GNSS_SV_CONFIG_SBAS_INITIAL2_SV_ID) {
-                    // handle SV id in range [183, 191]
-                    initialSvId = GNSS_SV_CONFIG_SBAS_INITIAL2_SV_ID;
-                    svIndexOffset = GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH;
-                } else if ((source.svId >= GNSS_SV_CONFIG_SBAS_INITIAL_SV_ID) &&
-                           (source.svId < (GNSS_SV_CONFIG_SBAS_INITIAL_SV_ID +
-                                           GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH))){
-                        // handle SV id in range of [120, 158]
-                        initialSvId = GNSS_SV_CONFIG_SBAS_INITIAL_SV_ID;
-                    } else {
-                        LOC_LOGe("invalid SBAS sv id %d", source.svId);
-                        svMaskPtr = nullptr;
-                    }
-                    break;
-            case GNSS_SV_TYPE_NAVIC:
-                 svMaskPtr = &config.navicBlacklistSvMask;
-                 initialSvId = GNSS_SV_CONFIG_NAVIC_INITIAL_SV_ID;
-                break;
-            default:
+    bool retVal = blacklistedSvIds.empty();
+
+    for (const GnssSvIdSource& source : blacklistedSvIds) {
+        bool knownConstellation = false;
+        bool validSvId = false;
+        for (const auto& range : sGnssSvIdConfigRanges) {
+            if (range.constellation != source.constellation) {
+                continue;
+            }
+            knownConstellation = true;
+            // SV ID 0 = All SV IDs
+            if (0 == source.svId) {
+                config.*range.svMask = GNSS_SV_CONFIG_ALL_BITS_ENABLED_MASK;
+                validSvId = true;
                 break;
             }
-
-            if (NULL == svMaskPtr) {
-                LOC_LOGe("Invalid constellation %d", source.constellation);
-            } else {
-                // SV ID 0 = All SV IDs
-                if (0 == source.svId) {
-                    *svMaskPtr = GNSS_SV_CONFIG_ALL_BITS_ENABLED_MASK;
-                } else if (source.svId < initialSvId || source.svId >= initialSvId + 64) {
-                    LOC_LOGe("Invalid sv id %d for sv type %d",
-                            source.svId, source.constellation);
-                } else {
-                    uint32_t shiftCnt = source.svId + svIndexOffset - initialSvId;
-                    *svMaskPtr |= (1ULL << shiftCnt);
-                }
+            uint32_t index = source.svId - range.firstSvId;
+            if (source.svId >= range.firstSvId && index < range.svIdCount) {
+                config.*range.svMask |= (1ULL << (range.firstBit + index));
+                validSvId = true;
+                break;
             }
         }
 
-        // Return true if any one source is valid
-        if (0 != config.gloBlacklistSvMask ||
-                0 != config.bdsBlacklistSvMask ||
-                0 != config.galBlacklistSvMask ||
-                0 != config.qzssBlacklistSvMask ||
-                0 != config.sbasBlacklistSvMask ||
-                0 != config.navicBlacklistSvMask) {
-            retVal = true;
+        if (!knownConstellation) {
+            LOC_LOGe("Invalid constellation %d", source.constellation);
+        } else if (!validSvId) {
+            LOC_LOGe("Invalid sv id %d for sv type %d", source.svId, source.constellation);
         }
     }
 
+    // Return true if any one source is valid
+    if (0 != config.gloBlacklistSvMask ||
+            0 != config.bdsBlacklistSvMask ||
+            0 != config.galBlacklistSvMask ||
+            0 != config.qzssBlacklistSvMask ||
+            0 != config.sbasBlacklistSvMask ||
+            0 != config.navicBlacklistSvMask) {
+        retVal = true;
+    }
+
     LOC_LOGd("blacklist bds 0x%" PRIx64 ", glo 0x%" PRIx64
             ", qzss 0x%" PRIx64 ", gal 0x%" PRIx64 ", sbas 0x%" PRIx64 ", navic 0x%" PRIx64,
              config.bdsBlacklistSvMask, config.gloBlacklistSvMask,
@@ -1844,47 +2169,30 @@ void GnssAdapter::convertFromGnssSvIdConfig(
         const GnssSvIdConfig& svConfig, std::vector<GnssSvIdSource>& blacklistedSvIds)
 {
     // Convert blacklisted SV mask values to vectors
-    if (svConfig.bdsBlacklistSvMask) {
-        convertGnssSvIdMaskToList(
-                svConfig.bdsBlacklistSvMask, blacklistedSvIds,
-                GNSS_SV_CONFIG_BDS_INITIAL_SV_ID, GNSS_SV_TYPE_BEIDOU);
-    }
-    if (svConfig.galBlacklistSvMask) {
-        convertGnssSvIdMaskToList(
-                svConfig.galBlacklistSvMask, blacklistedSvIds,
-                GNSS_SV_CONFIG_GAL_INITIAL_SV_ID, GNSS_SV_TYPE_GALILEO);
-    }
-    if (svConfig.gloBlacklistSvMask) {
-        convertGnssSvIdMaskToList(
-                svConfig.gloBlacklistSvMask, blacklistedSvIds,
-                GNSS_SV_CONFIG_GLO_INITIAL_SV_ID, GNSS_SV_TYPE_GLONASS);
-    }
-    if (svConfig.qzssBlacklistSvMask) {
-        convertGnssSvIdMaskToList(
-                svConfig.qzssBlacklistSvMask, blacklistedSvIds,
-                GNSS_SV_CONFIG_QZSS_INITIAL_SV_ID, GNSS_SV_TYPE_QZSS);
-    }
-    if (svConfig.sbasBlacklistSvMask) {
-        // SBAS - SV 120 to 158, maps to 0 to 38
-        //        SV 183 to 191, maps to 39 to 47
-        uint64_t sbasBlacklistSvMask = svConfig.sbasBlacklistSvMask;
-        // operate on 120 and 158 first
-        sbasBlacklistSvMask <<= (64 - GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH);
-        sbasBlacklistSvMask >>= (64 - GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH);
-        convertGnssSvIdMaskToList(
-                sbasBlacklistSvMask, blacklistedSvIds,
-                GNSS_SV_CONFIG_SBAS_INITIAL_SV_ID, GNSS_SV_TYPE_SBAS);
-        // operate on the second range
-        sbasBlacklistSvMask = svConfig.sbasBlacklistSvMask;
-        sbasBlacklistSvMask >>= GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH;
-        convertGnssSvIdMaskToList(
-                sbasBlacklistSvMask, blacklistedSvIds,
-                GNSS_SV_CONFIG_SBAS_INITIAL2_SV_ID, GNSS_SV_TYPE_SBAS);
-    }
-    if (svConfig.navicBlacklistSvMask) {
-        convertGnssSvIdMaskToList(
-                svConfig.navicBlacklistSvMask, blacklistedSvIds,
-                GNSS_SV_CONFIG_NAVIC_INITIAL_SV_ID, GNSS_SV_TYPE_NAVIC);
+    for (size_t i = 0; i < sizeof(sGnssSvIdConfigRanges) / sizeof(sGnssSvIdConfigRanges[0]);
+            i++) {
+        const auto& range = sGnssSvIdConfigRanges[i];
+        uint64_t svMask = svConfig.*range.svMask;
+        if (0 == svMask) {
+            continue;
+        }
+        // SV ID 0 => All SV IDs of the constellation, reported once
+        if (GNSS_SV_CONFIG_ALL_BITS_ENABLED_MASK == svMask) {
+            if (0 == i || sGnssSvIdConfigRanges[i - 1].constellation != range.constellation) {
+                LOC_LOGd("blacklist all SVs in constellation %d", range.constellation);
+                GnssSvIdSource source = {};
+                source.size = sizeof(GnssSvIdSource);
+                source.constellation = range.constellation;
+                source.svId = 0;
+                blacklistedSvIds.push_back(source);
+            }
+            continue;
+        }
+        svMask >>= range.firstBit;
+        if (range.svIdCount < 64) {
+            svMask &= (1ULL << range.svIdCount) - 1;
+        }
+        convertGnssSvIdMaskToList(svMask, blacklistedSvIds, range.firstSvId, range.constellation);
     }
 }
 
@@ -1896,35 +2204,11 @@ void GnssAdapter::convertGnssSvIdMaskToList(
     source.size = sizeof(GnssSvIdSource);
     source.constellation = svType;
 
-    // SV ID 0 => All SV IDs in mask
-    if (GNSS_SV_CONFIG_ALL_BITS_ENABLED_MASK == svIdMask) {
-        LOC_LOGd("blacklist all SVs in constellation %d", source.constellation);
-        source.svId = 0;
+    // one entry per set bit, lowest first, without walking the clear ones
+    while (0 != svIdMask) {
+        source.svId = initialSvId + __builtin_ctzll(svIdMask);
         svIds.push_back(source);
-        return;
-    }
-
-    // Convert each bit in svIdMask to vector entry
-    uint32_t bitNumber = 0;
-    while (svIdMask > 0) {
-        if (svIdMask & 0x1) {
-            source.svId = bitNumber + initialSvId;
-            // SBAS has two ranges:
-            // SBAS - SV 120 to 158, maps to 0 to 38
-            //        SV 183 to 191, maps to 39 to 47
-            // #define GNSS_SV_CONFIG_SBAS_INITIAL_SV_ID     120
-            // #define GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH 39
-            // #define GNSS_SV_CONFIG_SBAS_INITIAL2_SV_ID    183
-            if (svType == GNSS_SV_TYPE_SBAS) {
-                if (bitNumber >= GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH) {
-                    source.svId = bitNumber - GNSS_SV_CONFIG_SBAS_INITIAL_SV_LENGTH +
-                                  GNSS_SV_CONFIG_SBAS_INITIAL2_SV_ID;
-                }
-            }
-            svIds.push_back(source);
-        }
-        bitNumber++;
-        svIdMask >>= 1;
+        svIdMask &= svIdMask - 1;
     }
 }
 
@@ -1988,7 +2272,7 @@ GnssAdapter::gnssUpdateSvTypeConfigCommand(GnssSvTypeConfig config)
             mConfig(config) {}
         inline virtual void proc() const {
             if (!mAdapter->isEngineCapabilitiesKnown()) {
-                mAdapter->mPendingMsgs.push_back(new MsgGnssUpdateSvTypeConfig(*this));
+                mAdapter->queuePendingMsg(new MsgGnssUpdateSvTypeConfig(*this));
                 return;
             }
             // Check if feature is supported
@@ -2032,12 +2316,6 @@ GnssAdapter::gnssSvTypeConfigUpdate(bool sendReset)
             mGnssSvIdConfig.qzssBlacklistSvMask, mGnssSvIdConfig.galBlacklistSvMask,
             mGnssSvIdConfig.sbasBlacklistSvMask, mGnssSvIdConfig.navicBlacklistSvMask);
 
-    LOC_LOGd("blacklist bds 0x%" PRIx64 ", glo 0x%" PRIx64
-            ", qzss 0x%" PRIx64 ", gal 0x%" PRIx64 ", sbas 0x%" PRIx64 ", Navic 0x%" PRIx64,
-            mGnssSvIdConfig.bdsBlacklistSvMask, mGnssSvIdConfig.gloBlacklistSvMask,
-            mGnssSvIdConfig.qzssBlacklistSvMask, mGnssSvIdConfig.galBlacklistSvMask,
-            mGnssSvIdConfig.sbasBlacklistSvMask, mGnssSvIdConfig.navicBlacklistSvMask);
-
     if (mGnssSvTypeConfig.size == sizeof(mGnssSvTypeConfig)) {
 
         if (sendReset) {
@@ -2095,7 +2373,9 @@ GnssAdapter::gnssGetSvTypeConfigCommand(GnssSvTypeConfigCallback callback)
             mCallback(callback) {}
         inline virtual void proc() const {
             if (!mAdapter->isEngineCapabilitiesKnown()) {
-                mAdapter->mPendingMsgs.push_back(new MsgGnssGetSvTypeConfig(*this));
+                // only the last callback is kept anyway
+                mAdapter->queueIdempotentPendingMsg(new MsgGnssGetSvTypeConfig(*this),
+                                                    nullptr);
                 return;
             }
             if (!ContextBase::isFeatureSupported(
@@ -2127,7 +2407,8 @@ GnssAdapter::gnssResetSvTypeConfigCommand()
             mApi(api) {}
         inline virtual void proc() const {
             if (!mAdapter->isEngineCapabilitiesKnown()) {
-                mAdapter->mPendingMsgs.push_back(new MsgGnssResetSvTypeConfig(*this));
+                mAdapter->queueIdempotentPendingMsg(new MsgGnssResetSvTypeConfig(*this),
+                                                    nullptr);
                 return;
             }
             if (!ContextBase::isFeatureSupported(
@@ -2332,12 +2613,61 @@ GnssAdapter::injectLocationExtCommand(const GnssLocationInfoNotification &locati
     sendMsg(new MsgInjectLocationExt(*mLocApi, *mContext, locationInfo));
 }
 
+#define TIME_INJECT_ENGINE_STATUS_MAX_AGE_SEC (30)
+
+// The framework repeats the same NTP time (same offset to the elapsed realtime
+// reference) every time it refreshes. Such a time gives the engine nothing to
+// work with if it is no better than the last injection and the engine's own
+// time uncertainty, as last reported, is already below the injected one.
+bool
+GnssAdapter::isRedundantTimeInjection(int64_t time, int64_t timeReference,
+                                      int32_t uncertainty)
+{
+    int64_t offsetMs = time - timeReference;
+    std::lock_guard<std::mutex> lock(mTimeInjectLock);
+
+    bool redundant = false;
+    if (mTimeInjectValid && uncertainty >= mTimeInjectUncMs &&
+            llabs(offsetMs - mTimeInjectOffsetMs) <= (int64_t)uncertainty) {
+        auto timeAndClock = mSystemStatus->getLatest(&SystemStatusReports::mTimeAndClock);
+        timeval now;
+        gettimeofday(&now, nullptr);
+        if (nullptr != timeAndClock && timeAndClock->mTimeValid &&
+                now.tv_sec - timeAndClock->mUtcTime.tv_sec <=
+                        TIME_INJECT_ENGINE_STATUS_MAX_AGE_SEC) {
+            // same units as the time uncertainty of getDebugReport
+            uint64_t engineUncNs = (timeAndClock->mTimeUncNs > 0) ?
+                    timeAndClock->mTimeUncNs : (uint64_t)timeAndClock->mTimeUnc * 1000ULL;
+            redundant = (engineUncNs < (uint64_t)uncertainty * 1000000ULL);
+        }
+    }
+    if (!redundant) {
+        mTimeInjectValid = true;
+        mTimeInjectOffsetMs = offsetMs;
+        mTimeInjectUncMs = uncertainty;
+    }
+    return redundant;
+}
+
+// engine lost its time, the next injection must go through
+void
+GnssAdapter::resetTimeInjection()
+{
+    std::lock_guard<std::mutex> lock(mTimeInjectLock);
+    mTimeInjectValid = false;
+}
+
 void
 GnssAdapter::injectTimeCommand(int64_t time, int64_t timeReference, int32_t uncertainty)
 {
     LOC_LOGD("%s]: time %lld timeReference %lld uncertainty %d",
              __func__, (long long)time, (long long)timeReference, uncertainty);
 
+    if (isRedundantTimeInjection(time, timeReference, uncertainty)) {
+        LOC_LOGd("engine time is better than the repeated injection, skipped");
+        return;
+    }
+
     struct MsgInjectTime : public LocMsg {
         LocApiBase& mApi;
         ContextBase& mContext;
@@ -2403,8 +2733,13 @@ GnssAdapter::blockCPICommand(double latitude, double longitude,
 void
 GnssAdapter::updateSystemPowerState(PowerStateType systemPowerState) {
     if (POWER_STATE_UNKNOWN != systemPowerState) {
+        PowerStateType prevPowerState = mSystemPowerState;
         mSystemPowerState = systemPowerState;
         mLocApi->updateSystemPowerState(mSystemPowerState);
+        if ((POWER_STATE_SUSPEND == prevPowerState) !=
+                (POWER_STATE_SUSPEND == mSystemPowerState)) {
+            updateSuspendTrackingThrottle();
+        }
     }
 }
 
@@ -2489,9 +2824,117 @@ GnssAdapter::stopClientSessions(LocationAPI* client)
 
 }
 
+void
+GnssAdapter::updateClientSubscribers()
+{
+    mPositionSubscribers.clear();
+    mFlpPositionSubscribers.clear();
+    mGnssPositionSubscribers.clear();
+    mFlpLocationInfoNeeded = false;
+    mGnssLocationInfoNeeded = false;
+    mEngineLocationsSubscribers.clear();
+    mSvSubscribers.clear();
+    mNmeaSubscribers.clear();
+    mMeasurementsSubscribers.clear();
+    mDataSubscribers.clear();
+    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
+        LocationCallbacks* callbacks = &it->second;
+        if (nullptr != callbacks->gnssLocationInfoCb ||
+            nullptr != callbacks->engineLocationsInfoCb ||
+            nullptr != callbacks->trackingCb) {
+            bool needsInfo = (nullptr != callbacks->gnssLocationInfoCb ||
+                              nullptr != callbacks->engineLocationsInfoCb);
+            mPositionSubscribers.push_back(callbacks);
+            if (isFlpClient(*callbacks)) {
+                mFlpPositionSubscribers.push_back(callbacks);
+                mFlpLocationInfoNeeded |= needsInfo;
+            } else {
+                mGnssPositionSubscribers.push_back(callbacks);
+                mGnssLocationInfoNeeded |= needsInfo;
+            }
+        }
+        if (nullptr != callbacks->engineLocationsInfoCb) {
+            mEngineLocationsSubscribers.push_back(
+                    EngineLocationsSubscriber{it->first, callbacks, 0});
+        }
+        if (nullptr != callbacks->gnssSvCb) {
+            mSvSubscribers.push_back(callbacks);
+        }
+        if (nullptr != callbacks->gnssNmeaCb) {
+            mNmeaSubscribers.push_back(callbacks);
+        }
+        if (nullptr != callbacks->gnssMeasurementsCb) {
+            mMeasurementsSubscribers.push_back(
+                    MeasurementsSubscriber{it->first, callbacks, 0, 0});
+        }
+        if (nullptr != callbacks->gnssDataCb) {
+            mDataSubscribers.push_back(callbacks);
+        }
+    }
+    updateSessionSubscribers();
+}
+
+#define ENGINE_LOCATIONS_ALL_MASK ((1u << LOC_OUTPUT_ENGINE_COUNT) - 1)
+// sessions at most this fast take every measurement epoch the engine reports
+#define MEASUREMENTS_DECIMATION_MIN_INTERVAL_MS (100)
+
+// bit of the engine that produced a report, every bit if it does not say
+static inline uint32_t engineLocationMask(const EngineLocationInfo& engLocation)
+{
+    const GpsLocationExtended& ext = engLocation.locationExtended;
+    if ((GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_TYPE & ext.flags) &&
+            ext.locOutputEngType < LOC_OUTPUT_ENGINE_COUNT) {
+        return (1u << ext.locOutputEngType);
+    }
+    return ENGINE_LOCATIONS_ALL_MASK;
+}
+
+void
+GnssAdapter::updateSessionSubscribers()
+{
+    uint32_t neededMask = 0;
+    for (auto& subscriber : mEngineLocationsSubscribers) {
+        // LOC_REQ_ENGINE_*_BIT is 1 << LOC_OUTPUT_ENGINE_* of the same engine
+        uint32_t engineMask = 0;
+        for (auto& session : mTimeBasedTrackingSessions) {
+            if (session.first.client == subscriber.client) {
+                engineMask |= session.second.locReqEngTypeMask;
+            }
+        }
+        for (auto& session : mDistanceBasedTrackingSessions) {
+            if (session.first.client == subscriber.client) {
+                engineMask |= session.second.locReqEngTypeMask;
+            }
+        }
+        subscriber.engineMask = (0 == engineMask) ? ENGINE_LOCATIONS_ALL_MASK : engineMask;
+        neededMask |= subscriber.engineMask;
+    }
+    mEngineLocationsNeededMask.store(neededMask, std::memory_order_relaxed);
+
+    for (auto& subscriber : mMeasurementsSubscribers) {
+        uint32_t minIntervalMs = UINT32_MAX;
+        for (auto& session : mTimeBasedTrackingSessions) {
+            if (session.first.client == subscriber.client) {
+                minIntervalMs = (GNSS_POWER_MODE_M1 == session.second.powerMode) ? 0 :
+                        std::min(minIntervalMs, session.second.minInterval);
+            }
+        }
+        if (UINT32_MAX == minIntervalMs) {
+            minIntervalMs = 0;
+        }
+        if (minIntervalMs != subscriber.minIntervalMs) {
+            subscriber.minIntervalMs = minIntervalMs;
+            subscriber.nextDueNs = 0;
+        }
+    }
+}
+
 void
 GnssAdapter::updateClientsEventMask()
 {
+    // saveClient / eraseClient land here after every mClientData change
+    updateClientSubscribers();
+
     // need to register for leap second info
     // for proper nmea generation
     LOC_API_ADAPTER_EVENT_MASK_T mask = LOC_API_ADAPTER_BIT_LOC_SYSTEM_INFO |
@@ -2575,11 +3018,20 @@ GnssAdapter::handleEngineUpEvent()
             LocMsg(),
             mAdapter(adapter) {}
         virtual void proc() const {
+            uint64_t startNs = GnssInitTimings::nowNs();
+            mAdapter.resetTimeInjection();
             mAdapter.setEngineCapabilitiesKnown(true);
             mAdapter.broadcastCapabilities(mAdapter.getCapabilities());
             // must be called only after capabilities are known
             mAdapter.setConfig();
-            mAdapter.gnssSvIdConfigUpdate();
+            // engine restarted without a position, give it the cached one
+            mAdapter.injectCachedLastFix();
+            // setConfig() replays the cached SV blacklist through gnssUpdateConfig
+            // when the engine supports it, no need to send the same config again
+            if (!ContextBase::isFeatureSupported(
+                    LOC_SUPPORTED_FEATURE_CONSTELLATION_ENABLEMENT_V02)) {
+                mAdapter.gnssSvIdConfigUpdate();
+            }
             mAdapter.gnssSvTypeConfigUpdate();
             mAdapter.updateSystemPowerState(mAdapter.getSystemPowerState());
             mAdapter.gnssSecondaryBandConfigUpdate();
@@ -2587,10 +3039,8 @@ GnssAdapter::handleEngineUpEvent()
             mAdapter.initCDFWService();
             // restart sessions
             mAdapter.restartSessions(true);
-            for (auto msg: mAdapter.mPendingMsgs) {
-                mAdapter.sendMsg(msg);
-            }
-            mAdapter.mPendingMsgs.clear();
+            mAdapter.replayPendingMsgs();
+            mAdapter.mInitTimings.record(GNSS_INIT_STEP_ENGINE_UP, startNs);
         }
     };
 
@@ -2598,6 +3048,14 @@ GnssAdapter::handleEngineUpEvent()
     sendMsg(new MsgHandleEngineUpEvent(*this));
 }
 
+void
+GnssAdapter::handleConfigChangeEvent(const char* /*confPath*/, const LocConfNames& changed)
+{
+    if (changed.count("AGPS_PREWARM_MODE") > 0) {
+        updateAgpsPrewarmCommand();
+    }
+}
+
 void
 GnssAdapter::restartSessions(bool modemSSR)
 {
@@ -2683,6 +3141,8 @@ void GnssAdapter::checkAndRestartTimeBasedSession()
         }
 
         highestPowerTrackingOptions.setLocationOptions(smallestIntervalOptions);
+        mSuspendTrackingThrottled =
+                applySuspendTrackingThrottle(nullptr, highestPowerTrackingOptions);
         // want to run SPE session at a fixed min interval in some automotive scenarios
         if(!checkAndSetSPEToRunforNHz(highestPowerTrackingOptions)) {
             mLocApi->startTimeBasedTracking(highestPowerTrackingOptions, nullptr);
@@ -2811,6 +3271,9 @@ GnssAdapter::reportPowerStateIfChanged()
         if (mPowerStateCb != nullptr) {
             mPowerStateCb(mPowerOn);
         }
+        if (1 == ContextBase::mGps_conf.AGPS_PREWARM_MODE) {
+            updateAgpsPrewarm();
+        }
     }
 }
 
@@ -2845,9 +3308,21 @@ GnssAdapter::saveTrackingSession(LocationAPI* client, uint32_t sessionId,
             ContextBase::isMessageSupported(LOC_API_ADAPTER_MESSAGE_DISTANCE_BASE_TRACKING)) {
         mDistanceBasedTrackingSessions[key] = options;
     } else {
-        mTimeBasedTrackingSessions[key] = options;
-    }
+        TrackingOptions& saved = mTimeBasedTrackingSessions[key];
+        auto itr = mTimeBasedTrackingIntervals.find(std::make_pair(saved.minInterval, key));
+        if (itr != mTimeBasedTrackingIntervals.end()) {
+            // replacing an existing session, drop its old index entries
+            mTimeBasedTrackingIntervals.erase(itr);
+            mTimeBasedTrackingPowerModes.erase(
+                    mTimeBasedTrackingPowerModes.find(saved.powerMode));
+        }
+        saved = options;
+        mTimeBasedTrackingIntervals.emplace(options.minInterval, key);
+        mTimeBasedTrackingPowerModes.insert(options.powerMode);
+    }
+    updateSessionSubscribers();
     reportPowerStateIfChanged();
+    updateEnergyProfileState();
 }
 
 void
@@ -2856,6 +3331,10 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
     LocationSessionKey key(client, sessionId);
     auto it = mTimeBasedTrackingSessions.find(key);
     if (it != mTimeBasedTrackingSessions.end()) {
+        mTimeBasedTrackingIntervals.erase(
+                mTimeBasedTrackingIntervals.find(std::make_pair(it->second.minInterval, key)));
+        mTimeBasedTrackingPowerModes.erase(
+                mTimeBasedTrackingPowerModes.find(it->second.powerMode));
         mTimeBasedTrackingSessions.erase(it);
     } else {
         auto itr = mDistanceBasedTrackingSessions.find(key);
@@ -2863,7 +3342,67 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
             mDistanceBasedTrackingSessions.erase(itr);
         }
     }
+    updateSessionSubscribers();
     reportPowerStateIfChanged();
+    updateEnergyProfileState();
+}
+
+// Called whenever one of the GnssEnergyProfileState inputs may have changed;
+// the energy reading closes the interval of the previous state
+void
+GnssAdapter::updateEnergyProfileState()
+{
+    if (0 == ContextBase::mGps_conf.GNSS_ENERGY_PROFILE_ENABLED) {
+        return;
+    }
+
+    TrackingOptions options;
+    GnssEnergyProfileState state = {};
+    getMultiplexedTrackingOptions(nullptr, options, state.powerMode);
+    state.sessions = mTimeBasedTrackingSessions.size();
+    state.tbfMs = options.minInterval;
+    state.enabledSvTypes = mGnssSvTypeConfig.enabledSvTypesMask;
+    auto screenState = mSystemStatus->getLatest(&SystemStatusReports::mScreenState);
+    state.screenOn = (nullptr == screenState) ? -1 : (screenState->mState ? 1 : 0);
+
+    if (mEnergyProfile.setState(state)) {
+        mLocApi->getGnssEnergyConsumed();
+    }
+}
+
+// Options of the time based session with the smallest interval (first in key
+// order on a tie) and the smallest powerMode over all time based sessions,
+// leaving out excludedKey if given. options.size stays 0 and powerMode
+// GNSS_POWER_MODE_INVALID when no other session is left.
+void
+GnssAdapter::getMultiplexedTrackingOptions(const LocationSessionKey* excludedKey,
+                                           TrackingOptions& options, GnssPowerMode& powerMode)
+{
+    memset(&options, 0, sizeof(options));
+    powerMode = GNSS_POWER_MODE_INVALID;
+
+    auto modeIt = mTimeBasedTrackingPowerModes.begin();
+    auto intervalIt = mTimeBasedTrackingIntervals.begin();
+    if (nullptr != excludedKey) {
+        auto excluded = mTimeBasedTrackingSessions.find(*excludedKey);
+        if (excluded != mTimeBasedTrackingSessions.end()) {
+            // the excluded session holds one of the entries, skip it if it is the front one
+            if (intervalIt != mTimeBasedTrackingIntervals.end() &&
+                intervalIt->second == *excludedKey) {
+                ++intervalIt;
+            }
+            if (modeIt != mTimeBasedTrackingPowerModes.end() &&
+                *modeIt == excluded->second.powerMode) {
+                ++modeIt;
+            }
+        }
+    }
+    if (intervalIt != mTimeBasedTrackingIntervals.end()) {
+        options = mTimeBasedTrackingSessions.find(intervalIt->second)->second;
+    }
+    if (modeIt != mTimeBasedTrackingPowerModes.end()) {
+        powerMode = *modeIt;
+    }
 }
 
 bool GnssAdapter::setLocPositionMode(const LocPosMode& mode) {
@@ -2954,7 +3493,7 @@ GnssAdapter::startTrackingCommand(LocationAPI* client, TrackingOptions& options)
         inline virtual void proc() const {
             // distance based tracking will need to know engine capabilities before it can start
             if (!mAdapter.isEngineCapabilitiesKnown() && mOptions.minDistance > 0) {
-                mAdapter.mPendingMsgs.push_back(new MsgStartTracking(*this));
+                mAdapter.queuePendingMsg(new MsgStartTracking(*this));
                 return;
             }
             LocationError err = LOCATION_ERROR_SUCCESS;
@@ -3013,27 +3552,17 @@ GnssAdapter::startTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t sessi
     if (mTimeBasedTrackingSessions.empty()) {
         /*Reset previous NMEA reported time stamp */
         mPrevNmeaRptTimeNsec = 0;
+        mPrevSvRptTimeNsec = 0;
+        /* GSV left over from the last session is stale */
+        mNmeaEpochBatch.clear();
         startTimeBasedTracking(client, sessionId, options);
         // need to wait for QMI callback
         reportToClientWithNoWait = false;
     } else {
         // find the smallest interval and powerMode
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it = mTimeBasedTrackingSessions.begin(); it != mTimeBasedTrackingSessions.end(); ++it) {
-            // if not set or there is a new smallest interval, then set the new interval
-            if (0 == multiplexedOptions.size ||
-                it->second.minInterval < multiplexedOptions.minInterval) {
-                multiplexedOptions = it->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it->second.powerMode < multiplexedPowerMode) {
-                multiplexedPowerMode = it->second.powerMode;
-            }
-        }
+        TrackingOptions multiplexedOptions;
+        GnssPowerMode multiplexedPowerMode;
+        getMultiplexedTrackingOptions(nullptr, multiplexedOptions, multiplexedPowerMode);
         bool updateOptions = false;
         // if session we are starting has smaller interval then next smallest
         if (options.minInterval < multiplexedOptions.minInterval) {
@@ -3078,6 +3607,8 @@ GnssAdapter::startTimeBasedTracking(LocationAPI* client, uint32_t sessionId,
     // use a local copy of TrackingOptions as the TBF may get modified in the
     // checkAndSetSPEToRunforNHz function
     TrackingOptions tempOptions(trackingOptions);
+    LocationSessionKey key(client, sessionId);
+    mSuspendTrackingThrottled = applySuspendTrackingThrottle(&key, tempOptions);
     if (!checkAndSetSPEToRunforNHz(tempOptions)) {
         mLocApi->startTimeBasedTracking(tempOptions, new LocApiResponse(*getContext(),
                           [this, client, sessionId] (LocationError err) {
@@ -3113,6 +3644,8 @@ GnssAdapter::updateTracking(LocationAPI* client, uint32_t sessionId,
     // use a local copy of TrackingOptions as the TBF may get modified in the
     // checkAndSetSPEToRunforNHz function
     TrackingOptions tempOptions(updatedOptions);
+    LocationSessionKey key(client, sessionId);
+    mSuspendTrackingThrottled = applySuspendTrackingThrottle(&key, tempOptions);
     if(!checkAndSetSPEToRunforNHz(tempOptions)) {
         mLocApi->startTimeBasedTracking(tempOptions, new LocApiResponse(*getContext(),
                           [this, client, sessionId, oldOptions] (LocationError err) {
@@ -3155,7 +3688,7 @@ GnssAdapter::updateTrackingOptionsCommand(LocationAPI* client, uint32_t id,
         inline virtual void proc() const {
             // distance based tracking will need to know engine capabilities before it can start
             if (!mAdapter.isEngineCapabilitiesKnown() && mOptions.minDistance > 0) {
-                mAdapter.mPendingMsgs.push_back(new MsgUpdateTracking(*this));
+                mAdapter.queuePendingMsg(new MsgUpdateTracking(*this));
                 return;
             }
             LocationError err = LOCATION_ERROR_SUCCESS;
@@ -3266,25 +3799,9 @@ GnssAdapter::updateTrackingMultiplex(LocationAPI* client, uint32_t id,
        (it->second.minInterval != trackingOptions.minInterval ||
         it->second.powerMode != trackingOptions.powerMode)) {
         // find the smallest interval and powerMode, other than the session we are updating
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it2 = mTimeBasedTrackingSessions.begin();
-             it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-            // if session is not the one we are updating and either interval
-            // is not set or there is a new smallest interval, then set the new interval
-            if (it2->first != key && (0 == multiplexedOptions.size ||
-                it2->second.minInterval < multiplexedOptions.minInterval)) {
-                 multiplexedOptions = it2->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it2->second.powerMode < multiplexedPowerMode)) {
-                multiplexedPowerMode = it2->second.powerMode;
-            }
-            // else part: no QMI call is made, need to report back to client right away
-        }
+        TrackingOptions multiplexedOptions;
+        GnssPowerMode multiplexedPowerMode;
+        getMultiplexedTrackingOptions(&key, multiplexedOptions, multiplexedPowerMode);
         bool updateOptions = false;
         // if session we are updating has smaller interval then next smallest
         if (trackingOptions.minInterval < multiplexedOptions.minInterval) {
@@ -3381,24 +3898,9 @@ GnssAdapter::stopTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t id)
         auto it = mTimeBasedTrackingSessions.find(key);
         if (it != mTimeBasedTrackingSessions.end()) {
             // find the smallest interval and powerMode, other than the session we are stopping
-            TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-            GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-            memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-            for (auto it2 = mTimeBasedTrackingSessions.begin();
-                 it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-                // if session is not the one we are stopping and either interval
-                // is not set or there is a new smallest interval, then set the new interval
-                if (it2->first != key && (0 == multiplexedOptions.size ||
-                    it2->second.minInterval < multiplexedOptions.minInterval)) {
-                     multiplexedOptions = it2->second;
-                }
-                // if session is not the one we are stopping and either powerMode
-                // is not set or there is a new smallest powerMode, then set the new powerMode
-                if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                    it2->second.powerMode < multiplexedPowerMode)) {
-                    multiplexedPowerMode = it2->second.powerMode;
-                }
-            }
+            TrackingOptions multiplexedOptions;
+            GnssPowerMode multiplexedPowerMode;
+            getMultiplexedTrackingOptions(&key, multiplexedOptions, multiplexedPowerMode);
             // if session we are stopping has smaller interval then next smallest or
             // if session we are stopping has smaller powerMode then next smallest
             if (it->second.minInterval < multiplexedOptions.minInterval ||
@@ -3708,38 +4210,62 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                                  GnssDataNotification* pDataNotify,
                                  int msInWeek)
 {
+    // not from LocApiBase::reportPosition, there is no shared report yet
+    reportPositionReportEvent(std::make_shared<LocPositionReport>(
+                              LocPositionReport{ulpLocation, locationExtended, status}),
+                              techMask, pDataNotify, msInWeek);
+}
+
+void
+GnssAdapter::reportPositionReportEvent(const LocPositionReportPtr& report,
+                                       LocPosTechMask techMask,
+                                       GnssDataNotification* pDataNotify,
+                                       int msInWeek)
+{
+    const UlpLocation& ulpLocation = report->location;
+    const GpsLocationExtended& locationExtended = report->locationExtended;
+    enum loc_sess_status status = report->status;
     // this position is from QMI LOC API, then send report to engine hub
     // also, send out SPE fix promptly to the clients that have registered
     // with SPE report
-    LOC_LOGd("reportPositionEvent, eng type: %d, unpro %d, sess status %d msInWeek %d",
+    loc_util::LocTraceHop traceHop("GnssAdapter::reportPositionEvent");
+    LOC_LOGd_LAZY("reportPositionEvent, eng type: %d, unpro %d, sess status %d msInWeek %d",
              locationExtended.locOutputEngType,
              ulpLocation.unpropagatedPosition, status, msInWeek);
 
     struct MsgReportSPEPosition : public LocMsg {
         GnssAdapter& mAdapter;
-        mutable UlpLocation mUlpLocation;
-        mutable GpsLocationExtended mLocationExtended;
+        // shared with the other adapters and the engine hub,
+        // mUlpLocation / mLocationExtended refer into it
+        const LocPositionReportPtr mReport;
+        const UlpLocation& mUlpLocation;
+        const GpsLocationExtended& mLocationExtended;
         enum loc_sess_status mStatus;
         LocPosTechMask mTechMask;
         mutable GnssDataNotification mDataNotify;
         int mMsInWeek;
+        uint32_t mFixId;
 
         inline MsgReportSPEPosition(GnssAdapter& adapter,
-                                    const UlpLocation& ulpLocation,
-                                    const GpsLocationExtended& locationExtended,
-                                    enum loc_sess_status status,
+                                    const LocPositionReportPtr& report,
                                     LocPosTechMask techMask,
                                     GnssDataNotification dataNotify,
-                                    int msInWeek) :
+                                    int msInWeek,
+                                    uint32_t fixId) :
             LocMsg(),
             mAdapter(adapter),
-            mUlpLocation(ulpLocation),
-            mLocationExtended(locationExtended),
-            mStatus(status),
+            mReport(report),
+            mUlpLocation(mReport->location),
+            mLocationExtended(mReport->locationExtended),
+            mStatus(mReport->status),
             mTechMask(techMask),
             mDataNotify(dataNotify),
-            mMsInWeek(msInWeek) {}
+            mMsInWeek(msInWeek),
+            mFixId(fixId) {}
         inline virtual void proc() const {
+            // last hop of the fix, all client callbacks complete within it
+            loc_util::LocTraceHop traceHop("GnssAdapter::reportPosition", mFixId, true);
+            uint64_t startNs = GnssInitTimings::nowNs();
             if (mAdapter.mTimeBasedTrackingSessions.empty() &&
                 mAdapter.mDistanceBasedTrackingSessions.empty()) {
                 LOC_LOGd("reportPositionEvent, no session on-going, throw away the SPE reports");
@@ -3756,7 +4282,8 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
 
             if (true == mAdapter.initEngHubProxy()){
                 // send the SPE fix to engine hub
-                mAdapter.mEngHubProxy->gnssReportPosition(mUlpLocation, mLocationExtended, mStatus);
+                mAdapter.mEngHubProxy->gnssReportPosition(mUlpLocation, mLocationExtended,
+                                                          mStatus);
                 // report out all SPE fix if it is not propagated, even for failed fix
                 if (false == mUlpLocation.unpropagatedPosition) {
                     EngineLocationInfo engLocationInfo = {};
@@ -3769,6 +4296,9 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                                        engLocationInfo.locationExtended,
                                        mAdapter.mLocConfigInfo.leverArmConfigInfo);
                     mAdapter.reportEnginePositions(1, &engLocationInfo);
+                    if (mAdapter.isHighRateTracking()) {
+                        mAdapter.mHighRateStats.record(startNs);
+                    }
                 }
                 return;
             }
@@ -3787,6 +4317,9 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
             }
 
             mAdapter.reportPosition(mUlpLocation, mLocationExtended, mStatus, mTechMask);
+            if (mAdapter.isHighRateTracking()) {
+                mAdapter.mHighRateStats.record(startNs);
+            }
         }
     };
 
@@ -3796,8 +4329,9 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
             dataNotifyCopy = *pDataNotify;
             dataNotifyCopy.size = sizeof(dataNotifyCopy);
         }
-        sendMsg(new MsgReportSPEPosition(*this, ulpLocation, locationExtended,
-                                          status, techMask, dataNotifyCopy, msInWeek));
+        sendMsg(new MsgReportSPEPosition(*this, report, techMask, dataNotifyCopy, msInWeek,
+                                          traceHop.getFixId()),
+                LOC_MSG_PRIORITY_REALTIME);
     }
 }
 
@@ -3814,12 +4348,18 @@ GnssAdapter::reportEnginePositionsEvent(unsigned int count,
                                         EngineLocationInfo* locationArr) :
             LocMsg(),
             mAdapter(adapter),
-            mCount(count) {
-            if (mCount > LOC_OUTPUT_ENGINE_COUNT) {
-                mCount = LOC_OUTPUT_ENGINE_COUNT;
-            }
-            if (mCount > 0) {
-                memcpy(mEngLocInfo, locationArr, sizeof(EngineLocationInfo)*mCount);
+            mCount(0) {
+            if (count > LOC_OUTPUT_ENGINE_COUNT) {
+                count = LOC_OUTPUT_ENGINE_COUNT;
+            }
+            // only the reports some subscriber takes are copied, besides the fused
+            // one for reportPosition and the first one for the latency stamps
+            uint32_t neededMask = adapter.mEngineLocationsNeededMask.load(
+                    std::memory_order_relaxed) | (1u << LOC_OUTPUT_ENGINE_FUSED);
+            for (unsigned int i = 0; i < count; i++) {
+                if (0 == i || (engineLocationMask(locationArr[i]) & neededMask)) {
+                    memcpy(&mEngLocInfo[mCount++], &locationArr[i], sizeof(EngineLocationInfo));
+                }
             }
         }
         inline virtual void proc() const {
@@ -3827,7 +4367,7 @@ GnssAdapter::reportEnginePositionsEvent(unsigned int count,
         }
     };
 
-    sendMsg(new MsgReportEnginePositions(*this, count, locationArr));
+    sendMsg(new MsgReportEnginePositions(*this, count, locationArr), LOC_MSG_PRIORITY_REALTIME);
 }
 
 bool
@@ -3868,6 +4408,28 @@ GnssAdapter::isFlpClient(LocationCallbacks& locationCallbacks)
             locationCallbacks.gnssMeasurementsCb == nullptr);
 }
 
+bool
+GnssAdapter::isThrottledForScreenOff(uint64_t& lastReportNs)
+{
+    uint32_t intervalMs = ContextBase::mGps_conf.SCREEN_OFF_REPORT_INTERVAL_MS;
+    if (0 == intervalMs || nullptr == mSystemStatus) {
+        return false;
+    }
+    auto screenState = mSystemStatus->getLatest(&SystemStatusReports::mScreenState);
+    if (nullptr == screenState || screenState->mState) {
+        // full rate from the first report after the screen is on, and the
+        // first report after it is off goes out as well
+        lastReportNs = 0;
+        return false;
+    }
+    uint64_t nowNs = GnssInitTimings::nowNs();
+    if (0 != lastReportNs && nowNs - lastReportNs < intervalMs * 1000000ULL) {
+        return true;
+    }
+    lastReportNs = nowNs;
+    return false;
+}
+
 bool GnssAdapter::needToGenerateNmeaReport(const uint32_t &gpsTimeOfWeekMs,
         const struct timespec32_t &apTimeStamp)
 {
@@ -3876,7 +4438,8 @@ bool GnssAdapter::needToGenerateNmeaReport(const uint32_t &gpsTimeOfWeekMs,
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER && !mTimeBasedTrackingSessions.empty()) {
         currentTimeNsec = (apTimeStamp.tv_sec * BILLION_NSEC + apTimeStamp.tv_nsec);
-        if ((GNSS_NMEA_REPORT_RATE_NHZ == ContextBase::sNmeaReportRate) ||
+        if ((GNSS_NMEA_REPORT_RATE_NHZ == ContextBase::sNmeaReportRate &&
+                1 != ContextBase::mGps_conf.HIGH_RATE_DECIMATION_ENABLED) ||
                 (GPS_DEFAULT_FIX_INTERVAL_MS <= mLocPositionMode.min_interval)) {
             retVal = true;
         } else { /*tbf is less than 1000 milli-seconds and NMEA reporting rate is set to 1Hz */
@@ -3901,6 +4464,24 @@ bool GnssAdapter::needToGenerateNmeaReport(const uint32_t &gpsTimeOfWeekMs,
     return retVal;
 }
 
+// Union of the AP generated sentence types someone consumes: every type
+// for NMEA clients and the NMEA log, GGA alone for the DGNSS NTRIP server
+NmeaSentenceTypesMask GnssAdapter::getNmeaGenerationMask()
+{
+    NmeaSentenceTypesMask mask = 0;
+    if (isNMEAPrintEnabled()) {
+        mask = LOC_NMEA_AP_GENERATED_MASK;
+    } else {
+        if (!mNmeaSubscribers.empty()) {
+            mask = LOC_NMEA_AP_GENERATED_MASK;
+        }
+    }
+    if (isDgnssNmeaRequired()) {
+        mask |= LOC_NMEA_MASK_GGA_V02;
+    }
+    return mask;
+}
+
 void
 GnssAdapter::logLatencyInfo()
 {
@@ -3929,7 +4510,7 @@ GnssAdapter::logLatencyInfo()
         std::swap(mGnssLatencyInfoQueue.front().hlosQtimer3,
                   mGnssLatencyInfoQueue.front().hlosQtimer4);
     }
-    LOC_LOGv("meQtimer1=%" PRIi64 " "
+    LOC_LOGv_LAZY("meQtimer1=%" PRIi64 " "
              "meQtimer2=%" PRIi64 " "
              "meQtimer3=%" PRIi64 " "
              "peQtimer1=%" PRIi64 " "
@@ -3953,6 +4534,7 @@ GnssAdapter::logLatencyInfo()
              mGnssLatencyInfoQueue.front().hlosQtimer3, mGnssLatencyInfoQueue.front().hlosQtimer4,
              mGnssLatencyInfoQueue.front().hlosQtimer5);
     mLogger.log(mGnssLatencyInfoQueue.front());
+    mFixLatencyStats.record(mGnssLatencyInfoQueue.front());
     mGnssLatencyInfoQueue.pop();
     LOC_LOGv("mGnssLatencyInfoQueue.size after pop=%zu", mGnssLatencyInfoQueue.size());
 }
@@ -3969,29 +4551,40 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
     bool reportToFlpClient = needReportForFlpClient(status, techMask);
 
     if (reportToGnssClient || reportToFlpClient) {
+        // one conversion per fix, shared by all subscribers. The extended part is
+        // only filled when someone reads it: a GnssLocationInfo or engine locations
+        // subscriber, or the PACE injection below.
+        bool paceEnabled = (true == mLocConfigInfo.paceConfigInfo.isValid) &&
+                (true == mLocConfigInfo.paceConfigInfo.enable);
+        bool needLocationInfo = (reportToFlpClient && mFlpLocationInfoNeeded) ||
+                (reportToGnssClient && (mGnssLocationInfoNeeded ||
+                                        (paceEnabled && (LOC_POS_TECH_MASK_SENSORS & techMask))));
         GnssLocationInfoNotification locationInfo = {};
-        convertLocationInfo(locationInfo, locationExtended, status);
+        if (needLocationInfo) {
+            convertLocationInfo(locationInfo, locationExtended, status);
+        }
         convertLocation(locationInfo.location, ulpLocation, locationExtended);
         logLatencyInfo();
-        for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-            if ((reportToFlpClient && isFlpClient(it->second)) ||
-                    (reportToGnssClient && !isFlpClient(it->second))) {
-                if (nullptr != it->second.gnssLocationInfoCb) {
-                    it->second.gnssLocationInfoCb(locationInfo);
-                } else if ((nullptr != it->second.engineLocationsInfoCb) &&
-                           (false == initEngHubProxy())) {
-                    // if engine hub is disabled, this is SPE fix from modem
-                    // we need to mark one copy marked as fused and one copy marked as PPE
-                    // and dispatch it to the engineLocationsInfoCb
-                    GnssLocationInfoNotification engLocationsInfo[2];
-                    engLocationsInfo[0] = locationInfo;
-                    engLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
-                    engLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
-                    engLocationsInfo[1] = locationInfo;
-                    it->second.engineLocationsInfoCb(2, engLocationsInfo);
-                } else if (nullptr != it->second.trackingCb) {
-                    it->second.trackingCb(locationInfo.location);
-                }
+        const std::vector<LocationCallbacks*>& subscribers =
+                (reportToGnssClient && reportToFlpClient) ? mPositionSubscribers :
+                (reportToGnssClient ? mGnssPositionSubscribers : mFlpPositionSubscribers);
+        bool engHubLoaded = initEngHubProxy();
+        for (auto callbacks : subscribers) {
+            if (nullptr != callbacks->gnssLocationInfoCb) {
+                callbacks->gnssLocationInfoCb(locationInfo);
+            } else if ((nullptr != callbacks->engineLocationsInfoCb) &&
+                       (false == engHubLoaded)) {
+                // if engine hub is disabled, this is SPE fix from modem
+                // we need to mark one copy marked as fused and one copy marked as PPE
+                // and dispatch it to the engineLocationsInfoCb
+                GnssLocationInfoNotification engLocationsInfo[2];
+                engLocationsInfo[0] = locationInfo;
+                engLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
+                engLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
+                engLocationsInfo[1] = locationInfo;
+                callbacks->engineLocationsInfoCb(2, engLocationsInfo);
+            } else if (nullptr != callbacks->trackingCb) {
+                callbacks->trackingCb(locationInfo.location);
             }
         }
 
@@ -4008,8 +4601,7 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
             }
 
             // if PACE is enabled
-            if ((true == mLocConfigInfo.paceConfigInfo.isValid) &&
-                (true == mLocConfigInfo.paceConfigInfo.enable)) {
+            if (paceEnabled) {
                 // If fix has sensor contribution, and it is fused fix with DRE engine
                 // contributing to the fix, inject to modem
                 if ((LOC_POS_TECH_MASK_SENSORS & techMask) &&
@@ -4023,7 +4615,16 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         }
     }
 
-    if (needToGenerateNmeaReport(locationExtended.gpsTime.gpsTimeOfWeekMs,
+    if (reportToGnssClient) {
+        updateLastFixCache(ulpLocation, status);
+        if (LOC_SESS_SUCCESS == status) {
+            mEnergyProfile.addFix();
+        }
+    }
+
+    NmeaSentenceTypesMask nmeaTypesMask = getNmeaGenerationMask();
+    if (0 != nmeaTypesMask &&
+            needToGenerateNmeaReport(locationExtended.gpsTime.gpsTimeOfWeekMs,
             locationExtended.timeStamp.apTimeStamp)) {
         /*Only BlankNMEA sentence needs to be processed and sent, if both lat, long is 0 &
           horReliability is not set. */
@@ -4037,16 +4638,20 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         std::vector<std::string> nmeaArraystr;
         int indexOfGGA = -1;
         loc_nmea_generate_pos(ulpLocation, locationExtended, mLocSystemInfo, generate_nmea,
-                custom_nmea_gga, nmeaArraystr, indexOfGGA, isTagBlockGroupingEnabled);
-        stringstream ss;
+                custom_nmea_gga, nmeaArraystr, indexOfGGA, isTagBlockGroupingEnabled,
+                nmeaTypesMask);
+        // one epoch goes out as one notification, GSV of the epoch first
+        string s;
+        if (1 == ContextBase::mGps_conf.NMEA_EPOCH_BATCHING_ENABLED) {
+            s.swap(mNmeaEpochBatch);
+        }
         for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
+            s += *itor;
         }
-        string s = ss.str();
         reportNmea(s.c_str(), s.length());
 
         /* DgnssNtrip */
-        if (-1 != indexOfGGA && isDgnssNmeaRequired()) {
+        if (-1 != indexOfGGA && isDgnssGgaNeeded()) {
             mDgnssState |= DGNSS_STATE_NO_NMEA_PENDING;
             mStartDgnssNtripParams.nmea = std::move(nmeaArraystr[indexOfGGA]);
             bool isLocationValid = (0 != ulpLocation.gpsLocation.latitude) ||
@@ -4056,6 +4661,49 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
     }
 }
 
+// speed assumed when widening the accuracy of a cached fix by its age
+#define LAST_FIX_CACHE_DRIFT_METERS_PER_SEC (30.0f)
+
+void
+GnssAdapter::updateLastFixCache(const UlpLocation& ulpLocation, enum loc_sess_status status)
+{
+    const LocGpsLocation& fix = ulpLocation.gpsLocation;
+    if (0 == ContextBase::mGps_conf.LAST_FIX_CACHE_MAX_AGE_SEC ||
+            LOC_SESS_SUCCESS != status ||
+            !(fix.flags & LOC_GPS_LOCATION_HAS_LAT_LONG) ||
+            !(fix.flags & LOC_GPS_LOCATION_HAS_ACCURACY) ||
+            (0 == fix.latitude && 0 == fix.longitude) ||
+            fix.timestamp <= 0) {
+        return;
+    }
+    if (mLastFixCache.open()) {
+        mLastFixCache.update(fix.latitude, fix.longitude, fix.accuracy, fix.timestamp);
+    }
+}
+
+void
+GnssAdapter::injectCachedLastFix()
+{
+    uint32_t maxAgeSec = ContextBase::mGps_conf.LAST_FIX_CACHE_MAX_AGE_SEC;
+    if (0 == maxAgeSec || !mLastFixCache.open()) {
+        return;
+    }
+    struct timespec ts = {};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int64_t nowMs = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+    double latitude = 0;
+    double longitude = 0;
+    float accuracy = 0;
+    int64_t utcTimeMs = 0;
+    if (mLastFixCache.get(nowMs, maxAgeSec, latitude, longitude, accuracy, utcTimeMs)) {
+        float ageSec = (nowMs - utcTimeMs) / 1000.0f;
+        accuracy += ageSec * LAST_FIX_CACHE_DRIFT_METERS_PER_SEC;
+        LOC_LOGi("injecting cached fix, age %.1f s, accuracy %.0f m", ageSec, accuracy);
+        mLocApi->injectPosition(latitude, longitude, accuracy, false);
+    }
+}
+
 void
 GnssAdapter::reportLatencyInfoEvent(const GnssLatencyInfo& gnssLatencyInfo)
 {
@@ -4072,22 +4720,24 @@ GnssAdapter::reportLatencyInfoEvent(const GnssLatencyInfo& gnssLatencyInfo)
                       mAdapter.mGnssLatencyInfoQueue.size());
         }
     };
-    sendMsg(new MsgReportLatencyInfo(*this, gnssLatencyInfo));
+    sendMsg(new MsgReportLatencyInfo(*this, gnssLatencyInfo), LOC_MSG_PRIORITY_HOUSEKEEPING);
 }
 
 void
 GnssAdapter::reportEnginePositions(unsigned int count,
                                    const EngineLocationInfo* locationArr)
 {
-    bool needReportEnginePositions = false;
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.engineLocationsInfoCb) {
-            needReportEnginePositions = true;
-            break;
-        }
-    }
+    bool needReportEnginePositions = !mEngineLocationsSubscribers.empty();
+    uint32_t neededMask = mEngineLocationsNeededMask.load(std::memory_order_relaxed);
 
+    // each report some subscriber takes is converted once, for all of them
     GnssLocationInfoNotification locationInfo[LOC_OUTPUT_ENGINE_COUNT] = {};
+    uint32_t locationInfoMasks[LOC_OUTPUT_ENGINE_COUNT] = {};
+    unsigned int convertedCount = 0;
+    uint32_t convertedMask = 0;
+    if (count > LOC_OUTPUT_ENGINE_COUNT) {
+        count = LOC_OUTPUT_ENGINE_COUNT;
+    }
     for (unsigned int i = 0; i < count; i++) {
         const EngineLocationInfo* engLocation = (locationArr+i);
         // if it is fused/default location, call reportPosition maintain legacy behavior
@@ -4099,12 +4749,15 @@ GnssAdapter::reportEnginePositions(unsigned int count,
                            engLocation->location.tech_mask);
         }
 
-        if (needReportEnginePositions) {
-            convertLocationInfo(locationInfo[i], engLocation->locationExtended,
+        uint32_t engineMask = engineLocationMask(*engLocation);
+        if (needReportEnginePositions && (engineMask & neededMask)) {
+            convertLocationInfo(locationInfo[convertedCount], engLocation->locationExtended,
                                 engLocation->sessionStatus);
-            convertLocation(locationInfo[i].location,
+            convertLocation(locationInfo[convertedCount].location,
                             engLocation->location,
                             engLocation->locationExtended);
+            locationInfoMasks[convertedCount++] = engineMask;
+            convertedMask |= engineMask;
         }
     }
 
@@ -4124,10 +4777,22 @@ GnssAdapter::reportEnginePositions(unsigned int count,
             LOC_LOGv("PPE hlosQtimer4=%" PRIi64 " ", mGnssLatencyInfoQueue.front().hlosQtimer4);
         }
     }
-    if (needReportEnginePositions) {
-        for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-            if (nullptr != it->second.engineLocationsInfoCb) {
-                it->second.engineLocationsInfoCb(count, locationInfo);
+    if (needReportEnginePositions && convertedCount > 0) {
+        for (auto& subscriber : mEngineLocationsSubscribers) {
+            if ((subscriber.engineMask & convertedMask) == convertedMask) {
+                // takes every converted report, handed the shared array as is
+                subscriber.callbacks->engineLocationsInfoCb(convertedCount, locationInfo);
+                continue;
+            }
+            GnssLocationInfoNotification clientInfo[LOC_OUTPUT_ENGINE_COUNT];
+            unsigned int clientCount = 0;
+            for (unsigned int i = 0; i < convertedCount; i++) {
+                if (subscriber.engineMask & locationInfoMasks[i]) {
+                    clientInfo[clientCount++] = locationInfo[i];
+                }
+            }
+            if (clientCount > 0) {
+                subscriber.callbacks->engineLocationsInfoCb(clientCount, clientInfo);
             }
         }
     }
@@ -4157,12 +4822,31 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         }
     };
 
-    sendMsg(new MsgReportSv(*this, svNotify));
+    // a report still queued is stale now, only the newest one is handled
+    sendConflatedMsg(mSvReportSlot, new MsgReportSv(*this, svNotify), LOC_MSG_PRIORITY_REALTIME);
 }
 
 void
 GnssAdapter::reportSv(GnssSvNotification& svNotify)
 {
+    if (1 == ContextBase::mGps_conf.HIGH_RATE_DECIMATION_ENABLED && isHighRateTracking()) {
+        uint64_t nowNs = GnssInitTimings::nowNs();
+        if (0 != mPrevSvRptTimeNsec &&
+                nowNs - mPrevSvRptTimeNsec < NMEA_MAX_THRESHOLD_MSEC * 1000000ULL) {
+            mHighRateStats.countDecimatedSv();
+            mGnssSvIdUsedInPosAvail = false;
+            mGnssMbSvIdUsedInPosAvail = false;
+            return;
+        }
+        mPrevSvRptTimeNsec = nowNs;
+    }
+    if (isThrottledForScreenOff(mScreenOffSvRptNs)) {
+        mScreenOffDroppedSv.fetch_add(1, std::memory_order_relaxed);
+        mGnssSvIdUsedInPosAvail = false;
+        mGnssMbSvIdUsedInPosAvail = false;
+        return;
+    }
+
     int numSv = svNotify.count;
     uint16_t gnssSvId = 0;
     uint64_t svUsedIdMask = 0;
@@ -4299,22 +4983,31 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
         }
     }
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssSvCb) {
-            it->second.gnssSvCb(svNotify);
-        }
+    for (auto callbacks : mSvSubscribers) {
+        callbacks->gnssSvCb(svNotify);
     }
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
-        !mTimeBasedTrackingSessions.empty()) {
+        !mTimeBasedTrackingSessions.empty() &&
+        (getNmeaGenerationMask() & LOC_NMEA_MASK_GSV_V02)) {
         std::vector<std::string> nmeaArraystr;
         loc_nmea_generate_sv(svNotify, nmeaArraystr);
-        stringstream ss;
+        bool batching = (1 == ContextBase::mGps_conf.NMEA_EPOCH_BATCHING_ENABLED);
+        if (batching && !mNmeaEpochBatch.empty()) {
+            // the previous epoch had no position NMEA to go with
+            reportNmea(mNmeaEpochBatch.c_str(), mNmeaEpochBatch.length());
+            mNmeaEpochBatch.clear();
+        }
+        string s;
         for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
+            s += *itor;
+        }
+        if (batching) {
+            // held until the position report of this epoch
+            mNmeaEpochBatch.swap(s);
+        } else {
+            reportNmea(s.c_str(), s.length());
         }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
     }
 
     mGnssSvIdUsedInPosAvail = false;
@@ -4366,7 +5059,7 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
         }
     };
 
-    sendMsg(new MsgReportNmea(*this, nmea, length));
+    sendMsg(new MsgReportNmea(*this, nmea, length), LOC_MSG_PRIORITY_REALTIME);
 }
 
 void
@@ -4382,10 +5075,8 @@ GnssAdapter::reportNmea(const char* nmea, size_t length)
     nmeaNotification.nmea = nmea;
     nmeaNotification.length = length;
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssNmeaCb) {
-            it->second.gnssNmeaCb(nmeaNotification);
-        }
+    for (auto callbacks : mNmeaSubscribers) {
+        callbacks->gnssNmeaCb(nmeaNotification);
     }
 
     if (isNMEAPrintEnabled()) {
@@ -4418,12 +5109,17 @@ GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
         }
     };
 
-    sendMsg(new MsgReportData(*this, dataNotify, msInWeek));
+    sendConflatedMsg(mDataReportSlot, new MsgReportData(*this, dataNotify, msInWeek),
+                     LOC_MSG_PRIORITY_REALTIME);
 }
 
 void
 GnssAdapter::reportData(GnssDataNotification& dataNotify)
 {
+    if (isThrottledForScreenOff(mScreenOffDataRptNs)) {
+        mScreenOffDroppedData.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
     for (int sig = 0; sig < GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES; sig++) {
         if (GNSS_LOC_DATA_JAMMER_IND_BIT ==
             (dataNotify.gnssDataMask[sig] & GNSS_LOC_DATA_JAMMER_IND_BIT)) {
@@ -4434,10 +5130,8 @@ GnssAdapter::reportData(GnssDataNotification& dataNotify)
             LOC_LOGv("agc[%d]=%f", sig, dataNotify.agc[sig]);
         }
     }
-    for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssDataCb) {
-            it->second.gnssDataCb(dataNotify);
-        }
+    for (auto callbacks : mDataSubscribers) {
+        callbacks->gnssDataCb(dataNotify);
     }
 }
 
@@ -4729,7 +5423,6 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
     if (0 != gnssMeasurements.gnssMeasNotification.count) {
         struct MsgReportGnssMeasurementData : public LocMsg {
             GnssAdapter& mAdapter;
-            GnssMeasurements mGnssMeasurements;
             GnssMeasurementsNotification mMeasurementsNotify;
             inline MsgReportGnssMeasurementData(GnssAdapter& adapter,
                                                 const GnssMeasurements& gnssMeasurements,
@@ -4746,7 +5439,8 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
             }
         };
 
-        sendMsg(new MsgReportGnssMeasurementData(*this, gnssMeasurements, msInWeek));
+        sendMsg(new MsgReportGnssMeasurementData(*this, gnssMeasurements, msInWeek),
+                LOC_MSG_PRIORITY_REALTIME);
     }
     mEngHubProxy->gnssReportSvMeasurement(gnssMeasurements.gnssSvMeasurementSet);
     if (mDGnssNeedReport) {
@@ -4757,10 +5451,21 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
 void
 GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measurements)
 {
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssMeasurementsCb) {
-            it->second.gnssMeasurementsCb(measurements);
+    uint64_t nowNs = GnssInitTimings::nowNs();
+    for (auto& subscriber : mMeasurementsSubscribers) {
+        if (subscriber.minIntervalMs > MEASUREMENTS_DECIMATION_MIN_INTERVAL_MS) {
+            // skipped before the callback copies and converts the epoch. nextDueNs
+            // advances by the interval, not from now, so jittery epochs still average
+            // out to the requested rate; an epoch up to a tenth early is taken.
+            uint64_t intervalNs = subscriber.minIntervalMs * 1000000ULL;
+            if (0 != subscriber.nextDueNs && nowNs + intervalNs / 10 < subscriber.nextDueNs) {
+                continue;
+            }
+            subscriber.nextDueNs = (0 != subscriber.nextDueNs &&
+                                    nowNs < subscriber.nextDueNs + intervalNs) ?
+                    subscriber.nextDueNs + intervalNs : nowNs + intervalNs;
         }
+        subscriber.callbacks->gnssMeasurementsCb(measurements);
     }
 }
 
@@ -4788,14 +5493,15 @@ GnssAdapter::reportDGnssDataUsable(const GnssSvMeasurementSet &svMeasurementSet)
 void
 GnssAdapter::reportSvPolynomialEvent(GnssSvPolynomial &svPolynomial)
 {
-    LOC_LOGD("%s]: ", __func__);
+    // one of these per SV update, keep the log out of the default level
+    LOC_LOGv("sv %u", svPolynomial.gnssSvId);
     mEngHubProxy->gnssReportSvPolynomial(svPolynomial);
 }
 
 void
 GnssAdapter::reportSvEphemerisEvent(GnssSvEphemerisReport & svEphemeris)
 {
-    LOC_LOGD("%s]:", __func__);
+    LOC_LOGv("gnssConstellation %d", svEphemeris.gnssConstellation);
     mEngHubProxy->gnssReportSvEphemeris(svEphemeris);
 }
 
@@ -4831,7 +5537,12 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
         // extending the odcpi session past 30 seconds if needed
         if (ODCPI_REQUEST_TYPE_START == request.type) {
             if (false == mOdcpiRequestActive && false == mOdcpiTimer.isActive()) {
-                mOdcpiRequestCb(request);
+                // a fresh enough cached location keeps the framework request
+                // off the critical path, it only goes out if the engine is
+                // still asking when the timer expires
+                if (!injectCachedOdcpi() || request.isEmergencyMode) {
+                    sendOdcpiRequest(request);
+                }
                 mOdcpiRequestActive = true;
                 mOdcpiTimer.start();
             // if the current active odcpi session is non-emergency, and the new
@@ -4839,7 +5550,7 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
             // and restart the timer
             } else if (false == mOdcpiRequest.isEmergencyMode &&
                        true == request.isEmergencyMode) {
-                mOdcpiRequestCb(request);
+                sendOdcpiRequest(request);
                 mOdcpiRequestActive = true;
                 if (true == mOdcpiTimer.isActive()) {
                     mOdcpiTimer.restart();
@@ -4851,6 +5562,8 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
             // before requesting new ODCPI to avoid spamming ODCPI requests
             } else if (false == mOdcpiRequestActive && true == mOdcpiTimer.isActive()) {
                 mOdcpiRequestActive = true;
+            } else {
+                LOC_LOGd("coalesced into the in-flight ODCPI request");
             }
             mOdcpiRequest = request;
         // the request is being stopped, but allow timer to expire first
@@ -4858,7 +5571,10 @@ void GnssAdapter::requestOdcpi(const OdcpiRequestInfo& request)
         // to avoid spamming more odcpi requests to the framework
         } else if (ODCPI_REQUEST_TYPE_STOP == request.type) {
             LOC_LOGd("request: type %d, isEmergency %d", request.type, request.isEmergencyMode);
-            mOdcpiRequestCb(request);
+            // nothing to stop if only the cached location was injected
+            if (mOdcpiFrameworkStarted) {
+                sendOdcpiRequest(request);
+            }
             mOdcpiRequestActive = false;
         } else {
             LOC_LOGE("Invalid ODCPI request type..");
@@ -4974,6 +5690,35 @@ void GnssAdapter::injectOdcpi(const Location& location)
             location.latitude, location.longitude);
 
     mLocApi->injectPosition(location, true);
+
+    mOdcpiLastLocation = location;
+    mOdcpiLastLocationBootTimeMilli = getBootTimeMilliSec();
+}
+
+void GnssAdapter::sendOdcpiRequest(const OdcpiRequestInfo& request)
+{
+    mOdcpiRequestCb(request);
+    mOdcpiFrameworkStarted = (ODCPI_REQUEST_TYPE_START == request.type);
+}
+
+// Injects the last ODCPI location again if it is not older than
+// ODCPI_CACHED_LOCATION_MAX_AGE_SEC, returns whether it did
+bool GnssAdapter::injectCachedOdcpi()
+{
+    uint64_t maxAgeMilli =
+            ContextBase::mGps_conf.ODCPI_CACHED_LOCATION_MAX_AGE_SEC * 1000ULL;
+    if (0 == maxAgeMilli || 0 == mOdcpiLastLocationBootTimeMilli) {
+        return false;
+    }
+
+    uint64_t ageMilli = getBootTimeMilliSec() - mOdcpiLastLocationBootTimeMilli;
+    if (ageMilli > maxAgeMilli) {
+        return false;
+    }
+
+    LOC_LOGd("injecting cached ODCPI location, age %" PRIu64 " ms", ageMilli);
+    mLocApi->injectPosition(mOdcpiLastLocation, true);
+    return true;
 }
 
 // Called in the context of LocTimer thread
@@ -5006,7 +5751,7 @@ void GnssAdapter::odcpiTimerExpire()
     // if ODCPI request is still active after timer
     // expires, request again and restart timer
     if (mOdcpiRequestActive) {
-        mOdcpiRequestCb(mOdcpiRequest);
+        sendOdcpiRequest(mOdcpiRequest);
         mOdcpiTimer.restart();
     } else {
         mOdcpiTimer.stop();
@@ -5034,11 +5779,16 @@ GnssAdapter::reportGnssEngEnergyConsumedEvent(uint64_t energyConsumedSinceFirstB
                 mAdapter(adapter),
                 mGnssEnergyConsumedSinceFirstBoot(energyConsumed) {}
         inline virtual void proc() const {
+            if (0 != ContextBase::mGps_conf.GNSS_ENERGY_PROFILE_ENABLED &&
+                    UINT64_MAX != mGnssEnergyConsumedSinceFirstBoot) {
+                mAdapter.mEnergyProfile.addSample(mGnssEnergyConsumedSinceFirstBoot);
+            }
             mAdapter.invokeGnssEnergyConsumedCallback(mGnssEnergyConsumedSinceFirstBoot);
         }
     };
 
-    sendMsg(new MsgReportGnssGnssEngEnergyConsumed(*this, energyConsumedSinceFirstBoot));
+    sendMsg(new MsgReportGnssGnssEngEnergyConsumed(*this, energyConsumedSinceFirstBoot),
+            LOC_MSG_PRIORITY_HOUSEKEEPING);
     return true;
 }
 
@@ -5077,7 +5827,9 @@ void GnssAdapter::initDefaultAgpsCommand() {
             mAdapter(adapter) {
             }
         inline virtual void proc() const {
+            uint64_t startNs = GnssInitTimings::nowNs();
             mAdapter.initDefaultAgps();
+            mAdapter.mInitTimings.record(GNSS_INIT_STEP_DEFAULT_AGPS, startNs);
         }
     };
 
@@ -5098,6 +5850,37 @@ void GnssAdapter::initAgps(const AgpsCbInfo& cbInfo) {
     /* Register for AGPS event mask */
     updateEvtMask(LOC_API_ADAPTER_BIT_LOCATION_SERVER_REQUEST,
             LOC_REGISTRATION_MASK_ENABLED);
+    updateAgpsPrewarm();
+}
+
+void GnssAdapter::updateAgpsPrewarm() {
+
+    bool prewarm = false;
+    uint32_t mode = ContextBase::mGps_conf.AGPS_PREWARM_MODE;
+
+    if (0 != mode && mAgpsManager.isRegistered() &&
+            (2 == mode || mPowerOn)) {
+        /* only worth it, and only likely to succeed, on mobile data */
+        auto networkInfo = mSystemStatus->getLatest(&SystemStatusReports::mNetworkInfo);
+        uint64_t mobileBit = (uint64_t)1 << loc_core::TYPE_MOBILE;
+        prewarm = (nullptr != networkInfo &&
+                (networkInfo->mAllTypes & mobileBit) == mobileBit);
+    }
+    mAgpsManager.setPrewarm(prewarm);
+}
+
+void GnssAdapter::updateAgpsPrewarmCommand() {
+
+    struct MsgUpdateAgpsPrewarm : public LocMsg {
+        GnssAdapter& mAdapter;
+        inline MsgUpdateAgpsPrewarm(GnssAdapter& adapter) :
+                LocMsg(), mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.updateAgpsPrewarm();
+        }
+    };
+
+    sendMsg(new MsgUpdateAgpsPrewarm(*this));
 }
 
 void GnssAdapter::initAgpsCommand(const AgpsCbInfo& cbInfo){
@@ -5374,7 +6157,9 @@ void GnssAdapter::dataConnFailedCommand(AGpsExtType agpsType){
 
 void GnssAdapter::convertSatelliteInfo(std::vector<GnssDebugSatelliteInfo>& out,
                                        const GnssSvType& in_constellation,
-                                       const SystemStatusReports& in)
+                                       const SystemStatusSvHealth* svHealth,
+                                       const SystemStatusXtra* xtra,
+                                       const SystemStatusNavData* navData)
 {
     uint64_t sv_mask = 0ULL;
     uint32_t svid_min = 0;
@@ -5392,78 +6177,78 @@ void GnssAdapter::convertSatelliteInfo(std::vector<GnssDebugSatelliteInfo>& out,
             svid_min = GNSS_BUGREPORT_GPS_MIN;
             svid_num = GPS_NUM;
             svid_idx = 0;
-            if (!in.mSvHealth.empty()) {
-                eph_health_good_mask = in.mSvHealth.back().mGpsGoodMask;
-                eph_health_bad_mask  = in.mSvHealth.back().mGpsBadMask;
+            if (nullptr != svHealth) {
+                eph_health_good_mask = svHealth->mGpsGoodMask;
+                eph_health_bad_mask  = svHealth->mGpsBadMask;
             }
-            if (!in.mXtra.empty()) {
-                server_perdiction_available_mask = in.mXtra.back().mGpsXtraValid;
-                server_perdiction_age = (float)(in.mXtra.back().mGpsXtraAge);
+            if (nullptr != xtra) {
+                server_perdiction_available_mask = xtra->mGpsXtraValid;
+                server_perdiction_age = (float)(xtra->mGpsXtraAge);
             }
             break;
         case GNSS_SV_TYPE_GLONASS:
             svid_min = GNSS_BUGREPORT_GLO_MIN;
             svid_num = GLO_NUM;
             svid_idx = GPS_NUM;
-            if (!in.mSvHealth.empty()) {
-                eph_health_good_mask = in.mSvHealth.back().mGloGoodMask;
-                eph_health_bad_mask  = in.mSvHealth.back().mGloBadMask;
+            if (nullptr != svHealth) {
+                eph_health_good_mask = svHealth->mGloGoodMask;
+                eph_health_bad_mask  = svHealth->mGloBadMask;
             }
-            if (!in.mXtra.empty()) {
-                server_perdiction_available_mask = in.mXtra.back().mGloXtraValid;
-                server_perdiction_age = (float)(in.mXtra.back().mGloXtraAge);
+            if (nullptr != xtra) {
+                server_perdiction_available_mask = xtra->mGloXtraValid;
+                server_perdiction_age = (float)(xtra->mGloXtraAge);
             }
             break;
         case GNSS_SV_TYPE_QZSS:
             svid_min = GNSS_BUGREPORT_QZSS_MIN;
             svid_num = QZSS_NUM;
             svid_idx = GPS_NUM+GLO_NUM+BDS_NUM+GAL_NUM;
-            if (!in.mSvHealth.empty()) {
-                eph_health_good_mask = in.mSvHealth.back().mQzssGoodMask;
-                eph_health_bad_mask  = in.mSvHealth.back().mQzssBadMask;
+            if (nullptr != svHealth) {
+                eph_health_good_mask = svHealth->mQzssGoodMask;
+                eph_health_bad_mask  = svHealth->mQzssBadMask;
             }
-            if (!in.mXtra.empty()) {
-                server_perdiction_available_mask = in.mXtra.back().mQzssXtraValid;
-                server_perdiction_age = (float)(in.mXtra.back().mQzssXtraAge);
+            if (nullptr != xtra) {
+                server_perdiction_available_mask = xtra->mQzssXtraValid;
+                server_perdiction_age = (float)(xtra->mQzssXtraAge);
             }
             break;
         case GNSS_SV_TYPE_BEIDOU:
             svid_min = GNSS_BUGREPORT_BDS_MIN;
             svid_num = BDS_NUM;
             svid_idx = GPS_NUM+GLO_NUM;
-            if (!in.mSvHealth.empty()) {
-                eph_health_good_mask = in.mSvHealth.back().mBdsGoodMask;
-                eph_health_bad_mask  = in.mSvHealth.back().mBdsBadMask;
+            if (nullptr != svHealth) {
+                eph_health_good_mask = svHealth->mBdsGoodMask;
+                eph_health_bad_mask  = svHealth->mBdsBadMask;
             }
-            if (!in.mXtra.empty()) {
-                server_perdiction_available_mask = in.mXtra.back().mBdsXtraValid;
-                server_perdiction_age = (float)(in.mXtra.back().mBdsXtraAge);
+            if (nullptr != xtra) {
+                server_perdiction_available_mask = xtra->mBdsXtraValid;
+                server_perdiction_age = (float)(xtra->mBdsXtraAge);
             }
             break;
         case GNSS_SV_TYPE_GALILEO:
             svid_min = GNSS_BUGREPORT_GAL_MIN;
             svid_num = GAL_NUM;
             svid_idx = GPS_NUM+GLO_NUM+BDS_NUM;
-            if (!in.mSvHealth.empty()) {
-                eph_health_good_mask = in.mSvHealth.back().mGalGoodMask;
-                eph_health_bad_mask  = in.mSvHealth.back().mGalBadMask;
+            if (nullptr != svHealth) {
+                eph_health_good_mask = svHealth->mGalGoodMask;
+                eph_health_bad_mask  = svHealth->mGalBadMask;
             }
-            if (!in.mXtra.empty()) {
-                server_perdiction_available_mask = in.mXtra.back().mGalXtraValid;
-                server_perdiction_age = (float)(in.mXtra.back().mGalXtraAge);
+            if (nullptr != xtra) {
+                server_perdiction_available_mask = xtra->mGalXtraValid;
+                server_perdiction_age = (float)(xtra->mGalXtraAge);
             }
             break;
         case GNSS_SV_TYPE_NAVIC:
             svid_min = GNSS_BUGREPORT_NAVIC_MIN;
             svid_num = NAVIC_NUM;
             svid_idx = GPS_NUM+GLO_NUM+QZSS_NUM+BDS_NUM+GAL_NUM;
-            if (!in.mSvHealth.empty()) {
-                eph_health_good_mask = in.mSvHealth.back().mNavicGoodMask;
-                eph_health_bad_mask  = in.mSvHealth.back().mNavicBadMask;
+            if (nullptr != svHealth) {
+                eph_health_good_mask = svHealth->mNavicGoodMask;
+                eph_health_bad_mask  = svHealth->mNavicBadMask;
             }
-            if (!in.mXtra.empty()) {
-                server_perdiction_available_mask = in.mXtra.back().mNavicXtraValid;
-                server_perdiction_age = (float)(in.mXtra.back().mNavicXtraAge);
+            if (nullptr != xtra) {
+                server_perdiction_available_mask = xtra->mNavicXtraValid;
+                server_perdiction_age = (float)(xtra->mNavicXtraAge);
             }
             break;
         default:
@@ -5478,9 +6263,9 @@ void GnssAdapter::convertSatelliteInfo(std::vector<GnssDebugSatelliteInfo>& out,
         s.svid = i + svid_min;
         s.constellation = in_constellation;
 
-        if (!in.mNavData.empty()) {
-            s.mEphemerisType   = in.mNavData.back().mNav[svid_idx+i].mType;
-            s.mEphemerisSource = in.mNavData.back().mNav[svid_idx+i].mSource;
+        if (nullptr != navData) {
+            s.mEphemerisType   = navData->mNav[svid_idx+i].mType;
+            s.mEphemerisSource = navData->mNav[svid_idx+i].mSource;
         }
         else {
             s.mEphemerisType   = GNSS_EPH_TYPE_UNKNOWN;
@@ -5498,9 +6283,9 @@ void GnssAdapter::convertSatelliteInfo(std::vector<GnssDebugSatelliteInfo>& out,
             s.mEphemerisHealth = GNSS_EPH_HEALTH_UNKNOWN;
         }
 
-        if (!in.mNavData.empty()) {
+        if (nullptr != navData) {
             s.ephemerisAgeSeconds =
-                (float)(in.mNavData.back().mNav[svid_idx+i].mAgeSec);
+                (float)(navData->mNav[svid_idx+i].mAgeSec);
         }
         else {
             s.ephemerisAgeSeconds = 0.0f;
@@ -5529,49 +6314,54 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
         return false;
     }
 
-    SystemStatusReports reports = {};
-    systemstatus->getReport(reports, true);
+    // lock free snapshots, the NMEA and position ingest is never blocked on them
+    auto location = systemstatus->getLatest(&SystemStatusReports::mLocation);
+    auto bestPosition = systemstatus->getLatest(&SystemStatusReports::mBestPosition);
+    auto timeAndClock = systemstatus->getLatest(&SystemStatusReports::mTimeAndClock);
+    auto svHealth = systemstatus->getLatest(&SystemStatusReports::mSvHealth);
+    auto xtra = systemstatus->getLatest(&SystemStatusReports::mXtra);
+    auto navData = systemstatus->getLatest(&SystemStatusReports::mNavData);
 
     r.size = sizeof(r);
 
     // location block
     r.mLocation.size = sizeof(r.mLocation);
-    if(!reports.mLocation.empty() && reports.mLocation.back().mValid) {
+    if(nullptr != location && location->mValid) {
         r.mLocation.mValid = true;
         r.mLocation.mLocation.latitude =
-            reports.mLocation.back().mLocation.gpsLocation.latitude;
+            location->mLocation.gpsLocation.latitude;
         r.mLocation.mLocation.longitude =
-            reports.mLocation.back().mLocation.gpsLocation.longitude;
+            location->mLocation.gpsLocation.longitude;
         r.mLocation.mLocation.altitude =
-            reports.mLocation.back().mLocation.gpsLocation.altitude;
+            location->mLocation.gpsLocation.altitude;
         r.mLocation.mLocation.speed =
-            (double)(reports.mLocation.back().mLocation.gpsLocation.speed);
+            (double)(location->mLocation.gpsLocation.speed);
         r.mLocation.mLocation.bearing =
-            (double)(reports.mLocation.back().mLocation.gpsLocation.bearing);
+            (double)(location->mLocation.gpsLocation.bearing);
         r.mLocation.mLocation.accuracy =
-            (double)(reports.mLocation.back().mLocation.gpsLocation.accuracy);
+            (double)(location->mLocation.gpsLocation.accuracy);
 
         r.mLocation.verticalAccuracyMeters =
-            reports.mLocation.back().mLocationEx.vert_unc;
+            location->mLocationEx.vert_unc;
         r.mLocation.speedAccuracyMetersPerSecond =
-            reports.mLocation.back().mLocationEx.speed_unc;
+            location->mLocationEx.speed_unc;
         r.mLocation.bearingAccuracyDegrees =
-            reports.mLocation.back().mLocationEx.bearing_unc;
+            location->mLocationEx.bearing_unc;
 
         r.mLocation.mUtcReported =
-            reports.mLocation.back().mUtcReported;
+            location->mUtcReported;
     }
-    else if(!reports.mBestPosition.empty() && reports.mBestPosition.back().mValid) {
+    else if(nullptr != bestPosition && bestPosition->mValid) {
         r.mLocation.mValid = true;
         r.mLocation.mLocation.latitude =
-                (double)(reports.mBestPosition.back().mBestLat) * RAD2DEG;
+                (double)(bestPosition->mBestLat) * RAD2DEG;
         r.mLocation.mLocation.longitude =
-                (double)(reports.mBestPosition.back().mBestLon) * RAD2DEG;
-        r.mLocation.mLocation.altitude = reports.mBestPosition.back().mBestAlt;
+                (double)(bestPosition->mBestLon) * RAD2DEG;
+        r.mLocation.mLocation.altitude = bestPosition->mBestAlt;
         r.mLocation.mLocation.accuracy =
-                (double)(reports.mBestPosition.back().mBestHepe);
+                (double)(bestPosition->mBestHepe);
 
-        r.mLocation.mUtcReported = reports.mBestPosition.back().mUtcReported;
+        r.mLocation.mUtcReported = bestPosition->mUtcReported;
     }
     else {
         r.mLocation.mValid = false;
@@ -5587,28 +6377,28 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
 
     // time block
     r.mTime.size = sizeof(r.mTime);
-    if(!reports.mTimeAndClock.empty() && reports.mTimeAndClock.back().mTimeValid) {
+    if(nullptr != timeAndClock && timeAndClock->mTimeValid) {
         r.mTime.mValid = true;
         r.mTime.timeEstimate =
-            (((int64_t)(reports.mTimeAndClock.back().mGpsWeek)*7 +
+            (((int64_t)(timeAndClock->mGpsWeek)*7 +
                         GNSS_UTC_TIME_OFFSET)*24*60*60 -
-              (int64_t)(reports.mTimeAndClock.back().mLeapSeconds))*1000ULL +
-              (int64_t)(reports.mTimeAndClock.back().mGpsTowMs);
+              (int64_t)(timeAndClock->mLeapSeconds))*1000ULL +
+              (int64_t)(timeAndClock->mGpsTowMs);
 
-        if (reports.mTimeAndClock.back().mTimeUncNs > 0) {
+        if (timeAndClock->mTimeUncNs > 0) {
             // TimeUncNs value is available
             r.mTime.timeUncertaintyNs =
-                    (float)(reports.mTimeAndClock.back().mLeapSecUnc)*1000.0f +
-                    (float)(reports.mTimeAndClock.back().mTimeUncNs);
+                    (float)(timeAndClock->mLeapSecUnc)*1000.0f +
+                    (float)(timeAndClock->mTimeUncNs);
         } else {
             // fall back to legacy TimeUnc
             r.mTime.timeUncertaintyNs =
-                    ((float)(reports.mTimeAndClock.back().mTimeUnc) +
-                     (float)(reports.mTimeAndClock.back().mLeapSecUnc))*1000.0f;
+                    ((float)(timeAndClock->mTimeUnc) +
+                     (float)(timeAndClock->mLeapSecUnc))*1000.0f;
         }
 
         r.mTime.frequencyUncertaintyNsPerSec =
-            (float)(reports.mTimeAndClock.back().mClockFreqBiasUnc);
+            (float)(timeAndClock->mClockFreqBiasUnc);
         LOC_LOGV("getDebugReport - timeestimate=%" PRIu64 " unc=%f frequnc=%f",
                 r.mTime.timeEstimate,
                 r.mTime.timeUncertaintyNs, r.mTime.frequencyUncertaintyNsPerSec);
@@ -5618,17 +6408,23 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     }
 
     // satellite info block
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GPS, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GLONASS, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_QZSS, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_BEIDOU, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GALILEO, reports);
-    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_NAVIC, reports);
+    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GPS, svHealth.get(), xtra.get(), navData.get());
+    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GLONASS, svHealth.get(), xtra.get(), navData.get());
+    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_QZSS, svHealth.get(), xtra.get(), navData.get());
+    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_BEIDOU, svHealth.get(), xtra.get(), navData.get());
+    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GALILEO, svHealth.get(), xtra.get(), navData.get());
+    convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_NAVIC, svHealth.get(), xtra.get(), navData.get());
     LOC_LOGV("getDebugReport - satellite=%zu", r.mSatelliteInfo.size());
 
     return true;
 }
 
+uint64_t GnssAdapter::getDebugReportGeneration()
+{
+    SystemStatus* systemstatus = getSystemStatus();
+    return (nullptr == systemstatus) ? 0 : systemstatus->getGeneration();
+}
+
 /* get AGC information from system status and fill it */
 void
 GnssAdapter::getAgcInformation(GnssMeasurementsNotification& measurements, int msInWeek)
@@ -5636,39 +6432,39 @@ GnssAdapter::getAgcInformation(GnssMeasurementsNotification& measurements, int m
     SystemStatus* systemstatus = getSystemStatus();
 
     if (nullptr != systemstatus) {
-        SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
+        auto rfAndParams = systemstatus->getLatest(&SystemStatusReports::mRfAndParams);
+        auto timeAndClock = systemstatus->getLatest(&SystemStatusReports::mTimeAndClock);
 
-        if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
-            (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
+        if ((nullptr != rfAndParams) && (nullptr != timeAndClock) &&
+            (abs(msInWeek - (int)timeAndClock->mGpsTowMs) < 2000)) {
 
             for (size_t i = 0; i < measurements.count; i++) {
                 switch (measurements.measurements[i].svType) {
                 case GNSS_SV_TYPE_GPS:
                 case GNSS_SV_TYPE_QZSS:
                     measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcGps;
+                            rfAndParams->mAgcGps;
                     measurements.measurements[i].flags |=
                             GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
                     break;
 
                 case GNSS_SV_TYPE_GALILEO:
                     measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcGal;
+                            rfAndParams->mAgcGal;
                     measurements.measurements[i].flags |=
                             GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
                     break;
 
                 case GNSS_SV_TYPE_GLONASS:
                     measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcGlo;
+                            rfAndParams->mAgcGlo;
                     measurements.measurements[i].flags |=
                             GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
                     break;
 
                 case GNSS_SV_TYPE_BEIDOU:
                     measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcBds;
+                            rfAndParams->mAgcBds;
                     measurements.measurements[i].flags |=
                             GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
                     break;
@@ -5683,6 +6479,82 @@ GnssAdapter::getAgcInformation(GnssMeasurementsNotification& measurements, int m
     }
 }
 
+/* AGC and jammer indication of each signal type in rfAndParams */
+static void fillDataInformation(const SystemStatusRfAndParams& rfAndParams,
+                                GnssDataNotification& data)
+{
+    for (int sig = GNSS_LOC_SIGNAL_TYPE_GPS_L1CA;
+         sig < GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES; sig++) {
+        data.gnssDataMask[sig] = 0;
+        data.jammerInd[sig] = 0.0;
+        data.agc[sig] = 0.0;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mAgcGps) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
+                GNSS_LOC_DATA_AGC_BIT;
+        data.agc[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
+                rfAndParams.mAgcGps;
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
+                GNSS_LOC_DATA_AGC_BIT;
+        data.agc[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
+                rfAndParams.mAgcGps;
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
+                GNSS_LOC_DATA_AGC_BIT;
+        data.agc[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
+            rfAndParams.mAgcGps;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mJammerGps) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
+                GNSS_LOC_DATA_JAMMER_IND_BIT;
+        data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
+                (double)rfAndParams.mJammerGps;
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
+                GNSS_LOC_DATA_JAMMER_IND_BIT;
+        data.jammerInd[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
+                (double)rfAndParams.mJammerGps;
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
+                GNSS_LOC_DATA_JAMMER_IND_BIT;
+        data.jammerInd[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
+            (double)rfAndParams.mJammerGps;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mAgcGlo) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
+                GNSS_LOC_DATA_AGC_BIT;
+        data.agc[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
+                rfAndParams.mAgcGlo;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mJammerGlo) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
+                GNSS_LOC_DATA_JAMMER_IND_BIT;
+        data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
+                (double)rfAndParams.mJammerGlo;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mAgcBds) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
+                GNSS_LOC_DATA_AGC_BIT;
+        data.agc[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
+                rfAndParams.mAgcBds;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mJammerBds) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
+                GNSS_LOC_DATA_JAMMER_IND_BIT;
+        data.jammerInd[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
+                (double)rfAndParams.mJammerBds;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mAgcGal) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
+                GNSS_LOC_DATA_AGC_BIT;
+        data.agc[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
+                rfAndParams.mAgcGal;
+    }
+    if (GNSS_INVALID_JAMMER_IND != rfAndParams.mJammerGal) {
+        data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
+                GNSS_LOC_DATA_JAMMER_IND_BIT;
+        data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
+                (double)rfAndParams.mJammerGal;
+    }
+}
+
 /* get Data information from system status and fill it */
 void
 GnssAdapter::getDataInformation(GnssDataNotification& data, int msInWeek)
@@ -5691,82 +6563,20 @@ GnssAdapter::getDataInformation(GnssDataNotification& data, int msInWeek)
 
     LOC_LOGV("%s]: msInWeek=%d", __func__, msInWeek);
     if (nullptr != systemstatus) {
-        SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
-
-        if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
-            (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
-
-            for (int sig = GNSS_LOC_SIGNAL_TYPE_GPS_L1CA;
-                 sig < GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES; sig++) {
-                data.gnssDataMask[sig] = 0;
-                data.jammerInd[sig] = 0.0;
-                data.agc[sig] = 0.0;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGps) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
-                        reports.mRfAndParams.back().mAgcGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
-                        reports.mRfAndParams.back().mAgcGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
-                    reports.mRfAndParams.back().mAgcGps;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGps) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
-                        (double)reports.mRfAndParams.back().mJammerGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
-                        (double)reports.mRfAndParams.back().mJammerGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
-                    (double)reports.mRfAndParams.back().mJammerGps;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGlo) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
-                        reports.mRfAndParams.back().mAgcGlo;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGlo) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
-                        (double)reports.mRfAndParams.back().mJammerGlo;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcBds) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
-                        reports.mRfAndParams.back().mAgcBds;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerBds) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
-                        (double)reports.mRfAndParams.back().mJammerBds;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGal) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
-                        reports.mRfAndParams.back().mAgcGal;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGal) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
-                        (double)reports.mRfAndParams.back().mJammerGal;
+        auto rfAndParams = systemstatus->getLatest(&SystemStatusReports::mRfAndParams);
+        auto timeAndClock = systemstatus->getLatest(&SystemStatusReports::mTimeAndClock);
+
+        if ((nullptr != rfAndParams) && (nullptr != timeAndClock) &&
+            (abs(msInWeek - (int)timeAndClock->mGpsTowMs) < 2000)) {
+
+            // the report is the same until the engine sends a new one
+            if (rfAndParams != mDataInfoRfAndParams) {
+                fillDataInformation(*rfAndParams, mDataInfo);
+                mDataInfoRfAndParams = rfAndParams;
             }
+            memcpy(data.gnssDataMask, mDataInfo.gnssDataMask, sizeof(data.gnssDataMask));
+            memcpy(data.jammerInd, mDataInfo.jammerInd, sizeof(data.jammerInd));
+            memcpy(data.agc, mDataInfo.agc, sizeof(data.agc));
         }
     }
 }
@@ -5938,6 +6748,13 @@ void
 GnssAdapter::setPositionAssistedClockEstimator(bool enable,
                                                uint32_t sessionId) {
 
+    if (sessionId != 0 && mLocConfigInfo.paceConfigInfo.isValid &&
+            mLocConfigInfo.paceConfigInfo.enable == enable) {
+        // already set in the engine, setConfig() sets it again after engine restart
+        LOC_LOGd("pace already %s", enable ? "enabled" : "disabled");
+        reportResponse(LOCATION_ERROR_SUCCESS, sessionId);
+        return;
+    }
     mLocConfigInfo.paceConfigInfo.isValid = true;
     mLocConfigInfo.paceConfigInfo.enable = enable;
     LocApiResponse* locApiResponse = nullptr;
@@ -6003,6 +6820,7 @@ void GnssAdapter::gnssUpdateSvConfig(
     }
     // save the constellation settings to be used for modem SSR
     mGnssSvTypeConfig = constellationEnablementConfig;
+    updateEnergyProfileState();
 
     // handle blacklisted SV settings
     mGnssSvIdConfig   = blacklistSvConfig;
@@ -6239,21 +7057,18 @@ bool GnssAdapter::openMeasCorrCommand(const measCorrSetCapabilitiesCb setCapabil
         }
 }
 
-bool GnssAdapter::measCorrSetCorrectionsCommand(const GnssMeasurementCorrections gnssMeasCorr) {
+bool GnssAdapter::measCorrSetCorrectionsCommand(GnssMeasurementCorrections&& gnssMeasCorr) {
     LOC_LOGi("GnssAdapter::measCorrSetCorrectionsCommand");
 
-    /* Message to set Measurement Corrections */
+    /* Message to set the pending Measurement Corrections */
     struct MsgSetCorrectionsMeasCorr : public LocMsg {
-        const GnssMeasurementCorrections mGnssMeasCorr;
         GnssAdapter& mAdapter;
         LocApiBase& mApi;
 
         inline MsgSetCorrectionsMeasCorr(
-            const GnssMeasurementCorrections gnssMeasCorr,
             GnssAdapter& adapter,
             LocApiBase& api) :
             LocMsg(),
-            mGnssMeasCorr(gnssMeasCorr),
             mAdapter(adapter),
             mApi(api) {
             LOC_LOGv("MsgSetCorrectionsMeasCorr");
@@ -6261,12 +7076,34 @@ bool GnssAdapter::measCorrSetCorrectionsCommand(const GnssMeasurementCorrections
 
         inline virtual void proc() const {
             LOC_LOGv("MsgSetCorrectionsMeasCorr::proc()");
-            mApi.setMeasurementCorrections(mGnssMeasCorr);
+            GnssMeasurementCorrections gnssMeasCorr;
+            {
+                std::lock_guard<std::mutex> lock(mAdapter.mMeasCorrLock);
+                gnssMeasCorr = std::move(mAdapter.mPendingMeasCorr);
+                mAdapter.mPendingMeasCorr.satCorrections.clear();
+                mAdapter.mMeasCorrPending = false;
+            }
+            mApi.setMeasurementCorrections(gnssMeasCorr);
         }
     };
 
     if (ContextBase::isFeatureSupported(LOC_SUPPORTED_FEATURE_MEASUREMENTS_CORRECTION)) {
-        sendMsg(new MsgSetCorrectionsMeasCorr(gnssMeasCorr, *this, *mLocApi));
+        bool post = false;
+        {
+            std::lock_guard<std::mutex> lock(mMeasCorrLock);
+            if (mMeasCorrPending) {
+                mMeasCorrDropped++;
+                LOC_LOGd("superseded corrections not yet applied, %" PRIu64 " dropped",
+                         mMeasCorrDropped);
+            }
+            post = !mMeasCorrPending;
+            mPendingMeasCorr = std::move(gnssMeasCorr);
+            mMeasCorrPending = true;
+        }
+        // one queued msg applies whatever is latest by then
+        if (post) {
+            sendMsg(new MsgSetCorrectionsMeasCorr(*this, *mLocApi));
+        }
         return true;
     } else {
         LOC_LOGw("Measurement Corrections are not supported!");
@@ -6487,6 +7324,23 @@ void GnssAdapter::reportGnssConfigEvent(uint32_t sessionId, const GnssConfig& gn
             mSessionId(sessionId),
             mGnssConfig(gnssConfig) {}
         inline virtual void proc() const {
+            // keep what the engine runs with, a later get is served from it
+            if ((mGnssConfig.flags & GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT) &&
+                    (mGnssConfig.robustLocationConfig.validMask &
+                     GNSS_CONFIG_ROBUST_LOCATION_VERSION_VALID_BIT)) {
+                RobustLocationConfigInfo& cached =
+                        mAdapter.mLocConfigInfo.robustLocationConfigInfo;
+                const GnssConfigRobustLocation& reported = mGnssConfig.robustLocationConfig;
+                if (reported.validMask & GNSS_CONFIG_ROBUST_LOCATION_ENABLED_VALID_BIT) {
+                    cached.isValid = true;
+                    cached.enable = reported.enabled;
+                    cached.enableFor911 = (reported.validMask &
+                            GNSS_CONFIG_ROBUST_LOCATION_ENABLED_FOR_E911_VALID_BIT) ?
+                            reported.enabledForE911 : cached.enableFor911;
+                }
+                cached.versionValid = true;
+                cached.version = reported.version;
+            }
             // Invoke control clients config callback
             if (nullptr != mAdapter.mControlCallbacks.gnssConfigCb) {
                 mAdapter.mControlCallbacks.gnssConfigCb(mSessionId, mGnssConfig);
@@ -6511,7 +7365,9 @@ GnssAdapter::initEngHubProxyCommand() {
             LocMsg(),
             mAdapter(adapter) {}
         inline virtual void proc() const {
+            uint64_t startNs = GnssInitTimings::nowNs();
             mAdapter->initEngHubProxy();
+            mAdapter->mInitTimings.record(GNSS_INIT_STEP_ENG_HUB_PROXY, startNs);
         }
     };
 
@@ -6569,7 +7425,7 @@ GnssAdapter::initEngHubProxy() {
         // load the engine hub .so, if the .so is not present
         // all EngHubProxyBase calls will turn into no-op.
         void *handle = nullptr;
-        if ((handle = dlopen("libloc_eng_hub.so", RTLD_NOW)) == nullptr) {
+        if ((handle = LocLibPreloader::open("libloc_eng_hub.so")) == nullptr) {
             if ((error = dlerror()) != nullptr) {
                 LOC_LOGE("%s]: libloc_eng_hub.so not found %s !", __func__, error);
             }
@@ -6666,6 +7522,18 @@ GnssAdapter::parseDoublesString(char* dString) {
 
 void
 GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallback)
+{
+    if (!mGnssAntennaInformationsRead) {
+        readGnssAntennaInformation();
+        mGnssAntennaInformationsRead = true;
+    }
+    if (mGnssAntennaInformations.size() > 0) {
+        antennaInfoCallback(mGnssAntennaInformations);
+    }
+}
+
+void
+GnssAdapter::readGnssAntennaInformation()
 {
 #define MAX_TEXT_WIDTH      50
 #define MAX_COLUMN_WIDTH    20
@@ -6673,10 +7541,10 @@ GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallbac
     /* parse antenna_corrections file and fill in
     a vector of GnssAntennaInformation data structure */
 
-    std::vector<GnssAntennaInformation> gnssAntennaInformations;
+    std::vector<GnssAntennaInformation>& gnssAntennaInformations = mGnssAntennaInformations;
     GnssAntennaInformation gnssAntennaInfo;
 
-    uint32_t antennaInfoVectorSize;
+    uint32_t antennaInfoVectorSize = 0;
     loc_param_s_type ant_info_vector_table[] =
     {
         { "ANTENNA_INFO_VECTOR_SIZE", &antennaInfoVectorSize, NULL, 'n' }
@@ -6787,9 +7655,7 @@ GnssAdapter::reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallbac
         }
         gnssAntennaInformations.push_back(std::move(gnssAntennaInfo));
     }
-    if (antennaInfoVectorSize > 0) {
-        antennaInfoCallback(gnssAntennaInformations);
-    }
+    LOC_LOGd("%zu antenna infos read", gnssAntennaInformations.size());
 }
 
 /* ==== DGnss Usable Reporter ========================================================= */
@@ -6799,6 +7665,7 @@ void GnssAdapter::initCDFWService()
 {
     LOC_LOGv("mCdfwInterface %p", mCdfwInterface);
     if (nullptr == mCdfwInterface) {
+        uint64_t startNs = GnssInitTimings::nowNs();
         void* libHandle = nullptr;
         const char* libName = "libcdfw.so";
 
@@ -6818,6 +7685,7 @@ void GnssAdapter::initCDFWService()
             mCdfwInterface->startDgnssApiService(*mMsgTask);
             mQDgnssListenerHDL = mCdfwInterface->createUsableReporter(qDgnssSessionActiveCb);
         }
+        mInitTimings.record(GNSS_INIT_STEP_CDFW_SERVICE, startNs);
     }
 }
 
@@ -6916,13 +7784,28 @@ void GnssAdapter::checkUpdateDgnssNtrip(bool isLocationValid) {
             }
         } else if ((mDgnssState & DGNSS_STATE_NTRIP_SESSION_STARTED) && isLocationValid &&
             isDgnssNmeaRequired() &&
-            curBootTime - mDgnssLastNmeaBootTimeMilli > DGNSS_RANGE_UPDATE_TIME_10MIN_IN_MILLI ) {
+            curBootTime - mDgnssLastNmeaBootTimeMilli >
+                    ContextBase::mGps_conf.DGNSS_NTRIP_GGA_INTERVAL_SEC * 1000ULL) {
             mXtraObserver.updateNmeaToDgnssServer(mStartDgnssNtripParams.nmea);
             mDgnssLastNmeaBootTimeMilli = curBootTime;
         }
     }
 }
 
+// Whether checkUpdateDgnssNtrip() would use a GGA given now, so that the GGA
+// of fixes in between NTRIP updates is not kept at all
+bool GnssAdapter::isDgnssGgaNeeded() {
+    if (!isDgnssNmeaRequired() || !isInSession()) {
+        return false;
+    }
+    // the session start waits for the first GGA
+    if (!(mDgnssState & DGNSS_STATE_NTRIP_SESSION_STARTED)) {
+        return true;
+    }
+    return (getBootTimeMilliSec() - mDgnssLastNmeaBootTimeMilli >
+            ContextBase::mGps_conf.DGNSS_NTRIP_GGA_INTERVAL_SEC * 1000ULL);
+}
+
 void GnssAdapter::stopDgnssNtrip() {
     LOC_LOGd("isInSession %d mDgnssState 0x%x", isInSession(), mDgnssState);
     mStartDgnssNtripParams.nmea.clear();
@@ -6937,43 +7820,36 @@ void GnssAdapter::reportGGAToNtrip(const char* nmea) {
 #define POS_OF_GGA (3)  //start position of "GGA"
 #define COMMAS_BEFORE_VALID (6) //"$GPGGA,,,,,,0,,,,,,,,*hh"
 
-    if (!isDgnssNmeaRequired()) {
+    if (nullptr == nmea || !isDgnssGgaNeeded()) {
         return;
     }
 
-    if (nullptr == nmea || 0 == strlen(nmea)) {
+    /* the GGA sentence is located and checked in place, only a GGA
+     * that is going to be used is copied */
+    const char* found = strstr(nmea, "GGA");
+    if (nullptr == found || found - nmea < POS_OF_GGA) {
         return;
     }
+    const char* gga = found - POS_OF_GGA;
+    /* remove other sentences after GGA */
+    const char* ggaEnd = strchr(found, '$');
+    size_t ggaLen = (nullptr != ggaEnd) ? (size_t)(ggaEnd - gga) : strlen(gga);
 
-    string nmeaString(nmea);
-    size_t foundPos = nmeaString.find("GGA");
+    const char* fixQuality = gga;
     size_t foundNth = 0;
-    string GGAString;
-
-    if (foundPos != string::npos && foundPos >= POS_OF_GGA) {
-        size_t foundNextSentence = nmeaString.find("$", foundPos);
-        if (foundNextSentence != string::npos) {
-            /* remove other sentences after GGA */
-            GGAString = nmeaString.substr(foundPos - POS_OF_GGA, foundNextSentence);
-        } else {
-            /* GGA is the last sentence */
-            GGAString = nmeaString.substr(foundPos - POS_OF_GGA);
-        }
-        LOC_LOGd("GGAString %s", GGAString.c_str());
-
-        foundPos = GGAString.find(",");
-        while (foundPos != string::npos && foundNth < COMMAS_BEFORE_VALID) {
-            foundPos++;
-            foundNth++;
-            foundPos = GGAString.find(",", foundPos);
-        }
-
-        if (COMMAS_BEFORE_VALID == foundNth && GGAString.at(foundPos-1) != '0') {
-            mDgnssState |= DGNSS_STATE_NO_NMEA_PENDING;
-            mStartDgnssNtripParams.nmea = std::move(GGAString);
-            checkUpdateDgnssNtrip(true);
-        }
+    while (foundNth < COMMAS_BEFORE_VALID &&
+            nullptr != (fixQuality = (const char*)memchr(
+                    fixQuality, ',', ggaLen - (fixQuality - gga)))) {
+        fixQuality++;
+        foundNth++;
     }
 
-    return;
+    /* fix quality is the field after the 6th comma, 0 means invalid */
+    if (COMMAS_BEFORE_VALID == foundNth && fixQuality < gga + ggaLen &&
+            *fixQuality != ',' && *fixQuality != '0') {
+        LOC_LOGd("GGAString %.*s", (int)ggaLen, gga);
+        mDgnssState |= DGNSS_STATE_NO_NMEA_PENDING;
+        mStartDgnssNtripParams.nmea.assign(gga, ggaLen);
+        checkUpdateDgnssNtrip(true);
+    }
 }
@@ -38,10 +38,18 @@
 #include <SystemStatus.h>
 #include <XtraSystemStatusObserver.h>
 #include <map>
+#include <set>
 #include <functional>
 #include <loc_misc_utils.h>
 #include <queue>
 #include <NativeAgpsHandler.h>
+#include <LocHistogram.h>
+#include <LocLibPreloader.h>
+#include <LocFlatMap.h>
+#include <LocInlineArray.h>
+#include <GnssLastFixCache.h>
+#include <atomic>
+#include <mutex>
 
 #define MAX_URL_LEN 256
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -51,11 +59,14 @@
 #define LOC_GPS_NI_RESPONSE_IGNORE 4
 #define ODCPI_EXPECTED_INJECTION_TIME_MS 10000
 #define DELETE_AIDING_DATA_EXPECTED_TIME_MS 5000
+// ids of a gnssUpdateConfig / gnssGetConfig request, one per flag set, held inline
+#define GNSS_CONFIG_INLINE_IDS 32
+typedef loc_util::LocInlineArray<uint32_t, GNSS_CONFIG_INLINE_IDS> GnssConfigIdArray;
 
 class GnssAdapter;
 
-typedef std::map<LocationSessionKey, LocationOptions> LocationSessionMap;
-typedef std::map<LocationSessionKey, TrackingOptions> TrackingOptionsMap;
+typedef loc_util::LocFlatMap<LocationSessionKey, LocationOptions> LocationSessionMap;
+typedef loc_util::LocFlatMap<LocationSessionKey, TrackingOptions> TrackingOptionsMap;
 
 class OdcpiTimer : public LocTimer {
 public:
@@ -143,6 +154,9 @@ typedef struct {
     bool isValid;
     bool enable;
     bool enableFor911;
+    // engine version, known once the engine reported its config
+    bool versionValid;
+    GnssConfigRobustLocationVersion version;
 } RobustLocationConfigInfo;
 
 typedef struct {
@@ -197,7 +211,161 @@ private:
     LogGnssLatency mLogLatency;
 };
 
-class GnssAdapter : public LocAdapterBase {
+// Rolling fix delivery latency in usec, derived from the QTimer stamps of
+// each GnssLatencyInfo. QTimer is shared by all processors, so stamps taken
+// on the modem and on the AP can be subtracted directly.
+class GnssFixLatencyStats {
+public:
+    GnssFixLatencyStats();
+    // records one report; stages with missing or out of order stamps are skipped
+    void record(const GnssLatencyInfo& info);
+    void dump(std::string& out) const;
+
+private:
+    uint64_t mQTimerFreq;
+    // meQtimer1 (measurement) to peQtimer3 (position engine output)
+    loc_util::LocRollingHistogram mMeasToEngineUs;
+    // peQtimer3 to hlosQtimer2 (report received by the adapter)
+    loc_util::LocRollingHistogram mEngineToAdapterUs;
+    // hlosQtimer2 to hlosQtimer5 (fix handed to the clients)
+    loc_util::LocRollingHistogram mAdapterToClientUs;
+    // meQtimer1 to hlosQtimer5
+    loc_util::LocRollingHistogram mTotalUs;
+};
+
+// Throughput of sessions with a sub-second TBF: the interval between SPE fixes
+// reaching the adapter and the time the adapter takes to hand each to all of
+// its clients, so the dump shows the sustained rate and the headroom left in
+// each epoch. record() runs on the adapter thread, dump on any thread.
+class GnssHighRateStats {
+public:
+    GnssHighRateStats();
+    // a fix whose delivery started at startNs, from GnssInitTimings::nowNs()
+    void record(uint64_t startNs);
+    inline void countDecimatedSv() { mDecimatedSv.fetch_add(1, std::memory_order_relaxed); }
+    void dump(std::string& out) const;
+
+private:
+    uint64_t mLastFixNs;
+    loc_util::LocRollingHistogram mIntervalUs;
+    loc_util::LocRollingHistogram mDeliveryUs;
+    std::atomic<uint64_t> mDecimatedSv;
+};
+
+// GnssAdapter startup steps whose duration is kept for the debug dump
+typedef enum {
+    GNSS_INIT_STEP_READ_CONFIG = 0,
+    GNSS_INIT_STEP_DEFAULT_AGPS,
+    GNSS_INIT_STEP_ENG_HUB_PROXY,
+    GNSS_INIT_STEP_ENGINE_UP,
+    GNSS_INIT_STEP_CDFW_SERVICE,
+    GNSS_INIT_STEP_COUNT
+} GnssInitStep;
+
+// Duration of the last run of each startup step, in usec. Steps record from
+// the thread they run on, dump is callable from any thread.
+class GnssInitTimings {
+public:
+    GnssInitTimings();
+    static uint64_t nowNs();
+    // startNs was taken with nowNs() when the step began
+    void record(GnssInitStep step, uint64_t startNs);
+    void dump(std::string& out) const;
+
+private:
+    std::atomic<uint64_t> mStepUs[GNSS_INIT_STEP_COUNT]; // UINT64_MAX until the step ran
+};
+
+// What the engine was asked to do, an energy profile bucket key
+struct GnssEnergyProfileState {
+    uint32_t sessions;              // time based tracking sessions
+    GnssPowerMode powerMode;        // multiplexed over the sessions
+    uint32_t tbfMs;                 // multiplexed over the sessions
+    GnssSvTypesMask enabledSvTypes; // 0 for the engine default
+    int8_t screenOn;                // -1 until the screen state is known
+    inline bool operator==(const GnssEnergyProfileState& other) const {
+        return sessions == other.sessions && powerMode == other.powerMode &&
+                tbfMs == other.tbfMs && enabledSvTypes == other.enabledSvTypes &&
+                screenOn == other.screenOn;
+    }
+};
+
+// Engine energy split by GnssEnergyProfileState, for mJ per fix of each
+// tracking setup. The energy, time and final fixes between two engine
+// energy readings go to the state in effect at the first of them. The
+// adapter asks for a reading whenever the state changes, see
+// GNSS_ENERGY_PROFILE_ENABLED in gps.conf. Updates are done on the adapter
+// thread, dump is callable from any thread.
+class GnssEnergyProfile {
+public:
+    GnssEnergyProfile();
+    // true if the state differs from the current one, and a reading is due
+    bool setState(const GnssEnergyProfileState& state);
+    inline void addFix() { mIntervalFixes++; }
+    // energy in 0.1 mWs since first boot, as reported by the engine
+    void addSample(uint64_t energy);
+    void dump(std::string& out) const;
+
+private:
+    struct Bucket {
+        GnssEnergyProfileState state;
+        uint64_t energy;     // 0.1 mWs
+        uint64_t durationMs;
+        uint64_t fixes;
+    };
+    GnssEnergyProfileState mState;
+    // state, boot time and energy of the last reading
+    GnssEnergyProfileState mSampleState;
+    uint64_t mSampleBootTimeMs;
+    uint64_t mSampleEnergy;
+    uint64_t mIntervalFixes;
+    mutable std::mutex mMutex;
+    // the states seen so far, the last one also takes any states past the cap
+    std::vector<Bucket> mBuckets;
+};
+
+class GnssAdapter : public LocAdapterBase, public LocAdapterListener {
+
+    /* ==== CLIENT SUBSCRIBERS ============================================================= */
+    // Per report type views of mClientData, in mClientData order. They point
+    // into mClientData storage and are rebuilt by updateClientSubscribers()
+    // whenever a client is saved or erased, so the report fan-outs only walk
+    // the clients that registered the callback. Position subscribers are also
+    // kept split by isFlpClient(), for fixes that go to one kind only.
+    std::vector<LocationCallbacks*> mPositionSubscribers;
+    std::vector<LocationCallbacks*> mFlpPositionSubscribers;
+    std::vector<LocationCallbacks*> mGnssPositionSubscribers;
+    // whether any FLP / GNSS position subscriber reads more than the Location,
+    // otherwise reportPosition skips convertLocationInfo
+    bool mFlpLocationInfoNeeded;
+    bool mGnssLocationInfoNeeded;
+    // engine types a subscriber takes, as bits (1 << LocOutputEngineType), from the
+    // locReqEngTypeMask of its sessions; a client asking for none takes them all
+    struct EngineLocationsSubscriber {
+        LocationAPI* client;
+        LocationCallbacks* callbacks;
+        uint32_t engineMask;
+    };
+    std::vector<EngineLocationsSubscriber> mEngineLocationsSubscribers;
+    // union of the engineMask of all subscribers, read on the engine hub thread
+    std::atomic<uint32_t> mEngineLocationsNeededMask;
+    std::vector<LocationCallbacks*> mSvSubscribers;
+    std::vector<LocationCallbacks*> mNmeaSubscribers;
+    // a subscriber gets a measurement epoch every minIntervalMs, the shortest
+    // minInterval of its sessions, or every epoch with a GNSS_POWER_MODE_M1
+    // (full tracking) session or no session at all
+    struct MeasurementsSubscriber {
+        LocationAPI* client;
+        LocationCallbacks* callbacks;
+        uint32_t minIntervalMs;
+        uint64_t nextDueNs;
+    };
+    std::vector<MeasurementsSubscriber> mMeasurementsSubscribers;
+    // recomputes what the engine locations and measurements subscribers take
+    // from their sessions, after a subscriber or session change
+    void updateSessionSubscribers();
+    std::vector<LocationCallbacks*> mDataSubscribers;
+    void updateClientSubscribers();
 
     /* ==== Engine Hub ===================================================================== */
     EngineHubProxyBase* mEngHubProxy;
@@ -206,6 +374,13 @@ class GnssAdapter : public LocAdapterBase {
 
     /* ==== TRACKING ======================================================================= */
     TrackingOptionsMap mTimeBasedTrackingSessions;
+    // mTimeBasedTrackingSessions ordered by (minInterval, key) and by powerMode,
+    // so the multiplexed options are read off the front instead of scanning
+    // every session. Kept in step by saveTrackingSession / eraseTrackingSession.
+    std::multiset<std::pair<uint32_t, LocationSessionKey>> mTimeBasedTrackingIntervals;
+    std::multiset<GnssPowerMode> mTimeBasedTrackingPowerModes;
+    void getMultiplexedTrackingOptions(const LocationSessionKey* excludedKey,
+                                       TrackingOptions& options, GnssPowerMode& powerMode);
     LocationSessionMap mDistanceBasedTrackingSessions;
     LocPosMode mLocPositionMode;
     GnssSvUsedInPosition mGnssSvIdUsedInPosition;
@@ -218,6 +393,9 @@ class GnssAdapter : public LocAdapterBase {
     uint32_t mAfwControlId;
     uint32_t mNmeaMask;
     uint64_t mPrevNmeaRptTimeNsec;
+    // GSV sentences held for the position of the same epoch, with
+    // NMEA_EPOCH_BATCHING_ENABLED
+    std::string mNmeaEpochBatch;
     GnssSvIdConfig mGnssSvIdConfig;
     GnssSvTypeConfig mGnssSeconaryBandConfig;
     GnssSvTypeConfig mGnssSvTypeConfig;
@@ -232,6 +410,8 @@ class GnssAdapter : public LocAdapterBase {
     // This must be initialized via initAgps()
     AgpsManager mAgpsManager;
     void initAgps(const AgpsCbInfo& cbInfo);
+    /* brings the SUPL data call up or down per AGPS_PREWARM_MODE */
+    void updateAgpsPrewarm();
 
     /* ==== NFW =========================================================================== */
     NfwStatusCb mNfwCb;
@@ -244,8 +424,18 @@ class GnssAdapter : public LocAdapterBase {
     /* ==== Measurement Corrections========================================================= */
     bool mIsMeasCorrInterfaceOpen;
     measCorrSetCapabilitiesCb mMeasCorrSetCapabilitiesCb;
+    // the latest corrections not yet handed to LocApi; a newer set replaces
+    // one still pending, as applying the stale one first would gain nothing
+    std::mutex mMeasCorrLock;
+    GnssMeasurementCorrections mPendingMeasCorr;
+    bool mMeasCorrPending;
+    uint64_t mMeasCorrDropped;
     bool initMeasCorr(bool bSendCbWhenNotSupported);
     bool mIsAntennaInfoInterfaceOpened;
+    // antenna_corrections is static per device, parsed at the first
+    // antennaInfoInitCommand() and served from here after that
+    bool mGnssAntennaInformationsRead;
+    std::vector<GnssAntennaInformation> mGnssAntennaInformations;
 
     /* ==== DGNSS Data Usable Report======================================================== */
     QDgnssListenerHDL mQDgnssListenerHDL;
@@ -260,7 +450,14 @@ class GnssAdapter : public LocAdapterBase {
     OdcpiPrioritytype mCallbackPriority;
     OdcpiTimer mOdcpiTimer;
     OdcpiRequestInfo mOdcpiRequest;
+    // whether the framework was sent a START not followed by a STOP yet
+    bool mOdcpiFrameworkStarted;
+    // last location injected by the framework for ODCPI, and when
+    Location mOdcpiLastLocation;
+    uint64_t mOdcpiLastLocationBootTimeMilli;
     void odcpiTimerExpire();
+    void sendOdcpiRequest(const OdcpiRequestInfo& request);
+    bool injectCachedOdcpi();
 
     /* ==== DELETEAIDINGDATA =============================================================== */
     int64_t mLastDeleteAidingDataTime;
@@ -272,7 +469,13 @@ class GnssAdapter : public LocAdapterBase {
     XtraSystemStatusObserver mXtraObserver;
     LocationSystemInfo mLocSystemInfo;
     std::vector<GnssSvIdSource> mBlacklistedSvIds;
+    // config items the engine last accepted through gnssUpdateConfig, flags tell
+    // which are known. Only touched on the LocApi thread, cleared by setConfig
+    // so an engine (re)start gets everything injected again.
+    GnssConfig mEngineConfigShadow;
     PowerStateType mSystemPowerState;
+    // engine TBF raised for FLP sessions while suspended, see SUSPEND_TRACKING_MIN_TBF_MS
+    bool mSuspendTrackingThrottled;
 
     /* === Misc ===================================================================== */
     BlockCPIInfo mBlockCPIInfo;
@@ -280,7 +483,45 @@ class GnssAdapter : public LocAdapterBase {
     uint32_t mAllowFlpNetworkFixes;
     std::queue<GnssLatencyInfo> mGnssLatencyInfoQueue;
     GnssReportLoggerUtil mLogger;
+    GnssFixLatencyStats mFixLatencyStats;
+    GnssEnergyProfile mEnergyProfile;
+    void updateEnergyProfileState();
+    GnssInitTimings mInitTimings;
+    GnssLastFixCache mLastFixCache;
+    void updateLastFixCache(const UlpLocation& ulpLocation, enum loc_sess_status status);
+    void injectCachedLastFix();
     bool mDreIntEnabled;
+    // offset (time - timeReference) and uncertainty of the last time
+    // injection handed to the engine, taken from the caller thread
+    std::mutex mTimeInjectLock;
+    bool mTimeInjectValid;
+    int64_t mTimeInjectOffsetMs;
+    int32_t mTimeInjectUncMs;
+    bool isRedundantTimeInjection(int64_t time, int64_t timeReference, int32_t uncertainty);
+    void resetTimeInjection();
+    // sv and data (agc / jammer) reports only matter as the latest value;
+    // positions, nmea and system info stay lossless
+    LocMsgSlot mSvReportSlot;
+    LocMsgSlot mDataReportSlot;
+    // TBF below one second, SV and NMEA go out at 1 Hz with HIGH_RATE_DECIMATION_ENABLED
+    inline bool isHighRateTracking() const {
+        return !mTimeBasedTrackingSessions.empty() &&
+                mLocPositionMode.min_interval < GPS_DEFAULT_FIX_INTERVAL_MS;
+    }
+    GnssHighRateStats mHighRateStats;
+    uint64_t mPrevSvRptTimeNsec;
+    // With SCREEN_OFF_REPORT_INTERVAL_MS set, SV (and the GSV made of it) and
+    // data reports go out at most that often while the screen is off; true
+    // if the report is to be dropped, lastReportNs is when one last went out
+    bool isThrottledForScreenOff(uint64_t& lastReportNs);
+    uint64_t mScreenOffSvRptNs;
+    uint64_t mScreenOffDataRptNs;
+    std::atomic<uint64_t> mScreenOffDroppedSv;
+    std::atomic<uint64_t> mScreenOffDroppedData;
+    // AGC / jammer fields getDataInformation() fills in, worked out once
+    // for each SystemStatusRfAndParams reported; used on the msg task only
+    std::shared_ptr<const SystemStatusRfAndParams> mDataInfoRfAndParams;
+    GnssDataNotification mDataInfo;
 
     /* === NativeAgpsHandler ======================================================== */
     NativeAgpsHandler mNativeAgpsHandler;
@@ -309,6 +550,7 @@ class GnssAdapter : public LocAdapterBase {
     bool    mSendNmeaConsent;
     DGnssStateBitMask   mDgnssState;
     void checkUpdateDgnssNtrip(bool isLocationValid);
+    bool isDgnssGgaNeeded();
     void stopDgnssNtrip();
     uint64_t   mDgnssLastNmeaBootTimeMilli;
 
@@ -327,6 +569,7 @@ public:
     /* ==== SSR ============================================================================ */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
     virtual void handleEngineUpEvent();
+    virtual void handleConfigChangeEvent(const char* confPath, const LocConfNames& changed);
     /* ======== UTILITIES ================================================================== */
     void restartSessions(bool modemSSR = false);
     void checkAndRestartTimeBasedSession();
@@ -369,6 +612,8 @@ public:
     void updateTracking(LocationAPI* client, uint32_t sessionId,
             const TrackingOptions& updatedOptions, const TrackingOptions& oldOptions);
     bool checkAndSetSPEToRunforNHz(TrackingOptions & out);
+    bool applySuspendTrackingThrottle(const LocationSessionKey* key, TrackingOptions& options);
+    void updateSuspendTrackingThrottle();
 
     void setConstrainedTunc(bool enable, float tuncConstraint,
                             uint32_t energyBudget, uint32_t sessionId);
@@ -421,7 +666,6 @@ public:
     void gnssResetSvTypeConfigCommand();
 
     /* ==== UTILITIES ====================================================================== */
-    LocationError gnssSvIdConfigUpdateSync(const std::vector<GnssSvIdSource>& blacklistedSvIds);
     LocationError gnssSvIdConfigUpdateSync();
     void gnssSvIdConfigUpdate(const std::vector<GnssSvIdSource>& blacklistedSvIds);
     void gnssSvIdConfigUpdate();
@@ -440,6 +684,7 @@ public:
     /* ======== COMMANDS ====(Called from Client Thread)==================================== */
     void initDefaultAgpsCommand();
     void initAgpsCommand(const AgpsCbInfo& cbInfo);
+    void updateAgpsPrewarmCommand();
     void initNfwCommand(const NfwCbInfo& cbInfo);
     void dataConnOpenCommand(AGpsExtType agpsType,
             const char* apnName, int apnLen, AGpsBearerType bearerType);
@@ -458,7 +703,7 @@ public:
     uint32_t configLeverArmCommand(const LeverArmConfigInfo& configInfo);
     uint32_t configRobustLocationCommand(bool enable, bool enableForE911);
     bool openMeasCorrCommand(const measCorrSetCapabilitiesCb setCapabilitiesCb);
-    bool measCorrSetCorrectionsCommand(const GnssMeasurementCorrections gnssMeasCorr);
+    bool measCorrSetCorrectionsCommand(GnssMeasurementCorrections&& gnssMeasCorr);
     inline void closeMeasCorrCommand() { mIsMeasCorrInterfaceOpen = false; }
     uint32_t antennaInfoInitCommand(const antennaInfoCb antennaInfoCallback);
     inline void antennaInfoCloseCommand() { mIsAntennaInfoInterfaceOpened = false; }
@@ -494,6 +739,10 @@ public:
                                      LocPosTechMask techMask,
                                      GnssDataNotification* pDataNotify = nullptr,
                                      int msInWeek = -1);
+    virtual void reportPositionReportEvent(const LocPositionReportPtr& report,
+                                           LocPosTechMask techMask,
+                                           GnssDataNotification* pDataNotify,
+                                           int msInWeek);
     virtual void reportEnginePositionsEvent(unsigned int count,
                                             EngineLocationInfo* locationArr);
 
@@ -535,6 +784,7 @@ public:
     bool needReportForFlpClient(enum loc_sess_status status, LocPosTechMask techMask);
     bool needToGenerateNmeaReport(const uint32_t &gpsTimeOfWeekMs,
         const struct timespec32_t &apTimeStamp);
+    NmeaSentenceTypesMask getNmeaGenerationMask();
     void reportPosition(const UlpLocation &ulpLocation,
                         const GpsLocationExtended &locationExtended,
                         enum loc_sess_status status,
@@ -567,14 +817,37 @@ public:
     }
 
     void updateSystemPowerState(PowerStateType systemPowerState);
-    void reportSvPolynomial(const GnssSvPolynomial &svPolynomial);
 
 
     std::vector<double> parseDoublesString(char* dString);
+    void readGnssAntennaInformation();
     void reportGnssAntennaInformation(const antennaInfoCb antennaInfoCallback);
 
     /*======== GNSSDEBUG ================================================================*/
     bool getDebugReport(GnssDebugReport& report);
+    // changes whenever getDebugReport() may report something new
+    uint64_t getDebugReportGeneration();
+    // appends the startup timings, fix latency, engine report counts and
+    // SystemStatus histograms, callable from any thread
+    inline void dumpStats(std::string& out) const {
+        mInitTimings.dump(out);
+        loc_util::LocLibPreloader::dump(out);
+        mFixLatencyStats.dump(out);
+        mHighRateStats.dump(out);
+        out += "Screen off throttling: sv_dropped=" +
+                std::to_string(mScreenOffDroppedSv.load(std::memory_order_relaxed)) +
+                " data_dropped=" +
+                std::to_string(mScreenOffDroppedData.load(std::memory_order_relaxed)) + "\n";
+        mEnergyProfile.dump(out);
+        if (nullptr != mLocApi) {
+            mLocApi->dumpStats(out);
+        }
+        mXtraObserver.dumpStats(out);
+        SystemStatus::dumpStats(out);
+        if (nullptr != mSystemStatus) {
+            mSystemStatus->dumpTrack(out);
+        }
+    }
     /* get AGC information from system status and fill it */
     void getAgcInformation(GnssMeasurementsNotification& measurements, int msInWeek);
     /* get Data information from system status and fill it */
@@ -595,7 +868,9 @@ public:
     static uint32_t convertSuplMode(const GnssConfigSuplModeMask suplModeMask);
     static void convertSatelliteInfo(std::vector<GnssDebugSatelliteInfo>& out,
                                      const GnssSvType& in_constellation,
-                                     const SystemStatusReports& in);
+                                     const SystemStatusSvHealth* svHealth,
+                                     const SystemStatusXtra* xtra,
+                                     const SystemStatusNavData* navData);
     static bool convertToGnssSvIdConfig(
             const std::vector<GnssSvIdSource>& blacklistedSvIds, GnssSvIdConfig& config);
     static void convertFromGnssSvIdConfig(
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#define LOG_TAG "LocSvc_GnssLastFixCache"
+
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <log_util.h>
+#include <GnssLastFixCache.h>
+
+#define LAST_FIX_CACHE_MAGIC   (0x4c465843) // "LFXC"
+#define LAST_FIX_CACHE_VERSION (1)
+
+// on-file layout; seq is odd while an update is in progress, so a record
+// torn by a crash in the middle of update() is not used
+struct GnssLastFixCache::Record {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;
+    uint32_t reserved;
+    double latitude;
+    double longitude;
+    float accuracy;
+    uint32_t reserved2;
+    int64_t utcTimeMs;
+};
+
+GnssLastFixCache::GnssLastFixCache() : mRecord(nullptr), mOpenFailed(false) {}
+
+GnssLastFixCache::~GnssLastFixCache() {
+    if (nullptr != mRecord) {
+        munmap(mRecord, sizeof(Record));
+    }
+}
+
+bool GnssLastFixCache::open(const char* path) {
+    if (nullptr != mRecord) {
+        return true;
+    }
+    if (mOpenFailed) {
+        return false;
+    }
+    mOpenFailed = true;
+    int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        LOC_LOGw("open %s failed, errno %d", path, errno);
+        return false;
+    }
+    struct stat st = {};
+    if (0 != fstat(fd, &st) ||
+            (st.st_size != (off_t)sizeof(Record) && 0 != ftruncate(fd, sizeof(Record)))) {
+        LOC_LOGw("sizing %s failed, errno %d", path, errno);
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, sizeof(Record), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (MAP_FAILED == addr) {
+        LOC_LOGw("mmap %s failed, errno %d", path, errno);
+        return false;
+    }
+    mRecord = static_cast<Record*>(addr);
+    mOpenFailed = false;
+    if (LAST_FIX_CACHE_MAGIC != mRecord->magic ||
+            LAST_FIX_CACHE_VERSION != mRecord->version) {
+        // new or foreign file, start over
+        memset(mRecord, 0, sizeof(Record));
+        mRecord->magic = LAST_FIX_CACHE_MAGIC;
+        mRecord->version = LAST_FIX_CACHE_VERSION;
+    }
+    return true;
+}
+
+void GnssLastFixCache::update(double latitude, double longitude, float accuracy,
+                              int64_t utcTimeMs) {
+    if (nullptr == mRecord) {
+        return;
+    }
+    volatile uint32_t& seq = mRecord->seq;
+    seq = seq | 1;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    mRecord->latitude = latitude;
+    mRecord->longitude = longitude;
+    mRecord->accuracy = accuracy;
+    mRecord->utcTimeMs = utcTimeMs;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    seq = seq + 1;
+}
+
+bool GnssLastFixCache::get(int64_t nowUtcMs, uint32_t maxAgeSec, double& latitude,
+                           double& longitude, float& accuracy, int64_t& utcTimeMs) const {
+    if (nullptr == mRecord || 0 == mRecord->seq || (mRecord->seq & 1)) {
+        return false;
+    }
+    int64_t ageMs = nowUtcMs - mRecord->utcTimeMs;
+    // a fix from the future means the clock changed, do not trust it
+    if (mRecord->utcTimeMs <= 0 || ageMs < 0 || ageMs > (int64_t)maxAgeSec * 1000) {
+        return false;
+    }
+    latitude = mRecord->latitude;
+    longitude = mRecord->longitude;
+    accuracy = mRecord->accuracy;
+    utcTimeMs = mRecord->utcTimeMs;
+    return true;
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef GNSS_LAST_FIX_CACHE_H
+#define GNSS_LAST_FIX_CACHE_H
+
+#include <stdint.h>
+
+#define GNSS_LAST_FIX_CACHE_FILE "/data/vendor/location/gnss_last_fix.bin"
+
+// Last good fix, kept in a small mmap'ed file so that it outlives the HAL
+// process. A crash or restart of the HAL leaves the page in the page cache,
+// and the kernel writes it back, so it normally survives a reboot as well.
+// The adapter injects it as a coarse position on engine up, see
+// LAST_FIX_CACHE_MAX_AGE_SEC in gps.conf. Updates and reads are done on
+// the adapter thread only.
+class GnssLastFixCache {
+public:
+    GnssLastFixCache();
+    ~GnssLastFixCache();
+    // maps the cache file, creating it if needed; false if it can not be used
+    bool open(const char* path = GNSS_LAST_FIX_CACHE_FILE);
+    void update(double latitude, double longitude, float accuracy, int64_t utcTimeMs);
+    // the cached fix if it is valid and not older than maxAgeSec at nowUtcMs
+    bool get(int64_t nowUtcMs, uint32_t maxAgeSec, double& latitude, double& longitude,
+             float& accuracy, int64_t& utcTimeMs) const;
+
+private:
+    struct Record;
+    Record* mRecord;
+    bool mOpenFailed; // not retried on every fix
+};
+
+#endif // GNSS_LAST_FIX_CACHE_H
@@ -52,7 +52,12 @@ void NativeAgpsHandler::notify(const list<IDataItemCore*>& dlist) {
                         static_cast<NetworkInfoDataItemBase*>(each);
                     uint64_t mobileBit = (uint64_t )1 << loc_core::TYPE_MOBILE;
                     uint64_t allTypes = networkInfo->mAllTypes;
-                    mConnected = ((networkInfo->mAllTypes & mobileBit) == mobileBit);
+                    bool connected = ((networkInfo->mAllTypes & mobileBit) == mobileBit);
+                    if (connected != mConnected) {
+                        /* the SUPL data call is only prewarmed on mobile data */
+                        mAdapter.updateAgpsPrewarmCommand();
+                    }
+                    mConnected = connected;
                     /**
                      * mApn Telephony preferred Access Point Name to use for
                      * carrier data connection when connected to a cellular network.
@@ -110,7 +110,8 @@ XtraSystemStatusObserver::XtraSystemStatusObserver(IOsObserver* sysStatObs,
         mReqStatusReceived(false),
         mIsConnectivityStatusKnown(false),
         mSender(LocIpc::getLocIpcLocalSender(LOC_IPC_XTRA)),
-        mDelayLocTimer(*mSender) {
+        mPendingUpdates(0),
+        mDelayLocTimer(*mSender), mStatusFlushTimer(*this) {
     subscribe(true);
     auto recver = LocIpc::getLocIpcLocalRecver(
             make_shared<XtraIpcListener>(sysStatObs, msgTask, *this),
@@ -124,119 +125,172 @@ bool XtraSystemStatusObserver::updateLockStatus(GnssConfigGpsLock lock) {
     // MO(AFW bit) is enabled and disabled when MO is disabled
     mGpsLock = lock & ~GNSS_CONFIG_GPS_LOCK_NI;
 
-    if (!mReqStatusReceived) {
-        return true;
-    }
-
-    stringstream ss;
-    ss <<  "gpslock";
-    ss << " " << mGpsLock;
-    string s = ss.str();
-    return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
+    queueStatusUpdate(XTRA_STATUS_UPDATE_LOCK);
+    return true;
 }
 
 bool XtraSystemStatusObserver::updateConnections(uint64_t allConnections,
         NetworkInfoType* networkHandleInfo) {
+    bool changed = !mIsConnectivityStatusKnown || mConnections != allConnections;
     mIsConnectivityStatusKnown = true;
     mConnections = allConnections;
 
     LOC_LOGd("updateConnections mConnections:%" PRIx64, mConnections);
     for (uint8_t i = 0; i < MAX_NETWORK_HANDLES; ++i) {
+        changed = changed || !(mNetworkHandle[i] == networkHandleInfo[i]);
         mNetworkHandle[i] = networkHandleInfo[i];
         LOC_LOGd("updateConnections [%d] networkHandle:%" PRIx64 " networkType:%u",
             i, mNetworkHandle[i].networkHandle, mNetworkHandle[i].networkType);
     }
 
-    if (!mReqStatusReceived) {
-        return true;
+    // the daemon already has this state, either from the last update or
+    // from respondStatus
+    if (changed) {
+        queueStatusUpdate(XTRA_STATUS_UPDATE_CONNECTIONS);
     }
-
-    stringstream ss;
-    ss << "connection" << endl << mConnections << endl
-            << mNetworkHandle[0].toString() << endl
-            << mNetworkHandle[1].toString() << endl
-            << mNetworkHandle[2].toString() << endl
-            << mNetworkHandle[3].toString() << endl
-            << mNetworkHandle[4].toString() << endl
-            << mNetworkHandle[5].toString() << endl
-            << mNetworkHandle[6].toString() << endl
-            << mNetworkHandle[7].toString() << endl
-            << mNetworkHandle[8].toString() << endl
-            << mNetworkHandle[MAX_NETWORK_HANDLES-1].toString();
-    string s = ss.str();
-    return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
+    return true;
 }
 
 bool XtraSystemStatusObserver::updateTac(const string& tac) {
+    bool changed = (mTac != tac);
     mTac = tac;
 
-    if (!mReqStatusReceived) {
-        return true;
+    if (changed) {
+        queueStatusUpdate(XTRA_STATUS_UPDATE_TAC);
     }
-
-    stringstream ss;
-    ss <<  "tac";
-    ss << " " << tac.c_str();
-    string s = ss.str();
-    return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
+    return true;
 }
 
 bool XtraSystemStatusObserver::updateMccMnc(const string& mccmnc) {
+    bool changed = (mMccmnc != mccmnc);
     mMccmnc = mccmnc;
 
-    if (!mReqStatusReceived) {
-        return true;
+    if (changed) {
+        queueStatusUpdate(XTRA_STATUS_UPDATE_MCCMNC);
     }
-
-    stringstream ss;
-    ss <<  "mncmcc";
-    ss << " " << mccmnc.c_str();
-    string s = ss.str();
-    return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
+    return true;
 }
 
 bool XtraSystemStatusObserver::updateXtraThrottle(const bool enabled) {
     mXtraThrottle = enabled;
 
+    queueStatusUpdate(XTRA_STATUS_UPDATE_THROTTLE);
+    return true;
+}
+
+// Until the daemon asks for the status, changes are only kept, it gets them
+// all in respondStatus. After that they are held for XTRA_STATUS_COALESCE_MS,
+// so connection churn and the TAC / MCCMNC updates which usually come with
+// it cost the daemon one wakeup.
+void XtraSystemStatusObserver::queueStatusUpdate(uint32_t updateBit) {
     if (!mReqStatusReceived) {
-        return true;
+        return;
+    }
+
+    if (0 == mPendingUpdates) {
+        mStatusFlushTimer.start(XTRA_STATUS_COALESCE_MS, false,
+                                XTRA_STATUS_COALESCE_MS / 2);
+    }
+    mPendingUpdates |= updateBit;
+}
+
+void XtraSystemStatusObserver::StatusFlushTimer::timeOutCallback() {
+    struct SendPendingStatusMsg : public LocMsg {
+        XtraSystemStatusObserver& mXSSO;
+        inline SendPendingStatusMsg(XtraSystemStatusObserver& xsso) :
+                mXSSO(xsso) {}
+        inline void proc() const override {
+            mXSSO.sendPendingStatus();
+        }
+    };
+    mXSSO.getMsgTask()->sendMsg(new SendPendingStatusMsg(mXSSO));
+}
+
+void XtraSystemStatusObserver::sendPendingStatus() {
+    uint32_t pending = mPendingUpdates;
+    mPendingUpdates = 0;
+
+    // respondStatus does not carry the throttle setting
+    if (pending & XTRA_STATUS_UPDATE_THROTTLE) {
+        sendStatus(XTRA_STATUS_UPDATE_THROTTLE);
+        pending &= ~XTRA_STATUS_UPDATE_THROTTLE;
     }
 
+    if (0 == pending) {
+        return;
+    }
+    LOC_LOGd("pending status updates 0x%x", pending);
+    if (0 == (pending & (pending - 1))) {
+        sendStatus(pending);
+    } else {
+        // more than one item changed, the full status is one message
+        sendStatusSnapshot();
+    }
+}
+
+bool XtraSystemStatusObserver::sendStatus(uint32_t updateBit) {
     stringstream ss;
-    ss <<  "xtrathrottle";
-    ss << " " << (enabled ? 1 : 0);
+
+    switch (updateBit) {
+    case XTRA_STATUS_UPDATE_LOCK:
+        ss << "gpslock" << " " << mGpsLock;
+        break;
+    case XTRA_STATUS_UPDATE_CONNECTIONS:
+        ss << "connection" << endl;
+        formatConnections(ss);
+        break;
+    case XTRA_STATUS_UPDATE_TAC:
+        ss << "tac" << " " << mTac.c_str();
+        break;
+    case XTRA_STATUS_UPDATE_MCCMNC:
+        ss << "mncmcc" << " " << mMccmnc.c_str();
+        break;
+    case XTRA_STATUS_UPDATE_THROTTLE:
+        ss << "xtrathrottle" << " " << (mXtraThrottle ? 1 : 0);
+        break;
+    default:
+        return false;
+    }
+
     string s = ss.str();
     return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
 }
 
-inline bool XtraSystemStatusObserver::onStatusRequested(int32_t xtraStatusUpdated) {
-    mReqStatusReceived = true;
-
-    if (xtraStatusUpdated) {
-        return true;
+void XtraSystemStatusObserver::formatConnections(stringstream& ss) {
+    (mConnections == (uint64_t)~0 ? ss : ss << mConnections) << endl;
+    for (uint8_t i = 0; i < MAX_NETWORK_HANDLES - 1; ++i) {
+        ss << mNetworkHandle[i].toString() << endl;
     }
+    ss << mNetworkHandle[MAX_NETWORK_HANDLES-1].toString();
+}
 
+bool XtraSystemStatusObserver::sendStatusSnapshot() {
     stringstream ss;
 
     ss << "respondStatus" << endl;
     (mGpsLock == -1 ? ss : ss << mGpsLock) << endl;
-    (mConnections == (uint64_t)~0 ? ss : ss << mConnections) << endl
-            << mNetworkHandle[0].toString() << endl
-            << mNetworkHandle[1].toString() << endl
-            << mNetworkHandle[2].toString() << endl
-            << mNetworkHandle[3].toString() << endl
-            << mNetworkHandle[4].toString() << endl
-            << mNetworkHandle[5].toString() << endl
-            << mNetworkHandle[6].toString() << endl
-            << mNetworkHandle[7].toString() << endl
-            << mNetworkHandle[8].toString() << endl
-            << mNetworkHandle[MAX_NETWORK_HANDLES-1].toString() << endl
-            << mTac << endl << mMccmnc << endl << mIsConnectivityStatusKnown;
+    formatConnections(ss);
+    ss << endl << mTac << endl << mMccmnc << endl << mIsConnectivityStatusKnown;
 
     string s = ss.str();
     return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
 }
 
+inline bool XtraSystemStatusObserver::onStatusRequested(int32_t xtraStatusUpdated) {
+    mReqStatusReceived = true;
+
+    if (xtraStatusUpdated) {
+        return true;
+    }
+
+    // the snapshot covers whatever was still held back, except the throttle
+    mPendingUpdates &= XTRA_STATUS_UPDATE_THROTTLE;
+    if (0 == mPendingUpdates) {
+        mStatusFlushTimer.stop();
+    }
+    return sendStatusSnapshot();
+}
+
 void XtraSystemStatusObserver::startDgnssSource(const StartDgnssNtripParams& params) {
     stringstream ss;
     const GnssNtripConnectionParams* ntripParams = &(params.ntripParams);
@@ -254,15 +308,14 @@ void XtraSystemStatusObserver::startDgnssSource(const StartDgnssNtripParams& par
     string s = ss.str();
 
     LOC_LOGd("%s", s.data());
-    LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size());
     // make a local copy of the string for SSR
-    mNtripParamsString.assign(std::move(s));
+    mNtripParamsString = s;
+    sendDgnssMsg(std::move(s), false);
 }
 
 void XtraSystemStatusObserver::restartDgnssSource() {
     if (!mNtripParamsString.empty()) {
-        LocIpc::send(*mSender,
-            (const uint8_t*)mNtripParamsString.data(), mNtripParamsString.size());
+        sendDgnssMsg(string(mNtripParamsString), false);
         LOC_LOGv("Xtra SSR %s", mNtripParamsString.data());
     }
 }
@@ -271,19 +324,85 @@ void XtraSystemStatusObserver::stopDgnssSource() {
     LOC_LOGv();
     mNtripParamsString.clear();
 
-    const char s[] = "stopDgnssSource";
-    LocIpc::send(*mSender, (const uint8_t*)s, strlen(s));
+    sendDgnssMsg(string("stopDgnssSource"), false);
 }
 
 void XtraSystemStatusObserver::updateNmeaToDgnssServer(const string& nmea)
 {
-    stringstream ss;
-    ss <<  "updateDgnssServerNmea" << endl;
-    ss << nmea.data() << endl;
+    static const char header[] = "updateDgnssServerNmea\n";
+    string msg;
+    msg.reserve(sizeof(header) + nmea.size());
+    msg.assign(header, sizeof(header) - 1);
+    msg.append(nmea).append(1, '\n');
+
+    LOC_LOGd("%s", msg.data());
+    sendDgnssMsg(std::move(msg), true);
+}
 
-    string s = ss.str();
-    LOC_LOGd("%s", s.data());
-    LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size());
+static inline uint64_t dgnssMonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void XtraSystemStatusObserver::sendDgnssMsg(string&& msg, bool isGga) {
+    struct DgnssIpcMsg : public LocMsg {
+        XtraSystemStatusObserver& mXSSO;
+        shared_ptr<LocIpcSender> mSender;
+        string mMsg;
+        bool mIsGga;
+        // MsgTask times the msg queued for a slot, not a conflated one in it
+        uint64_t mQueuedNs;
+        inline DgnssIpcMsg(XtraSystemStatusObserver& xsso,
+                           const shared_ptr<LocIpcSender>& sender,
+                           string&& msg, bool isGga) :
+                mXSSO(xsso), mSender(sender), mMsg(std::move(msg)), mIsGga(isGga),
+                mQueuedNs(dgnssMonotonicNs()) {}
+        inline void proc() const override {
+            bool sent = LocIpc::send(*mSender, (const uint8_t*)mMsg.data(), mMsg.size());
+            mXSSO.onDgnssMsgSent(mIsGga, mMsg.size(), sent, mQueuedNs);
+        }
+    };
+
+    if (nullptr == mDgnssMsgTask) {
+        mDgnssMsgTask.reset(new MsgTask("LocDgnssIpc"));
+    }
+    DgnssIpcMsg* ipcMsg = new DgnssIpcMsg(*this, mSender, std::move(msg), isGga);
+    if (isGga) {
+        mDgnssMsgTask->sendConflatedMsg(mDgnssGgaSlot, ipcMsg);
+    } else {
+        mDgnssMsgTask->sendMsg(ipcMsg);
+    }
+}
+
+// on the DGNSS message thread
+void XtraSystemStatusObserver::onDgnssMsgSent(bool isGga, size_t length, bool sent,
+                                              uint64_t queuedNs) {
+    if (!sent) {
+        mDgnssIpcStats.mFailed.fetch_add(1, memory_order_relaxed);
+        LOC_LOGw("DGNSS %s message to xtra-daemon failed", isGga ? "GGA" : "control");
+    } else {
+        (isGga ? mDgnssIpcStats.mGgaMsgs : mDgnssIpcStats.mControlMsgs).fetch_add(
+                1, memory_order_relaxed);
+        mDgnssIpcStats.mBytes.fetch_add(length, memory_order_relaxed);
+    }
+    uint64_t nowNs = dgnssMonotonicNs();
+    if (nowNs > queuedNs) {
+        mDgnssIpcStats.mLatencyUs.record((nowNs - queuedNs) / 1000);
+    }
+}
+
+void XtraSystemStatusObserver::dumpStats(string& out) const {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "DGNSS IPC: control=%" PRIu64 " gga=%" PRIu64
+             " bytes=%" PRIu64 " failed=%" PRIu64 "\n  latency: ",
+             mDgnssIpcStats.mControlMsgs.load(memory_order_relaxed),
+             mDgnssIpcStats.mGgaMsgs.load(memory_order_relaxed),
+             mDgnssIpcStats.mBytes.load(memory_order_relaxed),
+             mDgnssIpcStats.mFailed.load(memory_order_relaxed));
+    out += buf;
+    mDgnssIpcStats.mLatencyUs.dump(out, "us");
+    out += "\n";
 }
 
 void XtraSystemStatusObserver::subscribe(bool yes)
@@ -30,10 +30,14 @@
 #define XTRA_SYSTEM_STATUS_OBS_H
 
 #include <cinttypes>
+#include <atomic>
+#include <memory>
 #include <MsgTask.h>
 #include <LocIpc.h>
 #include <LocTimer.h>
+#include <LocHistogram.h>
 #include <stdlib.h>
+#include <sstream>
 
 using namespace std;
 using namespace loc_util;
@@ -57,12 +61,17 @@ struct StartDgnssNtripParams {
     }
 };
 
+// Status updates to xtra-daemon are held this long, so that a burst of
+// changes goes out as one message
+#define XTRA_STATUS_COALESCE_MS 200
+
 class XtraSystemStatusObserver : public IDataItemObserver {
 public :
     // constructor & destructor
     XtraSystemStatusObserver(IOsObserver* sysStatObs, const MsgTask* msgTask);
     inline virtual ~XtraSystemStatusObserver() {
         subscribe(false);
+        mStatusFlushTimer.stop();
         mIpc.stopNonBlockingListening();
     }
 
@@ -83,8 +92,24 @@ public :
     void restartDgnssSource();
     void stopDgnssSource();
     void updateNmeaToDgnssServer(const string& nmea);
+    void sendPendingStatus();
+    // appends the DGNSS message counters and latencies, callable from any thread
+    void dumpStats(string& out) const;
 
 private:
+    // what changed since the last message to xtra-daemon
+    enum XtraStatusUpdateBits {
+        XTRA_STATUS_UPDATE_LOCK        = (1<<0),
+        XTRA_STATUS_UPDATE_CONNECTIONS = (1<<1),
+        XTRA_STATUS_UPDATE_TAC         = (1<<2),
+        XTRA_STATUS_UPDATE_MCCMNC      = (1<<3),
+        XTRA_STATUS_UPDATE_THROTTLE    = (1<<4),
+    };
+    void queueStatusUpdate(uint32_t updateBit);
+    bool sendStatus(uint32_t updateBit);
+    bool sendStatusSnapshot();
+    void formatConnections(stringstream& ss);
+
     IOsObserver*    mSystemStatusObsrvr;
     const MsgTask* mMsgTask;
     GnssConfigGpsLock mGpsLock;
@@ -98,6 +123,7 @@ private:
     bool mIsConnectivityStatusKnown;
     shared_ptr<LocIpcSender> mSender;
     string mNtripParamsString;
+    uint32_t mPendingUpdates;
 
     class DelayLocTimer : public LocTimer {
         LocIpcSender& mSender;
@@ -107,6 +133,33 @@ private:
             LocIpc::send(mSender, (const uint8_t*)"halinit", sizeof("halinit"));
         }
     } mDelayLocTimer;
+
+    class StatusFlushTimer : public LocTimer {
+        XtraSystemStatusObserver& mXSSO;
+    public:
+        StatusFlushTimer(XtraSystemStatusObserver& xsso) : mXSSO(xsso) {}
+        void timeOutCallback() override;
+    } mStatusFlushTimer;
+
+    // The DGNSS source messages go to xtra-daemon on a thread of their own,
+    // in order, so a backed up daemon socket does not stall the position
+    // reports the GGA updates are sent from. A GGA update not sent yet is
+    // replaced by the next one.
+    struct DgnssIpcStats {
+        atomic<uint64_t> mControlMsgs;
+        atomic<uint64_t> mGgaMsgs;
+        atomic<uint64_t> mBytes;
+        atomic<uint64_t> mFailed;
+        // from queueing the message until its send returned, in usec
+        LocHistogram mLatencyUs;
+        inline DgnssIpcStats() : mControlMsgs(0), mGgaMsgs(0), mBytes(0), mFailed(0) {}
+    };
+    void sendDgnssMsg(string&& msg, bool isGga);
+    void onDgnssMsgSent(bool isGga, size_t length, bool sent, uint64_t queuedNs);
+    DgnssIpcStats mDgnssIpcStats;
+    LocMsgSlot mDgnssGgaSlot;
+    // created with the first DGNSS source start, destroyed ahead of the slot
+    unique_ptr<MsgTask> mDgnssMsgTask;
 };
 
 #endif
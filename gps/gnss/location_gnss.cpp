@@ -66,6 +66,7 @@ static void agpsDataConnOpen(AGpsExtType agpsType, const char* apnName, int apnL
 static void agpsDataConnClosed(AGpsExtType agpsType);
 static void agpsDataConnFailed(AGpsExtType agpsType);
 static void getDebugReport(GnssDebugReport& report);
+static uint64_t getDebugReportGeneration();
 static void updateConnectionStatus(bool connected, int8_t type, bool roaming,
                                    NetworkHandle networkHandle, string& apn);
 static void getGnssEnergyConsumed(GnssEnergyConsumedCallback energyConsumedCb);
@@ -99,11 +100,12 @@ static void enablePPENtripStream(const GnssNtripConnectionParams& params, bool e
 static void disablePPENtripStream();
 
 static bool measCorrInit(const measCorrSetCapabilitiesCb setCapabilitiesCb);
-static bool measCorrSetCorrections(const GnssMeasurementCorrections gnssMeasCorr);
+static bool measCorrSetCorrections(GnssMeasurementCorrections gnssMeasCorr);
 static void measCorrClose();
 static uint32_t antennaInfoInit(const antennaInfoCb antennaInfoCallback);
 static void antennaInfoClose();
 static uint32_t configEngineRunState(PositioningEngineMask engType, LocEngineRunState engState);
+static void dumpStats(std::string& out);
 
 static const GnssInterface gGnssInterface = {
     sizeof(GnssInterface),
@@ -162,7 +164,9 @@ static const GnssInterface gGnssInterface = {
     gnssUpdateSecondaryBandConfig,
     gnssGetSecondaryBandConfig,
     resetNetworkInfo,
-    configEngineRunState
+    configEngineRunState,
+    dumpStats,
+    getDebugReportGeneration
 };
 
 #ifndef DEBUG_X86
@@ -370,6 +374,14 @@ static void getDebugReport(GnssDebugReport& report) {
     }
 }
 
+static uint64_t getDebugReportGeneration() {
+
+    if (NULL != gGnssAdapter) {
+        return gGnssAdapter->getDebugReportGeneration();
+    }
+    return 0;
+}
+
 static void updateConnectionStatus(bool connected, int8_t type,
                                    bool roaming, NetworkHandle networkHandle,
                                    string& apn) {
@@ -494,9 +506,10 @@ static bool measCorrInit(const measCorrSetCapabilitiesCb setCapabilitiesCb) {
     }
 }
 
-static bool measCorrSetCorrections(const GnssMeasurementCorrections gnssMeasCorr) {
+// taken by value as GnssInterface declares it, moved on from there
+static bool measCorrSetCorrections(GnssMeasurementCorrections gnssMeasCorr) {
     if (NULL != gGnssAdapter) {
-        return gGnssAdapter->measCorrSetCorrectionsCommand(gnssMeasCorr);
+        return gGnssAdapter->measCorrSetCorrectionsCommand(std::move(gnssMeasCorr));
     } else {
         return false;
     }
@@ -591,3 +604,9 @@ static uint32_t configEngineRunState(PositioningEngineMask engType, LocEngineRun
         return 0;
     }
 }
+
+static void dumpStats(std::string& out) {
+    if (NULL != gGnssAdapter) {
+        gGnssAdapter->dumpStats(out);
+    }
+}
@@ -34,7 +34,10 @@
 #include <log_util.h>
 #include <pthread.h>
 #include <map>
+#include <set>
+#include <loc_cfg.h>
 #include <loc_misc_utils.h>
+#include <LocTimer.h>
 
 typedef const GnssInterface* (getGnssInterface)();
 typedef const GeofenceInterface* (getGeofenceInterface)();
@@ -62,6 +65,8 @@ typedef std::map<LocationAPI*, LocationAPIDestroyCbData>
     LocationClientDestroyCbMap;
 
 typedef std::map<LocationAPI*, LocationCallbacks> LocationClientMap;
+// batching session or geofence ids of the clients
+typedef std::set<std::pair<LocationAPI*, uint32_t>> LocationSessionSet;
 typedef struct {
     LocationClientMap clientData;
     LocationClientDestroyCbMap destroyClientData;
@@ -70,10 +75,24 @@ typedef struct {
     GnssInterface* gnssInterface;
     GeofenceInterface* geofenceInterface;
     BatchingInterface* batchingInterface;
+    LocationSessionSet batchingSessions;
+    LocationSessionSet geofences;
 } LocationAPIData;
 
 static LocationAPIData gData = {};
-static pthread_mutex_t gDataMutex = PTHREAD_MUTEX_INITIALIZER;
+// gDataLock guards gData. The API calls only look clients and interfaces up, so they
+// share it, and only adding, updating and destroying clients takes it exclusively.
+// gLoadMutex serializes the one time interface loads and the OS framework refcount
+// outside of gDataLock, so a first time dlopen does not stall the calls of the clients
+// already registered. Remove client completions only touch destroyClientData, which
+// has a lock of its own, so the adapter threads never wait on gDataLock either.
+// gSessionMutex guards batchingSessions and geofences, which the API calls update
+// while sharing gDataLock.
+// Lock order: gLoadMutex, gDataLock, gDestroyCbMutex, gSessionMutex.
+static pthread_rwlock_t gDataLock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t gLoadMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t gDestroyCbMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t gSessionMutex = PTHREAD_MUTEX_INITIALIZER;
 static bool gGnssLoadFailed = false;
 static bool gBatchingLoadFailed = false;
 static bool gGeofenceLoadFailed = false;
@@ -112,6 +131,156 @@ static void destroyOSFrameworkInstance() {
     }
 }
 
+static bool isGnssClient(LocationCallbacks& locationCallbacks);
+
+// Loads and initializes an interface on first use. The pointer is only ever written with
+// both gLoadMutex and gDataLock held, so reading it under either one is safe.
+// isClient, if given, picks the clients registered so far to add to the interface; those
+// not getting capabilities from the gnss interface have them requested here.
+template <typename T1, typename T2>
+static void loadInterfaceOnce(T1*& locInterface, bool& loadFailed,
+                              const char* library, const char* name,
+                              bool (*isClient)(LocationCallbacks&) = nullptr)
+{
+    pthread_mutex_lock(&gLoadMutex);
+    if (NULL == locInterface && !loadFailed) {
+        T1* loadedInterface = (T1*)loadLocationInterface<T1, T2>(library, name);
+        if (NULL == loadedInterface) {
+            loadFailed = true;
+            LOC_LOGW("%s:%d]: No interface available in %s", __func__, __LINE__, library);
+        } else {
+            loadedInterface->initialize();
+            pthread_rwlock_wrlock(&gDataLock);
+            locInterface = loadedInterface;
+            for (auto& client : gData.clientData) {
+                if (nullptr != isClient && isClient(client.second)) {
+                    loadedInterface->addClient(client.first, client.second);
+                    if (!isGnssClient(client.second)) {
+                        loadedInterface->requestCapabilities(client.first);
+                    }
+                }
+            }
+            pthread_rwlock_unlock(&gDataLock);
+        }
+    }
+    pthread_mutex_unlock(&gLoadMutex);
+}
+
+static inline void loadGnssInterface()
+{
+    loadInterfaceOnce<GnssInterface, getGnssInterface>(
+            gData.gnssInterface, gGnssLoadFailed, "libgnss.so", "getGnssInterface");
+}
+
+static bool isBatchingClient(LocationCallbacks& locationCallbacks);
+static bool isGeofenceClient(LocationCallbacks& locationCallbacks);
+
+// The batching and geofence interfaces, and the adapters behind them, are only started
+// by the first startBatching / addGeofences, not when a client registers for them.
+static inline void loadBatchingInterface()
+{
+    loadInterfaceOnce<BatchingInterface, getBatchingInterface>(
+            gData.batchingInterface, gBatchingLoadFailed, "libbatching.so",
+            "getBatchingInterface", isBatchingClient);
+}
+
+static inline void loadGeofenceInterface()
+{
+    loadInterfaceOnce<GeofenceInterface, getGeofenceInterface>(
+            gData.geofenceInterface, gGeofenceLoadFailed, "libgeofencing.so",
+            "getGeofenceInterface", isGeofenceClient);
+}
+
+// seconds without batching sessions / geofences before the interface is torn down again,
+// LOCATION_INTERFACE_IDLE_SEC in gps.conf; 0 keeps it up
+static uint32_t getInterfaceIdleSec()
+{
+    static uint32_t sIdleSec = []() {
+        uint32_t idleSec = 0;
+        loc_param_s_type idleConfTable[] =
+        {
+            {"LOCATION_INTERFACE_IDLE_SEC", &idleSec, NULL, 'n'},
+        };
+        loc_read_conf(LOC_PATH_GPS_CONF_STR, idleConfTable,
+                sizeof(idleConfTable)/sizeof(idleConfTable[0]));
+        return idleSec;
+    }();
+    return sIdleSec;
+}
+
+// Deinitializes an interface that has no sessions left. The adapter behind it deletes
+// itself after the msgs queued for it, and is created anew by the next request.
+template <typename T>
+static void unloadIdleInterface(T*& locInterface, const LocationSessionSet& sessions)
+{
+    pthread_mutex_lock(&gLoadMutex);
+    pthread_rwlock_wrlock(&gDataLock);
+    pthread_mutex_lock(&gSessionMutex);
+    T* idleInterface = sessions.empty() ? locInterface : NULL;
+    pthread_mutex_unlock(&gSessionMutex);
+    if (NULL != idleInterface) {
+        LOC_LOGd("interface %p idle, deinitializing", idleInterface);
+        locInterface = NULL;
+        idleInterface->deinitialize();
+    }
+    pthread_rwlock_unlock(&gDataLock);
+    pthread_mutex_unlock(&gLoadMutex);
+}
+
+class InterfaceIdleTimer : public loc_util::LocTimer {
+    void (*mOnIdle)();
+public:
+    inline InterfaceIdleTimer(void (*onIdle)()) : mOnIdle(onIdle) {}
+    inline virtual void timeOutCallback() override { mOnIdle(); }
+};
+
+static void unloadIdleBatchingInterface()
+{
+    unloadIdleInterface(gData.batchingInterface, gData.batchingSessions);
+}
+
+static void unloadIdleGeofenceInterface()
+{
+    unloadIdleInterface(gData.geofenceInterface, gData.geofences);
+}
+
+static InterfaceIdleTimer gBatchingIdleTimer(unloadIdleBatchingInterface);
+static InterfaceIdleTimer gGeofenceIdleTimer(unloadIdleGeofenceInterface);
+
+// Adds and removes session ids of a client; arms the idle timer once none are left.
+// client only with no ids removes all of the client's ids.
+static void updateSessions(LocationSessionSet& sessions, InterfaceIdleTimer& idleTimer,
+                           LocationAPI* client, size_t count, const uint32_t* ids, bool add)
+{
+    uint32_t idleSec = getInterfaceIdleSec();
+    pthread_mutex_lock(&gSessionMutex);
+    bool wasEmpty = sessions.empty();
+    if (add) {
+        for (size_t i = 0; i < count; i++) {
+            if (0 != ids[i]) {
+                sessions.insert(std::make_pair(client, ids[i]));
+            }
+        }
+    } else if (NULL == ids) {
+        auto it = sessions.lower_bound(std::make_pair(client, (uint32_t)0));
+        while (it != sessions.end() && it->first == client) {
+            it = sessions.erase(it);
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            sessions.erase(std::make_pair(client, ids[i]));
+        }
+    }
+    if (idleSec > 0) {
+        if (wasEmpty && !sessions.empty()) {
+            idleTimer.stop();
+        } else if (!wasEmpty && sessions.empty()) {
+            idleTimer.start(idleSec * 1000, false, idleSec * 100);
+        }
+    }
+    pthread_mutex_unlock(&gSessionMutex);
+}
+
 static bool needsGnssTrackingInfo(LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.gnssLocationInfoCb != nullptr ||
@@ -152,7 +321,7 @@ void LocationAPI::onRemoveClientCompleteCb (LocationAdapterTypeMask adapterType)
     bool invokeCallback = false;
     locationApiDestroyCompleteCallback destroyCompleteCb;
     LOC_LOGd("adatper type %x", adapterType);
-    pthread_mutex_lock(&gDataMutex);
+    pthread_mutex_lock(&gDestroyCbMutex);
     auto it = gData.destroyClientData.find(this);
     if (it != gData.destroyClientData.end()) {
         it->second.waitAdapterMask &= ~adapterType;
@@ -162,7 +331,7 @@ void LocationAPI::onRemoveClientCompleteCb (LocationAdapterTypeMask adapterType)
             gData.destroyClientData.erase(it);
         }
     }
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_mutex_unlock(&gDestroyCbMutex);
 
     if (invokeCallback) {
         LOC_LOGd("invoke client destroy cb");
@@ -202,79 +371,51 @@ LocationAPI::createInstance (LocationCallbacks& locationCallbacks)
     LocationAPI* newLocationAPI = new LocationAPI();
     bool requestedCapabilities = false;
 
-    pthread_mutex_lock(&gDataMutex);
-
+    pthread_mutex_lock(&gLoadMutex);
     gOSFrameworkRefCount++;
     if (1 == gOSFrameworkRefCount) {
         createOSFrameworkInstance();
     }
+    pthread_mutex_unlock(&gLoadMutex);
 
-    if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            gData.gnssInterface->addClient(newLocationAPI, locationCallbacks);
-            if (!requestedCapabilities) {
-                gData.gnssInterface->requestCapabilities(newLocationAPI);
-                requestedCapabilities = true;
-            }
-        }
+    bool gnssClient = isGnssClient(locationCallbacks);
+    bool batchingClient = isBatchingClient(locationCallbacks);
+    bool geofenceClient = isGeofenceClient(locationCallbacks);
+    if (gnssClient) {
+        loadGnssInterface();
     }
 
-    if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
-            gData.batchingInterface->addClient(newLocationAPI, locationCallbacks);
-            if (!requestedCapabilities) {
-                gData.batchingInterface->requestCapabilities(newLocationAPI);
-                requestedCapabilities = true;
-            }
+    pthread_rwlock_wrlock(&gDataLock);
+
+    if (gnssClient && NULL != gData.gnssInterface) {
+        gData.gnssInterface->addClient(newLocationAPI, locationCallbacks);
+        if (!requestedCapabilities) {
+            gData.gnssInterface->requestCapabilities(newLocationAPI);
+            requestedCapabilities = true;
         }
     }
 
-    if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-               (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-               getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
+    if (batchingClient && NULL != gData.batchingInterface) {
+        gData.batchingInterface->addClient(newLocationAPI, locationCallbacks);
+        if (!requestedCapabilities) {
+            gData.batchingInterface->requestCapabilities(newLocationAPI);
+            requestedCapabilities = true;
         }
-        if (NULL != gData.geofenceInterface) {
-            gData.geofenceInterface->addClient(newLocationAPI, locationCallbacks);
-            if (!requestedCapabilities) {
-                gData.geofenceInterface->requestCapabilities(newLocationAPI);
-                requestedCapabilities = true;
-            }
+    }
+
+    if (geofenceClient && NULL != gData.geofenceInterface) {
+        gData.geofenceInterface->addClient(newLocationAPI, locationCallbacks);
+        if (!requestedCapabilities) {
+            gData.geofenceInterface->requestCapabilities(newLocationAPI);
+            requestedCapabilities = true;
         }
     }
+    // a batching or geofence only client, with the interface not loaded yet, gets its
+    // capabilities once the first startBatching / addGeofences loads it
 
     gData.clientData[newLocationAPI] = locationCallbacks;
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 
     return newLocationAPI;
 }
@@ -284,7 +425,7 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
 {
     bool invokeDestroyCb = false;
 
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_wrlock(&gDataLock);
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
         bool removeFromGnssInf = (NULL != gData.gnssInterface);
@@ -307,7 +448,9 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
                     (removeFromBatchingInf ? LOCATION_ADAPTER_BATCHING_TYPE_BIT : 0);
             destroyCbData.waitAdapterMask |=
                     (removeFromGeofenceInf ? LOCATION_ADAPTER_GEOFENCE_TYPE_BIT : 0);
+            pthread_mutex_lock(&gDestroyCbMutex);
             gData.destroyClientData[this] = destroyCbData;
+            pthread_mutex_unlock(&gDestroyCbMutex);
             LOC_LOGi("destroy data stored in the map: 0x%x", destroyCbData.waitAdapterMask);
         }
 
@@ -325,6 +468,8 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
         }
 
         gData.clientData.erase(it);
+        updateSessions(gData.batchingSessions, gBatchingIdleTimer, this, 0, NULL, false);
+        updateSessions(gData.geofences, gGeofenceIdleTimer, this, 0, NULL, false);
 
         if (!needToWait) {
             invokeDestroyCb = true;
@@ -334,12 +479,15 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
                  __func__, __LINE__, this);
     }
 
+    pthread_rwlock_unlock(&gDataLock);
+
+    pthread_mutex_lock(&gLoadMutex);
     if (1 == gOSFrameworkRefCount) {
         destroyOSFrameworkInstance();
     }
     gOSFrameworkRefCount--;
+    pthread_mutex_unlock(&gLoadMutex);
 
-    pthread_mutex_unlock(&gDataMutex);
     if (invokeDestroyCb) {
         if (!destroyCompleteCb) {
             (destroyCompleteCb) ();
@@ -368,72 +516,36 @@ LocationAPI::updateCallbacks(LocationCallbacks& locationCallbacks)
         return;
     }
 
-    pthread_mutex_lock(&gDataMutex);
-
-    if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            // either adds new Client or updates existing Client
-            gData.gnssInterface->addClient(this, locationCallbacks);
-        }
+    bool gnssClient = isGnssClient(locationCallbacks);
+    bool batchingClient = isBatchingClient(locationCallbacks);
+    bool geofenceClient = isGeofenceClient(locationCallbacks);
+    if (gnssClient) {
+        loadGnssInterface();
     }
 
-    if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
-            // either adds new Client or updates existing Client
-            gData.batchingInterface->addClient(this, locationCallbacks);
-        }
-    }
+    pthread_rwlock_wrlock(&gDataLock);
 
-    if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-                (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-                 getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
-            // either adds new Client or updates existing Client
-            gData.geofenceInterface->addClient(this, locationCallbacks);
-        }
+    // either adds new Client or updates existing Client
+    if (gnssClient && NULL != gData.gnssInterface) {
+        gData.gnssInterface->addClient(this, locationCallbacks);
+    }
+    if (batchingClient && NULL != gData.batchingInterface) {
+        gData.batchingInterface->addClient(this, locationCallbacks);
+    }
+    if (geofenceClient && NULL != gData.geofenceInterface) {
+        gData.geofenceInterface->addClient(this, locationCallbacks);
     }
 
     gData.clientData[this] = locationCallbacks;
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t
 LocationAPI::startTracking(TrackingOptions& trackingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
@@ -448,14 +560,14 @@ LocationAPI::startTracking(TrackingOptions& trackingOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 void
 LocationAPI::stopTracking(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
@@ -470,14 +582,14 @@ LocationAPI::stopTracking(uint32_t id)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::updateTrackingOptions(
         uint32_t id, TrackingOptions& trackingOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
@@ -492,45 +604,48 @@ LocationAPI::updateTrackingOptions(
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t
 LocationAPI::startBatching(BatchingOptions &batchingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    loadBatchingInterface();
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.batchingInterface) {
         id = gData.batchingInterface->startBatching(this, batchingOptions);
+        updateSessions(gData.batchingSessions, gBatchingIdleTimer, this, 1, &id, true);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 void
 LocationAPI::stopBatching(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.batchingInterface) {
         gData.batchingInterface->stopBatching(this, id);
+        updateSessions(gData.batchingSessions, gBatchingIdleTimer, this, 1, &id, false);
     } else {
         LOC_LOGE("%s:%d]: No batching interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::updateBatchingOptions(uint32_t id, BatchingOptions& batchOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.batchingInterface) {
         gData.batchingInterface->updateBatchingOptions(this, id, batchOptions);
@@ -539,13 +654,13 @@ LocationAPI::updateBatchingOptions(uint32_t id, BatchingOptions& batchOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::getBatchedLocations(uint32_t id, size_t count)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.batchingInterface != NULL) {
         gData.batchingInterface->getBatchedLocations(this, id, count);
@@ -554,45 +669,52 @@ LocationAPI::getBatchedLocations(uint32_t id, size_t count)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t*
 LocationAPI::addGeofences(size_t count, GeofenceOption* options, GeofenceInfo* info)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    loadGeofenceInterface();
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         ids = gData.geofenceInterface->addGeofences(this, count, options, info);
+        if (NULL != ids) {
+            updateSessions(gData.geofences, gGeofenceIdleTimer, this, count, ids, true);
+        }
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return ids;
 }
 
 void
 LocationAPI::removeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->removeGeofences(this, count, ids);
+        if (NULL != ids) {
+            updateSessions(gData.geofences, gGeofenceIdleTimer, this, count, ids, false);
+        }
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::modifyGeofences(size_t count, uint32_t* ids, GeofenceOption* options)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->modifyGeofences(this, count, ids, options);
@@ -601,13 +723,13 @@ LocationAPI::modifyGeofences(size_t count, uint32_t* ids, GeofenceOption* option
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::pauseGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->pauseGeofences(this, count, ids);
@@ -616,13 +738,13 @@ LocationAPI::pauseGeofences(size_t count, uint32_t* ids)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::resumeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->resumeGeofences(this, count, ids);
@@ -631,13 +753,37 @@ LocationAPI::resumeGeofences(size_t count, uint32_t* ids)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
+}
+
+void
+LocationAPI::dumpStats(LocationAdapterTypeMask adapterTypes, std::string& out)
+{
+    // holding gDataLock keeps an idle interface from being deinitialized meanwhile
+    pthread_rwlock_rdlock(&gDataLock);
+
+    if (adapterTypes & LOCATION_ADAPTER_BATCHING_TYPE_BIT) {
+        if (NULL == gData.batchingInterface) {
+            out += "Batching: not loaded\n";
+        } else if (NULL != gData.batchingInterface->dumpStats) {
+            gData.batchingInterface->dumpStats(out);
+        }
+    }
+    if (adapterTypes & LOCATION_ADAPTER_GEOFENCE_TYPE_BIT) {
+        if (NULL == gData.geofenceInterface) {
+            out += "Geofence: not loaded\n";
+        } else if (NULL != gData.geofenceInterface->dumpStats) {
+            gData.geofenceInterface->dumpStats(out);
+        }
+    }
+
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::gnssNiResponse(uint32_t id, GnssNiResponse response)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         gData.gnssInterface->gnssNiResponse(this, id, response);
@@ -646,7 +792,7 @@ LocationAPI::gnssNiResponse(uint32_t id, GnssNiResponse response)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void LocationAPI::enableNetworkProvider() {
@@ -699,20 +845,12 @@ LocationControlAPI*
 LocationControlAPI::createInstance(LocationControlCallbacks& locationControlCallbacks)
 {
     LocationControlAPI* controlAPI = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    if (nullptr != locationControlCallbacks.responseCb) {
+        loadGnssInterface();
+    }
+    pthread_rwlock_wrlock(&gDataLock);
 
     if (nullptr != locationControlCallbacks.responseCb && NULL == gData.controlAPI) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
         if (NULL != gData.gnssInterface) {
             gData.controlAPI = new LocationControlAPI();
             gData.controlCallbacks = locationControlCallbacks;
@@ -721,7 +859,7 @@ LocationControlAPI::createInstance(LocationControlCallbacks& locationControlCall
         }
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return controlAPI;
 }
 
@@ -739,18 +877,18 @@ LocationControlAPI::LocationControlAPI()
 LocationControlAPI::~LocationControlAPI()
 {
     LOC_LOGD("LOCATION CONTROL API DESTRUCTOR");
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_wrlock(&gDataLock);
 
     gData.controlAPI = NULL;
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t
 LocationControlAPI::enable(LocationTechnologyType techType)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->enable(techType);
@@ -759,14 +897,14 @@ LocationControlAPI::enable(LocationTechnologyType techType)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 void
 LocationControlAPI::disable(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         gData.gnssInterface->disable(id);
@@ -775,14 +913,14 @@ LocationControlAPI::disable(uint32_t id)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t*
 LocationControlAPI::gnssUpdateConfig(const GnssConfig& config)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         ids = gData.gnssInterface->gnssUpdateConfig(config);
@@ -791,14 +929,14 @@ LocationControlAPI::gnssUpdateConfig(const GnssConfig& config)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return ids;
 }
 
 uint32_t* LocationControlAPI::gnssGetConfig(GnssConfigFlagsMask mask) {
 
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.gnssInterface) {
         ids = gData.gnssInterface->gnssGetConfig(mask);
@@ -806,7 +944,7 @@ uint32_t* LocationControlAPI::gnssGetConfig(GnssConfigFlagsMask mask) {
         LOC_LOGe("No gnss interface available for Control API client %p", this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return ids;
 }
 
@@ -814,7 +952,7 @@ uint32_t
 LocationControlAPI::gnssDeleteAidingData(GnssAidingData& data)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->gnssDeleteAidingData(data);
@@ -823,7 +961,7 @@ LocationControlAPI::gnssDeleteAidingData(GnssAidingData& data)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
@@ -831,7 +969,7 @@ uint32_t LocationControlAPI::configConstellations(
         const GnssSvTypeConfig& constellationEnablementConfig,
         const GnssSvIdConfig&   blacklistSvConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->gnssUpdateSvConfig(
@@ -840,14 +978,14 @@ uint32_t LocationControlAPI::configConstellations(
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configConstellationSecondaryBand(
         const GnssSvTypeConfig& secondaryBandConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->gnssUpdateSecondaryBandConfig(secondaryBandConfig);
@@ -855,14 +993,14 @@ uint32_t LocationControlAPI::configConstellationSecondaryBand(
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configConstrainedTimeUncertainty(
             bool enable, float tuncThreshold, uint32_t energyBudget) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->setConstrainedTunc(enable,
@@ -872,13 +1010,13 @@ uint32_t LocationControlAPI::configConstrainedTimeUncertainty(
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configPositionAssistedClockEstimator(bool enable) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->setPositionAssistedClockEstimator(enable);
@@ -886,13 +1024,13 @@ uint32_t LocationControlAPI::configPositionAssistedClockEstimator(bool enable) {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configLeverArm(const LeverArmConfigInfo& configInfo) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->configLeverArm(configInfo);
@@ -900,13 +1038,13 @@ uint32_t LocationControlAPI::configLeverArm(const LeverArmConfigInfo& configInfo
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configRobustLocation(bool enable, bool enableForE911) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->configRobustLocation(enable, enableForE911);
@@ -914,13 +1052,13 @@ uint32_t LocationControlAPI::configRobustLocation(bool enable, bool enableForE91
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configMinGpsWeek(uint16_t minGpsWeek) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->configMinGpsWeek(minGpsWeek);
@@ -928,14 +1066,14 @@ uint32_t LocationControlAPI::configMinGpsWeek(uint16_t minGpsWeek) {
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configDeadReckoningEngineParams(
         const DeadReckoningEngineConfig& dreConfig) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->configDeadReckoningEngineParams(dreConfig);
@@ -943,14 +1081,14 @@ uint32_t LocationControlAPI::configDeadReckoningEngineParams(
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 uint32_t LocationControlAPI::configEngineRunState(
         PositioningEngineMask engType, LocEngineRunState engState) {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->configEngineRunState(engType, engState);
@@ -958,7 +1096,7 @@ uint32_t LocationControlAPI::configEngineRunState(
         LOC_LOGe("No gnss interface available for Location Control API");
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
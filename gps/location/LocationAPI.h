@@ -54,6 +54,10 @@ public:
 
     void onRemoveClientCompleteCb (LocationAdapterTypeMask adapterType);
 
+    /* appends the stats of the batching and geofence adapters in adapterTypes,
+       or that they are not loaded, to out. Callable from any thread. */
+    static void dumpStats(LocationAdapterTypeMask adapterTypes, std::string& out);
+
     /* updates/changes the callbacks that will be called.
         mandatory callbacks must be present for callbacks to be successfully updated
         no return value */
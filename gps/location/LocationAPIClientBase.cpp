@@ -37,6 +37,77 @@
 
 #define GEOFENCE_SESSION_ID 0xFFFFFFFF
 #define CONFIG_SESSION_ID 0xFFFFFFFF
+// the assistance server host name points into the caller's memory, so it is not cached
+#define CONFIG_CACHE_FLAGS (~(GnssConfigFlagsMask)GNSS_CONFIG_FLAGS_SET_ASSISTANCE_DATA_VALID_BIT)
+
+// Copies the items of mask that from has into into
+static void mergeGnssConfig(GnssConfig& into, const GnssConfig& from, GnssConfigFlagsMask mask)
+{
+    mask &= (from.flags & CONFIG_CACHE_FLAGS);
+    if (mask & GNSS_CONFIG_FLAGS_GPS_LOCK_VALID_BIT) {
+        into.gpsLock = from.gpsLock;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_SUPL_VERSION_VALID_BIT) {
+        into.suplVersion = from.suplVersion;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_LPP_PROFILE_VALID_BIT) {
+        into.lppProfileMask = from.lppProfileMask;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_LPPE_CONTROL_PLANE_VALID_BIT) {
+        into.lppeControlPlaneMask = from.lppeControlPlaneMask;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_LPPE_USER_PLANE_VALID_BIT) {
+        into.lppeUserPlaneMask = from.lppeUserPlaneMask;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_AGLONASS_POSITION_PROTOCOL_VALID_BIT) {
+        into.aGlonassPositionProtocolMask = from.aGlonassPositionProtocolMask;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_EM_PDN_FOR_EM_SUPL_VALID_BIT) {
+        into.emergencyPdnForEmergencySupl = from.emergencyPdnForEmergencySupl;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_SUPL_EM_SERVICES_BIT) {
+        into.suplEmergencyServices = from.suplEmergencyServices;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_SUPL_MODE_BIT) {
+        into.suplModeMask = from.suplModeMask;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_BLACKLISTED_SV_IDS_BIT) {
+        into.blacklistedSvIds = from.blacklistedSvIds;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_EMERGENCY_EXTENSION_SECONDS_BIT) {
+        into.emergencyExtensionSeconds = from.emergencyExtensionSeconds;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT) {
+        into.robustLocationConfig = from.robustLocationConfig;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_MIN_GPS_WEEK_BIT) {
+        into.minGpsWeek = from.minGpsWeek;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT) {
+        into.minSvElevation = from.minSvElevation;
+    }
+    if (mask & GNSS_CONFIG_FLAGS_CONSTELLATION_SECONDARY_BAND_BIT) {
+        into.secondaryBandConfig = from.secondaryBandConfig;
+    }
+    into.flags |= mask;
+}
+
+// Collective config responses carry one error per bit of mask, low bits first
+static GnssConfigFlagsMask failedConfigFlags(GnssConfigFlagsMask mask,
+                                             size_t count, LocationError* errors)
+{
+    GnssConfigFlagsMask failed = 0;
+    size_t i = 0;
+    for (GnssConfigFlagsMask bit = 1; 0 != bit && i < count; bit <<= 1) {
+        if (mask & bit) {
+            if (LOCATION_ERROR_SUCCESS != errors[i]) {
+                failed |= bit;
+            }
+            i++;
+        }
+    }
+    return failed;
+}
 
 // LocationAPIControlClient
 LocationAPIControlClient::LocationAPIControlClient() :
@@ -49,6 +120,9 @@ LocationAPIControlClient::LocationAPIControlClient() :
     }
 
     memset(&mConfig, 0, sizeof(GnssConfig));
+    GnssConfig emptyConfig = {};
+    emptyConfig.size = sizeof(GnssConfig);
+    mConfigCache = std::make_shared<const GnssConfig>(emptyConfig);
 
     LocationControlCallbacks locationControlCallbacks;
     locationControlCallbacks.size = sizeof(LocationControlCallbacks);
@@ -61,6 +135,10 @@ LocationAPIControlClient::LocationAPIControlClient() :
         [this](size_t count, LocationError* errors, uint32_t* ids) {
             onCtrlCollectiveResponseCb(count, errors, ids);
         };
+    locationControlCallbacks.gnssConfigCb =
+        [this](uint32_t session, const GnssConfig& config) {
+            onCtrlGnssConfigCb(session, config);
+        };
 
     mLocationControlAPI = LocationControlAPI::createInstance(locationControlCallbacks);
 }
@@ -77,6 +155,8 @@ LocationAPIControlClient::~LocationAPIControlClient()
     for (int i = 0; i < CTRL_REQUEST_MAX; i++) {
         mRequestQueues[i].reset((uint32_t)0);
     }
+    // leave no future waiting on a client that is gone
+    completeConfigGets(true);
 
     pthread_mutex_unlock(&mMutex);
 
@@ -90,8 +170,9 @@ uint32_t LocationAPIControlClient::locAPIGnssDeleteAidingData(GnssAidingData& da
     if (mLocationControlAPI) {
         uint32_t session = mLocationControlAPI->gnssDeleteAidingData(data);
         LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, session);
-        mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].reset(session);
-        mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].push(new GnssDeleteAidingDataRequest(*this));
+        mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].setSession(session);
+        mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].push(session,
+                new GnssDeleteAidingDataRequest(*this));
 
         retVal = LOCATION_ERROR_SUCCESS;
     }
@@ -110,8 +191,8 @@ uint32_t LocationAPIControlClient::locAPIEnable(LocationTechnologyType techType)
     } else if (mLocationControlAPI) {
         uint32_t session = mLocationControlAPI->enable(techType);
         LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, session);
-        mRequestQueues[CTRL_REQUEST_CONTROL].reset(session);
-        mRequestQueues[CTRL_REQUEST_CONTROL].push(new EnableRequest(*this));
+        mRequestQueues[CTRL_REQUEST_CONTROL].setSession(session);
+        mRequestQueues[CTRL_REQUEST_CONTROL].push(session, new EnableRequest(*this));
         retVal = LOCATION_ERROR_SUCCESS;
         mEnabled = true;
     } else {
@@ -129,7 +210,7 @@ void LocationAPIControlClient::locAPIDisable()
         uint32_t session = 0;
         session = mRequestQueues[CTRL_REQUEST_CONTROL].getSession();
         if (session > 0) {
-            mRequestQueues[CTRL_REQUEST_CONTROL].push(new DisableRequest(*this));
+            mRequestQueues[CTRL_REQUEST_CONTROL].push(session, new DisableRequest(*this));
             mLocationControlAPI->disable(session);
             mEnabled = false;
         } else {
@@ -153,10 +234,9 @@ uint32_t LocationAPIControlClient::locAPIGnssUpdateConfig(GnssConfig config)
             uint32_t* idArray = mLocationControlAPI->gnssUpdateConfig(config);
             LOC_LOGv("gnssUpdateConfig return array: %p", idArray);
             if (nullptr != idArray) {
-                if (nullptr != mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].getSessionArrayPtr()) {
-                    mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].reset(idArray);
-                }
-                mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].push(new GnssUpdateConfigRequest(*this));
+                // collective responses are correlated by their first session
+                mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].push(idArray[0],
+                        new GnssUpdateConfigRequest(*this, config));
                 retVal = LOCATION_ERROR_SUCCESS;
                 delete [] idArray;
             }
@@ -168,26 +248,120 @@ uint32_t LocationAPIControlClient::locAPIGnssUpdateConfig(GnssConfig config)
 
 uint32_t LocationAPIControlClient::locAPIGnssGetConfig(GnssConfigFlagsMask mask)
 {
-    uint32_t retVal = LOCATION_ERROR_GENERAL_FAILURE;
+    pthread_mutex_lock(&mMutex);
+    uint32_t retVal = gnssGetConfig(mask, nullptr);
+    pthread_mutex_unlock(&mMutex);
+    return retVal;
+}
+
+std::future<GnssConfig> LocationAPIControlClient::locAPIGnssGetConfigAsync(
+        GnssConfigFlagsMask mask)
+{
+    std::shared_ptr<PendingConfigGet> pending = std::make_shared<PendingConfigGet>();
+    pending->mask = mask & CONFIG_CACHE_FLAGS;
+    pending->remaining = pending->mask;
+    std::future<GnssConfig> future = pending->promise.get_future();
 
     pthread_mutex_lock(&mMutex);
+    mPendingConfigGets.push_back(pending);
+    if (LOCATION_ERROR_SUCCESS != gnssGetConfig(mask, pending)) {
+        // nothing was requested, answer from what is known
+        pending->remaining = 0;
+    }
+    completeConfigGets(false);
+    pthread_mutex_unlock(&mMutex);
+    return future;
+}
+
+bool LocationAPIControlClient::locAPIGetCachedConfig(
+        GnssConfigFlagsMask mask, GnssConfig& config) const
+{
+    std::shared_ptr<const GnssConfig> cache = std::atomic_load(&mConfigCache);
+    config = {};
+    config.size = sizeof(GnssConfig);
+    mergeGnssConfig(config, *cache, mask);
+    return (config.flags == mask);
+}
+
+uint32_t LocationAPIControlClient::gnssGetConfig(
+        GnssConfigFlagsMask mask, const std::shared_ptr<PendingConfigGet>& pending)
+{
+    uint32_t retVal = LOCATION_ERROR_GENERAL_FAILURE;
+
     if (mLocationControlAPI) {
 
         uint32_t* idArray = mLocationControlAPI->gnssGetConfig(mask);
         LOC_LOGv("gnssGetConfig return array: %p", idArray);
         if (nullptr != idArray) {
-            if (nullptr != mRequestQueues[CTRL_REQUEST_CONFIG_GET].getSessionArrayPtr()) {
-                mRequestQueues[CTRL_REQUEST_CONFIG_GET].reset(idArray);
-            }
-            mRequestQueues[CTRL_REQUEST_CONFIG_GET].push(new GnssGetConfigRequest(*this));
+            // collective responses are correlated by their first session
+            mRequestQueues[CTRL_REQUEST_CONFIG_GET].push(idArray[0],
+                    new GnssGetConfigRequest(*this, pending));
             retVal = LOCATION_ERROR_SUCCESS;
             delete [] idArray;
         }
     }
-    pthread_mutex_unlock(&mMutex);
     return retVal;
 }
 
+void LocationAPIControlClient::onGnssUpdateConfigResponse(
+        const GnssConfig& config, size_t count, LocationError* errors)
+{
+    GnssConfigFlagsMask failed = failedConfigFlags(config.flags, count, errors);
+    pthread_mutex_lock(&mMutex);
+    updateConfigCache(config, config.flags & ~failed);
+    pthread_mutex_unlock(&mMutex);
+}
+
+void LocationAPIControlClient::onGnssGetConfigResponse(
+        const std::shared_ptr<PendingConfigGet>& pending, size_t count, LocationError* errors)
+{
+    if (nullptr != pending) {
+        GnssConfigFlagsMask failed = failedConfigFlags(pending->mask, count, errors);
+        pthread_mutex_lock(&mMutex);
+        pending->mask &= ~failed;
+        pending->remaining &= ~failed;
+        completeConfigGets(false);
+        pthread_mutex_unlock(&mMutex);
+    }
+}
+
+void LocationAPIControlClient::onCtrlGnssConfigCb(uint32_t session, const GnssConfig& config)
+{
+    LOC_LOGv("session %u flags 0x%x", session, config.flags);
+    pthread_mutex_lock(&mMutex);
+    updateConfigCache(config, config.flags);
+    for (auto& pending : mPendingConfigGets) {
+        pending->remaining &= ~config.flags;
+    }
+    completeConfigGets(false);
+    pthread_mutex_unlock(&mMutex);
+}
+
+void LocationAPIControlClient::updateConfigCache(
+        const GnssConfig& config, GnssConfigFlagsMask mask)
+{
+    if (0 != (mask & CONFIG_CACHE_FLAGS)) {
+        std::shared_ptr<GnssConfig> cache = std::make_shared<GnssConfig>(*mConfigCache);
+        mergeGnssConfig(*cache, config, mask);
+        std::atomic_store(&mConfigCache, std::shared_ptr<const GnssConfig>(cache));
+    }
+}
+
+void LocationAPIControlClient::completeConfigGets(bool all)
+{
+    for (auto it = mPendingConfigGets.begin(); it != mPendingConfigGets.end();) {
+        if (all || 0 == (*it)->remaining) {
+            GnssConfig config = {};
+            config.size = sizeof(GnssConfig);
+            mergeGnssConfig(config, *mConfigCache, (*it)->mask);
+            (*it)->promise.set_value(config);
+            it = mPendingConfigGets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void LocationAPIControlClient::onCtrlResponseCb(LocationError error, uint32_t id)
 {
     if (error != LOCATION_ERROR_SUCCESS) {
@@ -212,7 +386,10 @@ void LocationAPIControlClient::onCtrlCollectiveResponseCb(
             LOC_LOGV("%s:%d] SUCCESS: %d id: %d", __FUNCTION__, __LINE__, errors[i], ids[i]);
         }
     }
-    LocationAPIRequest* request = getRequestBySessionArrayPtr(ids);
+    LocationAPIRequest* request = nullptr;
+    if (count > 0) {
+        request = getRequestByCollectiveSession(ids[0]);
+    }
     if (request) {
         request->onCollectiveResponse(count, errors, ids);
         delete request;
@@ -224,10 +401,9 @@ LocationAPIRequest* LocationAPIControlClient::getRequestBySession(uint32_t sessi
     pthread_mutex_lock(&mMutex);
     LocationAPIRequest* request = nullptr;
 
-    if (mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].getSession() == session) {
-        request = mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].pop();
-    } else if (mRequestQueues[CTRL_REQUEST_CONTROL].getSession() == session) {
-        request = mRequestQueues[CTRL_REQUEST_CONTROL].pop();
+    request = mRequestQueues[CTRL_REQUEST_DELETEAIDINGDATA].pop(session);
+    if (nullptr == request) {
+        request = mRequestQueues[CTRL_REQUEST_CONTROL].pop(session);
     }
 
     pthread_mutex_unlock(&mMutex);
@@ -235,16 +411,14 @@ LocationAPIRequest* LocationAPIControlClient::getRequestBySession(uint32_t sessi
 }
 
 LocationAPIRequest*
-LocationAPIControlClient::getRequestBySessionArrayPtr(
-        uint32_t* sessionArrayPtr)
+LocationAPIControlClient::getRequestByCollectiveSession(uint32_t firstSession)
 {
     pthread_mutex_lock(&mMutex);
     LocationAPIRequest* request = nullptr;
 
-    if (mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].getSessionArrayPtr() == sessionArrayPtr) {
-        request = mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].pop();
-    } else if (mRequestQueues[CTRL_REQUEST_CONFIG_GET].getSessionArrayPtr() == sessionArrayPtr) {
-        request = mRequestQueues[CTRL_REQUEST_CONFIG_GET].pop();
+    request = mRequestQueues[CTRL_REQUEST_CONFIG_UPDATE].pop(firstSession);
+    if (nullptr == request) {
+        request = mRequestQueues[CTRL_REQUEST_CONFIG_GET].pop(firstSession);
     }
 
     pthread_mutex_unlock(&mMutex);
@@ -364,8 +538,8 @@ uint32_t LocationAPIClientBase::locAPIStartTracking(TrackingOptions& options)
             // onResponseCb might be called from other thread immediately after
             // startTracking returns, so we are not going to unlock mutex
             // until StartTrackingRequest is pushed into mRequestQueues[REQUEST_TRACKING]
-            mRequestQueues[REQUEST_TRACKING].reset(session);
-            mRequestQueues[REQUEST_TRACKING].push(new StartTrackingRequest(*this));
+            mRequestQueues[REQUEST_TRACKING].setSession(session);
+            mRequestQueues[REQUEST_TRACKING].push(session, new StartTrackingRequest(*this));
             mTracking = true;
         }
 
@@ -383,7 +557,7 @@ void LocationAPIClientBase::locAPIStopTracking()
         uint32_t session = 0;
         session = mRequestQueues[REQUEST_TRACKING].getSession();
         if (session > 0) {
-            mRequestQueues[REQUEST_TRACKING].push(new StopTrackingRequest(*this));
+            mRequestQueues[REQUEST_TRACKING].push(session, new StopTrackingRequest(*this));
             mLocationAPI->stopTracking(session);
             mTracking = false;
         } else {
@@ -400,7 +574,7 @@ void LocationAPIClientBase::locAPIUpdateTrackingOptions(TrackingOptions& options
         uint32_t session = 0;
         session = mRequestQueues[REQUEST_TRACKING].getSession();
         if (session > 0) {
-            mRequestQueues[REQUEST_TRACKING].push(new UpdateTrackingOptionsRequest(*this));
+            mRequestQueues[REQUEST_TRACKING].push(session, new UpdateTrackingOptionsRequest(*this));
             mLocationAPI->updateTrackingOptions(session, options);
         } else {
             LOC_LOGE("%s:%d] invalid session: %d.", __FUNCTION__, __LINE__, session);
@@ -442,7 +616,8 @@ uint32_t LocationAPIClientBase::locAPIStartSession(
             if (sessionMode == SESSION_MODE_ON_FIX) {
                 trackingSession = mLocationAPI->startTracking(options);
                 LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, trackingSession);
-                mRequestQueues[REQUEST_SESSION].push(new StartTrackingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(trackingSession,
+                        new StartTrackingRequest(*this));
             } else {
                 // Fill in the batch mode
                 BatchingOptions batchOptions = {};
@@ -467,7 +642,8 @@ uint32_t LocationAPIClientBase::locAPIStartSession(
                 batchingSession = mLocationAPI->startBatching(batchOptions);
                 LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, batchingSession);
                 mRequestQueues[REQUEST_SESSION].setSession(batchingSession);
-                mRequestQueues[REQUEST_SESSION].push(new StartBatchingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(batchingSession,
+                        new StartBatchingRequest(*this));
             }
 
             uint32_t session = ((sessionMode != SESSION_MODE_ON_FIX) ?
@@ -503,10 +679,12 @@ uint32_t LocationAPIClientBase::locAPIStopSession(uint32_t id)
             uint32_t sMode = entity.sessionMode;
 
             if (sMode == SESSION_MODE_ON_FIX) {
-                mRequestQueues[REQUEST_SESSION].push(new StopTrackingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(trackingSession,
+                        new StopTrackingRequest(*this));
                 mLocationAPI->stopTracking(trackingSession);
             } else {
-                mRequestQueues[REQUEST_SESSION].push(new StopBatchingRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(batchingSession,
+                        new StopBatchingRequest(*this));
                 mLocationAPI->stopBatching(batchingSession);
             }
 
@@ -534,11 +712,12 @@ uint32_t LocationAPIClientBase::locAPIUpdateSessionOptions(
             uint32_t trackingSession = entity.trackingSession;
             uint32_t batchingSession = entity.batchingSession;
             uint32_t sMode = entity.sessionMode;
+            LocationAPIRequest* request = nullptr;
 
             if (sessionMode == SESSION_MODE_ON_FIX) {
                 // we only add an UpdateTrackingOptionsRequest to mRequestQueues[REQUEST_SESSION],
                 // even if this update request will stop batching and then start tracking.
-                mRequestQueues[REQUEST_SESSION].push(new UpdateTrackingOptionsRequest(*this));
+                request = new UpdateTrackingOptionsRequest(*this);
                 if (sMode == SESSION_MODE_ON_FIX) {
                     mLocationAPI->updateTrackingOptions(trackingSession, options);
                 } else  {
@@ -557,7 +736,7 @@ uint32_t LocationAPIClientBase::locAPIUpdateSessionOptions(
             } else {
                 // we only add an UpdateBatchingOptionsRequest to mRequestQueues[REQUEST_SESSION],
                 // even if this update request will stop tracking and then start batching.
-                mRequestQueues[REQUEST_SESSION].push(new UpdateBatchingOptionsRequest(*this));
+                request = new UpdateBatchingOptionsRequest(*this);
                 BatchingOptions batchOptions = {};
                 batchOptions.size = sizeof(BatchingOptions);
                 switch (sessionMode) {
@@ -597,6 +776,9 @@ uint32_t LocationAPIClientBase::locAPIUpdateSessionOptions(
 
             uint32_t session = ((sessionMode != SESSION_MODE_ON_FIX) ?
                     batchingSession : trackingSession);
+            // filed under the session the update ends up with, which is the new one
+            // when the mode switched between tracking and batching
+            mRequestQueues[REQUEST_SESSION].push(session, request);
 
             entity.trackingSession = trackingSession;
             entity.batchingSession = batchingSession;
@@ -624,7 +806,8 @@ uint32_t LocationAPIClientBase::locAPIGetBatchedLocations(uint32_t id, size_t co
             SessionEntity entity = mSessionBiDict.getExtById(id);
             if (entity.sessionMode != SESSION_MODE_ON_FIX) {
                 uint32_t batchingSession = entity.batchingSession;
-                mRequestQueues[REQUEST_SESSION].push(new GetBatchedLocationsRequest(*this));
+                mRequestQueues[REQUEST_SESSION].push(batchingSession,
+                        new GetBatchedLocationsRequest(*this));
                 mLocationAPI->getBatchedLocations(batchingSession, count);
                 retVal = LOCATION_ERROR_SUCCESS;
             }  else {
@@ -654,11 +837,15 @@ uint32_t LocationAPIClientBase::locAPIAddGeofences(
         uint32_t* sessions = mLocationAPI->addGeofences(count, options, data);
         if (sessions) {
             LOC_LOGI("%s:%d] start new sessions: %p", __FUNCTION__, __LINE__, sessions);
-            mRequestQueues[REQUEST_GEOFENCE].push(new AddGeofencesRequest(*this));
+            // collective responses are correlated by their first session
+            mRequestQueues[REQUEST_GEOFENCE].push((count > 0) ? sessions[0] : 0,
+                    new AddGeofencesRequest(*this));
 
-            for (size_t i = 0; i < count; i++) {
-                mGeofenceBiDict.set(ids[i], sessions[i], options[i].breachTypeMask);
-            }
+            mGeofenceBiDict.update([&] (BiDict<GeofenceBreachTypeMask>::Table& table) {
+                for (size_t i = 0; i < count; i++) {
+                    table.set(ids[i], sessions[i], options[i].breachTypeMask);
+                }
+            });
             retVal = LOCATION_ERROR_SUCCESS;
         }
     }
@@ -683,18 +870,21 @@ void LocationAPIClientBase::locAPIRemoveGeofences(size_t count, uint32_t* ids)
             BiDict<GeofenceBreachTypeMask>* removedGeofenceBiDict =
                     new BiDict<GeofenceBreachTypeMask>();
             size_t j = 0;
-            for (size_t i = 0; i < count; i++) {
-                sessions[j] = mGeofenceBiDict.getSession(ids[i]);
-                if (sessions[j] > 0) {
-                    GeofenceBreachTypeMask type = mGeofenceBiDict.getExtBySession(sessions[j]);
-                    mGeofenceBiDict.rmBySession(sessions[j]);
-                    removedGeofenceBiDict->set(ids[i], sessions[j], type);
-                    j++;
-                }
-            }
+            removedGeofenceBiDict->update([&] (BiDict<GeofenceBreachTypeMask>::Table& removed) {
+                mGeofenceBiDict.update([&] (BiDict<GeofenceBreachTypeMask>::Table& table) {
+                    for (size_t i = 0; i < count; i++) {
+                        sessions[j] = table.getSession(ids[i]);
+                        if (sessions[j] > 0) {
+                            removed.set(ids[i], sessions[j], table.getExtBySession(sessions[j]));
+                            table.rmBySession(sessions[j]);
+                            j++;
+                        }
+                    }
+                });
+            });
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new RemoveGeofencesRequest(*this,
-                        removedGeofenceBiDict));
+                mRequestQueues[REQUEST_GEOFENCE].push(sessions[0],
+                        new RemoveGeofencesRequest(*this, removedGeofenceBiDict));
                 mLocationAPI->removeGeofences(j, sessions);
             } else {
                 delete(removedGeofenceBiDict);
@@ -724,15 +914,18 @@ void LocationAPIClientBase::locAPIModifyGeofences(
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
-            for (size_t i = 0; i < count; i++) {
-                sessions[j] = mGeofenceBiDict.getSession(ids[i]);
-                if (sessions[j] > 0) {
-                    mGeofenceBiDict.set(ids[i], sessions[j], options[i].breachTypeMask);
-                    j++;
+            mGeofenceBiDict.update([&] (BiDict<GeofenceBreachTypeMask>::Table& table) {
+                for (size_t i = 0; i < count; i++) {
+                    sessions[j] = table.getSession(ids[i]);
+                    if (sessions[j] > 0) {
+                        table.set(ids[i], sessions[j], options[i].breachTypeMask);
+                        j++;
+                    }
                 }
-            }
+            });
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new ModifyGeofencesRequest(*this));
+                mRequestQueues[REQUEST_GEOFENCE].push(sessions[0],
+                        new ModifyGeofencesRequest(*this));
                 mLocationAPI->modifyGeofences(j, sessions, options);
             }
         } else {
@@ -759,14 +952,16 @@ void LocationAPIClientBase::locAPIPauseGeofences(size_t count, uint32_t* ids)
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
+            auto table = mGeofenceBiDict.snapshot();
             for (size_t i = 0; i < count; i++) {
-                sessions[j] = mGeofenceBiDict.getSession(ids[i]);
+                sessions[j] = table->getSession(ids[i]);
                 if (sessions[j] > 0) {
                     j++;
                 }
             }
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new PauseGeofencesRequest(*this));
+                mRequestQueues[REQUEST_GEOFENCE].push(sessions[0],
+                        new PauseGeofencesRequest(*this));
                 mLocationAPI->pauseGeofences(j, sessions);
             }
         } else {
@@ -794,17 +989,20 @@ void LocationAPIClientBase::locAPIResumeGeofences(
 
         if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
             size_t j = 0;
-            for (size_t i = 0; i < count; i++) {
-                sessions[j] = mGeofenceBiDict.getSession(ids[i]);
-                if (sessions[j] > 0) {
-                    if (mask) {
-                        mGeofenceBiDict.set(ids[i], sessions[j], mask[i]);
+            mGeofenceBiDict.update([&] (BiDict<GeofenceBreachTypeMask>::Table& table) {
+                for (size_t i = 0; i < count; i++) {
+                    sessions[j] = table.getSession(ids[i]);
+                    if (sessions[j] > 0) {
+                        if (mask) {
+                            table.set(ids[i], sessions[j], mask[i]);
+                        }
+                        j++;
                     }
-                    j++;
                 }
-            }
+            });
             if (j > 0) {
-                mRequestQueues[REQUEST_GEOFENCE].push(new ResumeGeofencesRequest(*this));
+                mRequestQueues[REQUEST_GEOFENCE].push(sessions[0],
+                        new ResumeGeofencesRequest(*this));
                 mLocationAPI->resumeGeofences(j, sessions);
             }
         } else {
@@ -832,8 +1030,8 @@ void LocationAPIClientBase::locAPIGnssNiResponse(uint32_t id, GnssNiResponse res
         uint32_t session = id;
         mLocationAPI->gnssNiResponse(id, response);
         LOC_LOGI("%s:%d] start new session: %d", __FUNCTION__, __LINE__, session);
-        mRequestQueues[REQUEST_NIRESPONSE].reset(session);
-        mRequestQueues[REQUEST_NIRESPONSE].push(new GnssNiResponseRequest(*this));
+        mRequestQueues[REQUEST_NIRESPONSE].setSession(session);
+        mRequestQueues[REQUEST_NIRESPONSE].push(session, new GnssNiResponseRequest(*this));
     }
     pthread_mutex_unlock(&mMutex);
 }
@@ -856,10 +1054,11 @@ void LocationAPIClientBase::beforeGeofenceBreachCb(
     pthread_mutex_lock(&mMutex);
     if (mGeofenceBreachCallback != nullptr) {
         size_t count = 0;
+        auto table = mGeofenceBiDict.snapshot();
         for (size_t i = 0; i < n; i++) {
-            uint32_t id = mGeofenceBiDict.getId(geofenceBreachNotification.ids[i]);
+            uint32_t id = table->getId(geofenceBreachNotification.ids[i]);
             GeofenceBreachTypeMask type =
-                mGeofenceBiDict.getExtBySession(geofenceBreachNotification.ids[i]);
+                table->getExtBySession(geofenceBreachNotification.ids[i]);
             // if type == 0, we will not head into the fllowing block anyway.
             // so we don't need to check id and type
             if ((geofenceBreachNotification.type == GEOFENCE_BREACH_ENTER &&
@@ -937,8 +1136,8 @@ void LocationAPIClientBase::onCollectiveResponseCb(
     }
     LocationAPIRequest* request = nullptr;
     pthread_mutex_lock(&mMutex);
-    if (mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
-        request = mRequestQueues[REQUEST_GEOFENCE].pop();
+    if (count > 0 && mRequestQueues[REQUEST_GEOFENCE].getSession() == GEOFENCE_SESSION_ID) {
+        request = mRequestQueues[REQUEST_GEOFENCE].pop(ids[0]);
     }
     pthread_mutex_unlock(&mMutex);
     if (request) {
@@ -957,19 +1156,11 @@ LocationAPIRequest* LocationAPIClientBase::getRequestBySession(uint32_t session)
 {
     pthread_mutex_lock(&mMutex);
     LocationAPIRequest* request = nullptr;
-    for (int i = 0; i < REQUEST_MAX; i++) {
-        if (i != REQUEST_GEOFENCE &&
-                i != REQUEST_SESSION &&
-                mRequestQueues[i].getSession() == session) {
-            request = mRequestQueues[i].pop();
-            break;
-        }
-    }
-    if (request == nullptr) {
-        // Can't find a request with correct session,
-        // try to find it from mSessionBiDict
-        if (mSessionBiDict.hasSession(session)) {
-            request = mRequestQueues[REQUEST_SESSION].pop();
+    // sessions are unique across request types, geofence requests are
+    // correlated through their collective response instead
+    for (int i = 0; i < REQUEST_MAX && nullptr == request; i++) {
+        if (i != REQUEST_GEOFENCE) {
+            request = mRequestQueues[i].pop(session);
         }
     }
     pthread_mutex_unlock(&mMutex);
@@ -34,6 +34,12 @@
 #include <pthread.h>
 #include <queue>
 #include <map>
+#include <memory>
+#include <future>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <string.h>
 
 #include "LocationAPI.h"
 #include <loc_pla.h>
@@ -73,6 +79,10 @@ public:
             size_t /*count*/, LocationError* /*errors*/, uint32_t* /*ids*/) {}
 };
 
+// Outstanding requests of one type. Each request is filed under the session
+// its response will carry, so requests for several sessions can be in flight
+// at once and a response completes the oldest request of its own session
+// instead of whichever request of the type was issued first.
 class RequestQueue {
 public:
     RequestQueue(): mSession(0), mSessionArrayPtr(nullptr) {
@@ -83,26 +93,33 @@ public:
     void inline setSession(uint32_t session) { mSession = session; }
     void inline setSessionArrayPtr(uint32_t* ptr) { mSessionArrayPtr = ptr; }
     void reset(uint32_t session) {
-        LocationAPIRequest* request = nullptr;
-        while (!mQueue.empty()) {
-            request = mQueue.front();
-            mQueue.pop();
-            delete request;
+        for (auto& each : mRequests) {
+            delete each.second;
         }
+        mRequests.clear();
         mSession = session;
     }
     void reset(uint32_t* sessionArrayPtr) {
         reset((uint32_t)0);
         mSessionArrayPtr = sessionArrayPtr;
     }
+    // files the request under the current session
     void push(LocationAPIRequest* request) {
-        mQueue.push(request);
+        push(mSession, request);
+    }
+    void push(uint32_t session, LocationAPIRequest* request) {
+        // equal keys keep their insertion order
+        mRequests.emplace(session, request);
     }
     LocationAPIRequest* pop() {
+        return pop(mSession);
+    }
+    LocationAPIRequest* pop(uint32_t session) {
         LocationAPIRequest* request = nullptr;
-        if (!mQueue.empty()) {
-            request = mQueue.front();
-            mQueue.pop();
+        auto it = mRequests.lower_bound(session);
+        if (it != mRequests.end() && it->first == session) {
+            request = it->second;
+            mRequests.erase(it);
         }
         return request;
     }
@@ -111,7 +128,7 @@ public:
 private:
     uint32_t mSession;
     uint32_t* mSessionArrayPtr;
-    std::queue<LocationAPIRequest*> mQueue;
+    std::multimap<uint32_t, LocationAPIRequest*> mRequests;
 };
 
 class LocationAPIControlClient {
@@ -122,7 +139,7 @@ public:
     LocationAPIControlClient& operator=(const LocationAPIControlClient&) = delete;
 
     LocationAPIRequest* getRequestBySession(uint32_t session);
-    LocationAPIRequest* getRequestBySessionArrayPtr(uint32_t* sessionArrayPtr);
+    LocationAPIRequest* getRequestByCollectiveSession(uint32_t firstSession);
 
     // LocationControlAPI
     uint32_t locAPIGnssDeleteAidingData(GnssAidingData& data);
@@ -130,11 +147,19 @@ public:
     void locAPIDisable();
     uint32_t locAPIGnssUpdateConfig(GnssConfig config);
     uint32_t locAPIGnssGetConfig(GnssConfigFlagsMask config);
+    // The future is ready once the engine has reported every item of mask or
+    // failed to read it; items that failed are left out of the returned flags.
+    std::future<GnssConfig> locAPIGnssGetConfigAsync(GnssConfigFlagsMask mask);
+    // Last known value of the items of mask, kept from get responses, engine
+    // reports and successful updates, with no round trip to the adapter thread.
+    // Returns false when any item of mask is not known yet.
+    bool locAPIGetCachedConfig(GnssConfigFlagsMask mask, GnssConfig& config) const;
     inline LocationControlAPI* getControlAPI() { return mLocationControlAPI; }
 
     // callbacks
     void onCtrlResponseCb(LocationError error, uint32_t id);
     void onCtrlCollectiveResponseCb(size_t count, LocationError* errors, uint32_t* ids);
+    void onCtrlGnssConfigCb(uint32_t session, const GnssConfig& config);
 
     inline virtual void onGnssDeleteAidingDataCb(LocationError /*error*/) {}
     inline virtual void onEnableCb(LocationError /*error*/) {}
@@ -144,6 +169,15 @@ public:
     inline virtual void onGnssGetConfigCb(
             size_t /*count*/, LocationError* /*errors*/, uint32_t* /*ids*/) {}
 
+private:
+    struct PendingConfigGet {
+        GnssConfigFlagsMask mask;
+        // items neither reported nor failed yet
+        GnssConfigFlagsMask remaining;
+        std::promise<GnssConfig> promise;
+    };
+
+public:
     class GnssDeleteAidingDataRequest : public LocationAPIRequest {
     public:
         GnssDeleteAidingDataRequest(LocationAPIControlClient& API) : mAPI(API) {}
@@ -173,28 +207,48 @@ public:
 
     class GnssUpdateConfigRequest : public LocationAPIRequest {
     public:
-        GnssUpdateConfigRequest(LocationAPIControlClient& API) : mAPI(API) {}
+        GnssUpdateConfigRequest(LocationAPIControlClient& API, const GnssConfig& config) :
+            mAPI(API), mConfig(config) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* ids) {
+            mAPI.onGnssUpdateConfigResponse(mConfig, count, errors);
             mAPI.onGnssUpdateConfigCb(count, errors, ids);
         }
         LocationAPIControlClient& mAPI;
+        GnssConfig mConfig;
     };
 
     class GnssGetConfigRequest : public LocationAPIRequest {
     public:
-        GnssGetConfigRequest(LocationAPIControlClient& API) : mAPI(API) {}
+        GnssGetConfigRequest(LocationAPIControlClient& API,
+                             const std::shared_ptr<PendingConfigGet>& pending) :
+            mAPI(API), mPending(pending) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* ids) {
+            mAPI.onGnssGetConfigResponse(mPending, count, errors);
             mAPI.onGnssGetConfigCb(count, errors, ids);
         }
         LocationAPIControlClient& mAPI;
+        std::shared_ptr<PendingConfigGet> mPending;
     };
 
 private:
+    uint32_t gnssGetConfig(GnssConfigFlagsMask mask,
+                           const std::shared_ptr<PendingConfigGet>& pending);
+    void onGnssUpdateConfigResponse(const GnssConfig& config,
+                                    size_t count, LocationError* errors);
+    void onGnssGetConfigResponse(const std::shared_ptr<PendingConfigGet>& pending,
+                                 size_t count, LocationError* errors);
+    // both with mMutex held
+    void updateConfigCache(const GnssConfig& config, GnssConfigFlagsMask mask);
+    void completeConfigGets(bool all);
+
     pthread_mutex_t mMutex;
     LocationControlAPI* mLocationControlAPI;
     RequestQueue mRequestQueues[CTRL_REQUEST_MAX];
     bool mEnabled;
     GnssConfig mConfig;
+    // replaced under mMutex through std::atomic_store, read without it
+    std::shared_ptr<const GnssConfig> mConfigCache;
+    std::list<std::shared_ptr<PendingConfigGet>> mPendingConfigGets;
 };
 
 class LocationAPIClientBase {
@@ -297,117 +351,171 @@ private:
         uint32_t sessionMode;
     } SessionEntity;
 
+    // Bidirectional id <-> session index with an extra value per session. The
+    // entries live in flat sorted vectors inside an immutable Table; writers
+    // serialize on mBiDictMutex, edit a copy and publish it, while readers
+    // take the current Table without any lock and may keep it as long as they
+    // need (RCU style, the shared_ptr reclaims old tables). Callbacks that
+    // translate many sessions take one snapshot() and look them all up in it,
+    // and update() applies a bulk change with a single copy.
     template<typename T>
     class BiDict {
     public:
-        BiDict() {
+        struct Entry {
+            uint32_t id;
+            uint32_t session;
+            T ext;
+        };
+        class Table {
+            // sorted by session, the key callbacks translate by
+            std::vector<Entry> mEntries;
+            // (id, session) sorted by id
+            std::vector<std::pair<uint32_t, uint32_t>> mIds;
+
+            inline typename std::vector<Entry>::const_iterator
+                    lowerSession(uint32_t session) const {
+                return std::lower_bound(mEntries.begin(), mEntries.end(), session,
+                        [] (const Entry& e, uint32_t s) { return e.session < s; });
+            }
+            inline std::vector<std::pair<uint32_t, uint32_t>>::const_iterator
+                    lowerId(uint32_t id) const {
+                return std::lower_bound(mIds.begin(), mIds.end(), id,
+                        [] (const std::pair<uint32_t, uint32_t>& e, uint32_t i) {
+                            return e.first < i; });
+            }
+            inline const Entry* findSession(uint32_t session) const {
+                auto it = lowerSession(session);
+                return (it != mEntries.end() && it->session == session) ? &(*it) : nullptr;
+            }
+            inline bool findId(uint32_t id, uint32_t& session) const {
+                auto it = lowerId(id);
+                if (it != mIds.end() && it->first == id) {
+                    session = it->second;
+                    return true;
+                }
+                return false;
+            }
+            inline static T zeroExt() {
+                T ret;
+                memset(&ret, 0, sizeof(T));
+                return ret;
+            }
+        public:
+            inline size_t size() const { return mEntries.size(); }
+            inline const std::vector<Entry>& entries() const { return mEntries; }
+            inline bool hasId(uint32_t id) const {
+                uint32_t session = 0;
+                return findId(id, session);
+            }
+            inline bool hasSession(uint32_t session) const {
+                return nullptr != findSession(session);
+            }
+            inline uint32_t getId(uint32_t session) const {
+                const Entry* e = findSession(session);
+                return (nullptr != e) ? e->id : 0;
+            }
+            inline uint32_t getSession(uint32_t id) const {
+                uint32_t session = 0;
+                findId(id, session);
+                return session;
+            }
+            inline T getExtBySession(uint32_t session) const {
+                const Entry* e = findSession(session);
+                return (nullptr != e) ? e->ext : zeroExt();
+            }
+            inline T getExtById(uint32_t id) const {
+                uint32_t session = 0;
+                if (findId(id, session) && session > 0) {
+                    return getExtBySession(session);
+                }
+                return zeroExt();
+            }
+            // any pairing id or session had before is dropped
+            void set(uint32_t id, uint32_t session, const T& ext) {
+                rmById(id);
+                rmBySession(session);
+                mEntries.insert(lowerSession(session), Entry{id, session, ext});
+                mIds.insert(lowerId(id), std::make_pair(id, session));
+            }
+            void rmById(uint32_t id) {
+                auto it = lowerId(id);
+                if (it != mIds.end() && it->first == id) {
+                    auto e = lowerSession(it->second);
+                    if (e != mEntries.end() && e->session == it->second) {
+                        mEntries.erase(e);
+                    }
+                    mIds.erase(it);
+                }
+            }
+            void rmBySession(uint32_t session) {
+                auto e = lowerSession(session);
+                if (e != mEntries.end() && e->session == session) {
+                    auto it = lowerId(e->id);
+                    if (it != mIds.end() && it->first == e->id) {
+                        mIds.erase(it);
+                    }
+                    mEntries.erase(e);
+                }
+            }
+            inline void clear() {
+                mEntries.clear();
+                mIds.clear();
+            }
+        };
+
+        BiDict() : mTable(std::make_shared<const Table>()) {
             pthread_mutex_init(&mBiDictMutex, nullptr);
         }
         virtual ~BiDict() {
             pthread_mutex_destroy(&mBiDictMutex);
         }
-        bool hasId(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mForwardMap.find(id) != mForwardMap.end());
-            pthread_mutex_unlock(&mBiDictMutex);
-            return ret;
+        inline std::shared_ptr<const Table> snapshot() const {
+            return std::atomic_load(&mTable);
         }
-        bool hasSession(uint32_t session) {
+        // Runs edit(Table&) on a copy of the current table and publishes it
+        template <typename Edit>
+        void update(Edit edit) {
             pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mBackwardMap.find(session) != mBackwardMap.end());
+            std::shared_ptr<Table> next = std::make_shared<Table>(*mTable);
+            edit(*next);
+            std::atomic_store(&mTable, std::shared_ptr<const Table>(next));
             pthread_mutex_unlock(&mBiDictMutex);
-            return ret;
         }
-        void set(uint32_t id, uint32_t session, T& ext) {
-            pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap[id] = session;
-            mBackwardMap[session] = id;
-            mExtMap[session] = ext;
-            pthread_mutex_unlock(&mBiDictMutex);
+        bool hasId(uint32_t id) const { return snapshot()->hasId(id); }
+        bool hasSession(uint32_t session) const { return snapshot()->hasSession(session); }
+        void set(uint32_t id, uint32_t session, const T& ext) {
+            update([&] (Table& table) { table.set(id, session, ext); });
         }
         void clear() {
             pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap.clear();
-            mBackwardMap.clear();
-            mExtMap.clear();
+            std::atomic_store(&mTable, std::make_shared<const Table>());
             pthread_mutex_unlock(&mBiDictMutex);
         }
         void rmById(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
-            mBackwardMap.erase(mForwardMap[id]);
-            mExtMap.erase(mForwardMap[id]);
-            mForwardMap.erase(id);
-            pthread_mutex_unlock(&mBiDictMutex);
+            update([id] (Table& table) { table.rmById(id); });
         }
         void rmBySession(uint32_t session) {
-            pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap.erase(mBackwardMap[session]);
-            mBackwardMap.erase(session);
-            mExtMap.erase(session);
-            pthread_mutex_unlock(&mBiDictMutex);
-        }
-        uint32_t getId(uint32_t session) {
-            pthread_mutex_lock(&mBiDictMutex);
-            uint32_t ret = 0;
-            auto it = mBackwardMap.find(session);
-            if (it != mBackwardMap.end()) {
-                ret = it->second;
-            }
-            pthread_mutex_unlock(&mBiDictMutex);
-            return ret;
-        }
-        uint32_t getSession(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
-            uint32_t ret = 0;
-            auto it = mForwardMap.find(id);
-            if (it != mForwardMap.end()) {
-                ret = it->second;
-            }
-            pthread_mutex_unlock(&mBiDictMutex);
-            return ret;
+            update([session] (Table& table) { table.rmBySession(session); });
         }
-        T getExtById(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
-            T ret;
-            memset(&ret, 0, sizeof(T));
-            uint32_t session = mForwardMap[id];
-            if (session > 0) {
-                auto it = mExtMap.find(session);
-                if (it != mExtMap.end()) {
-                    ret = it->second;
-                }
-            }
-            pthread_mutex_unlock(&mBiDictMutex);
-            return ret;
+        uint32_t getId(uint32_t session) const { return snapshot()->getId(session); }
+        uint32_t getSession(uint32_t id) const { return snapshot()->getSession(id); }
+        T getExtById(uint32_t id) const { return snapshot()->getExtById(id); }
+        T getExtBySession(uint32_t session) const {
+            return snapshot()->getExtBySession(session);
         }
-        T getExtBySession(uint32_t session) {
-            pthread_mutex_lock(&mBiDictMutex);
-            T ret;
-            memset(&ret, 0, sizeof(T));
-            auto it = mExtMap.find(session);
-            if (it != mExtMap.end()) {
-                ret = it->second;
-            }
-            pthread_mutex_unlock(&mBiDictMutex);
-            return ret;
-        }
-        std::vector<uint32_t> getAllSessions() {
+        std::vector<uint32_t> getAllSessions() const {
+            std::shared_ptr<const Table> table = snapshot();
             std::vector<uint32_t> ret;
-            pthread_mutex_lock(&mBiDictMutex);
-            for (auto it = mBackwardMap.begin(); it != mBackwardMap.end(); it++) {
-                ret.push_back(it->first);
+            ret.reserve(table->size());
+            for (const Entry& e : table->entries()) {
+                ret.push_back(e.session);
             }
-            pthread_mutex_unlock(&mBiDictMutex);
             return ret;
         }
     private:
         pthread_mutex_t mBiDictMutex;
-        // mForwarMap mapping id->session
-        std::map<uint32_t, uint32_t> mForwardMap;
-        // mBackwardMap mapping session->id
-        std::map<uint32_t, uint32_t> mBackwardMap;
-        // mExtMap mapping session->ext
-        std::map<uint32_t, T> mExtMap;
+        // only replaced through std::atomic_store, never modified in place
+        std::shared_ptr<const Table> mTable;
     };
 
     class StartTrackingRequest : public LocationAPIRequest {
@@ -490,8 +598,9 @@ private:
         AddGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
             uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            auto table = mAPI.mGeofenceBiDict.snapshot();
             for (size_t i = 0; i < count; i++) {
-                ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
+                ids[i] = table->getId(sessions[i]);
             }
             LOC_LOGD("%s:]Returned geofence-id: %d in add geofence", __FUNCTION__, *ids);
             mAPI.onAddGeofencesCb(count, errors, ids);
@@ -508,8 +617,9 @@ private:
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
             if (nullptr != mRemovedGeofenceBiDict) {
                 uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+                auto table = mRemovedGeofenceBiDict->snapshot();
                 for (size_t i = 0; i < count; i++) {
-                    ids[i] = mRemovedGeofenceBiDict->getId(sessions[i]);
+                    ids[i] = table->getId(sessions[i]);
                 }
                 LOC_LOGD("%s:]Returned geofence-id: %d in remove geofence", __FUNCTION__, *ids);
                 mAPI.onRemoveGeofencesCb(count, errors, ids);
@@ -528,8 +638,9 @@ private:
         ModifyGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
             uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            auto table = mAPI.mGeofenceBiDict.snapshot();
             for (size_t i = 0; i < count; i++) {
-                ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
+                ids[i] = table->getId(sessions[i]);
             }
             mAPI.onModifyGeofencesCb(count, errors, ids);
             free(ids);
@@ -542,8 +653,9 @@ private:
         PauseGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
             uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            auto table = mAPI.mGeofenceBiDict.snapshot();
             for (size_t i = 0; i < count; i++) {
-                ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
+                ids[i] = table->getId(sessions[i]);
             }
             mAPI.onPauseGeofencesCb(count, errors, ids);
             free(ids);
@@ -556,8 +668,9 @@ private:
         ResumeGeofencesRequest(LocationAPIClientBase& API) : mAPI(API) {}
         inline void onCollectiveResponse(size_t count, LocationError* errors, uint32_t* sessions) {
             uint32_t *ids = (uint32_t*)malloc(sizeof(uint32_t) * count);
+            auto table = mAPI.mGeofenceBiDict.snapshot();
             for (size_t i = 0; i < count; i++) {
-                ids[i] = mAPI.mGeofenceBiDict.getId(sessions[i]);
+                ids[i] = table->getId(sessions[i]);
             }
             mAPI.onResumeGeofencesCb(count, errors, ids);
             free(ids);
@@ -111,6 +111,8 @@ struct GnssInterface {
     void (*resetNetworkInfo)();
     uint32_t (*configEngineRunState)(PositioningEngineMask engType,
                                      LocEngineRunState engState);
+    void (*dumpStats)(std::string& out);
+    uint64_t (*getDebugReportGeneration)();
 };
 
 struct BatchingInterface {
@@ -124,6 +126,7 @@ struct BatchingInterface {
     void (*stopBatching)(LocationAPI* client, uint32_t id);
     void (*updateBatchingOptions)(LocationAPI* client, uint32_t id, BatchingOptions&);
     void (*getBatchedLocations)(LocationAPI* client, uint32_t id, size_t count);
+    void (*dumpStats)(std::string& out);
 };
 
 struct GeofenceInterface {
@@ -139,6 +142,7 @@ struct GeofenceInterface {
                             GeofenceOption* options);
     void (*pauseGeofences)(LocationAPI* client, size_t count, uint32_t* ids);
     void (*resumeGeofences)(LocationAPI* client, size_t count, uint32_t* ids);
+    void (*dumpStats)(std::string& out);
 };
 
 #endif /* LOCATION_INTERFACE_H */
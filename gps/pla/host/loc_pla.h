@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __LOC_PLA__
+#define __LOC_PLA__
+
+/*
+ * Platform layer of the host builds, which run the HAL libraries on a
+ * workstation against the host libcutils and libutils, without the
+ * processgroup scheduling and with the conf files of the working directory.
+ */
+
+#ifdef __cplusplus
+#include <utils/SystemClock.h>
+#define uptimeMillis() android::uptimeMillis()
+#define elapsedRealtime() android::elapsedRealtime()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <cutils/properties.h>
+#include <cutils/threads.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* bionic has it in sys/cdefs.h, glibc doesn't */
+#ifndef __unused
+#define __unused __attribute__((__unused__))
+#endif
+
+#define SP_FOREGROUND 1
+#define set_sched_policy(a, b)
+
+#define UID_GPS (1021)
+#define GID_GPS (1021)
+#define UID_LOCCLIENT (4021)
+#define GID_LOCCLIENT (4021)
+
+#define LOC_PATH_GPS_CONF_STR      "gps.conf"
+#define LOC_PATH_IZAT_CONF_STR     "izat.conf"
+#define LOC_PATH_FLP_CONF_STR      "flp.conf"
+#define LOC_PATH_LOWI_CONF_STR     "lowi.conf"
+#define LOC_PATH_SAP_CONF_STR      "sap.conf"
+#define LOC_PATH_APDR_CONF_STR     "apdr.conf"
+#define LOC_PATH_XTWIFI_CONF_STR   "xtwifi.conf"
+#define LOC_PATH_QUIPC_CONF_STR    "quipc.conf"
+#define LOC_PATH_ANT_CORR_STR      "gnss_antenna_info.conf"
+#define LOC_PATH_SLIM_CONF_STR     "slim.conf"
+#define LOC_PATH_VPE_CONF_STR      "vpeglue.conf"
+
+/*!
+ * @brief Function for memory block copy
+ *
+ * @param[out] p_Dest     Destination buffer.
+ * @param[in]  q_DestSize Destination buffer size.
+ * @param[in]  p_Src      Source buffer.
+ * @param[in]  q_SrcSize  Source buffer size.
+ *
+ * @return Number of bytes copied.
+ */
+static inline size_t memscpy (void *p_Dest, size_t q_DestSize, const void *p_Src, size_t q_SrcSize)
+{
+    size_t res = (q_DestSize < q_SrcSize) ? q_DestSize : q_SrcSize;
+    if (p_Dest && p_Src && q_DestSize > 0 && q_SrcSize > 0) {
+        memcpy(p_Dest, p_Src, res);
+    } else {
+        res = 0;
+    }
+    return res;
+}
+
+/*API for boot kpi marker prints  */
+inline int loc_boot_kpi_marker(const char * pFmt __unused, ...)
+{
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus */
+
+#endif /* __LOC_PLA__ */
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOC_BUFFER_POOL_H
+#define LOC_BUFFER_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace loc_util {
+
+// Hands out std::vector<T> buffers as shared_ptrs and takes their storage back
+// when the last reference goes, so a steady stream of same sized reports (batched
+// fixes, measurements) stops reallocating once warmed up. Up to maxFree buffers,
+// with their capacity, are kept for reuse; the rest are freed. Buffers may be
+// acquired and released on any thread, and may outlive the pool.
+template <typename T>
+class LocBufferPool {
+public:
+    typedef std::vector<T> Storage;
+    typedef std::shared_ptr<Storage> Buffer;
+
+private:
+    struct State {
+        std::mutex mLock;
+        std::vector<Storage*> mFree;
+        size_t mMaxFree;
+        uint64_t mHits;
+        uint64_t mMisses;
+        inline State(size_t maxFree) : mMaxFree(maxFree), mHits(0), mMisses(0) {}
+        inline ~State() {
+            for (Storage* storage : mFree) {
+                delete storage;
+            }
+        }
+    };
+    std::shared_ptr<State> mState;
+
+    static void release(const std::shared_ptr<State>& state, Storage* storage) {
+        storage->clear();
+        {
+            std::lock_guard<std::mutex> guard(state->mLock);
+            if (state->mFree.size() < state->mMaxFree) {
+                state->mFree.push_back(storage);
+                return;
+            }
+        }
+        delete storage;
+    }
+
+public:
+    inline LocBufferPool(size_t maxFree) : mState(std::make_shared<State>(maxFree)) {}
+
+    // empty buffer with room for at least count elements
+    Buffer acquire(size_t count) {
+        Storage* storage = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(mState->mLock);
+            if (!mState->mFree.empty()) {
+                storage = mState->mFree.back();
+                mState->mFree.pop_back();
+                mState->mHits++;
+            } else {
+                mState->mMisses++;
+            }
+        }
+        if (nullptr == storage) {
+            storage = new Storage();
+        }
+        storage->reserve(count);
+        std::shared_ptr<State> state = mState;
+        return Buffer(storage, [state] (Storage* s) { release(state, s); });
+    }
+
+    // buffer holding a copy of count elements at data
+    inline Buffer acquire(const T* data, size_t count) {
+        Buffer buffer = acquire(count);
+        if (nullptr != data) {
+            buffer->assign(data, data + count);
+        }
+        return buffer;
+    }
+
+    inline uint64_t getHits() const {
+        std::lock_guard<std::mutex> guard(mState->mLock);
+        return mState->mHits;
+    }
+    inline uint64_t getMisses() const {
+        std::lock_guard<std::mutex> guard(mState->mLock);
+        return mState->mMisses;
+    }
+};
+
+} // namespace loc_util
+
+#endif // LOC_BUFFER_POOL_H
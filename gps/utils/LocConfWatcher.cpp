@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "LocSvc_LocConfWatcher"
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <set>
+#include <memory>
+#include <log_util.h>
+#include <LocConfWatcher.h>
+
+#define CONF_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+namespace loc_util {
+
+class LocConfWatcherRunnable : public LocRunnable {
+    LocConfWatcher& mWatcher;
+public:
+    inline LocConfWatcherRunnable(LocConfWatcher& watcher) : mWatcher(watcher) {}
+    virtual bool run() override { return mWatcher.handleEvents(); }
+    inline virtual void interrupt() override { close(mWatcher.mFd); }
+};
+
+LocConfWatcher& LocConfWatcher::getInstance()
+{
+    // never destroyed, listeners may be removed from static dtors
+    static LocConfWatcher* sInstance = new LocConfWatcher();
+    return *sInstance;
+}
+
+LocConfWatcher::LocConfWatcher() :
+        mFd(inotify_init1(IN_CLOEXEC)), mNextHandle(0)
+{
+    pthread_mutex_init(&mMutex, nullptr);
+    if (mFd < 0) {
+        LOC_LOGe("inotify_init1 failed: %s", strerror(errno));
+    } else {
+        mThread.start("LocConfWatcher", std::make_shared<LocConfWatcherRunnable>(*this));
+    }
+}
+
+uint32_t LocConfWatcher::addListener(const char* confPath, ChangeListener listener)
+{
+    uint32_t handle = 0;
+    if (mFd < 0 || nullptr == confPath || nullptr == listener) {
+        return handle;
+    }
+
+    std::string path(confPath);
+    size_t slash = path.rfind('/');
+    std::string dir = (std::string::npos == slash) ? "." : path.substr(0, slash);
+    std::string name = (std::string::npos == slash) ? path : path.substr(slash + 1);
+
+    pthread_mutex_lock(&mMutex);
+    auto fiter = mFiles.find(path);
+    if (fiter == mFiles.end()) {
+        // conf updates usually replace the file, so watch its directory
+        int wd = inotify_add_watch(mFd, dir.c_str(), CONF_WATCH_EVENTS);
+        if (wd < 0) {
+            LOC_LOGw("can't watch %s: %s", dir.c_str(), strerror(errno));
+        } else {
+            WatchedDir& watchedDir = mDirs[wd];
+            watchedDir.mPath = dir;
+            watchedDir.mFiles[name] = path;
+            fiter = mFiles.emplace(path, WatchedFile()).first;
+            loc_read_conf_items(confPath, fiter->second.mItems);
+            LOC_LOGd("watching %s", confPath);
+        }
+    }
+    if (fiter != mFiles.end()) {
+        handle = ++mNextHandle;
+        fiter->second.mListeners[handle] = listener;
+    }
+    pthread_mutex_unlock(&mMutex);
+
+    return handle;
+}
+
+void LocConfWatcher::removeListener(uint32_t handle)
+{
+    pthread_mutex_lock(&mMutex);
+    for (auto& each : mFiles) {
+        if (each.second.mListeners.erase(handle) > 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+// Called in the context of the watcher thread
+bool LocConfWatcher::handleEvents()
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len = read(mFd, buf, sizeof(buf));
+    if (len <= 0) {
+        return (len < 0 && EINTR == errno);
+    }
+
+    std::set<std::string> changedPaths;
+    pthread_mutex_lock(&mMutex);
+    for (char* ptr = buf; ptr < buf + len;
+            ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len) {
+        const struct inotify_event* event = (const struct inotify_event*)ptr;
+        if (0 == event->len) {
+            continue;
+        }
+        auto diter = mDirs.find(event->wd);
+        if (diter != mDirs.end()) {
+            auto niter = diter->second.mFiles.find(event->name);
+            if (niter != diter->second.mFiles.end()) {
+                changedPaths.insert(niter->second);
+            }
+        }
+    }
+    pthread_mutex_unlock(&mMutex);
+
+    for (auto& path : changedPaths) {
+        handleFileChange(path);
+    }
+    return true;
+}
+
+void LocConfWatcher::handleFileChange(const std::string& confPath)
+{
+    LocConfItems items;
+    if (!loc_read_conf_items(confPath.c_str(), items)) {
+        // replaced in several steps, wait for the one that puts it back
+        LOC_LOGd("%s not readable", confPath.c_str());
+        return;
+    }
+
+    pthread_mutex_lock(&mMutex);
+    auto fiter = mFiles.find(confPath);
+    if (fiter != mFiles.end()) {
+        LocConfItems& oldItems = fiter->second.mItems;
+        LocConfNames changed;
+        for (auto& each : items) {
+            auto oiter = oldItems.find(each.first);
+            if (oiter == oldItems.end() || oiter->second != each.second) {
+                changed.insert(each.first);
+            }
+        }
+        for (auto& each : oldItems) {
+            if (0 == items.count(each.first)) {
+                changed.insert(each.first);
+            }
+        }
+
+        if (!changed.empty()) {
+            LOC_LOGi("%s: %zu parameters changed", confPath.c_str(), changed.size());
+            oldItems = std::move(items);
+            for (auto& each : fiter->second.mListeners) {
+                each.second(confPath.c_str(), changed);
+            }
+        }
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+} // namespace loc_util
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __LOC_CONF_WATCHER_H__
+#define __LOC_CONF_WATCHER_H__
+
+#include <stdint.h>
+#include <pthread.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <loc_cfg.h>
+#include <LocThread.h>
+
+namespace loc_util {
+
+// Watches conf files with inotify and tells the listeners of a file which
+// of its parameters changed, once whoever updated it closes or renames it
+// into place. Parameters that appear, disappear or take a different value
+// all count as changed.
+//
+// Listeners are called on the watcher thread and with its lock held, so
+// they should only hand the change over to their own msg task. Once
+// removeListener() returns, the listener won't be called again.
+class LocConfWatcher {
+public:
+    typedef std::function<void(const char* confPath,
+                               const LocConfNames& changed)> ChangeListener;
+
+    static LocConfWatcher& getInstance();
+
+    // Returns a handle for removeListener(), 0 if the file can't be watched
+    uint32_t addListener(const char* confPath, ChangeListener listener);
+    void removeListener(uint32_t handle);
+
+private:
+    struct WatchedFile {
+        LocConfItems mItems;
+        std::map<uint32_t, ChangeListener> mListeners;
+    };
+    struct WatchedDir {
+        std::string mPath;
+        // file name within the dir -> full path
+        std::map<std::string, std::string> mFiles;
+    };
+
+    LocConfWatcher();
+    ~LocConfWatcher() = delete;
+
+    bool handleEvents();
+    void handleFileChange(const std::string& confPath);
+
+    friend class LocConfWatcherRunnable;
+    const int mFd;
+    pthread_mutex_t mMutex;
+    uint32_t mNextHandle;
+    std::map<std::string, WatchedFile> mFiles;
+    // inotify watch descriptor -> dir
+    std::map<int, WatchedDir> mDirs;
+    LocThread mThread;
+};
+
+} // namespace loc_util
+
+#endif //__LOC_CONF_WATCHER_H__
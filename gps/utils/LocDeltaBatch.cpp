@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include <LocDeltaBatch.h>
+
+namespace loc_util {
+
+// fields always stored, or stored for a flag of their own, ahead of the scaled ones
+enum {
+    FIELD_FLAGS = 0,
+    FIELD_TECH_MASK,
+    FIELD_TIMESTAMP,
+    FIELD_SPOOF_MASK,
+    FIELD_ELAPSED_REAL_TIME,
+    FIELD_ELAPSED_REAL_TIME_UNC,
+    FIELD_SCALED
+};
+
+// the fields kept as integers of value * scale, in stream order after the above
+template <typename T>
+struct DeltaField {
+    LocationFlagsMask flag;
+    T Location::* field;
+    double scale;
+};
+
+static const DeltaField<double> sDoubleFields[] = {
+    { LOCATION_HAS_LAT_LONG_BIT, &Location::latitude, 1e8 },
+    { LOCATION_HAS_LAT_LONG_BIT, &Location::longitude, 1e8 },
+    { LOCATION_HAS_ALTITUDE_BIT, &Location::altitude, 1e3 },
+};
+
+static const DeltaField<float> sFloatFields[] = {
+    { LOCATION_HAS_SPEED_BIT, &Location::speed, 1e3 },
+    { LOCATION_HAS_BEARING_BIT, &Location::bearing, 1e3 },
+    { LOCATION_HAS_ACCURACY_BIT, &Location::accuracy, 1e3 },
+    { LOCATION_HAS_VERTICAL_ACCURACY_BIT, &Location::verticalAccuracy, 1e3 },
+    { LOCATION_HAS_SPEED_ACCURACY_BIT, &Location::speedAccuracy, 1e3 },
+    { LOCATION_HAS_BEARING_ACCURACY_BIT, &Location::bearingAccuracy, 1e3 },
+    { LOCATION_HAS_CONFORMITY_INDEX_BIT, &Location::conformityIndex, 1e6 },
+};
+
+// a batch of a trip mostly takes less than this per fix
+#define LOC_DELTA_BATCH_BYTES_PER_FIX 24
+// scaled values are clamped into +/- 2^62, what is out there is garbage anyway
+#define LOC_DELTA_BATCH_SCALED_MAX 4.6e18
+
+static inline void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static inline uint64_t getVarint(const std::vector<uint8_t>& in, size_t& offset)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; offset < in.size() && shift < 64; shift += 7) {
+        uint8_t byte = in[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (0 == (byte & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+// the difference to last, wrapping, as a zigzag varint so small steps either
+// way take a byte or two
+static inline void putDelta(std::vector<uint8_t>& out, uint64_t value, uint64_t& last)
+{
+    uint64_t delta = value - last;
+    last = value;
+    putVarint(out, (delta << 1) ^ (0 - (delta >> 63)));
+}
+
+static inline uint64_t getDelta(const std::vector<uint8_t>& in, size_t& offset, uint64_t& last)
+{
+    uint64_t zigzag = getVarint(in, offset);
+    last += (zigzag >> 1) ^ (0 - (zigzag & 1));
+    return last;
+}
+
+static inline uint64_t quantize(double value, double scale)
+{
+    double scaled = value * scale;
+    if (!(scaled > -LOC_DELTA_BATCH_SCALED_MAX)) {
+        // also NaN
+        scaled = (scaled < 0) ? -LOC_DELTA_BATCH_SCALED_MAX : 0;
+    } else if (scaled > LOC_DELTA_BATCH_SCALED_MAX) {
+        scaled = LOC_DELTA_BATCH_SCALED_MAX;
+    }
+    return static_cast<uint64_t>(llround(scaled));
+}
+
+static inline double dequantize(uint64_t value, double scale)
+{
+    return static_cast<double>(static_cast<int64_t>(value)) / scale;
+}
+
+static_assert(FIELD_SCALED + sizeof(sDoubleFields) / sizeof(sDoubleFields[0]) +
+        sizeof(sFloatFields) / sizeof(sFloatFields[0]) == 16,
+        "LocDeltaBatch::FIELD_COUNT is off");
+
+LocDeltaBatch::LocDeltaBatch() :
+    mCount(0)
+{
+    memset(mLast, 0, sizeof(mLast));
+}
+
+void LocDeltaBatch::append(const Location& location)
+{
+    LocationFlagsMask flags = location.flags;
+    putDelta(mBytes, flags, mLast[FIELD_FLAGS]);
+    putDelta(mBytes, location.techMask, mLast[FIELD_TECH_MASK]);
+    putDelta(mBytes, location.timestamp, mLast[FIELD_TIMESTAMP]);
+    if (flags & LOCATION_HAS_SPOOF_MASK) {
+        putDelta(mBytes, location.spoofMask, mLast[FIELD_SPOOF_MASK]);
+    }
+    if (flags & LOCATION_HAS_ELAPSED_REAL_TIME) {
+        putDelta(mBytes, location.elapsedRealTime, mLast[FIELD_ELAPSED_REAL_TIME]);
+        putDelta(mBytes, location.elapsedRealTimeUnc, mLast[FIELD_ELAPSED_REAL_TIME_UNC]);
+    }
+    size_t field = FIELD_SCALED;
+    for (const DeltaField<double>& f : sDoubleFields) {
+        if (flags & f.flag) {
+            putDelta(mBytes, quantize(location.*(f.field), f.scale), mLast[field]);
+        }
+        field++;
+    }
+    for (const DeltaField<float>& f : sFloatFields) {
+        if (flags & f.flag) {
+            putDelta(mBytes, quantize(location.*(f.field), f.scale), mLast[field]);
+        }
+        field++;
+    }
+    mCount++;
+}
+
+void LocDeltaBatch::append(const Location* locations, size_t count)
+{
+    if (nullptr == locations) {
+        return;
+    }
+    mBytes.reserve(mBytes.size() + count * LOC_DELTA_BATCH_BYTES_PER_FIX);
+    for (size_t i = 0; i < count; i++) {
+        append(locations[i]);
+    }
+}
+
+void LocDeltaBatch::clear()
+{
+    mBytes.clear();
+    mCount = 0;
+    memset(mLast, 0, sizeof(mLast));
+}
+
+LocDeltaBatch::Reader::Reader(const LocDeltaBatch& batch) :
+    mBatch(batch),
+    mOffset(0),
+    mRead(0)
+{
+    memset(mLast, 0, sizeof(mLast));
+}
+
+bool LocDeltaBatch::Reader::next(Location& location)
+{
+    if (mRead >= mBatch.mCount) {
+        return false;
+    }
+    const std::vector<uint8_t>& in = mBatch.mBytes;
+    memset(&location, 0, sizeof(Location));
+    location.size = sizeof(Location);
+    location.flags = static_cast<LocationFlagsMask>(getDelta(in, mOffset, mLast[FIELD_FLAGS]));
+    location.techMask =
+            static_cast<LocationTechnologyMask>(getDelta(in, mOffset, mLast[FIELD_TECH_MASK]));
+    location.timestamp = getDelta(in, mOffset, mLast[FIELD_TIMESTAMP]);
+    LocationFlagsMask flags = location.flags;
+    if (flags & LOCATION_HAS_SPOOF_MASK) {
+        location.spoofMask =
+                static_cast<LocationSpoofMask>(getDelta(in, mOffset, mLast[FIELD_SPOOF_MASK]));
+    }
+    if (flags & LOCATION_HAS_ELAPSED_REAL_TIME) {
+        location.elapsedRealTime = getDelta(in, mOffset, mLast[FIELD_ELAPSED_REAL_TIME]);
+        location.elapsedRealTimeUnc =
+                getDelta(in, mOffset, mLast[FIELD_ELAPSED_REAL_TIME_UNC]);
+    }
+    size_t field = FIELD_SCALED;
+    for (const DeltaField<double>& f : sDoubleFields) {
+        if (flags & f.flag) {
+            location.*(f.field) = dequantize(getDelta(in, mOffset, mLast[field]), f.scale);
+        }
+        field++;
+    }
+    for (const DeltaField<float>& f : sFloatFields) {
+        if (flags & f.flag) {
+            location.*(f.field) = static_cast<float>(
+                    dequantize(getDelta(in, mOffset, mLast[field]), f.scale));
+        }
+        field++;
+    }
+    mRead++;
+    return true;
+}
+
+} // namespace loc_util
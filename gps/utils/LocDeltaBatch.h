@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOC_DELTA_BATCH_H
+#define LOC_DELTA_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <LocationDataTypes.h>
+
+namespace loc_util {
+
+// Batched fixes kept as a byte stream instead of an array of Location, for
+// the copies that outlive the report of a long trip or a big flush. Each fix
+// is its delta to the previous one, in zigzag varints:
+//   timestamp and elapsedRealTime      exact, in ms / ns
+//   latitude, longitude                in 1e-8 degrees (about 1 mm)
+//   altitude                           in mm
+//   speed, accuracies                  in mm, mm/s
+//   bearing, bearingAccuracy           in 1e-3 degrees
+//   conformityIndex                    in 1e-6
+// and only the fields the flags mark valid are stored, so a fix of a trip
+// takes some 15 to 25 bytes rather than sizeof(Location). The decoded fixes
+// are the stored ones rounded to these steps, with the fields not marked
+// valid zeroed.
+class LocDeltaBatch {
+    enum { FIELD_COUNT = 16 };
+public:
+    LocDeltaBatch();
+
+    void append(const Location& location);
+    void append(const Location* locations, size_t count);
+    void clear();
+
+    // fixes stored
+    inline size_t size() const { return mCount; }
+    inline bool empty() const { return 0 == mCount; }
+    // encoded bytes
+    inline size_t byteSize() const { return mBytes.size(); }
+
+    // Decodes the fixes front to back, one at a time; the batch must outlive
+    // the reader and not be appended to while it is read.
+    class Reader {
+    public:
+        Reader(const LocDeltaBatch& batch);
+        // false once all fixes were read
+        bool next(Location& location);
+        inline size_t remaining() const { return mBatch.mCount - mRead; }
+    private:
+        const LocDeltaBatch& mBatch;
+        size_t mOffset;
+        size_t mRead;
+        uint64_t mLast[FIELD_COUNT];
+    };
+
+private:
+    // the fields of the previous fix, quantized; writer and reader delta the
+    // same integers, so the rounding does not add up along the batch
+    uint64_t mLast[FIELD_COUNT];
+    size_t mCount;
+    std::vector<uint8_t> mBytes;
+};
+
+} // namespace loc_util
+
+#endif // LOC_DELTA_BATCH_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOC_FIXED_RING_H
+#define LOC_FIXED_RING_H
+
+#include <stdint.h>
+#include <new>
+#include <utility>
+
+namespace loc_util {
+
+// Fixed capacity FIFO with inline storage. Once N elements are held, adding
+// one more destroys the oldest. Index 0 and front() are the oldest element,
+// back() the newest. Elements are constructed in place and never shifted,
+// and the container never allocates. emplace_back / push_back arguments must
+// not refer to an element of the same ring, since the oldest element may be
+// destroyed before the new one is constructed. Not thread safe.
+template <typename T, uint32_t N>
+class LocFixedRing {
+    static_assert(N > 0, "LocFixedRing capacity must be positive");
+
+    alignas(T) unsigned char mStorage[N * sizeof(T)];
+    uint32_t mHead;
+    uint32_t mSize;
+
+    inline T* slot(uint32_t index) {
+        return reinterpret_cast<T*>(mStorage) + ((mHead + index) % N);
+    }
+    inline const T* slot(uint32_t index) const {
+        return reinterpret_cast<const T*>(mStorage) + ((mHead + index) % N);
+    }
+
+public:
+    class const_iterator {
+        const LocFixedRing* mRing;
+        uint32_t mIndex;
+    public:
+        inline const_iterator(const LocFixedRing* ring, uint32_t index) :
+            mRing(ring), mIndex(index) {}
+        inline const T& operator*() const { return (*mRing)[mIndex]; }
+        inline const T* operator->() const { return &(*mRing)[mIndex]; }
+        inline const_iterator& operator++() { mIndex++; return *this; }
+        inline bool operator==(const const_iterator& other) const {
+            return mRing == other.mRing && mIndex == other.mIndex;
+        }
+        inline bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    inline LocFixedRing() : mHead(0), mSize(0) {}
+    inline LocFixedRing(const LocFixedRing& other) : mHead(0), mSize(0) {
+        for (uint32_t i = 0; i < other.mSize; i++) {
+            emplace_back(other[i]);
+        }
+    }
+    inline LocFixedRing& operator=(const LocFixedRing& other) {
+        if (this != &other) {
+            clear();
+            for (uint32_t i = 0; i < other.mSize; i++) {
+                emplace_back(other[i]);
+            }
+        }
+        return *this;
+    }
+    inline ~LocFixedRing() { clear(); }
+
+    inline uint32_t size() const { return mSize; }
+    inline bool empty() const { return 0 == mSize; }
+    inline bool full() const { return N == mSize; }
+    static inline uint32_t capacity() { return N; }
+
+    inline T& operator[](uint32_t index) { return *slot(index); }
+    inline const T& operator[](uint32_t index) const { return *slot(index); }
+    inline T& front() { return *slot(0); }
+    inline const T& front() const { return *slot(0); }
+    inline T& back() { return *slot(mSize - 1); }
+    inline const T& back() const { return *slot(mSize - 1); }
+
+    inline const_iterator begin() const { return const_iterator(this, 0); }
+    inline const_iterator end() const { return const_iterator(this, mSize); }
+
+    template <typename... ARGS>
+    inline T& emplace_back(ARGS&&... args) {
+        if (full()) {
+            pop_front();
+        }
+        T* p = new (slot(mSize)) T(std::forward<ARGS>(args)...);
+        mSize++;
+        return *p;
+    }
+    inline void push_back(const T& val) { emplace_back(val); }
+    inline void push_back(T&& val) { emplace_back(std::move(val)); }
+
+    // ring must not be empty
+    inline void pop_front() {
+        slot(0)->~T();
+        mHead = (mHead + 1) % N;
+        mSize--;
+    }
+    // moves the oldest element out and removes it; ring must not be empty
+    inline T take_front() {
+        T val(std::move(*slot(0)));
+        pop_front();
+        return val;
+    }
+
+    inline void clear() {
+        while (mSize > 0) {
+            pop_front();
+        }
+        mHead = 0;
+    }
+};
+
+} // namespace loc_util
+
+#endif // LOC_FIXED_RING_H
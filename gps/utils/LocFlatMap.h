@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOC_FLAT_MAP_H
+#define LOC_FLAT_MAP_H
+
+#include <stddef.h>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace loc_util {
+
+// Ordered map kept as a sorted vector of (key, value) pairs. Meant for the
+// small, rarely modified and frequently iterated maps of the adapters (clients,
+// sessions), where walking contiguous storage beats chasing tree nodes.
+// Iteration order is the Compare order, same as std::map. Unlike std::map,
+// any insert or erase invalidates all iterators, pointers and references into
+// the container. Keys are not meant to be changed through an iterator.
+// Not thread safe.
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<Key, T>>>
+class LocFlatMap {
+public:
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef std::pair<Key, T> value_type;
+    typedef typename std::vector<value_type, Allocator>::iterator iterator;
+    typedef typename std::vector<value_type, Allocator>::const_iterator const_iterator;
+
+private:
+    std::vector<value_type, Allocator> mItems;
+    Compare mCompare;
+
+    inline bool keyLess(const value_type& item, const Key& key) const {
+        return mCompare(item.first, key);
+    }
+
+public:
+    inline iterator begin() { return mItems.begin(); }
+    inline iterator end() { return mItems.end(); }
+    inline const_iterator begin() const { return mItems.begin(); }
+    inline const_iterator end() const { return mItems.end(); }
+
+    inline size_t size() const { return mItems.size(); }
+    inline bool empty() const { return mItems.empty(); }
+    inline void clear() { mItems.clear(); }
+    inline void reserve(size_t n) { mItems.reserve(n); }
+
+    inline iterator lower_bound(const Key& key) {
+        return std::lower_bound(mItems.begin(), mItems.end(), key,
+                [this] (const value_type& item, const Key& k) { return keyLess(item, k); });
+    }
+    inline const_iterator lower_bound(const Key& key) const {
+        return std::lower_bound(mItems.begin(), mItems.end(), key,
+                [this] (const value_type& item, const Key& k) { return keyLess(item, k); });
+    }
+
+    inline iterator find(const Key& key) {
+        iterator it = lower_bound(key);
+        return (it != mItems.end() && !mCompare(key, it->first)) ? it : mItems.end();
+    }
+    inline const_iterator find(const Key& key) const {
+        const_iterator it = lower_bound(key);
+        return (it != mItems.end() && !mCompare(key, it->first)) ? it : mItems.end();
+    }
+    inline size_t count(const Key& key) const { return (find(key) != end()) ? 1 : 0; }
+
+    // Returns the existing entry and false when key is already present
+    inline std::pair<iterator, bool> insert(const value_type& item) {
+        iterator it = lower_bound(item.first);
+        if (it != mItems.end() && !mCompare(item.first, it->first)) {
+            return std::make_pair(it, false);
+        }
+        return std::make_pair(mItems.insert(it, item), true);
+    }
+
+    inline T& operator[](const Key& key) {
+        iterator it = lower_bound(key);
+        if (it == mItems.end() || mCompare(key, it->first)) {
+            it = mItems.insert(it, value_type(key, T()));
+        }
+        return it->second;
+    }
+
+    inline iterator erase(iterator it) { return mItems.erase(it); }
+    inline size_t erase(const Key& key) {
+        iterator it = find(key);
+        if (it == mItems.end()) {
+            return 0;
+        }
+        mItems.erase(it);
+        return 1;
+    }
+};
+
+} // namespace loc_util
+
+#endif // LOC_FLAT_MAP_H
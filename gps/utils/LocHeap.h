@@ -30,13 +30,20 @@
 #define __LOC_HEAP__
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#include <vector>
 
 namespace loc_util {
 
 // abstract class to be implemented by client to provide a rankable class
 class LocRankable {
+    friend class LocHeap;
+    // index of this obj in the LocHeap array, -1 if not in a heap.
+    // An obj can be in at most one heap at a time.
+    int mHeapIndex;
 public:
+    inline LocRankable() : mHeapIndex(-1) {}
     virtual inline ~LocRankable() {}
 
     // method to rank objects of such type for sorting purposes.
@@ -50,23 +57,29 @@ public:
     inline bool outRanks(LocRankable& rankable) { return ranks(rankable) > 0; }
 };
 
-// opaque class to provide service implementation.
-class LocHeapNode;
-
-// a heap whose left and right children are not sorted. It is sorted only vertically,
-// i.e. parent always ranks higher than children, if they exist. Ranking algorithm is
-// implemented in Rankable. The reason that there is no sort between children is to
-// help beter balance the tree with lower cost. When a node is pushed to the tree,
-// it is guaranteed that the subtree that is smaller gets to have the new node.
+// a d-ary heap kept in a contiguous array, sorted only vertically, i.e. parent
+// always ranks higher than children, if they exist. Ranking algorithm is
+// implemented in Rankable. Each node keeps its own array index, so that it can
+// be removed without searching for it. There is no per node allocation, and
+// the array is always complete, so the tree is always balanced.
 class LocHeap {
 protected:
-    LocHeapNode* mTree;
+    // number of children of each node
+    static const uint32_t ARITY = 4;
+    std::vector<LocRankable*> mTree;
+
+    // move the node at index up / down until the heap is sorted again
+    void siftUp(uint32_t index);
+    void siftDown(uint32_t index);
+    inline void place(LocRankable* node, uint32_t index) {
+        mTree[index] = node;
+        node->mHeapIndex = (int)index;
+    }
 public:
-    inline LocHeap() : mTree(NULL) {}
+    inline LocHeap() {}
     ~LocHeap();
 
-    // push keeps the tree sorted by rank, it also tries to balance the
-    // tree by adding the new node to the smaller of the subtrees.
+    // push keeps the tree sorted by rank, in O(log n).
     // node is reference to an obj that is managed by client, that client
     //      creates and destroyes. The destroy should happen after the
     //      node is popped out from the heap.
@@ -78,15 +91,14 @@ public:
     //         the tree top.
     LocRankable* peek();
 
-    // pop keeps the tree sorted by rank, but it does not try to balance
-    // the tree.
+    // pop keeps the tree sorted by rank, in O(log n).
     // Return - pointer to the node popped out, or NULL if heap is already empty
     LocRankable* pop();
 
-    // navigating through the tree and find the node that ranks the same
-    // as the input data, then remove it from the tree. Rank is implemented
-    // by rankable obj.
-    // returns the pointer to the node removed; or NULL (if failed).
+    // remove the input obj from the tree, found by its array index, in
+    // O(log n).
+    // returns the pointer to the node removed; or NULL (if the obj is not
+    //         in this heap).
     LocRankable* remove(LocRankable& rankable);
 
 #ifdef __LOC_UNIT_TEST__
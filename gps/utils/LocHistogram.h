@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef __LOC_HISTOGRAM_H__
+#define __LOC_HISTOGRAM_H__
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <atomic>
+#include <string>
+
+namespace loc_util {
+
+// Lock-free histogram with power-of-2 buckets, meant to be recorded into on a
+// hot path by one or more threads and read from any thread for dumps.
+// Bucket 0 holds the value 0; bucket i (i > 0) holds values in
+// [2^(i-1), 2^i). Percentiles are therefore reported as the upper bound of
+// the bucket they fall in, which is within a factor of 2 of the real value.
+class LocHistogram {
+public:
+    static const uint32_t kBuckets = 40;
+
+    inline LocHistogram() { reset(); }
+
+    inline void record(uint64_t value) {
+        uint32_t i = 0;
+        if (value > 0) {
+            i = 64 - __builtin_clzll(value);
+            if (i >= kBuckets) {
+                i = kBuckets - 1;
+            }
+        }
+        mBuckets[i].fetch_add(1, std::memory_order_relaxed);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+        mSum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = mMax.load(std::memory_order_relaxed);
+        while (value > max &&
+               !mMax.compare_exchange_weak(max, value, std::memory_order_relaxed));
+    }
+
+    inline void reset() {
+        for (uint32_t i = 0; i < kBuckets; i++) {
+            mBuckets[i].store(0, std::memory_order_relaxed);
+        }
+        mCount.store(0, std::memory_order_relaxed);
+        mSum.store(0, std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+    inline uint64_t getCount() const { return mCount.load(std::memory_order_relaxed); }
+    inline uint64_t getMax() const { return mMax.load(std::memory_order_relaxed); }
+    inline uint64_t getMean() const {
+        uint64_t count = getCount();
+        return (0 == count) ? 0 : mSum.load(std::memory_order_relaxed) / count;
+    }
+
+    // pct in [0, 100]; 0 if nothing has been recorded
+    inline uint64_t getPercentile(uint32_t pct) const {
+        uint64_t count = getCount();
+        if (0 == count) {
+            return 0;
+        }
+        uint64_t rank = (count * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < kBuckets; i++) {
+            seen += mBuckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank && seen > 0) {
+                uint64_t upper = (0 == i) ? 0 : ((1ULL << i) - 1);
+                uint64_t max = getMax();
+                return (upper < max) ? upper : max;
+            }
+        }
+        return getMax();
+    }
+
+    // appends "n=.. mean=.. p50=.. p90=.. p95=.. p99=.. max=.." followed by unit
+    inline void dump(std::string& out, const char* unit) const {
+        char buf[192];
+        snprintf(buf, sizeof(buf),
+                 "n=%" PRIu64 " mean=%" PRIu64 " p50=%" PRIu64 " p90=%" PRIu64
+                 " p95=%" PRIu64 " p99=%" PRIu64 " max=%" PRIu64 "%s",
+                 getCount(), getMean(), getPercentile(50), getPercentile(90),
+                 getPercentile(95), getPercentile(99), getMax(),
+                 (nullptr != unit) ? unit : "");
+        out += buf;
+    }
+
+private:
+    std::atomic<uint64_t> mBuckets[kBuckets];
+    std::atomic<uint64_t> mCount;
+    std::atomic<uint64_t> mSum;
+    std::atomic<uint64_t> mMax;
+};
+
+// Rolling view over two LocHistogram windows of windowNs each. Records go
+// into the current window; the first record past its end resets the older
+// window and makes it current. Dumps show the last complete window and the
+// one in progress, so percentiles track recent behavior instead of the
+// whole process lifetime.
+class LocRollingHistogram {
+public:
+    inline explicit LocRollingHistogram(uint64_t windowNs) :
+        mWindowNs(windowNs), mWindowStartNs(0), mCurrent(0) {}
+
+    // nowNs is any monotonic clock, as long as every caller uses the same one
+    inline void record(uint64_t value, uint64_t nowNs) {
+        uint64_t start = mWindowStartNs.load(std::memory_order_relaxed);
+        if (0 == start) {
+            mWindowStartNs.compare_exchange_strong(start, nowNs, std::memory_order_relaxed);
+        } else if (nowNs - start >= mWindowNs &&
+                   mWindowStartNs.compare_exchange_strong(start, nowNs,
+                                                          std::memory_order_relaxed)) {
+            uint32_t next = mCurrent.load(std::memory_order_relaxed) ^ 1;
+            mWindows[next].reset();
+            mCurrent.store(next, std::memory_order_release);
+        }
+        mWindows[mCurrent.load(std::memory_order_acquire)].record(value);
+    }
+
+    inline const LocHistogram& getCurrent() const {
+        return mWindows[mCurrent.load(std::memory_order_acquire)];
+    }
+    inline const LocHistogram& getPrevious() const {
+        return mWindows[mCurrent.load(std::memory_order_acquire) ^ 1];
+    }
+
+    // appends "last: <LocHistogram::dump> cur: <LocHistogram::dump>"
+    inline void dump(std::string& out, const char* unit) const {
+        uint32_t current = mCurrent.load(std::memory_order_acquire);
+        out += "last: ";
+        mWindows[current ^ 1].dump(out, unit);
+        out += " cur: ";
+        mWindows[current].dump(out, unit);
+    }
+
+private:
+    const uint64_t mWindowNs;
+    std::atomic<uint64_t> mWindowStartNs;
+    std::atomic<uint32_t> mCurrent;
+    LocHistogram mWindows[2];
+};
+
+} // namespace loc_util
+
+#endif //__LOC_HISTOGRAM_H__
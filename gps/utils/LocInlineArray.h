@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOC_INLINE_ARRAY_H
+#define LOC_INLINE_ARRAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+
+namespace loc_util {
+
+// Array of a size set at construction, for the ids and errors of collective
+// responses. Up to N elements are held inline, only larger arrays go to the
+// heap. T must be trivially copyable; elements are value initialized or
+// copied from a source. An array that failed to allocate has size() 0.
+template <typename T, uint32_t N>
+class LocInlineArray {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "LocInlineArray holds trivially copyable types only");
+
+    T mInline[N];
+    T* mData;
+    size_t mSize;
+
+    inline void init(size_t count) {
+        mData = mInline;
+        mSize = count;
+        if (count > N) {
+            mData = new (std::nothrow) T[count];
+            if (nullptr == mData) {
+                mData = mInline;
+                mSize = 0;
+            }
+        }
+    }
+
+public:
+    inline LocInlineArray(size_t count = 0) : mInline() {
+        init(count);
+        if (mData != mInline) {
+            for (size_t i = 0; i < mSize; i++) {
+                mData[i] = T();
+            }
+        }
+    }
+    inline LocInlineArray(size_t count, const T& val) {
+        init(count);
+        for (size_t i = 0; i < mSize; i++) {
+            mData[i] = val;
+        }
+    }
+    // copies count elements from src, if it is not NULL
+    inline LocInlineArray(const T* src, size_t count) : mInline() {
+        init(count);
+        if (nullptr != src && mSize > 0) {
+            memcpy(mData, src, mSize * sizeof(T));
+        }
+    }
+    inline LocInlineArray(const LocInlineArray& other) :
+        LocInlineArray(other.mData, other.mSize) {}
+    LocInlineArray& operator=(const LocInlineArray& other) = delete;
+    inline ~LocInlineArray() {
+        if (mData != mInline) {
+            delete[] mData;
+        }
+    }
+
+    inline size_t size() const { return mSize; }
+    inline bool empty() const { return 0 == mSize; }
+    inline T* data() { return mData; }
+    inline const T* data() const { return mData; }
+    inline T& operator[](size_t index) { return mData[index]; }
+    inline const T& operator[](size_t index) const { return mData[index]; }
+    inline T* begin() { return mData; }
+    inline T* end() { return mData + mSize; }
+    inline const T* begin() const { return mData; }
+    inline const T* end() const { return mData + mSize; }
+};
+
+} // namespace loc_util
+
+#endif // LOC_INLINE_ARRAY_H
@@ -29,6 +29,9 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <netinet/in.h>
 #include <netdb.h>
@@ -36,6 +39,11 @@
 #include <log_util.h>
 #include <LocIpc.h>
 #include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include <inttypes.h>
+#include <time.h>
 
 using namespace std;
 
@@ -58,12 +66,63 @@ namespace loc_util {
         } \
     }
 
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+static int createMemFd(const char* name) {
+#ifdef __NR_memfd_create
+    return (int)syscall(__NR_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+LocIpcStats::LocIpcStats() : mStartNs(monotonicNs()),
+        mSentMsgs(0), mSentBytes(0), mSendSyscalls(0),
+        mRecvMsgs(0), mRecvBytes(0), mRecvSyscalls(0),
+        mSentFragmentedMsgs(0), mSentFdMsgs(0), mRecvFragmentedMsgs(0), mRecvFdMsgs(0) {}
+
+static LocIpcStats& stats() {
+    static LocIpcStats sStats;
+    return sStats;
+}
+
+#define LOC_IPC_STAT_ADD(field, n) stats().field.fetch_add((n), std::memory_order_relaxed)
+
+// accounts for a msg handed to the listener, dispatch started at startNs
+static inline void recordRecv(uint64_t len, uint64_t startNs) {
+    LOC_IPC_STAT_ADD(mRecvMsgs, 1);
+    LOC_IPC_STAT_ADD(mRecvBytes, len);
+    stats().mRecvSizes.record(len);
+    stats().mDispatchUs.record((monotonicNs() - startNs) / 1000);
+}
+
 const char Sock::MSG_ABORT[] = "LocIpc::Sock::ABORT";
 const char Sock::LOC_IPC_HEAD[] = "$MSGLEN$";
+// not valid UTF-8, so it can not be mistaken for the text protocol above
+const uint32_t Sock::FRAME_MAGIC = 0xF1C0A5E7;
+const uint8_t Sock::FRAME_VERSION = 1;
+
+ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
+                   socklen_t addrlen) const {
+    return send(buf, len, flags, destAddr, addrlen, -1, 0);
+}
 ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
-                          socklen_t addrlen) const {
+                   socklen_t addrlen, int32_t msgId, uint32_t peerCaps) const {
     ssize_t rtv = -1;
-    SOCK_OP_AND_LOG(buf, len, isValid(), rtv, sendto(buf, len, flags, destAddr, addrlen));
+    SOCK_OP_AND_LOG(buf, len, isValid(), rtv,
+                    sendto(buf, len, flags, destAddr, addrlen, msgId, peerCaps));
     return rtv;
 }
 ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
@@ -77,70 +136,275 @@ ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>
     return rtv;
 }
 ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
-                     socklen_t addrlen) const {
+                     socklen_t addrlen, int32_t msgId, uint32_t peerCaps) const {
     ssize_t rtv = -1;
     if (len <= mMaxTxSize) {
         rtv = ::sendto(mSid, buf, len, flags, destAddr, addrlen);
+        LOC_IPC_STAT_ADD(mSendSyscalls, 1);
+    } else if ((peerCaps & LOC_IPC_PEER_CAP_LARGE_MSG_BY_FD) &&
+               (rtv = sendByFd(buf, len, flags, destAddr, addrlen, msgId)) > 0) {
+        // handed over in one datagram
+    } else if (peerCaps & LOC_IPC_PEER_CAP_BINARY_FRAMING) {
+        FrameHead head = {FRAME_MAGIC, FRAME_VERSION, FRAME_FLAG_FRAGMENTED, sizeof(FrameHead),
+                          msgId, (uint32_t)len};
+        rtv = ::sendto(mSid, &head, sizeof(head), flags, destAddr, addrlen);
+        LOC_IPC_STAT_ADD(mSendSyscalls, 1);
+        if (rtv > 0) {
+            rtv = sendFragments(buf, len, flags, destAddr, addrlen);
+            rtv = (rtv > 0) ? (sizeof(head) + len) : -1;
+        }
     } else {
         std::string head(LOC_IPC_HEAD + to_string(len));
         rtv = ::sendto(mSid, head.c_str(), head.length(), flags, destAddr, addrlen);
+        LOC_IPC_STAT_ADD(mSendSyscalls, 1);
         if (rtv > 0) {
-            for (size_t offset = 0; offset < len && rtv > 0; offset += rtv) {
-                rtv = ::sendto(mSid, (char*)buf + offset, min(len - offset, (size_t)mMaxTxSize),
-                               flags, destAddr, addrlen);
-            }
+            rtv = sendFragments(buf, len, flags, destAddr, addrlen);
             rtv = (rtv > 0) ? (head.length() + len) : -1;
         }
     }
+    if (rtv > 0) {
+        LOC_IPC_STAT_ADD(mSentMsgs, 1);
+        LOC_IPC_STAT_ADD(mSentBytes, len);
+        stats().mSentSizes.record(len);
+    }
+    return rtv;
+}
+// Sends len bytes as mMaxTxSize datagrams, up to LOC_IPC_MAX_BATCH per syscall
+ssize_t Sock::sendFragments(const void *buf, size_t len, int flags,
+                            const struct sockaddr *destAddr, socklen_t addrlen) const {
+    struct mmsghdr msgs[LOC_IPC_MAX_BATCH];
+    struct iovec iovs[LOC_IPC_MAX_BATCH];
+    size_t offset = 0;
+    while (offset < len) {
+        unsigned int count = 0;
+        for (size_t next = offset; next < len && count < LOC_IPC_MAX_BATCH;
+             next += iovs[count++].iov_len) {
+            iovs[count].iov_base = (char*)buf + next;
+            iovs[count].iov_len = min(len - next, (size_t)mMaxTxSize);
+            memset(&msgs[count], 0, sizeof(msgs[count]));
+            msgs[count].msg_hdr.msg_name = (void*)destAddr;
+            msgs[count].msg_hdr.msg_namelen = addrlen;
+            msgs[count].msg_hdr.msg_iov = &iovs[count];
+            msgs[count].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = ::sendmmsg(mSid, msgs, count, flags);
+        LOC_IPC_STAT_ADD(mSendSyscalls, 1);
+        if (sent <= 0) {
+            return -1;
+        }
+        for (int i = 0; i < sent; i++) {
+            offset += iovs[i].iov_len;
+        }
+    }
+    LOC_IPC_STAT_ADD(mSentFragmentedMsgs, 1);
+    return len;
+}
+// Writes the payload into a sealed memfd and sends only a frame head with
+// the fd attached, so the recver maps the payload instead of reassembling it
+// from mMaxTxSize chunks. Returns -1 if memfd is not available, in which case
+// nothing was sent and the caller falls back to chunking.
+ssize_t Sock::sendByFd(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
+                       socklen_t addrlen, int32_t msgId) const {
+    int fd = createMemFd("LocIpc");
+    if (fd < 0) {
+        LOC_LOGw("memfd_create failed, reason: %s", strerror(errno));
+        return -1;
+    }
+
+    ssize_t rtv = 0;
+    for (size_t offset = 0; offset < len && rtv >= 0; offset += rtv) {
+        rtv = ::write(fd, (const char*)buf + offset, len - offset);
+    }
+#ifdef F_ADD_SEALS
+    if (rtv >= 0) {
+        // the recver can trust the size and content while it has it mapped
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    }
+#endif
+
+    if (rtv >= 0) {
+        FrameHead head = {FRAME_MAGIC, FRAME_VERSION, FRAME_FLAG_FD, sizeof(FrameHead),
+                          msgId, (uint32_t)len};
+        struct iovec iov = { &head, sizeof(head) };
+        union {
+            struct cmsghdr align;
+            char buf[CMSG_SPACE(sizeof(int))];
+        } control = {};
+        struct msghdr msg = {};
+        msg.msg_name = (void*)destAddr;
+        msg.msg_namelen = addrlen;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+        rtv = ::sendmsg(mSid, &msg, flags);
+        LOC_IPC_STAT_ADD(mSendSyscalls, 1);
+        if (rtv > 0) {
+            LOC_IPC_STAT_ADD(mSentFdMsgs, 1);
+        }
+        rtv = (rtv > 0) ? (sizeof(head) + len) : -1;
+    }
+
+    ::close(fd);
     return rtv;
 }
+ssize_t Sock::recvByFd(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                       int fd, size_t msgLen) const {
+    ssize_t nBytes = -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < msgLen) {
+        LOC_LOGe("invalid payload fd, size %zu", msgLen);
+    } else if (0 == msgLen) {
+        nBytes = 0;
+    } else {
+        void* data = mmap(nullptr, msgLen, PROT_READ, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == data) {
+            LOC_LOGe("mmap failed, reason: %s", strerror(errno));
+        } else {
+            nBytes = msgLen;
+            uint64_t startNs = monotonicNs();
+            dataCb->onReceive((const char*)data, nBytes, &recver);
+            recordRecv(msgLen, startNs);
+            LOC_IPC_STAT_ADD(mRecvFdMsgs, 1);
+            munmap(data, msgLen);
+        }
+    }
+    ::close(fd);
+    return nBytes;
+}
+ssize_t Sock::recvFragments(const LocIpcRecver& recver,
+                            const shared_ptr<ILocIpcListener>& dataCb, int sid, int flags,
+                            struct sockaddr *srcAddr, socklen_t *addrlen,
+                            std::string& msg, size_t msgLenReceived) const {
+    ssize_t nBytes = 1;
+    for (; (msgLenReceived < msg.size()) && (nBytes > 0); msgLenReceived += nBytes) {
+        nBytes = ::recvfrom(sid, &(msg[msgLenReceived]), msg.size() - msgLenReceived,
+                            flags, srcAddr, addrlen);
+        LOC_IPC_STAT_ADD(mRecvSyscalls, 1);
+    }
+    if (nBytes > 0) {
+        nBytes = msg.size();
+        uint64_t startNs = monotonicNs();
+        dataCb->onReceive(msg.data(), nBytes, &recver);
+        recordRecv(msg.size(), startNs);
+        LOC_IPC_STAT_ADD(mRecvFragmentedMsgs, 1);
+    }
+    return nBytes;
+}
 ssize_t Sock::recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const  {
     std::string msg(mMaxTxSize, 0);
-    ssize_t nBytes = ::recvfrom(sid, (void*)msg.data(), msg.size(), flags, srcAddr, addrlen);
-    if (nBytes > 0) {
-        if (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
-            LOC_LOGi("recvd abort msg.data %s", msg.data());
+    // recvmsg so that an fd passed along with the datagram is not lost
+    struct iovec iov = { (void*)msg.data(), msg.size() };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr hdr = {};
+    hdr.msg_name = srcAddr;
+    hdr.msg_namelen = (nullptr != addrlen) ? *addrlen : 0;
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control.buf;
+    hdr.msg_controllen = sizeof(control.buf);
+    ssize_t nBytes = ::recvmsg(sid, &hdr, flags | MSG_CMSG_CLOEXEC);
+    LOC_IPC_STAT_ADD(mRecvSyscalls, 1);
+    if (nullptr != addrlen) {
+        *addrlen = hdr.msg_namelen;
+    }
+
+    int fd = -1;
+    if (nBytes >= 0 && hdr.msg_controllen > 0) {
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); nullptr != cmsg;
+             cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+            if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type &&
+                cmsg->cmsg_len >= CMSG_LEN(sizeof(int))) {
+                memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+    }
+
+    // a long msg head is followed by its fragments
+    auto recvLong = [&](size_t msgLen) -> ssize_t {
+        uint64_t startNs = monotonicNs();
+        std::string longMsg(msgLen, 0);
+        ssize_t rtv = recvFragments(recver, dataCb, sid, flags, srcAddr, addrlen, longMsg, 0);
+        stats().mReassemblyUs.record((monotonicNs() - startNs) / 1000);
+        return rtv;
+    };
+
+    FrameHead head;
+    if (nBytes <= 0) {
+        // error or peer gone
+    } else if ((size_t)nBytes == sizeof(head) &&
+               0 == memcmp(msg.data(), &FRAME_MAGIC, sizeof(FRAME_MAGIC))) {
+        // binary frame head, without any string parsing
+        memcpy(&head, msg.data(), sizeof(head));
+        if (head.flags & FRAME_FLAG_ABORT) {
+            LOC_LOGi("recvd abort frame");
             nBytes = 0;
-        } else if (strncmp(msg.data(), LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
-            // short message
-            msg.resize(nBytes);
-            dataCb->onReceive(msg.data(), nBytes, &recver);
+        } else if ((head.flags & FRAME_FLAG_FD) && -1 != fd) {
+            nBytes = recvByFd(recver, dataCb, fd, head.length);
+            // an empty payload is not an error, keep listening
+            nBytes = (0 == nBytes) ? 1 : nBytes;
+            fd = -1;
+        } else if (head.flags & FRAME_FLAG_FRAGMENTED) {
+            nBytes = recvLong(head.length);
         } else {
-            // long message
-            size_t msgLen = 0;
-            sscanf(msg.data() + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
-            msg.resize(msgLen);
-            for (size_t msgLenReceived = 0; (msgLenReceived < msgLen) && (nBytes > 0);
-                 msgLenReceived += nBytes) {
-                nBytes = ::recvfrom(sid, &(msg[msgLenReceived]), msg.size() - msgLenReceived,
-                                    flags, srcAddr, addrlen);
-            }
-            if (nBytes > 0) {
-                nBytes = msgLen;
-                dataCb->onReceive(msg.data(), nBytes, &recver);
-            }
+            LOC_LOGw("dropping frame v%u flags 0x%x", head.version, head.flags);
         }
+    } else if ((MSG_ABORT[0] != msg[0] && LOC_IPC_HEAD[0] != msg[0]) ||
+               (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) != 0 &&
+                strncmp(msg.data(), LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1) != 0)) {
+        // short message
+        uint64_t startNs = monotonicNs();
+        dataCb->onReceive(msg.data(), nBytes, &recver);
+        recordRecv(nBytes, startNs);
+    } else if (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
+        LOC_LOGi("recvd abort msg.data %s", msg.data());
+        nBytes = 0;
+    } else {
+        // long message from a peer on the text protocol
+        size_t msgLen = 0;
+        msg.resize(nBytes);
+        sscanf(msg.data() + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
+        nBytes = recvLong(msgLen);
     }
 
+    if (-1 != fd) {
+        // not expected with this msg, do not leak it
+        ::close(fd);
+    }
     return nBytes;
 }
 ssize_t Sock::sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen) {
-    return send(MSG_ABORT, sizeof(MSG_ABORT), flags, destAddr, addrlen);
+    // only ever sent to our own recver, which always understands frames
+    FrameHead head = {FRAME_MAGIC, FRAME_VERSION, FRAME_FLAG_ABORT, sizeof(FrameHead), -1, 0};
+    return send(&head, sizeof(head), flags, destAddr, addrlen);
 }
 
 class LocIpcLocalSender : public LocIpcSender {
 protected:
     shared_ptr<Sock> mSock;
     struct sockaddr_un mAddr;
+    // LOC_IPC_PEER_CAP_* bits of the peer msgs are sent to
+    const uint32_t mPeerCaps;
     inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
-    inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId,
+                           mPeerCaps);
     }
 public:
-    inline LocIpcLocalSender(const char* name) : LocIpcSender(),
+    inline LocIpcLocalSender(const char* name, uint32_t peerCaps = 0) : LocIpcSender(),
             mSock(nullptr),
-            mAddr({.sun_family = AF_UNIX, {}}) {
+            mAddr({.sun_family = AF_UNIX, {}}),
+            mPeerCaps(peerCaps) {
 
         int fd = -1;
         if (nullptr != name) {
@@ -195,21 +459,26 @@ protected:
     shared_ptr<Sock> mSock;
     const string mName;
     sockaddr_in mAddr;
+    // LOC_IPC_PEER_CAP_* bits of the peer msgs are sent to, no fd passing across AF_INET
+    const uint32_t mPeerCaps;
     inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
-    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId,
+                           mPeerCaps);
     }
 public:
     inline LocIpcInetSender(const LocIpcInetSender& sender) :
             mSockType(sender.mSockType), mSock(sender.mSock),
-            mName(sender.mName), mAddr(sender.mAddr) {
+            mName(sender.mName), mAddr(sender.mAddr), mPeerCaps(sender.mPeerCaps) {
     }
-    inline LocIpcInetSender(const char* name, int32_t port, int sockType) : LocIpcSender(),
+    inline LocIpcInetSender(const char* name, int32_t port, int sockType,
+                            uint32_t peerCaps = 0) : LocIpcSender(),
             mSockType(sockType),
             mSock(make_shared<Sock>((nullptr == name) ? -1 : (::socket(AF_INET, mSockType, 0)))),
             mName((nullptr == name) ? "" : name),
             mAddr({.sin_family = AF_INET, .sin_port = htons(port),
-                    .sin_addr = {htonl(INADDR_ANY)}}) {
+                    .sin_addr = {htonl(INADDR_ANY)}}),
+            mPeerCaps(peerCaps & ~LOC_IPC_PEER_CAP_LARGE_MSG_BY_FD) {
         if (mSock != nullptr && mSock->isValid() && nullptr != name) {
             struct hostent* hp = gethostbyname(name);
             if (nullptr != hp) {
@@ -227,17 +496,18 @@ class LocIpcInetTcpSender : public LocIpcInetSender {
 protected:
     mutable bool mFirstTime;
 
-    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
         if (mFirstTime) {
             mFirstTime = false;
             ::connect(mSock->mSid, (const struct sockaddr*)&mAddr, sizeof(mAddr));
         }
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId,
+                           mPeerCaps);
     }
 
 public:
-    inline LocIpcInetTcpSender(const char* name, int32_t port) :
-            LocIpcInetSender(name, port, SOCK_STREAM),
+    inline LocIpcInetTcpSender(const char* name, int32_t port, uint32_t peerCaps = 0) :
+            LocIpcInetSender(name, port, SOCK_STREAM, peerCaps),
             mFirstTime(true) {}
 };
 
@@ -275,8 +545,7 @@ protected:
     inline virtual ssize_t recv() const override {
         socklen_t size = sizeof(mAddr);
         if (-1 == mConnFd && mSock->isValid()) {
-            if (::listen(mSock->mSid, 3) < 0 ||
-                (mConnFd = accept(mSock->mSid, (struct sockaddr*)&mAddr, &size)) < 0) {
+            if ((mConnFd = accept(mSock->mSid, (struct sockaddr*)&mAddr, &size)) < 0) {
                 mSock->close();
                 mConnFd = -1;
             }
@@ -286,7 +555,13 @@ protected:
 public:
     inline LocIpcInetTcpRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
                                int32_t port) :
-            LocIpcInetRecver(listener, name, port, SOCK_STREAM), mConnFd(-1) {}
+            LocIpcInetRecver(listener, name, port, SOCK_STREAM), mConnFd(-1) {
+        // listen right away, a sender may connect before the first recv()
+        if (mSock->isValid() && ::listen(mSock->mSid, 3) < 0) {
+            LOC_LOGe("listen socket error. sock fd: %d, reason: %s", mSock->mSid, strerror(errno));
+            mSock->close();
+        }
+    }
     inline virtual ~LocIpcInetTcpRecver() { if (-1 != mConnFd) ::close(mConnFd);}
 };
 
@@ -368,9 +643,55 @@ bool LocIpc::send(LocIpcSender& sender, const uint8_t data[], uint32_t length, i
     return sender.sendData(data, length, msgId);
 }
 
+const LocIpcStats& LocIpc::getStats() {
+    return stats();
+}
+
+void LocIpc::dumpStats(std::string& out) {
+    const LocIpcStats& s = stats();
+    uint64_t elapsedMs = (monotonicNs() - s.mStartNs) / 1000000;
+    uint64_t sentBytes = s.mSentBytes.load(std::memory_order_relaxed);
+    uint64_t recvBytes = s.mRecvBytes.load(std::memory_order_relaxed);
+    char buf[448];
+
+    // bytes per ms is KB/s; average since first use, so only meaningful
+    // for a busy process
+    snprintf(buf, sizeof(buf),
+             "LocIpc: up=%" PRIu64 "ms\n"
+             "  sent: msgs=%" PRIu64 " bytes=%" PRIu64 " syscalls=%" PRIu64 " avg=%" PRIu64 "KB/s\n"
+             "  recv: msgs=%" PRIu64 " bytes=%" PRIu64 " syscalls=%" PRIu64 " avg=%" PRIu64 "KB/s\n"
+             "  fragmented: sent=%" PRIu64 " recv=%" PRIu64
+             "  by_fd: sent=%" PRIu64 " recv=%" PRIu64 "\n",
+             elapsedMs,
+             s.mSentMsgs.load(std::memory_order_relaxed), sentBytes,
+             s.mSendSyscalls.load(std::memory_order_relaxed),
+             (0 == elapsedMs) ? 0 : sentBytes / elapsedMs,
+             s.mRecvMsgs.load(std::memory_order_relaxed), recvBytes,
+             s.mRecvSyscalls.load(std::memory_order_relaxed),
+             (0 == elapsedMs) ? 0 : recvBytes / elapsedMs,
+             s.mSentFragmentedMsgs.load(std::memory_order_relaxed),
+             s.mRecvFragmentedMsgs.load(std::memory_order_relaxed),
+             s.mSentFdMsgs.load(std::memory_order_relaxed),
+             s.mRecvFdMsgs.load(std::memory_order_relaxed));
+    out += buf;
+    out += "  sent size: ";
+    s.mSentSizes.dump(out, "B");
+    out += "\n  recv size: ";
+    s.mRecvSizes.dump(out, "B");
+    out += "\n  reassembly: ";
+    s.mReassemblyUs.dump(out, "us");
+    out += "\n  dispatch: ";
+    s.mDispatchUs.dump(out, "us");
+    out += "\n";
+}
+
 shared_ptr<LocIpcSender> LocIpc::getLocIpcLocalSender(const char* localSockName) {
     return make_shared<LocIpcLocalSender>(localSockName);
 }
+shared_ptr<LocIpcSender> LocIpc::getLocIpcLocalSender(const char* localSockName,
+                                                      uint32_t peerCaps) {
+    return make_shared<LocIpcLocalSender>(localSockName, peerCaps);
+}
 unique_ptr<LocIpcRecver> LocIpc::getLocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener,
                                                       const char* localSockName) {
     return make_unique<LocIpcLocalRecver>(listener, localSockName);
@@ -383,6 +704,133 @@ shared_ptr<LocIpcSender> LocIpc::getLocIpcQrtrSender(int service, int instance)
             "_ZN8loc_util22createLocIpcQrtrSenderEii");
     return (nullptr == creator) ? nullptr : creator(service, instance);
 }
+
+// QRTR sender that a LocIpcQrtrWatcher tells when its service goes down and
+// comes back. The address resolved by the wrapped sender is kept and, at UP,
+// replaced with the one of the restarted service, so no send after a modem
+// SSR waits for it to be looked up again.
+class LocIpcQrtrSenderProxy : public LocIpcSender {
+    const int mService;
+    const int mInstance;
+    const shared_ptr<LocIpcSender> mSender;
+    mutable mutex mMutex;
+    bool mServiceUp;
+    mutable deque<pair<int32_t, vector<uint8_t>>> mPending;
+    mutable uint32_t mDropped;
+
+    // mMutex held
+    inline void flushPending() {
+        while (!mPending.empty()) {
+            auto& msg = mPending.front();
+            if (!mSender->sendData(msg.second.data(), msg.second.size(), msg.first)) {
+                LOC_LOGw("service %d up, %zu msgs still pending", mService, mPending.size());
+                break;
+            }
+            mPending.pop_front();
+        }
+    }
+protected:
+    inline virtual bool isOperable() const override {
+        lock_guard<mutex> lock(mMutex);
+        return !mServiceUp || mSender->isSendable();
+    }
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const override {
+        lock_guard<mutex> lock(mMutex);
+        if (mServiceUp) {
+            return mSender->sendData(data, length, msgId) ? length : -1;
+        }
+        if (mPending.size() >= LOC_IPC_QRTR_MAX_PENDING) {
+            mPending.pop_front();
+            mDropped++;
+        }
+        mPending.emplace_back(msgId, vector<uint8_t>(data, data + length));
+        return length;
+    }
+public:
+    inline LocIpcQrtrSenderProxy(int service, int instance,
+                                 const shared_ptr<LocIpcSender>& sender) :
+            mService(service), mInstance(instance), mSender(sender),
+            mServiceUp(true), mDropped(0) {}
+    inline bool isService(int service, int instance) const {
+        return mService == service && mInstance == instance;
+    }
+    void onServiceStatusChange(LocIpcQrtrWatcher::ServiceStatus status,
+                               const LocIpcSender& sender) {
+        lock_guard<mutex> lock(mMutex);
+        if (LocIpcQrtrWatcher::ServiceStatus::DOWN == status) {
+            mServiceUp = false;
+        } else {
+            mSender->copyDestAddrFrom(sender);
+            mServiceUp = true;
+            if (mDropped > 0) {
+                LOC_LOGw("service %d was down, %u msgs dropped", mService, mDropped);
+                mDropped = 0;
+            }
+            flushPending();
+        }
+    }
+    inline virtual unique_ptr<LocIpcRecver> getRecver(
+            const shared_ptr<ILocIpcListener>& listener) override {
+        return mSender->getRecver(listener);
+    }
+    inline virtual void copyDestAddrFrom(const LocIpcSender& otherSender) override {
+        lock_guard<mutex> lock(mMutex);
+        mSender->copyDestAddrFrom(otherSender);
+    }
+};
+
+// The senders from LocIpc::getLocIpcQrtrSender() with a watcher, by watcher.
+// Not a LocIpcQrtrWatcher member, the watchers of the prebuilt libraries are
+// built against its layout.
+static mutex sQrtrSendersMutex;
+static unordered_map<const LocIpcQrtrWatcher*,
+                     vector<weak_ptr<LocIpcQrtrSenderProxy>>> sQrtrSenders;
+
+static void addQrtrSender(const LocIpcQrtrWatcher* watcher,
+                          const shared_ptr<LocIpcQrtrSenderProxy>& sender) {
+    lock_guard<mutex> lock(sQrtrSendersMutex);
+    for (auto it = sQrtrSenders.begin(); it != sQrtrSenders.end();) {
+        auto& senders = it->second;
+        senders.erase(remove_if(senders.begin(), senders.end(),
+                [](const weak_ptr<LocIpcQrtrSenderProxy>& s) { return s.expired(); }),
+                senders.end());
+        it = senders.empty() ? sQrtrSenders.erase(it) : next(it);
+    }
+    sQrtrSenders[watcher].push_back(sender);
+}
+
+void LocIpcQrtrWatcher::onServiceStatusChange(int serviceId, int instanceId,
+                                              ServiceStatus status, const LocIpcSender& sender) {
+    vector<shared_ptr<LocIpcQrtrSenderProxy>> senders;
+    {
+        lock_guard<mutex> lock(sQrtrSendersMutex);
+        auto it = sQrtrSenders.find(this);
+        if (it != sQrtrSenders.end()) {
+            for (auto& s : it->second) {
+                shared_ptr<LocIpcQrtrSenderProxy> proxy = s.lock();
+                if (nullptr != proxy && proxy->isService(serviceId, instanceId)) {
+                    senders.push_back(proxy);
+                }
+            }
+        }
+    }
+    for (auto& proxy : senders) {
+        proxy->onServiceStatusChange(status, sender);
+    }
+}
+
+shared_ptr<LocIpcSender> LocIpc::getLocIpcQrtrSender(int service, int instance,
+        const shared_ptr<LocIpcQrtrWatcher>& qrtrWatcher) {
+    shared_ptr<LocIpcSender> sender = getLocIpcQrtrSender(service, instance);
+    if (nullptr == sender || nullptr == qrtrWatcher) {
+        return sender;
+    }
+    shared_ptr<LocIpcQrtrSenderProxy> proxy =
+            make_shared<LocIpcQrtrSenderProxy>(service, instance, sender);
+    addQrtrSender(qrtrWatcher.get(), proxy);
+    return proxy;
+}
+
 unique_ptr<LocIpcRecver> LocIpc::getLocIpcQrtrRecver(const shared_ptr<ILocIpcListener>& listener,
                                                      int service, int instance,
                                                      const shared_ptr<LocIpcQrtrWatcher>& watcher) {
@@ -399,6 +847,10 @@ unique_ptr<LocIpcRecver> LocIpc::getLocIpcQrtrRecver(const shared_ptr<ILocIpcLis
 shared_ptr<LocIpcSender> LocIpc::getLocIpcInetTcpSender(const char* serverName, int32_t port) {
     return make_shared<LocIpcInetTcpSender>(serverName, port);
 }
+shared_ptr<LocIpcSender> LocIpc::getLocIpcInetTcpSender(const char* serverName, int32_t port,
+                                                        uint32_t peerCaps) {
+    return make_shared<LocIpcInetTcpSender>(serverName, port, peerCaps);
+}
 unique_ptr<LocIpcRecver> LocIpc::getLocIpcInetTcpRecver(const shared_ptr<ILocIpcListener>& listener,
                                                             const char* serverName, int32_t port) {
     return make_unique<LocIpcInetTcpRecver>(listener, serverName, port);
@@ -406,6 +858,10 @@ unique_ptr<LocIpcRecver> LocIpc::getLocIpcInetTcpRecver(const shared_ptr<ILocIpc
 shared_ptr<LocIpcSender> LocIpc::getLocIpcInetUdpSender(const char* serverName, int32_t port) {
     return make_shared<LocIpcInetSender>(serverName, port, SOCK_DGRAM);
 }
+shared_ptr<LocIpcSender> LocIpc::getLocIpcInetUdpSender(const char* serverName, int32_t port,
+                                                        uint32_t peerCaps) {
+    return make_shared<LocIpcInetSender>(serverName, port, SOCK_DGRAM, peerCaps);
+}
 unique_ptr<LocIpcRecver> LocIpc::getLocIpcInetUdpRecver(const shared_ptr<ILocIpcListener>& listener,
                                                              const char* serverName, int32_t port) {
     return make_unique<LocIpcInetUdpRecver>(listener, serverName, port);
@@ -37,7 +37,9 @@
 #include <sys/un.h>
 #include <unordered_set>
 #include <mutex>
+#include <atomic>
 #include <LocThread.h>
+#include <LocHistogram.h>
 
 using namespace std;
 
@@ -46,6 +48,23 @@ namespace loc_util {
 class LocIpcRecver;
 class LocIpcSender;
 
+// What the peer of a sender understands beyond the original $MSGLEN$ text
+// framing. Recvers of this LocIpc version accept all of them. Datagram
+// sockets have no back channel to learn it from, so whoever creates a
+// sender to a peer known to be on this version states it; senders default
+// to the text framing so older peers keep working.
+// Fixed size binary frame heads for msgs over mMaxTxSize and aborts
+#define LOC_IPC_PEER_CAP_BINARY_FRAMING  0x1
+// msgs over mMaxTxSize handed over in a memfd, AF_UNIX only
+#define LOC_IPC_PEER_CAP_LARGE_MSG_BY_FD 0x2
+#define LOC_IPC_PEER_CAPS_CURRENT \
+        (LOC_IPC_PEER_CAP_BINARY_FRAMING | LOC_IPC_PEER_CAP_LARGE_MSG_BY_FD)
+
+// max number of fragments of a long msg moved per sendmmsg
+#define LOC_IPC_MAX_BATCH 32
+// msgs a QRTR sender with a watcher holds while its service is down
+#define LOC_IPC_QRTR_MAX_PENDING 32
+
 class ILocIpcListener {
 protected:
     inline virtual ~ILocIpcListener() {}
@@ -80,12 +99,36 @@ public:
         lock_guard<mutex> lock(mMutex);
         mClientsToWatch.emplace(nodeId);
     }
+    // The LocIpcQrtrWatcher version, which a watcher calls from its own,
+    // moves the senders of the service along with it: they hold their msgs
+    // while it is DOWN and take over the address of sender and send them at UP.
     virtual void onServiceStatusChange(int sericeId, int instanceId, ServiceStatus status,
                                        const LocIpcSender& sender) = 0;
     inline virtual void onClientGone(int nodeId __unused, int portId __unused) {}
     inline const unordered_set<int>& getServicesToWatch() { return mServicesToWatch; }
 };
 
+// Traffic of all socket based senders / recvers in this process, kept so
+// that throughput and dispatch latency can be read from a live device.
+struct LocIpcStats {
+    const uint64_t mStartNs;            // CLOCK_MONOTONIC, when first used
+    atomic<uint64_t> mSentMsgs;
+    atomic<uint64_t> mSentBytes;
+    atomic<uint64_t> mSendSyscalls;
+    atomic<uint64_t> mRecvMsgs;
+    atomic<uint64_t> mRecvBytes;
+    atomic<uint64_t> mRecvSyscalls;
+    atomic<uint64_t> mSentFragmentedMsgs;   // sent in mMaxTxSize chunks
+    atomic<uint64_t> mSentFdMsgs;           // sent in a memfd
+    atomic<uint64_t> mRecvFragmentedMsgs;   // reassembled from chunks
+    atomic<uint64_t> mRecvFdMsgs;           // recvd in a memfd
+    LocHistogram mSentSizes;            // bytes per msg
+    LocHistogram mRecvSizes;            // bytes per msg
+    LocHistogram mReassemblyUs;         // long msg head until handled
+    LocHistogram mDispatchUs;           // time in onReceive
+    LocIpcStats();
+};
+
 class LocIpc {
 public:
     inline LocIpc() = default;
@@ -99,8 +142,25 @@ public:
             getLocIpcInetUdpSender(const char* serverName, int32_t port);
     static shared_ptr<LocIpcSender>
             getLocIpcInetTcpSender(const char* serverName, int32_t port);
+    // Same as above, for a peer with the given LOC_IPC_PEER_CAP_* bits. With
+    // LOC_IPC_PEER_CAP_LARGE_MSG_BY_FD, payloads too big for one datagram are
+    // handed over in a sealed memfd passed along the socket instead of being
+    // split into chunks.
+    static shared_ptr<LocIpcSender>
+            getLocIpcLocalSender(const char* localSockName, uint32_t peerCaps);
+    static shared_ptr<LocIpcSender>
+            getLocIpcInetUdpSender(const char* serverName, int32_t port, uint32_t peerCaps);
+    static shared_ptr<LocIpcSender>
+            getLocIpcInetTcpSender(const char* serverName, int32_t port, uint32_t peerCaps);
     static shared_ptr<LocIpcSender>
             getLocIpcQrtrSender(int service, int instance);
+    // Same as above, for a service watched by qrtrWatcher, which is also given
+    // to the recver. The sender keeps the address it resolved and follows the
+    // service through restarts; msgs sent while the service is down are held,
+    // up to LOC_IPC_QRTR_MAX_PENDING, and sent as soon as it is up again.
+    static shared_ptr<LocIpcSender>
+            getLocIpcQrtrSender(int service, int instance,
+                                const shared_ptr<LocIpcQrtrWatcher>& qrtrWatcher);
 
     static unique_ptr<LocIpcRecver>
             getLocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener,
@@ -148,6 +208,10 @@ public:
     static bool send(LocIpcSender& sender, const uint8_t data[],
                      uint32_t length, int32_t msgId = -1);
 
+    static const LocIpcStats& getStats();
+    // appends getStats(), with average throughput since start, to out
+    static void dumpStats(std::string& out);
+
 private:
     LocThread mThread;
 };
@@ -196,18 +260,47 @@ public:
 class Sock {
     static const char MSG_ABORT[];
     static const char LOC_IPC_HEAD[];
+    static const uint32_t FRAME_MAGIC;
+    static const uint8_t FRAME_VERSION;
+    enum {
+        FRAME_FLAG_FRAGMENTED = 0x1,    // payload follows in mMaxTxSize datagrams
+        FRAME_FLAG_FD = 0x2,            // payload in the memfd passed with the head
+        FRAME_FLAG_ABORT = 0x4,         // stop listening, no payload
+    };
+    // sent in host byte order; recvers only ever talk to peers on the same device
+    struct FrameHead {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t flags;
+        uint16_t headLen;
+        int32_t msgId;
+        uint32_t length;                // payload length
+    };
     const uint32_t mMaxTxSize;
     ssize_t sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
-                   socklen_t addrlen) const;
+                   socklen_t addrlen, int32_t msgId, uint32_t peerCaps) const;
+    ssize_t sendFragments(const void *buf, size_t len, int flags,
+                          const struct sockaddr *destAddr, socklen_t addrlen) const;
+    ssize_t sendByFd(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
+                     socklen_t addrlen, int32_t msgId) const;
     ssize_t recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                      int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t recvFragments(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                          int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen,
+                          std::string& msg, size_t msgLenReceived) const;
+    ssize_t recvByFd(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                     int fd, size_t msgLen) const;
 public:
     int mSid;
     inline Sock(int sid, const uint32_t maxTxSize = 8192) : mMaxTxSize(maxTxSize), mSid(sid) {}
     inline ~Sock() { close(); }
     inline bool isValid() const { return -1 != mSid; }
+    // text framing, for peers of any LocIpc version
     ssize_t send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                  socklen_t addrlen) const;
+    // framing as the LOC_IPC_PEER_CAP_* bits of the peer allow
+    ssize_t send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
+                 socklen_t addrlen, int32_t msgId, uint32_t peerCaps) const;
     ssize_t recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                  struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
     ssize_t sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen);
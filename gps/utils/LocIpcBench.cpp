@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// loc_ipc_bench - echoes msgs between two LocIpc recvers in this process,
+// over each transport LocIpc creates senders / recvers for, and reports
+// round trip latency and throughput per msg size and peer caps.
+//
+// usage: loc_ipc_bench [-n round trips] [-t local|udp|tcp|qrtr] [-p port] [-d dir]
+//
+// Sizes go from well below to well past the 8KB mMaxTxSize, so the single
+// datagram, the fragmented and the memfd paths are all timed. Every reply
+// is checked against what was sent, and the exit code is non zero if any
+// round trip is lost or corrupted. QRTR needs libloc_socket.so and is
+// skipped where it can not be loaded. Inet pairs take two ports each from
+// -p on, pick another base if a run just before left them in TIME_WAIT.
+
+#define LOG_TAG "LocSvc_IpcBench"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <LocIpc.h>
+
+using namespace loc_util;
+
+#define LOC_IPC_BENCH_QRTR_SERVICE  0x4c49 // "LI"
+#define LOC_IPC_BENCH_TIMEOUT_MS    1000
+
+static const uint32_t sSizes[] = {
+    64, 1024, 8191, 8192, 8193, 32 * 1024, 256 * 1024,
+};
+
+struct BenchTransport {
+    const char* mName;
+    uint32_t mMaxMsgSize;
+};
+
+// Bigger msgs are not swept over inet / QRTR: a burst of fragments longer
+// than the socket buffer is dropped over UDP, and over TCP the recver loses
+// the msg boundaries once several fragments are coalesced in the stream.
+static const BenchTransport sTransports[] = {
+    {"local", UINT32_MAX},
+    {"udp",   32 * 1024},
+    {"tcp",   32 * 1024},
+    {"qrtr",  32 * 1024},
+};
+
+struct BenchMode {
+    const char* mName;
+    uint32_t mPeerCaps;
+    bool mLocalOnly;
+};
+
+static const BenchMode sModes[] = {
+    {"text",   0,                                                                false},
+    {"framed", LOC_IPC_PEER_CAP_BINARY_FRAMING,                                  false},
+    {"memfd",  LOC_IPC_PEER_CAP_BINARY_FRAMING | LOC_IPC_PEER_CAP_LARGE_MSG_BY_FD, true},
+};
+
+static inline uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// sends whatever it gets back to the client side
+class EchoListener : public ILocIpcListener {
+    shared_ptr<LocIpcSender> mReplyTo;
+    mutex mMutex;
+public:
+    inline void setReplyTo(const shared_ptr<LocIpcSender>& replyTo) {
+        lock_guard<mutex> lock(mMutex);
+        mReplyTo = replyTo;
+    }
+    virtual void onReceive(const char* data, uint32_t len, const LocIpcRecver*) override {
+        shared_ptr<LocIpcSender> replyTo;
+        {
+            lock_guard<mutex> lock(mMutex);
+            replyTo = mReplyTo;
+        }
+        if (nullptr != replyTo) {
+            LocIpc::send(*replyTo, (const uint8_t*)data, len);
+        }
+    }
+};
+
+// wakes up the bench thread on each reply, and checks it
+class ReplyListener : public ILocIpcListener {
+    mutex mMutex;
+    condition_variable mCond;
+    uint64_t mReplies;
+    uint64_t mBadReplies;
+    std::string mExpected;
+public:
+    inline ReplyListener() : mReplies(0), mBadReplies(0) {}
+    inline void expect(const std::string& payload) {
+        lock_guard<mutex> lock(mMutex);
+        mExpected = payload;
+    }
+    inline uint64_t badReplies() {
+        lock_guard<mutex> lock(mMutex);
+        return mBadReplies;
+    }
+    virtual void onReceive(const char* data, uint32_t len, const LocIpcRecver*) override {
+        lock_guard<mutex> lock(mMutex);
+        if (len != mExpected.size() || 0 != memcmp(data, mExpected.data(), len)) {
+            mBadReplies++;
+        }
+        mReplies++;
+        mCond.notify_one();
+    }
+    // waits for the reply count to reach replies
+    inline bool wait(uint64_t replies) {
+        unique_lock<mutex> lock(mMutex);
+        return mCond.wait_for(lock, std::chrono::milliseconds(LOC_IPC_BENCH_TIMEOUT_MS),
+                              [&] { return mReplies >= replies; });
+    }
+};
+
+// one server / client pair on a transport, with the senders towards each
+struct BenchPair {
+    shared_ptr<EchoListener> mEcho = make_shared<EchoListener>();
+    shared_ptr<ReplyListener> mReplies = make_shared<ReplyListener>();
+    LocIpc mServerIpc;
+    LocIpc mClientIpc;
+    shared_ptr<LocIpcSender> mToServer;
+    shared_ptr<LocIpcSender> mToClient;
+
+    bool start(unique_ptr<LocIpcRecver> server, unique_ptr<LocIpcRecver> client) {
+        if (nullptr == server || nullptr == client ||
+            !server->isRecvable() || !client->isRecvable()) {
+            return false;
+        }
+        return mServerIpc.startNonBlockingListening(server) &&
+                mClientIpc.startNonBlockingListening(client);
+    }
+};
+
+static bool startPair(BenchPair& pair, const char* transport, const BenchMode& mode,
+                      const std::string& dir, int32_t port) {
+    bool started = false;
+    if (0 == strcmp(transport, "local")) {
+        // unique per pair, the recvers of the last pair unlink theirs once
+        // their listening threads are done
+        std::string suffix = to_string(getpid()) + "." + to_string(port);
+        std::string server = dir + "/loc_ipc_bench_s." + suffix;
+        std::string client = dir + "/loc_ipc_bench_c." + suffix;
+        started = pair.start(LocIpc::getLocIpcLocalRecver(pair.mEcho, server.c_str()),
+                             LocIpc::getLocIpcLocalRecver(pair.mReplies, client.c_str()));
+        pair.mToServer = LocIpc::getLocIpcLocalSender(server.c_str(), mode.mPeerCaps);
+        pair.mToClient = LocIpc::getLocIpcLocalSender(client.c_str(), mode.mPeerCaps);
+    } else if (0 == strcmp(transport, "udp")) {
+        started = pair.start(LocIpc::getLocIpcInetUdpRecver(pair.mEcho, "127.0.0.1", port),
+                             LocIpc::getLocIpcInetUdpRecver(pair.mReplies, "127.0.0.1",
+                                                            port + 1));
+        pair.mToServer = LocIpc::getLocIpcInetUdpSender("127.0.0.1", port, mode.mPeerCaps);
+        pair.mToClient = LocIpc::getLocIpcInetUdpSender("127.0.0.1", port + 1, mode.mPeerCaps);
+    } else if (0 == strcmp(transport, "tcp")) {
+        started = pair.start(LocIpc::getLocIpcInetTcpRecver(pair.mEcho, "127.0.0.1", port),
+                             LocIpc::getLocIpcInetTcpRecver(pair.mReplies, "127.0.0.1",
+                                                            port + 1));
+        pair.mToServer = LocIpc::getLocIpcInetTcpSender("127.0.0.1", port, mode.mPeerCaps);
+        pair.mToClient = LocIpc::getLocIpcInetTcpSender("127.0.0.1", port + 1, mode.mPeerCaps);
+    } else if (0 == strcmp(transport, "qrtr")) {
+        // QRTR senders have no peer caps, they always send as text
+        pair.mToServer = LocIpc::getLocIpcQrtrSender(LOC_IPC_BENCH_QRTR_SERVICE, 1);
+        pair.mToClient = LocIpc::getLocIpcQrtrSender(LOC_IPC_BENCH_QRTR_SERVICE + 1, 1);
+        if (nullptr != pair.mToServer && nullptr != pair.mToClient) {
+            started = pair.start(
+                    LocIpc::getLocIpcQrtrRecver(pair.mEcho, LOC_IPC_BENCH_QRTR_SERVICE, 1),
+                    LocIpc::getLocIpcQrtrRecver(pair.mReplies,
+                                                LOC_IPC_BENCH_QRTR_SERVICE + 1, 1));
+        }
+    }
+    if (started) {
+        pair.mEcho->setReplyTo(pair.mToClient);
+    }
+    return started && nullptr != pair.mToServer && nullptr != pair.mToClient;
+}
+
+// returns the number of lost or corrupted round trips
+static uint64_t benchSize(BenchPair& pair, const char* transport, const char* mode,
+                          uint32_t size, uint32_t roundTrips, uint64_t& replies) {
+    std::string payload(size, 0);
+    for (uint32_t i = 0; i < size; i++) {
+        payload[i] = (char)(i * 31 + size);
+    }
+    pair.mReplies->expect(payload);
+    uint64_t badBefore = pair.mReplies->badReplies();
+
+    std::vector<uint64_t> rttNs;
+    rttNs.reserve(roundTrips);
+    uint64_t startNs = nowNs();
+    uint64_t lost = 0;
+    for (uint32_t i = 0; i < roundTrips; i++) {
+        uint64_t sentNs = nowNs();
+        if (!LocIpc::send(*pair.mToServer, (const uint8_t*)payload.data(), size) ||
+            !pair.mReplies->wait(replies + 1)) {
+            // nothing came back, the rest of this size would only time out too
+            lost = roundTrips - i;
+            break;
+        }
+        replies++;
+        rttNs.push_back(nowNs() - sentNs);
+    }
+    uint64_t elapsedNs = nowNs() - startNs;
+    uint64_t bad = pair.mReplies->badReplies() - badBefore;
+
+    if (rttNs.empty()) {
+        printf("%-6s %-7s %8u %10s %10s %10s %6" PRIu64 "\n",
+               transport, mode, size, "-", "-", "-", lost + bad);
+    } else {
+        std::sort(rttNs.begin(), rttNs.end());
+        uint64_t p50 = rttNs[rttNs.size() / 2];
+        uint64_t p99 = rttNs[std::min(rttNs.size() - 1, rttNs.size() * 99 / 100)];
+        // bytes moved both ways
+        double mbPerSec = (0 == elapsedNs) ? 0.0 :
+                2.0 * size * rttNs.size() * 1000.0 / elapsedNs;
+        printf("%-6s %-7s %8u %10.1f %10.1f %10.2f %6" PRIu64 "\n",
+               transport, mode, size, p50 / 1000.0, p99 / 1000.0, mbPerSec, lost + bad);
+    }
+    return lost + bad;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: loc_ipc_bench [-n round trips] [-t local|udp|tcp|qrtr] [-p port] [-d dir]\n");
+}
+
+int main(int argc, char** argv) {
+    uint32_t roundTrips = 1000;
+    const char* only = nullptr;
+    int32_t port = 51000;
+#ifdef __ANDROID__
+    std::string dir = "/data/local/tmp";
+#else
+    std::string dir = "/tmp";
+#endif
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:p:d:")) != -1) {
+        switch (opt) {
+        case 'n': roundTrips = strtoul(optarg, nullptr, 0); break;
+        case 't': only = optarg; break;
+        case 'p': port = strtol(optarg, nullptr, 0); break;
+        case 'd': dir = optarg; break;
+        default: usage(); return 2;
+        }
+    }
+    if (0 == roundTrips) {
+        usage();
+        return 2;
+    }
+
+    // a peer gone mid send shows up as lost round trips, not as a crash
+    signal(SIGPIPE, SIG_IGN);
+    uint64_t failures = 0;
+    printf("%-6s %-7s %8s %10s %10s %10s %6s\n",
+           "ipc", "mode", "bytes", "p50_us", "p99_us", "MB/s", "lost");
+    for (const BenchTransport& benchTransport : sTransports) {
+        const char* transport = benchTransport.mName;
+        if (nullptr != only && 0 != strcmp(only, transport)) {
+            continue;
+        }
+        bool isLocal = (0 == strcmp(transport, "local"));
+        bool isQrtr = (0 == strcmp(transport, "qrtr"));
+        for (const BenchMode& mode : sModes) {
+            if ((mode.mLocalOnly && !isLocal) || (isQrtr && 0 != mode.mPeerCaps)) {
+                continue;
+            }
+            BenchPair pair;
+            bool started = startPair(pair, transport, mode, dir, port);
+            // fresh ports for each pair, the last ones may still be in TIME_WAIT
+            port += 2;
+            if (!started) {
+                // only QRTR may be missing, sockets and ports are expected to work
+                printf("%-6s %-7s skipped, could not create senders / recvers\n",
+                       transport, mode.mName);
+                failures += isQrtr ? 0 : 1;
+                continue;
+            }
+            uint64_t replies = 0;
+            for (uint32_t size : sSizes) {
+                if (size > benchTransport.mMaxMsgSize) {
+                    break;
+                }
+                failures += benchSize(pair, transport, mode.mName, size, roundTrips, replies);
+            }
+        }
+    }
+
+    std::string stats;
+    LocIpc::dumpStats(stats);
+    printf("\n%s", stats.c_str());
+    return (0 == failures) ? 0 : 1;
+}
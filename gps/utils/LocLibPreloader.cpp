@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "LocSvc_LibPreloader"
+
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <map>
+#include <thread>
+#include <log_util.h>
+#include <LocLibPreloader.h>
+
+namespace loc_util {
+
+struct LibLoad {
+    bool mLoading;
+    bool mPreloaded;
+    bool mLoaded;
+    uint64_t mLoadUs;
+};
+
+static pthread_mutex_t sMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sCond = PTHREAD_COND_INITIALIZER;
+static std::map<std::string, LibLoad> sLoads;
+
+static uint64_t nowUs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Times the dlopen of a library this process hasn't asked for before
+static void* loadLib(const std::string& libName)
+{
+    uint64_t startUs = nowUs();
+    void* handle = dlopen(libName.c_str(), RTLD_NOW);
+    uint64_t loadUs = nowUs() - startUs;
+    if (nullptr == handle) {
+        const char* err = dlerror();
+        LOC_LOGd("%s not loaded: %s", libName.c_str(), (nullptr == err) ? "unknown" : err);
+    } else {
+        LOC_LOGd("%s loaded in %" PRIu64 " us", libName.c_str(), loadUs);
+    }
+
+    pthread_mutex_lock(&sMutex);
+    LibLoad& load = sLoads[libName];
+    load.mLoading = false;
+    load.mLoaded = (nullptr != handle);
+    load.mLoadUs = loadUs;
+    pthread_cond_broadcast(&sCond);
+    pthread_mutex_unlock(&sMutex);
+
+    return handle;
+}
+
+void LocLibPreloader::preload(const char* const* libNames, size_t count)
+{
+    for (size_t i = 0; nullptr != libNames && i < count; i++) {
+        if (nullptr == libNames[i]) {
+            continue;
+        }
+        std::string libName(libNames[i]);
+        bool start = false;
+        pthread_mutex_lock(&sMutex);
+        if (0 == sLoads.count(libName)) {
+            sLoads[libName] = {true, true, false, 0};
+            start = true;
+        }
+        pthread_mutex_unlock(&sMutex);
+
+        if (start) {
+            std::thread([libName] () { loadLib(libName); }).detach();
+        }
+    }
+}
+
+void* LocLibPreloader::open(const char* libName)
+{
+    if (nullptr == libName) {
+        return nullptr;
+    }
+
+    std::string name(libName);
+    bool first = false;
+    pthread_mutex_lock(&sMutex);
+    auto it = sLoads.find(name);
+    if (it == sLoads.end()) {
+        sLoads[name] = {true, false, false, 0};
+        first = true;
+    } else {
+        while (it->second.mLoading) {
+            pthread_cond_wait(&sCond, &sMutex);
+        }
+    }
+    pthread_mutex_unlock(&sMutex);
+
+    // once loaded, this only takes another reference
+    return first ? loadLib(name) : dlopen(libName, RTLD_NOW);
+}
+
+void LocLibPreloader::dump(std::string& out)
+{
+    pthread_mutex_lock(&sMutex);
+    out += "Library loads:\n";
+    for (auto& each : sLoads) {
+        out += "  ";
+        out += each.first;
+        out += each.second.mPreloaded ? " (preloaded): " : ": ";
+        if (each.second.mLoading) {
+            out += "loading";
+        } else if (!each.second.mLoaded) {
+            out += "not found";
+        } else {
+            out += std::to_string(each.second.mLoadUs) + " us";
+        }
+        out += "\n";
+    }
+    pthread_mutex_unlock(&sMutex);
+}
+
+} // namespace loc_util
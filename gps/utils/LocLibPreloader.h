@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __LOC_LIB_PRELOADER_H__
+#define __LOC_LIB_PRELOADER_H__
+
+#include <stddef.h>
+#include <string>
+
+namespace loc_util {
+
+// Loads shared libraries ahead of their first use, and keeps how long the
+// first load of each library took, for the debug dump.
+//
+// preload() starts each dlopen(RTLD_NOW) on a thread of its own. open() is
+// what the code that needs a library calls instead of dlopen(RTLD_NOW); it
+// waits for a preload in flight rather than loading the library a second
+// time. Preloaded handles are never closed.
+class LocLibPreloader {
+public:
+    static void preload(const char* const* libNames, size_t count);
+    template <size_t N>
+    static inline void preload(const char* const (&libNames)[N]) {
+        preload(libNames, N);
+    }
+    static void* open(const char* libName);
+    static void dump(std::string& out);
+};
+
+} // namespace loc_util
+
+#endif //__LOC_LIB_PRELOADER_H__
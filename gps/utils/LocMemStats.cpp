@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#define LOG_TAG "LocSvc_LocMemStats"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <loc_pla.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+#include <LocMemStats.h>
+
+namespace loc_util {
+
+std::atomic<int> LocMemStats::sEnabled(-1);
+LocMemStats::Counter LocMemStats::sCounters[LOC_MEM_TAG_COUNT] = {};
+
+static const char* const sTagNames[LOC_MEM_TAG_COUNT] = {
+    "msg_task", "system_status", "log_buffer", "geofence", "batching", "hidl"
+};
+
+// Reading the conf logs, and logging may allocate what is accounted, so
+// whatever is allocated while the conf is read, on this or another thread,
+// is taken as unaccounted rather than waiting for the read.
+bool LocMemStats::readEnabled() {
+    int state = -1;
+    if (sEnabled.compare_exchange_strong(state, 2, std::memory_order_relaxed)) {
+        uint32_t enabled = 0;
+        loc_param_s_type memStatsConfTable[] =
+        {
+            {"MEM_ACCOUNTING_ENABLED", &enabled, NULL, 'n'},
+        };
+        loc_read_conf(LOC_PATH_GPS_CONF_STR, memStatsConfTable,
+                      sizeof(memStatsConfTable) / sizeof(memStatsConfTable[0]));
+        state = (0 != enabled) ? 1 : 0;
+        sEnabled.store(state, std::memory_order_relaxed);
+        LOC_LOGd("MEM_ACCOUNTING_ENABLED: %u", enabled);
+    }
+    return 1 == state;
+}
+
+void LocMemStats::dump(std::string& out) {
+    if (!isEnabled()) {
+        out += "LocMemStats: disabled, see MEM_ACCOUNTING_ENABLED\n";
+        return;
+    }
+
+    char buf[160];
+    out += "LocMemStats:\n";
+    for (int tag = 0; tag < LOC_MEM_TAG_COUNT; tag++) {
+        const Counter& counter = sCounters[tag];
+        snprintf(buf, sizeof(buf),
+                 "  %-14s bytes=%" PRId64 " objects=%" PRId64 " peak=%" PRId64
+                 " allocations=%" PRIu64 "\n", sTagNames[tag],
+                 counter.mBytes.load(std::memory_order_relaxed),
+                 counter.mObjects.load(std::memory_order_relaxed),
+                 counter.mPeakBytes.load(std::memory_order_relaxed),
+                 counter.mAllocations.load(std::memory_order_relaxed));
+        out += buf;
+    }
+}
+
+} // namespace loc_util
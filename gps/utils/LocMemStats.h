@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef __LOC_MEM_STATS_H__
+#define __LOC_MEM_STATS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <new>
+#include <string>
+
+namespace loc_util {
+
+// The subsystems whose heap use is accounted, if MEM_ACCOUNTING_ENABLED is
+// set in gps.conf
+typedef enum {
+    // the MsgTask slabs, their heap fallback and std::function msgs
+    LOC_MEM_MSG_TASK = 0,
+    // the published SystemStatusReports copies readers hold
+    LOC_MEM_SYSTEM_STATUS,
+    // the log buffer mapping and heap rings
+    LOC_MEM_LOG_BUFFER,
+    // the geofence maps of GeofenceAdapter
+    LOC_MEM_GEOFENCE,
+    // the session maps of BatchingAdapter
+    LOC_MEM_BATCHING,
+    // callbacks pending in the HIDL callback dispatcher
+    LOC_MEM_HIDL,
+    LOC_MEM_TAG_COUNT
+} LocMemTag;
+
+// Process wide byte and object counters per LocMemTag. The counting is a
+// few relaxed atomics, and nothing at all while accounting is disabled.
+class LocMemStats {
+    struct Counter {
+        std::atomic<int64_t> mBytes;
+        std::atomic<int64_t> mObjects;
+        std::atomic<int64_t> mPeakBytes;
+        std::atomic<uint64_t> mAllocations;
+    };
+    // -1 until gps.conf is read, 2 while it is being read, then 0 or 1
+    static std::atomic<int> sEnabled;
+    static Counter sCounters[LOC_MEM_TAG_COUNT];
+    static bool readEnabled();
+
+public:
+    static inline bool isEnabled() {
+        int enabled = sEnabled.load(std::memory_order_relaxed);
+        return (enabled < 0) ? readEnabled() : (1 == enabled);
+    }
+    static inline void allocated(LocMemTag tag, size_t bytes, int64_t objects = 1) {
+        if (isEnabled()) {
+            Counter& counter = sCounters[tag];
+            int64_t now = counter.mBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            counter.mObjects.fetch_add(objects, std::memory_order_relaxed);
+            counter.mAllocations.fetch_add(1, std::memory_order_relaxed);
+            int64_t peak = counter.mPeakBytes.load(std::memory_order_relaxed);
+            while (now > peak && !counter.mPeakBytes.compare_exchange_weak(
+                    peak, now, std::memory_order_relaxed)) {}
+        }
+    }
+    static inline void released(LocMemTag tag, size_t bytes, int64_t objects = 1) {
+        if (isEnabled()) {
+            Counter& counter = sCounters[tag];
+            counter.mBytes.fetch_sub(bytes, std::memory_order_relaxed);
+            counter.mObjects.fetch_sub(objects, std::memory_order_relaxed);
+        }
+    }
+    // appends bytes, objects, peak bytes and allocations per subsystem
+    static void dump(std::string& out);
+};
+
+// Base class accounting every object of the derived classes under TAG, by
+// the dynamic size of the object
+template <LocMemTag TAG>
+struct LocMemTracked {
+    inline static void* operator new(size_t size) {
+        void* p = ::operator new(size);
+        LocMemStats::allocated(TAG, size);
+        return p;
+    }
+    inline static void* operator new(size_t size, const std::nothrow_t& tag) noexcept {
+        void* p = ::operator new(size, tag);
+        if (nullptr != p) {
+            LocMemStats::allocated(TAG, size);
+        }
+        return p;
+    }
+    inline static void operator delete(void* p, size_t size) noexcept {
+        if (nullptr != p) {
+            LocMemStats::released(TAG, size);
+        }
+        ::operator delete(p);
+    }
+    // only called if a constructor throws after new (nothrow)
+    inline static void operator delete(void* p, const std::nothrow_t&) noexcept {
+        ::operator delete(p);
+    }
+};
+
+// Allocator accounting the memory of a container under TAG, one object per
+// element allocated
+template <typename T, LocMemTag TAG>
+struct LocMemAllocator {
+    typedef T value_type;
+    template <typename U>
+    struct rebind {
+        typedef LocMemAllocator<U, TAG> other;
+    };
+
+    inline LocMemAllocator() noexcept {}
+    template <typename U>
+    inline LocMemAllocator(const LocMemAllocator<U, TAG>&) noexcept {}
+
+    inline T* allocate(size_t n) {
+        T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+        LocMemStats::allocated(TAG, n * sizeof(T), n);
+        return p;
+    }
+    inline void deallocate(T* p, size_t n) noexcept {
+        LocMemStats::released(TAG, n * sizeof(T), n);
+        ::operator delete(p);
+    }
+};
+
+template <typename T, typename U, LocMemTag TAG>
+inline bool operator==(const LocMemAllocator<T, TAG>&, const LocMemAllocator<U, TAG>&) {
+    return true;
+}
+template <typename T, typename U, LocMemTag TAG>
+inline bool operator!=(const LocMemAllocator<T, TAG>&, const LocMemAllocator<U, TAG>&) {
+    return false;
+}
+
+} // namespace loc_util
+
+#endif // __LOC_MEM_STATS_H__
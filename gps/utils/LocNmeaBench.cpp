@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// loc_nmea_bench - feeds a capture of position and SV reports through
+// loc_nmea_generate_pos and loc_nmea_generate_sv, reports sentences per
+// second and heap allocations per report, and checks the generated NMEA
+// against a golden file byte for byte, failing on the first difference.
+//
+// usage: loc_nmea_bench -g <capture> [reports]     synthesize a capture
+//        loc_nmea_bench <capture> [-n iterations] [-r <golden> | -c <golden>]
+//
+// A capture is a LocNmeaCaptureHeader followed by records, each one a
+// uint32_t LOC_NMEA_CAPTURE_* kind and the structs below copied as they
+// are, so a capture only replays on the ABI it was recorded on. The golden
+// file holds the sentences of every record, after a "#<record>" line. It
+// is <capture> with its extension replaced by .nmea unless -c names
+// another one; -r records it instead of checking it.
+//
+// testdata/loc_nmea_drive.cap is "-g testdata/loc_nmea_drive.cap 10",
+// made on an LP64 target, with loc_nmea_drive.nmea next to it. Re-record
+// the golden file with -r only for an intended change of the sentences.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <new>
+#include <string>
+#include <vector>
+#include <loc_nmea.h>
+
+#define LOC_NMEA_CAPTURE_MAGIC     0x414d4e4cu // "LNMA"
+#define LOC_NMEA_CAPTURE_VERSION   1
+#define LOC_NMEA_CAPTURE_POSITION  1
+#define LOC_NMEA_CAPTURE_SV        2
+
+struct LocNmeaCaptureHeader {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mUlpLocationSize;
+    uint32_t mLocationExtendedSize;
+    uint32_t mSystemInfoSize;
+    uint32_t mSvNotificationSize;
+};
+
+// arguments of one loc_nmea_generate_pos call
+struct LocNmeaCapturePosition {
+    UlpLocation mLocation;
+    GpsLocationExtended mLocationExtended;
+    LocationSystemInfo mSystemInfo;
+    NmeaSentenceTypesMask mTypesMask;
+    uint8_t mGenerateNmea;
+    uint8_t mCustomGgaFixQuality;
+    uint8_t mTagBlockGrouping;
+};
+
+struct LocNmeaRecord {
+    uint32_t mKind;
+    // only the member of mKind is valid
+    LocNmeaCapturePosition mPosition;
+    GnssSvNotification mSv;
+};
+
+// every allocation made by the generators goes through here
+static uint64_t sAllocations = 0;
+
+void* operator new(size_t size) {
+    sAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete(void* p) noexcept {
+    free(p);
+}
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void initHeader(LocNmeaCaptureHeader& header) {
+    memset(&header, 0, sizeof(header));
+    header.mMagic = LOC_NMEA_CAPTURE_MAGIC;
+    header.mVersion = LOC_NMEA_CAPTURE_VERSION;
+    header.mUlpLocationSize = sizeof(UlpLocation);
+    header.mLocationExtendedSize = sizeof(GpsLocationExtended);
+    header.mSystemInfoSize = sizeof(LocationSystemInfo);
+    header.mSvNotificationSize = sizeof(GnssSvNotification);
+}
+
+static bool readCapture(const char* path, std::vector<LocNmeaRecord>& records) {
+    FILE* file = fopen(path, "rb");
+    if (nullptr == file) {
+        fprintf(stderr, "can't open %s, %s\n", path, strerror(errno));
+        return false;
+    }
+    LocNmeaCaptureHeader header, expected;
+    initHeader(expected);
+    bool ok = (1 == fread(&header, sizeof(header), 1, file)) &&
+            (0 == memcmp(&header, &expected, sizeof(header)));
+    if (!ok) {
+        fprintf(stderr, "%s is not a capture of this version and ABI\n", path);
+    }
+
+    uint32_t kind = 0;
+    while (ok && 1 == fread(&kind, sizeof(kind), 1, file)) {
+        records.emplace_back();
+        LocNmeaRecord& record = records.back();
+        memset(&record, 0, sizeof(record));
+        record.mKind = kind;
+        if (LOC_NMEA_CAPTURE_POSITION == kind) {
+            ok = (1 == fread(&record.mPosition, sizeof(record.mPosition), 1, file));
+        } else if (LOC_NMEA_CAPTURE_SV == kind) {
+            ok = (1 == fread(&record.mSv, sizeof(record.mSv), 1, file)) &&
+                    record.mSv.count <= GNSS_SV_MAX;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "%s: bad record %zu\n", path, records.size() - 1);
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+// A 1Hz drive around a loop with ~40 SVs on L1 and L5, every 10th fix
+// without position so the blank sentences get their share.
+static bool synthesizeCapture(const char* path, uint32_t count) {
+    FILE* file = fopen(path, "wb");
+    if (nullptr == file) {
+        fprintf(stderr, "can't create %s, %s\n", path, strerror(errno));
+        return false;
+    }
+    LocNmeaCaptureHeader header;
+    initHeader(header);
+    bool ok = (1 == fwrite(&header, sizeof(header), 1, file));
+
+    static const struct {
+        GnssSvType type;
+        uint16_t firstSvId;
+        uint16_t svCount;
+        GnssSignalTypeMask signals[2];
+    } constellations[] = {
+        {GNSS_SV_TYPE_GPS,     1,   10, {GNSS_SIGNAL_GPS_L1CA, GNSS_SIGNAL_GPS_L5}},
+        {GNSS_SV_TYPE_SBAS,    120, 2,  {GNSS_SIGNAL_SBAS_L1, 0}},
+        {GNSS_SV_TYPE_GLONASS, 65,  7,  {GNSS_SIGNAL_GLONASS_G1, 0}},
+        {GNSS_SV_TYPE_GALILEO, 301, 8,  {GNSS_SIGNAL_GALILEO_E1, GNSS_SIGNAL_GALILEO_E5A}},
+        {GNSS_SV_TYPE_BEIDOU,  201, 9,  {GNSS_SIGNAL_BEIDOU_B1I, GNSS_SIGNAL_BEIDOU_B2AI}},
+        {GNSS_SV_TYPE_QZSS,    193, 2,  {GNSS_SIGNAL_QZSS_L1CA, GNSS_SIGNAL_QZSS_L5}},
+        {GNSS_SV_TYPE_NAVIC,   401, 2,  {GNSS_SIGNAL_NAVIC_L5, 0}}
+    };
+
+    LocNmeaCapturePosition position;
+    GnssSvNotification sv;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        double t = (double)i;
+
+        memset(&sv, 0, sizeof(sv));
+        sv.size = sizeof(sv);
+        sv.gnssSignalTypeMaskValid = true;
+        for (const auto& constellation : constellations) {
+            for (uint16_t n = 0; n < constellation.svCount; n++) {
+                for (GnssSignalTypeMask signal : constellation.signals) {
+                    if (0 == signal || sv.count >= GNSS_SV_MAX) {
+                        continue;
+                    }
+                    GnssSv& each = sv.gnssSvs[sv.count++];
+                    each.size = sizeof(each);
+                    each.svId = constellation.firstSvId + n * 3;
+                    each.type = constellation.type;
+                    each.gnssSignalTypeMask = signal;
+                    each.elevation = fmod(7.0 + n * 11.3 + t * 0.01, 90.0);
+                    each.azimuth = fmod(n * 37.7 + t * 0.05, 360.0);
+                    each.cN0Dbhz = (n % 5 == 4) ? 0.0f : 18.0 + fmod(n * 4.1 + t * 0.3, 30.0);
+                    each.gnssSvOptionsMask = (n % 3 != 2) ? GNSS_SV_OPTIONS_USED_IN_FIX_BIT : 0;
+                }
+            }
+        }
+        uint32_t kind = LOC_NMEA_CAPTURE_SV;
+        ok = (1 == fwrite(&kind, sizeof(kind), 1, file)) &&
+                (1 == fwrite(&sv, sizeof(sv), 1, file));
+
+        memset(&position, 0, sizeof(position));
+        LocGpsLocation& gps = position.mLocation.gpsLocation;
+        position.mLocation.size = sizeof(position.mLocation);
+        position.mLocation.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+        gps.size = sizeof(gps);
+        if (i % 10 != 9) {
+            gps.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+                    LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+                    LOC_GPS_LOCATION_HAS_ACCURACY;
+        }
+        gps.latitude = 32.9 + 0.01 * sin(t / 300.0);
+        gps.longitude = -117.2 + 0.01 * cos(t / 300.0);
+        gps.altitude = 100.0 + 5.0 * sin(t / 60.0);
+        gps.speed = 13.8 + sin(t / 20.0);
+        gps.bearing = fmod(t * 0.6, 360.0);
+        gps.accuracy = 3.5f;
+        gps.timestamp = 1600000000000LL + (int64_t)i * 1000;
+
+        GpsLocationExtended& ext = position.mLocationExtended;
+        ext.size = sizeof(ext);
+        ext.flags = GPS_LOCATION_EXTENDED_HAS_DOP |
+                GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL |
+                GPS_LOCATION_EXTENDED_HAS_MAG_DEV |
+                GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA |
+                GPS_LOCATION_EXTENDED_HAS_POS_TECH_MASK;
+        ext.pdop = 1.8f;
+        ext.hdop = 0.9f;
+        ext.vdop = 1.5f;
+        ext.altitudeMeanSeaLevel = gps.altitude - 35.0;
+        ext.magneticDeviation = 11.4f;
+        ext.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+        ext.gnss_sv_used_ids.gps_sv_used_ids_mask = 0x0000db6dULL;
+        ext.gnss_sv_used_ids.glo_sv_used_ids_mask = 0x00000db6ULL;
+        ext.gnss_sv_used_ids.gal_sv_used_ids_mask = 0x000036dbULL;
+        ext.gnss_sv_used_ids.bds_sv_used_ids_mask = 0x0001b6dbULL;
+        ext.gnss_sv_used_ids.qzss_sv_used_ids_mask = 0x00000009ULL;
+
+        position.mTypesMask = LOC_NMEA_AP_GENERATED_MASK;
+        position.mGenerateNmea = (i % 10 != 9);
+        kind = LOC_NMEA_CAPTURE_POSITION;
+        ok = ok && (1 == fwrite(&kind, sizeof(kind), 1, file)) &&
+                (1 == fwrite(&position, sizeof(position), 1, file));
+    }
+    ok = (0 == fclose(file)) && ok;
+    if (!ok) {
+        fprintf(stderr, "can't write %s\n", path);
+    }
+    return ok;
+}
+
+static void generate(const LocNmeaRecord& record, std::vector<std::string>& nmeaArraystr) {
+    if (LOC_NMEA_CAPTURE_POSITION == record.mKind) {
+        const LocNmeaCapturePosition& position = record.mPosition;
+        int indexOfGGA = -1;
+        loc_nmea_generate_pos(position.mLocation, position.mLocationExtended,
+                position.mSystemInfo, position.mGenerateNmea,
+                position.mCustomGgaFixQuality, nmeaArraystr, indexOfGGA,
+                position.mTagBlockGrouping, position.mTypesMask);
+    } else {
+        loc_nmea_generate_sv(record.mSv, nmeaArraystr);
+    }
+}
+
+static bool readFile(const char* path, std::string& content) {
+    FILE* file = fopen(path, "rb");
+    if (nullptr == file) {
+        fprintf(stderr, "can't open %s, %s\n", path, strerror(errno));
+        return false;
+    }
+    char buf[4096];
+    size_t length;
+    while ((length = fread(buf, 1, sizeof(buf), file)) > 0) {
+        content.append(buf, length);
+    }
+    fclose(file);
+    return true;
+}
+
+// reports the first difference, by record and line, of the two outputs
+static bool compareOutput(const std::string& golden, const std::string& output) {
+    size_t length = std::min(golden.size(), output.size());
+    size_t diff = 0;
+    while (diff < length && golden[diff] == output[diff]) {
+        diff++;
+    }
+    if (diff == length && golden.size() == output.size()) {
+        return true;
+    }
+    // npos + 1 is the start of the output
+    size_t lineStart = (0 == diff) ? 0 : output.rfind('\n', diff - 1) + 1;
+    size_t recordStart = output.rfind('#', lineStart);
+    std::string recordLine = output.substr(recordStart,
+            output.find('\n', recordStart) - recordStart);
+    fprintf(stderr, "output differs from golden at byte %zu, record %s\n",
+            diff, recordLine.c_str() + 1);
+    fprintf(stderr, " golden: %s\n", golden.substr(lineStart,
+            golden.find('\n', lineStart) - lineStart).c_str());
+    fprintf(stderr, " output: %s\n", output.substr(lineStart,
+            output.find('\n', lineStart) - lineStart).c_str());
+    return false;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && 0 == strcmp(argv[1], "-g")) {
+        return synthesizeCapture(argv[2], (argc > 3) ? atoi(argv[3]) : 600) ? 0 : 1;
+    }
+    const char* capture = nullptr;
+    const char* record = nullptr;
+    const char* check = nullptr;
+    int iterations = 100;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (0 == strcmp(argv[i], "-r") && i + 1 < argc) {
+            record = argv[++i];
+        } else if (0 == strcmp(argv[i], "-c") && i + 1 < argc) {
+            check = argv[++i];
+        } else if (nullptr == capture && '-' != argv[i][0]) {
+            capture = argv[i];
+        } else {
+            capture = nullptr;
+            break;
+        }
+    }
+    std::string defaultGolden;
+    if (nullptr != capture && nullptr == record && nullptr == check) {
+        defaultGolden = capture;
+        size_t dot = defaultGolden.rfind('.');
+        size_t slash = defaultGolden.rfind('/');
+        if (std::string::npos != dot && (std::string::npos == slash || dot > slash)) {
+            defaultGolden.erase(dot);
+        }
+        defaultGolden += ".nmea";
+        check = defaultGolden.c_str();
+    }
+    if (nullptr == capture || iterations <= 0 || (nullptr != record && nullptr != check)) {
+        fprintf(stderr, "usage: %s -g <capture> [reports]\n"
+                "       %s <capture> [-n iterations] [-r <golden> | -c <golden>]\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+
+    std::vector<LocNmeaRecord> records;
+    if (!readCapture(capture, records) || records.empty()) {
+        return 1;
+    }
+
+    // one untimed pass for the golden output, which also warms up caches
+    std::string output;
+    std::vector<std::string> nmeaArraystr;
+    for (size_t i = 0; i < records.size(); i++) {
+        nmeaArraystr.clear();
+        generate(records[i], nmeaArraystr);
+        output += "#" + std::to_string(i) + "\n";
+        for (const auto& sentence : nmeaArraystr) {
+            output += sentence;
+        }
+    }
+
+    uint64_t sentences = 0;
+    uint64_t allocations = sAllocations;
+    uint64_t start = nowNs();
+    for (int n = 0; n < iterations; n++) {
+        for (const auto& each : records) {
+            // a fresh vector per report, as GnssAdapter does
+            std::vector<std::string> out;
+            generate(each, out);
+            sentences += out.size();
+        }
+    }
+    uint64_t elapsedNs = nowNs() - start;
+    allocations = sAllocations - allocations;
+
+    uint64_t reports = (uint64_t)records.size() * iterations;
+    double seconds = elapsedNs / 1e9;
+    printf("%llu reports, %llu sentences in %.3f s\n",
+            (unsigned long long)reports, (unsigned long long)sentences, seconds);
+    printf("%.0f sentences/s, %.0f ns/report, %.2f allocations/report\n",
+            sentences / seconds, (double)elapsedNs / reports, (double)allocations / reports);
+
+    if (nullptr != record) {
+        FILE* file = fopen(record, "wb");
+        bool ok = (nullptr != file) &&
+                (output.size() == fwrite(output.data(), 1, output.size(), file));
+        ok = (nullptr != file) && (0 == fclose(file)) && ok;
+        if (!ok) {
+            fprintf(stderr, "can't write %s\n", record);
+            return 1;
+        }
+    } else if (nullptr != check) {
+        std::string golden;
+        if (!readFile(check, golden) || !compareOutput(golden, output)) {
+            return 1;
+        }
+        printf("output matches %s\n", check);
+    }
+    return 0;
+}
@@ -34,9 +34,9 @@
 #include <cutils/atomic.h>
 #endif /* FEATURE_EXTERNAL_AP */
 #include <pthread.h>
+#include <atomic>
 
 #ifdef FEATURE_EXTERNAL_AP
-#include <atomic>
 
 inline int32_t android_atomic_inc(volatile int32_t *addr)
 {
@@ -59,13 +59,18 @@ namespace loc_util {
 // itself when the last client calls its drop() method. To add a cient,
 // this share lock's share() method has to be called, so that the obj
 // can maintain an accurate client count.
+// The lock also carries a state word that is only written with the lock
+// held but may be read without it. Clients whose common case can be
+// answered by the state alone, e.g. stopping a timer that is not running,
+// check peekState() first and only take the lock when they have to.
 class LocSharedLock {
     volatile int32_t mRef;
     pthread_mutex_t mMutex;
+    std::atomic<int32_t> mState;
     inline ~LocSharedLock() { pthread_mutex_destroy(&mMutex); }
 public:
     // first client to create this LockSharedLock
-    inline LocSharedLock() : mRef(1) { pthread_mutex_init(&mMutex, NULL); }
+    inline LocSharedLock() : mRef(1), mState(0) { pthread_mutex_init(&mMutex, NULL); }
     // following client(s) are to *share()* this lock created by the first client
     inline LocSharedLock* share() { android_atomic_inc(&mRef); return this; }
     // whe a client no longer needs this shared lock, drop() shall be called.
@@ -74,6 +79,13 @@ public:
     inline void lock() { pthread_mutex_lock(&mMutex); }
     // unlocking the lock to leave the critical section
     inline void unlock() { pthread_mutex_unlock(&mMutex); }
+    // publish the state, only while holding the lock
+    inline void setStateLocked(int32_t state) {
+        mState.store(state, std::memory_order_release);
+    }
+    // the state last published, without taking the lock. It may change
+    // right after, so it only tells whether taking the lock is worth it.
+    inline int32_t peekState() const { return mState.load(std::memory_order_acquire); }
 };
 
 } //namespace loc_util
@@ -26,12 +26,21 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  */
+#define LOG_TAG "LocSvc_LocThread"
+
 #include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <unistd.h>
 #include <LocThread.h>
 #include <string.h>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <loc_pla.h>
+#include <log_util.h>
+#include <loc_cfg.h>
+#include <loc_misc_utils.h>
 
 using std::weak_ptr;
 using std::shared_ptr;
@@ -40,6 +49,114 @@ using std::string;
 
 namespace loc_util {
 
+// Scheduling of the threads named in gps.conf, applied by each LocThread
+// once it runs. A class applies to the threads listed in its *_NAMES.
+struct LocThreadSchedClass {
+    char mNames[LOC_MAX_PARAM_STRING];
+    // cpus the threads may run on, 0 leaves the affinity alone
+    uint32_t mCpuMask;
+    // SCHED_FIFO priority, 0 keeps SCHED_OTHER
+    uint32_t mRtPriority;
+    // uclamp.min, 0 leaves it alone
+    uint32_t mUclampMin;
+};
+
+enum {
+    LOC_THREAD_SCHED_REALTIME = 0,
+    LOC_THREAD_SCHED_HOUSEKEEPING,
+    LOC_THREAD_SCHED_COUNT
+};
+
+// from uapi/linux/sched/types.h, not in every libc
+struct LocSchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+    uint32_t sched_util_min;
+    uint32_t sched_util_max;
+};
+#define LOC_SCHED_FLAG_KEEP_ALL       0x18
+#define LOC_SCHED_FLAG_UTIL_CLAMP_MIN 0x20
+
+static const LocThreadSchedClass* getSchedClasses() {
+    static LocThreadSchedClass sClasses[LOC_THREAD_SCHED_COUNT];
+    static std::once_flag sOnce;
+
+    std::call_once(sOnce, [] {
+        LocThreadSchedClass& rt = sClasses[LOC_THREAD_SCHED_REALTIME];
+        LocThreadSchedClass& hk = sClasses[LOC_THREAD_SCHED_HOUSEKEEPING];
+        loc_param_s_type schedConfTable[] =
+        {
+            {"THREAD_REALTIME_NAMES",            &rt.mNames,      NULL, 's'},
+            {"THREAD_REALTIME_CPU_MASK",         &rt.mCpuMask,    NULL, 'n'},
+            {"THREAD_REALTIME_PRIORITY",         &rt.mRtPriority, NULL, 'n'},
+            {"THREAD_REALTIME_UCLAMP_MIN",       &rt.mUclampMin,  NULL, 'n'},
+            {"THREAD_HOUSEKEEPING_NAMES",        &hk.mNames,      NULL, 's'},
+            {"THREAD_HOUSEKEEPING_CPU_MASK",     &hk.mCpuMask,    NULL, 'n'},
+        };
+        loc_read_conf(LOC_PATH_GPS_CONF_STR, schedConfTable,
+                sizeof(schedConfTable)/sizeof(schedConfTable[0]));
+    });
+
+    return sClasses;
+}
+
+static void applySched(const char* tName) {
+    const LocThreadSchedClass* classes = getSchedClasses();
+    const LocThreadSchedClass* sched = nullptr;
+
+    for (int i = 0; i < LOC_THREAD_SCHED_COUNT && nullptr == sched; i++) {
+        if (loc_util_name_in_list(classes[i].mNames, tName)) {
+            sched = &classes[i];
+        }
+    }
+    if (nullptr == sched) {
+        return;
+    }
+
+    if (0 != sched->mCpuMask) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu = 0; cpu < 32; cpu++) {
+            if (sched->mCpuMask & (1U << cpu)) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        if (0 != sched_setaffinity(0, sizeof(cpus), &cpus)) {
+            LOC_LOGe("%s: cpu mask 0x%x failed: %s", tName, sched->mCpuMask, strerror(errno));
+        }
+    }
+
+    if (0 != sched->mRtPriority) {
+        struct sched_param param = {};
+        param.sched_priority = sched->mRtPriority;
+        if (0 != sched_setscheduler(0, SCHED_FIFO | SCHED_RESET_ON_FORK, &param)) {
+            LOC_LOGe("%s: SCHED_FIFO %u failed: %s", tName, sched->mRtPriority,
+                     strerror(errno));
+        }
+    }
+
+    if (0 != sched->mUclampMin) {
+        struct LocSchedAttr attr = {};
+        attr.size = sizeof(attr);
+        attr.sched_flags = LOC_SCHED_FLAG_KEEP_ALL | LOC_SCHED_FLAG_UTIL_CLAMP_MIN;
+        attr.sched_util_min = sched->mUclampMin;
+        // kernels without uclamp refuse the flag, nothing to do about it then
+        if (0 != syscall(__NR_sched_setattr, 0, &attr, 0)) {
+            LOC_LOGw("%s: uclamp.min %u failed: %s", tName, sched->mUclampMin,
+                     strerror(errno));
+        }
+    }
+
+    LOC_LOGd("%s: cpu mask 0x%x, rt priority %u, uclamp.min %u", tName,
+             sched->mCpuMask, sched->mRtPriority, sched->mUclampMin);
+}
+
 class LocThreadDelegate {
     static const char defaultThreadName[];
     weak_ptr<LocRunnable> mRunnable;
@@ -82,6 +199,8 @@ LocThreadDelegate::LocThreadDelegate(const string tName, shared_ptr<LocRunnable>
         mThread([tName, runnable] {
                 prctl(PR_SET_NAME, tName.c_str(), 0, 0, 0);
                 runnable->prerun();
+                // after prerun(), which may move the thread to its cgroup
+                applySched(tName.c_str());
                 while (runnable->run());
                 runnable->postrun();
             }) {
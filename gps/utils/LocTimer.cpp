@@ -32,6 +32,9 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
 #include <log_util.h>
@@ -51,8 +54,9 @@
 namespace loc_util {
 
 /*
-There are implementations of 5 classes in this file:
-LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerPollTask, LocTimerWrapper
+There are implementations of 8 classes in this file:
+LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerQueue, LocTimerHeap,
+LocTimerWheel, LocTimerPollTask, LocTimerWrapper
 
 LocTimer - client front end, interface for client to start / stop timers, also
            to provide a callback.
@@ -63,17 +67,20 @@ LocTimerDelegate - an internal timer entity, which also is a LocRankable obj.
                    stop() method. When a LocTimerDelegate obj is ticking, it
                    stays in the corresponding LocTimerContainer. When expired
                    or stopped, the obj is removed from the container. Since it
-                   is also a LocRankable obj, and LocTimerContainer also is a
-                   heap, its ranks() implementation decides where it is placed
-                   in the heap.
-LocTimerContainer - core of the timer service. It is a container (derived from
-                    LocHeap) for LocTimerDelegate (implements LocRankable) objs.
+                   is also a LocRankable obj, its ranks() implementation decides
+                   where it is placed in the heap of LocTimerHeap.
+LocTimerContainer - core of the timer service. It is a container (keeping a
+                    LocTimerQueue) for LocTimerDelegate objs.
                     There are 2 of such containers, one for sw timers (or Linux
                     timers) one for hw timers (or Linux alarms). It adds one of
                     each (those that expire the soonest) to kernel via services
                     provided by LocTimerPollTask. All the heap management on the
                     LocTimerDelegate objs are done in the MsgTask context, such
                     that synchronization is ensured.
+LocTimerQueue - storage interface of LocTimerContainer, which orders the timers
+                by time out. It is implemented by LocTimerHeap (LocHeap based)
+                and LocTimerWheel (hierarchical timer wheel), selected with
+                LocTimer::setBackend().
 LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
                    both implements LocRunnalbe with epoll_wait() in the run()
                    method. It is also a LocThread client, so as to loop the run
@@ -84,16 +91,32 @@ LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
 */
 
 class LocTimerPollTask;
+class LocTimerDelegate;
+
+// Storage of the ticking LocTimerDelegate objs of a LocTimerContainer, ordered
+// by their time out. All methods are called in the MsgTask context.
+class LocTimerQueue {
+public:
+    virtual inline ~LocTimerQueue() {}
+    // add a timer into the queue
+    virtual void push(LocTimerDelegate& timer) = 0;
+    // returns the timer that expires the soonest; or NULL if queue is empty
+    virtual LocTimerDelegate* peek() = 0;
+    // returns true if the timer was in the queue and is removed
+    virtual bool remove(LocTimerDelegate& timer) = 0;
+    // pops, soonest first, a timer whose time out is not later than now
+    // returns NULL if there is no such timer
+    virtual LocTimerDelegate* popExpired(const struct timespec& now) = 0;
+};
 
 // This is a multi-functaional class that:
-// * extends the LocHeap class for the detection of head update upon add / remove
-//   events. When that happens, soonest time out changes, so timerfd needs update.
-// * contains the timers, and add / remove them into the heap
+// * keeps the timers in a LocTimerQueue and detects the update of the soonest
+//   time out upon add / remove events. When that happens, timerfd needs update.
 // * provides and maps 2 of such containers, one for timers (or  mSwTimers), one
 //   for alarms (or mHwTimers);
 // * provides a polling thread;
 // * provides a MsgTask thread for synchronized add / remove / timer client callback.
-class LocTimerContainer : public LocHeap {
+class LocTimerContainer {
     // mutex to synchronize getters of static members
     static pthread_mutex_t mMutex;
     // Container of timers
@@ -104,22 +127,29 @@ class LocTimerContainer : public LocHeap {
     static MsgTask* mMsgTask;
     // Poll task to provide epoll call and threading to poll.
     static LocTimerPollTask* mPollTask;
+    // backend of the containers created from now on
+    static LocTimerBackend mBackend;
     // timer / alarm fd
     int mDevFd;
+    // storage of the ticking timers / alarms
+    LocTimerQueue* mQueue;
+    // time out currently programmed to mDevFd, 0 if disarmed
+    struct timespec mArmedTime;
     // ctor
-    LocTimerContainer(bool wakeOnExpire);
+    LocTimerContainer(bool wakeOnExpire, LocTimerBackend backend);
     // dtor
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
     static LocTimerPollTask* getPollTaskLocked();
-    // extend LocHeap and pop if the top outRanks input
-    LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
     // update the timer POSIX calls with updated soonest timer spec
-    void updateSoonestTime(LocTimerDelegate* priorTop);
+    void updateSoonestTime();
+    // pop a timer that is due by now, or whose slack window has begun
+    LocTimerDelegate* popExpired(const struct timespec& now);
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
+    static void setBackend(LocTimerBackend backend);
 
     LocTimerDelegate* getSoonestTimer();
     int getTimerFd();
@@ -184,20 +214,32 @@ public:
 // Internal class of timer obj. It gets born when client calls LocTimer::start();
 // and gets deleted when client calls LocTimer::stop() or when the it expire()'s.
 // This class implements LocRankable::ranks() so that when an obj is added into
-// the container (of LocHeap), it gets placed in sorted order.
+// the LocHeap of LocTimerHeap, it gets placed in sorted order.
 class LocTimerDelegate : public LocRankable {
     friend class LocTimerContainer;
+    friend class LocTimerHeap;
+    friend class LocTimerWheel;
     friend class LocTimer;
     LocTimer* mClient;
     LocSharedLock* mLock;
+    // the latest time to expire, i.e. time out plus slack. Timers are ordered
+    // and the timer fd is programmed by this.
     struct timespec mFutureTime;
+    // the earliest time to expire, i.e. time out. May expire together with
+    // another timer as soon as this is passed.
+    struct timespec mEarliestTime;
     LocTimerContainer* mContainer;
-    // not a complete obj, just ctor for LocRankable comparisons
-    inline LocTimerDelegate(struct timespec& delay)
-        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL) {}
+    // LocTimerWheel book keeping: slot list links, time out in ticks and
+    // level / slot the obj is in
+    LocTimerDelegate* mWheelPrev;
+    LocTimerDelegate* mWheelNext;
+    uint64_t mWheelTick;
+    int mWheelLevel;
+    uint32_t mWheelSlot;
     inline ~LocTimerDelegate() { if (mLock) { mLock->drop(); mLock = NULL; } }
 public:
-    LocTimerDelegate(LocTimer& client, struct timespec& futureTime, LocTimerContainer* container);
+    LocTimerDelegate(LocTimer& client, struct timespec& earliestTime,
+                     struct timespec& futureTime, LocTimerContainer* container);
     void destroyLocked();
     // LocRankable virtual method
     virtual int ranks(LocRankable& rankable);
@@ -205,6 +247,75 @@ public:
     inline struct timespec getFutureTime() { return mFutureTime; }
 };
 
+// LOC_TIMER_BACKEND_HEAP - timers are kept in a LocHeap, ranked by
+// LocTimerDelegate::ranks().
+class LocTimerHeap : public LocTimerQueue {
+    LocHeap mHeap;
+public:
+    inline virtual void push(LocTimerDelegate& timer) override {
+        mHeap.push((LocRankable&)timer);
+    }
+    inline virtual LocTimerDelegate* peek() override {
+        return (LocTimerDelegate*)(mHeap.peek());
+    }
+    inline virtual bool remove(LocTimerDelegate& timer) override {
+        return NULL != mHeap.remove((LocRankable&)timer);
+    }
+    virtual LocTimerDelegate* popExpired(const struct timespec& now) override;
+};
+
+// LOC_TIMER_BACKEND_WHEEL - a hierarchical timer wheel of 1 ms ticks.
+// Level L has WHEEL_SLOTS slots, each of WHEEL_SLOTS^L ticks. A timer is placed
+// by its absolute tick, in the lowest level where its tick and mNow have all
+// the higher level bits in common. So the slots of a level are in time order,
+// and all the timers of a level expire before those of the next level. Timers
+// that do not fit in the top level (only when mNow is close to the top level
+// wrap) go to the overflow level WHEEL_LEVELS. Advancing mNow takes the timers
+// out of the slots it passes, which either expire, or cascade down to a lower
+// level. Since a timer cascades at most WHEEL_LEVELS times, push / remove /
+// expire are amortized O(1). The soonest timer is cached, and only when it
+// leaves the wheel, it is looked up again in the earliest non empty slot.
+class LocTimerWheel : public LocTimerQueue {
+    static const uint32_t WHEEL_BITS = 6;
+    static const uint32_t WHEEL_SLOTS = 1 << WHEEL_BITS;
+    static const uint64_t WHEEL_MASK = WHEEL_SLOTS - 1;
+    static const int WHEEL_LEVELS = 6;
+public:
+    // mWheelLevel of a timer not in the wheel; or expired, waiting in mDue
+    static const int WHEEL_NONE = -1;
+    static const int WHEEL_DUE = -2;
+private:
+    // heads of the slot lists, of the overflow level only slot 0 is used
+    LocTimerDelegate* mSlots[WHEEL_LEVELS + 1][WHEEL_SLOTS];
+    // bit n of mOccupied[L] is set when mSlots[L][n] is not empty
+    uint64_t mOccupied[WHEEL_LEVELS + 1];
+    // current tick of the wheel
+    uint64_t mNow;
+    // the soonest timer in the slots
+    LocTimerDelegate* mSoonest;
+    // expired timers in time out order, from mDueHead on yet to be popped
+    std::vector<LocTimerDelegate*> mDue;
+    size_t mDueHead;
+
+    static inline uint64_t slotRange(uint32_t first, uint32_t last) {
+        return ((last >= WHEEL_SLOTS - 1) ? ~0ULL : ((1ULL << (last + 1)) - 1)) &
+               ~((1ULL << first) - 1);
+    }
+    void link(LocTimerDelegate& timer);
+    void unlink(LocTimerDelegate& timer);
+    // moves all the timers in the slots of slotMask of the level to list
+    void collect(int level, uint64_t slotMask, LocTimerDelegate*& list);
+    // moves mNow to now, expired timers are appended to mDue
+    void advance(uint64_t now);
+    void findSoonest();
+public:
+    LocTimerWheel();
+    virtual void push(LocTimerDelegate& timer) override;
+    virtual LocTimerDelegate* peek() override;
+    virtual bool remove(LocTimerDelegate& timer) override;
+    virtual LocTimerDelegate* popExpired(const struct timespec& now) override;
+};
+
 /***************************LocTimerContainer methods***************************/
 
 // Most of these static recources are created on demand. They however are never
@@ -217,12 +328,16 @@ LocTimerContainer* LocTimerContainer::mSwTimers = NULL;
 LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
+LocTimerBackend LocTimerContainer::mBackend = LOC_TIMER_BACKEND_WHEEL;
 
 // ctor - initialize timer heaps
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
-LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+LocTimerContainer::LocTimerContainer(bool wakeOnExpire, LocTimerBackend backend) :
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mQueue(LOC_TIMER_BACKEND_HEAP == backend ?
+           (LocTimerQueue*)new LocTimerHeap() : (LocTimerQueue*)new LocTimerWheel()),
+    mArmedTime{} {
 
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
@@ -244,6 +359,7 @@ LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
 inline
 LocTimerContainer::~LocTimerContainer() {
     close(mDevFd);
+    delete mQueue;
 }
 
 LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
@@ -254,7 +370,7 @@ LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
         pthread_mutex_lock(&mMutex);
         // let's check one more time to be safe
         if (!container) {
-            container = new LocTimerContainer(wakeOnExpire);
+            container = new LocTimerContainer(wakeOnExpire, mBackend);
             // timerfd_create failure
             if (-1 == container->getTimerFd()) {
                 delete container;
@@ -266,6 +382,12 @@ LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
     return container;
 }
 
+void LocTimerContainer::setBackend(LocTimerBackend backend) {
+    pthread_mutex_lock(&mMutex);
+    mBackend = backend;
+    pthread_mutex_unlock(&mMutex);
+}
+
 MsgTask* LocTimerContainer::getMsgTaskLocked() {
     // it is cheap to check pointer first than locking mutext unconditionally
     if (!mMsgTask) {
@@ -284,7 +406,7 @@ LocTimerPollTask* LocTimerContainer::getPollTaskLocked() {
 
 inline
 LocTimerDelegate* LocTimerContainer::getSoonestTimer() {
-    return (LocTimerDelegate*)(peek());
+    return mQueue->peek();
 }
 
 inline
@@ -292,31 +414,27 @@ int LocTimerContainer::getTimerFd() {
     return mDevFd;
 }
 
-void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
+void LocTimerContainer::updateSoonestTime() {
     LocTimerDelegate* curTop = getSoonestTimer();
+    struct itimerspec delay;
+    memset(&delay, 0, sizeof(struct itimerspec));
+    if (curTop) {
+        delay.it_value = curTop->getFutureTime();
+    }
 
-    // check if top has changed
-    if (curTop != priorTop) {
-        struct itimerspec delay;
-        memset(&delay, 0, sizeof(struct itimerspec));
-        bool toSetTime = false;
-        // if tree is empty now, we remove poll and disarm timer
+    // only go to kernel if the soonest time out has changed
+    if (delay.it_value.tv_sec != mArmedTime.tv_sec ||
+        delay.it_value.tv_nsec != mArmedTime.tv_nsec) {
         if (!curTop) {
+            // if queue is empty now, we remove poll and disarm timer
             mPollTask->removePoll(*this);
-            // setting the values to disarm timer
-            delay.it_value.tv_sec = 0;
-            delay.it_value.tv_nsec = 0;
-            toSetTime = true;
-        } else if (!priorTop || curTop->outRanks(*priorTop)) {
+        } else {
             // do this first to avoid race condition, in case settime is called
             // with too small an interval
             mPollTask->addPoll(*this);
-            delay.it_value = curTop->getFutureTime();
-            toSetTime = true;
-        }
-        if (toSetTime) {
-            timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
         }
+        timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        mArmedTime = delay.it_value;
     }
 }
 
@@ -329,9 +447,8 @@ void LocTimerContainer::add(LocTimerDelegate& timer) {
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-            mTimerContainer->push((LocRankable&)(*mTimer));
-            mTimerContainer->updateSoonestTime(priorTop);
+            mTimerContainer->mQueue->push(*mTimer);
+            mTimerContainer->updateSoonestTime();
         }
     };
 
@@ -346,14 +463,10 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
         inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-
             // update soonest timer only if mTimer is actually removed from
-            // mTimerContainer AND mTimer is not priorTop.
-            if (priorTop == ((LocHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
-                // if passing in NULL, we tell updateSoonestTime to update
-                // kernel with the current top timer interval.
-                mTimerContainer->updateSoonestTime(NULL);
+            // mTimerContainer, updateSoonestTime() tells if it was the top.
+            if (mTimerContainer->mQueue->remove(*mTimer)) {
+                mTimerContainer->updateSoonestTime();
             }
             // all timers are deleted here, and only here.
             delete mTimer;
@@ -364,8 +477,9 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
 }
 
 // all the heap management is done in the MsgTask context.
-// Upon expire, we check and continuously pop the heap until
-// the top node's timeout is in the future.
+// Upon expire, we check and continuously pop the queue until
+// the top node's timeout is in the future, and its slack window
+// has not begun yet.
 void LocTimerContainer::expire() {
     struct MsgTimerExpire : public LocMsg {
         LocTimerContainer* mTimerContainer;
@@ -375,16 +489,17 @@ void LocTimerContainer::expire() {
             struct timespec now;
             // get time spec of now
             clock_gettime(CLOCK_BOOTTIME, &now);
-            LocTimerDelegate timerOfNow(now);
-            // pop everything in the heap that outRanks now, i.e. has time older than now
+            // timer fd was disarmed by expire() in the poll thread
+            mTimerContainer->mArmedTime = {};
+            // pop everything in the queue that has time older than now
             // and then call expire() on that timer.
-            for (LocTimerDelegate* timer = (LocTimerDelegate*)mTimerContainer->pop();
+            for (LocTimerDelegate* timer = mTimerContainer->popExpired(now);
                  NULL != timer;
-                 timer = mTimerContainer->popIfOutRanks(timerOfNow)) {
+                 timer = mTimerContainer->popExpired(now)) {
                 // the timer delegate obj will be deleted before the return of this call
                 timer->expire();
             }
-            mTimerContainer->updateSoonestTime(NULL);
+            mTimerContainer->updateSoonestTime();
         }
     };
 
@@ -395,16 +510,23 @@ void LocTimerContainer::expire() {
     mMsgTask->sendMsg(new MsgTimerExpire(*this));
 }
 
-LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
-    LocTimerDelegate* poppedNode = NULL;
-    if (mTree && !timer.outRanks(*peek())) {
-        poppedNode = (LocTimerDelegate*)(pop());
+// Timers whose slack windows overlap with that of the soonest one are
+// coalesced into its wake up: after the timers that are due, the following
+// ones are also popped while their earliest time has passed.
+LocTimerDelegate* LocTimerContainer::popExpired(const struct timespec& now) {
+    LocTimerDelegate* timer = mQueue->popExpired(now);
+    if (NULL == timer) {
+        LocTimerDelegate* top = mQueue->peek();
+        if (top && (top->mEarliestTime.tv_sec < now.tv_sec ||
+                    (top->mEarliestTime.tv_sec == now.tv_sec &&
+                     top->mEarliestTime.tv_nsec <= now.tv_nsec)) &&
+            mQueue->remove(*top)) {
+            timer = top;
+        }
     }
-
-    return poppedNode;
+    return timer;
 }
 
-
 /***************************LocTimerPollTask methods***************************/
 
 inline
@@ -468,12 +590,19 @@ bool TimerRunnable::run() {
 
 inline
 LocTimerDelegate::LocTimerDelegate(LocTimer& client,
+                                   struct timespec& earliestTime,
                                    struct timespec& futureTime,
                                    LocTimerContainer* container)
     : mClient(&client),
       mLock(mClient->mLock->share()),
       mFutureTime(futureTime),
-      mContainer(container) {
+      mEarliestTime(earliestTime),
+      mContainer(container),
+      mWheelPrev(NULL),
+      mWheelNext(NULL),
+      mWheelTick(0),
+      mWheelLevel(LocTimerWheel::WHEEL_NONE),
+      mWheelSlot(0) {
     // adding the timer into the container
     mContainer->add(*this);
 }
@@ -529,6 +658,208 @@ void LocTimerDelegate::expire() {
 }
 
 
+/*****************************LocTimerHeap methods****************************/
+
+LocTimerDelegate* LocTimerHeap::popExpired(const struct timespec& now) {
+    LocTimerDelegate* poppedNode = NULL;
+    LocTimerDelegate* top = peek();
+    if (top && (top->mFutureTime.tv_sec < now.tv_sec ||
+                (top->mFutureTime.tv_sec == now.tv_sec &&
+                 top->mFutureTime.tv_nsec <= now.tv_nsec))) {
+        poppedNode = (LocTimerDelegate*)(mHeap.pop());
+    }
+    return poppedNode;
+}
+
+/****************************LocTimerWheel methods****************************/
+
+LocTimerWheel::LocTimerWheel() : mNow(0), mSoonest(NULL), mDueHead(0) {
+    memset(mSlots, 0, sizeof(mSlots));
+    memset(mOccupied, 0, sizeof(mOccupied));
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    mNow = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void LocTimerWheel::link(LocTimerDelegate& timer) {
+    // a timer already in the past goes to the current slot
+    uint64_t tick = (timer.mWheelTick > mNow) ? timer.mWheelTick : mNow;
+    uint64_t diff = tick ^ mNow;
+    int level = (0 == diff) ? 0 : (63 - __builtin_clzll(diff)) / WHEEL_BITS;
+    uint32_t slot = 0;
+    if (level >= WHEEL_LEVELS) {
+        level = WHEEL_LEVELS;
+    } else {
+        slot = (tick >> (level * WHEEL_BITS)) & WHEEL_MASK;
+    }
+
+    LocTimerDelegate*& head = mSlots[level][slot];
+    timer.mWheelLevel = level;
+    timer.mWheelSlot = slot;
+    timer.mWheelPrev = NULL;
+    timer.mWheelNext = head;
+    if (head) {
+        head->mWheelPrev = &timer;
+    }
+    head = &timer;
+    mOccupied[level] |= (1ULL << slot);
+}
+
+void LocTimerWheel::unlink(LocTimerDelegate& timer) {
+    LocTimerDelegate*& head = mSlots[timer.mWheelLevel][timer.mWheelSlot];
+    if (timer.mWheelPrev) {
+        timer.mWheelPrev->mWheelNext = timer.mWheelNext;
+    } else {
+        head = timer.mWheelNext;
+    }
+    if (timer.mWheelNext) {
+        timer.mWheelNext->mWheelPrev = timer.mWheelPrev;
+    }
+    if (!head) {
+        mOccupied[timer.mWheelLevel] &= ~(1ULL << timer.mWheelSlot);
+    }
+    timer.mWheelPrev = NULL;
+    timer.mWheelNext = NULL;
+    timer.mWheelLevel = WHEEL_NONE;
+}
+
+void LocTimerWheel::collect(int level, uint64_t slotMask, LocTimerDelegate*& list) {
+    uint64_t pending = mOccupied[level] & slotMask;
+    mOccupied[level] &= ~slotMask;
+    while (pending) {
+        uint32_t slot = __builtin_ctzll(pending);
+        pending &= (pending - 1);
+        LocTimerDelegate* timer = mSlots[level][slot];
+        mSlots[level][slot] = NULL;
+        while (timer) {
+            LocTimerDelegate* next = timer->mWheelNext;
+            timer->mWheelNext = list;
+            list = timer;
+            timer = next;
+        }
+    }
+}
+
+void LocTimerWheel::advance(uint64_t now) {
+    if (now < mNow) {
+        return;
+    }
+
+    LocTimerDelegate* list = NULL;
+    // level 0 slots from mNow's to now's, within the current level 0 window
+    uint64_t windowEnd = mNow | WHEEL_MASK;
+    collect(0, slotRange(mNow & WHEEL_MASK, (now > windowEnd ? windowEnd : now) & WHEEL_MASK),
+            list);
+    // higher level slots after mNow's up to now's, within their windows
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        uint32_t shift = level * WHEEL_BITS;
+        uint64_t from = mNow >> shift;
+        uint64_t to = now >> shift;
+        if (from == to) {
+            // neither this level nor any level above is passed
+            break;
+        }
+        uint32_t first = (from & WHEEL_MASK) + 1;
+        windowEnd = from | WHEEL_MASK;
+        if (first < WHEEL_SLOTS) {
+            collect(level, slotRange(first, (to > windowEnd ? windowEnd : to) & WHEEL_MASK),
+                    list);
+        }
+    }
+    if ((mNow >> (WHEEL_LEVELS * WHEEL_BITS)) != (now >> (WHEEL_LEVELS * WHEEL_BITS))) {
+        collect(WHEEL_LEVELS, 1, list);
+    }
+
+    mNow = now;
+    size_t dueStart = mDue.size();
+    while (list) {
+        LocTimerDelegate* timer = list;
+        list = timer->mWheelNext;
+        if (timer->mWheelTick <= now) {
+            timer->mWheelPrev = NULL;
+            timer->mWheelNext = NULL;
+            timer->mWheelLevel = WHEEL_DUE;
+            mDue.push_back(timer);
+        } else {
+            // cascade down
+            link(*timer);
+        }
+    }
+    std::stable_sort(mDue.begin() + dueStart, mDue.end(),
+                     [](LocTimerDelegate* a, LocTimerDelegate* b) {
+                         return a->mWheelTick < b->mWheelTick;
+                     });
+    if (mSoonest && mSoonest->mWheelLevel < 0) {
+        findSoonest();
+    }
+}
+
+void LocTimerWheel::findSoonest() {
+    mSoonest = NULL;
+    for (int level = 0; level <= WHEEL_LEVELS && NULL == mSoonest; level++) {
+        if (mOccupied[level]) {
+            // slots are in time order, only the earliest one is searched
+            uint32_t slot = __builtin_ctzll(mOccupied[level]);
+            for (LocTimerDelegate* timer = mSlots[level][slot]; timer; timer = timer->mWheelNext) {
+                if (!mSoonest || timer->mWheelTick < mSoonest->mWheelTick) {
+                    mSoonest = timer;
+                }
+            }
+        }
+    }
+}
+
+void LocTimerWheel::push(LocTimerDelegate& timer) {
+    // round the time out up to a tick, so that the timer fd is always
+    // programmed on a tick, when all the timers of the slot expire.
+    timer.mWheelTick = (uint64_t)timer.mFutureTime.tv_sec * 1000 +
+            (timer.mFutureTime.tv_nsec + 999999) / 1000000;
+    timer.mFutureTime.tv_sec = timer.mWheelTick / 1000;
+    timer.mFutureTime.tv_nsec = (timer.mWheelTick % 1000) * 1000000;
+    link(timer);
+    if (!mSoonest || timer.mWheelTick < mSoonest->mWheelTick) {
+        mSoonest = &timer;
+    }
+}
+
+LocTimerDelegate* LocTimerWheel::peek() {
+    return (mDueHead < mDue.size()) ? mDue[mDueHead] : mSoonest;
+}
+
+bool LocTimerWheel::remove(LocTimerDelegate& timer) {
+    bool removed = false;
+    if (timer.mWheelLevel >= 0) {
+        unlink(timer);
+        if (&timer == mSoonest) {
+            findSoonest();
+        }
+        removed = true;
+    } else if (WHEEL_DUE == timer.mWheelLevel) {
+        auto it = std::find(mDue.begin() + mDueHead, mDue.end(), &timer);
+        if (mDue.end() != it) {
+            mDue.erase(it);
+            removed = true;
+        }
+        timer.mWheelLevel = WHEEL_NONE;
+    }
+    return removed;
+}
+
+LocTimerDelegate* LocTimerWheel::popExpired(const struct timespec& now) {
+    if (mDueHead >= mDue.size()) {
+        mDue.clear();
+        mDueHead = 0;
+        advance((uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+    }
+
+    LocTimerDelegate* timer = NULL;
+    if (mDueHead < mDue.size()) {
+        timer = mDue[mDueHead++];
+        timer->mWheelLevel = WHEEL_NONE;
+    }
+    return timer;
+}
+
 /***************************LocTimer methods***************************/
 LocTimer::LocTimer() : mTimer(NULL), mLock(new LocSharedLock()) {
 }
@@ -541,37 +872,61 @@ LocTimer::~LocTimer() {
     }
 }
 
+static inline void addMs(struct timespec& time, uint32_t ms) {
+    time.tv_sec += ms / 1000;
+    time.tv_nsec += (ms % 1000) * 1000000;
+    if (time.tv_nsec >= 1000000000) {
+        time.tv_sec += time.tv_nsec / 1000000000;
+        time.tv_nsec %= 1000000000;
+    }
+}
+
 bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
+    return start(timeOutInMs, wakeOnExpire, 0);
+}
+
+bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire, uint32_t slackInMs) {
     bool success = false;
+    // already running, start() would fail under the lock just the same
+    if (mLock->peekState()) {
+        return false;
+    }
     mLock->lock();
     if (!mTimer) {
-        struct timespec futureTime;
-        clock_gettime(CLOCK_BOOTTIME, &futureTime);
-        futureTime.tv_sec += timeOutInMs / 1000;
-        futureTime.tv_nsec += (timeOutInMs % 1000) * 1000000;
-        if (futureTime.tv_nsec >= 1000000000) {
-            futureTime.tv_sec += futureTime.tv_nsec / 1000000000;
-            futureTime.tv_nsec %= 1000000000;
-        }
+        struct timespec earliestTime;
+        clock_gettime(CLOCK_BOOTTIME, &earliestTime);
+        addMs(earliestTime, timeOutInMs);
+        struct timespec futureTime = earliestTime;
+        addMs(futureTime, slackInMs);
 
         LocTimerContainer* container;
         container = LocTimerContainer::get(wakeOnExpire);
         if (NULL != container) {
-            mTimer = new LocTimerDelegate(*this, futureTime, container);
+            mTimer = new LocTimerDelegate(*this, earliestTime, futureTime, container);
             // if mTimer is non 0, success should be 0; or vice versa
         }
         success = (NULL != mTimer);
+        mLock->setStateLocked(success);
     }
     mLock->unlock();
     return success;
 }
 
+void LocTimer::setBackend(LocTimerBackend backend) {
+    LocTimerContainer::setBackend(backend);
+}
+
 bool LocTimer::stop() {
     bool success = false;
+    // not running, which is most stop() calls: restarts and destructors
+    if (!mLock->peekState()) {
+        return false;
+    }
     mLock->lock();
     if (mTimer) {
         LocTimerDelegate* timer = mTimer;
         mTimer = NULL;
+        mLock->setStateLocked(0);
         if (timer) {
             timer->destroyLocked();
             success = true;
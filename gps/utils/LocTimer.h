@@ -39,6 +39,16 @@ namespace loc_util {
 class LocTimerDelegate;
 class LocSharedLock;
 
+// Storage used by the timer service to order pending timers.
+// LOC_TIMER_BACKEND_HEAP:  binary heap (LocHeap), O(log n) start / stop.
+// LOC_TIMER_BACKEND_WHEEL: hierarchical timer wheel with 1 ms ticks,
+//                          amortized O(1) start / stop. Deadlines are
+//                          rounded up to the next ms.
+enum LocTimerBackend {
+    LOC_TIMER_BACKEND_HEAP = 0,
+    LOC_TIMER_BACKEND_WHEEL,
+};
+
 // LocTimer client must extend this class and implementthe callback.
 // start() / stop() methods are to arm / disarm timer.
 class LocTimer
@@ -63,6 +73,12 @@ public:
     //               false on failure, e.g. timer is already running.
     bool start(uint32_t timeOutInMs, bool wakeOnExpire);
 
+    // same as above, with
+    // slackInMs:    how late the timer may expire, so that it can expire
+    //               together with other timers in one wake up. The timer
+    //               expires in [timeOutInMs, timeOutInMs + slackInMs].
+    bool start(uint32_t timeOutInMs, bool wakeOnExpire, uint32_t slackInMs);
+
     // return:       true on success;
     //               false on failure, e.g. timer is not running.
     bool stop();
@@ -71,6 +87,12 @@ public:
     //  This method is used for timeout calling back to client. This method
     //  should be short enough (eg: send a message to your own thread).
     virtual void timeOutCallback() = 0;
+
+    // select the storage backend of the timer service. The timer / alarm
+    // containers pick the backend when they are created, i.e. upon the first
+    // start() with the respective wakeOnExpire, so this should be called
+    // before any timer is started. Default is LOC_TIMER_BACKEND_WHEEL.
+    static void setBackend(LocTimerBackend backend);
 };
 
 } // namespace loc_util
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <atomic>
+#include <LocTrace.h>
+
+#if defined (USE_ANDROID_LOGGING) || defined (ANDROID)
+#include <cutils/trace.h>
+#define LOC_TRACE_TAG ATRACE_TAG_HAL
+#endif
+
+#define LOC_TRACE_FIX_NAME "gnss_fix"
+#define LOC_TRACE_NAME_MAX 96
+
+namespace loc_util {
+
+static std::atomic<uint32_t> sLastFixId(0);
+static thread_local uint32_t sCurrentFixId = 0;
+
+uint32_t LocTrace::startFix() {
+    uint32_t fixId = ++sLastFixId;
+    if (0 == fixId) {
+        // 0 means "no fix", skip it on wrap around
+        fixId = ++sLastFixId;
+    }
+#ifdef LOC_TRACE_TAG
+    atrace_async_begin(LOC_TRACE_TAG, LOC_TRACE_FIX_NAME, (int32_t)fixId);
+#endif
+    return fixId;
+}
+
+void LocTrace::endFix(uint32_t fixId) {
+#ifdef LOC_TRACE_TAG
+    if (0 != fixId) {
+        atrace_async_end(LOC_TRACE_TAG, LOC_TRACE_FIX_NAME, (int32_t)fixId);
+    }
+#else
+    (void)fixId;
+#endif
+}
+
+uint32_t LocTrace::currentFixId() {
+    return sCurrentFixId;
+}
+
+void LocTrace::setCurrentFixId(uint32_t fixId) {
+    sCurrentFixId = fixId;
+}
+
+bool LocTrace::isEnabled() {
+#ifdef LOC_TRACE_TAG
+    return atrace_is_tag_enabled(LOC_TRACE_TAG);
+#else
+    return false;
+#endif
+}
+
+void LocTrace::beginHop(const char* hop, uint32_t fixId) {
+#ifdef LOC_TRACE_TAG
+    char name[LOC_TRACE_NAME_MAX];
+    snprintf(name, sizeof(name), "%s fix=%u", hop, fixId);
+    atrace_begin(LOC_TRACE_TAG, name);
+#else
+    (void)hop;
+    (void)fixId;
+#endif
+}
+
+void LocTrace::endHop() {
+#ifdef LOC_TRACE_TAG
+    atrace_end(LOC_TRACE_TAG);
+#endif
+}
+
+LocTraceHop::LocTraceHop(const char* hop, uint32_t fixId, bool endsFix) :
+    mFixId(fixId), mPrevFixId(sCurrentFixId), mEndsFix(endsFix),
+    mTraced(LocTrace::isEnabled()) {
+    sCurrentFixId = fixId;
+    if (mTraced) {
+        LocTrace::beginHop(hop, fixId);
+    }
+}
+
+LocTraceHop::~LocTraceHop() {
+    if (mTraced) {
+        LocTrace::endHop();
+    }
+    if (mEndsFix) {
+        LocTrace::endFix(mFixId);
+    }
+    sCurrentFixId = mPrevFixId;
+}
+
+} // namespace loc_util
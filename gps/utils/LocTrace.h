@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef LOC_TRACE_H
+#define LOC_TRACE_H
+
+#include <stdint.h>
+
+namespace loc_util {
+
+// Trace points for following one fix through the report pipeline.
+// On Android they are emitted as atrace markers under the HAL tag, so a
+// Perfetto or systrace capture with the "hal" category shows:
+//  - one async slice "gnss_fix" per fix, with the fix ID as its cookie,
+//    opened where LocApiBase receives the report and closed when the
+//    adapter has finished delivering it to all clients;
+//  - one thread slice per hop, named "<hop> fix=<id>", on whichever
+//    thread executes that hop.
+// Nothing is formatted or written unless tracing is enabled.
+class LocTrace {
+public:
+    // Allocates a new fix ID and opens its async slice.
+    static uint32_t startFix();
+    // Closes the async slice of fixId.
+    static void endFix(uint32_t fixId);
+    // The fix ID being handled on the calling thread, 0 if none. Hops
+    // running on the same thread as their caller pick it up from here;
+    // hops behind a message queue must carry it in the message.
+    static uint32_t currentFixId();
+    static void setCurrentFixId(uint32_t fixId);
+    static bool isEnabled();
+    static void beginHop(const char* hop, uint32_t fixId);
+    static void endHop();
+};
+
+// Scoped hop: traces hop for its lifetime and makes fixId the current fix
+// ID of the thread, restoring the previous one on exit. With endsFix set
+// it also closes the fix async slice on exit.
+class LocTraceHop {
+    const uint32_t mFixId;
+    const uint32_t mPrevFixId;
+    const bool mEndsFix;
+    const bool mTraced;
+public:
+    LocTraceHop(const char* hop, uint32_t fixId = LocTrace::currentFixId(),
+                bool endsFix = false);
+    ~LocTraceHop();
+    inline uint32_t getFixId() const { return mFixId; }
+};
+
+} // namespace loc_util
+
+#endif /* LOC_TRACE_H */
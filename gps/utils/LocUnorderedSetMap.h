@@ -30,6 +30,10 @@
 #define __LOC_UNORDERDED_SETMAP_H__
 
 #include <algorithm>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <stdint.h>
 #include <loc_pla.h>
 
 #ifdef NO_UNORDERED_SET_OR_MAP
@@ -63,69 +67,256 @@ inline static void trimSet(unordered_set<T>& fromSet, const unordered_set<T>& rV
 template <typename T>
 static unordered_set<T> removeAndReturnInterset(unordered_set<T>& s1, unordered_set<T>& s2) {
     unordered_set<T> common = {};
-    for (auto b = s2.begin(); b != s2.end(); b++) {
-        auto a = find(s1.begin(), s1.end(), *b);
+    for (auto b = s2.begin(); b != s2.end(); ) {
+        auto a = s1.find(*b);
         if (a != s1.end()) {
             // this is a common item of both l1 and l2, remove from both
             // but after we add to common
             common.insert(*a);
             s1.erase(a);
-            s2.erase(b);
+            b = s2.erase(b);
+        } else {
+            b++;
         }
     }
     return common;
 }
 
+// A set of trivially copyable VALs, e.g. pointers or enums, kept in a flat
+// array. The first INLINE_SIZE elements are stored inline, only larger sets
+// allocate. Lookups are linear, which beats hashing for the handful of
+// elements these sets hold.
+template <typename T, size_t INLINE_SIZE = 8>
+class LocSmallSet {
+    static_assert(std::is_trivially_copyable<T>::value, "LocSmallSet needs a POD element");
+    T mInline[INLINE_SIZE];
+    std::vector<T> mSpill;
+    size_t mSize;
+
+    inline T* data() { return (mSize <= INLINE_SIZE) ? mInline : mSpill.data(); }
+    inline const T* data() const { return (mSize <= INLINE_SIZE) ? mInline : mSpill.data(); }
+public:
+    inline LocSmallSet() : mSize(0) {}
+
+    inline const T* begin() const { return data(); }
+    inline const T* end() const { return data() + mSize; }
+    inline size_t size() const { return mSize; }
+    inline bool empty() const { return 0 == mSize; }
+    inline bool contains(const T& val) const { return end() != std::find(begin(), end(), val); }
+
+    // returns true if val is newly inserted
+    bool insert(const T& val) {
+        bool inserted = !contains(val);
+        if (inserted) {
+            if (mSize < INLINE_SIZE) {
+                mInline[mSize] = val;
+            } else {
+                if (mSize == INLINE_SIZE) {
+                    mSpill.assign(mInline, mInline + INLINE_SIZE);
+                }
+                mSpill.push_back(val);
+            }
+            mSize++;
+        }
+        return inserted;
+    }
+
+    // returns true if val was in the set
+    bool erase(const T& val) {
+        T* vals = data();
+        T* pos = std::find(vals, vals + mSize, val);
+        bool erased = (vals + mSize != pos);
+        if (erased) {
+            // order is irrelevant, move the last one into the hole
+            *pos = vals[mSize - 1];
+            mSize--;
+            if (mSize == INLINE_SIZE) {
+                std::copy(mSpill.begin(), mSpill.begin() + INLINE_SIZE, mInline);
+                mSpill.clear();
+            } else if (mSize > INLINE_SIZE) {
+                mSpill.pop_back();
+            }
+        }
+        return erased;
+    }
+
+    inline void clear() {
+        mSize = 0;
+        mSpill.clear();
+    }
+
+    inline unordered_set<T> toSet() const { return unordered_set<T>(begin(), end()); }
+};
+
+// KEY -> set of VALs, in an open addressing (linear probing) hash table. Both
+// KEY and VAL are expected to be small and trivially copyable, like the
+// DataItemId and IDataItemObserver* they are used for. Each VAL set is a
+// LocSmallSet inline in the table slot, so neither the map nor the sets
+// allocate per entry. Removal shifts the following entries back instead of
+// leaving tombstones, so lookups never get slower over time.
 template <typename KEY, typename VAL>
 class LocUnorderedSetMap {
-    unordered_map<KEY, unordered_set<VAL>> mMap;
+    typedef LocSmallSet<VAL> ValSet;
+    struct Slot {
+        bool mUsed;
+        KEY mKey;
+        ValSet mVals;
+        inline Slot() : mUsed(false), mKey() {}
+    };
+    std::vector<Slot> mSlots;
+    size_t mSize;
+
+    inline size_t home(const KEY& key) const {
+        // std::hash of pointers and enums is often identity, mix the bits
+        uint64_t h = (uint64_t)std::hash<KEY>()(key) * 0x9E3779B97F4A7C15ULL;
+        return (size_t)(h >> 32) & (mSlots.size() - 1);
+    }
+
+    // returns the slot of key, or nullptr if not found
+    Slot* findSlot(const KEY& key) {
+        if (0 == mSize) {
+            return nullptr;
+        }
+        size_t mask = mSlots.size() - 1;
+        for (size_t i = home(key); mSlots[i].mUsed; i = (i + 1) & mask) {
+            if (mSlots[i].mKey == key) {
+                return &mSlots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // returns the slot of key, an empty one is claimed if key not found
+    Slot& claimSlot(const KEY& key, bool& added) {
+        Slot* slot = findSlot(key);
+        added = (nullptr == slot);
+        if (added) {
+            // keep the load factor at most 1/2
+            if ((mSize + 1) * 2 > mSlots.size()) {
+                rehash(mSlots.size() * 2);
+            }
+            size_t mask = mSlots.size() - 1;
+            size_t i = home(key);
+            while (mSlots[i].mUsed) {
+                i = (i + 1) & mask;
+            }
+            slot = &mSlots[i];
+            slot->mUsed = true;
+            slot->mKey = key;
+            mSize++;
+        }
+        return *slot;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> slots(capacity);
+        mSlots.swap(slots);
+        size_t mask = mSlots.size() - 1;
+        for (auto& slot : slots) {
+            if (slot.mUsed) {
+                size_t i = home(slot.mKey);
+                while (mSlots[i].mUsed) {
+                    i = (i + 1) & mask;
+                }
+                mSlots[i] = std::move(slot);
+            }
+        }
+    }
 
-    // Trim the VALs pointed to by *iter*, with everything that also exist in *rVals*.
+    // backward shift deletion
+    void eraseSlot(Slot* slot) {
+        size_t mask = mSlots.size() - 1;
+        size_t hole = slot - mSlots.data();
+        for (size_t i = (hole + 1) & mask; mSlots[i].mUsed; i = (i + 1) & mask) {
+            // an entry can fill the hole if its home is not in (hole, i]
+            size_t h = home(mSlots[i].mKey);
+            if (((i - h) & mask) >= ((i - hole) & mask)) {
+                mSlots[hole] = std::move(mSlots[i]);
+                hole = i;
+            }
+        }
+        mSlots[hole].mUsed = false;
+        mSlots[hole].mVals.clear();
+        mSize--;
+    }
+
+    // Trim the VALs of *slot*, with everything that also exist in *rVals*.
     // If the set becomes empty, remove the map entry. *goneVals*, if not null, records
     // the trimmed VALs.
-    bool trimOrRemove(typename unordered_map<KEY, unordered_set<VAL>>::iterator iter,
-                      const unordered_set<VAL>& rVals, unordered_set<VAL>* goneVals) {
-        trimSet<VAL>(iter->second, rVals, goneVals);
-        bool removeEntry = (iter->second.empty());
+    bool trimOrRemove(Slot* slot, const unordered_set<VAL>& rVals,
+                      unordered_set<VAL>* goneVals) {
+        for (auto val : rVals) {
+            if (slot->mVals.erase(val) && nullptr != goneVals) {
+                goneVals->insert(val);
+            }
+        }
+        bool removeEntry = slot->mVals.empty();
         if (removeEntry) {
-            mMap.erase(iter);
+            eraseSlot(slot);
         }
         return removeEntry;
     }
 
 public:
-    inline LocUnorderedSetMap() {}
-    inline LocUnorderedSetMap(size_t size) : LocUnorderedSetMap() {
-        mMap.get_allocator().allocate(size);
+    inline LocUnorderedSetMap() : LocUnorderedSetMap(8) {}
+    // size is the expected number of KEYs, e.g. the size of the KEY space
+    inline LocUnorderedSetMap(size_t size) : mSize(0) {
+        size_t capacity = 8;
+        while (capacity < size * 2) {
+            capacity <<= 1;
+        }
+        mSlots.resize(capacity);
     }
 
-    inline bool empty() { return mMap.empty(); }
+    inline bool empty() { return 0 == mSize; }
 
     // This gets the raw pointer to the VALs pointed to by *key*
     // If the entry is not in the map, nullptr will be returned.
-    inline unordered_set<VAL>* getValSetPtr(const KEY& key) {
-        auto entry = mMap.find(key);
-        return (entry != mMap.end()) ? &(entry->second) : nullptr;
+    inline const LocSmallSet<VAL>* getValSetPtr(const KEY& key) {
+        Slot* slot = findSlot(key);
+        return (nullptr != slot) ? &(slot->mVals) : nullptr;
     }
 
     //  This gets a copy of VALs pointed to by *key*
     // If the entry is not in the map, an empty set will be returned.
     inline unordered_set<VAL> getValSet(const KEY& key) {
-        auto entry = mMap.find(key);
-        return (entry != mMap.end()) ? entry->second : unordered_set<VAL>{};
+        Slot* slot = findSlot(key);
+        return (nullptr != slot) ? slot->mVals.toSet() : unordered_set<VAL>{};
+    }
+
+    // This splits the VALs pointed to by *key* in one pass, into those that also exist
+    // in *vals*, added to *inVals* if not null; and those that do not, added to
+    // *outVals* if not null.
+    inline void getValSetDiff(const KEY& key, const unordered_set<VAL>& vals,
+                              unordered_set<VAL>* inVals, unordered_set<VAL>* outVals) {
+        Slot* slot = findSlot(key);
+        if (nullptr != slot) {
+            for (auto val : slot->mVals) {
+                unordered_set<VAL>* dest = (vals.end() != vals.find(val)) ? inVals : outVals;
+                if (nullptr != dest) {
+                    dest->insert(val);
+                }
+            }
+        }
     }
 
     // This gets all the KEYs from the map
     inline unordered_set<KEY> getKeys() {
         unordered_set<KEY> keys = {};
-        for (auto entry : mMap) {
-            keys.insert(entry.first);
+        for (auto& slot : mSlots) {
+            if (slot.mUsed) {
+                keys.insert(slot.mKey);
+            }
         }
         return keys;
     }
 
     inline bool remove(const KEY& key) {
-        return mMap.erase(key) > 0;
+        Slot* slot = findSlot(key);
+        if (nullptr != slot) {
+            eraseSlot(slot);
+        }
+        return nullptr != slot;
     }
 
     // This looks into all the entries keyed by *keys*. Remove any VALs from the entries
@@ -139,10 +330,13 @@ public:
 
     inline void trimOrRemove(unordered_set<KEY>& keys, const unordered_set<VAL>& rVals,
                              unordered_set<KEY>* goneKeys, unordered_set<VAL>* goneVals) {
+        if (rVals.empty()) {
+            return;
+        }
         for (auto key : keys) {
-            auto iter = mMap.find(key);
-            if (iter != mMap.end() && trimOrRemove(iter, rVals, goneVals) && nullptr != goneKeys) {
-                goneKeys->insert(iter->first);
+            Slot* slot = findSlot(key);
+            if (nullptr != slot && trimOrRemove(slot, rVals, goneVals) && nullptr != goneKeys) {
+                goneKeys->insert(key);
             }
         }
     }
@@ -152,12 +346,9 @@ public:
     bool add(const KEY& key, const unordered_set<VAL>& newVals) {
         bool newEntryAdded = false;
         if (!newVals.empty()) {
-            auto iter = mMap.find(key);
-            if (iter != mMap.end()) {
-                iter->second.insert(newVals.begin(), newVals.end());
-            } else {
-                mMap[key] = newVals;
-                newEntryAdded = true;
+            Slot& slot = claimSlot(key, newEntryAdded);
+            for (auto val : newVals) {
+                slot.mVals.insert(val);
             }
         }
         return newEntryAdded;
@@ -173,6 +364,9 @@ public:
 
     inline void add(const unordered_set<KEY>& keys, const unordered_set<VAL>& newVals,
                     unordered_set<KEY>* newKeys) {
+        if (newVals.empty()) {
+            return;
+        }
         for (auto key : keys) {
             if (add(key, newVals) && nullptr != newKeys) {
                 newKeys->insert(key);
@@ -182,15 +376,27 @@ public:
 
     // This puts *newVals* into the map keyed by *key*, and returns the VALs that are
     // in effect removed from the keyed VAL set in the map entry.
-    // This call would also remove those same VALs from *newVals*.
+    // This call would also remove from *newVals* the VALs that were already in the
+    // entry, leaving only the ones newly added.
     inline unordered_set<VAL> update(const KEY& key, unordered_set<VAL>& newVals) {
         unordered_set<VAL> goneVals = {};
         if (newVals.empty()) {
-            mMap.erase(key);
+            remove(key);
         } else {
-            auto curVals = mMap[key];
-            mMap[key] = newVals;
-            goneVals = removeAndReturnInterset(curVals, newVals);
+            bool added = false;
+            Slot& slot = claimSlot(key, added);
+            for (auto val : slot.mVals) {
+                if (0 == newVals.erase(val)) {
+                    goneVals.insert(val);
+                }
+            }
+            // the entry now has the remaining newVals plus the common ones
+            for (auto val : goneVals) {
+                slot.mVals.erase(val);
+            }
+            for (auto val : newVals) {
+                slot.mVals.insert(val);
+            }
         }
         return goneVals;
     }
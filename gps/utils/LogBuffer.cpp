@@ -28,6 +28,10 @@
  */
 
 #include "LogBuffer.h"
+#include "LocMemStats.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #ifdef USE_GLIB
 #include <execinfo.h>
 #endif
@@ -54,9 +58,10 @@ LogBuffer* LogBuffer::getInstance() {
     return mInstance;
 }
 
-LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
+LogBuffer::LogBuffer():
         mConfigVec(TOTAL_LOG_LEVELS, ConfigsInLevel(TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC,
-                    MAXIMUM_NUM_IN_LIST, 0)) {
+                    MAXIMUM_NUM_IN_LIST)),
+        mFileHeader(nullptr), mFileSize(0), mFileBacked(false) {
     loc_param_s_type log_buff_config_table[] =
     {
         {"E_LEVEL_TIME_DEPTH",      &mConfigVec[0].mTimeDepthThres,  NULL, 'n'},
@@ -72,44 +77,220 @@ LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
     };
     loc_read_conf(LOC_PATH_GPS_CONF_STR, log_buff_config_table,
             sizeof(log_buff_config_table)/sizeof(log_buff_config_table[0]));
+    mapLogFile();
     registerSignalHandler();
 }
 
+// The rings are kept in LOG_BUFFER_FILE_PATH/logbuffer_<process>.bin, so the
+// logs are in the file as they are appended, and survive a crash with no
+// work in the signal handler. The file of the previous run is kept as .prev.
+// If the file can't be mapped, the rings are kept on heap only.
+void LogBuffer::mapLogFile() {
+    static_assert(TOTAL_LOG_LEVELS == LOG_RING_LEVELS, "LOG_RING_LEVELS mismatch");
+    uint32_t capacity[LOG_RING_LEVELS];
+    for (int i = 0; i < LOG_RING_LEVELS; i++) {
+        capacity[i] = mConfigVec[i].mMaxNumThres;
+    }
+    size_t ringSize = logRingSize(capacity);
+    mFileSize = LOG_BUFFER_RINGS_OFFSET + LOG_BUFFER_MAX_RINGS * ringSize;
+
+    char process[32] = {};
+    int fd = open("/proc/self/comm", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t len = read(fd, process, sizeof(process) - 1);
+        close(fd);
+        while (len > 0 && ('\n' == process[len - 1] || '\0' == process[len - 1])) {
+            process[--len] = '\0';
+        }
+    }
+    string path = string(LOG_BUFFER_FILE_PATH "logbuffer_") + process + ".bin";
+    rename(path.c_str(), (path + ".prev").c_str());
+
+    void* area = MAP_FAILED;
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd >= 0) {
+        if (0 == ftruncate(fd, mFileSize)) {
+            area = mmap(nullptr, mFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    mFileBacked = (MAP_FAILED != area);
+    if (!mFileBacked) {
+        ALOGE("Log buffer file %s not mapped, %s", path.c_str(), strerror(errno));
+        unlink(path.c_str());
+        area = calloc(1, mFileSize);
+    }
+
+    LocMemStats::allocated(LOC_MEM_LOG_BUFFER, mFileSize);
+
+    // a new file, or calloc'ed memory, is all zeros
+    mFileHeader = (LogBufferFileHeader*)area;
+    mFileHeader->mSlotSize = sizeof(LogSlot);
+    mFileHeader->mLevels = LOG_RING_LEVELS;
+    memcpy(mFileHeader->mCapacity, capacity, sizeof(capacity));
+    mFileHeader->mRings = LOG_BUFFER_MAX_RINGS;
+    mFileHeader->mRingSize = ringSize;
+    mFileHeader->mPid = getpid();
+    memcpy(mFileHeader->mProcess, process, sizeof(mFileHeader->mProcess));
+    mFileHeader->mVersion = LOG_BUFFER_FILE_VERSION;
+    // a valid magic marks the header complete for the decoder
+    atomic_thread_fence(memory_order_release);
+    mFileHeader->mMagic = LOG_BUFFER_FILE_MAGIC;
+}
+
+static inline uint64_t getBootNs() {
+    timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Each thread gets a ring of its own on its first append. Rings are never
+// freed, on thread exit the ring is released for reuse by a new thread.
+LogRing* LogBuffer::getThreadRing() {
+    struct RingOwner {
+        LogRing* mRing = nullptr;
+        ~RingOwner() {
+            if (nullptr != mRing) {
+                mRing->mHeader->mInUse.store(0, memory_order_release);
+            }
+        }
+    };
+    static thread_local RingOwner owner;
+
+    if (nullptr == owner.mRing) {
+        lock_guard<mutex> guard(mLock);
+        for (auto& ring : mRings) {
+            if (!ring->mHeader->mInUse.load(memory_order_acquire)) {
+                ring->mHeader->mInUse.store(1, memory_order_relaxed);
+                ring->mHeader->mTid = gettid();
+                owner.mRing = ring.get();
+                break;
+            }
+        }
+        if (nullptr == owner.mRing) {
+            LogRing* ring = new LogRing();
+            size_t ringSize = mFileHeader->mRingSize;
+            void* base = nullptr;
+            if (mRings.size() < mFileHeader->mRings) {
+                base = (char*)mFileHeader + LOG_BUFFER_RINGS_OFFSET + mRings.size() * ringSize;
+            } else {
+                ring->mHeapMem.reset(new char[ringSize]());
+                base = ring->mHeapMem.get();
+                LocMemStats::allocated(LOC_MEM_LOG_BUFFER, ringSize, 0);
+            }
+            LocMemStats::allocated(LOC_MEM_LOG_BUFFER, sizeof(LogRing));
+            ring->mHeader = (LogRingHeader*)base;
+            for (int i = 0; i < LOG_RING_LEVELS; i++) {
+                ring->mCapacity[i] = mFileHeader->mCapacity[i];
+                ring->mSlots[i] = logRingSlots(base, mFileHeader->mCapacity, i);
+            }
+            ring->mHeader->mTid = gettid();
+            ring->mHeader->mInUse.store(1, memory_order_relaxed);
+            mRings.emplace_back(ring);
+            owner.mRing = ring;
+        }
+    }
+    return owner.mRing;
+}
+
 void LogBuffer::append(string& data, int level, uint64_t timestamp) {
-    lock_guard<mutex> guard(mLock);
-    pair<uint64_t, string> item(timestamp, data);
-    mLogList.append(item, level);
-    mConfigVec[level].mCurrentSize++;
-
-    while ((timestamp - mLogList.front(level).first) > mConfigVec[level].mTimeDepthThres ||
-            mConfigVec[level].mCurrentSize > mConfigVec[level].mMaxNumThres) {
-        mLogList.pop(level);
-        mConfigVec[level].mCurrentSize--;
+    append(data.c_str(), data.size(), level, timestamp);
+}
+
+// Lock free, only the calling thread ever writes to its ring. Trimming by
+// time depth and capacity is left to dump().
+void LogBuffer::append(const char* data, size_t len, int level, uint64_t timestamp) {
+    if (level < 0 || level >= TOTAL_LOG_LEVELS) {
+        return;
+    }
+    LogRing* ring = getThreadRing();
+    uint32_t capacity = ring->mCapacity[level];
+    if (0 == capacity) {
+        return;
     }
+
+    uint64_t head = ring->mHeader->mHead[level].load(memory_order_relaxed);
+    LogSlot& slot = ring->mSlots[level][head % capacity];
+    uint32_t seq = slot.mSeq.load(memory_order_relaxed);
+    slot.mSeq.store(seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot.mTimestamp = timestamp;
+    slot.mBootNs = getBootNs();
+    slot.mLen = (len < LOG_BUFFER_SLOT_SIZE) ? len : LOG_BUFFER_SLOT_SIZE;
+    memcpy(slot.mText, data, slot.mLen);
+
+    slot.mSeq.store(seq + 2, memory_order_release);
+    ring->mHeader->mHead[level].store(head + 1, memory_order_release);
 }
 
 //Dump the log buffer of specific level, level = -1 to dump all the levels in log buffer.
 void LogBuffer::dump(std::function<void(stringstream&)> log, int level) {
+    struct LogEntry {
+        uint64_t mBootNs;
+        uint64_t mTimestamp;
+        int mLevel;
+        string mText;
+    };
+    vector<LogEntry> entries;
+    uint64_t flushNs = mFileHeader->mFlushNs.load(memory_order_relaxed);
     lock_guard<mutex> guard(mLock);
-    list<pair<pair<uint64_t, string>, int>> li;
-    if (-1 == level) {
-        li = mLogList.dump();
-    } else {
-        li = mLogList.dump(level);
+
+    for (int lvl = 0; lvl < TOTAL_LOG_LEVELS; lvl++) {
+        if (-1 != level && lvl != level) {
+            continue;
+        }
+        // collect the level from all the rings
+        vector<LogEntry> levelEntries;
+        uint64_t newest = 0;
+        LogSlot copy;
+        for (auto& ring : mRings) {
+            uint32_t capacity = ring->mCapacity[lvl];
+            uint64_t head = ring->mHeader->mHead[lvl].load(memory_order_acquire);
+            uint64_t count = (head < capacity) ? head : capacity;
+            for (uint64_t i = head - count; i < head; i++) {
+                // skip the slot if its writer was there while we copy
+                if (logSlotRead(ring->mSlots[lvl][i % capacity], copy) &&
+                        copy.mBootNs >= flushNs) {
+                    if (copy.mTimestamp > newest) {
+                        newest = copy.mTimestamp;
+                    }
+                    levelEntries.push_back({copy.mBootNs, copy.mTimestamp, lvl,
+                                            string(copy.mText, copy.mLen)});
+                }
+            }
+        }
+
+        // trim by time depth and capacity, like it used to be done on append
+        sort(levelEntries.begin(), levelEntries.end(),
+             [](const LogEntry& a, const LogEntry& b) { return a.mBootNs < b.mBootNs; });
+        size_t first = 0;
+        if (levelEntries.size() > mConfigVec[lvl].mMaxNumThres) {
+            first = levelEntries.size() - mConfigVec[lvl].mMaxNumThres;
+        }
+        for (size_t i = first; i < levelEntries.size(); i++) {
+            if ((newest - levelEntries[i].mTimestamp) <= mConfigVec[lvl].mTimeDepthThres) {
+                entries.push_back(std::move(levelEntries[i]));
+            }
+        }
     }
-    ALOGE("Begining of dump, buffer size: %d", (int)li.size());
+    // merge the levels into time order
+    sort(entries.begin(), entries.end(),
+         [](const LogEntry& a, const LogEntry& b) { return a.mBootNs < b.mBootNs; });
+
+    ALOGE("Begining of dump, buffer size: %d", (int)entries.size());
     stringstream ln;
-    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << li.size() << endl;
+    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << entries.size() << endl;
     log(ln);
-    for_each (li.begin(), li.end(), [&, this](const pair<pair<uint64_t, string>, int> &item){
+    for (auto& entry : entries) {
         stringstream line;
-        line << "["<<item.first.first << "] ";
-        line << "Level " << mLevelMap[item.second] << ": ";
-        line << item.first.second << endl;
+        line << "["<< entry.mTimestamp << "] ";
+        line << "Level " << mLevelMap[entry.mLevel] << ": ";
+        line << entry.mText << endl;
         if (log != nullptr) {
             log(line);
         }
-    });
+    }
     ALOGE("End of dump");
 }
 
@@ -130,7 +311,7 @@ void LogBuffer::dumpToLogFile(string filePath) {
 }
 
 void LogBuffer::flush() {
-    mLogList.flush();
+    mFileHeader->mFlushNs.store(getBootNs(), memory_order_relaxed);
 }
 
 void LogBuffer::registerSignalHandler() {
@@ -167,6 +348,12 @@ void LogBuffer::signalHandler(const int code, siginfo_t *const si, void *const s
         }
     }
 #endif
+    //Nothing to do on a crash if the logs are already in the log buffer file
+    if (mInstance->mFileBacked && code != SIGUSR1) {
+        mOriSigAction[code].sa_sigaction(code, si, sc);
+        return;
+    }
+
     //Dump the log buffer to adb logcat
     mInstance->dumpToAdbLogcat();
 
@@ -30,11 +30,14 @@
 #ifndef LOG_BUFFER_H
 #define LOG_BUFFER_H
 
-#include "SkipList.h"
 #include "log_util.h"
+#include "LogRing.h"
 #include <loc_cfg.h>
 #include <loc_pla.h>
 #include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
 #include <sstream>
 #include <ostream>
 #include <fstream>
@@ -51,16 +54,27 @@
 //file path of dumped log buffer
 #define LOG_BUFFER_FILE_PATH "/data/vendor/location/"
 
+using namespace std;
+
 namespace loc_util {
 
 class ConfigsInLevel{
 public:
     uint32_t mTimeDepthThres;
     uint32_t mMaxNumThres;
-    int mCurrentSize;
 
-    ConfigsInLevel(uint32_t time, int num, int size):
-        mTimeDepthThres(time), mMaxNumThres(num), mCurrentSize(size) {}
+    ConfigsInLevel(uint32_t time, int num):
+        mTimeDepthThres(time), mMaxNumThres(num) {}
+};
+
+// A ring of the calling thread, see LogRingHeader. Its memory is in the
+// log buffer file mapping; or on heap, if it is beyond LOG_BUFFER_MAX_RINGS
+// or the file could not be mapped.
+struct LogRing {
+    LogRingHeader* mHeader;
+    LogSlot* mSlots[LOG_RING_LEVELS];
+    uint32_t mCapacity[LOG_RING_LEVELS];
+    unique_ptr<char[]> mHeapMem;
 };
 
 class LogBuffer {
@@ -70,21 +84,31 @@ private:
     static struct sigaction mNewSigAction;
     static mutex sLock;
 
-    SkipList<pair<uint64_t, string>> mLogList;
     vector<ConfigsInLevel> mConfigVec;
+    // guards mRings, only taken when a thread gets its ring, and by dump()
     mutex mLock;
+    vector<unique_ptr<LogRing>> mRings;
+    // the log buffer file header, followed by LOG_BUFFER_MAX_RINGS rings
+    LogBufferFileHeader* mFileHeader;
+    size_t mFileSize;
+    // true if mFileHeader is mmap'd from the log buffer file
+    bool mFileBacked;
 
     const vector<string> mLevelMap {"E", "W", "I", "D", "V"};
 
+    LogRing* getThreadRing();
+
 public:
     static LogBuffer* getInstance();
     void append(string& data, int level, uint64_t timestamp);
+    void append(const char* data, size_t len, int level, uint64_t timestamp);
     void dump(std::function<void(stringstream&)> log, int level = -1);
     void dumpToAdbLogcat();
     void dumpToLogFile(string filePath);
     void flush();
 private:
     LogBuffer();
+    void mapLogFile();
     void registerSignalHandler();
     static void signalHandler(const int code, siginfo_t *const si, void *const sc);
 
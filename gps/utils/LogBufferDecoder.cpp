@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// loc_logbuffer_decoder - turns a LogBuffer file, e.g. one pulled from
+// /data/vendor/location/logbuffer_<process>.bin[.prev] after a crash, back
+// into text, in the time order the logs were appended.
+//
+// usage: loc_logbuffer_decoder <logbuffer file> [level]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "LogRing.h"
+
+using namespace loc_util;
+
+static const char* const sLevelMap[LOG_RING_LEVELS] = {"E", "W", "I", "D", "V"};
+
+struct LogEntry {
+    uint64_t mBootNs;
+    uint64_t mTimestamp;
+    int mLevel;
+    uint32_t mTid;
+    std::string mText;
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <logbuffer file> [level]\n", argv[0]);
+        return 1;
+    }
+    int level = (argc > 2) ? atoi(argv[2]) : -1;
+
+    int fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || 0 != fstat(fd, &st)) {
+        fprintf(stderr, "can't open %s, %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    void* area = ((size_t)st.st_size >= sizeof(LogBufferFileHeader)) ?
+            mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (MAP_FAILED == area) {
+        fprintf(stderr, "can't map %s\n", argv[1]);
+        return 1;
+    }
+
+    LogBufferFileHeader* header = (LogBufferFileHeader*)area;
+    if (LOG_BUFFER_FILE_MAGIC != header->mMagic ||
+            LOG_BUFFER_FILE_VERSION != header->mVersion ||
+            sizeof(LogSlot) != header->mSlotSize ||
+            LOG_RING_LEVELS != header->mLevels ||
+            logRingSize(header->mCapacity) != header->mRingSize ||
+            LOG_BUFFER_RINGS_OFFSET + (uint64_t)header->mRings * header->mRingSize >
+            (uint64_t)st.st_size) {
+        fprintf(stderr, "%s is not a valid log buffer file\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t flushNs = header->mFlushNs.load(std::memory_order_relaxed);
+    std::vector<LogEntry> entries;
+    LogSlot copy;
+    for (uint32_t r = 0; r < header->mRings; r++) {
+        void* base = (char*)area + LOG_BUFFER_RINGS_OFFSET + (size_t)r * header->mRingSize;
+        LogRingHeader* ring = (LogRingHeader*)base;
+        for (int lvl = 0; lvl < LOG_RING_LEVELS; lvl++) {
+            uint32_t capacity = header->mCapacity[lvl];
+            if ((-1 != level && lvl != level) || 0 == capacity) {
+                continue;
+            }
+            LogSlot* slots = logRingSlots(base, header->mCapacity, lvl);
+            uint64_t head = ring->mHead[lvl].load(std::memory_order_relaxed);
+            uint64_t count = (head < capacity) ? head : capacity;
+            for (uint64_t i = head - count; i < head; i++) {
+                // a slot torn by the crash is dropped
+                if (logSlotRead(slots[i % capacity], copy) && copy.mBootNs >= flushNs) {
+                    entries.push_back({copy.mBootNs, copy.mTimestamp, lvl, ring->mTid,
+                                       std::string(copy.mText, copy.mLen)});
+                }
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const LogEntry& a, const LogEntry& b) {
+        return a.mBootNs < b.mBootNs;
+    });
+
+    printf("log buffer of %.*s (pid %u), level[%d], buffer size: %zu\n",
+           (int)sizeof(header->mProcess), header->mProcess, header->mPid, level,
+           entries.size());
+    for (auto& entry : entries) {
+        // lines usually end with a newline already
+        bool newline = entry.mText.empty() || '\n' != entry.mText.back();
+        printf("[%llu] Level %s: tid %u %s%s", (unsigned long long)entry.mTimestamp,
+               sLevelMap[entry.mLevel], entry.mTid, entry.mText.c_str(), newline ? "\n" : "");
+    }
+    munmap(area, st.st_size);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// On-disk / in-memory layout of the LogBuffer rings. LogBuffer keeps them in
+// an mmap'd file, so the logs outlive a crash of the process, and the file
+// can be turned back into text with loc_logbuffer_decoder. Everything here
+// must stay position independent and of fixed layout.
+
+//number of log levels, must match TOTAL_LOG_LEVELS
+#define LOG_RING_LEVELS 5
+//size of the text of a log slot, longer lines are truncated
+#define LOG_BUFFER_SLOT_SIZE 256
+//number of rings in the log buffer file, threads beyond get heap rings
+#define LOG_BUFFER_MAX_RINGS 32
+//magic and version of the log buffer file
+#define LOG_BUFFER_FILE_MAGIC 0x4655424C
+#define LOG_BUFFER_FILE_VERSION 1
+//rings start at this offset of the file
+#define LOG_BUFFER_RINGS_OFFSET 4096
+
+namespace loc_util {
+
+// A log line in a ring. mSeq is odd while the owner thread is writing the
+// slot, so that readers can tell a torn slot without locking the writer out.
+struct LogSlot {
+    std::atomic<uint32_t> mSeq;
+    uint32_t mLen;
+    uint64_t mTimestamp;
+    uint64_t mBootNs;
+    char mText[LOG_BUFFER_SLOT_SIZE];
+};
+
+// Head of a ring, followed by mCapacity[level] LogSlots of each level in
+// order. A ring is written by a single thread only. It is handed to another
+// thread after its owner exits, its logs are kept until overwritten.
+struct alignas(64) LogRingHeader {
+    std::atomic<uint32_t> mInUse;
+    uint32_t mTid;
+    // number of slots ever written of each level
+    std::atomic<uint64_t> mHead[LOG_RING_LEVELS];
+};
+
+// Head of the log buffer file, the rings follow at LOG_BUFFER_RINGS_OFFSET,
+// mRingSize bytes each.
+struct LogBufferFileHeader {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mSlotSize;
+    uint32_t mLevels;
+    uint32_t mCapacity[LOG_RING_LEVELS];
+    uint32_t mRings;
+    uint32_t mRingSize;
+    uint32_t mPid;
+    // logs written before this are flushed
+    std::atomic<uint64_t> mFlushNs;
+    char mProcess[32];
+};
+
+static_assert(sizeof(LogBufferFileHeader) <= LOG_BUFFER_RINGS_OFFSET,
+              "log buffer file header too large");
+
+inline size_t logRingSize(const uint32_t capacity[LOG_RING_LEVELS]) {
+    size_t size = sizeof(LogRingHeader);
+    for (int i = 0; i < LOG_RING_LEVELS; i++) {
+        size += capacity[i] * sizeof(LogSlot);
+    }
+    // keep the following ring header aligned
+    return (size + alignof(LogRingHeader) - 1) & ~(alignof(LogRingHeader) - 1);
+}
+
+// Slots of a level of the ring at ringBase
+inline LogSlot* logRingSlots(void* ringBase, const uint32_t capacity[LOG_RING_LEVELS],
+                             int level) {
+    size_t offset = sizeof(LogRingHeader);
+    for (int i = 0; i < level; i++) {
+        offset += capacity[i] * sizeof(LogSlot);
+    }
+    return (LogSlot*)((char*)ringBase + offset);
+}
+
+// Copies the slot out if it is not being written to. Returns false for a
+// torn or never written slot.
+inline bool logSlotRead(LogSlot& slot, LogSlot& copy) {
+    uint32_t seq = slot.mSeq.load(std::memory_order_acquire);
+    copy.mLen = slot.mLen;
+    copy.mTimestamp = slot.mTimestamp;
+    copy.mBootNs = slot.mBootNs;
+    if (copy.mLen > LOG_BUFFER_SLOT_SIZE) {
+        copy.mLen = LOG_BUFFER_SLOT_SIZE;
+    }
+    for (uint32_t i = 0; i < copy.mLen; i++) {
+        copy.mText[i] = slot.mText[i];
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (0 != seq) && (0 == (seq & 1)) &&
+            seq == slot.mSeq.load(std::memory_order_relaxed);
+}
+
+} // namespace loc_util
+
+#endif // LOG_RING_H
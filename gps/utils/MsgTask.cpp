@@ -30,19 +30,132 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
 #include <MsgTask.h>
+#include <LocMemStats.h>
 #include <msg_q.h>
+#include <linked_list.h>
 #include <log_util.h>
 #include <loc_log.h>
+#include <loc_cfg.h>
+#include <loc_misc_utils.h>
 #include <loc_pla.h>
 
 namespace loc_util {
 
-class MTRunnable : public LocRunnable {
+// number of slab blocks backing each MsgTask's MsgPool
+#define MSG_TASK_POOL_BLOCKS 64
+// max number of messages MTRunnable takes off the queue per wakeup
+#define MSG_TASK_DRAIN_BATCH 32
+// msg_q lanes of a MsgTask, see LocMsgPriority
+#define LOC_MSG_LANE_HIGH 0
+#define LOC_MSG_LANE_HOUSEKEEPING 1
+#define LOC_MSG_LANE_COUNT 2
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// realtime and control msgs stay in one FIFO lane, so that no report
+// overtakes a command queued before it
+static inline unsigned int laneOf(LocMsgPriority priority) {
+    return (LOC_MSG_PRIORITY_HOUSEKEEPING == priority) ?
+            LOC_MSG_LANE_HOUSEKEEPING : LOC_MSG_LANE_HIGH;
+}
+
+// the state of every MsgTask alive in the process, for dumpAllStats()
+static std::mutex sMsgTasksLock;
+static std::list<const MsgTaskState*> sMsgTasks;
+
+// What sendMsg() queues for a msg: the msg, with the CLOCK_MONOTONIC time
+// and the priority class it was sent with. Those are kept here rather than
+// in LocMsg, whose layout msgs built into prebuilt libraries share.
+// Envelopes come from the MsgPool of the MsgTask.
+struct MsgEnvelope {
+    const LocMsg* mMsg;
+    uint64_t mSendTimeNs;
+    LocMsgPriority mPriority;
+};
+
+// handles msgs just taken off q, recording their timing in stats
+static void procMsgs(const void* q, MsgTaskStats& stats, MsgEnvelope** envelopes,
+                     unsigned int count) {
+    msg_q_stats qStats;
+    msg_q_get_stats((void*)q, &qStats);
+    stats.mQueueDepth.record(qStats.sent - qStats.received + count);
+
+    uint64_t now = monotonicNs();
+    for (unsigned int i = 0; i < count; i++) {
+        MsgEnvelope* envelope = envelopes[i];
+        LocMsg* msg = (LocMsg*)envelope->mMsg;
+        if (now > envelope->mSendTimeNs) {
+            uint64_t waitUs = (now - envelope->mSendTimeNs) / 1000;
+            stats.mQueueWaitUs.record(waitUs);
+            if (LOC_MSG_PRIORITY_REALTIME == envelope->mPriority) {
+                stats.mRealtimeWaitUs.record(waitUs);
+            }
+        }
+        MsgPool::release(envelope);
+
+        msg->log();
+        // there is where each individual msg handling is invoked
+        msg->proc();
+
+        delete msg;
+
+        uint64_t done = monotonicNs();
+        stats.mProcUs.record((done - now) / 1000);
+        now = done;
+    }
+}
+
+static void logQueueStats(const void* q) {
+    msg_q_stats stats = {};
+    msg_q_get_stats((void*)q, &stats);
+    LOC_LOGd("sent %" PRIu64 " contended %" PRIu64 " allocations %" PRIu64
+             " node reused %" PRIu64 " nodes peak %u"
+             " overflowed %" PRIu64 " wakeups %" PRIu64 " starvation picks %" PRIu64,
+             stats.sent, stats.contended, stats.allocations,
+             stats.node_reused, stats.nodes_peak,
+             stats.overflowed, stats.wakeups, stats.starvation_picks);
+    LOC_LOGd("batch sizes 1: %" PRIu64 " 2-3: %" PRIu64 " 4-7: %" PRIu64
+             " 8-15: %" PRIu64 " 16-31: %" PRIu64 " 32+: %" PRIu64,
+             stats.batch_hist[0], stats.batch_hist[1], stats.batch_hist[2],
+             stats.batch_hist[3], stats.batch_hist[4], stats.batch_hist[5]);
+}
+
+class MsgStrand;
+
+// Everything of a MsgTask but its thread. The MTRunnable or MsgStrand
+// running the msgs keeps it, so that what libraries built against the
+// original MsgTask destroy inline, the thread only, is enough to free it.
+class MsgTaskState {
+public:
     const void* mQ;
+    MsgPool mPool;
+    MsgTaskStats mStats;
+    // set instead of a thread running, when the MsgTask is on the pool
+    shared_ptr<MsgStrand> mStrand;
+    char mName[16];
+
+    MsgTaskState(const char* name, msg_q_type qType);
+    ~MsgTaskState();
+    void dumpStats(std::string& out) const;
+};
+
+class MTRunnable : public LocRunnable {
+    shared_ptr<MsgTaskState> mState;
 public:
-    inline MTRunnable(const void* q) : mQ(q) {}
-    virtual ~MTRunnable();
+    inline MTRunnable(const shared_ptr<MsgTaskState>& state) : mState(state) {}
+    virtual ~MTRunnable() = default;
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
     // until thread is stopped.
@@ -57,36 +170,378 @@ public:
 };
 
 static void LocMsgDestroy(void* msg) {
-    delete (LocMsg*)msg;
+    MsgEnvelope* envelope = (MsgEnvelope*)msg;
+    delete envelope->mMsg;
+    MsgPool::release(envelope);
+}
+
+// high-water mark of the list node pool of each msg_q lane, from gps.conf
+static unsigned int getNodePoolMax() {
+    static unsigned int sNodePoolMax = []() {
+        uint32_t poolMax = LINKED_LIST_POOL_DEFAULT_MAX;
+        loc_param_s_type nodePoolConfTable[] =
+        {
+            {"MSG_Q_NODE_POOL_MAX", &poolMax, NULL, 'n'},
+        };
+        loc_read_conf(LOC_PATH_GPS_CONF_STR, nodePoolConfTable,
+                sizeof(nodePoolConfTable)/sizeof(nodePoolConfTable[0]));
+        return (unsigned int)poolMax;
+    }();
+    return sNodePoolMax;
+}
+
+/***************************MsgStrand / MsgPoolExecutor***************************/
+
+// Runs the msgs of a MsgTask on the shared MsgPoolExecutor threads. A strand
+// is on the run queue at most once and run by one worker at a time, so the
+// msgs of a MsgTask are still handled one by one in queue order.
+class MsgStrand : public std::enable_shared_from_this<MsgStrand> {
+    // mState->mStrand refers back to the strand until ~MsgTask
+    shared_ptr<MsgTaskState> mState;
+    // msgs sent and not yet taken off the queue. Senders count after
+    // queueing, so it may dip below 0 when the strand takes a msg not
+    // counted yet.
+    std::atomic<int64_t> mPending;
+public:
+    inline MsgStrand(const shared_ptr<MsgTaskState>& state) :
+        mState(state), mPending(0) {}
+    // after a msg is queued on the queue of mState
+    void kick();
+    // the MsgTask is going away, msgs not taken yet are dropped like
+    // MTRunnable drops them when its thread is interrupted
+    inline void close() { msg_q_unblock((void*)mState->mQ); }
+    // on a worker, returns true if msgs are left and it must be queued again
+    bool runOnce();
+};
+
+class MsgPoolExecutor {
+    struct Worker : public LocRunnable {
+        MsgPoolExecutor& mExecutor;
+        inline Worker(MsgPoolExecutor& executor) : mExecutor(executor) {}
+        inline virtual void prerun() override {
+            set_sched_policy(gettid(), SP_FOREGROUND);
+        }
+        inline virtual bool run() override { return mExecutor.runNext(); }
+        inline virtual void interrupt() override {}
+    };
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::deque<shared_ptr<MsgStrand>> mRunQueue;
+    std::vector<std::unique_ptr<LocThread>> mThreads;
+    uint32_t mThreadCount;
+    char mNames[LOC_MAX_PARAM_STRING];
+
+    MsgPoolExecutor() : mThreadCount(0) {
+        mNames[0] = '\0';
+        loc_param_s_type poolConfTable[] =
+        {
+            {"MSG_TASK_POOL_THREADS", &mThreadCount, NULL, 'n'},
+            {"MSG_TASK_POOL_NAMES",   &mNames,       NULL, 's'},
+        };
+        loc_read_conf(LOC_PATH_GPS_CONF_STR, poolConfTable,
+                sizeof(poolConfTable)/sizeof(poolConfTable[0]));
+    }
+
+    bool runNext() {
+        shared_ptr<MsgStrand> strand;
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mCond.wait(lock, [this] { return !mRunQueue.empty(); });
+            strand = mRunQueue.front();
+            mRunQueue.pop_front();
+        }
+        // back of the queue when it has more, the other strands get their turn
+        if (strand->runOnce()) {
+            schedule(strand);
+        }
+        return true;
+    }
+
+public:
+    static MsgPoolExecutor& getInstance() {
+        // never destroyed, MsgTasks may go away during process exit
+        static MsgPoolExecutor* sInstance = new MsgPoolExecutor();
+        return *sInstance;
+    }
+
+    // true if the MsgTask named so is to run on the pool
+    inline bool isPooled(const char* name) const {
+        return mThreadCount > 0 && nullptr != name && loc_util_name_in_list(mNames, name);
+    }
+
+    void schedule(const shared_ptr<MsgStrand>& strand) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRunQueue.push_back(strand);
+        // workers start with the first strand, not all pooled MsgTasks may be in use
+        while (mThreads.size() < mThreadCount && mThreads.size() < mRunQueue.size()) {
+            char name[16];
+            snprintf(name, sizeof(name), "LocMsgPool%zu", mThreads.size());
+            std::unique_ptr<LocThread> thread(new LocThread());
+            if (!thread->start(name, std::make_shared<Worker>(*this))) {
+                break;
+            }
+            mThreads.push_back(std::move(thread));
+        }
+        mCond.notify_one();
+    }
+};
+
+void MsgStrand::kick() {
+    if (0 == mPending.fetch_add(1, std::memory_order_acq_rel)) {
+        MsgPoolExecutor::getInstance().schedule(shared_from_this());
+    }
 }
 
+bool MsgStrand::runOnce() {
+    // mPending > 0 when scheduled, so this finds at least one msg and won't block
+    MsgEnvelope* envelopes[MSG_TASK_DRAIN_BATCH];
+    unsigned int count = 0;
+    msq_q_err_type result = msg_q_rcv_batch((void*)mState->mQ, (void **)envelopes,
+                                            MSG_TASK_DRAIN_BATCH, &count);
+    if (eMSG_Q_SUCCESS != result) {
+        LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
+                 loc_get_msg_q_status(result));
+        return false;
+    }
+
+    procMsgs(mState->mQ, mState->mStats, envelopes, count);
+    return mPending.fetch_sub(count, std::memory_order_acq_rel) > (int64_t)count;
+}
+
+MsgPool::MsgPool(uint32_t blockCount) :
+    mSlab((unsigned char*)malloc((size_t)blockCount * kBlockSize)),
+    mBlockCount(nullptr != mSlab ? blockCount : 0),
+    mHead(0), mHits(0), mMisses(0) {
+    LocMemStats::allocated(LOC_MEM_MSG_TASK, (size_t)mBlockCount * kBlockSize, 0);
+    for (uint32_t i = 0; i < mBlockCount; i++) {
+        BlockHeader* header = new (block(i)) BlockHeader();
+        header->mPool = this;
+        header->mIndex = i;
+        push(header);
+    }
+}
+
+MsgPool::~MsgPool() {
+    LocMemStats::released(LOC_MEM_MSG_TASK, (size_t)mBlockCount * kBlockSize, 0);
+    free(mSlab);
+}
+
+void MsgPool::push(BlockHeader* header) {
+    uint64_t head = mHead.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        header->mNext.store((uint32_t)head, std::memory_order_relaxed);
+        next = ((head >> 32) + 1) << 32 | (header->mIndex + 1);
+    } while (!mHead.compare_exchange_weak(head, next,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+}
+
+void* MsgPool::allocate(size_t size) {
+    if (size <= kPayloadSize) {
+        uint64_t head = mHead.load(std::memory_order_acquire);
+        while ((uint32_t)head != 0) {
+            BlockHeader* header = block((uint32_t)head - 1);
+            uint64_t next = ((head >> 32) + 1) << 32 |
+                    header->mNext.load(std::memory_order_relaxed);
+            if (mHead.compare_exchange_weak(head, next,
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                mHits.fetch_add(1, std::memory_order_relaxed);
+                return (unsigned char*)header + kHeaderSize;
+            }
+        }
+    }
+
+    mMisses.fetch_add(1, std::memory_order_relaxed);
+    BlockHeader* header = (BlockHeader*)::operator new(kHeaderSize + size);
+    new (header) BlockHeader();
+    header->mPool = nullptr;
+    header->mIndex = (uint32_t)size;
+    LocMemStats::allocated(LOC_MEM_MSG_TASK, kHeaderSize + size);
+    return (unsigned char*)header + kHeaderSize;
+}
+
+void MsgPool::release(void* payload) {
+    if (nullptr != payload) {
+        BlockHeader* header = (BlockHeader*)((unsigned char*)payload - kHeaderSize);
+        if (nullptr != header->mPool) {
+            header->mPool->push(header);
+        } else {
+            LocMemStats::released(LOC_MEM_MSG_TASK, kHeaderSize + header->mIndex);
+            ::operator delete(header);
+        }
+    }
+}
+
+MsgTaskState::MsgTaskState(const char* name, msg_q_type qType) :
+    mQ(msg_q_init3(qType, 0, LOC_MSG_LANE_COUNT)),
+    mPool(MSG_TASK_POOL_BLOCKS) {
+    strlcpy(mName, (NULL != name) ? name : "LocThread", sizeof(mName));
+    msg_q_set_node_pool_max((void*)mQ, getNodePoolMax());
+
+    std::lock_guard<std::mutex> lock(sMsgTasksLock);
+    sMsgTasks.push_back(this);
+}
+
+MsgTaskState::~MsgTaskState() {
+    {
+        std::lock_guard<std::mutex> lock(sMsgTasksLock);
+        sMsgTasks.remove(this);
+    }
+    logQueueStats(mQ);
+    // before mPool goes, pooled msgs still queued go back to it
+    msg_q_flush((void*)mQ);
+    msg_q_destroy((void**)&mQ);
+}
+
+MsgTask::MsgTask(const char* threadName, msg_q_type qType) :
+    mState(nullptr), mThread() {
+    shared_ptr<MsgTaskState> state = std::make_shared<MsgTaskState>(threadName, qType);
+    mState = state.get();
+    if (MsgPoolExecutor::getInstance().isPooled(state->mName)) {
+        state->mStrand = std::make_shared<MsgStrand>(state);
+    } else {
+        mThread.start(threadName, std::make_shared<MTRunnable>(state));
+    }
+}
+
+// a function of its own, prebuilt libraries link against it
 MsgTask::MsgTask(const char* threadName) :
-    mQ(msg_q_init2()), mThread() {
-    mThread.start(threadName, std::make_shared<MTRunnable>(mQ));
+    MsgTask(threadName, eMSG_Q_TYPE_LIST) {}
+
+// On a thread, stopping mThread lets the MTRunnable free mState as the
+// thread exits.
+MsgTask::~MsgTask() {
+    if (nullptr != mState->mStrand) {
+        // the strand frees mState once no worker is running it any more
+        shared_ptr<MsgStrand> strand = std::move(mState->mStrand);
+        strand->close();
+    }
+}
+
+void MsgTaskState::dumpStats(std::string& out) const {
+    msg_q_stats qStats = {};
+    uint64_t hits = mPool.getHits(), misses = mPool.getMisses();
+    char buf[256];
+
+    msg_q_get_stats((void*)mQ, &qStats);
+
+    snprintf(buf, sizeof(buf),
+             "%s: sent=%" PRIu64 " pending=%" PRIu64 " contended=%" PRIu64
+             " conflated=%" PRIu64 " q_allocs=%" PRIu64 " q_node_reused=%" PRIu64 " q_nodes_peak=%u"
+             " pool_hits=%" PRIu64 " pool_misses=%" PRIu64 "\n",
+             mName, qStats.sent, qStats.sent - qStats.received, qStats.contended,
+             mStats.mConflated.load(std::memory_order_relaxed), qStats.allocations, qStats.node_reused, qStats.nodes_peak, hits, misses);
+    out += buf;
+    out += "  queue wait: ";
+    mStats.mQueueWaitUs.dump(out, "us");
+    out += "\n  realtime queue wait: ";
+    mStats.mRealtimeWaitUs.dump(out, "us");
+    out += "\n  proc: ";
+    mStats.mProcUs.dump(out, "us");
+    out += "\n  queue depth: ";
+    mStats.mQueueDepth.dump(out, nullptr);
+    out += "\n";
+}
+
+void MsgTask::dumpStats(std::string& out) const {
+    mState->dumpStats(out);
+}
+
+void MsgTask::dumpAllStats(std::string& out) {
+    std::lock_guard<std::mutex> lock(sMsgTasksLock);
+    for (auto state : sMsgTasks) {
+        state->dumpStats(out);
+    }
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
+    sendMsg(msg, LOC_MSG_PRIORITY_CONTROL);
+}
+
+void MsgTask::sendMsg(const LocMsg* msg, LocMsgPriority priority) const {
     if (msg && this) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        MsgEnvelope* envelope = new (mState->mPool.allocate(sizeof(MsgEnvelope)))
+                MsgEnvelope{msg, monotonicNs(), priority};
+        msg_q_snd2((void*)mState->mQ, (void*)envelope, LocMsgDestroy, laneOf(priority));
+        if (nullptr != mState->mStrand) {
+            mState->mStrand->kick();
+        }
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
                  __func__, msg, this);
     }
 }
 
+void LocMsgSlot::procLatest() {
+    const LocMsg* msg = mLatest.exchange(nullptr, std::memory_order_acq_rel);
+    if (nullptr != msg) {
+        msg->log();
+        msg->proc();
+        delete msg;
+    }
+}
+
+void MsgTask::sendConflatedMsg(LocMsgSlot& slot, const LocMsg* msg,
+                               LocMsgPriority priority) const {
+    if (msg && this) {
+        const LocMsg* older = slot.mLatest.exchange(msg, std::memory_order_acq_rel);
+        if (nullptr != older) {
+            // the msg queued for the slot has not run yet and takes msg instead
+            mState->mStats.mConflated.fetch_add(1, std::memory_order_relaxed);
+            delete older;
+        } else {
+            LocMsgSlot* slotPtr = &slot;
+            sendMsg([slotPtr]() { slotPtr->procLatest(); }, priority);
+        }
+    } else {
+        LOC_LOGE("%s: msg is %p and this is %p",
+                 __func__, msg, this);
+    }
+}
+
+void MsgTask::getQueueStats(msg_q_stats& stats) const {
+    memset(&stats, 0, sizeof(stats));
+    msg_q_get_stats((void*)mState->mQ, &stats);
+}
+
+void MsgTask::getPoolStats(uint64_t& hits, uint64_t& misses) const {
+    hits = mState->mPool.getHits();
+    misses = mState->mPool.getMisses();
+}
+
+MsgPool& MsgTask::getPool() const {
+    return mState->mPool;
+}
+
+const MsgTaskStats& MsgTask::getStats() const {
+    return mState->mStats;
+}
+
+const char* MsgTask::getName() const {
+    return mState->mName;
+}
+
 void MsgTask::sendMsg(const std::function<void()> runnable) const {
-    struct RunMsg : public LocMsg {
+    sendMsg(runnable, LOC_MSG_PRIORITY_CONTROL);
+}
+
+void MsgTask::sendMsg(const std::function<void()> runnable,
+                      LocMsgPriority priority) const {
+    struct RunMsg : public LocMsg, public LocMemTracked<LOC_MEM_MSG_TASK> {
         const std::function<void()> mRunnable;
     public:
         inline RunMsg(const std::function<void()> runnable) : mRunnable(runnable) {}
         ~RunMsg() = default;
         inline virtual void proc() const override { mRunnable(); }
     };
-    sendMsg(new RunMsg(runnable));
+    sendMsg(new RunMsg(runnable), priority);
 }
 
 void MTRunnable::interrupt() {
-    msg_q_unblock((void*)mQ);
+    msg_q_unblock((void*)mState->mQ);
 }
 
 void MTRunnable::prerun() {
@@ -95,26 +550,19 @@ void MTRunnable::prerun() {
 }
 
 bool MTRunnable::run() {
-    LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
+    // drain whatever is pending in one go, then handle it off the queue lock
+    MsgEnvelope* envelopes[MSG_TASK_DRAIN_BATCH];
+    unsigned int count = 0;
+    msq_q_err_type result = msg_q_rcv_batch((void*)mState->mQ, (void **)envelopes,
+                                            MSG_TASK_DRAIN_BATCH, &count);
     if (eMSG_Q_SUCCESS != result) {
         LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
                  loc_get_msg_q_status(result));
         return false;
     }
 
-    msg->log();
-    // there is where each individual msg handling is invoked
-    msg->proc();
-
-    delete msg;
-
+    procMsgs(mState->mQ, mState->mStats, envelopes, count);
     return true;
 }
 
-MTRunnable::~MTRunnable() {
-    msg_q_flush((void*)mQ);
-    msg_q_destroy((void**)&mQ);
-}
-
 } // namespace loc_util
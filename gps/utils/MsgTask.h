@@ -30,10 +30,35 @@
 #define __MSG_TASK__
 
 #include <functional>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <string>
+#include <stdint.h>
 #include <LocThread.h>
+#include <LocHistogram.h>
+#include <msg_q.h>
 
 namespace loc_util {
 
+// Priority classes of msgs posted to a MsgTask. Realtime and control msgs
+// share the high priority queue lane, so a report is never handled ahead of
+// a command queued before it; housekeeping msgs have a lane of their own.
+// The MsgTask thread takes from the high lane while it has msgs pending,
+// with a starvation guard so housekeeping still progresses.
+typedef enum {
+    // position / SV / measurement reports, latency sensitive
+    LOC_MSG_PRIORITY_REALTIME = 0,
+    // commands, config and everything else, the default
+    LOC_MSG_PRIORITY_CONTROL,
+    // stats, energy and other background reports, which nothing after
+    // them depends on
+    LOC_MSG_PRIORITY_HOUSEKEEPING,
+    LOC_MSG_PRIORITY_COUNT
+} LocMsgPriority;
+
 struct LocMsg {
     inline LocMsg() {}
     inline virtual ~LocMsg() {}
@@ -41,14 +66,142 @@ struct LocMsg {
     inline virtual void log() const {}
 };
 
+// Timing of one MsgTask thread, recorded by the thread itself while it
+// handles msgs and readable from any thread for dumps.
+struct MsgTaskStats {
+    // time from sendMsg() until the msg is taken off the queue, in usec
+    LocHistogram mQueueWaitUs;
+    // same, LOC_MSG_PRIORITY_REALTIME msgs only
+    LocHistogram mRealtimeWaitUs;
+    // time spent in LocMsg::proc(), in usec
+    LocHistogram mProcUs;
+    // msgs pending, sampled each time the thread drains the queue
+    LocHistogram mQueueDepth;
+    // msgs of a LocMsgSlot replaced by a newer one before they were handled
+    std::atomic<uint64_t> mConflated;
+    inline MsgTaskStats() : mConflated(0) {}
+};
+
+// Latest value slot for a kind of msg where a newer one supersedes an older
+// one not handled yet, e.g. a status report. Sent through
+// MsgTask::sendConflatedMsg(), only the latest msg of the slot is handled,
+// at the queue position of the oldest one it replaced, so a MsgTask that
+// falls behind has at most one of them pending. The slot must stay alive
+// as long as msgs sent through it may be queued.
+class LocMsgSlot {
+    std::atomic<const LocMsg*> mLatest;
+    friend class MsgTask;
+    // on the MsgTask thread, handles the msg in the slot, if any
+    void procLatest();
+public:
+    inline LocMsgSlot() : mLatest(nullptr) {}
+    inline ~LocMsgSlot() { delete mLatest.exchange(nullptr); }
+    LocMsgSlot(const LocMsgSlot&) = delete;
+    LocMsgSlot& operator=(const LocMsgSlot&) = delete;
+};
+
+// Fixed size block allocator for messages posted through MsgTask.
+// Blocks come from a slab allocated once per MsgTask and are recycled
+// through a lock-free, ABA-safe (tagged index) free list. Any thread may
+// allocate or release. Requests that are too big, or arrive while the slab
+// is exhausted, fall back to the heap and are counted as misses.
+class MsgPool {
+    struct BlockHeader {
+        MsgPool* mPool;           // nullptr for heap fallback blocks
+        std::atomic<uint32_t> mNext;
+        uint32_t mIndex;          // payload size of heap fallback blocks
+    };
+    static const size_t kHeaderSize =
+            (sizeof(BlockHeader) + alignof(std::max_align_t) - 1) &
+            ~(alignof(std::max_align_t) - 1);
+public:
+    // block stride in the slab, header included
+    static const size_t kBlockSize = 192;
+    static const size_t kPayloadSize = kBlockSize - kHeaderSize;
+
+    MsgPool(uint32_t blockCount);
+    ~MsgPool();
+    void* allocate(size_t size);
+    static void release(void* payload);
+    inline uint64_t getHits() const { return mHits.load(std::memory_order_relaxed); }
+    inline uint64_t getMisses() const { return mMisses.load(std::memory_order_relaxed); }
+private:
+    inline BlockHeader* block(uint32_t index) const {
+        return (BlockHeader*)(mSlab + (size_t)index * kBlockSize);
+    }
+    void push(BlockHeader* header);
+    unsigned char* mSlab;
+    uint32_t mBlockCount;
+    // high 32 bits: ABA tag, low 32 bits: index + 1 of the top block, 0 if empty
+    std::atomic<uint64_t> mHead;
+    std::atomic<uint64_t> mHits;
+    std::atomic<uint64_t> mMisses;
+};
+
+// Move-only message wrapping a callable inline, allocated from a MsgPool.
+// Deleting it through a LocMsg* hands the memory back to the pool.
+template <typename F>
+struct PooledRunMsg : public LocMsg {
+    mutable F mRunnable;
+    inline PooledRunMsg(F&& runnable) : mRunnable(std::move(runnable)) {}
+    inline PooledRunMsg(const F& runnable) : mRunnable(runnable) {}
+    PooledRunMsg(const PooledRunMsg&) = delete;
+    PooledRunMsg& operator=(const PooledRunMsg&) = delete;
+    inline virtual void proc() const override { mRunnable(); }
+    inline static void* operator new(size_t size, MsgPool& pool) {
+        return pool.allocate(size);
+    }
+    inline static void operator delete(void* p) { MsgPool::release(p); }
+    inline static void operator delete(void* p, MsgPool&) { MsgPool::release(p); }
+};
+
+// queue, pool, stats and strand of a MsgTask, see MsgTask.cpp
+class MsgTaskState;
+
 class MsgTask {
-    const void* mQ;
+    // Prebuilt libraries create and destroy MsgTasks with the layout of the
+    // original class, one pointer and the thread, so everything else a
+    // MsgTask has is kept behind mState.
+    MsgTaskState* mState;
     LocThread mThread;
+    MsgPool& getPool() const;
 public:
-    ~MsgTask() = default;
+    ~MsgTask();
     MsgTask(const char* threadName = NULL);
+    // qType selects the msg_q storage; eMSG_Q_TYPE_RING keeps sendMsg
+    // lock-free and malloc-free on the queue side for hot report paths.
+    MsgTask(const char* threadName, msg_q_type qType);
+    // the overloads without a priority send at LOC_MSG_PRIORITY_CONTROL
     void sendMsg(const LocMsg* msg) const;
+    void sendMsg(const LocMsg* msg, LocMsgPriority priority) const;
     void sendMsg(const std::function<void()> runnable) const;
+    void sendMsg(const std::function<void()> runnable, LocMsgPriority priority) const;
+    // puts msg into slot, replacing the msg there if it has not been handled
+    // yet; queues a msg handling the slot only if it was empty
+    void sendConflatedMsg(LocMsgSlot& slot, const LocMsg* msg,
+                          LocMsgPriority priority = LOC_MSG_PRIORITY_CONTROL) const;
+    // Posts a callable without going through std::function. The callable
+    // is moved into a pooled message, so the common small lambda costs no
+    // heap allocation at all.
+    template <typename F, typename = typename std::enable_if<
+            !std::is_pointer<typename std::decay<F>::type>::value &&
+            !std::is_same<typename std::decay<F>::type, std::nullptr_t>::value &&
+            !std::is_same<typename std::decay<F>::type, std::function<void()>>::value>::type>
+    inline void sendMsg(F&& runnable,
+                        LocMsgPriority priority = LOC_MSG_PRIORITY_CONTROL) const {
+        typedef PooledRunMsg<typename std::decay<F>::type> RunMsg;
+        sendMsg(new (getPool()) RunMsg(std::forward<F>(runnable)), priority);
+    }
+    // cumulative send / contention / allocation counters of the queue
+    void getQueueStats(msg_q_stats& stats) const;
+    // pooled message allocations served from the slab / from the heap
+    void getPoolStats(uint64_t& hits, uint64_t& misses) const;
+    const MsgTaskStats& getStats() const;
+    const char* getName() const;
+    // appends queue, pool and timing stats of this MsgTask to out
+    void dumpStats(std::string& out) const;
+    // appends dumpStats() of every MsgTask alive in this process to out
+    static void dumpAllStats(std::string& out);
 };
 
 } //
@@ -2386,7 +2386,7 @@ typedef void (*AgnssStatusIpV6Cb)(AGnssExtStatusIpV6 status);
 /*
 * Callback with Antenna information.
 */
-typedef void(*antennaInfoCb)(std::vector<GnssAntennaInformation> gnssAntennaInformations);
+typedef void(*antennaInfoCb)(const std::vector<GnssAntennaInformation>& gnssAntennaInformations);
 
 /* Constructs for interaction with loc_net_iface library */
 typedef void (*LocAgpsOpenResultCb)(bool isSuccess, AGpsExtType agpsType, const char* apn,
@@ -43,11 +43,94 @@ typedef struct list_element {
    void (*dealloc_func)(void*);
 }list_element;
 
+/* Counters are written under the lock of the list's user, but read by
+   linked_list_get_stats without it */
+#define LIST_STAT_SET(field, val) __atomic_store_n(&(field), (val), __ATOMIC_RELAXED)
+#define LIST_STAT_GET(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
 typedef struct list_state {
    list_element* p_head;
    list_element* p_tail;
+   list_element* p_free;            /* Node pool, singly linked through next */
+   linked_list_stats stats;
 } list_state;
 
+/*===========================================================================
+
+  FUNCTION:   list_node_get
+
+  Takes a node off the pool; mallocs one if the pool is empty.
+
+  ===========================================================================*/
+static list_element* list_node_get(list_state* p_list)
+{
+   list_element* elem = p_list->p_free;
+
+   if( elem != NULL )
+   {
+      p_list->p_free = elem->next;
+      LIST_STAT_SET(p_list->stats.pooled, p_list->stats.pooled - 1);
+      LIST_STAT_SET(p_list->stats.reused, p_list->stats.reused + 1);
+   }
+   else
+   {
+      elem = (list_element*)malloc(sizeof(list_element));
+      if( elem == NULL )
+      {
+         return NULL;
+      }
+      LIST_STAT_SET(p_list->stats.allocations, p_list->stats.allocations + 1);
+   }
+
+   LIST_STAT_SET(p_list->stats.in_use, p_list->stats.in_use + 1);
+   if( p_list->stats.in_use > p_list->stats.peak_in_use )
+   {
+      LIST_STAT_SET(p_list->stats.peak_in_use, p_list->stats.in_use);
+   }
+   return elem;
+}
+
+/*===========================================================================
+
+  FUNCTION:   list_node_put
+
+  Returns a node to the pool; frees it if the pool is at its high-water mark.
+
+  ===========================================================================*/
+static void list_node_put(list_state* p_list, list_element* elem)
+{
+   LIST_STAT_SET(p_list->stats.in_use, p_list->stats.in_use - 1);
+
+   if( p_list->stats.pooled < p_list->stats.pool_max )
+   {
+      elem->next = p_list->p_free;
+      p_list->p_free = elem;
+      LIST_STAT_SET(p_list->stats.pooled, p_list->stats.pooled + 1);
+   }
+   else
+   {
+      free(elem);
+   }
+}
+
+/*===========================================================================
+
+  FUNCTION:   list_pool_trim
+
+  Frees pooled nodes until at most keep are left.
+
+  ===========================================================================*/
+static void list_pool_trim(list_state* p_list, uint32_t keep)
+{
+   while( p_list->stats.pooled > keep )
+   {
+      list_element* elem = p_list->p_free;
+      p_list->p_free = elem->next;
+      free(elem);
+      LIST_STAT_SET(p_list->stats.pooled, p_list->stats.pooled - 1);
+   }
+}
+
 /* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
 
 /*===========================================================================
@@ -73,6 +156,8 @@ linked_list_err_type linked_list_init(void** list_data)
 
    tmp_list->p_head = NULL;
    tmp_list->p_tail = NULL;
+   tmp_list->p_free = NULL;
+   tmp_list->stats.pool_max = LINKED_LIST_POOL_DEFAULT_MAX;
 
    *list_data = tmp_list;
 
@@ -95,6 +180,7 @@ linked_list_err_type linked_list_destroy(void** list_data)
    list_state* p_list = (list_state*)*list_data;
 
    linked_list_flush(p_list);
+   list_pool_trim(p_list, 0);
 
    free(*list_data);
    *list_data = NULL;
@@ -122,7 +208,7 @@ linked_list_err_type linked_list_add(void* list_data, void *data_obj, void (*dea
    }
 
    list_state* p_list = (list_state*)list_data;
-   list_element* elem = (list_element*)malloc(sizeof(list_element));
+   list_element* elem = list_node_get(p_list);
    if( elem == NULL )
    {
       LOC_LOGE("%s: Memory allocation failed\n", __FUNCTION__);
@@ -195,8 +281,8 @@ linked_list_err_type linked_list_remove(void* list_data, void **data_obj)
    /* Copy data to output param */
    *data_obj = tmp->data_ptr;
 
-   /* Free allocated list element */
-   free(tmp);
+   /* Return list element to the pool */
+   list_node_put(p_list, tmp);
 
    return eLINKED_LIST_SUCCESS;
 }
@@ -220,6 +306,41 @@ int linked_list_empty(void* list_data)
    }
 }
 
+/*===========================================================================
+
+  FUNCTION:   linked_list_peek_tail
+
+  ===========================================================================*/
+linked_list_err_type linked_list_peek_tail(void* list_data, void **data_obj,
+                                           void (**dealloc)(void*))
+{
+   if( list_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid list parameter!\n", __FUNCTION__);
+      return eLINKED_LIST_INVALID_HANDLE;
+   }
+
+   if( data_obj == NULL )
+   {
+      LOC_LOGE("%s: Invalid input parameter!\n", __FUNCTION__);
+      return eLINKED_LIST_INVALID_PARAMETER;
+   }
+
+   list_state* p_list = (list_state*)list_data;
+   if( p_list->p_tail == NULL )
+   {
+      return eLINKED_LIST_UNAVAILABLE_RESOURCE;
+   }
+
+   *data_obj = p_list->p_tail->data_ptr;
+   if( dealloc != NULL )
+   {
+      *dealloc = p_list->p_tail->dealloc_func;
+   }
+
+   return eLINKED_LIST_SUCCESS;
+}
+
 /*===========================================================================
 
   FUNCTION:   linked_list_flush
@@ -246,8 +367,8 @@ linked_list_err_type linked_list_flush(void* list_data)
          p_list->p_head->dealloc_func(p_list->p_head->data_ptr);
       }
 
-      /* Free list element */
-      free(p_list->p_head);
+      /* Return list element to the pool */
+      list_node_put(p_list, p_list->p_head);
 
       p_list->p_head = tmp;
    }
@@ -311,7 +432,7 @@ linked_list_err_type linked_list_search(void* list_data, void **data_p,
          if (NULL == data_p && NULL != tmp->dealloc_func) {
              tmp->dealloc_func(tmp->data_ptr);
          }
-         free(tmp);
+         list_node_put(p_list, tmp);
        }
 
        tmp = NULL;
@@ -323,3 +444,54 @@ linked_list_err_type linked_list_search(void* list_data, void **data_p,
    return eLINKED_LIST_SUCCESS;
 }
 
+/*===========================================================================
+
+  FUNCTION:   linked_list_set_pool_max
+
+  ===========================================================================*/
+linked_list_err_type linked_list_set_pool_max(void* list_data, unsigned int pool_max)
+{
+   if( list_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid list parameter!\n", __FUNCTION__);
+      return eLINKED_LIST_INVALID_HANDLE;
+   }
+
+   list_state* p_list = (list_state*)list_data;
+
+   LIST_STAT_SET(p_list->stats.pool_max, pool_max);
+   list_pool_trim(p_list, pool_max);
+
+   return eLINKED_LIST_SUCCESS;
+}
+
+/*===========================================================================
+
+  FUNCTION:   linked_list_get_stats
+
+  ===========================================================================*/
+linked_list_err_type linked_list_get_stats(void* list_data, linked_list_stats* stats)
+{
+   if( list_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid list parameter!\n", __FUNCTION__);
+      return eLINKED_LIST_INVALID_HANDLE;
+   }
+
+   if( stats == NULL )
+   {
+      LOC_LOGE("%s: Invalid stats parameter!\n", __FUNCTION__);
+      return eLINKED_LIST_INVALID_PARAMETER;
+   }
+
+   list_state* p_list = (list_state*)list_data;
+
+   stats->allocations = LIST_STAT_GET(p_list->stats.allocations);
+   stats->reused = LIST_STAT_GET(p_list->stats.reused);
+   stats->in_use = LIST_STAT_GET(p_list->stats.in_use);
+   stats->peak_in_use = LIST_STAT_GET(p_list->stats.peak_in_use);
+   stats->pooled = LIST_STAT_GET(p_list->stats.pooled);
+   stats->pool_max = LIST_STAT_GET(p_list->stats.pool_max);
+
+   return eLINKED_LIST_SUCCESS;
+}
@@ -33,6 +33,7 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 /** Linked List Return Codes */
@@ -54,6 +55,21 @@ typedef enum
      /**< Failed because list is empty. */
 }linked_list_err_type;
 
+/** Default max number of free nodes a list keeps for reuse, see
+    linked_list_set_pool_max */
+#define LINKED_LIST_POOL_DEFAULT_MAX 64
+
+/** Linked List Node Counters */
+typedef struct
+{
+  uint64_t allocations;  /**< Nodes malloc'ed by linked_list_add. */
+  uint64_t reused;       /**< Adds served from the node pool. */
+  uint32_t in_use;       /**< Nodes currently holding an element. */
+  uint32_t peak_in_use;  /**< Max of in_use since the list was created. */
+  uint32_t pooled;       /**< Free nodes currently kept for reuse. */
+  uint32_t pool_max;     /**< High-water mark of the node pool. */
+}linked_list_stats;
+
 /*===========================================================================
 FUNCTION    linked_list_init
 
@@ -163,6 +179,31 @@ SIDE EFFECTS
 ===========================================================================*/
 int linked_list_empty(void* list_data);
 
+/*===========================================================================
+FUNCTION    linked_list_peek_tail
+
+DESCRIPTION
+   Retrieves the oldest element of the list, i.e. the one the next
+   linked_list_remove would return, without removing it.
+
+   list_data: State of list to peek into.
+   data_obj:  Pointer to space to copy the element's data pointer to.
+   dealloc:   Pointer to space to copy the element's dealloc function to.
+              Pass NULL if not needed.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+linked_list_err_type linked_list_peek_tail(void* list_data, void **data_obj,
+                                           void (**dealloc)(void*));
+
 /*===========================================================================
 FUNCTION    linked_list_flush
 
@@ -212,6 +253,53 @@ linked_list_err_type linked_list_search(void* list_data, void **data_p,
                                         bool (*equal)(void* data_0, void* data),
                                         void* data_0, bool rm_if_found);
 
+/*===========================================================================
+FUNCTION    linked_list_set_pool_max
+
+DESCRIPTION
+   Sets the high-water mark of the node pool. Nodes of removed elements are
+   kept on a free list for the next linked_list_add, up to pool_max of them;
+   past that they are freed. Free nodes above a lowered mark are freed right
+   away. 0 disables the pool.
+
+   list_data: List handle.
+   pool_max:  Max number of free nodes to keep.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+linked_list_err_type linked_list_set_pool_max(void* list_data, unsigned int pool_max);
+
+/*===========================================================================
+FUNCTION    linked_list_get_stats
+
+DESCRIPTION
+   Takes a snapshot of the node counters of the list. Unlike the other
+   functions it may be called without the lock that serializes access to
+   the list, the counters are then only loosely consistent with each other.
+
+   list_data: List handle.
+   stats:     Pointer to the counters to fill in.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+linked_list_err_type linked_list_get_stats(void* list_data, linked_list_stats* stats);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
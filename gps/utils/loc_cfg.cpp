@@ -39,6 +39,14 @@
 #include <time.h>
 #include <grp.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <inttypes.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <loc_cfg.h>
 #include <loc_pla.h>
 #include <loc_target.h>
@@ -219,36 +227,31 @@ int loc_set_config_entry(const loc_param_s_type* config_entry,
 }
 
 /*===========================================================================
-FUNCTION loc_fill_conf_item
+FUNCTION loc_parse_conf_item
 
 DESCRIPTION
-   Takes a line of configuration item and sets defined values based on
-   the passed in configuration table. This table maps strings to values to
-   set along with the type of each of these values.
+   Splits a line of configuration item into its name and value, and parses
+   the numerical forms of the value.
 
 PARAMETERS:
-   input_buf : buffer contanis config item
-   config_table: table definition of strings to places to store information
-   table_length: length of the configuration table
+   input_buf : buffer contanis config item, tokenized in place
+   config_value: parsed item, pointing into input_buf
 
 DEPENDENCIES
    N/A
 
 RETURN VALUE
-   0: Number of records in the config_table filled with input_buf
+   true if input_buf holds a "name = value" item
 
 SIDE EFFECTS
    N/A
 ===========================================================================*/
-int loc_fill_conf_item(char* input_buf,
-                       const loc_param_s_type* config_table,
-                       uint32_t table_length, uint16_t string_len = LOC_MAX_PARAM_STRING)
+static bool loc_parse_conf_item(char* input_buf, loc_param_v_type& config_value)
 {
-    int ret = 0;
+    bool ret = false;
 
-    if (input_buf && config_table) {
+    if (input_buf) {
         char *lasts;
-        loc_param_v_type config_value;
         memset(&config_value, 0, sizeof(config_value));
 
         /* Separate variable and value */
@@ -276,13 +279,7 @@ int loc_fill_conf_item(char* input_buf,
                     config_value.param_double_value = (double) atof(config_value.param_str_value); /* float */
                     config_value.param_int_value = atoi(config_value.param_str_value); /* dec */
                 }
-
-                for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
-                {
-                    if(!loc_set_config_entry(&config_table[i], &config_value, string_len)) {
-                        ret += 1;
-                    }
-                }
+                ret = true;
             }
         }
     }
@@ -290,6 +287,183 @@ int loc_fill_conf_item(char* input_buf,
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_parse_conf_span
+
+DESCRIPTION
+   Same as loc_parse_conf_item, for a line that is not NULL terminated and
+   is left as it is. The trimmed name and value are copied into the
+   buffers passed in, the value cut to value_size as loc_set_config_entry
+   would store it.
+
+PARAMETERS:
+   line, len: config item, without the end of line
+   name_buf, name_size: buffer for the name
+   value_buf, value_size: buffer for the value
+   config_value: parsed item, pointing into name_buf and value_buf
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true if the line holds a "name = value" item
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static bool loc_parse_conf_span(const char* line, size_t len,
+                                char* name_buf, size_t name_size,
+                                char* value_buf, size_t value_size,
+                                loc_param_v_type& config_value)
+{
+    const char* end = line + len;
+
+    /* strtok_r skips the leading separators */
+    while (line < end && '=' == *line) {
+        line++;
+    }
+    const char* sep = (const char*)memchr(line, '=', end - line);
+    /* skip lines that do not contain two operands */
+    if (NULL == sep || sep + 1 == end) {
+        return false;
+    }
+
+    const char* name = line;
+    const char* nameEnd = sep;
+    const char* value = sep + 1;
+    const char* valueEnd = end;
+    while (name < nameEnd && isspace((unsigned char)*name)) {
+        name++;
+    }
+    while (nameEnd > name && isspace((unsigned char)nameEnd[-1])) {
+        nameEnd--;
+    }
+    while (value < valueEnd && isspace((unsigned char)*value)) {
+        value++;
+    }
+    while (valueEnd > value && isspace((unsigned char)valueEnd[-1])) {
+        valueEnd--;
+    }
+    /* a name that does not fit is not one of the table */
+    if ((size_t)(nameEnd - name) >= name_size || 0 == value_size) {
+        return false;
+    }
+    size_t valueLen = valueEnd - value;
+    if (valueLen >= value_size) {
+        valueLen = value_size - 1;
+    }
+
+    memset(&config_value, 0, sizeof(config_value));
+    memcpy(name_buf, name, nameEnd - name);
+    name_buf[nameEnd - name] = '\0';
+    memcpy(value_buf, value, valueLen);
+    value_buf[valueLen] = '\0';
+    config_value.param_name = name_buf;
+    config_value.param_str_value = value_buf;
+
+    /* Parse numerical value */
+    if ((valueLen >= 3) && (value_buf[0] == '0') && (tolower(value_buf[1]) == 'x'))
+    {
+        /* hex */
+        config_value.param_int_value = (int) strtol(&value_buf[2], (char**) NULL, 16);
+    }
+    else {
+        config_value.param_double_value = (double) atof(value_buf); /* float */
+        config_value.param_int_value = atoi(value_buf); /* dec */
+    }
+
+    return true;
+}
+
+/* Index of a configuration table by parameter name, so that a line of the
+   file costs one hash lookup rather than a strcmp against every entry. Keys
+   point at the table's own names, which outlive the index. */
+struct loc_param_name_hash {
+    inline size_t operator()(const char* name) const {
+        // FNV-1a
+        size_t hash = 2166136261u;
+        for (; *name; name++) {
+            hash = (hash ^ (unsigned char)*name) * 16777619u;
+        }
+        return hash;
+    }
+};
+struct loc_param_name_equal {
+    inline bool operator()(const char* a, const char* b) const {
+        return 0 == strcmp(a, b);
+    }
+};
+typedef std::unordered_multimap<const char*, uint32_t,
+        loc_param_name_hash, loc_param_name_equal> loc_param_index;
+
+static void loc_build_param_index(const loc_param_s_type* config_table,
+                                  uint32_t table_length, loc_param_index& index)
+{
+    index.clear();
+    index.reserve(table_length);
+    for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
+    {
+        if (NULL != config_table[i].param_name) {
+            index.emplace(config_table[i].param_name, i);
+        }
+    }
+}
+
+/*===========================================================================
+FUNCTION loc_fill_conf_item
+
+DESCRIPTION
+   Takes a line of configuration item and sets defined values based on
+   the passed in configuration table. This table maps strings to values to
+   set along with the type of each of these values.
+
+PARAMETERS:
+   input_buf : buffer contanis config item
+   config_table: table definition of strings to places to store information
+   index: config_table indexed by loc_build_param_index()
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   0: Number of records in the config_table filled with input_buf
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static int loc_set_conf_item(loc_param_v_type& config_value,
+                             const loc_param_s_type* config_table,
+                             const loc_param_index& index,
+                             uint16_t string_len)
+{
+    int ret = 0;
+
+    auto range = index.equal_range(config_value.param_name);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if(!loc_set_config_entry(&config_table[it->second], &config_value, string_len)) {
+            ret += 1;
+        }
+    }
+
+    return ret;
+}
+
+static int loc_fill_conf_item(char* input_buf,
+                              const loc_param_s_type* config_table,
+                              const loc_param_index& index,
+                              uint16_t string_len = LOC_MAX_PARAM_STRING)
+{
+    int ret = 0;
+    loc_param_v_type config_value;
+
+    if (config_table && loc_parse_conf_item(input_buf, config_value)) {
+        ret = loc_set_conf_item(config_value, config_table, index, string_len);
+    }
+
+    return ret;
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf_r_long (repetitive)
 
@@ -325,6 +499,7 @@ int loc_read_conf_r_long(FILE *conf_fp, const loc_param_s_type* config_table,
     int ret=0;
     char input_buf[string_len];  /* declare a char array */
     unsigned int num_params=table_length;
+    loc_param_index index;
 
     if(conf_fp == NULL) {
         LOC_LOGE("%s:%d]: ERROR: File pointer is NULL\n", __func__, __LINE__);
@@ -341,6 +516,8 @@ int loc_read_conf_r_long(FILE *conf_fp, const loc_param_s_type* config_table,
         }
     }
 
+    loc_build_param_index(config_table, table_length, index);
+
     LOC_LOGD("%s:%d]: num_params: %d\n", __func__, __LINE__, num_params);
     while(num_params)
     {
@@ -349,7 +526,7 @@ int loc_read_conf_r_long(FILE *conf_fp, const loc_param_s_type* config_table,
             break;
         }
 
-        num_params -= loc_fill_conf_item(input_buf, config_table, table_length, string_len);
+        num_params -= loc_fill_conf_item(input_buf, config_table, index, string_len);
     }
 
 err:
@@ -388,36 +565,174 @@ int loc_update_conf_long(const char* conf_data, int32_t length,
 {
     int ret = -1;
 
-    if (conf_data && length && config_table && table_length) {
-        // make a copy, so we do not tokenize the original data
-        char* conf_copy = (char*)malloc(length+1);
-
-        if (conf_copy != NULL)
-        {
-            memcpy(conf_copy, conf_data, length);
-            // we hard NULL the end of string to be safe
-            conf_copy[length] = 0;
-
-            // start with one record off
-            uint32_t num_params = table_length - 1;
-            char* saveptr = NULL;
-            char* input_buf = strtok_r(conf_copy, "\n", &saveptr);
-            ret = 0;
+    if (conf_data && length > 0 && config_table && table_length) {
+        // the data is parsed where it is, up to length or its NULL, if earlier
+        const char* cur = conf_data;
+        const char* end = conf_data + strnlen(conf_data, length);
+        char name_buf[LOC_MAX_PARAM_NAME];
+        char value_buf[string_len];
+        loc_param_v_type config_value;
 
-            LOC_LOGD("%s:%d]: num_params: %d\n", __func__, __LINE__, num_params);
-            while(num_params && input_buf) {
+        // start with one record off
+        uint32_t num_params = table_length - 1;
+        loc_param_index index;
+        loc_build_param_index(config_table, table_length, index);
+        ret = 0;
+
+        LOC_LOGD("%s:%d]: num_params: %d\n", __func__, __LINE__, num_params);
+        while(num_params && cur < end) {
+            const char* eol = (const char*)memchr(cur, '\n', end - cur);
+            if (NULL == eol) {
+                eol = end;
+            }
+            // empty lines do not count as records
+            if (eol > cur) {
                 ret++;
-                num_params -=
-                        loc_fill_conf_item(input_buf, config_table, table_length, string_len);
-                input_buf = strtok_r(NULL, "\n", &saveptr);
+                if (loc_parse_conf_span(cur, eol - cur, name_buf, sizeof(name_buf),
+                                        value_buf, string_len, config_value)) {
+                    num_params -=
+                            loc_set_conf_item(config_value, config_table, index, string_len);
+                }
             }
-            free(conf_copy);
+            cur = eol + 1;
         }
     }
 
     return ret;
 }
 
+/*=============================================================================
+ *
+ *   Process wide cache of parsed configuration files
+ *
+ *   gps.conf, izat.conf and friends are read by a good number of modules at
+ *   start up. Each file is mapped and parsed once into a hashed name ->
+ *   value table, and every loc_read_conf() against it after that is a set of
+ *   lookups. An entry is re-parsed if the file changes underneath it.
+ *
+ *============================================================================*/
+typedef struct {
+    std::string str_value;
+    int int_value;
+    double double_value;
+} loc_conf_value;
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime_sec;
+    long mtime_nsec;
+    std::unordered_map<std::string, loc_conf_value> params;
+} loc_conf_file;
+
+static pthread_mutex_t sConfCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::unordered_map<std::string, std::shared_ptr<const loc_conf_file>> sConfCache;
+
+static inline bool loc_conf_file_matches(const loc_conf_file& conf, const struct stat& st)
+{
+    return conf.dev == st.st_dev && conf.ino == st.st_ino && conf.size == st.st_size &&
+            conf.mtime_sec == st.st_mtim.tv_sec && conf.mtime_nsec == st.st_mtim.tv_nsec;
+}
+
+static std::shared_ptr<const loc_conf_file> loc_conf_file_parse(const char* conf_file_name)
+{
+    int fd = open(conf_file_name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    std::shared_ptr<loc_conf_file> conf;
+    struct stat st;
+    if (0 == fstat(fd, &st)) {
+        conf = std::make_shared<loc_conf_file>();
+        conf->dev = st.st_dev;
+        conf->ino = st.st_ino;
+        conf->size = st.st_size;
+        conf->mtime_sec = st.st_mtim.tv_sec;
+        conf->mtime_nsec = st.st_mtim.tv_nsec;
+
+        void* data = (st.st_size > 0) ?
+                mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        if (MAP_FAILED != data) {
+            const char* cur = (const char*)data;
+            const char* end = cur + st.st_size;
+            std::string line;
+            loc_param_v_type config_value;
+            while (cur < end) {
+                const char* eol = (const char*)memchr(cur, '\n', end - cur);
+                if (NULL == eol) {
+                    eol = end;
+                }
+                line.assign(cur, eol - cur);
+                cur = eol + 1;
+                if (loc_parse_conf_item(&line[0], config_value)) {
+                    // later occurrences of a parameter win, as with fgets
+                    loc_conf_value& value = conf->params[config_value.param_name];
+                    value.str_value = config_value.param_str_value;
+                    value.int_value = config_value.param_int_value;
+                    value.double_value = config_value.param_double_value;
+                }
+            }
+            munmap(data, st.st_size);
+        }
+    }
+    close(fd);
+
+    return conf;
+}
+
+static std::shared_ptr<const loc_conf_file> loc_conf_cache_get(const char* conf_file_name)
+{
+    std::shared_ptr<const loc_conf_file> conf;
+    struct stat st;
+
+    pthread_mutex_lock(&sConfCacheMutex);
+    if (0 != stat(conf_file_name, &st)) {
+        sConfCache.erase(conf_file_name);
+    } else {
+        auto it = sConfCache.find(conf_file_name);
+        if (it != sConfCache.end() && loc_conf_file_matches(*it->second, st)) {
+            conf = it->second;
+        } else {
+            conf = loc_conf_file_parse(conf_file_name);
+            if (nullptr != conf) {
+                sConfCache[conf_file_name] = conf;
+            } else if (it != sConfCache.end()) {
+                sConfCache.erase(it);
+            }
+        }
+    }
+    pthread_mutex_unlock(&sConfCacheMutex);
+
+    return conf;
+}
+
+static void loc_conf_cache_fill(const loc_conf_file& conf, const loc_param_s_type* config_table,
+                                uint32_t table_length, uint16_t string_len)
+{
+    loc_param_v_type config_value;
+
+    for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
+    {
+        /* Clear validity bit */
+        if(NULL != config_table[i].param_set)
+        {
+            *(config_table[i].param_set) = 0;
+        }
+
+        auto it = conf.params.find(config_table[i].param_name);
+        if (it != conf.params.end()) {
+            memset(&config_value, 0, sizeof(config_value));
+            config_value.param_name = (char*)config_table[i].param_name;
+            config_value.param_str_value = (char*)it->second.str_value.c_str();
+            config_value.param_int_value = it->second.int_value;
+            config_value.param_double_value = it->second.double_value;
+            loc_set_config_entry(&config_table[i], &config_value, string_len);
+        }
+    }
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf_long
 
@@ -443,18 +758,16 @@ SIDE EFFECTS
 void loc_read_conf_long(const char* conf_file_name, const loc_param_s_type* config_table,
                         uint32_t table_length, uint16_t string_len)
 {
-    FILE *conf_fp = NULL;
+    std::shared_ptr<const loc_conf_file> conf;
 
     log_buffer_init(false);
-    if((conf_fp = fopen(conf_file_name, "r")) != NULL)
+    if((conf = loc_conf_cache_get(conf_file_name)) != nullptr)
     {
         LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
         if(table_length && config_table) {
-            loc_read_conf_r_long(conf_fp, config_table, table_length, string_len);
-            rewind(conf_fp);
+            loc_conf_cache_fill(*conf, config_table, table_length, string_len);
         }
-        loc_read_conf_r_long(conf_fp, loc_param_table, loc_param_num, string_len);
-        fclose(conf_fp);
+        loc_conf_cache_fill(*conf, loc_param_table, loc_param_num, string_len);
     }
     /* Initialize logging mechanism with parsed data */
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
@@ -462,6 +775,90 @@ void loc_read_conf_long(const char* conf_file_name, const loc_param_s_type* conf
     log_tag_level_map_init();
 }
 
+/*===========================================================================
+FUNCTION loc_read_conf_items
+
+DESCRIPTION
+   Gets the name and value of every parameter the specified configuration
+   file holds, so that callers can tell which of them changed.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+   items: filled with the parameters
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true if the file could be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+bool loc_read_conf_items(const char* conf_file_name, LocConfItems& items)
+{
+    std::shared_ptr<const loc_conf_file> conf = loc_conf_cache_get(conf_file_name);
+
+    items.clear();
+    if (nullptr != conf) {
+        items.reserve(conf->params.size());
+        for (auto& each : conf->params) {
+            items.emplace(each.first, each.second.str_value);
+        }
+    }
+    return (nullptr != conf);
+}
+
+/*===========================================================================
+FUNCTION loc_read_conf_subset
+
+DESCRIPTION
+   Reads the specified configuration file and sets the entries of the passed
+   in configuration table that are also in names. Other entries, and the
+   validity bits of all of them, are left as they are.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+   config_table: table definition of strings to places to store information
+   table_length: length of the configuration table
+   names: names of the parameters to set
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   number of the records in the table that are set
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+int loc_read_conf_subset(const char* conf_file_name, const loc_param_s_type* config_table,
+                         uint32_t table_length, const LocConfNames& names)
+{
+    int ret = 0;
+    std::shared_ptr<const loc_conf_file> conf = loc_conf_cache_get(conf_file_name);
+    loc_param_v_type config_value;
+
+    for(uint32_t i = 0; nullptr != conf && NULL != config_table && i < table_length; i++)
+    {
+        if (0 == names.count(config_table[i].param_name)) {
+            continue;
+        }
+        auto it = conf->params.find(config_table[i].param_name);
+        if (it != conf->params.end()) {
+            memset(&config_value, 0, sizeof(config_value));
+            config_value.param_name = (char*)config_table[i].param_name;
+            config_value.param_str_value = (char*)it->second.str_value.c_str();
+            config_value.param_int_value = it->second.int_value;
+            config_value.param_double_value = it->second.double_value;
+            if (!loc_set_config_entry(&config_table[i], &config_value)) {
+                ret++;
+            }
+        }
+    }
+    return ret;
+}
+
 /*=============================================================================
  *
  *   Define and Structures for Parsing Location Process Configuration File
@@ -555,7 +952,7 @@ static const loc_param_s_type loc_process_conf_parameter_table[] = {
 };
 
 /*===========================================================================
-FUNCTION loc_read_process_conf
+FUNCTION loc_parse_process_conf
 
 DESCRIPTION
    Parse the specified conf file and return info for the processes defined.
@@ -579,8 +976,8 @@ SIDE EFFECTS
 NOTES:
    On success, memory pointed by (*process_info_table_ptr) must be freed.
 ===========================================================================*/
-int loc_read_process_conf(const char* conf_file_name, uint32_t * process_count_ptr,
-                          loc_process_info_s_type** process_info_table_ptr) {
+static int loc_parse_process_conf(const char* conf_file_name, uint32_t * process_count_ptr,
+                                  loc_process_info_s_type** process_info_table_ptr) {
     loc_process_info_s_type *child_proc = nullptr;
     volatile int i=0;
     unsigned int j=0;
@@ -1151,3 +1548,123 @@ err:
 
     return ret;
 }
+
+/* The process table of the last conf file parsed. It is what every
+   loc_read_process_conf() caller in the process gets until izat.conf or gps.conf
+   change or the properties the table depends on do; the platform checks behind it
+   are cached by loc_target already. The lock also serializes the parser, which
+   works on the file scope conf struct. */
+typedef struct {
+    std::string conf_file_name;
+    struct stat conf_st;
+    struct stat gps_conf_st;
+    bool xtra_daemon_enabled;
+    bool vendor_enhanced;
+    std::vector<loc_process_info_s_type> table;
+} loc_process_conf_cache;
+
+static pthread_mutex_t sProcessConfMutex = PTHREAD_MUTEX_INITIALIZER;
+static loc_process_conf_cache* sProcessConf = nullptr;
+
+static inline bool loc_stat_matches(const struct stat& a, const struct stat& b)
+{
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino && a.st_size == b.st_size &&
+            a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+/*===========================================================================
+FUNCTION loc_read_process_conf
+
+DESCRIPTION
+   Parse the specified conf file and return info for the processes defined.
+   The format of the file should conform with izat.conf. The table is parsed
+   once and handed out again while the conf files stay the same.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+   process_count_ptr: pointer to store number of processes defined in the conf file.
+   process_info_table_ptr: pointer to store the process info table.
+
+DEPENDENCIES
+   The file must be in izat.conf format.
+
+RETURN VALUE
+   0: success
+   none-zero: failure
+
+SIDE EFFECTS
+   N/A
+
+NOTES:
+   On success, memory pointed by (*process_info_table_ptr) must be freed.
+===========================================================================*/
+int loc_read_process_conf(const char* conf_file_name, uint32_t * process_count_ptr,
+                          loc_process_info_s_type** process_info_table_ptr) {
+    if (conf_file_name == NULL || process_count_ptr == NULL || process_info_table_ptr == NULL) {
+        return -1;
+    }
+
+    struct stat conf_st, gps_conf_st;
+    if (0 != stat(conf_file_name, &conf_st)) {
+        memset(&conf_st, 0, sizeof(conf_st));
+    }
+    if (0 != stat(LOC_PATH_GPS_CONF, &gps_conf_st)) {
+        memset(&gps_conf_st, 0, sizeof(gps_conf_st));
+    }
+    bool xtra_daemon_enabled = isXtraDaemonEnabled();
+    bool vendor_enhanced = isVendorEnhanced();
+    int ret = 0;
+
+    pthread_mutex_lock(&sProcessConfMutex);
+    if (nullptr == sProcessConf || sProcessConf->conf_file_name != conf_file_name ||
+        !loc_stat_matches(sProcessConf->conf_st, conf_st) ||
+        !loc_stat_matches(sProcessConf->gps_conf_st, gps_conf_st) ||
+        sProcessConf->xtra_daemon_enabled != xtra_daemon_enabled ||
+        sProcessConf->vendor_enhanced != vendor_enhanced) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint32_t count = 0;
+        loc_process_info_s_type* table = nullptr;
+        ret = loc_parse_process_conf(conf_file_name, &count, &table);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        LOC_LOGd("%s parsed in %" PRId64 " us, %u processes", conf_file_name,
+                 (int64_t)((end.tv_sec - start.tv_sec) * 1000000 +
+                           (end.tv_nsec - start.tv_nsec) / 1000), count);
+        if (0 == ret) {
+            if (nullptr == sProcessConf) {
+                sProcessConf = new loc_process_conf_cache();
+            }
+            sProcessConf->conf_file_name = conf_file_name;
+            sProcessConf->conf_st = conf_st;
+            sProcessConf->gps_conf_st = gps_conf_st;
+            sProcessConf->xtra_daemon_enabled = xtra_daemon_enabled;
+            sProcessConf->vendor_enhanced = vendor_enhanced;
+            sProcessConf->table.assign(table, table + count);
+            free(table);
+        } else if (nullptr != sProcessConf) {
+            delete sProcessConf;
+            sProcessConf = nullptr;
+        }
+    }
+
+    *process_count_ptr = 0;
+    *process_info_table_ptr = nullptr;
+    if (0 == ret) {
+        size_t count = sProcessConf->table.size();
+        loc_process_info_s_type* table = (loc_process_info_s_type*)calloc(
+                count > 0 ? count : 1, sizeof(loc_process_info_s_type));
+        if (nullptr == table) {
+            LOC_LOGE("%s:%d]: ERROR: Malloc returned NULL\n", __func__, __LINE__);
+            ret = -1;
+        } else {
+            if (count > 0) {
+                memcpy(table, sProcessConf->table.data(), count * sizeof(loc_process_info_s_type));
+            }
+            *process_count_ptr = count;
+            *process_info_table_ptr = table;
+        }
+    }
+    pthread_mutex_unlock(&sProcessConfMutex);
+
+    return ret;
+}
@@ -162,6 +162,28 @@ int loc_read_process_conf(const char* conf_file_name, uint32_t * process_count_p
 int loc_get_datum_type();
 #ifdef __cplusplus
 }
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Name -> value of the parameters in a conf file, and a set of names
+typedef std::unordered_map<std::string, std::string> LocConfItems;
+typedef std::unordered_set<std::string> LocConfNames;
+
+/* Gets the parameters conf_file_name holds right now. Returns false if the
+   file can't be read. */
+bool loc_read_conf_items(const char* conf_file_name, LocConfItems& items);
+
+/* Like loc_read_conf, but only sets the entries of config_table that are in
+   names, leaving the others and all param_set flags alone. Returns the
+   number of entries set. */
+int loc_read_conf_subset(const char* conf_file_name, const loc_param_s_type* config_table,
+                         uint32_t table_length, const LocConfNames& names);
+
+#define UTIL_READ_CONF_SUBSET(filename, config_table, names) \
+    loc_read_conf_subset((filename), (&config_table[0]), \
+                         sizeof(config_table) / sizeof(config_table[0]), (names))
 #endif
 
 #endif /* LOC_CFG_H */
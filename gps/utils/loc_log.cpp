@@ -59,6 +59,32 @@ const char EXIT_ERROR_TAG[]  = "Exiting with error";
 
 int build_type_prop = BUILD_TYPE_PROP_NA;
 
+/* "HH:MM:SS" */
+#define LOC_HMS_LEN 8
+
+/* Write hms followed by '.' and frac zero padded to digits, truncated to
+   buf_size like snprintf would. */
+static char *loc_format_hms_frac(char *str, size_t buf_size, const char *hms, long frac,
+                                 int digits)
+{
+    char tmp[LOC_HMS_LEN + 1 + 9 + 1];
+
+    memcpy(tmp, hms, LOC_HMS_LEN);
+    tmp[LOC_HMS_LEN] = '.';
+    for (int i = digits; i > 0; i--) {
+        tmp[LOC_HMS_LEN + i] = '0' + frac % 10;
+        frac /= 10;
+    }
+    tmp[LOC_HMS_LEN + 1 + digits] = '\0';
+
+    if (buf_size > 0) {
+        size_t len = std::min(buf_size - 1, (size_t)(LOC_HMS_LEN + 1 + digits));
+        memcpy(str, tmp, len);
+        str[len] = '\0';
+    }
+    return str;
+}
+
 const string gEmptyStr = "";
 const string gUnknownStr = "UNKNOWN";
 /* Logging Mechanism */
@@ -168,17 +194,21 @@ RETURN VALUE
 ===========================================================================*/
 char *loc_get_time(char *time_string, size_t buf_size)
 {
+   /* HH:MM:SS of the last second seen by this thread, re-rendered only
+      once a second so localtime_r and its tz lock stay off most calls */
+   static thread_local time_t cached_sec = -1;
+   static thread_local char cached_hms[LOC_HMS_LEN + 1];
    struct timeval now;     /* sec and usec     */
-   struct tm now_tm;       /* broken-down time */
-   char hms_string[80];    /* HH:MM:SS         */
 
    gettimeofday(&now, NULL);
-   localtime_r(&now.tv_sec, &now_tm);
-
-   strftime(hms_string, sizeof hms_string, "%H:%M:%S", &now_tm);
-   snprintf(time_string, buf_size, "%s.%03d", hms_string, (int) (now.tv_usec / 1000));
-
-   return time_string;
+   if (now.tv_sec != cached_sec) {
+      struct tm now_tm;    /* broken-down time */
+      localtime_r(&now.tv_sec, &now_tm);
+      strftime(cached_hms, sizeof cached_hms, "%H:%M:%S", &now_tm);
+      cached_sec = now.tv_sec;
+   }
+
+   return loc_format_hms_frac(time_string, buf_size, cached_hms, now.tv_usec / 1000, 3);
 }
 
 /*===========================================================================
@@ -198,15 +228,19 @@ SIDE EFFECTS
 ===========================================================================*/
 char * get_timestamp(char *str, unsigned long buf_size)
 {
+  /* every LOC_LOG* line lands here, only the fraction changes within a second */
+  static thread_local time_t cached_sec = -1;
+  static thread_local char cached_hms[LOC_HMS_LEN + 1];
   struct timeval tv;
-  struct timezone tz;
-  int hh, mm, ss;
-  gettimeofday(&tv, &tz);
-  hh = tv.tv_sec/3600%24;
-  mm = (tv.tv_sec%3600)/60;
-  ss = tv.tv_sec%60;
-  snprintf(str, buf_size, "%02d:%02d:%02d.%06ld", hh, mm, ss, tv.tv_usec);
-  return str;
+  gettimeofday(&tv, NULL);
+  if (tv.tv_sec != cached_sec) {
+    int hh = tv.tv_sec/3600%24;
+    int mm = (tv.tv_sec%3600)/60;
+    int ss = tv.tv_sec%60;
+    snprintf(cached_hms, sizeof(cached_hms), "%02d:%02d:%02d", hh, mm, ss);
+    cached_sec = tv.tv_sec;
+  }
+  return loc_format_hms_frac(str, buf_size, cached_hms, tv.tv_usec, 6);
 }
 
 /*===========================================================================
@@ -220,13 +254,12 @@ RETURN VALUE
    N/A
 
 ===========================================================================*/
-void log_buffer_insert(char *str, unsigned long buf_size __unused, int level)
+void log_buffer_insert(char *str, unsigned long buf_size, int level)
 {
     timespec tv;
     clock_gettime(CLOCK_BOOTTIME, &tv);
     uint64_t elapsedTime = (uint64_t)tv.tv_sec + (uint64_t)tv.tv_nsec/1000000000;
-    string ss = str;
-    loc_util::LogBuffer::getInstance()->append(ss, level, elapsedTime);
+    loc_util::LogBuffer::getInstance()->append(str, strnlen(str, buf_size), level, elapsedTime);
 }
 
 void log_tag_level_map_init()
@@ -35,9 +35,11 @@
 #include <math.h>
 #include <log_util.h>
 #include <loc_misc_utils.h>
+#include <LocLibPreloader.h>
 #include <ctype.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <atomic>
 
 #ifndef MSEC_IN_ONE_SEC
 #define MSEC_IN_ONE_SEC 1000ULL
@@ -124,6 +126,24 @@ err:
     return;
 }
 
+bool loc_util_name_in_list(const char *list, const char *name)
+{
+    size_t len = strlen(name);
+    const char *p = list;
+
+    while (*p) {
+        while (*p == ',' || *p == ' ') {
+            p++;
+        }
+        size_t tokenLen = strcspn(p, ", ");
+        if (tokenLen == len && 0 == strncmp(p, name, len)) {
+            return true;
+        }
+        p += tokenLen;
+    }
+    return false;
+}
+
 inline void logDlError(const char* failedCall) {
     const char * err = dlerror();
     LOC_LOGe("%s error: %s", failedCall, (nullptr == err) ? "unknown" : err);
@@ -134,7 +154,7 @@ void* dlGetSymFromLib(void*& libHandle, const char* libName, const char* symName
     void* sym = nullptr;
     if ((nullptr != libHandle || nullptr != libName) && nullptr != symName) {
         if (nullptr == libHandle) {
-            libHandle = dlopen(libName, RTLD_NOW);
+            libHandle = loc_util::LocLibPreloader::open(libName);
             if (nullptr == libHandle) {
                 logDlError("dlopen");
             }
@@ -169,7 +189,9 @@ uint64_t getQTimerTickCount()
     return qTimerCount;
 }
 
-uint64_t getQTimerDeltaNanos()
+/* Reads the delta from the MHI time_us node, sets present to whether any
+   MHI device node exists at all */
+static uint64_t readQTimerDeltaNanos(bool& present)
 {
     char qtimer_val_string[100];
     char *temp;
@@ -180,26 +202,27 @@ uint64_t getQTimerDeltaNanos()
     memset(qtimer_val_string, '\0', sizeof(qtimer_val_string));
 
     char devNode[] = "/sys/bus/mhi/devices/0306_00.01.00/time_us";
-    for (; devNode[27] < 3 && mdm_fd < 0; devNode[27]++) {
-        mdm_fd = ::open(devNode, O_RDONLY);
+    for (; devNode[27] < '3' && mdm_fd < 0; devNode[27]++) {
+        mdm_fd = ::open(devNode, O_RDONLY | O_CLOEXEC);
         if (mdm_fd < 0) {
-            LOC_LOGe("MDM open file: %s error: %s", devNode, strerror(errno));
+            LOC_LOGv("MDM open file: %s error: %s", devNode, strerror(errno));
         }
     }
-    if (mdm_fd > 0) {
+    present = (mdm_fd >= 0);
+    if (mdm_fd >= 0) {
         ret = read(mdm_fd, qtimer_val_string, sizeof(qtimer_val_string)-1);
         ::close(mdm_fd);
         if (ret < 0) {
             LOC_LOGe("MDM read time_us file error: %s", strerror(errno));
         } else {
-            temp = qtimer_val_string;
-            temp = strchr(temp, ':');
-            temp = temp + 2;
-            local_qtimer = atoll(temp);
-
-            temp = strchr(temp, ':');
-            temp = temp + 2;
-            remote_qtimer = atoll(temp);
+            temp = strchr(qtimer_val_string, ':');
+            if (temp != nullptr) {
+                local_qtimer = strtoull(temp + 1, &temp, 10);
+                temp = strchr(temp, ':');
+            }
+            if (temp != nullptr) {
+                remote_qtimer = strtoull(temp + 1, nullptr, 10);
+            }
 
             if (local_qtimer >= remote_qtimer) {
                 delta = (local_qtimer - remote_qtimer) * 1000;
@@ -212,6 +235,33 @@ uint64_t getQTimerDeltaNanos()
     return delta;
 }
 
+/* The AP/MP Qtimer delta only drifts slowly, so it is read again at most
+   this often. Without MHI devices (single SoC) it stays 0. */
+#define QTIMER_DELTA_REFRESH_MSEC (60 * MSEC_IN_ONE_SEC)
+
+uint64_t getQTimerDeltaNanos()
+{
+    static std::atomic<uint64_t> sDeltaNanos(0);
+    static std::atomic<uint64_t> sNextRefreshMs(0);
+    static std::atomic<bool> sLoggedAbsent(false);
+
+    uint64_t nowMs = getBootTimeMilliSec();
+    uint64_t nextRefreshMs = sNextRefreshMs.load(std::memory_order_relaxed);
+
+    // one caller refreshes, the others keep using the cached delta meanwhile
+    if (nowMs >= nextRefreshMs &&
+        sNextRefreshMs.compare_exchange_strong(nextRefreshMs, nowMs + QTIMER_DELTA_REFRESH_MSEC)) {
+        bool present = false;
+        uint64_t delta = readQTimerDeltaNanos(present);
+        if (!present && !sLoggedAbsent.exchange(true)) {
+            LOC_LOGi("no MHI time_us node, Qtimer delta is 0");
+        }
+        sDeltaNanos.store(delta, std::memory_order_relaxed);
+    }
+
+    return sDeltaNanos.load(std::memory_order_relaxed);
+}
+
 uint64_t getQTimerFreq()
 {
 #if __aarch64__
@@ -234,19 +284,16 @@ uint64_t getBootTimeMilliSec()
     return (uint64_t)GET_MSEC_FROM_TS(curTs);
 }
 
-// Used for convert position/velocity from GSNS antenna based to VRP based
-void Matrix_MxV(float a[3][3],  float b[3], float c[3]) {
-    int i, j;
-
-    for (i=0; i<3; i++) {
-        c[i] = 0.0f;
-        for (j=0; j<3; j++)
-            c[i] += a[i][j] * b[j];
-    }
+// Fixed size 3x3 kernels used to convert position/velocity from GNSS antenna
+// based to VRP based. Kept local and fully unrolled so they inline into the
+// callers without loop or call overhead.
+static inline void Matrix_MxV(const float a[3][3], const float b[3], float c[3]) {
+    c[0] = a[0][0] * b[0] + a[0][1] * b[1] + a[0][2] * b[2];
+    c[1] = a[1][0] * b[0] + a[1][1] * b[1] + a[1][2] * b[2];
+    c[2] = a[2][0] * b[0] + a[2][1] * b[1] + a[2][2] * b[2];
 }
 
-// Used for convert position/velocity from GNSS antenna based to VRP based
-void Matrix_Skew(float a[3], float c[3][3]) {
+static inline void Matrix_Skew(const float a[3], float c[3][3]) {
     c[0][0] = 0.0f;
     c[0][1] = -a[2];
     c[0][2] = a[1];
@@ -258,16 +305,13 @@ void Matrix_Skew(float a[3], float c[3][3]) {
     c[2][2] = 0.0f;
 }
 
-// Used for convert position/velocity from GNSS antenna based to VRP based
-void Euler2Dcm(float euler[3], float dcm[3][3]) {
-    float cr = 0.0, sr = 0.0, cp = 0.0, sp = 0.0, ch = 0.0, sh = 0.0;
-
-    cr = cosf(euler[0]);
-    sr = sinf(euler[0]);
-    cp = cosf(euler[1]);
-    sp = sinf(euler[1]);
-    ch = cosf(euler[2]);
-    sh = sinf(euler[2]);
+static inline void Euler2Dcm(const float euler[3], float dcm[3][3]) {
+    float cr = cosf(euler[0]);
+    float sr = sinf(euler[0]);
+    float cp = cosf(euler[1]);
+    float sp = sinf(euler[1]);
+    float ch = cosf(euler[2]);
+    float sh = sinf(euler[2]);
 
     dcm[0][0] = cp * ch;
     dcm[0][1] = (sp*sr*ch) - (cr*sh);
@@ -296,7 +340,6 @@ void loc_convert_lla_gnss_to_vrp(double lla[3], float rollPitchYaw[3],
              rollPitchYaw[0], rollPitchYaw[1], rollPitchYaw[2]);
 
     float cnb[3][3];
-    memset(cnb, 0, sizeof(cnb));
     Euler2Dcm(rollPitchYaw, cnb);
 
     float sl = sin(lla[0]);
@@ -331,17 +374,13 @@ void loc_convert_velocity_gnss_to_vrp(float enuVelocity[3], float rollPitchYaw[3
              rollPitchYawRate[0], rollPitchYawRate[1], rollPitchYawRate[2]);
 
     float cnb[3][3];
-    memset(cnb, 0, sizeof(cnb));
     Euler2Dcm(rollPitchYaw, cnb);
 
     float skewLA[3][3];
-    memset(skewLA, 0, sizeof(skewLA));
     Matrix_Skew(leverArm, skewLA);
 
     float tmp[3];
     float deltaEnuVelocity[3];
-    memset(tmp, 0, sizeof(tmp));
-    memset(deltaEnuVelocity, 0, sizeof(deltaEnuVelocity));
     Matrix_MxV(skewLA, rollPitchYawRate, tmp);
     Matrix_MxV(cnb, tmp, deltaEnuVelocity);
 
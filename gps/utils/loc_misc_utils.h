@@ -98,6 +98,24 @@ SIDE EFFECTS
 ===========================================================================*/
 void loc_util_trim_space(char *org_string);
 
+/*===========================================================================
+FUNCTION loc_util_name_in_list
+
+DESCRIPTION
+   Checks whether name is one of the entries of a comma (and / or space)
+   separated list, as gps.conf lists thread names
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true if name is listed
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+bool loc_util_name_in_list(const char *list, const char *name);
+
 /*===========================================================================
 FUNCTION dlGetSymFromLib
 
@@ -149,6 +167,7 @@ FUNCTION getQTimerDeltaNanos
 DESCRIPTION
 This function is used to read the the difference in nanoseconds between
 Qtimer on AP side and Qtimer on MP side for dual-SoC architectures such as Kona
+The value is cached and read from the MHI node again at most once a minute.
 
 DEPENDENCIES
 N/A
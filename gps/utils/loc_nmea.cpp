@@ -45,6 +45,7 @@
 #define MAX_SATELLITES_IN_USE 12
 #define MSEC_IN_ONE_WEEK      604800000ULL
 #define UTC_GPS_OFFSET_MSECS  315964800000ULL
+#define SEC_IN_ONE_DAY        86400
 #define MAX_TAG_BLOCK_GROUP_CODE  (99999)
 
 // GNSS system id according to NMEA spec
@@ -124,6 +125,30 @@ typedef struct loc_nmea_sv_meta_s
     uint32_t systemId;
 } loc_nmea_sv_meta;
 
+// UTC date and time of day of a fix, day is days since the epoch
+typedef struct loc_nmea_utc_s
+{
+    int64_t day;
+    int year;
+    int month;
+    int mday;
+    int hours;
+    int minutes;
+    int seconds;
+} loc_nmea_utc;
+
+// last leap second change reported, with what follows from it
+typedef struct loc_nmea_leap_second_s
+{
+    bool valid;
+    uint16_t systemWeek;
+    uint32_t systemMsec;
+    uint8_t leapSecondsBeforeChange;
+    uint8_t leapSecondsAfterChange;
+    uint64_t gpsTimeLsChange;
+    LocGpsUtcTime utcTimeInTransition;
+} loc_nmea_leap_second;
+
 typedef struct loc_sv_cache_info_s
 {
     uint64_t gps_used_mask;
@@ -272,83 +297,183 @@ static void convert_Ecef_to_Lla(const LocEcef& pecef, LocLla& plla)
     }
 }
 
+// NMEA conventions of each constellation, indexed by GnssSvType. SBAS has
+// no talker of its own, its SVs are reported with GPS.
+typedef struct loc_nmea_constellation_s
+{
+    GnssSvType svType;
+    const char* talker;                 // nullptr if it has none
+    uint32_t systemId;
+    uint32_t svIdOffset;
+    uint64_t loc_sv_cache_info_s::* usedMask;
+    uint32_t svTypeMask;                // reported under this talker
+    GnssSignalTypeMask defaultSignal;   // if no signal type in report
+    int8_t firstGsvGroup;               // into sGsvGroups, -1 if none
+    uint8_t gsvGroupCount;
+} loc_nmea_constellation;
+
+static constexpr loc_nmea_constellation sConstellations[] = {
+    {GNSS_SV_TYPE_UNKNOWN, nullptr, 0, 0, nullptr, 0, 0, -1, 0},
+    {GNSS_SV_TYPE_GPS, "GP", SYSTEM_ID_GPS, 0, &loc_sv_cache_info_s::gps_used_mask,
+            (1 << GNSS_SV_TYPE_GPS) | (1 << GNSS_SV_TYPE_SBAS), GNSS_SIGNAL_GPS_L1CA, 0, 3},
+    {GNSS_SV_TYPE_SBAS, nullptr, 0, SBAS_SV_ID_OFFSET, nullptr,
+            0, GNSS_SIGNAL_SBAS_L1, 0, 3},
+    // GLONASS SV ids are from 65-96
+    {GNSS_SV_TYPE_GLONASS, "GL", SYSTEM_ID_GLONASS, GLONASS_SV_ID_OFFSET,
+            &loc_sv_cache_info_s::glo_used_mask,
+            (1 << GNSS_SV_TYPE_GLONASS), GNSS_SIGNAL_GLONASS_G1, 3, 2},
+    // QZSS SV ids are from 193-199. So keep svIdOffset 192
+    {GNSS_SV_TYPE_QZSS, "GQ", SYSTEM_ID_QZSS, QZSS_SV_ID_OFFSET,
+            &loc_sv_cache_info_s::qzss_used_mask,
+            (1 << GNSS_SV_TYPE_QZSS), GNSS_SIGNAL_QZSS_L1CA, 8, 3},
+    // BDS SV ids are from 201-237. So keep svIdOffset 200
+    {GNSS_SV_TYPE_BEIDOU, "GB", SYSTEM_ID_BDS, BDS_SV_ID_OFFSET,
+            &loc_sv_cache_info_s::bds_used_mask,
+            (1 << GNSS_SV_TYPE_BEIDOU), GNSS_SIGNAL_BEIDOU_B1I, 11, 3},
+    // GALILEO SV ids are from 301-336, So keep svIdOffset 300
+    {GNSS_SV_TYPE_GALILEO, "GA", SYSTEM_ID_GALILEO, GALILEO_SV_ID_OFFSET,
+            &loc_sv_cache_info_s::gal_used_mask,
+            (1 << GNSS_SV_TYPE_GALILEO), GNSS_SIGNAL_GALILEO_E1, 5, 3},
+    // NAVIC SV ids are from 401-414. So keep svIdOffset 400
+    {GNSS_SV_TYPE_NAVIC, "GI", SYSTEM_ID_NAVIC, NAVIC_SV_ID_OFFSET,
+            &loc_sv_cache_info_s::navic_used_mask,
+            (1 << GNSS_SV_TYPE_NAVIC), GNSS_SIGNAL_NAVIC_L5, 14, 1}
+};
+#define CONSTELLATION_COUNT (sizeof(sConstellations) / sizeof(sConstellations[0]))
+
+// NMEA signal ID of each GnssSignalTypeMask bit, indexed by bit position,
+// and the constellation and loc_sv_cache_info count the signal is counted in
+typedef struct loc_nmea_signal_s
+{
+    GnssSignalTypeMask signalType;
+    uint32_t signalId;
+    GnssSvType svType;
+    uint32_t loc_sv_cache_info_s::* svCount;    // nullptr if not counted
+} loc_nmea_signal;
+
+static constexpr loc_nmea_signal sSignals[] = {
+    {GNSS_SIGNAL_GPS_L1CA, SIGNAL_ID_GPS_L1CA, GNSS_SV_TYPE_GPS,
+            &loc_sv_cache_info_s::gps_l1_count},
+    {GNSS_SIGNAL_GPS_L1C, SIGNAL_ID_ALL_SIGNALS, GNSS_SV_TYPE_UNKNOWN, nullptr},
+    {GNSS_SIGNAL_GPS_L2, SIGNAL_ID_GPS_L2CL, GNSS_SV_TYPE_GPS,
+            &loc_sv_cache_info_s::gps_l2_count},
+    {GNSS_SIGNAL_GPS_L5, SIGNAL_ID_GPS_L5Q, GNSS_SV_TYPE_GPS,
+            &loc_sv_cache_info_s::gps_l5_count},
+    {GNSS_SIGNAL_GLONASS_G1, SIGNAL_ID_GLO_G1CA, GNSS_SV_TYPE_GLONASS,
+            &loc_sv_cache_info_s::glo_g1_count},
+    {GNSS_SIGNAL_GLONASS_G2, SIGNAL_ID_GLO_G2CA, GNSS_SV_TYPE_GLONASS,
+            &loc_sv_cache_info_s::glo_g2_count},
+    {GNSS_SIGNAL_GALILEO_E1, SIGNAL_ID_GAL_L1BC, GNSS_SV_TYPE_GALILEO,
+            &loc_sv_cache_info_s::gal_e1_count},
+    {GNSS_SIGNAL_GALILEO_E5A, SIGNAL_ID_GAL_E5A, GNSS_SV_TYPE_GALILEO,
+            &loc_sv_cache_info_s::gal_e5_count},
+    {GNSS_SIGNAL_GALILEO_E5B, SIGNAL_ID_GAL_E5B, GNSS_SV_TYPE_GALILEO,
+            &loc_sv_cache_info_s::gal_e5b_count},
+    {GNSS_SIGNAL_BEIDOU_B1, SIGNAL_ID_ALL_SIGNALS, GNSS_SV_TYPE_UNKNOWN, nullptr},
+    {GNSS_SIGNAL_BEIDOU_B2, SIGNAL_ID_ALL_SIGNALS, GNSS_SV_TYPE_UNKNOWN, nullptr},
+    {GNSS_SIGNAL_QZSS_L1CA, SIGNAL_ID_QZSS_L1CA, GNSS_SV_TYPE_QZSS,
+            &loc_sv_cache_info_s::qzss_l1_count},
+    {GNSS_SIGNAL_QZSS_L1S, SIGNAL_ID_ALL_SIGNALS, GNSS_SV_TYPE_UNKNOWN, nullptr},
+    {GNSS_SIGNAL_QZSS_L2, SIGNAL_ID_QZSS_L2CL, GNSS_SV_TYPE_QZSS,
+            &loc_sv_cache_info_s::qzss_l2_count},
+    {GNSS_SIGNAL_QZSS_L5, SIGNAL_ID_QZSS_L5Q, GNSS_SV_TYPE_QZSS,
+            &loc_sv_cache_info_s::qzss_l5_count},
+    {GNSS_SIGNAL_SBAS_L1, SIGNAL_ID_GPS_L1CA, GNSS_SV_TYPE_UNKNOWN, nullptr},
+    {GNSS_SIGNAL_BEIDOU_B1I, SIGNAL_ID_BDS_B1I, GNSS_SV_TYPE_BEIDOU,
+            &loc_sv_cache_info_s::bds_b1i_count},
+    {GNSS_SIGNAL_BEIDOU_B1C, SIGNAL_ID_BDS_B1C, GNSS_SV_TYPE_BEIDOU,
+            &loc_sv_cache_info_s::bds_b1c_count},
+    {GNSS_SIGNAL_BEIDOU_B2I, SIGNAL_ID_BDS_B2I, GNSS_SV_TYPE_UNKNOWN, nullptr},
+    {GNSS_SIGNAL_BEIDOU_B2AI, SIGNAL_ID_BDS_B2A, GNSS_SV_TYPE_BEIDOU,
+            &loc_sv_cache_info_s::bds_b2_count},
+    {GNSS_SIGNAL_NAVIC_L5, SIGNAL_ID_NAVIC_L5SPS, GNSS_SV_TYPE_NAVIC,
+            &loc_sv_cache_info_s::navic_l5_count},
+    {GNSS_SIGNAL_BEIDOU_B2AQ, SIGNAL_ID_BDS_B2A, GNSS_SV_TYPE_UNKNOWN, nullptr}
+};
+#define SIGNAL_COUNT (sizeof(sSignals) / sizeof(sSignals[0]))
+
+// both tables are looked up by index, make sure the rows are where they belong
+static constexpr bool loc_nmea_constellations_in_order(uint32_t i)
+{
+    return (CONSTELLATION_COUNT == i) ||
+            ((uint32_t)sConstellations[i].svType == i && loc_nmea_constellations_in_order(i + 1));
+}
+static constexpr bool loc_nmea_signals_in_order(uint32_t i)
+{
+    return (SIGNAL_COUNT == i) ||
+            (sSignals[i].signalType == (1u << i) && loc_nmea_signals_in_order(i + 1));
+}
+static_assert(loc_nmea_constellations_in_order(0),
+        "sConstellations must be indexed by GnssSvType");
+static_assert(loc_nmea_signals_in_order(0),
+        "sSignals must be indexed by GnssSignalTypeMask bit");
+
 /*===========================================================================
-FUNCTION    convert_signalType_to_signalId
+FUNCTION    loc_nmea_constellation_of
 
 DESCRIPTION
-   convert signalType to signal ID
+   Look up the NMEA conventions of a constellation
 
 DEPENDENCIES
    NONE
 
 RETURN VALUE
-   value of signal ID
+   table entry, nullptr for an unknown constellation
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static uint32_t convert_signalType_to_signalId(GnssSignalTypeMask signalType)
+static inline const loc_nmea_constellation* loc_nmea_constellation_of(GnssSvType svType)
 {
-    uint32_t signalId = SIGNAL_ID_ALL_SIGNALS;
+    return ((uint32_t)svType < CONSTELLATION_COUNT) ? &sConstellations[svType] : nullptr;
+}
 
-    switch (signalType) {
-        case GNSS_SIGNAL_GPS_L1CA:
-        case GNSS_SIGNAL_SBAS_L1:
-            signalId = SIGNAL_ID_GPS_L1CA;
-            break;
-        case GNSS_SIGNAL_GPS_L2:
-            signalId = SIGNAL_ID_GPS_L2CL;
-            break;
-        case GNSS_SIGNAL_GPS_L5:
-            signalId = SIGNAL_ID_GPS_L5Q;
-            break;
-        case GNSS_SIGNAL_GLONASS_G1:
-            signalId = SIGNAL_ID_GLO_G1CA;
-            break;
-        case GNSS_SIGNAL_GLONASS_G2:
-            signalId = SIGNAL_ID_GLO_G2CA;
-            break;
-        case GNSS_SIGNAL_GALILEO_E1:
-            signalId = SIGNAL_ID_GAL_L1BC;
-            break;
-        case GNSS_SIGNAL_GALILEO_E5A:
-            signalId = SIGNAL_ID_GAL_E5A;
-            break;
-        case GNSS_SIGNAL_GALILEO_E5B:
-            signalId = SIGNAL_ID_GAL_E5B;
-            break;
-        case GNSS_SIGNAL_QZSS_L1CA:
-            signalId = SIGNAL_ID_QZSS_L1CA;
-            break;
-        case GNSS_SIGNAL_QZSS_L2:
-            signalId = SIGNAL_ID_QZSS_L2CL;
-            break;
-        case GNSS_SIGNAL_QZSS_L5:
-            signalId = SIGNAL_ID_QZSS_L5Q;
-            break;
-        case GNSS_SIGNAL_BEIDOU_B1I:
-            signalId = SIGNAL_ID_BDS_B1I;
-            break;
-        case GNSS_SIGNAL_BEIDOU_B1C:
-            signalId = SIGNAL_ID_BDS_B1C;
-            break;
-        case GNSS_SIGNAL_BEIDOU_B2I:
-            signalId = SIGNAL_ID_BDS_B2I;
-            break;
-        case GNSS_SIGNAL_BEIDOU_B2AI:
-        case GNSS_SIGNAL_BEIDOU_B2AQ:
-            signalId = SIGNAL_ID_BDS_B2A;
-            break;
-        case GNSS_SIGNAL_NAVIC_L5:
-            signalId = SIGNAL_ID_NAVIC_L5SPS;
-            break;
-        default:
-            signalId = SIGNAL_ID_ALL_SIGNALS;
+/*===========================================================================
+FUNCTION    loc_nmea_signal_of
+
+DESCRIPTION
+   Look up a single signal type
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   table entry, nullptr unless exactly one known signal type bit is set
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static inline const loc_nmea_signal* loc_nmea_signal_of(GnssSignalTypeMask signalType)
+{
+    if (0 == signalType || 0 != (signalType & (signalType - 1))) {
+        return nullptr;
     }
+    uint32_t bit = __builtin_ctz(signalType);
+    return (bit < SIGNAL_COUNT) ? &sSignals[bit] : nullptr;
+}
+
+/*===========================================================================
+FUNCTION    convert_signalType_to_signalId
+
+DESCRIPTION
+   convert signalType to signal ID
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   value of signal ID
 
-    return signalId;
+SIDE EFFECTS
+   N/A
 
+===========================================================================*/
+static inline uint32_t convert_signalType_to_signalId(GnssSignalTypeMask signalType)
+{
+    const loc_nmea_signal* signal = loc_nmea_signal_of(signalType);
+    return (nullptr != signal) ? signal->signalId : SIGNAL_ID_ALL_SIGNALS;
 }
 
 /*===========================================================================
@@ -369,19 +494,18 @@ SIDE EFFECTS
 ===========================================================================*/
 static uint32_t get_sv_count_from_mask(uint64_t svMask, int totalSvCount)
 {
-    int index = 0;
-    uint32_t svCount = 0;
-
     if(totalSvCount > MAX_SV_COUNT_SUPPORTED_IN_ONE_CONSTELLATION) {
         LOC_LOGE("total SV count in this constellation %d exceeded limit %d",
                  totalSvCount, MAX_SV_COUNT_SUPPORTED_IN_ONE_CONSTELLATION);
     }
-    for(index = 0; index < totalSvCount; index++) {
-        if(svMask & 0x1)
-            svCount += 1;
-        svMask >>= 1;
+    if (totalSvCount <= 0) {
+        return 0;
+    }
+    // only the lowest totalSvCount bits are SVs of this constellation
+    if (totalSvCount < MAX_SV_COUNT_SUPPORTED_IN_ONE_CONSTELLATION) {
+        svMask &= (1ULL << totalSvCount) - 1;
     }
-    return svCount;
+    return __builtin_popcountll(svMask);
 }
 
 /*===========================================================================
@@ -407,119 +531,28 @@ static loc_nmea_sv_meta* loc_nmea_sv_meta_init(loc_nmea_sv_meta& sv_meta,
                                                bool needCombine)
 {
     memset(&sv_meta, 0, sizeof(sv_meta));
-    sv_meta.svTypeMask = (1 << svType);
 
-    switch (svType)
-    {
-        case GNSS_SV_TYPE_GPS:
-            sv_meta.talker[0] = 'G';
-            sv_meta.talker[1] = 'P';
-            sv_meta.mask = sv_cache_info.gps_used_mask;
-            sv_meta.systemId = SYSTEM_ID_GPS;
-            sv_meta.svTypeMask |= (1 << GNSS_SV_TYPE_SBAS);
-            switch (signalType) {
-                case GNSS_SIGNAL_GPS_L1CA:
-                    sv_meta.svCount = sv_cache_info.gps_l1_count;
-                    break;
-                case GNSS_SIGNAL_GPS_L5:
-                    sv_meta.svCount = sv_cache_info.gps_l5_count;
-                    break;
-                case GNSS_SIGNAL_GPS_L2:
-                    sv_meta.svCount = sv_cache_info.gps_l2_count;
-                    break;
-            }
-            break;
-        case GNSS_SV_TYPE_GLONASS:
-            sv_meta.talker[0] = 'G';
-            sv_meta.talker[1] = 'L';
-            sv_meta.mask = sv_cache_info.glo_used_mask;
-            // GLONASS SV ids are from 65-96
-            sv_meta.svIdOffset = GLONASS_SV_ID_OFFSET;
-            sv_meta.systemId = SYSTEM_ID_GLONASS;
-            switch (signalType) {
-                case GNSS_SIGNAL_GLONASS_G1:
-                    sv_meta.svCount = sv_cache_info.glo_g1_count;
-                    break;
-                case GNSS_SIGNAL_GLONASS_G2:
-                    sv_meta.svCount = sv_cache_info.glo_g2_count;
-                    break;
-            }
-            break;
-        case GNSS_SV_TYPE_GALILEO:
-            sv_meta.talker[0] = 'G';
-            sv_meta.talker[1] = 'A';
-            sv_meta.mask = sv_cache_info.gal_used_mask;
-            // GALILEO SV ids are from 301-336, So keep svIdOffset 300
-            sv_meta.svIdOffset = GALILEO_SV_ID_OFFSET;
-            sv_meta.systemId = SYSTEM_ID_GALILEO;
-            switch (signalType) {
-                case GNSS_SIGNAL_GALILEO_E1:
-                    sv_meta.svCount = sv_cache_info.gal_e1_count;
-                    break;
-                case GNSS_SIGNAL_GALILEO_E5A:
-                    sv_meta.svCount = sv_cache_info.gal_e5_count;
-                    break;
-                case GNSS_SIGNAL_GALILEO_E5B:
-                    sv_meta.svCount = sv_cache_info.gal_e5b_count;
-                    break;
-            }
-            break;
-        case GNSS_SV_TYPE_QZSS:
-            sv_meta.talker[0] = 'G';
-            sv_meta.talker[1] = 'Q';
-            sv_meta.mask = sv_cache_info.qzss_used_mask;
-            // QZSS SV ids are from 193-199. So keep svIdOffset 192
-            sv_meta.svIdOffset = QZSS_SV_ID_OFFSET;
-            sv_meta.systemId = SYSTEM_ID_QZSS;
-            switch (signalType) {
-                case GNSS_SIGNAL_QZSS_L1CA:
-                    sv_meta.svCount = sv_cache_info.qzss_l1_count;
-                    break;
-                case GNSS_SIGNAL_QZSS_L2:
-                    sv_meta.svCount = sv_cache_info.qzss_l2_count;
-                    break;
-                case GNSS_SIGNAL_QZSS_L5:
-                    sv_meta.svCount = sv_cache_info.qzss_l5_count;
-                    break;
-            }
-            break;
-        case GNSS_SV_TYPE_BEIDOU:
-            sv_meta.talker[0] = 'G';
-            sv_meta.talker[1] = 'B';
-            sv_meta.mask = sv_cache_info.bds_used_mask;
-            // BDS SV ids are from 201-237. So keep svIdOffset 200
-            sv_meta.svIdOffset = BDS_SV_ID_OFFSET;
-            sv_meta.systemId = SYSTEM_ID_BDS;
-            switch (signalType) {
-                case GNSS_SIGNAL_BEIDOU_B1I:
-                    sv_meta.svCount = sv_cache_info.bds_b1i_count;
-                    break;
-                case GNSS_SIGNAL_BEIDOU_B1C:
-                    sv_meta.svCount = sv_cache_info.bds_b1c_count;
-                    break;
-                case GNSS_SIGNAL_BEIDOU_B2AI:
-                    sv_meta.svCount = sv_cache_info.bds_b2_count;
-                    break;
-            }
-            break;
-        case GNSS_SV_TYPE_NAVIC:
-            sv_meta.talker[0] = 'G';
-            sv_meta.talker[1] = 'I';
-            sv_meta.mask = sv_cache_info.navic_used_mask;
-            // NAVIC SV ids are from 401-414. So keep svIdOffset 400
-            sv_meta.svIdOffset = NAVIC_SV_ID_OFFSET;
-            sv_meta.systemId = SYSTEM_ID_NAVIC;
-            switch (signalType) {
-                case GNSS_SIGNAL_NAVIC_L5:
-                    sv_meta.svCount = sv_cache_info.navic_l5_count;
-                    break;
-            }
-            break;
-        default:
-            LOC_LOGE("NMEA Error unknow constellation type: %d", svType);
-            return NULL;
+    const loc_nmea_constellation* constellation = loc_nmea_constellation_of(svType);
+    if (nullptr == constellation || nullptr == constellation->talker) {
+        LOC_LOGE("NMEA Error unknow constellation type: %d", svType);
+        return NULL;
+    }
+    sv_meta.svTypeMask = constellation->svTypeMask;
+    sv_meta.talker[0] = constellation->talker[0];
+    sv_meta.talker[1] = constellation->talker[1];
+    sv_meta.mask = sv_cache_info.*(constellation->usedMask);
+    sv_meta.svIdOffset = constellation->svIdOffset;
+    sv_meta.systemId = constellation->systemId;
+
+    const loc_nmea_signal* signal = loc_nmea_signal_of(signalType);
+    if (nullptr != signal) {
+        sv_meta.signalId = signal->signalId;
+        if (svType == signal->svType) {
+            sv_meta.svCount = sv_cache_info.*(signal->svCount);
+        }
+    } else {
+        sv_meta.signalId = SIGNAL_ID_ALL_SIGNALS;
     }
-    sv_meta.signalId = convert_signalType_to_signalId(signalType);
     sv_meta.totalSvUsedCount =
             get_sv_count_from_mask(sv_cache_info.gps_used_mask,
                     GPS_SV_PRN_MAX - GPS_SV_PRN_MIN + 1) +
@@ -594,6 +627,242 @@ static int loc_nmea_put_checksum(char *pNmea, int maxSize, bool isTagBlock)
     return (length + checksumLength + 1);
 }
 
+/*===========================================================================
+CLASS       LocNmeaWriter
+
+DESCRIPTION
+   Appends the fields of one sentence to a buffer. Numbers are formatted by
+   hand instead of through snprintf, with output identical to the printf
+   formats they replace, and the checksum is accumulated while writing so
+   the sentence does not need a second pass. A LocNmeaField is a piece of
+   a sentence rendered once, with its checksum, and shared by several
+   sentences of the same fix.
+
+===========================================================================*/
+typedef struct loc_nmea_field_s
+{
+    char str[48];
+    int length;
+    uint8_t checksum;
+} LocNmeaField;
+
+class LocNmeaWriter
+{
+public:
+    inline LocNmeaWriter(char* buf, int bufSize) :
+            mBuf(buf), mBufSize(bufSize), mLength(0), mChecksum(0),
+            mOverflow(nullptr == buf || bufSize <= 0) {}
+
+    // "$<talker><type>,", the '$' is not part of the checksum
+    inline void begin(const char* talker, const char* type) {
+        putLead('$');
+        putStr(talker);
+        putStr(type);
+        putChar(',');
+    }
+    // the tag block's leading '\' is not part of its checksum either
+    inline void beginTagBlock() {
+        putLead('\\');
+    }
+    inline void putChar(char c) {
+        if (mLength + 1 < mBufSize) {
+            mBuf[mLength++] = c;
+            mChecksum ^= (uint8_t)c;
+        } else {
+            mOverflow = true;
+        }
+    }
+    inline void putStr(const char* str) {
+        while ('\0' != *str) {
+            putChar(*str++);
+        }
+    }
+    inline void put(const LocNmeaField& field) {
+        if (mLength + field.length < mBufSize) {
+            memcpy(mBuf + mLength, field.str, field.length);
+            mLength += field.length;
+            mChecksum ^= field.checksum;
+        } else {
+            mOverflow = true;
+        }
+    }
+    // "%0<width>d"
+    void putInt(int64_t value, int width = 0);
+    // "%0<width>.<decimals>f", decimals up to 6
+    void putFixed(double value, int decimals, int width = 0);
+    // "%0<degWidth>d%09.6f,<hemisphere>," of degrees and their minutes
+    void putDegMin(double degrees, int degWidth, char hemisphere);
+    // appends "*hh\r\n", or "*hh\" for a tag block, and NUL terminates
+    bool end(bool isTagBlock = false);
+    // keeps what was written so far as a field, without end()
+    bool saveAs(LocNmeaField& field);
+    inline int length() const { return mLength; }
+
+private:
+    inline void putLead(char c) {
+        putChar(c);
+        mChecksum = 0;
+    }
+    void putDigits(const char* digits, int count, bool negative, int width);
+
+    char* mBuf;
+    int mBufSize;
+    int mLength;
+    uint8_t mChecksum;
+    bool mOverflow;
+};
+
+// digits holds count characters in reverse order
+void LocNmeaWriter::putDigits(const char* digits, int count, bool negative, int width)
+{
+    if (negative) {
+        putChar('-');
+        width--;
+    }
+    for (; width > count; width--) {
+        putChar('0');
+    }
+    while (count > 0) {
+        putChar(digits[--count]);
+    }
+}
+
+void LocNmeaWriter::putInt(int64_t value, int width)
+{
+    char digits[24];
+    int count = 0;
+    uint64_t magnitude = (value < 0) ? (0 - (uint64_t)value) : (uint64_t)value;
+    do {
+        digits[count++] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    putDigits(digits, count, value < 0, width);
+}
+
+void LocNmeaWriter::putFixed(double value, int decimals, int width)
+{
+    static const double scales[] = {1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+    if (decimals < 0 || decimals > 6) {
+        mOverflow = true;
+        return;
+    }
+
+    double scaled = fabs(value) * scales[decimals];
+    double whole = floor(scaled);
+    double fraction = scaled - whole;
+    // printf rounds the exact binary value, ties to even. Below 1e9 the
+    // scaling is off by less than 1e-7, so only a fraction this close to
+    // one half may round differently here, leave those and non-finite or
+    // large values to snprintf.
+    if (!(scaled < 1e9) || fabs(fraction - 0.5) < 1e-6) {
+        char str[48];
+        int length = snprintf(str, sizeof(str), "%0*.*f", width, decimals, value);
+        if (length < 0 || length >= (int)sizeof(str)) {
+            mOverflow = true;
+        } else {
+            putStr(str);
+        }
+        return;
+    }
+
+    uint64_t units = (uint64_t)whole + ((fraction > 0.5) ? 1 : 0);
+    char digits[32];
+    int count = 0;
+    for (int i = 0; i < decimals; i++) {
+        digits[count++] = '0' + (units % 10);
+        units /= 10;
+    }
+    if (decimals > 0) {
+        digits[count++] = '.';
+    }
+    do {
+        digits[count++] = '0' + (units % 10);
+        units /= 10;
+    } while (units > 0);
+    putDigits(digits, count, signbit(value), width);
+}
+
+void LocNmeaWriter::putDegMin(double degrees, int degWidth, char hemisphere)
+{
+    putInt((uint8_t)floor(degrees), degWidth);
+    putFixed(fmod(degrees * 60.0, 60.0), 6, 9);
+    putChar(',');
+    putChar(hemisphere);
+    putChar(',');
+}
+
+bool LocNmeaWriter::end(bool isTagBlock)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    uint8_t checksum = mChecksum;
+    putChar('*');
+    putChar(hex[checksum >> 4]);
+    putChar(hex[checksum & 0xF]);
+    if (isTagBlock) {
+        putChar('\\');
+    } else {
+        putChar('\r');
+        putChar('\n');
+    }
+    if (mBufSize > 0 && nullptr != mBuf) {
+        mBuf[mLength] = '\0';
+    }
+    return !mOverflow;
+}
+
+bool LocNmeaWriter::saveAs(LocNmeaField& field)
+{
+    if (mOverflow || mBuf != field.str) {
+        return false;
+    }
+    field.length = mLength;
+    field.checksum = mChecksum;
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_blank_pos_sentences
+
+DESCRIPTION
+   Position sentences that do not depend on the fix, with their checksum
+   put once: the blank GSA, VTG, DTM, RMC, GNS and GGA sent for non-final
+   fixes. The GSA is also the one sent when no SV was used.
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   The sentences with their type, in that order
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+typedef std::vector<std::pair<NmeaSentenceTypesMask, std::string>> LocNmeaBlankSentences;
+
+static const LocNmeaBlankSentences& loc_nmea_blank_pos_sentences()
+{
+    static const LocNmeaBlankSentences sentences = [] {
+        static const std::pair<NmeaSentenceTypesMask, const char*> blank[] = {
+            {LOC_NMEA_MASK_GSA_V02,   "$GPGSA,A,1,,,,,,,,,,,,,,,,"},
+            {LOC_NMEA_MASK_VTG_V02,   "$GPVTG,,T,,M,,N,,K,N"},
+            {LOC_NMEA_MASK_GPDTM_V02, "$GPDTM,,,,,,,,"},
+            {LOC_NMEA_MASK_RMC_V02,   "$GPRMC,,V,,,,,,,,,,N,V"},
+            {LOC_NMEA_MASK_GNGNS_V02, "$GPGNS,,,,,,N,,,,,,,V"},
+            {LOC_NMEA_MASK_GGA_V02,   "$GPGGA,,,,,,0,,,,,,,,"}
+        };
+        LocNmeaBlankSentences v;
+        char sentence[NMEA_SENTENCE_MAX_LENGTH];
+        for (const auto& each : blank) {
+            strlcpy(sentence, each.second, sizeof(sentence));
+            int length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
+            v.emplace_back(each.first, std::string(sentence, length));
+        }
+        return v;
+    }();
+    return sentences;
+}
+
 /*===========================================================================
 FUNCTION    loc_nmea_generate_GSA
 
@@ -608,6 +877,8 @@ DESCRIPTION
 DEPENDENCIES
    NONE
 
+   No sentence is generated when formatSentences is false.
+
 RETURN VALUE
    Number of SVs used
 
@@ -620,7 +891,8 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
                               std::vector<std::string> &nmeaArraystr,
-                              bool isTagBlockGroupingEnabled)
+                              bool isTagBlockGroupingEnabled,
+                              bool formatSentences)
 {
     if (!sentence || bufSize <= 0 || !sv_meta_p)
     {
@@ -628,11 +900,6 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         return 0;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
-    int lengthTagBlock = 0;
-
     uint32_t svUsedCount = 0;
     uint32_t svUsedList[64] = {0};
     uint32_t sentenceCount = 0;
@@ -650,32 +917,34 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         svIdOffset = 0;
     }
 
-    for (uint8_t i = 1; mask > 0 && svUsedCount < 64; i++)
+    // bit n of the mask is SV n + 1, visit only the set bits
+    for (; mask > 0 && svUsedCount < 64; mask &= mask - 1)
     {
-        if (mask & 1)
-            svUsedList[svUsedCount++] = i + svIdOffset;
-        mask = mask >> 1;
+        svUsedList[svUsedCount++] = __builtin_ctzll(mask) + 1 + svIdOffset;
     }
 
-    if (svUsedCount == 0) {
-        return 0;
+    if (svUsedCount == 0 || !formatSentences) {
+        // nobody wants GSA, callers still need the count
+        return svUsedCount;
     } else {
         sentenceNumber = 1;
         sentenceCount = svUsedCount / 12 + (svUsedCount % 12 != 0);
         svNumber = 1;
     }
     while (sentenceNumber <= sentenceCount) {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
+        LocNmeaWriter gsa(sentence, bufSize);
         if (svUsedCount > 12 && isTagBlockGroupingEnabled) {
-            lengthTagBlock = snprintf(pMarker, lengthRemaining, "\\g:%d-%d-%d", sentenceNumber,
-                     sentenceCount, code);
+            gsa.beginTagBlock();
+            gsa.putStr("g:");
+            gsa.putInt(sentenceNumber);
+            gsa.putChar('-');
+            gsa.putInt(sentenceCount);
+            gsa.putChar('-');
+            gsa.putInt(code);
             if (MAX_TAG_BLOCK_GROUP_CODE == code) {
                 code = 1;
             }
-            lengthTagBlock = loc_nmea_put_checksum(sentence, bufSize, true);
-            pMarker += lengthTagBlock;
-            lengthRemaining -= lengthTagBlock;
+            gsa.end(true);
         }
         if (sv_meta_p->totalSvUsedCount == 0)
             fixType = '1'; // no fix
@@ -694,53 +963,43 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         // v.v : Vertical DOP
         // s : GNSS System Id
         // cc : Checksum value
-        length = snprintf(pMarker, lengthRemaining, "$%sGSA,A,%c,", talker, fixType);
-        if (length < 0 || length >= lengthRemaining) {
-            LOC_LOGE("NMEA Error in string formatting");
-            return 0;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        gsa.begin(talker, "GSA");
+        gsa.putStr("A,");
+        gsa.putChar(fixType);
+        gsa.putChar(',');
 
         // Add 12 satellite IDs
         for (uint8_t i = 0; i < 12; i++, svNumber++)
         {
             if (svNumber <= svUsedCount)
-                length = snprintf(pMarker, lengthRemaining, "%02d,", svUsedList[svNumber - 1]);
-            else
-                length = snprintf(pMarker, lengthRemaining, ",");
-
-            if (length < 0 || length >= lengthRemaining) {
-                LOC_LOGE("NMEA Error in string formatting");
-                return 0;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+                gsa.putInt(svUsedList[svNumber - 1], 2);
+            gsa.putChar(',');
         }
 
         // Add the position/horizontal/vertical DOP values
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,%.1f,%.1f,",
-                    locationExtended.pdop,
-                    locationExtended.hdop,
-                    locationExtended.vdop);
+            gsa.putFixed(locationExtended.pdop, 1);
+            gsa.putChar(',');
+            gsa.putFixed(locationExtended.hdop, 1);
+            gsa.putChar(',');
+            gsa.putFixed(locationExtended.vdop, 1);
+            gsa.putChar(',');
         }
         else
         {   // no dop
-            length = snprintf(pMarker, lengthRemaining, ",,,");
+            gsa.putStr(",,,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         // system id
-        length = snprintf(pMarker, lengthRemaining, "%d", sv_meta_p->systemId);
-        pMarker += length;
-        lengthRemaining -= length;
+        gsa.putInt(sv_meta_p->systemId);
 
         /* Sentence is ready, add checksum and broadcast */
-        length = loc_nmea_put_checksum(sentence + lengthTagBlock, bufSize - lengthTagBlock, false);
-        nmeaArraystr.push_back(sentence);
+        if (!gsa.end()) {
+            LOC_LOGE("NMEA Error in string formatting");
+            return 0;
+        }
+        nmeaArraystr.emplace_back(sentence, gsa.length());
         sentenceNumber++;
         if (!isTagBlockGroupingEnabled) {
             break;
@@ -752,6 +1011,61 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
     return svUsedCount;
 }
 
+// One GSV group per talker and signal, in the order they are reported.
+// The first group of a constellation also counts the SVs whose signal
+// type has no group of its own, SBAS SVs are reported along with GPS.
+typedef struct loc_nmea_gsv_group_s
+{
+    GnssSvType svType;
+    GnssSignalTypeMask signalType;
+} loc_nmea_gsv_group;
+
+static constexpr loc_nmea_gsv_group sGsvGroups[] = {
+    {GNSS_SV_TYPE_GPS,     GNSS_SIGNAL_GPS_L1CA},
+    {GNSS_SV_TYPE_GPS,     GNSS_SIGNAL_GPS_L5},
+    {GNSS_SV_TYPE_GPS,     GNSS_SIGNAL_GPS_L2},
+    {GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G1},
+    {GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G2},
+    {GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E1},
+    {GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5A},
+    {GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5B},
+    {GNSS_SV_TYPE_QZSS,    GNSS_SIGNAL_QZSS_L1CA},
+    {GNSS_SV_TYPE_QZSS,    GNSS_SIGNAL_QZSS_L5},
+    {GNSS_SV_TYPE_QZSS,    GNSS_SIGNAL_QZSS_L2},
+    {GNSS_SV_TYPE_BEIDOU,  GNSS_SIGNAL_BEIDOU_B1I},
+    {GNSS_SV_TYPE_BEIDOU,  GNSS_SIGNAL_BEIDOU_B1C},
+    {GNSS_SV_TYPE_BEIDOU,  GNSS_SIGNAL_BEIDOU_B2AI},
+    {GNSS_SV_TYPE_NAVIC,   GNSS_SIGNAL_NAVIC_L5}
+};
+#define GSV_GROUP_COUNT (sizeof(sGsvGroups) / sizeof(sGsvGroups[0]))
+
+// the groups of every sConstellations row are its own, SBAS shares those of GPS
+static constexpr GnssSvType loc_nmea_gsv_owner(GnssSvType svType)
+{
+    return (GNSS_SV_TYPE_SBAS == svType) ? GNSS_SV_TYPE_GPS : svType;
+}
+static constexpr bool loc_nmea_gsv_groups_valid(uint32_t i, uint32_t n)
+{
+    return (CONSTELLATION_COUNT == i) ||
+            ((sConstellations[i].gsvGroupCount == n) ? loc_nmea_gsv_groups_valid(i + 1, 0) :
+             (sConstellations[i].firstGsvGroup + n < GSV_GROUP_COUNT &&
+              sGsvGroups[sConstellations[i].firstGsvGroup + n].svType ==
+                      loc_nmea_gsv_owner(sConstellations[i].svType) &&
+              loc_nmea_gsv_groups_valid(i, n + 1)));
+}
+static_assert(loc_nmea_gsv_groups_valid(0, 0),
+        "sConstellations GSV groups must match sGsvGroups");
+
+// SVs of every GSV group as indexes into GnssSvNotification::gnssSvs,
+// in report order. svCount is what the sentences announce, the SVs listed
+// are those whose signal ID matches the group.
+typedef struct loc_nmea_gsv_svs_s
+{
+    uint32_t svCount[GSV_GROUP_COUNT];
+    uint32_t listedCount[GSV_GROUP_COUNT];
+    uint8_t listed[GSV_GROUP_COUNT][GNSS_SV_MAX];
+} loc_nmea_gsv_svs;
+
 /*===========================================================================
 FUNCTION    loc_nmea_generate_GSV
 
@@ -762,6 +1076,8 @@ DESCRIPTION
    - $GLGSV: GLONASS Satellites in View
    - $GAGSV: GALILEO Satellites in View
 
+   svIndexes lists the SVs of this group, 4 go into each sentence.
+
 DEPENDENCIES
    NONE
 
@@ -773,9 +1089,11 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
+                              const uint8_t* svIndexes,
+                              uint32_t svIndexCount,
                               char* sentence,
                               int bufSize,
-                              loc_nmea_sv_meta* sv_meta_p,
+                              const loc_nmea_sv_meta* sv_meta_p,
                               std::vector<std::string> &nmeaArraystr)
 {
     if (!sentence || bufSize <= 0)
@@ -784,15 +1102,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         return;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
-    int sentenceCount = 0;
-    int sentenceNumber = 1;
-    size_t svNumber = 1;
-
     const char* talker = sv_meta_p->talker;
-    uint32_t svIdOffset = sv_meta_p->svIdOffset;
     int svCount = sv_meta_p->svCount;
     if (svCount <= 0)
     {
@@ -800,118 +1110,55 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         return;
     }
 
-    if ((1 << GNSS_SV_TYPE_GLONASS) & sv_meta_p->svTypeMask) {
-        svIdOffset = 0;
-    }
-    svNumber = 1;
-    sentenceNumber = 1;
-    sentenceCount = svCount / 4 + (svCount % 4 != 0);
+    // GLONASS SVs keep their 65-96 IDs in GSV
+    bool isGlonass = (0 != ((1 << GNSS_SV_TYPE_GLONASS) & sv_meta_p->svTypeMask));
+    uint32_t svNumber = 0;
+    int sentenceCount = svCount / 4 + (svCount % 4 != 0);
 
-    while (sentenceNumber <= sentenceCount)
+    for (int sentenceNumber = 1; sentenceNumber <= sentenceCount; sentenceNumber++)
     {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
+        LocNmeaWriter gsv(sentence, bufSize);
+        gsv.begin(talker, "GSV");
+        gsv.putInt(sentenceCount);
+        gsv.putChar(',');
+        gsv.putInt(sentenceNumber);
+        gsv.putChar(',');
+        gsv.putInt(svCount, 2);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGSV,%d,%d,%02d",
-                talker, sentenceCount, sentenceNumber, svCount);
-
-        if (length < 0 || length >= lengthRemaining)
+        for (int i = 0; svNumber < svIndexCount && i < 4; i++, svNumber++)
         {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            const GnssSv& sv = svNotify.gnssSvs[svIndexes[svNumber]];
 
-        for (int i=0; (svNumber <= svNotify.count) && (i < 4);  svNumber++)
-        {
-            GnssSignalTypeMask signalType = svNotify.gnssSvs[svNumber-1].gnssSignalTypeMask;
-            if (0 == signalType) {
-                // If no signal type in report, it means default L1,G1,E1,B1I
-                switch (svNotify.gnssSvs[svNumber - 1].type)
-                {
-                    case GNSS_SV_TYPE_GPS:
-                        signalType = GNSS_SIGNAL_GPS_L1CA;
-                        break;
-                    case GNSS_SV_TYPE_GLONASS:
-                        signalType = GNSS_SIGNAL_GLONASS_G1;
-                        break;
-                    case GNSS_SV_TYPE_GALILEO:
-                        signalType = GNSS_SIGNAL_GALILEO_E1;
-                        break;
-                    case GNSS_SV_TYPE_QZSS:
-                        signalType = GNSS_SIGNAL_QZSS_L1CA;
-                        break;
-                    case GNSS_SV_TYPE_BEIDOU:
-                        signalType = GNSS_SIGNAL_BEIDOU_B1I;
-                        break;
-                    case GNSS_SV_TYPE_SBAS:
-                        signalType = GNSS_SIGNAL_SBAS_L1;
-                        break;
-                    case GNSS_SV_TYPE_NAVIC:
-                        signalType = GNSS_SIGNAL_NAVIC_L5;
-                        break;
-                    default:
-                        LOC_LOGE("NMEA Error unknow constellation type: %d",
-                                svNotify.gnssSvs[svNumber - 1].type);
-                        continue;
-                }
+            gsv.putChar(',');
+            if (GNSS_SV_TYPE_GLONASS == sv.type && GLO_SV_PRN_SLOT_UNKNOWN == sv.svId) {
+                gsv.putChar(',');
+            } else {
+                // SBAS SVs come with GPS but have an offset of their own
+                uint32_t offset = isGlonass ? 0 : sConstellations[sv.type].svIdOffset;
+                gsv.putInt((int)(sv.svId - offset), 2);
+                gsv.putChar(',');
             }
-
-            if ((sv_meta_p->svTypeMask & (1 << svNotify.gnssSvs[svNumber - 1].type)) &&
-                    sv_meta_p->signalId == convert_signalType_to_signalId(signalType))
+            gsv.putInt((int)(0.5 + sv.elevation), 2); //float to int
+            gsv.putChar(',');
+            gsv.putInt((int)(0.5 + sv.azimuth), 3); //float to int
+            gsv.putChar(',');
+            if (sv.cN0Dbhz > 0)
             {
-                if (GNSS_SV_TYPE_SBAS == svNotify.gnssSvs[svNumber - 1].type) {
-                    svIdOffset = SBAS_SV_ID_OFFSET;
-                }
-                if (GNSS_SV_TYPE_GLONASS == svNotify.gnssSvs[svNumber - 1].type &&
-                    GLO_SV_PRN_SLOT_UNKNOWN == svNotify.gnssSvs[svNumber - 1].svId) {
-                    length = snprintf(pMarker, lengthRemaining, ",,%02d,%03d,",
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-                } else {
-                    length = snprintf(pMarker, lengthRemaining, ",%02d,%02d,%03d,",
-                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset,
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-                }
-                if (length < 0 || length >= lengthRemaining)
-                {
-                    LOC_LOGE("NMEA Error in string formatting");
-                    return;
-                }
-                pMarker += length;
-                lengthRemaining -= length;
-
-                if (svNotify.gnssSvs[svNumber - 1].cN0Dbhz > 0)
-                {
-                    length = snprintf(pMarker, lengthRemaining,"%02d",
-                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz)); //float to int
-
-                    if (length < 0 || length >= lengthRemaining)
-                    {
-                        LOC_LOGE("NMEA Error in string formatting");
-                        return;
-                    }
-                    pMarker += length;
-                    lengthRemaining -= length;
-                }
-
-                i++;
+                gsv.putInt((int)(0.5 + sv.cN0Dbhz), 2); //float to int
             }
-
         }
 
-        // append signalId
-        length = snprintf(pMarker, lengthRemaining,",%X",sv_meta_p->signalId);
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = loc_nmea_put_checksum(sentence, bufSize, false);
-        nmeaArraystr.push_back(sentence);
-        sentenceNumber++;
+        // append signalId, NMEA signal IDs are a single hex digit
+        static const char hex[] = "0123456789ABCDEF";
+        gsv.putChar(',');
+        gsv.putChar(hex[sv_meta_p->signalId & 0xF]);
 
-    }  //while
+        if (!gsv.end()) {
+            LOC_LOGE("NMEA Error in string formatting");
+            return;
+        }
+        nmeaArraystr.emplace_back(sentence, gsv.length());
+    }
 }
 
 /*===========================================================================
@@ -936,15 +1183,11 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
                                   char *sentence,
                                   int bufSize)
 {
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
     int datum_type;
     char ref_datum[4] = {0};
     char local_datum[4] = {0};
     double lla_offset[3] = {0};
     char latHem, longHem;
-    double latMins, longMins;
 
 
 
@@ -969,13 +1212,10 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         default:
             break;
     }
-    length = snprintf(pMarker , lengthRemaining , "$%sDTM,%s,," , talker, local_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
+    LocNmeaWriter dtm(sentence, bufSize);
+    dtm.begin(talker, "DTM");
+    dtm.putStr(local_datum);
+    dtm.putStr(",,");
 
     lla_offset[0] = local_lla.lat - ref_lla.lat;
     lla_offset[1] = fmod(local_lla.lon - ref_lla.lon, 360.0);
@@ -991,32 +1231,21 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         latHem = 'S';
         lla_offset[0] *= -1.0;
     }
-    latMins = fmod(lla_offset[0] * 60.0, 60.0);
     if (lla_offset[1] < 0.0) {
         longHem = 'W';
         lla_offset[1] *= -1.0;
     }else {
         longHem = 'E';
     }
-    longMins = fmod(lla_offset[1] * 60.0, 60.0);
-    length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,",
-                     (uint8_t)floor(lla_offset[0]), latMins, latHem,
-                     (uint8_t)floor(lla_offset[1]), longMins, longHem, lla_offset[2]);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
-    length = snprintf(pMarker , lengthRemaining , "%s" , ref_datum);
-    if (length < 0 || length >= lengthRemaining) {
+    dtm.putDegMin(lla_offset[0], 2, latHem);
+    dtm.putDegMin(lla_offset[1], 3, longHem);
+    dtm.putFixed(lla_offset[2], 3);
+    dtm.putChar(',');
+    dtm.putStr(ref_datum);
+
+    if (!dtm.end()) {
         LOC_LOGE("NMEA Error in string formatting");
-        return;
     }
-    pMarker += length;
-    lengthRemaining -= length;
-
-    length = loc_nmea_put_checksum(sentence, bufSize, false);
 }
 
 /*===========================================================================
@@ -1065,29 +1294,43 @@ static bool get_utctime_with_leapsecond_transition(
         const GnssSystemTimeStructType &gpsTimestampLsChange =
             leapSecondChangeInfo.gpsTimestampLsChange;
 
-        uint64_t gpsTimeLsChange = gpsTimestampLsChange.systemWeek * MSEC_IN_ONE_WEEK +
-                                   gpsTimestampLsChange.systemMsec;
+        // the change info is the same from one fix to the next for months,
+        // what follows from it is only worked out again when it changes
+        static thread_local loc_nmea_leap_second lastChange = {};
+        if (!lastChange.valid ||
+            lastChange.systemWeek != gpsTimestampLsChange.systemWeek ||
+            lastChange.systemMsec != gpsTimestampLsChange.systemMsec ||
+            lastChange.leapSecondsBeforeChange != leapSecondChangeInfo.leapSecondsBeforeChange ||
+            lastChange.leapSecondsAfterChange != leapSecondChangeInfo.leapSecondsAfterChange) {
+            lastChange.valid = true;
+            lastChange.systemWeek = gpsTimestampLsChange.systemWeek;
+            lastChange.systemMsec = gpsTimestampLsChange.systemMsec;
+            lastChange.leapSecondsBeforeChange = leapSecondChangeInfo.leapSecondsBeforeChange;
+            lastChange.leapSecondsAfterChange = leapSecondChangeInfo.leapSecondsAfterChange;
+            lastChange.gpsTimeLsChange =
+                    (uint64_t)gpsTimestampLsChange.systemWeek * MSEC_IN_ONE_WEEK +
+                    gpsTimestampLsChange.systemMsec;
+            // we substract 1000 milli-seconds from UTC timestmap in order to calculate the
+            // proper year, month and date during leap second transtion.
+            // Let us give an example, assuming leap second transition is scheduled on 2019,
+            // Dec 31st mid night. When leap second transition is happening,
+            // instead of outputting the time as 2020, Jan, 1st, 00 hour, 00 min, and 00 sec.
+            // The time need to be displayed as 2019, Dec, 31st, 23 hour, 59 min and 60 sec.
+            lastChange.utcTimeInTransition = lastChange.gpsTimeLsChange + UTC_GPS_OFFSET_MSECS -
+                    leapSecondChangeInfo.leapSecondsBeforeChange * 1000 - 1000;
+        }
+
         uint64_t gpsTimePosReport = locationExtended.gpsTime.gpsWeek * MSEC_IN_ONE_WEEK +
                                     locationExtended.gpsTime.gpsTimeOfWeekMs;
         // we are only dealing with positive leap second change, as negative
         // leap second change has never occurred and should not occur in future
-        if (leapSecondChangeInfo.leapSecondsAfterChange >
-            leapSecondChangeInfo.leapSecondsBeforeChange) {
+        if (lastChange.leapSecondsAfterChange > lastChange.leapSecondsBeforeChange) {
             // leap second adjustment is always 1 second at a time. It can happen
             // every quarter end and up to four times per year.
-            if ((gpsTimePosReport >= gpsTimeLsChange) &&
-                (gpsTimePosReport < (gpsTimeLsChange + 1000))) {
+            if ((gpsTimePosReport >= lastChange.gpsTimeLsChange) &&
+                (gpsTimePosReport < (lastChange.gpsTimeLsChange + 1000))) {
                 inTransition = true;
-                utcPosTimestamp = gpsTimeLsChange + UTC_GPS_OFFSET_MSECS -
-                                  leapSecondChangeInfo.leapSecondsBeforeChange * 1000;
-
-                // we substract 1000 milli-seconds from UTC timestmap in order to calculate the
-                // proper year, month and date during leap second transtion.
-                // Let us give an example, assuming leap second transition is scheduled on 2019,
-                // Dec 31st mid night. When leap second transition is happening,
-                // instead of outputting the time as 2020, Jan, 1st, 00 hour, 00 min, and 00 sec.
-                // The time need to be displayed as 2019, Dec, 31st, 23 hour, 59 min and 60 sec.
-                utcPosTimestamp -= 1000;
+                utcPosTimestamp = lastChange.utcTimeInTransition;
             }
         }
     }
@@ -1095,17 +1338,61 @@ static bool get_utctime_with_leapsecond_transition(
 }
 
 /*===========================================================================
-FUNCTION    loc_nmea_get_fix_quality
+FUNCTION    loc_nmea_utc_time
 
 DESCRIPTION
-   This function obtains the fix quality for GGA sentence, mode indicator
-   for RMC and VTG sentence based on nav solution mask and tech mask in
-   the postion report.
+   Breaks a UTC timestamp down into date and time of day. gmtime_r is only
+   called when the day changes, the time of day of the fixes in between is
+   derived from the date kept for the day.
 
 DEPENDENCIES
    NONE
 
-Output parameter
+RETURN VALUE
+   false if the timestamp could not be converted
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static bool loc_nmea_utc_time(LocGpsUtcTime utcTimestamp, loc_nmea_utc& utc)
+{
+    static thread_local loc_nmea_utc lastDay = {-1, 0, 0, 0, 0, 0, 0};
+
+    int64_t utcSec = (int64_t)(utcTimestamp / 1000);
+    int64_t day = utcSec / SEC_IN_ONE_DAY;
+    if (day != lastDay.day) {
+        time_t dayStart(day * SEC_IN_ONE_DAY);
+        struct tm result;
+        if (NULL == gmtime_r(&dayStart, &result)) {
+            return false;
+        }
+        lastDay.day = day;
+        lastDay.year = result.tm_year % 100; // 2 digit year
+        lastDay.month = result.tm_mon + 1; // tm_mon starts at zero
+        lastDay.mday = result.tm_mday;
+    }
+
+    int secOfDay = (int)(utcSec - day * SEC_IN_ONE_DAY);
+    utc = lastDay;
+    utc.hours = secOfDay / 3600;
+    utc.minutes = (secOfDay / 60) % 60;
+    utc.seconds = secOfDay % 60;
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_get_fix_quality
+
+DESCRIPTION
+   This function obtains the fix quality for GGA sentence, mode indicator
+   for RMC and VTG sentence based on nav solution mask and tech mask in
+   the postion report.
+
+DEPENDENCIES
+   NONE
+
+Output parameter
    ggaGpsQuality: gps quality field in GGA sentence
    rmcModeIndicator: mode indicator field in RMC sentence
    vtgModeIndicator: mode indicator field in VTG sentence
@@ -1333,7 +1620,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                bool custom_gga_fix_quality,
                                std::vector<std::string> &nmeaArraystr,
                                int& indexOfGGA,
-                               bool isTagBlockGroupingEnabled)
+                               bool isTagBlockGroupingEnabled,
+                               NmeaSentenceTypesMask typesMask)
 {
     ENTRY_LOG();
 
@@ -1344,10 +1632,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
     inLsTransition = get_utctime_with_leapsecond_transition
                     (location, locationExtended, systemInfo, utcPosTimestamp);
 
-    time_t utcTime(utcPosTimestamp/1000);
-    struct tm result;
-    tm * pTm = gmtime_r(&utcTime, &result);
-    if (NULL == pTm) {
+    loc_nmea_utc utc;
+    if (!loc_nmea_utc_time(utcPosTimestamp, utc)) {
         LOC_LOGE("gmtime failed");
         return;
     }
@@ -1357,15 +1643,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
     char sentence_RMC[NMEA_SENTENCE_MAX_LENGTH] = {0};
     char sentence_GNS[NMEA_SENTENCE_MAX_LENGTH] = {0};
     char sentence_GGA[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
-    int length = 0;
-    int utcYear = pTm->tm_year % 100; // 2 digit year
-    int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
-    int utcDay = pTm->tm_mday;
-    int utcHours = pTm->tm_hour;
-    int utcMinutes = pTm->tm_min;
-    int utcSeconds = pTm->tm_sec;
+    int utcYear = utc.year;
+    int utcMonth = utc.month;
+    int utcDay = utc.mday;
+    int utcHours = utc.hours;
+    int utcMinutes = utc.minutes;
+    int utcSeconds = utc.seconds;
     int utcMSeconds = (location.gpsLocation.timestamp)%1000;
     int datum_type = loc_get_datum_type();
     LocEcef ecef_w84;
@@ -1403,6 +1686,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 locationExtended.gnss_sv_used_ids.navic_sv_used_ids_mask;
     }
 
+    bool generateGSA = (0 != (typesMask & LOC_NMEA_MASK_GSA_V02));
+    bool generateVTG = (0 != (typesMask & LOC_NMEA_MASK_VTG_V02));
+    bool generateDTM = (0 != (typesMask & LOC_NMEA_MASK_GPDTM_V02));
+    bool generateRMC = (0 != (typesMask & LOC_NMEA_MASK_RMC_V02));
+    bool generateGNS = (0 != (typesMask & LOC_NMEA_MASK_GNGNS_V02));
+    bool generateGGA = (0 != (typesMask & LOC_NMEA_MASK_GGA_V02));
+
     if (generate_nmea) {
         char talker[3] = {'G', 'P', '\0'};
         uint32_t svUsedCount = 0;
@@ -1414,7 +1704,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        generateGSA);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1428,7 +1719,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        generateGSA);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1442,7 +1734,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        generateGSA);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1455,7 +1748,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        generateGSA);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1469,7 +1763,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled,
+                        generateGSA);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1479,10 +1774,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         // if svUsedCount is 0, it means we do not generate any GSA sentence yet.
         // in this case, generate an empty GSA sentence
-        if (svUsedCount == 0) {
-            strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-            nmeaArraystr.push_back(sentence);
+        if (svUsedCount == 0 && generateGSA) {
+            nmeaArraystr.push_back(loc_nmea_blank_pos_sentences()[0].second);
         }
 
         char ggaGpsQuality[3] = {'0', '\0', '\0'};
@@ -1496,60 +1789,56 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
-        pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        if (generateVTG) {
+            LocNmeaWriter vtg(sentence, sizeof(sentence));
+            vtg.begin(talker, "VTG");
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
-        {
-            float magTrack = location.gpsLocation.bearing;
-            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
             {
-                magTrack = location.gpsLocation.bearing - locationExtended.magneticDeviation;
-                if (magTrack < 0.0)
-                    magTrack += 360.0;
-                else if (magTrack > 360.0)
-                    magTrack -= 360.0;
-            }
+                float magTrack = location.gpsLocation.bearing;
+                if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
+                {
+                    magTrack = location.gpsLocation.bearing - locationExtended.magneticDeviation;
+                    if (magTrack < 0.0)
+                        magTrack += 360.0;
+                    else if (magTrack > 360.0)
+                        magTrack -= 360.0;
+                }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
-        }
+                vtg.putFixed(location.gpsLocation.bearing, 1);
+                vtg.putStr(",T,");
+                vtg.putFixed(magTrack, 1);
+                vtg.putStr(",M,");
+            }
+            else
+            {
+                vtg.putStr(",T,,M,");
+            }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
+            {
+                float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
+                float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
-        {
-            float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            float speedKmPerHour = location.gpsLocation.speed * 3.6;
+                vtg.putFixed(speedKnots, 1);
+                vtg.putStr(",N,");
+                vtg.putFixed(speedKmPerHour, 1);
+                vtg.putStr(",K,");
+            }
+            else
+            {
+                vtg.putStr(",N,,K,");
+            }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",N,,K,");
-        }
+            vtg.putChar(vtgModeIndicator);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            if (!vtg.end())
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            nmeaArraystr.emplace_back(sentence, vtg.length());
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
-
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
 
         memset(&ecef_w84, 0, sizeof(ecef_w84));
         memset(&ecef_p90, 0, sizeof(ecef_p90));
@@ -1561,9 +1850,25 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         lla_w84.lon = location.gpsLocation.longitude / 180.0 * M_PI;
         lla_w84.alt = location.gpsLocation.altitude;
 
-        convert_Lla_to_Ecef(lla_w84, ecef_w84);
-        convert_WGS84_to_PZ90(ecef_w84, ecef_p90);
-        convert_Ecef_to_Lla(ecef_p90, lla_p90);
+        // with the WGS84 datum, PZ90 is only needed for the DTM offsets.
+        // The PZ90 position only depends on the WGS84 one, so a receiver
+        // that is standing still skips the transform
+        static thread_local LocLla lastLlaW84 = {};
+        static thread_local LocLla lastLlaP90 = {};
+        static thread_local bool lastLlaValid = false;
+        if (!generateDTM && LOC_GNSS_DATUM_PZ90 != datum_type) {
+            // lla_p90 stays zero, local_lla is unused
+        } else if (lastLlaValid && lastLlaW84.lat == lla_w84.lat &&
+                lastLlaW84.lon == lla_w84.lon && lastLlaW84.alt == lla_w84.alt) {
+            lla_p90 = lastLlaP90;
+        } else {
+            convert_Lla_to_Ecef(lla_w84, ecef_w84);
+            convert_WGS84_to_PZ90(ecef_w84, ecef_p90);
+            convert_Ecef_to_Lla(ecef_p90, lla_p90);
+            lastLlaW84 = lla_w84;
+            lastLlaP90 = lla_p90;
+            lastLlaValid = true;
+        }
 
         switch (datum_type) {
             case LOC_GNSS_DATUM_WGS84:
@@ -1589,45 +1894,37 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // -------------------
         // ------$--DTM-------
         // -------------------
-        loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM, sizeof(sentence_DTM));
-
-        // -------------------
-        // ------$--RMC-------
-        // -------------------
-
-        pMarker = sentence_RMC;
-        lengthRemaining = sizeof(sentence_RMC);
-
-        bool validFix = ((0 != sv_cache_info.gps_used_mask) ||
-                (0 != sv_cache_info.glo_used_mask) ||
-                (0 != sv_cache_info.gal_used_mask) ||
-                (0 != sv_cache_info.qzss_used_mask) ||
-                (0 != sv_cache_info.bds_used_mask));
-
-        if (validFix) {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        } else {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,V,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+        if (generateDTM) {
+            loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM, sizeof(sentence_DTM));
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
+        if (!generateRMC && !generateGNS && !generateGGA) {
+            if (generateDTM) {
+                nmeaArraystr.push_back(sentence_DTM);
+            }
+            EXIT_LOG(%d, 0);
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
+        // the time and position fields are the same in RMC, GNS and GGA,
+        // render them once
+        LocNmeaField utcTimeField;
+        LocNmeaWriter utcTime(utcTimeField.str, sizeof(utcTimeField.str));
+        utcTime.putInt(utcHours, 2);
+        utcTime.putInt(utcMinutes, 2);
+        utcTime.putInt(utcSeconds, 2);
+        utcTime.putChar('.');
+        utcTime.putInt(utcMSeconds/10, 2);
+        utcTime.putChar(',');
+
+        LocNmeaField latLonField;
+        LocNmeaWriter latLon(latLonField.str, sizeof(latLonField.str));
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
         {
             double latitude = ref_lla.lat;
             double longitude = ref_lla.lon;
             char latHemisphere;
             char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
 
             if (latitude > 0)
             {
@@ -1649,473 +1946,238 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 lonHemisphere = 'E';
             }
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            latLon.putDegMin(latitude, 2, latHemisphere);
+            latLon.putDegMin(longitude, 3, lonHemisphere);
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
+            latLon.putStr(",,,,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
+        if (!utcTime.saveAs(utcTimeField) || !latLon.saveAs(latLonField))
         {
             LOC_LOGE("NMEA Error in string formatting");
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
-        {
-            float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
+        // DTM goes before the first position sentence, and before each
+        // of them with the PZ90 datum
+        bool dtmPending = generateDTM;
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        // -------------------
+        // ------$--RMC-------
+        // -------------------
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
+        if (generateRMC) {
+            LocNmeaWriter rmc(sentence_RMC, sizeof(sentence_RMC));
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            bool validFix = ((0 != sv_cache_info.gps_used_mask) ||
+                    (0 != sv_cache_info.glo_used_mask) ||
+                    (0 != sv_cache_info.gal_used_mask) ||
+                    (0 != sv_cache_info.qzss_used_mask) ||
+                    (0 != sv_cache_info.bds_used_mask));
 
-        length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
-                          utcDay, utcMonth, utcYear);
+            rmc.begin(talker, "RMC");
+            rmc.put(utcTimeField);
+            rmc.putStr(validFix ? "A," : "V,");
+            rmc.put(latLonField);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
+            {
+                float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
+                rmc.putFixed(speedKnots, 1);
+            }
+            rmc.putChar(',');
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
-        {
-            float magneticVariation = locationExtended.magneticDeviation;
-            char direction;
-            if (magneticVariation < 0.0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
+            {
+                rmc.putFixed(location.gpsLocation.bearing, 1);
+            }
+            rmc.putChar(',');
+
+            rmc.putInt(utcDay, 2);
+            rmc.putInt(utcMonth, 2);
+            rmc.putInt(utcYear, 2);
+            rmc.putChar(',');
+
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
             {
-                direction = 'W';
-                magneticVariation *= -1.0;
+                float magneticVariation = locationExtended.magneticDeviation;
+                char direction;
+                if (magneticVariation < 0.0)
+                {
+                    direction = 'W';
+                    magneticVariation *= -1.0;
+                }
+                else
+                {
+                    direction = 'E';
+                }
+
+                rmc.putFixed(magneticVariation, 1);
+                rmc.putChar(',');
+                rmc.putChar(direction);
+                rmc.putChar(',');
             }
             else
             {
-                direction = 'E';
+                rmc.putStr(",,");
             }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
-                              magneticVariation, direction);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            rmc.putChar(rmcModeIndicator);
 
-        length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
-        pMarker += length;
-        lengthRemaining -= length;
+            // hardcode Navigation Status field to 'V'
+            rmc.putStr(",V");
 
-        // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
+            if (!rmc.end())
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            if (dtmPending) {
+                nmeaArraystr.push_back(sentence_DTM);
+            }
+            nmeaArraystr.emplace_back(sentence_RMC, rmc.length());
+            dtmPending = generateDTM && (LOC_GNSS_DATUM_PZ90 == datum_type);
 
-        length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC), false);
+        }
 
         // -------------------
         // ------$--GNS-------
         // -------------------
 
-        pMarker = sentence_GNS;
-        lengthRemaining = sizeof(sentence_GNS);
+        if (generateGNS) {
+            LocNmeaWriter gns(sentence_GNS, sizeof(sentence_GNS));
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            gns.begin(talker, "GNS");
+            gns.put(utcTimeField);
+            gns.put(latLonField);
+            gns.putStr(gnsModeIndicator);
+            gns.putChar(',');
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
+            gns.putInt(svUsedCount, 2);
+            gns.putChar(',');
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
+                gns.putFixed(locationExtended.hdop, 1);
+            }
+            gns.putChar(',');
 
-            if (latitude > 0)
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
             {
-                latHemisphere = 'N';
+                gns.putFixed(locationExtended.altitudeMeanSeaLevel, 1);
             }
-            else
+            gns.putChar(',');
+
+            if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
+                (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                gns.putFixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1);
             }
+            gns.putChar(',');
 
-            if (longitude < 0)
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
             {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+                gns.putFixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1);
             }
-            else
+            gns.putChar(',');
+
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
             {
-                lonHemisphere = 'E';
+                gns.putInt(locationExtended.dgnssRefStationId, 4);
             }
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%s,", gnsModeIndicator);
+            // hardcode Navigation Status field to 'V'
+            gns.putStr(",V");
 
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
-        }
-        else {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%02d,,",
-                              svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
-            (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
+            if (!gns.end())
             {
                 LOC_LOGE("NMEA Error in string formatting");
                 return;
             }
-            pMarker += length;
-            lengthRemaining -= length;
-        }
-
-        // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-        pMarker += length;
-        lengthRemaining -= length;
+            if (dtmPending) {
+                nmeaArraystr.push_back(sentence_DTM);
+            }
+            nmeaArraystr.emplace_back(sentence_GNS, gns.length());
+            dtmPending = generateDTM && (LOC_GNSS_DATUM_PZ90 == datum_type);
 
-        length = loc_nmea_put_checksum(sentence_GNS, sizeof(sentence_GNS), false);
+        }
 
         // -------------------
         // ------$--GGA-------
         // -------------------
 
-        pMarker = sentence_GGA;
-        lengthRemaining = sizeof(sentence_GGA);
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
+        if (generateGGA) {
+            LocNmeaWriter gga(sentence_GGA, sizeof(sentence_GGA));
+
+            gga.begin(talker, "GGA");
+            gga.put(utcTimeField);
+            gga.put(latLonField);
+
+            // Number of satellites in use, 00-12
+            if (svUsedCount > MAX_SATELLITES_IN_USE)
+                svUsedCount = MAX_SATELLITES_IN_USE;
+            gga.putStr(ggaGpsQuality);
+            gga.putChar(',');
+            gga.putInt(svUsedCount, 2);
+            gga.putChar(',');
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
+            {
+                gga.putFixed(locationExtended.hdop, 1);
+            }
+            gga.putChar(',');
 
-            if (latitude > 0)
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
             {
-                latHemisphere = 'N';
+                gga.putFixed(locationExtended.altitudeMeanSeaLevel, 1);
+                gga.putStr(",M,");
             }
             else
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                gga.putStr(",,");
             }
 
-            if (longitude < 0)
+            if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
+                (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
             {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+                gga.putFixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1);
+                gga.putStr(",M,");
             }
             else
             {
-                lonHemisphere = 'E';
+                gga.putStr(",,");
             }
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        // Number of satellites in use, 00-12
-        if (svUsedCount > MAX_SATELLITES_IN_USE)
-            svUsedCount = MAX_SATELLITES_IN_USE;
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
-        }
-        else
-        {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
-                              ggaGpsQuality, svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
-            (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",,");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
+            {
+                gga.putFixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1);
+            }
+            gga.putChar(',');
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
+            {
+                gga.putInt(locationExtended.dgnssRefStationId, 4);
+            }
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
+            if (!gga.end())
             {
                 LOC_LOGE("NMEA Error in string formatting");
                 return;
             }
-            pMarker += length;
-            lengthRemaining -= length;
-        }
-
-        length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA), false);
 
-        // ------$--DTM-------
-        nmeaArraystr.push_back(sentence_DTM);
-        // ------$--RMC-------
-        nmeaArraystr.push_back(sentence_RMC);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
-        }
-        // ------$--GNS-------
-        nmeaArraystr.push_back(sentence_GNS);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+            if (dtmPending) {
+                nmeaArraystr.push_back(sentence_DTM);
+            }
+            nmeaArraystr.emplace_back(sentence_GGA, gga.length());
+            indexOfGGA = static_cast<int>(nmeaArraystr.size() - 1);
         }
-        // ------$--GGA-------
-        nmeaArraystr.push_back(sentence_GGA);
-        indexOfGGA = static_cast<int>(nmeaArraystr.size() - 1);
     }
     //Send blank NMEA reports for non-final fixes
     else {
-        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        for (const auto& each : loc_nmea_blank_pos_sentences()) {
+            if (0 != (typesMask & each.first)) {
+                nmeaArraystr.push_back(each.second);
+            }
+        }
     }
 
     EXIT_LOG(%d, 0);
@@ -2146,202 +2208,68 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
     loc_sv_cache_info sv_cache_info = {};
+    loc_nmea_sv_meta sv_meta[GSV_GROUP_COUNT];
+    loc_nmea_gsv_svs svs;
+
+    for (uint32_t group = 0; group < GSV_GROUP_COUNT; group++) {
+        loc_nmea_sv_meta_init(sv_meta[group], sv_cache_info, sGsvGroups[group].svType,
+                sGsvGroups[group].signalType, false);
+        svs.svCount[group] = 0;
+        svs.listedCount[group] = 0;
+    }
 
-    //Count GPS SVs for saparating GPS from GLONASS and throw others
-    for (uint32_t svOffset = 0; svOffset < svNotify.count; svOffset++) {
-        if ((GNSS_SV_TYPE_GPS == svNotify.gnssSvs[svOffset].type) ||
-            (GNSS_SV_TYPE_SBAS == svNotify.gnssSvs[svOffset].type))
-        {
-            if (GNSS_SIGNAL_GPS_L5 == svNotify.gnssSvs[svOffset].gnssSignalTypeMask) {
-                sv_cache_info.gps_l5_count++;
-            } else if (GNSS_SIGNAL_GPS_L2 == svNotify.gnssSvs[svOffset].gnssSignalTypeMask) {
-                sv_cache_info.gps_l2_count++;
-            } else {
-                // GNSS_SIGNAL_GPS_L1CA, GNSS_SIGNAL_SBAS_L1 or default
-                // If no signal type in report, it means default L1
-                sv_cache_info.gps_l1_count++;
-            }
-        }
-        else if (GNSS_SV_TYPE_GLONASS == svNotify.gnssSvs[svOffset].type)
-        {
-            if (GNSS_SIGNAL_GLONASS_G2 == svNotify.gnssSvs[svOffset].gnssSignalTypeMask){
-                sv_cache_info.glo_g2_count++;
-            } else {
-                // GNSS_SIGNAL_GLONASS_G1 or default
-                // If no signal type in report, it means default G1
-                sv_cache_info.glo_g1_count++;
-            }
-        }
-        else if (GNSS_SV_TYPE_GALILEO == svNotify.gnssSvs[svOffset].type)
-        {
-            if(GNSS_SIGNAL_GALILEO_E5A == svNotify.gnssSvs[svOffset].gnssSignalTypeMask){
-                sv_cache_info.gal_e5_count++;
-            } else if (GNSS_SIGNAL_GALILEO_E5B == svNotify.gnssSvs[svOffset].gnssSignalTypeMask) {
-                sv_cache_info.gal_e5b_count++;
-            } else {
-                // GNSS_SIGNAL_GALILEO_E1 or default
-                // If no signal type in report, it means default E1
-                sv_cache_info.gal_e1_count++;
+    // sort every SV into its groups in a single pass
+    uint32_t count = svNotify.count;
+    if (count > GNSS_SV_MAX) {
+        LOC_LOGE("NMEA Error SV count %u exceeds %d", count, GNSS_SV_MAX);
+        count = GNSS_SV_MAX;
+    }
+    for (uint32_t svOffset = 0; svOffset < count; svOffset++) {
+        const GnssSv& sv = svNotify.gnssSvs[svOffset];
+        const loc_nmea_constellation* constellation = loc_nmea_constellation_of(sv.type);
+        if (nullptr == constellation || constellation->firstGsvGroup < 0) {
+            LOC_LOGE("NMEA Error unknow constellation type: %d", sv.type);
+            continue;
+        }
+        uint32_t firstGroup = constellation->firstGsvGroup;
+        uint32_t groupCount = constellation->gsvGroupCount;
+
+        // counted by the exact signal type, anything else is the default
+        uint32_t countGroup = firstGroup;
+        GnssSignalTypeMask countSignal = (GNSS_SIGNAL_BEIDOU_B2AQ == sv.gnssSignalTypeMask) ?
+                (GnssSignalTypeMask)GNSS_SIGNAL_BEIDOU_B2AI :
+                (GnssSignalTypeMask)sv.gnssSignalTypeMask;
+        for (uint32_t group = firstGroup + 1; group < firstGroup + groupCount; group++) {
+            if (sGsvGroups[group].signalType == countSignal) {
+                countGroup = group;
+                break;
             }
         }
-        else if (GNSS_SV_TYPE_QZSS == svNotify.gnssSvs[svOffset].type)
-        {
-            if (GNSS_SIGNAL_QZSS_L5 == svNotify.gnssSvs[svOffset].gnssSignalTypeMask) {
-                sv_cache_info.qzss_l5_count++;
-            } else if (GNSS_SIGNAL_QZSS_L2 == svNotify.gnssSvs[svOffset].gnssSignalTypeMask) {
-                sv_cache_info.qzss_l2_count++;
-            } else {
-                // GNSS_SIGNAL_QZSS_L1CA or default
-                // If no signal type in report, it means default L1
-                sv_cache_info.qzss_l1_count++;
-            }
+        svs.svCount[countGroup]++;
+
+        // listed by signal ID, if no signal type in report it means default
+        GnssSignalTypeMask signalType = sv.gnssSignalTypeMask;
+        if (0 == signalType) {
+            signalType = constellation->defaultSignal;
         }
-        else if (GNSS_SV_TYPE_BEIDOU == svNotify.gnssSvs[svOffset].type)
-        {
-            // cache the used in fix mask, as it will be needed to send $PQGSA
-            // during the position report
-            if (GNSS_SV_OPTIONS_USED_IN_FIX_BIT ==
-                (svNotify.gnssSvs[svOffset].gnssSvOptionsMask &
-                  GNSS_SV_OPTIONS_USED_IN_FIX_BIT))
-            {
-                setSvMask(sv_cache_info.bds_used_mask, svNotify.gnssSvs[svOffset].svId);
-            }
-            if ((GNSS_SIGNAL_BEIDOU_B2AI == svNotify.gnssSvs[svOffset].gnssSignalTypeMask) ||
-                   (GNSS_SIGNAL_BEIDOU_B2AQ == svNotify.gnssSvs[svOffset].gnssSignalTypeMask)) {
-                sv_cache_info.bds_b2_count++;
-            } else if (GNSS_SIGNAL_BEIDOU_B1C == svNotify.gnssSvs[svOffset].gnssSignalTypeMask) {
-                sv_cache_info.bds_b1c_count++;
-            } else {
-                // GNSS_SIGNAL_BEIDOU_B1I or default
-                // If no signal type in report, it means default B1I
-                sv_cache_info.bds_b1i_count++;
+        uint32_t signalId = convert_signalType_to_signalId(signalType);
+        for (uint32_t group = firstGroup; group < firstGroup + groupCount; group++) {
+            if (sv_meta[group].signalId == signalId) {
+                svs.listed[group][svs.listedCount[group]++] = svOffset;
+                break;
             }
         }
-        else if (GNSS_SV_TYPE_NAVIC == svNotify.gnssSvs[svOffset].type)
-        {
-            // GNSS_SIGNAL_NAVIC_L5 is the only signal type for NAVIC
-            sv_cache_info.navic_l5_count++;
-        }
     }
 
-    loc_nmea_sv_meta sv_meta;
-    // ---------------------
-    // ------$GPGSV:L1CA----
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L1CA, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GPGSV:L5------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L5, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GPGSV:L2------
-    // ---------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L2, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GLGSV:G1------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G1, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GLGSV:G2------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G2, false), nmeaArraystr);
-
-    // ---------------------
-    // ------$GAGSV:E1------
-    // ---------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E1, false), nmeaArraystr);
-
-    // -------------------------
-    // ------$GAGSV:E5A---------
-    // -------------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5A, false), nmeaArraystr);
-
-    // -------------------------
-    // ------$GAGSV:E5B---------
-    // -------------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5B, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GQGSV (QZSS):L1CA-----
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L1CA, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GQGSV (QZSS):L5-------
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L5, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GQGSV (QZSS):L2-------
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L2, false), nmeaArraystr);
-
-
-    // -----------------------------
-    // ------$GBGSV (BEIDOU:B1I)----
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1I, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GBGSV (BEIDOU:B1C)----
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1C, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GBGSV (BEIDOU:B2AI)---
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B2AI, false), nmeaArraystr);
-
-    // -----------------------------
-    // ------$GIGSV (NAVIC:L5)------
-    // -----------------------------
-
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_NAVIC,
-            GNSS_SIGNAL_NAVIC_L5,false), nmeaArraystr);
+    // --------------------------------------------------------------------
+    // ---$GPGSV:L1CA,L5,L2 $GLGSV:G1,G2 $GAGSV:E1,E5A,E5B-----------------
+    // ---$GQGSV:L1CA,L5,L2 $GBGSV:B1I,B1C,B2AI $GIGSV:L5------------------
+    // --------------------------------------------------------------------
+    for (uint32_t group = 0; group < GSV_GROUP_COUNT; group++) {
+        sv_meta[group].svCount = svs.svCount[group];
+        loc_nmea_generate_GSV(svNotify, svs.listed[group], svs.listedCount[group],
+                sentence, sizeof(sentence), &sv_meta[group], nmeaArraystr);
+    }
 
     EXIT_LOG(%d, 0);
 }
@@ -72,6 +72,14 @@ typedef struct {
     double     Z;
 } LocEcef;
 
+/* Sentence types generated on AP, for every talker: GGA, RMC, GSV, GSA,
+ * VTG, GNS and DTM. loc_nmea_generate_pos skips the types not in its
+ * typesMask, loc_nmea_generate_sv only generates GSV. */
+#define LOC_NMEA_AP_GENERATED_MASK (LOC_NMEA_MASK_GGA_V02 | LOC_NMEA_MASK_RMC_V02 | \
+                                    LOC_NMEA_MASK_GSV_V02 | LOC_NMEA_MASK_GSA_V02 | \
+                                    LOC_NMEA_MASK_VTG_V02 | LOC_NMEA_MASK_GNGNS_V02 | \
+                                    LOC_NMEA_MASK_GPDTM_V02)
+
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
                               std::vector<std::string> &nmeaArraystr);
 
@@ -82,7 +90,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                bool custom_gga_fix_quality,
                                std::vector<std::string> &nmeaArraystr,
                                int& indexOfGGA,
-                               bool isTagBlockGroupingEnabled);
+                               bool isTagBlockGroupingEnabled,
+                               NmeaSentenceTypesMask typesMask = LOC_NMEA_AP_GENERATED_MASK);
 
 #define DEBUG_NMEA_MINSIZE 6
 #define DEBUG_NMEA_MAXSIZE 4096
@@ -39,6 +39,7 @@
 #include "loc_target.h"
 #include "loc_log.h"
 #include <loc_pla.h>
+#include <mutex>
 
 #define APQ8064_ID_1 "109"
 #define APQ8064_ID_2 "153"
@@ -64,8 +65,6 @@
 #define GPS_CHECK_NO_ERROR 0
 #define GPS_CHECK_NO_GPS_HW 1
 
-static unsigned int gTarget = (unsigned int)-1;
-
 static int read_a_line(const char * file_path, char * line, int line_size)
 {
     FILE *fp;
@@ -93,12 +92,54 @@ static int read_a_line(const char * file_path, char * line, int line_size)
     return result;
 }
 
+/* Everything the functions below report, read once per process. The
+   properties are read-only and the soc nodes don't change after boot. */
+struct LocTargetInfo {
+    char baseband[PROPERTY_VALUE_MAX];
+    char platform_name[PROPERTY_VALUE_MAX];
+    char auto_platform_name[PROPERTY_VALUE_MAX];
+    char soc_id[PROPERTY_VALUE_MAX];
+    int soc_id_result;
+    int low_ram;
+    unsigned int target;
+};
+
+static unsigned int loc_detect_target(const LocTargetInfo& info);
+
+static const LocTargetInfo& loc_get_target_info()
+{
+    static LocTargetInfo info;
+    static std::once_flag once;
+
+    std::call_once(once, []() {
+        static const char soc_id[]     = "/sys/devices/soc0/soc_id";
+        static const char soc_id_dep[] = "/sys/devices/system/soc/soc0/id";
+        char low_ram_target[PROPERTY_VALUE_MAX];
+
+        property_get("ro.baseband", info.baseband, "");
+        property_get("ro.board.platform", info.platform_name, "");
+        property_get("ro.hardware.type", info.auto_platform_name, "");
+        property_get("ro.config.low_ram", low_ram_target, "");
+        info.low_ram = !(strncmp(low_ram_target, "true", PROPERTY_VALUE_MAX));
+
+        if (!access(soc_id, F_OK)) {
+            info.soc_id_result = read_a_line(soc_id, info.soc_id, sizeof(info.soc_id));
+        } else {
+            info.soc_id_result = read_a_line(soc_id_dep, info.soc_id, sizeof(info.soc_id));
+        }
+
+        info.target = loc_detect_target(info);
+    });
+
+    return info;
+}
+
 /*The character array passed to this function should have length
   of atleast PROPERTY_VALUE_MAX*/
 void loc_get_target_baseband(char *baseband, int array_length)
 {
     if(baseband && (array_length >= PROPERTY_VALUE_MAX)) {
-        property_get("ro.baseband", baseband, "");
+        strlcpy(baseband, loc_get_target_info().baseband, array_length);
         LOC_LOGD("%s:%d]: Baseband: %s\n", __func__, __LINE__, baseband);
     }
     else {
@@ -112,7 +153,7 @@ void loc_get_target_baseband(char *baseband, int array_length)
 void loc_get_platform_name(char *platform_name, int array_length)
 {
     if(platform_name && (array_length >= PROPERTY_VALUE_MAX)) {
-        property_get("ro.board.platform", platform_name, "");
+        strlcpy(platform_name, loc_get_target_info().platform_name, array_length);
         LOC_LOGD("%s:%d]: Target name: %s\n", __func__, __LINE__, platform_name);
     }
     else {
@@ -126,7 +167,7 @@ void loc_get_platform_name(char *platform_name, int array_length)
 void loc_get_auto_platform_name(char *platform_name, int array_length)
 {
     if(platform_name && (array_length >= PROPERTY_VALUE_MAX)) {
-        property_get("ro.hardware.type", platform_name, "");
+        strlcpy(platform_name, loc_get_target_info().auto_platform_name, array_length);
         LOC_LOGD("%s:%d]: Autoplatform name: %s\n", __func__, __LINE__, platform_name);
     }
     else {
@@ -142,11 +183,9 @@ void loc_get_auto_platform_name(char *platform_name, int array_length)
 */
 int loc_identify_low_ram_target()
 {
-    int ret = 0;
-    char low_ram_target[PROPERTY_VALUE_MAX];
-    property_get("ro.config.low_ram", low_ram_target, "");
-    LOC_LOGd("low ram target: %s\n", low_ram_target);
-    return !(strncmp(low_ram_target, "true", PROPERTY_VALUE_MAX));
+    int low_ram = loc_get_target_info().low_ram;
+    LOC_LOGd("low ram target: %d\n", low_ram);
+    return low_ram;
 }
 
 /*The character array passed to this function should have length
@@ -154,17 +193,10 @@ int loc_identify_low_ram_target()
 /* Reads the soc_id node and return the soc_id value */
 void loc_get_device_soc_id(char *soc_id_value, int array_length)
 {
-    static const char soc_id[]     = "/sys/devices/soc0/soc_id";
-    static const char soc_id_dep[] = "/sys/devices/system/soc/soc0/id";
-    int return_val = 0;
-
     if (soc_id_value && (array_length >= PROPERTY_VALUE_MAX)) {
-        if (!access(soc_id, F_OK)) {
-            return_val = read_a_line(soc_id, soc_id_value, array_length);
-        } else {
-            return_val = read_a_line(soc_id_dep, soc_id_value, array_length);
-        }
-        if (0 == return_val) {
+        const LocTargetInfo& info = loc_get_target_info();
+        strlcpy(soc_id_value, info.soc_id, array_length);
+        if (0 == info.soc_id_result) {
             LOC_LOGd("SOC Id value: %s\n", soc_id_value);
         } else {
             LOC_LOGe("Unable to read the soc_id value\n");
@@ -176,41 +208,38 @@ void loc_get_device_soc_id(char *soc_id_value, int array_length)
 
 unsigned int loc_get_target(void)
 {
-    if (gTarget != (unsigned int)-1)
-        return gTarget;
+    return loc_get_target_info().target;
+}
 
+static unsigned int loc_detect_target(const LocTargetInfo& info)
+{
     static const char hw_platform[]      = "/sys/devices/soc0/hw_platform";
     static const char hw_platform_dep[]  =
         "/sys/devices/system/soc/soc0/hw_platform";
     static const char mdm[]              = "/target"; // mdm target we are using
 
     char rd_hw_platform[LINE_LEN];
-    char rd_id[LINE_LEN];
     char rd_mdm[LINE_LEN];
-    char baseband[LINE_LEN];
-    char rd_auto_platform[LINE_LEN];
-
-    loc_get_target_baseband(baseband, sizeof(baseband));
+    const char* rd_id = info.soc_id;
+    const char* baseband = info.baseband;
+    unsigned int target;
 
     if (!access(hw_platform, F_OK)) {
         read_a_line(hw_platform, rd_hw_platform, LINE_LEN);
     } else {
         read_a_line(hw_platform_dep, rd_hw_platform, LINE_LEN);
     }
-    // Get the soc-id for this device.
-    loc_get_device_soc_id(rd_id, sizeof(rd_id));
 
     /*check automotive platform*/
-    loc_get_auto_platform_name(rd_auto_platform, sizeof(rd_auto_platform));
-    if( !memcmp(rd_auto_platform, STR_AUTO, LENGTH(STR_AUTO)) )
+    if( !memcmp(info.auto_platform_name, STR_AUTO, LENGTH(STR_AUTO)) )
     {
-          gTarget = TARGET_AUTO;
+          target = TARGET_AUTO;
           goto detected;
     }
 
     if( !memcmp(baseband, STR_APQ_NO_WGR, LENGTH(STR_APQ_NO_WGR)) ){
 
-        gTarget = TARGET_NO_GNSS;
+        target = TARGET_NO_GNSS;
         goto detected;
     }
 
@@ -220,9 +249,9 @@ unsigned int loc_get_target(void)
 
         if( !memcmp(rd_id, MPQ8064_ID_1, LENGTH(MPQ8064_ID_1))
             && IS_STR_END(rd_id[LENGTH(MPQ8064_ID_1)]) )
-            gTarget = TARGET_NO_GNSS;
+            target = TARGET_NO_GNSS;
         else
-            gTarget = TARGET_APQ_SA;
+            target = TARGET_APQ_SA;
     } else if (((!memcmp(rd_hw_platform, STR_LIQUID, LENGTH(STR_LIQUID))
                  && IS_STR_END(rd_hw_platform[LENGTH(STR_LIQUID)])) ||
                 (!memcmp(rd_hw_platform, STR_SURF,   LENGTH(STR_SURF))
@@ -230,20 +259,20 @@ unsigned int loc_get_target(void)
                 (!memcmp(rd_hw_platform, STR_MTP,   LENGTH(STR_MTP))
                  && IS_STR_END(rd_hw_platform[LENGTH(STR_MTP)]))) &&
                !read_a_line( mdm, rd_mdm, LINE_LEN)) {
-        gTarget = TARGET_MDM;
+        target = TARGET_MDM;
     } else if( (!memcmp(rd_id, MSM8930_ID_1, LENGTH(MSM8930_ID_1))
                 && IS_STR_END(rd_id[LENGTH(MSM8930_ID_1)])) ||
                (!memcmp(rd_id, MSM8930_ID_2, LENGTH(MSM8930_ID_2))
                 && IS_STR_END(rd_id[LENGTH(MSM8930_ID_2)])) ) {
-        gTarget = TARGET_MSM_NO_SSC;
+        target = TARGET_MSM_NO_SSC;
     } else if ( !memcmp(baseband, STR_MSM, LENGTH(STR_MSM)) ||
                 !memcmp(baseband, STR_SDM, LENGTH(STR_SDM)) ) {
-        gTarget = TARGET_DEFAULT;
+        target = TARGET_DEFAULT;
     } else {
-        gTarget = TARGET_UNKNOWN;
+        target = TARGET_UNKNOWN;
     }
 
 detected:
-    LOC_LOGW("HAL: %s returned %d", __FUNCTION__, gTarget);
-    return gTarget;
+    LOC_LOGW("HAL: %s returned %d", __FUNCTION__, target);
+    return target;
 }
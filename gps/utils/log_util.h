@@ -172,6 +172,13 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 #define LOG_NDEBUG 0
 #endif
 #define TOTAL_LOG_LEVELS 5
+/* Highest log level compiled into the binary, 1 (error) through 5 (verbose).
+   Anything above it is removed by the compiler, before DEBUG_LEVEL or the
+   tag based levels are consulted. Set from GNSS_LOG_LEVEL_CFLAGS. */
+#ifndef LOC_LOG_COMPILE_LEVEL
+#define LOC_LOG_COMPILE_LEVEL 5
+#endif
+#define LOC_LOG_COMPILED(x) ((x) <= LOC_LOG_COMPILE_LEVEL)
 #define LOGGING_BUFFER_MAX_LEN 1024
 #define IF_LOG_BUFFER_ENABLE if (loc_logger.LOG_BUFFER_ENABLE)
 #define INSERT_BUFFER(flag, level, format, x...)                                              \
@@ -209,7 +216,8 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 */
 static int LOCAL_LOG_LEVEL = -1;
 #define IF_LOC_LOG(x) \
-    if (((LOCAL_LOG_LEVEL == -1 && (LOCAL_LOG_LEVEL = get_tag_log_level(LOG_TAG)) >= x) ||\
+    if (LOC_LOG_COMPILED(x) && \
+            ((LOCAL_LOG_LEVEL == -1 && (LOCAL_LOG_LEVEL = get_tag_log_level(LOG_TAG)) >= x) ||\
             LOCAL_LOG_LEVEL >= x) && LOCAL_LOG_LEVEL <= 5)
 
 #define IF_LOC_LOGE IF_LOC_LOG(1)
@@ -224,13 +232,59 @@ static int LOCAL_LOG_LEVEL = -1;
 #define LOC_LOGD(...) IF_LOC_LOGD { ALOGD(__VA_ARGS__); INSERT_BUFFER(LOG_NDEBUG, 3, __VA_ARGS__);}
 #define LOC_LOGV(...) IF_LOC_LOGV { ALOGV(__VA_ARGS__); INSERT_BUFFER(LOG_NDEBUG, 4, __VA_ARGS__);}
 
+/* Lazy format variants: the arguments are evaluated and formatted exactly
+   once, after the level check, into a single buffer shared by logcat and
+   the log buffer. Use these where the arguments are costly or the call is
+   on a per-report path. Output is limited to LOGGING_BUFFER_MAX_LEN. */
+#define LOC_LOG_LAZY(level, ALOG, format, x...)                                               \
+{                                                                                             \
+    IF_LOC_LOG(level) {                                                                       \
+        char log_str[LOGGING_BUFFER_MAX_LEN];                                                 \
+        int head_len = 0;                                                                     \
+        IF_LOG_BUFFER_ENABLE {                                                                \
+            if (LOG_NDEBUG == 0) {                                                            \
+                char timestr[32];                                                             \
+                get_timestamp(timestr, sizeof(timestr));                                      \
+                head_len = snprintf(log_str, sizeof(log_str), "%s %d %ld %s :", timestr,      \
+                        getpid(), syscall(SYS_gettid), LOG_TAG==NULL ? "": LOG_TAG);          \
+                if (head_len < 0 || head_len >= (int)sizeof(log_str) - 2) {                   \
+                    head_len = 0;                                                             \
+                }                                                                             \
+            }                                                                                 \
+        }                                                                                     \
+        int body_len = snprintf(log_str + head_len, sizeof(log_str) - head_len, format, ##x);\
+        ALOG("%s", log_str + head_len);                                                       \
+        if (head_len > 0) {                                                                   \
+            int end = head_len + (body_len < 0 ? 0 : body_len);                               \
+            if (end > (int)sizeof(log_str) - 2) {                                             \
+                end = sizeof(log_str) - 2;                                                    \
+            }                                                                                 \
+            log_str[end] = '\n';                                                              \
+            log_str[end + 1] = '\0';                                                          \
+            log_buffer_insert(log_str, sizeof(log_str), (level) - 1);                         \
+        }                                                                                     \
+    }                                                                                         \
+}
+
+#define LOC_LOGE_LAZY(...) LOC_LOG_LAZY(1, ALOGE, __VA_ARGS__)
+#define LOC_LOGW_LAZY(...) LOC_LOG_LAZY(2, ALOGW, __VA_ARGS__)
+#define LOC_LOGI_LAZY(...) LOC_LOG_LAZY(3, ALOGI, __VA_ARGS__)
+#define LOC_LOGD_LAZY(...) LOC_LOG_LAZY(4, ALOGD, __VA_ARGS__)
+#define LOC_LOGV_LAZY(...) LOC_LOG_LAZY(5, ALOGV, __VA_ARGS__)
+
 #else /* DEBUG_DMN_LOC_API */
 
-#define LOC_LOGE(...) ALOGE(__VA_ARGS__)
-#define LOC_LOGW(...) ALOGW(__VA_ARGS__)
-#define LOC_LOGI(...) ALOGI(__VA_ARGS__)
-#define LOC_LOGD(...) ALOGD(__VA_ARGS__)
-#define LOC_LOGV(...) ALOGV(__VA_ARGS__)
+#define LOC_LOGE(...) if (LOC_LOG_COMPILED(1)) { ALOGE(__VA_ARGS__); }
+#define LOC_LOGW(...) if (LOC_LOG_COMPILED(2)) { ALOGW(__VA_ARGS__); }
+#define LOC_LOGI(...) if (LOC_LOG_COMPILED(3)) { ALOGI(__VA_ARGS__); }
+#define LOC_LOGD(...) if (LOC_LOG_COMPILED(4)) { ALOGD(__VA_ARGS__); }
+#define LOC_LOGV(...) if (LOC_LOG_COMPILED(5)) { ALOGV(__VA_ARGS__); }
+
+#define LOC_LOGE_LAZY(...) LOC_LOGE(__VA_ARGS__)
+#define LOC_LOGW_LAZY(...) LOC_LOGW(__VA_ARGS__)
+#define LOC_LOGI_LAZY(...) LOC_LOGI(__VA_ARGS__)
+#define LOC_LOGD_LAZY(...) LOC_LOGD(__VA_ARGS__)
+#define LOC_LOGV_LAZY(...) LOC_LOGV(__VA_ARGS__)
 
 #endif /* DEBUG_DMN_LOC_API */
 
@@ -239,8 +293,11 @@ static int LOCAL_LOG_LEVEL = -1;
  *                          LOGGING IMPROVEMENT MACROS
  *
  *============================================================================*/
-#define LOG_(LOC_LOG, ID, WHAT, SPEC, VAL)                                    \
+#define LOG_(LOC_LOG, LEVEL, ID, WHAT, SPEC, VAL)                             \
     do {                                                                      \
+        if (!LOC_LOG_COMPILED(LEVEL)) {                                       \
+            break;                                                            \
+        }                                                                     \
         if (loc_logger.TIMESTAMP) {                                           \
             char ts[32];                                                      \
             LOC_LOG("[%s] %s %s line %d " #SPEC,                              \
@@ -258,10 +315,21 @@ static int LOCAL_LOG_LEVEL = -1;
 #define LOC_LOGd(fmt,...) LOC_LOGD(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
 #define LOC_LOGe(fmt,...) LOC_LOGE(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
 
-#define LOG_I(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGI, ID, WHAT, SPEC, VAL)
-#define LOG_V(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGV, ID, WHAT, SPEC, VAL)
-#define LOG_E(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGE, ID, WHAT, SPEC, VAL)
-#define LOG_D(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGD, ID, WHAT, SPEC, VAL)
+#define LOC_LOGv_LAZY(fmt,...) \
+        LOC_LOGV_LAZY(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOC_LOGw_LAZY(fmt,...) \
+        LOC_LOGW_LAZY(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOC_LOGi_LAZY(fmt,...) \
+        LOC_LOGI_LAZY(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOC_LOGd_LAZY(fmt,...) \
+        LOC_LOGD_LAZY(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define LOC_LOGe_LAZY(fmt,...) \
+        LOC_LOGE_LAZY(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
+
+#define LOG_I(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGI, 3, ID, WHAT, SPEC, VAL)
+#define LOG_V(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGV, 5, ID, WHAT, SPEC, VAL)
+#define LOG_E(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGE, 1, ID, WHAT, SPEC, VAL)
+#define LOG_D(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGD, 4, ID, WHAT, SPEC, VAL)
 
 #define ENTRY_LOG() LOG_V(ENTRY_TAG, __FUNCTION__, %s, "")
 #define EXIT_LOG(SPEC, VAL) LOG_V(EXIT_TAG, __FUNCTION__, SPEC, VAL)
@@ -32,16 +32,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include <loc_pla.h>
 #include <log_util.h>
 #include "linked_list.h"
 #include "msg_q.h"
 
+#define MSG_Q_RING_DEFAULT_CAPACITY 256
+#define MSG_Q_CACHE_LINE 64
+/* A lane that had msgs pending while this many msgs in a row were taken
+   from higher priority lanes is served next regardless of priority. */
+#define MSG_Q_STARVATION_LIMIT 16
+
+#define MSG_Q_STAT_INC(q, field) __atomic_fetch_add(&(q)->stats.field, 1, __ATOMIC_RELAXED)
+
+typedef struct msg_q_ring_slot {
+   unsigned long seq;               /* Slot sequence, gates producer / consumer access */
+   void* msg_obj;
+   void (*dealloc)(void*);
+} msg_q_ring_slot;
+
+typedef struct msg_q_ring {
+   msg_q_ring_slot* slots;
+   unsigned long mask;              /* Slot count - 1, slot count is a power of 2 */
+   /* Producer and consumer cursors live on separate cache lines */
+   unsigned long enq_pos __attribute__((aligned(MSG_Q_CACHE_LINE)));
+   unsigned long deq_pos __attribute__((aligned(MSG_Q_CACHE_LINE)));
+} msg_q_ring;
+
+typedef struct msg_q_lane {
+   void* msg_list;                  /* List storage; ring overflow storage */
+   msg_q_ring ring;                 /* eMSG_Q_TYPE_RING only */
+   unsigned long overflow_cnt;      /* eMSG_Q_TYPE_RING only, msgs parked on msg_list */
+   unsigned int skipped;            /* Consumer only, see MSG_Q_STARVATION_LIMIT */
+} msg_q_lane;
+
 typedef struct msg_q {
-   void* msg_list;                  /* Linked list to store information */
+   msg_q_lane lanes[MSG_Q_MAX_LANES]; /* Lane 0 is the highest priority */
+   unsigned int num_lanes;
    pthread_cond_t  list_cond;       /* Condition variable for waiting on msg queue */
    pthread_mutex_t list_mutex;      /* Mutex for exclusive access to message queue */
    int unblocked;                   /* Has this message queue been unblocked? */
+   msg_q_type type;                 /* Storage type of this queue */
+   int wake_fd;                     /* eMSG_Q_TYPE_RING only, consumer blocks on it */
+   int sleeping;                    /* eMSG_Q_TYPE_RING only, consumer about to block */
+   msg_q_stats stats;
 } msg_q;
 
 /*===========================================================================
@@ -85,6 +122,464 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
    }
 }
 
+/*===========================================================================
+FUNCTION    msg_q_ring_init
+
+DESCRIPTION
+   Allocates ring slots.
+
+   ring:     Ring to initialize.
+   capacity: Requested number of slots, rounded up to a power of 2.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   0 on success; -1 on failure
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_ring_init(msg_q_ring* ring, unsigned int capacity)
+{
+   unsigned long size = 1;
+   unsigned long i;
+
+   if (0 == capacity) {
+      capacity = MSG_Q_RING_DEFAULT_CAPACITY;
+   }
+   while (size < capacity) {
+      size <<= 1;
+   }
+
+   ring->slots = (msg_q_ring_slot*)calloc(size, sizeof(msg_q_ring_slot));
+   if (NULL == ring->slots) {
+      LOC_LOGE("%s: Unable to allocate %lu ring slots!\n", __FUNCTION__, size);
+      return -1;
+   }
+
+   for (i = 0; i < size; i++) {
+      ring->slots[i].seq = i;
+   }
+   ring->mask = size - 1;
+   ring->enq_pos = 0;
+   ring->deq_pos = 0;
+
+   return 0;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_push
+
+DESCRIPTION
+   Lock-free enqueue of one message onto a lane's ring. Safe for any number
+   of concurrent producers.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   1 if queued; 0 if the ring is full
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_ring_push(msg_q* p_msg_q, msg_q_ring* ring,
+                           void* msg_obj, void (*dealloc)(void*))
+{
+   unsigned long pos = __atomic_load_n(&ring->enq_pos, __ATOMIC_RELAXED);
+
+   for (;;) {
+      msg_q_ring_slot* slot = &ring->slots[pos & ring->mask];
+      unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+      long diff = (long)(seq - pos);
+
+      if (0 == diff) {
+         /* slot is free for this position, try to claim it */
+         if (__atomic_compare_exchange_n(&ring->enq_pos, &pos, pos + 1, 1,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            slot->msg_obj = msg_obj;
+            slot->dealloc = dealloc;
+            __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+            return 1;
+         }
+         /* lost the race, pos now holds the current enq_pos */
+         MSG_Q_STAT_INC(p_msg_q, contended);
+      } else if (diff < 0) {
+         /* consumer has not released this slot yet, ring is full */
+         return 0;
+      } else {
+         pos = __atomic_load_n(&ring->enq_pos, __ATOMIC_RELAXED);
+      }
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_pop
+
+DESCRIPTION
+   Dequeues the oldest message from a ring. Consumer thread only.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   1 if a message was dequeued; 0 if the head slot is not yet published
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_ring_pop(msg_q_ring* ring, void** msg_obj, void (**dealloc)(void*))
+{
+   unsigned long pos = __atomic_load_n(&ring->deq_pos, __ATOMIC_RELAXED);
+   msg_q_ring_slot* slot = &ring->slots[pos & ring->mask];
+   unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+   if ((long)(seq - (pos + 1)) < 0) {
+      return 0;
+   }
+
+   *msg_obj = slot->msg_obj;
+   if (NULL != dealloc) {
+      *dealloc = slot->dealloc;
+   }
+   /* hand the slot back to producers for the next lap */
+   __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+   __atomic_store_n(&ring->deq_pos, pos + 1, __ATOMIC_SEQ_CST);
+
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_idle
+
+DESCRIPTION
+   Checks whether no producer has claimed a ring slot that the consumer has
+   not yet taken, i.e. the ring is empty and no enqueue is in flight.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   non-zero if idle
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static inline int msg_q_ring_idle(msg_q_ring* ring)
+{
+   return __atomic_load_n(&ring->enq_pos, __ATOMIC_SEQ_CST) ==
+          __atomic_load_n(&ring->deq_pos, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_wake
+
+DESCRIPTION
+   Wakes the consumer if it is blocked or about to block on the eventfd.
+   Producers only pay for the write() when the consumer is actually idle.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void msg_q_ring_wake(msg_q* p_msg_q, int force)
+{
+   /* plain load first so the common, consumer busy case stays read-only */
+   if (force || (__atomic_load_n(&p_msg_q->sleeping, __ATOMIC_SEQ_CST) &&
+                 __atomic_exchange_n(&p_msg_q->sleeping, 0, __ATOMIC_SEQ_CST))) {
+      uint64_t one = 1;
+      if (write(p_msg_q->wake_fd, &one, sizeof(one)) != sizeof(one)) {
+         LOC_LOGE("%s: Unable to signal eventfd!\n", __FUNCTION__);
+      }
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_lane_pending
+
+DESCRIPTION
+   Checks whether a lane has anything for the consumer. For ring queues this
+   includes slots claimed by a producer but not yet published. list_mutex
+   must be held for list queues.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   non-zero if pending
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_lane_pending(msg_q* p_msg_q, msg_q_lane* lane)
+{
+   if (eMSG_Q_TYPE_RING == p_msg_q->type) {
+      return !msg_q_ring_idle(&lane->ring) ||
+             __atomic_load_n(&lane->overflow_cnt, __ATOMIC_SEQ_CST) > 0;
+   }
+   return !linked_list_empty(lane->msg_list);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_select_lane
+
+DESCRIPTION
+   Picks the lane the consumer should take from next: the highest priority
+   lane with msgs pending, unless a lower priority lane has been passed
+   over MSG_Q_STARVATION_LIMIT times in a row.
+
+DEPENDENCIES
+   Consumer thread only; list_mutex must be held for list queues.
+
+RETURN VALUE
+   lane index; -1 if nothing is pending
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_select_lane(msg_q* p_msg_q)
+{
+   unsigned int i;
+
+   for (i = p_msg_q->num_lanes - 1; i > 0; i--) {
+      if (p_msg_q->lanes[i].skipped >= MSG_Q_STARVATION_LIMIT &&
+          msg_q_lane_pending(p_msg_q, &p_msg_q->lanes[i])) {
+         MSG_Q_STAT_INC(p_msg_q, starvation_picks);
+         return (int)i;
+      }
+   }
+
+   for (i = 0; i < p_msg_q->num_lanes; i++) {
+      if (msg_q_lane_pending(p_msg_q, &p_msg_q->lanes[i])) {
+         return (int)i;
+      }
+   }
+
+   return -1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_account_take
+
+DESCRIPTION
+   Updates starvation bookkeeping after a msg was taken from lane taken.
+
+DEPENDENCIES
+   Consumer thread only; list_mutex must be held for list queues.
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void msg_q_account_take(msg_q* p_msg_q, unsigned int taken)
+{
+   unsigned int i;
+
+   p_msg_q->lanes[taken].skipped = 0;
+   for (i = taken + 1; i < p_msg_q->num_lanes; i++) {
+      if (msg_q_lane_pending(p_msg_q, &p_msg_q->lanes[i])) {
+         p_msg_q->lanes[i].skipped++;
+      }
+   }
+   MSG_Q_STAT_INC(p_msg_q, received);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_list_take
+
+DESCRIPTION
+   Takes the next message of a list queue, honoring lane priority.
+
+DEPENDENCIES
+   list_mutex must be held.
+
+RETURN VALUE
+   1 if a message was taken; 0 if the queue is empty
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_list_take(msg_q* p_msg_q, void** msg_obj)
+{
+   int lane = msg_q_select_lane(p_msg_q);
+
+   if (lane < 0 ||
+       eLINKED_LIST_SUCCESS != linked_list_remove(p_msg_q->lanes[lane].msg_list, msg_obj)) {
+      return 0;
+   }
+   msg_q_account_take(p_msg_q, (unsigned int)lane);
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_lane_take
+
+DESCRIPTION
+   Takes the oldest message of one ring lane, ring first and then the
+   overflow list. The overflow list is only touched once the ring is idle,
+   so the per-producer send order is preserved across the two stores.
+
+DEPENDENCIES
+   Consumer thread only.
+
+RETURN VALUE
+   1 if a message was taken; 0 if a producer is still publishing
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int msg_q_ring_lane_take(msg_q* p_msg_q, msg_q_lane* lane, void** msg_obj)
+{
+   if (msg_q_ring_pop(&lane->ring, msg_obj, NULL)) {
+      return 1;
+   }
+
+   if (!msg_q_ring_idle(&lane->ring)) {
+      /* a producer claimed the head slot and is still filling it */
+      return 0;
+   }
+
+   if (__atomic_load_n(&lane->overflow_cnt, __ATOMIC_SEQ_CST) > 0) {
+      /* Ring is empty; move parked msgs back into it, oldest first, so
+         that producers can return to the lock-free path once the
+         overflow list is drained. Producers queue behind the mutex
+         meanwhile, which keeps the parked msgs ahead of theirs. */
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+      while (__atomic_load_n(&lane->overflow_cnt, __ATOMIC_RELAXED) > 0) {
+         void* parked = NULL;
+         void (*dealloc)(void*) = NULL;
+         if (eLINKED_LIST_SUCCESS != linked_list_peek_tail(lane->msg_list,
+                                                           &parked, &dealloc) ||
+             !msg_q_ring_push(p_msg_q, &lane->ring, parked, dealloc)) {
+            break;
+         }
+         linked_list_remove(lane->msg_list, &parked);
+         __atomic_fetch_sub(&lane->overflow_cnt, 1, __ATOMIC_SEQ_CST);
+      }
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+      return msg_q_ring_pop(&lane->ring, msg_obj, NULL);
+   }
+
+   return 0;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_take
+
+DESCRIPTION
+   Takes the next message of a ring queue, honoring lane priority.
+
+   p_msg_q:   Message Queue to take from.
+   msg_obj:   Pointer to space to copy msg_q contents to.
+   block:     Wait for a message if there is none.
+   wait_busy: Wait for a producer that is still publishing the next msg;
+              if 0, that case is reported as eMSG_Q_EMPTY.
+
+DEPENDENCIES
+   Consumer thread only.
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static msq_q_err_type msg_q_ring_take(msg_q* p_msg_q, void** msg_obj,
+                                      int block, int wait_busy)
+{
+   for (;;) {
+      int lane;
+
+      if (__atomic_load_n(&p_msg_q->unblocked, __ATOMIC_ACQUIRE)) {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+
+      lane = msg_q_select_lane(p_msg_q);
+      if (lane >= 0) {
+         if (msg_q_ring_lane_take(p_msg_q, &p_msg_q->lanes[lane], msg_obj)) {
+            msg_q_account_take(p_msg_q, (unsigned int)lane);
+            return eMSG_Q_SUCCESS;
+         }
+         if (!wait_busy) {
+            return eMSG_Q_EMPTY;
+         }
+         sched_yield();
+         continue;
+      }
+
+      if (!block) {
+         return eMSG_Q_EMPTY;
+      }
+
+      /* Announce the intent to sleep, then re-check so that a producer that
+         enqueued in between either is seen here or sees the flag. */
+      __atomic_store_n(&p_msg_q->sleeping, 1, __ATOMIC_SEQ_CST);
+      if (msg_q_select_lane(p_msg_q) < 0 &&
+          !__atomic_load_n(&p_msg_q->unblocked, __ATOMIC_SEQ_CST)) {
+         uint64_t count;
+         MSG_Q_STAT_INC(p_msg_q, wakeups);
+         if (read(p_msg_q->wake_fd, &count, sizeof(count)) < 0) {
+            LOC_LOGE("%s: Unable to wait on eventfd!\n", __FUNCTION__);
+         }
+      }
+      __atomic_store_n(&p_msg_q->sleeping, 0, __ATOMIC_SEQ_CST);
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_free
+
+DESCRIPTION
+   Releases everything msg_q_init / msg_q_init3 may have allocated.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void msg_q_free(msg_q* p_msg_q)
+{
+   unsigned int i;
+
+   for (i = 0; i < MSG_Q_MAX_LANES; i++) {
+      if (NULL != p_msg_q->lanes[i].msg_list) {
+         linked_list_destroy(&p_msg_q->lanes[i].msg_list);
+      }
+      free(p_msg_q->lanes[i].ring.slots);
+      p_msg_q->lanes[i].ring.slots = NULL;
+   }
+   if (p_msg_q->wake_fd >= 0) {
+      close(p_msg_q->wake_fd);
+   }
+   free(p_msg_q);
+}
+
 /* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
 
 /*===========================================================================
@@ -108,7 +603,9 @@ msq_q_err_type msg_q_init(void** msg_q_data)
       return eMSG_Q_FAILURE_GENERAL;
    }
 
-   if( linked_list_init(&tmp_msg_q->msg_list) != 0 )
+   tmp_msg_q->wake_fd = -1;
+
+   if( linked_list_init(&tmp_msg_q->lanes[0].msg_list) != 0 )
    {
       LOC_LOGE("%s: Unable to initialize storage list!\n", __FUNCTION__);
       free(tmp_msg_q);
@@ -118,7 +615,7 @@ msq_q_err_type msg_q_init(void** msg_q_data)
    if( pthread_mutex_init(&tmp_msg_q->list_mutex, NULL) != 0 )
    {
       LOC_LOGE("%s: Unable to initialize list mutex!\n", __FUNCTION__);
-      linked_list_destroy(&tmp_msg_q->msg_list);
+      linked_list_destroy(&tmp_msg_q->lanes[0].msg_list);
       free(tmp_msg_q);
       return eMSG_Q_FAILURE_GENERAL;
    }
@@ -126,13 +623,15 @@ msq_q_err_type msg_q_init(void** msg_q_data)
    if( pthread_cond_init(&tmp_msg_q->list_cond, NULL) != 0 )
    {
       LOC_LOGE("%s: Unable to initialize msg q cond var!\n", __FUNCTION__);
-      linked_list_destroy(&tmp_msg_q->msg_list);
+      linked_list_destroy(&tmp_msg_q->lanes[0].msg_list);
       pthread_mutex_destroy(&tmp_msg_q->list_mutex);
       free(tmp_msg_q);
       return eMSG_Q_FAILURE_GENERAL;
    }
 
    tmp_msg_q->unblocked = 0;
+   tmp_msg_q->type = eMSG_Q_TYPE_LIST;
+   tmp_msg_q->num_lanes = 1;
 
    *msg_q_data = tmp_msg_q;
 
@@ -153,6 +652,63 @@ const void* msg_q_init2()
   return q;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_init3
+
+  ===========================================================================*/
+const void* msg_q_init3(msg_q_type type, unsigned int capacity, unsigned int num_lanes)
+{
+  void* q = NULL;
+  msg_q* p_msg_q;
+  unsigned int i;
+
+  if (eMSG_Q_SUCCESS != msg_q_init(&q)) {
+    return NULL;
+  }
+  p_msg_q = (msg_q*)q;
+
+  if (0 == num_lanes) {
+    num_lanes = 1;
+  } else if (num_lanes > MSG_Q_MAX_LANES) {
+    LOC_LOGW("%s: %u lanes requested, using %u\n", __FUNCTION__, num_lanes, MSG_Q_MAX_LANES);
+    num_lanes = MSG_Q_MAX_LANES;
+  }
+
+  for (i = 1; i < num_lanes; i++) {
+    if (linked_list_init(&p_msg_q->lanes[i].msg_list) != 0) {
+      LOC_LOGE("%s: Unable to initialize storage list!\n", __FUNCTION__);
+      pthread_mutex_destroy(&p_msg_q->list_mutex);
+      pthread_cond_destroy(&p_msg_q->list_cond);
+      msg_q_free(p_msg_q);
+      return NULL;
+    }
+  }
+  p_msg_q->num_lanes = num_lanes;
+
+  if (eMSG_Q_TYPE_RING == type) {
+    int ok = 1;
+    for (i = 0; ok && i < num_lanes; i++) {
+      ok = (0 == msg_q_ring_init(&p_msg_q->lanes[i].ring, capacity));
+    }
+    if (ok) {
+      p_msg_q->wake_fd = eventfd(0, EFD_CLOEXEC);
+      ok = (p_msg_q->wake_fd >= 0);
+    }
+
+    if (ok) {
+      p_msg_q->type = eMSG_Q_TYPE_RING;
+    } else {
+      LOC_LOGW("%s: falling back to list message queue\n", __FUNCTION__);
+      for (i = 0; i < num_lanes; i++) {
+        free(p_msg_q->lanes[i].ring.slots);
+        p_msg_q->lanes[i].ring.slots = NULL;
+      }
+    }
+  }
+  return q;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_destroy
@@ -168,13 +724,12 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
 
    msg_q* p_msg_q = (msg_q*)*msg_q_data;
 
-   linked_list_destroy(&p_msg_q->msg_list);
    pthread_mutex_destroy(&p_msg_q->list_mutex);
    pthread_cond_destroy(&p_msg_q->list_cond);
 
    p_msg_q->unblocked = 0;
 
-   free(*msg_q_data);
+   msg_q_free(p_msg_q);
    *msg_q_data = NULL;
 
    return eMSG_Q_SUCCESS;
@@ -186,6 +741,17 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
 
   ===========================================================================*/
 msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*))
+{
+   return msg_q_snd2(msg_q_data, msg_obj, dealloc, 0);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_snd2
+
+  ===========================================================================*/
+msq_q_err_type msg_q_snd2(void* msg_q_data, void* msg_obj, void (*dealloc)(void*),
+                          unsigned int lane_idx)
 {
    msq_q_err_type rv;
    if( msg_q_data == NULL )
@@ -200,10 +766,57 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
    }
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
+   if( lane_idx >= p_msg_q->num_lanes )
+   {
+      lane_idx = p_msg_q->num_lanes - 1;
+   }
+   msg_q_lane* lane = &p_msg_q->lanes[lane_idx];
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
    LOC_LOGV("%s: Sending message with handle = %p\n", __FUNCTION__, msg_obj);
 
+   if (eMSG_Q_TYPE_RING == p_msg_q->type)
+   {
+      if( __atomic_load_n(&p_msg_q->unblocked, __ATOMIC_ACQUIRE) )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+
+      /* Once anything is parked on the overflow list, keep appending there
+         until the consumer drains it, so that send order is preserved. */
+      if( 0 == __atomic_load_n(&lane->overflow_cnt, __ATOMIC_SEQ_CST) &&
+          msg_q_ring_push(p_msg_q, &lane->ring, msg_obj, dealloc) )
+      {
+         rv = eMSG_Q_SUCCESS;
+      }
+      else
+      {
+         pthread_mutex_lock(&p_msg_q->list_mutex);
+         rv = convert_linked_list_err_type(linked_list_add(lane->msg_list, msg_obj, dealloc));
+         if( eMSG_Q_SUCCESS == rv )
+         {
+            __atomic_fetch_add(&lane->overflow_cnt, 1, __ATOMIC_SEQ_CST);
+            MSG_Q_STAT_INC(p_msg_q, overflowed);
+         }
+         pthread_mutex_unlock(&p_msg_q->list_mutex);
+      }
+
+      if( eMSG_Q_SUCCESS == rv )
+      {
+         MSG_Q_STAT_INC(p_msg_q, sent);
+         msg_q_ring_wake(p_msg_q, 0);
+      }
+
+      LOC_LOGV("%s: Finished Sending message with handle = %p\n", __FUNCTION__, msg_obj);
+      return rv;
+   }
+
+   if( pthread_mutex_trylock(&p_msg_q->list_mutex) != 0 )
+   {
+      MSG_Q_STAT_INC(p_msg_q, contended);
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+   }
+
    if( p_msg_q->unblocked )
    {
       LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
@@ -211,7 +824,11 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
-   rv = convert_linked_list_err_type(linked_list_add(p_msg_q->msg_list, msg_obj, dealloc));
+   rv = convert_linked_list_err_type(linked_list_add(lane->msg_list, msg_obj, dealloc));
+   if( eMSG_Q_SUCCESS == rv )
+   {
+      MSG_Q_STAT_INC(p_msg_q, sent);
+   }
 
    /* Show data is in the message queue. */
    pthread_cond_signal(&p_msg_q->list_cond);
@@ -245,6 +862,13 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if (eMSG_Q_TYPE_RING == p_msg_q->type)
+   {
+      rv = msg_q_ring_take(p_msg_q, msg_obj, 1, 1);
+      LOC_LOGV("%s: Received message %p rv = %d\n", __FUNCTION__, *msg_obj, rv);
+      return rv;
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    if( p_msg_q->unblocked )
@@ -255,12 +879,13 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
    }
 
    /* Wait for data in the message queue */
-   while( linked_list_empty(p_msg_q->msg_list) && !p_msg_q->unblocked )
+   while( msg_q_select_lane(p_msg_q) < 0 && !p_msg_q->unblocked )
    {
+      MSG_Q_STAT_INC(p_msg_q, wakeups);
       pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
    }
 
-   rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->msg_list, msg_obj));
+   rv = msg_q_list_take(p_msg_q, msg_obj) ? eMSG_Q_SUCCESS : eMSG_Q_UNAVAILABLE_RESOURCE;
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
@@ -269,6 +894,91 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
    return rv;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv_batch
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs,
+                               unsigned int max_objs, unsigned int* num_objs)
+{
+   msq_q_err_type rv;
+   unsigned int count = 0;
+   unsigned int bucket = 0;
+
+   if( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   if( msg_objs == NULL || num_objs == NULL || max_objs == 0 )
+   {
+      LOC_LOGE("%s: Invalid msg_objs parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+   *num_objs = 0;
+
+   if (eMSG_Q_TYPE_RING == p_msg_q->type)
+   {
+      rv = msg_q_ring_take(p_msg_q, &msg_objs[0], 1, 1);
+      if( eMSG_Q_SUCCESS != rv )
+      {
+         return rv;
+      }
+      /* the rest of the burst only if already published, no waiting */
+      for( count = 1;
+           count < max_objs &&
+           eMSG_Q_SUCCESS == msg_q_ring_take(p_msg_q, &msg_objs[count], 0, 0);
+           count++ );
+   }
+   else
+   {
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+
+      if( p_msg_q->unblocked )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         pthread_mutex_unlock(&p_msg_q->list_mutex);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+
+      /* Wait for data in the message queue */
+      while( msg_q_select_lane(p_msg_q) < 0 && !p_msg_q->unblocked )
+      {
+         MSG_Q_STAT_INC(p_msg_q, wakeups);
+         pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
+      }
+
+      /* Take the whole pending burst under this one lock */
+      while( count < max_objs && msg_q_list_take(p_msg_q, &msg_objs[count]) )
+      {
+         count++;
+      }
+
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+      if( 0 == count )
+      {
+         /* woken up by msg_q_unblock */
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+   }
+
+   while( bucket < MSG_Q_BATCH_BUCKETS - 1 && (count >> (bucket + 1)) != 0 )
+   {
+      bucket++;
+   }
+   MSG_Q_STAT_INC(p_msg_q, batch_hist[bucket]);
+
+   *num_objs = count;
+   LOC_LOGV("%s: Received %u messages\n", __FUNCTION__, count);
+
+   return eMSG_Q_SUCCESS;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_rmv
@@ -289,6 +999,14 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if (eMSG_Q_TYPE_RING == p_msg_q->type) {
+      rv = msg_q_ring_take(p_msg_q, msg_obj, 0, 1);
+      if (eMSG_Q_EMPTY == rv) {
+         LOC_LOGW("%s: list is empty !!\n", __FUNCTION__);
+      }
+      return rv;
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    if (p_msg_q->unblocked) {
@@ -297,13 +1015,12 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
-   if (linked_list_empty(p_msg_q->msg_list)) {
+   if (!msg_q_list_take(p_msg_q, msg_obj)) {
       LOC_LOGW("%s: list is empty !!\n", __FUNCTION__);
       pthread_mutex_unlock(&p_msg_q->list_mutex);
       return eMSG_Q_EMPTY;
    }
-
-   rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->msg_list, msg_obj));
+   rv = eMSG_Q_SUCCESS;
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
@@ -321,7 +1038,8 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
   ===========================================================================*/
 msq_q_err_type msg_q_flush(void* msg_q_data)
 {
-   msq_q_err_type rv;
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+   unsigned int i;
    if ( msg_q_data == NULL )
    {
       LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
@@ -332,12 +1050,35 @@ msq_q_err_type msg_q_flush(void* msg_q_data)
 
    LOC_LOGD("%s: Flushing Message Queue\n", __FUNCTION__);
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
-
-   /* Remove all elements from the list */
-   rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
+   for (i = 0; i < p_msg_q->num_lanes; i++)
+   {
+      msg_q_lane* lane = &p_msg_q->lanes[i];
+
+      if (eMSG_Q_TYPE_RING == p_msg_q->type)
+      {
+         void* msg_obj;
+         void (*dealloc)(void*);
+         /* Drain whatever is published; like the list, dealloc what we can */
+         while( msg_q_ring_pop(&lane->ring, &msg_obj, &dealloc) )
+         {
+            if( NULL != dealloc )
+            {
+               dealloc(msg_obj);
+            }
+         }
+      }
+
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+
+      /* Remove all elements from the list */
+      if (eMSG_Q_SUCCESS == rv)
+      {
+         rv = convert_linked_list_err_type(linked_list_flush(lane->msg_list));
+      }
+      __atomic_store_n(&lane->overflow_cnt, 0, __ATOMIC_SEQ_CST);
 
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+   }
 
    LOC_LOGD("%s: Message Queue flushed\n", __FUNCTION__);
 
@@ -369,9 +1110,13 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
 
    LOC_LOGD("%s: Unblocking Message Queue\n", __FUNCTION__);
    /* Unblocking message queue */
-   p_msg_q->unblocked = 1;
+   __atomic_store_n(&p_msg_q->unblocked, 1, __ATOMIC_SEQ_CST);
 
    /* Allow all the waiters to wake up */
+   if (eMSG_Q_TYPE_RING == p_msg_q->type)
+   {
+      msg_q_ring_wake(p_msg_q, 1);
+   }
    pthread_cond_broadcast(&p_msg_q->list_cond);
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
@@ -380,3 +1125,78 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
 
    return eMSG_Q_SUCCESS;
 }
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_get_stats
+
+  ===========================================================================*/
+msq_q_err_type msg_q_get_stats(void* msg_q_data, msg_q_stats* stats)
+{
+   if ( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   if ( stats == NULL )
+   {
+      LOC_LOGE("%s: Invalid stats parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+
+   stats->sent = __atomic_load_n(&p_msg_q->stats.sent, __ATOMIC_RELAXED);
+   stats->received = __atomic_load_n(&p_msg_q->stats.received, __ATOMIC_RELAXED);
+   stats->allocations = 0;
+   stats->node_reused = 0;
+   stats->nodes_pooled = 0;
+   stats->nodes_peak = 0;
+   for (unsigned int i = 0; i < p_msg_q->num_lanes; i++) {
+      linked_list_stats list_stats;
+      if (eLINKED_LIST_SUCCESS ==
+            linked_list_get_stats(p_msg_q->lanes[i].msg_list, &list_stats)) {
+         stats->allocations += list_stats.allocations;
+         stats->node_reused += list_stats.reused;
+         stats->nodes_pooled += list_stats.pooled;
+         stats->nodes_peak += list_stats.peak_in_use;
+      }
+   }
+   stats->contended = __atomic_load_n(&p_msg_q->stats.contended, __ATOMIC_RELAXED);
+   stats->overflowed = __atomic_load_n(&p_msg_q->stats.overflowed, __ATOMIC_RELAXED);
+   stats->wakeups = __atomic_load_n(&p_msg_q->stats.wakeups, __ATOMIC_RELAXED);
+   stats->starvation_picks =
+         __atomic_load_n(&p_msg_q->stats.starvation_picks, __ATOMIC_RELAXED);
+   for (int i = 0; i < MSG_Q_BATCH_BUCKETS; i++) {
+      stats->batch_hist[i] = __atomic_load_n(&p_msg_q->stats.batch_hist[i], __ATOMIC_RELAXED);
+   }
+
+   return eMSG_Q_SUCCESS;
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_set_node_pool_max
+
+  ===========================================================================*/
+msq_q_err_type msg_q_set_node_pool_max(void* msg_q_data, unsigned int pool_max)
+{
+   if ( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+   for (unsigned int i = 0; eMSG_Q_SUCCESS == rv && i < p_msg_q->num_lanes; i++) {
+      rv = convert_linked_list_err_type(
+            linked_list_set_pool_max(p_msg_q->lanes[i].msg_list, pool_max));
+   }
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   return rv;
+}
@@ -34,6 +34,7 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include <stdlib.h>
+#include <stdint.h>
 
 /** Linked List Return Codes */
 typedef enum
@@ -54,6 +55,45 @@ typedef enum
      /**< Failed because list is empty. */
 }msq_q_err_type;
 
+/** Message Queue Storage Types */
+typedef enum
+{
+  eMSG_Q_TYPE_LIST                           = 0,
+     /**< Mutex protected linked list, one allocation per message. */
+  eMSG_Q_TYPE_RING                           = 1
+     /**< Bounded lock-free multi-producer / single-consumer ring. Messages
+          that do not fit are parked on the linked list until the ring
+          drains, so a send never fails or blocks because of capacity. */
+}msg_q_type;
+
+/** Max number of priority lanes of a message queue, see msg_q_init3 */
+#define MSG_Q_MAX_LANES 4
+
+/** Number of log2 buckets in the rcv_batch size histogram; bucket i counts
+    batches of [2^i, 2^(i+1)) messages, the last bucket is open ended. */
+#define MSG_Q_BATCH_BUCKETS 6
+
+/** Message Queue Counters */
+typedef struct
+{
+  uint64_t sent;         /**< Messages successfully queued. */
+  uint64_t received;     /**< Messages handed out by rcv / rmv. */
+  uint64_t allocations;  /**< List nodes malloc'ed on the send path. */
+  uint64_t node_reused;  /**< Sends that took a list node from a node pool
+                              instead, see msg_q_set_node_pool_max. */
+  uint32_t nodes_pooled; /**< Free list nodes currently kept for reuse. */
+  uint32_t nodes_peak;   /**< Sum of the per lane max of list nodes in use. */
+  uint64_t contended;    /**< Sends that found the mutex held (list) or
+                              lost a slot claim race (ring). */
+  uint64_t overflowed;   /**< Ring sends that spilled to the linked list. */
+  uint64_t wakeups;      /**< Times the consumer had to block and be woken. */
+  uint64_t starvation_picks;
+                         /**< Takes from a low priority lane forced by the
+                              starvation guard. */
+  uint64_t batch_hist[MSG_Q_BATCH_BUCKETS];
+                         /**< msg_q_rcv_batch batch size distribution. */
+}msg_q_stats;
+
 /*===========================================================================
 FUNCTION    msg_q_init
 
@@ -92,6 +132,36 @@ SIDE EFFECTS
 ===========================================================================*/
 const void* msg_q_init2();
 
+/*===========================================================================
+FUNCTION    msg_q_init3
+
+DESCRIPTION
+   Initializes internal structures for message queue of the given storage
+   type. With eMSG_Q_TYPE_RING, only a single thread may call msg_q_rcv /
+   msg_q_rmv on the returned queue.
+
+   The queue has num_lanes priority lanes, each FIFO on its own. Receivers
+   take from the lowest numbered lane that has messages, except that a lane
+   passed over for too long while it had messages pending is served next,
+   so that lower priority lanes are never starved.
+
+   type:      storage type of the queue, see msg_q_type.
+   capacity:  number of ring slots per lane, rounded up to a power of 2; 0
+              selects the default. Ignored for eMSG_Q_TYPE_LIST.
+   num_lanes: number of priority lanes, 1 to MSG_Q_MAX_LANES.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   opaque handle to the Q created; NULL if create fails
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+const void* msg_q_init3(msg_q_type type, unsigned int capacity, unsigned int num_lanes);
+
 /*===========================================================================
 FUNCTION    msg_q_destroy
 
@@ -137,6 +207,33 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*));
 
+/*===========================================================================
+FUNCTION    msg_q_snd2
+
+DESCRIPTION
+   Same as msg_q_snd, into the given priority lane. msg_q_snd sends into
+   lane 0. A lane beyond those the queue was created with maps to its
+   lowest priority lane.
+
+   msg_q_data: Message Queue to add the element to.
+   msgp:       Pointer to data to add into message queue.
+   dealloc:    Function used to deallocate memory for this element. Pass NULL
+               if you do not want data deallocated during a flush operation
+   lane:       Priority lane, 0 is the highest priority.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_snd2(void* msg_q_data, void* msg_obj, void (*dealloc)(void*),
+                          unsigned int lane);
+
 /*===========================================================================
 FUNCTION    msg_q_rcv
 
@@ -159,6 +256,33 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj);
 
+/*===========================================================================
+FUNCTION    msg_q_rcv_batch
+
+DESCRIPTION
+   Retrieves up to max_objs messages from the message queue in one go,
+   oldest first. Blocks like msg_q_rcv until at least one message is
+   available, then takes whatever else is pending without waiting again,
+   so a burst costs a single lock round-trip (list) or none (ring).
+
+   msg_q_data: Message Queue to copy data from.
+   msg_objs:   Array to copy msg_q contents to.
+   max_objs:   Capacity of msg_objs.
+   num_objs:   Number of messages stored in msg_objs.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs,
+                               unsigned int max_objs, unsigned int* num_objs);
+
 /*===========================================================================
 FUNCTION    msg_q_rmv
 
@@ -225,6 +349,53 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_unblock(void* msg_q_data);
 
+/*===========================================================================
+FUNCTION    msg_q_get_stats
+
+DESCRIPTION
+   Takes a snapshot of the message queue counters. Counters are cumulative
+   since the queue was created, so callers diff two snapshots to measure an
+   interval.
+
+   msg_q_data: Message queue to query.
+   stats:      Pointer to the counters to fill in.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_get_stats(void* msg_q_data, msg_q_stats* stats);
+
+/*===========================================================================
+FUNCTION    msg_q_set_node_pool_max
+
+DESCRIPTION
+   Sets the high-water mark of the list node pool of each lane, see
+   linked_list_set_pool_max. Lanes keep LINKED_LIST_POOL_DEFAULT_MAX free
+   nodes unless told otherwise, so that once the queue has seen its usual
+   depth, sending and receiving does no heap allocation.
+
+   msg_q_data: Message queue to configure.
+   pool_max:   Max number of free nodes to keep per lane; 0 disables.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_set_node_pool_max(void* msg_q_data, unsigned int pool_max);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2020 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libqti-perfd-client"
+
+#include <aidl/android/hardware/power/IPower.h>
+#include <android/binder_manager.h>
+#include <log/log.h>
+
+#include "perf_stats.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ::aidl::android::hardware::power::Boost;
+using ::aidl::android::hardware::power::IPower;
+using ::aidl::android::hardware::power::Mode;
+
+/*
+ * Perf locks of the vendor blobs, mapped onto the power HAL. A lock with a
+ * duration becomes an INTERACTION boost for that long, a lock without one
+ * holds the LAUNCH mode until it is released. The opcodes are not decoded,
+ * the power HAL decides what a boost does on this device, but they tell
+ * locks apart: a timed lock whose opcode list matches one already boosted
+ * for at least as long does not reach the power HAL again.
+ */
+
+// a lock without duration that is never released must not hold the mode forever
+#define PERF_LOCK_UNTIMED_MAX_MS 30000
+// perf_hint without duration
+#define PERF_HINT_DEFAULT_MS 1000
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct PerfLock {
+    bool timed;
+    Clock::time_point deadline;
+    // opcode, value pairs of perf_lock_acq, or the hint id and type of perf_hint
+    std::vector<int> resources;
+};
+
+class PerfLockManager {
+  public:
+    static PerfLockManager& getInstance() {
+        static PerfLockManager* instance = new PerfLockManager();
+        return *instance;
+    }
+
+    int acquire(int handle, int durationMs, std::vector<int>&& resources) {
+        bool timed = durationMs > 0;
+        bool boost = false;
+        bool sync;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+
+            sync = expireLocked();
+            if (handle <= 0 || mLocks.find(handle) == mLocks.end()) {
+                handle = mNextHandle++;
+                if (mNextHandle <= 0) {
+                    mNextHandle = 1;
+                }
+            }
+
+            Clock::time_point deadline =
+                    Clock::now() +
+                    std::chrono::milliseconds(timed ? durationMs : PERF_LOCK_UNTIMED_MAX_MS);
+            if (timed) {
+                boost = !coveredLocked(handle, resources, deadline);
+            }
+            auto it = mLocks.find(handle);
+            // the mode follows the untimed locks, before and after this one
+            sync |= !timed || (it != mLocks.end() && !it->second.timed);
+            PerfLock& perfLock = mLocks[handle];
+            perfLock.timed = timed;
+            perfLock.deadline = deadline;
+            perfLock.resources = std::move(resources);
+
+            startTimerLocked();
+            mCond.notify_one();
+        }
+
+        // the binder calls are made without mLock held
+        if (boost) {
+            setBoost(durationMs);
+        }
+        if (sync) {
+            syncMode();
+        }
+        return handle;
+    }
+
+    int release(int handle) {
+        bool timed;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+
+            auto it = mLocks.find(handle);
+            if (it == mLocks.end()) {
+                return -1;
+            }
+            timed = it->second.timed;
+            mLocks.erase(it);
+        }
+
+        if (timed) {
+            cancelBoost();
+        } else {
+            syncMode();
+        }
+        return 0;
+    }
+
+  private:
+    PerfLockManager() : mNextHandle(1), mTimerStarted(false), mModeOn(false) {}
+
+    /*
+     * Whether another timed lock with the same resources is boosted until
+     * deadline or later already.
+     */
+    bool coveredLocked(int handle, const std::vector<int>& resources,
+                       Clock::time_point deadline) const {
+        for (const auto& entry : mLocks) {
+            if (entry.first != handle && entry.second.timed &&
+                entry.second.deadline >= deadline && entry.second.resources == resources) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool anyLocked(bool timed) const {
+        for (const auto& entry : mLocks) {
+            if (entry.second.timed == timed) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::shared_ptr<IPower> getPowerHalLocked() {
+        if (!mPower) {
+            const std::string name = std::string(IPower::descriptor) + "/default";
+            ndk::SpAIBinder binder(AServiceManager_checkService(name.c_str()));
+            mPower = IPower::fromBinder(binder);
+            if (!mPower) {
+                ALOGW("power HAL not available");
+            }
+        }
+        return mPower;
+    }
+
+    void setBoostHalLocked(int durationMs) {
+        std::shared_ptr<IPower> power = getPowerHalLocked();
+        if (power && !power->setBoost(Boost::INTERACTION, durationMs).isOk()) {
+            ALOGW("setBoost INTERACTION %d failed", durationMs);
+            mPower = nullptr;
+        }
+    }
+
+    void setBoost(int durationMs) {
+        std::lock_guard<std::mutex> halLock(mHalLock);
+        setBoostHalLocked(durationMs);
+    }
+
+    /* Cancel the boost once no timed lock is left. */
+    void cancelBoost() {
+        std::lock_guard<std::mutex> halLock(mHalLock);
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            if (anyLocked(true)) {
+                return;
+            }
+        }
+        setBoostHalLocked(-1);
+    }
+
+    /*
+     * Bring the LAUNCH mode in line with the untimed locks. The state is read
+     * again under mHalLock, so racing callers leave the mode of the last one.
+     */
+    void syncMode() {
+        std::lock_guard<std::mutex> halLock(mHalLock);
+        bool modeOn;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            modeOn = anyLocked(false);
+        }
+        if (modeOn == mModeOn) {
+            return;
+        }
+
+        std::shared_ptr<IPower> power = getPowerHalLocked();
+        if (power && power->setMode(Mode::LAUNCH, modeOn).isOk()) {
+            mModeOn = modeOn;
+        } else {
+            ALOGW("setMode LAUNCH %d failed", modeOn);
+            mPower = nullptr;
+        }
+    }
+
+    /* Drop the locks past their deadline, true if the mode needs a sync. */
+    bool expireLocked() {
+        Clock::time_point now = Clock::now();
+        bool untimedExpired = false;
+
+        for (auto it = mLocks.begin(); it != mLocks.end();) {
+            if (it->second.deadline <= now) {
+                if (!it->second.timed) {
+                    ALOGW("perf lock %d held past %d ms, released", it->first,
+                          PERF_LOCK_UNTIMED_MAX_MS);
+                    untimedExpired = true;
+                }
+                it = mLocks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return untimedExpired;
+    }
+
+    void startTimerLocked() {
+        if (mTimerStarted) {
+            return;
+        }
+        mTimerStarted = true;
+        // the manager is never destroyed
+        std::thread([this]() { runTimer(); }).detach();
+    }
+
+    void runTimer() {
+        std::unique_lock<std::mutex> lock(mLock);
+
+        while (true) {
+            if (expireLocked()) {
+                lock.unlock();
+                syncMode();
+                lock.lock();
+                continue;
+            }
+            if (mLocks.empty()) {
+                mCond.wait(lock);
+                continue;
+            }
+
+            Clock::time_point next = Clock::time_point::max();
+            for (const auto& entry : mLocks) {
+                if (entry.second.deadline < next) {
+                    next = entry.second.deadline;
+                }
+            }
+            mCond.wait_until(lock, next);
+        }
+    }
+
+    // lock state, never held across a binder call
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::map<int, PerfLock> mLocks;
+    int mNextHandle;
+    bool mTimerStarted;
+    // orders the power HAL calls, taken before mLock
+    std::mutex mHalLock;
+    bool mModeOn;
+    std::shared_ptr<IPower> mPower;
+};
+
+}  // anonymous namespace
+
+extern "C" {
+
+int perf_get_feedback(int req, const char* pkg) {
+    (void)req;
+    (void)pkg;
+    return 0;
+}
+
+int perf_hint(int hint, const char* pkg, int duration, int type) {
+    ALOGV("perf_hint: hint: 0x%x, pkg: %s, duration: %d, type: %d", hint, pkg ? pkg : "",
+          duration, type);
+    perfStatsRecord(PERF_STATS_KIND_HINT, hint, duration);
+    return PerfLockManager::getInstance().acquire(
+            0, duration > 0 ? duration : PERF_HINT_DEFAULT_MS, {hint, type});
+}
+
+int perf_lock_acq(int handle, int duration, int list[], int numArgs) {
+    if (!list || numArgs <= 0) {
+        ALOGE("perf_lock_acq: no resources, handle: %d", handle);
+        return -1;
+    }
+    ALOGV("perf_lock_acq: handle: %d, duration: %d, list[0]: 0x%x, numArgs: %d", handle,
+          duration, list[0], numArgs);
+    // the list holds opcode, value pairs
+    for (int i = 0; i < numArgs; i += 2) {
+        perfStatsRecord(PERF_STATS_KIND_LOCK, list[i], duration);
+    }
+    return PerfLockManager::getInstance().acquire(handle, duration,
+                                                  std::vector<int>(list, list + numArgs));
+}
+
+int perf_lock_cmd(int cmd) {
+    (void)cmd;
+    return 0;
+}
+
+int perf_lock_rel(int handle) {
+    ALOGV("perf_lock_rel: handle: %d", handle);
+    return PerfLockManager::getInstance().release(handle);
+}
+
+int perf_lock_use_profile(int handle, int profile) {
+    (void)profile;
+    return handle;
+}
+
+}  // extern "C"
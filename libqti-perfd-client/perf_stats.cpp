@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2020 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libqti-perfd-client"
+
+#include "perf_stats.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace {
+
+PerfStatsBlock* mapBlock() {
+    std::string name = getprogname() ? getprogname() : "unknown";
+    for (char& c : name) {
+        if (c == '/') c = '_';
+    }
+    std::string path = std::string(PERF_STATS_DIR) + "/" + name + PERF_STATS_SUFFIX;
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        ALOGV("no perf stats for %s", name.c_str());
+        return nullptr;
+    }
+
+    // another instance of the same process may be setting the block up
+    flock(fd, LOCK_EX);
+
+    PerfStatsBlock* block = nullptr;
+    struct stat st;
+    if (fstat(fd, &st) == 0 &&
+        (st.st_size == sizeof(PerfStatsBlock) || ftruncate(fd, sizeof(PerfStatsBlock)) == 0)) {
+        void* addr =
+                mmap(nullptr, sizeof(PerfStatsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED) {
+            block = static_cast<PerfStatsBlock*>(addr);
+        }
+    }
+
+    if (block && (block->magic != PERF_STATS_MAGIC || block->version != PERF_STATS_VERSION)) {
+        // new file, or left over from another layout
+        memset(static_cast<void*>(block), 0, sizeof(PerfStatsBlock));
+        block->version = PERF_STATS_VERSION;
+        block->startSec = time(nullptr);
+        block->magic = PERF_STATS_MAGIC;
+    }
+
+    flock(fd, LOCK_UN);
+    close(fd);
+
+    if (!block) {
+        ALOGE("failed to map %s", path.c_str());
+    }
+    return block;
+}
+
+PerfStatsEntry* findEntry(PerfStatsBlock* block, uint64_t key) {
+    for (PerfStatsEntry& entry : block->entries) {
+        uint64_t current = entry.key.load(std::memory_order_relaxed);
+        if (current == key) {
+            return &entry;
+        }
+        if (current == 0) {
+            uint64_t expected = 0;
+            if (entry.key.compare_exchange_strong(expected, key) || expected == key) {
+                return &entry;
+            }
+        }
+    }
+    return nullptr;
+}
+
+}  // anonymous namespace
+
+void perfStatsRecord(uint32_t kind, uint32_t id, int durationMs) {
+    static std::once_flag once;
+    static PerfStatsBlock* block;
+
+    std::call_once(once, []() { block = mapBlock(); });
+    if (!block) {
+        return;
+    }
+
+    PerfStatsEntry* entry = findEntry(block, perfStatsKey(kind, id));
+    if (!entry) {
+        block->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    entry->count.fetch_add(1, std::memory_order_relaxed);
+    if (durationMs <= 0) {
+        entry->untimed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t ms = durationMs;
+    entry->totalMs.fetch_add(ms, std::memory_order_relaxed);
+    uint64_t max = entry->maxMs.load(std::memory_order_relaxed);
+    while (ms > max && !entry->maxMs.compare_exchange_weak(max, ms, std::memory_order_relaxed)) {
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Counter block every process using libqti-perfd-client keeps in
+ * PERF_STATS_DIR/<process>.stats. The file is mapped shared, so several
+ * instances of the same process add to the same counters and
+ * perfd-client-stats reads them without asking anybody.
+ */
+
+#define PERF_STATS_DIR "/data/vendor/perfd"
+#define PERF_STATS_SUFFIX ".stats"
+#define PERF_STATS_MAGIC 0x54535046  // "PFST"
+#define PERF_STATS_VERSION 1
+#define PERF_STATS_MAX_ENTRIES 128
+
+enum PerfStatsKind : uint32_t {
+    PERF_STATS_KIND_LOCK = 1,  // id is a perf_lock_acq opcode
+    PERF_STATS_KIND_HINT = 2,  // id is a perf_hint id
+};
+
+struct PerfStatsEntry {
+    // kind << 32 | id, 0 while the entry is free
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> count;
+    // requests without a duration, held until perf_lock_rel
+    std::atomic<uint64_t> untimed;
+    std::atomic<uint64_t> totalMs;
+    std::atomic<uint64_t> maxMs;
+};
+
+struct PerfStatsBlock {
+    uint32_t magic;
+    uint32_t version;
+    // CLOCK_REALTIME seconds when the counters started
+    uint64_t startSec;
+    // requests that found the table full
+    std::atomic<uint64_t> dropped;
+    PerfStatsEntry entries[PERF_STATS_MAX_ENTRIES];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "counters are shared between processes");
+
+static inline uint64_t perfStatsKey(uint32_t kind, uint32_t id) {
+    return (static_cast<uint64_t>(kind) << 32) | id;
+}
+
+/* Count a request of the calling process, no-op while the block can't be mapped. */
+void perfStatsRecord(uint32_t kind, uint32_t id, int durationMs);
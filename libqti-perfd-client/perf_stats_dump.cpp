@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2020 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * perfd-client-stats: print the perf lock and hint counters recorded by
+ * libqti-perfd-client, one block per calling process. -r clears them.
+ */
+
+#include "perf_stats.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static void dumpBlock(const std::string& caller, PerfStatsBlock* block, bool reset) {
+    if (block->magic != PERF_STATS_MAGIC || block->version != PERF_STATS_VERSION) {
+        printf("%s: unknown layout\n\n", caller.c_str());
+        return;
+    }
+
+    uint64_t elapsed = 0;
+    time_t now = time(nullptr);
+    if (now > static_cast<time_t>(block->startSec)) {
+        elapsed = now - block->startSec;
+    }
+
+    printf("%s: %llu s, %llu dropped\n", caller.c_str(), (unsigned long long)elapsed,
+           (unsigned long long)block->dropped.load());
+    printf("  %-4s %-10s %10s %8s %8s %10s %10s\n", "kind", "id", "count", "per-h", "untimed",
+           "avg-ms", "max-ms");
+
+    for (PerfStatsEntry& entry : block->entries) {
+        uint64_t key = entry.key.load();
+        if (key == 0) {
+            continue;
+        }
+
+        uint64_t count = entry.count.load();
+        uint64_t untimed = entry.untimed.load();
+        uint64_t timed = count - untimed;
+        printf("  %-4s 0x%08x %10llu %8llu %8llu %10llu %10llu\n",
+               (key >> 32) == PERF_STATS_KIND_HINT ? "hint" : "lock",
+               static_cast<uint32_t>(key), (unsigned long long)count,
+               (unsigned long long)(elapsed ? count * 3600 / elapsed : 0),
+               (unsigned long long)untimed,
+               (unsigned long long)(timed ? entry.totalMs.load() / timed : 0),
+               (unsigned long long)entry.maxMs.load());
+    }
+    printf("\n");
+
+    if (reset) {
+        // the clients keep their mapping, so clear the counters in place
+        for (PerfStatsEntry& entry : block->entries) {
+            entry.count = 0;
+            entry.untimed = 0;
+            entry.totalMs = 0;
+            entry.maxMs = 0;
+        }
+        block->dropped = 0;
+        block->startSec = now;
+    }
+}
+
+int main(int argc, char** argv) {
+    bool reset = argc > 1 && !strcmp(argv[1], "-r");
+
+    DIR* dir = opendir(PERF_STATS_DIR);
+    if (!dir) {
+        fprintf(stderr, "failed to open %s: %s\n", PERF_STATS_DIR, strerror(errno));
+        return 1;
+    }
+
+    const size_t suffixLen = strlen(PERF_STATS_SUFFIX);
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        std::string name = ent->d_name;
+        if (name.size() <= suffixLen ||
+            name.compare(name.size() - suffixLen, suffixLen, PERF_STATS_SUFFIX)) {
+            continue;
+        }
+
+        std::string path = std::string(PERF_STATS_DIR) + "/" + name;
+        int fd = open(path.c_str(), (reset ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, "failed to open %s: %s\n", path.c_str(), strerror(errno));
+            continue;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) || st.st_size != sizeof(PerfStatsBlock)) {
+            close(fd);
+            continue;
+        }
+
+        void* addr = mmap(nullptr, sizeof(PerfStatsBlock), PROT_READ | (reset ? PROT_WRITE : 0),
+                          MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            continue;
+        }
+
+        dumpBlock(name.substr(0, name.size() - suffixLen), static_cast<PerfStatsBlock*>(addr),
+                  reset);
+        munmap(addr, sizeof(PerfStatsBlock));
+    }
+    closedir(dir);
+
+    return 0;
+}
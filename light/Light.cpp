@@ -20,56 +20,211 @@
 
 #include "Light.h"
 
-#include <fstream>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
 
-#define NOTIFICATION_LED_LEFT(x) "/sys/class/leds/left/" + x
-#define NOTIFICATION_LED_WHITE(x) "/sys/class/leds/white/" + x
+#include <algorithm>
+#include <array>
+#include <string>
+
+#define NOTIFICATION_LED_LEFT  "/sys/class/leds/left/"
+#define NOTIFICATION_LED_WHITE "/sys/class/leds/white/"
 
 #define BREATH              "breath"
 #define BRIGHTNESS          "brightness"
 #define MAX_BRIGHTNESS      "max_brightness"
 
+/* LPG lookup table the controller runs when breath is set. */
+#define LUT_PATTERN         "lut_pattern"
+#define LO_IDX              "lo_idx"
+#define PAUSE_LO_COUNT      "pause_lo_count"
+#define STEP_MS             "step_ms"
+
+#define LUT_MAX_STEP_MS     1000
+#define LUT_MAX_PAUSE_COUNT 255
+
 namespace {
 /*
- * Get the full path to the led node.
+ * Get the directory of the led, left if the device has one, white otherwise.
  */
-static std::string getLedPath(std::string path) {
-    std::ifstream left_path(NOTIFICATION_LED_LEFT(path));
-    return left_path.good() ? NOTIFICATION_LED_LEFT(path) : NOTIFICATION_LED_WHITE(path);
+static std::string getLedDir() {
+    return access(NOTIFICATION_LED_LEFT BRIGHTNESS, F_OK) == 0 ? NOTIFICATION_LED_LEFT
+                                                               : NOTIFICATION_LED_WHITE;
 }
 
 /*
- * Write value to path and close file.
+ * A led sysfs attribute, kept open once opened. Opening is retried on use,
+ * the attributes may not be accessible yet when the service starts.
  */
-static void set(std::string path, std::string value) {
-    std::ofstream file(getLedPath(path));
+class LedAttribute {
+  public:
+    LedAttribute(const std::string& dir, const char* name, int flags)
+        : path(dir + name), flags(flags | O_CLOEXEC), fd(-1) {
+        reopen();
+    }
 
-    if (!file.is_open()) {
-        ALOGW("failed to write %s to %s", value.c_str(), path.c_str());
-        return;
+    ~LedAttribute() {
+        if (fd >= 0) {
+            close(fd);
+        }
     }
 
-    file << value;
-}
+    bool write(const std::string& str) {
+        if (!reopen() || pwrite(fd, str.c_str(), str.size(), 0) != (ssize_t)str.size()) {
+            ALOGW("failed to write %s to %s", str.c_str(), path.c_str());
+            return false;
+        }
 
-static void set(std::string path, int value) {
-    set(path, std::to_string(value));
-}
+        return true;
+    }
+
+    bool write(int value) {
+        return write(std::to_string(value));
+    }
+
+    std::string readString() {
+        char buf[256] = {};
+        ssize_t len;
+
+        if (!reopen() || (len = pread(fd, buf, sizeof(buf) - 1, 0)) <= 0) {
+            ALOGW("failed to read from %s", path.c_str());
+            return "";
+        }
+
+        /* Drop the trailing newline, the value is written back as is. */
+        if (buf[len - 1] == '\n') {
+            buf[len - 1] = '\0';
+        }
+
+        return buf;
+    }
+
+    int read() {
+        return atoi(readString().c_str());
+    }
+
+  private:
+    bool reopen() {
+        if (fd < 0) {
+            fd = open(path.c_str(), flags);
+        }
+        return fd >= 0;
+    }
+
+    const std::string path;
+    const int flags;
+    int fd;
+};
 
 /*
- * Read max brightness from path and close file.
+ * Lookup table setup of the led: the pattern, the index the controller
+ * pauses at, the pause in steps and the step time.
  */
-static int getMaxBrightness(std::string path) {
-    std::ifstream file(getLedPath(path));
-    int value;
+struct LedLut {
+    std::string pattern;
+    int loIdx;
+    int pauseLoCount;
+    int stepMs;
+
+    bool operator==(const LedLut& other) const {
+        return pattern == other.pattern && loIdx == other.loIdx &&
+               pauseLoCount == other.pauseLoCount && stepMs == other.stepMs;
+    }
+};
 
-    if (!file.is_open()) {
-        ALOGW("failed to read from %s", path.c_str());
-        return 0;
+struct NotificationLed {
+    const std::string dir;
+    LedAttribute breath;
+    LedAttribute brightness;
+    LedAttribute maxBrightnessAttr;
+    uint32_t maxBrightness;
+
+    LedAttribute lutPattern;
+    LedAttribute loIdx;
+    LedAttribute pauseLoCount;
+    LedAttribute stepMs;
+    /* Whether the led has a lookup table, and the breathing one it came with. */
+    bool hasLut;
+    LedLut breathLut;
+    LedLut currentLut;
+
+    NotificationLed()
+        : dir(getLedDir()),
+          breath(dir, BREATH, O_WRONLY),
+          brightness(dir, BRIGHTNESS, O_WRONLY),
+          maxBrightnessAttr(dir, MAX_BRIGHTNESS, O_RDONLY),
+          maxBrightness(maxBrightnessAttr.read()),
+          lutPattern(dir, LUT_PATTERN, O_RDWR),
+          loIdx(dir, LO_IDX, O_RDWR),
+          pauseLoCount(dir, PAUSE_LO_COUNT, O_RDWR),
+          stepMs(dir, STEP_MS, O_RDWR),
+          hasLut(false) {
+        if (access((dir + LUT_PATTERN).c_str(), F_OK) == 0) {
+            breathLut = {lutPattern.readString(), loIdx.read(), pauseLoCount.read(),
+                         stepMs.read()};
+            hasLut = !breathLut.pattern.empty();
+            currentLut = breathLut;
+        }
+    }
+
+    bool setLut(const LedLut& lut) {
+        if (lut == currentLut) {
+            return true;
+        }
+
+        /* Invalidate first, a partly written table must not match anything. */
+        currentLut = {};
+        if (!lutPattern.write(lut.pattern) || !loIdx.write(lut.loIdx) ||
+                !pauseLoCount.write(lut.pauseLoCount) || !stepMs.write(lut.stepMs)) {
+            return false;
+        }
+
+        currentLut = lut;
+        return true;
+    }
+
+    /*
+     * Blink in the led controller: a two entry table, off then on, run at
+     * one step per on time, with the off time as a pause at the off entry.
+     * Returns false if the led has no table or the timing does not fit it.
+     */
+    bool setLutBlink(uint32_t brightness, int onMs, int offMs) {
+        if (!hasLut || onMs <= 0 || onMs > LUT_MAX_STEP_MS || offMs < onMs ||
+                offMs / onMs > LUT_MAX_PAUSE_COUNT || !getMaxBrightness()) {
+            return false;
+        }
+
+        uint32_t percent = std::max(brightness * 100 / getMaxBrightness(), 1u);
+        LedLut lut = {"0," + std::to_string(percent), 0, offMs / onMs, onMs};
+
+        return setLut(lut) && breath.write(1);
+    }
+
+    /*
+     * Breathe with the table the led came with.
+     */
+    void setBreath() {
+        if (hasLut) {
+            setLut(breathLut);
+        }
+        breath.write(1);
     }
 
-    file >> value;
-    return value;
+    /*
+     * max_brightness does not change, read it again only if it was not read yet.
+     */
+    uint32_t getMaxBrightness() {
+        if (!maxBrightness) {
+            maxBrightness = maxBrightnessAttr.read();
+        }
+        return maxBrightness;
+    }
+};
+
+static NotificationLed& getNotificationLed() {
+    static NotificationLed led;
+    return led;
 }
 
 static uint32_t getBrightness(const LightState& state) {
@@ -106,25 +261,31 @@ static inline uint32_t getScaledBrightness(const LightState& state, uint32_t max
 }
 
 static void handleNotification(const LightState& state) {
-    uint32_t notificationBrightness = getScaledBrightness(state, getMaxBrightness(MAX_BRIGHTNESS));
+    NotificationLed& led = getNotificationLed();
+    uint32_t notificationBrightness = getScaledBrightness(state, led.getMaxBrightness());
 
     /* Disable breathing or blinking */
-    set(BREATH, 0);
-    set(BRIGHTNESS, 0);
+    led.breath.write(0);
+    led.brightness.write(0);
 
     if (!notificationBrightness) {
         return;
     }
 
     switch (state.flashMode) {
-        case Flash::HARDWARE:
         case Flash::TIMED:
+            /* Blinking, run by the led controller if it fits its table */
+            if (led.setLutBlink(notificationBrightness, state.flashOnMs, state.flashOffMs)) {
+                break;
+            }
+            [[fallthrough]];
+        case Flash::HARDWARE:
             /* Breathing */
-            set(BREATH, 1);
+            led.setBreath();
             break;
         case Flash::NONE:
         default:
-            set(BRIGHTNESS, notificationBrightness);
+            led.brightness.write(notificationBrightness);
     }
 }
 
@@ -150,14 +311,21 @@ static std::vector<LightBackend> backends = {
     { Type::BATTERY, handleNotification },
 };
 
-static LightStateHandler findHandler(Type type) {
-    for (const LightBackend& backend : backends) {
-        if (backend.type == type) {
-            return backend.handler;
-        }
+/* Index of backends by type, nullptr for unsupported types. */
+static const std::array<LightBackend*, static_cast<size_t>(Type::COUNT)> backendsByType = [] {
+    std::array<LightBackend*, static_cast<size_t>(Type::COUNT)> table = {};
+
+    for (LightBackend& backend : backends) {
+        table[static_cast<size_t>(backend.type)] = &backend;
     }
 
-    return nullptr;
+    return table;
+}();
+
+static LightBackend* findBackend(Type type) {
+    size_t index = static_cast<size_t>(type);
+
+    return index < backendsByType.size() ? backendsByType[index] : nullptr;
 }
 
 static LightState findLitState(LightStateHandler handler) {
@@ -176,14 +344,6 @@ static LightState findLitState(LightStateHandler handler) {
     return emptyState;
 }
 
-static void updateState(Type type, const LightState& state) {
-    for (LightBackend& backend : backends) {
-        if (backend.type == type) {
-            backend.state = state;
-        }
-    }
-}
-
 }  // anonymous namespace
 
 namespace android {
@@ -192,30 +352,50 @@ namespace light {
 namespace V2_0 {
 namespace implementation {
 
+Light::Light() : ledApplied(false) {
+#ifndef LIGHT_LAZY_HAL
+    /* Resolve the led and open its attributes once, at service start. */
+    getNotificationLed();
+#endif
+}
+
 Return<Status> Light::setLight(Type type, const LightState& state) {
-    /* Lock global mutex until light state is updated. */
+    LightBackend* backend = findBackend(type);
+    if (!backend) {
+        /* If no backend has been found, then the type is not supported. */
+        return Status::LIGHT_NOT_SUPPORTED;
+    }
+
+    LightStateHandler handler = backend->handler;
+
+    /*
+     * Lock global mutex until light state is updated. The service runs a
+     * single binder thread, so it is never contended and costs no more than
+     * an uncontended futex on the way in and out, but all types share the
+     * cached states and the led, which must not be torn if that changes.
+     */
     std::lock_guard<std::mutex> lock(globalLock);
 
-    LightStateHandler handler = findHandler(type);
-    if (!handler) {
-        /* If no handler has been found, then the type is not supported. */
-        return Status::LIGHT_NOT_SUPPORTED;
+    /* The lit state of the handler can only change with the state of this type. */
+    if (ledApplied && isStateEqual(backend->state, state)) {
+        return Status::SUCCESS;
     }
 
     /* Find the old state of the current handler. */
     LightState oldState = findLitState(handler);
 
     /* Update the cached state value for the current type. */
-    updateState(type, state);
+    backend->state = state;
 
     /* Find the new state of the current handler. */
     LightState newState = findLitState(handler);
 
-    if (isStateEqual(oldState, newState)) {
+    if (ledApplied && isStateEqual(oldState, newState)) {
         return Status::SUCCESS;
     }
 
     handler(newState);
+    ledApplied = true;
 
     return Status::SUCCESS;
 }
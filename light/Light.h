@@ -52,11 +52,16 @@ namespace implementation {
 
 class Light : public ILight {
   public:
+    Light();
+
     Return<Status> setLight(Type type, const LightState& state) override;
     Return<void> getSupportedTypes(getSupportedTypes_cb _hidl_cb) override;
 
   private:
+    /* Guards the cached backend states, ledApplied and the led writes. */
     std::mutex globalLock;
+    /* Whether the led was set by this process, it may be left lit by an earlier one. */
+    bool ledApplied;
 };
 
 }  // namespace implementation
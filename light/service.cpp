@@ -16,12 +16,14 @@
 
 #define LOG_TAG "android.hardware.light@2.0-service.xiaomi_sm6150"
 
+#include <hidl/HidlLazyUtils.h>
 #include <hidl/HidlTransportSupport.h>
 
 #include "Light.h"
 
 using android::hardware::configureRpcThreadpool;
 using android::hardware::joinRpcThreadpool;
+using android::hardware::LazyServiceRegistrar;
 
 using android::hardware::light::V2_0::ILight;
 using android::hardware::light::V2_0::implementation::Light;
@@ -35,7 +37,12 @@ int main() {
 
     configureRpcThreadpool(1, true);
 
+#ifdef LIGHT_LAZY_HAL
+    /* init starts the service on the first request, it exits once no client is left. */
+    status_t status = LazyServiceRegistrar::getInstance().registerService(service);
+#else
     status_t status = service->registerAsService();
+#endif
     if (status != OK) {
         ALOGE("Cannot register Light HAL service.");
         return 1;
@@ -16,10 +16,6 @@
 
 #define LOG_TAG "AntiFlickerService"
 
-#include <android-base/file.h>
-#include <android-base/logging.h>
-#include <android-base/strings.h>
-
 #include "AntiFlicker.h"
 
 namespace vendor {
@@ -31,21 +27,15 @@ namespace implementation {
 static constexpr const char* kAntiFlickerStatusPath =
         "/sys/devices/platform/soc/soc:qcom,dsi-display/anti_flicker";
 
+AntiFlicker::AntiFlicker() : mNode(kAntiFlickerStatusPath) {}
+
 Return<bool> AntiFlicker::isEnabled() {
-    std::string buf;
-    if (!android::base::ReadFileToString(kAntiFlickerStatusPath, &buf)) {
-        LOG(ERROR) << "Failed to read " << kAntiFlickerStatusPath;
-        return false;
-    }
-    return std::stoi(android::base::Trim(buf)) == 1;
+    int value;
+    return mNode.read(&value) && value == 1;
 }
 
 Return<bool> AntiFlicker::setEnabled(bool enabled) {
-    if (!android::base::WriteStringToFile((enabled ? "1" : "0"), kAntiFlickerStatusPath)) {
-        LOG(ERROR) << "Failed to write " << kAntiFlickerStatusPath;
-        return false;
-    }
-    return true;
+    return mNode.write(enabled ? 1 : 0);
 }
 
 }  // namespace implementation
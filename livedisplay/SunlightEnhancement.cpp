@@ -16,10 +16,6 @@
 
 #define LOG_TAG "SunlightEnhancementService"
 
-#include <android-base/file.h>
-#include <android-base/logging.h>
-#include <android-base/strings.h>
-
 #include "SunlightEnhancement.h"
 
 namespace vendor {
@@ -30,21 +26,15 @@ namespace implementation {
 
 static constexpr const char* kHbmStatusPath = "/sys/devices/platform/soc/soc:qcom,dsi-display/hbm";
 
+SunlightEnhancement::SunlightEnhancement() : mNode(kHbmStatusPath) {}
+
 Return<bool> SunlightEnhancement::isEnabled() {
-    std::string buf;
-    if (!android::base::ReadFileToString(kHbmStatusPath, &buf)) {
-        LOG(ERROR) << "Failed to read " << kHbmStatusPath;
-        return false;
-    }
-    return std::stoi(android::base::Trim(buf)) == 1;
+    int value;
+    return mNode.read(&value) && value == 1;
 }
 
 Return<bool> SunlightEnhancement::setEnabled(bool enabled) {
-    if (!android::base::WriteStringToFile((enabled ? "1" : "0"), kHbmStatusPath)) {
-        LOG(ERROR) << "Failed to write " << kHbmStatusPath;
-        return false;
-    }
-    return true;
+    return mNode.write(enabled ? 1 : 0);
 }
 
 }  // namespace implementation
@@ -21,6 +21,8 @@
 #include <hidl/Status.h>
 #include <vendor/lineage/livedisplay/2.1/ISunlightEnhancement.h>
 
+#include "SysfsNode.h"
+
 namespace vendor {
 namespace lineage {
 namespace livedisplay {
@@ -33,9 +35,14 @@ using ::android::hardware::Void;
 
 class SunlightEnhancement : public ISunlightEnhancement {
   public:
+    SunlightEnhancement();
+
     // Methods from ::vendor::lineage::livedisplay::V2_1::ISunlightEnhancement follow.
     Return<bool> isEnabled() override;
     Return<bool> setEnabled(bool enabled) override;
+
+  private:
+    SysfsNode mNode;
 };
 
 }  // namespace implementation
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LiveDisplaySysfsNode"
+
+#include <android-base/logging.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "SysfsNode.h"
+
+namespace vendor {
+namespace lineage {
+namespace livedisplay {
+namespace V2_1 {
+namespace implementation {
+
+SysfsNode::SysfsNode(const char* path) : mPath(path), mFd(-1), mCached(false), mValue(0) {}
+
+SysfsNode::~SysfsNode() {
+    if (mFd >= 0) {
+        close(mFd);
+    }
+}
+
+bool SysfsNode::openLocked() {
+    if (mFd < 0) {
+        mFd = open(mPath, O_RDWR | O_CLOEXEC);
+        if (mFd < 0) {
+            PLOG(ERROR) << "Failed to open " << mPath;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SysfsNode::changedByKernelLocked() {
+    struct pollfd pfd = {.fd = mFd, .events = POLLPRI, .revents = 0};
+
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR));
+}
+
+bool SysfsNode::readLocked() {
+    char buf[16];
+    ssize_t len = pread(mFd, buf, sizeof(buf) - 1, 0);
+
+    if (len <= 0) {
+        PLOG(ERROR) << "Failed to read " << mPath;
+        mCached = false;
+        return false;
+    }
+    buf[len] = '\0';
+    mValue = strtol(buf, nullptr, 10);
+    mCached = true;
+    return true;
+}
+
+bool SysfsNode::read(int* value) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!openLocked()) {
+        return false;
+    }
+    if ((!mCached || changedByKernelLocked()) && !readLocked()) {
+        return false;
+    }
+    *value = mValue;
+    return true;
+}
+
+bool SysfsNode::write(int value) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!openLocked()) {
+        return false;
+    }
+    if (mCached && mValue == value && !changedByKernelLocked()) {
+        return true;
+    }
+
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), "%d", value);
+    if (pwrite(mFd, buf, len, 0) != len) {
+        PLOG(ERROR) << "Failed to write " << mPath;
+        mCached = false;
+        return false;
+    }
+    mValue = value;
+    mCached = true;
+    return true;
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace livedisplay
+}  // namespace lineage
+}  // namespace vendor
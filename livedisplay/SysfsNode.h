@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VENDOR_LINEAGE_LIVEDISPLAY_V2_1_SYSFSNODE_H
+#define VENDOR_LINEAGE_LIVEDISPLAY_V2_1_SYSFSNODE_H
+
+#include <mutex>
+
+namespace vendor {
+namespace lineage {
+namespace livedisplay {
+namespace V2_1 {
+namespace implementation {
+
+/*
+ * An integer sysfs node, kept open, with its last known value cached.
+ * The cache is dropped when the kernel signals a change with sysfs_notify
+ * (POLLPRI), so nodes the kernel only changes that way stay coherent.
+ */
+class SysfsNode {
+  public:
+    explicit SysfsNode(const char* path);
+    ~SysfsNode();
+
+    bool read(int* value);
+    bool write(int value);
+
+  private:
+    bool openLocked();
+    bool changedByKernelLocked();
+    bool readLocked();
+
+    const char* mPath;
+    int mFd;
+    bool mCached;
+    int mValue;
+    std::mutex mLock;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace livedisplay
+}  // namespace lineage
+}  // namespace vendor
+
+#endif  // VENDOR_LINEAGE_LIVEDISPLAY_V2_1_SYSFSNODE_H
@@ -17,13 +17,16 @@
 #define LOG_TAG "vendor.lineage.livedisplay@2.1-service.xiaomi_sm6150"
 
 #include <android-base/logging.h>
+#include <android-base/properties.h>
 #include <binder/ProcessState.h>
+#include <hidl/HidlLazyUtils.h>
 #include <hidl/HidlTransportSupport.h>
 #include <livedisplay/sdm/PictureAdjustment.h>
 
 #include "AntiFlicker.h"
 #include "SunlightEnhancement.h"
 
+using ::android::hardware::LazyServiceRegistrar;
 using ::vendor::lineage::livedisplay::V2_0::sdm::PictureAdjustment;
 using ::vendor::lineage::livedisplay::V2_0::sdm::SDMController;
 using ::vendor::lineage::livedisplay::V2_1::IAntiFlicker;
@@ -35,22 +38,27 @@ int main() {
     std::shared_ptr<SDMController> controller = std::make_shared<SDMController>();
     android::sp<PictureAdjustment> pictureAdjustment = new PictureAdjustment(controller);
 
-    android::hardware::configureRpcThreadpool(1, true /*callerWillJoin*/);
+    // PictureAdjustment calls into SDM, keep to one thread unless asked otherwise
+    size_t threads = android::base::GetUintProperty<size_t>("ro.vendor.livedisplay.threads", 1);
+    android::hardware::configureRpcThreadpool(threads, true /*callerWillJoin*/);
+
+    // hwservicemanager starts the service on demand, it exits once no client holds any of them
+    LazyServiceRegistrar& registrar = LazyServiceRegistrar::getInstance();
 
 #ifdef SUPPORT_ANTI_FLICKER
     android::sp<IAntiFlicker> antiFlicker = new AntiFlicker();
-    if (antiFlicker->registerAsService() != android::OK) {
+    if (registrar.registerService(antiFlicker) != android::OK) {
         LOG(ERROR) << "Cannot register anti flicker HAL service.";
         return 1;
     }
 #endif
-    if (pictureAdjustment->registerAsService() != android::OK) {
+    if (registrar.registerService(pictureAdjustment) != android::OK) {
         LOG(ERROR) << "Cannot register picture adjustment HAL service.";
         return 1;
     }
 #ifdef SUPPORT_SUNLIGHT_ENHANCEMENT
     android::sp<ISunlightEnhancement> sunlightEnhancement = new SunlightEnhancement();
-    if (sunlightEnhancement->registerAsService() != android::OK) {
+    if (registrar.registerService(sunlightEnhancement) != android::OK) {
         LOG(ERROR) << "Cannot register sunlight enhancement HAL service.";
         return 1;
     }
@@ -17,11 +17,29 @@
 #include <aidl/android/hardware/power/BnPower.h>
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
 #include <sys/ioctl.h>
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 // defines from drivers/input/touchscreen/xiaomi/xiaomi_touch.h
 #define SET_CUR_VALUE 0
+#define Touch_Game_Mode 0
+#define Touch_Report_Rate 9
 #define Touch_Doubletap_Mode 14
+#define Touch_Mode_NUM 20
+
+#define TOUCH_REPORT_RATE_NORMAL 0
+#define TOUCH_REPORT_RATE_HIGH 1
+
+// LAUNCH is turned off by the framework once the app is drawn, this only
+// guards against it being left on
+#define LAUNCH_TOUCH_BOOST_MAX_MS 5000
 
 #define TOUCH_DEV_PATH "/dev/xiaomi-touch"
 
@@ -37,6 +55,150 @@ namespace pixel {
 
 using ::aidl::android::hardware::power::Mode;
 
+namespace {
+
+/*
+ * The xiaomi-touch device, opened once and shared by all touch modes. The
+ * value last set for each mode is kept, so the same value is not sent twice.
+ */
+class TouchDevice {
+  public:
+    static TouchDevice& getInstance() {
+        static TouchDevice instance;
+        return instance;
+    }
+
+    bool setMode(int mode, int value) {
+        std::lock_guard<std::mutex> lock(mLock);
+        return setModeLocked(mode, value);
+    }
+
+    /*
+     * Game mode and the high report rate follow the power hints that want low
+     * touch latency, while the device is interactive. A hint given a timeout
+     * is dropped when it runs out, if it was not turned off before.
+     */
+    void setHint(Mode hint, bool enabled, int timeoutMs = 0) {
+        std::lock_guard<std::mutex> lock(mLock);
+        uint32_t index = static_cast<uint32_t>(hint);
+        uint32_t bit = 1u << index;
+
+        mActiveHints = enabled ? (mActiveHints | bit) : (mActiveHints & ~bit);
+        if (enabled && timeoutMs > 0) {
+            mHintDeadlines[index] =
+                    std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            mTimedHints |= bit;
+            startTimerLocked();
+            mTimerCond.notify_one();
+        } else {
+            mTimedHints &= ~bit;
+        }
+        updateTouchModesLocked();
+    }
+
+    void setInteractive(bool interactive) {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        mInteractive = interactive;
+        updateTouchModesLocked();
+    }
+
+  private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    TouchDevice()
+        : mActiveHints(0), mTimedHints(0), mInteractive(true), mTimerStarted(false) {
+        mValues.fill(-1);
+    }
+
+    void startTimerLocked() {
+        if (mTimerStarted) {
+            return;
+        }
+        mTimerStarted = true;
+        // the instance lives as long as the process
+        std::thread([this]() { runTimer(); }).detach();
+    }
+
+    void runTimer() {
+        std::unique_lock<std::mutex> lock(mLock);
+
+        while (true) {
+            if (!mTimedHints) {
+                mTimerCond.wait(lock);
+                continue;
+            }
+
+            TimePoint now = std::chrono::steady_clock::now();
+            TimePoint next = TimePoint::max();
+            uint32_t expired = 0;
+            for (uint32_t index = 0; index < mHintDeadlines.size(); index++) {
+                if (!(mTimedHints & (1u << index))) {
+                    continue;
+                }
+                if (mHintDeadlines[index] <= now) {
+                    expired |= 1u << index;
+                } else if (mHintDeadlines[index] < next) {
+                    next = mHintDeadlines[index];
+                }
+            }
+
+            if (expired) {
+                LOG(INFO) << "Touch boost hints 0x" << std::hex << expired << " timed out";
+                mTimedHints &= ~expired;
+                mActiveHints &= ~expired;
+                updateTouchModesLocked();
+                continue;
+            }
+            mTimerCond.wait_until(lock, next);
+        }
+    }
+
+    bool setModeLocked(int mode, int value) {
+        if (mode < 0 || mode >= Touch_Mode_NUM) {
+            return false;
+        }
+        if (mValues[mode] == value) {
+            return true;
+        }
+        if (mFd < 0) {
+            mFd.reset(open(TOUCH_DEV_PATH, O_RDWR | O_CLOEXEC));
+            if (mFd < 0) {
+                PLOG(ERROR) << "Failed to open " << TOUCH_DEV_PATH;
+                return false;
+            }
+        }
+
+        int arg[2] = {mode, value};
+        if (ioctl(mFd, TOUCH_IOC_SETMODE, &arg) < 0) {
+            PLOG(ERROR) << "Failed to set touch mode " << mode << " to " << value;
+            mValues[mode] = -1;
+            return false;
+        }
+        mValues[mode] = value;
+        return true;
+    }
+
+    void updateTouchModesLocked() {
+        bool boost = mInteractive && mActiveHints;
+
+        setModeLocked(Touch_Game_Mode, boost ? 1 : 0);
+        setModeLocked(Touch_Report_Rate, boost ? TOUCH_REPORT_RATE_HIGH : TOUCH_REPORT_RATE_NORMAL);
+    }
+
+    std::mutex mLock;
+    ::android::base::unique_fd mFd;
+    std::array<int, Touch_Mode_NUM> mValues;
+    uint32_t mActiveHints;
+    uint32_t mTimedHints;
+    std::array<TimePoint, 32> mHintDeadlines;
+    bool mInteractive;
+    bool mTimerStarted;
+    std::condition_variable mTimerCond;
+};
+
+}  // anonymous namespace
+
 bool isDeviceSpecificModeSupported(Mode type, bool* _aidl_return) {
     switch (type) {
         case Mode::DOUBLE_TAP_TO_WAKE:
@@ -48,14 +210,23 @@ bool isDeviceSpecificModeSupported(Mode type, bool* _aidl_return) {
 }
 
 bool setDeviceSpecificMode(Mode type, bool enabled) {
+    TouchDevice& touch = TouchDevice::getInstance();
+
     switch (type) {
-        case Mode::DOUBLE_TAP_TO_WAKE: {
-            int fd = open(TOUCH_DEV_PATH, O_RDWR);
-            int arg[2] = {Touch_Doubletap_Mode, enabled ? 1 : 0};
-            ioctl(fd, TOUCH_IOC_SETMODE, &arg);
-            close(fd);
+        case Mode::DOUBLE_TAP_TO_WAKE:
+            touch.setMode(Touch_Doubletap_Mode, enabled ? 1 : 0);
             return true;
-        }
+        // The touch modes follow these, libperfmgr still handles the hints.
+        case Mode::LAUNCH:
+            touch.setHint(type, enabled, LAUNCH_TOUCH_BOOST_MAX_MS);
+            return false;
+        case Mode::GAME:
+        case Mode::SUSTAINED_PERFORMANCE:
+            touch.setHint(type, enabled);
+            return false;
+        case Mode::INTERACTIVE:
+            touch.setInteractive(enabled);
+            return false;
         default:
             return false;
     }
@@ -20,7 +20,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
@@ -32,130 +31,85 @@
 #include "edify/expr.h"
 #include "otautil/error_code.h"
 
-#define MAX(a, b) (((a) > (b)) ? (a) : (b))
-
-#define ALPHABET_LEN 256
-
 #define BASEBAND_PART_PATH "/dev/block/bootdevice/by-name/modem"
 #define BASEBAND_VER_STR_START "QC_IMAGE_VERSION_STRING=MPSS.AT."
 #define BASEBAND_VER_STR_START_LEN 32
 #define BASEBAND_VER_BUF_LEN 255
 
-/* Boyer-Moore string search implementation from Wikipedia */
-
-/* Return longest suffix length of suffix ending at str[p] */
-static int max_suffix_len(const char* str, size_t str_len, size_t p) {
-    uint32_t i;
-
-    for (i = 0; (str[p - i] == str[str_len - 1 - i]) && (i < p);) {
-        i++;
-    }
+/* The modem image is read in chunks of this size, aligned to it */
+#define BASEBAND_READ_CHUNK (1024 * 1024)
 
-    return i;
-}
-
-/* Generate table of distance between last character of pat and rightmost
- * occurrence of character c in pat
+/* Find pat in str. memchr() is vectorized, so it skips quickly to the
+ * candidates for the first byte and only those get compared in full.
  */
-static void bm_make_delta1(int* delta1, const char* pat, size_t pat_len) {
-    uint32_t i;
-    for (i = 0; i < ALPHABET_LEN; i++) {
-        delta1[i] = pat_len;
-    }
-    for (i = 0; i < pat_len - 1; i++) {
-        uint8_t idx = (uint8_t)pat[i];
-        delta1[idx] = pat_len - 1 - i;
-    }
-}
-
-/* Generate table of next possible full match from mismatch at pat[p] */
-static void bm_make_delta2(int* delta2, const char* pat, size_t pat_len) {
-    int p;
-    uint32_t last_prefix = pat_len - 1;
-
-    for (p = pat_len - 1; p >= 0; p--) {
-        /* Compare whether pat[p-pat_len] is suffix of pat */
-        if (strncmp(pat + p, pat, pat_len - p) == 0) {
-            last_prefix = p + 1;
+static const char* find_prefix(const char* str, size_t str_len, const char* pat, size_t pat_len) {
+    const char* end = str + str_len;
+    const char* p = str;
+
+    while ((size_t)(end - p) >= pat_len) {
+        p = (const char*)memchr(p, pat[0], end - p - pat_len + 1);
+        if (p == NULL) {
+            return NULL;
         }
-        delta2[p] = last_prefix + (pat_len - 1 - p);
-    }
-
-    for (p = 0; p < (int)pat_len - 1; p++) {
-        /* Get longest suffix of pattern ending on character pat[p] */
-        int suf_len = max_suffix_len(pat, pat_len, p);
-        if (pat[p - suf_len] != pat[pat_len - 1 - suf_len]) {
-            delta2[pat_len - 1 - suf_len] = pat_len - 1 - p + suf_len;
+        if (memcmp(p + 1, pat + 1, pat_len - 1) == 0) {
+            return p;
         }
-    }
-}
-
-static char* bm_search(const char* str, size_t str_len, const char* pat, size_t pat_len) {
-    int delta1[ALPHABET_LEN];
-    int delta2[pat_len];
-    int i;
-
-    bm_make_delta1(delta1, pat, pat_len);
-    bm_make_delta2(delta2, pat, pat_len);
-
-    if (pat_len == 0) {
-        return (char*)str;
-    }
-
-    i = pat_len - 1;
-    while (i < (int)str_len) {
-        int j = pat_len - 1;
-        while (j >= 0 && (str[i] == pat[j])) {
-            i--;
-            j--;
-        }
-        if (j < 0) {
-            return (char*)(str + i + 1);
-        }
-        i += MAX(delta1[(uint8_t)str[i]], delta2[j]);
+        p++;
     }
 
     return NULL;
 }
 
 static int get_baseband_version(char *ver_str, size_t len) {
-    int ret = 0;
+    const size_t overlap = BASEBAND_VER_STR_START_LEN - 1;
+    std::vector<char> buf(overlap + BASEBAND_READ_CHUNK);
+    size_t kept = 0;
+    off64_t read_off = 0;
+    int ret = -ENOENT;
     int fd;
-    int baseband_size;
-    char *baseband_data = NULL;
-    char *offset = NULL;
 
-    fd = open(BASEBAND_PART_PATH, O_RDONLY);
+    fd = open(BASEBAND_PART_PATH, O_RDONLY | O_CLOEXEC);
     if (fd < 0) {
-        ret = errno;
-        goto err_ret;
-    }
-
-    baseband_size = lseek64(fd, 0, SEEK_END);
-    if (baseband_size == -1) {
-        ret = errno;
-        goto err_fd_close;
-    }
-
-    baseband_data = (char *) mmap(NULL, baseband_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (baseband_data == (char *)-1) {
-        ret = errno;
-        goto err_fd_close;
+        return errno;
     }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    /* Stream the image and stop at the first match, the version string
+     * sits in the first part of it. The last bytes of each chunk are kept
+     * in front of the next one so a prefix across the boundary is found.
+     */
+    while (true) {
+        ssize_t n = TEMP_FAILURE_RETRY(pread64(fd, buf.data() + kept, BASEBAND_READ_CHUNK,
+                read_off));
+        if (n < 0) {
+            ret = errno;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        read_off += n;
+
+        size_t avail = kept + n;
+        const char* match = find_prefix(buf.data(), avail, BASEBAND_VER_STR_START,
+                BASEBAND_VER_STR_START_LEN);
+        if (match != NULL) {
+            off64_t ver_off = read_off - avail + (match - buf.data()) + BASEBAND_VER_STR_START_LEN;
+            ssize_t ver_len = TEMP_FAILURE_RETRY(pread64(fd, ver_str, len - 1, ver_off));
+            if (ver_len < 0) {
+                ret = errno;
+            } else {
+                ver_str[ver_len] = '\0';
+                ret = 0;
+            }
+            break;
+        }
 
-    /* Do Boyer-Moore search across BASEBAND data */
-    offset = bm_search(baseband_data, baseband_size, BASEBAND_VER_STR_START,
-            BASEBAND_VER_STR_START_LEN);
-    if (offset != NULL) {
-        strncpy(ver_str, offset + BASEBAND_VER_STR_START_LEN, len);
-    } else {
-        ret = -ENOENT;
+        kept = avail < overlap ? avail : overlap;
+        memmove(buf.data(), buf.data() + avail - kept, kept);
     }
 
-    munmap(baseband_data, baseband_size);
-err_fd_close:
     close(fd);
-err_ret:
     return ret;
 }
 
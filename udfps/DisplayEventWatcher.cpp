@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "UdfpsHandler.xiaomi_sm6150"
+
+#include "DisplayEventWatcher.h"
+
+#include <android-base/logging.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+// backoff after epoll or read errors, so a broken node can't spin the cpu
+#define ERROR_BACKOFF_MIN_MS 10
+#define ERROR_BACKOFF_MAX_MS 5000
+
+DisplayEventWatcher::DisplayEventWatcher()
+    : mEpollFd(epoll_create1(EPOLL_CLOEXEC)), mStopFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    if (mEpollFd < 0 || mStopFd < 0) {
+        PLOG(ERROR) << "failed to set up display event watcher";
+        return;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, mStopFd.get(), &ev)) {
+        PLOG(ERROR) << "failed to add stop event";
+    }
+}
+
+DisplayEventWatcher::~DisplayEventWatcher() {
+    stop();
+}
+
+bool DisplayEventWatcher::addLocked(Node& node) {
+    node.fd.reset(open(node.path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (node.fd < 0) {
+        PLOG(ERROR) << "failed to open " << node.path;
+        return false;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLPRI | EPOLLERR;
+    ev.data.ptr = &node;
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, node.fd.get(), &ev)) {
+        PLOG(ERROR) << "failed to watch " << node.path;
+        node.fd.reset();
+        return false;
+    }
+    return true;
+}
+
+bool DisplayEventWatcher::watch(const std::string& path, Callback callback) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mNodes.push_back(std::make_unique<Node>());
+    Node& node = *mNodes.back();
+    node.path = path;
+    node.callback = std::move(callback);
+
+    if (!addLocked(node)) {
+        mNodes.pop_back();
+        return false;
+    }
+    return true;
+}
+
+bool DisplayEventWatcher::start() {
+    if (mEpollFd < 0 || mStopFd < 0) {
+        return false;
+    }
+    if (!mThread.joinable()) {
+        mThread = std::thread(&DisplayEventWatcher::run, this);
+    }
+    return true;
+}
+
+void DisplayEventWatcher::stop() {
+    if (!mThread.joinable()) {
+        return;
+    }
+
+    uint64_t one = 1;
+    if (write(mStopFd.get(), &one, sizeof(one)) != sizeof(one)) {
+        PLOG(ERROR) << "failed to signal stop";
+    }
+    mThread.join();
+
+    uint64_t count;
+    (void)!read(mStopFd.get(), &count, sizeof(count));
+}
+
+bool DisplayEventWatcher::dispatch(Node& node, Clock::time_point when) {
+    char buf[32];
+
+    // pread, the node is read from the start and sysfs_notify() re-armed
+    ssize_t rc = TEMP_FAILURE_RETRY(pread(node.fd.get(), buf, sizeof(buf) - 1, 0));
+    if (rc < 0) {
+        PLOG(ERROR) << "failed to read " << node.path;
+        return false;
+    }
+
+    std::string value(buf, rc);
+    while (!value.empty() && (value.back() == '\n' || value.back() == ' ')) {
+        value.pop_back();
+    }
+    node.callback(value, when);
+    return true;
+}
+
+bool DisplayEventWatcher::waitForStop(int timeoutMs) {
+    struct pollfd stopPoll = {
+            .fd = mStopFd.get(),
+            .events = POLLIN,
+            .revents = 0,
+    };
+    return TEMP_FAILURE_RETRY(poll(&stopPoll, 1, timeoutMs)) > 0;
+}
+
+void DisplayEventWatcher::run() {
+    int backoffMs = 0;
+
+    // sysfs reports every node readable right away, consume the current values
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto& node : mNodes) {
+            dispatch(*node, Clock::now());
+        }
+    }
+
+    while (true) {
+        if (backoffMs) {
+            // a node that fails to read stays pending, don't spin on it
+            if (waitForStop(backoffMs)) {
+                return;
+            }
+        }
+
+        struct epoll_event events[4];
+        int rc = epoll_wait(mEpollFd.get(), events, 4, -1);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            PLOG(ERROR) << "failed to wait for display events";
+            backoffMs = std::clamp(backoffMs * 2, ERROR_BACKOFF_MIN_MS, ERROR_BACKOFF_MAX_MS);
+            continue;
+        }
+
+        bool ok = true;
+        Clock::time_point when = Clock::now();
+        std::lock_guard<std::mutex> lock(mLock);
+        for (int i = 0; i < rc; i++) {
+            Node* node = static_cast<Node*>(events[i].data.ptr);
+            if (!node) {
+                return;
+            }
+            ok &= dispatch(*node, when);
+        }
+        backoffMs = ok ? 0 : std::clamp(backoffMs * 2, ERROR_BACKOFF_MIN_MS, ERROR_BACKOFF_MAX_MS);
+    }
+}
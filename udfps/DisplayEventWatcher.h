@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Watches sysfs nodes of the display driver that are sysfs_notify()'d on
+ * change, such as fod_ui, from a single epoll thread. Callbacks run on
+ * that thread with the new value of the node and the time the change was
+ * picked up.
+ */
+class DisplayEventWatcher {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void(const std::string& value, Clock::time_point when)>;
+
+    DisplayEventWatcher();
+    ~DisplayEventWatcher();
+
+    /* Watch path, may be called before or after start(). */
+    bool watch(const std::string& path, Callback callback);
+
+    bool start();
+    /* Stop and join the thread, callbacks are not called anymore once it returns. */
+    void stop();
+
+  private:
+    struct Node {
+        std::string path;
+        android::base::unique_fd fd;
+        Callback callback;
+    };
+
+    bool addLocked(Node& node);
+    bool dispatch(Node& node, Clock::time_point when);
+    bool waitForStop(int timeoutMs);
+    void run();
+
+    android::base::unique_fd mEpollFd;
+    android::base::unique_fd mStopFd;
+    std::mutex mLock;
+    // Node pointers are handed to epoll, so they must not move
+    std::vector<std::unique_ptr<Node>> mNodes;
+    std::thread mThread;
+};
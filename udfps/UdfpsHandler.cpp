@@ -7,13 +7,16 @@
 #define LOG_TAG "UdfpsHandler.xiaomi_sm6150"
 
 #include "UdfpsHandler.h"
+#include "DisplayEventWatcher.h"
+#include "UdfpsLatency.h"
 
 #include <android-base/logging.h>
 #include <android-base/unique_fd.h>
 #include <fcntl.h>
-#include <poll.h>
+#include <sys/ioctl.h>
 #include <unistd.h>
-#include <thread>
+#include <chrono>
+#include <mutex>
 
 // Fingerprint hwmodule commands
 #define COMMAND_NIT 10
@@ -30,24 +33,8 @@
 
 #define FOD_UI_PATH "/sys/devices/platform/soc/soc:qcom,dsi-display/fod_ui"
 
-static bool readBool(int fd) {
-    char c;
-    int rc;
-
-    rc = lseek(fd, 0, SEEK_SET);
-    if (rc) {
-        LOG(ERROR) << "failed to seek fd, err: " << rc;
-        return false;
-    }
-
-    rc = read(fd, &c, sizeof(char));
-    if (rc != 1) {
-        LOG(ERROR) << "failed to read bool from fd, err: " << rc;
-        return false;
-    }
-
-    return c != '0';
-}
+// fod_ui to COMMAND_NIT taking longer than this is worth a warning
+#define FOD_UI_NIT_SLOW_US 16000
 
 class XiaomiUdfpsHander : public UdfpsHandler {
   public:
@@ -55,62 +42,115 @@ class XiaomiUdfpsHander : public UdfpsHandler {
         mDevice = device;
         touch_fd_ = android::base::unique_fd(open(TOUCH_DEV_PATH, O_RDWR));
 
-        std::thread([this]() {
-            int fd = open(FOD_UI_PATH, O_RDONLY);
-            if (fd < 0) {
-                LOG(ERROR) << "failed to open fd, err: " << fd;
-                return;
-            }
-
-            struct pollfd fodUiPoll = {
-                    .fd = fd,
-                    .events = POLLERR | POLLPRI,
-                    .revents = 0,
-            };
-
-            while (true) {
-                int rc = poll(&fodUiPoll, 1, -1);
-                if (rc < 0) {
-                    LOG(ERROR) << "failed to poll fd, err: " << rc;
-                    continue;
-                }
-
-                mDevice->extCmd(mDevice, COMMAND_NIT,
-                                readBool(fd) ? PARAM_NIT_UDFPS : PARAM_NIT_NONE);
-            }
-        }).detach();
+        mWatcher.watch(FOD_UI_PATH, [this](const std::string& value,
+                                           DisplayEventWatcher::Clock::time_point when) {
+            onFodUi(value != "0", when);
+        });
+        mWatcher.start();
+    }
+
+    ~XiaomiUdfpsHander() {
+        // the callback uses mDevice, which must not outlive the handler
+        mWatcher.stop();
     }
 
     void onFingerDown(uint32_t /*x*/, uint32_t /*y*/, float /*minor*/, float /*major*/) {
-        // nothing
+        mLatency.fingerDown(UdfpsLatency::Clock::now());
+        /*
+         * Light the sensor area right away instead of waiting for fod_ui,
+         * which only follows once the UI has drawn the pressed icon.
+         */
+        setNit(PARAM_NIT_UDFPS);
+        mLatency.mark(UdfpsLatency::STAGE_NIT, UdfpsLatency::Clock::now());
+        setTouchUdfps(UDFPS_STATUS_ON);
+        mLatency.mark(UdfpsLatency::STAGE_TOUCH, UdfpsLatency::Clock::now());
     }
 
     void onFingerUp() {
-        // nothing
+        // back to what fod_ui asks for, as if onFingerDown had not lit it
+        restoreNit();
     }
 
     void onAcquired(int32_t result, int32_t vendorCode) {
         if (result == FINGERPRINT_ACQUIRED_GOOD) {
-            int arg[2] = {TOUCH_UDFPS_ENABLE, UDFPS_STATUS_OFF};
-            ioctl(touch_fd_.get(), TOUCH_IOC_SETMODE, &arg);
+            mLatency.mark(UdfpsLatency::STAGE_ACQUIRED, UdfpsLatency::Clock::now());
+            setTouchUdfps(UDFPS_STATUS_OFF);
         } else if (vendorCode == 21 || vendorCode == 23) {
             /*
              * vendorCode = 21 waiting for fingerprint authentication
              * vendorCode = 23 waiting for fingerprint enroll
              */
-            int arg[2] = {TOUCH_UDFPS_ENABLE, UDFPS_STATUS_ON};
-            ioctl(touch_fd_.get(), TOUCH_IOC_SETMODE, &arg);
+            setTouchUdfps(UDFPS_STATUS_ON);
         }
     }
 
     void cancel() {
-        int arg[2] = {TOUCH_UDFPS_ENABLE, UDFPS_STATUS_OFF};
-        ioctl(touch_fd_.get(), TOUCH_IOC_SETMODE, &arg);
+        restoreNit();
+        setTouchUdfps(UDFPS_STATUS_OFF);
     }
 
   private:
+    void setNit(int param) {
+        std::lock_guard<std::mutex> lock(mLock);
+        setNitLocked(param);
+    }
+
+    void setNitLocked(int param) {
+        if (param == mNit) {
+            return;
+        }
+        mDevice->extCmd(mDevice, COMMAND_NIT, param);
+        mNit = param;
+    }
+
+    void restoreNit() {
+        std::lock_guard<std::mutex> lock(mLock);
+        setNitLocked(mFodUi ? PARAM_NIT_UDFPS : PARAM_NIT_NONE);
+    }
+
+    void setTouchUdfps(int status) {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        if (status == mTouchUdfps) {
+            return;
+        }
+        int arg[2] = {TOUCH_UDFPS_ENABLE, status};
+        if (ioctl(touch_fd_.get(), TOUCH_IOC_SETMODE, &arg) < 0) {
+            PLOG(ERROR) << "failed to set touch udfps " << status;
+            return;
+        }
+        mTouchUdfps = status;
+    }
+
+    void onFodUi(bool show, DisplayEventWatcher::Clock::time_point when) {
+        if (show) {
+            mLatency.mark(UdfpsLatency::STAGE_FOD_UI, when);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mFodUi = show;
+            setNitLocked(show ? PARAM_NIT_UDFPS : PARAM_NIT_NONE);
+        }
+
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                          DisplayEventWatcher::Clock::now() - when)
+                          .count();
+        if (us > FOD_UI_NIT_SLOW_US) {
+            LOG(WARNING) << "fod_ui " << show << " took " << us << "us to COMMAND_NIT";
+        } else {
+            LOG(VERBOSE) << "fod_ui " << show << " took " << us << "us to COMMAND_NIT";
+        }
+    }
+
     fingerprint_device_t* mDevice;
     android::base::unique_fd touch_fd_;
+    // last values sent, fod_ui and the fingerprint HAL both drive them
+    std::mutex mLock;
+    int mNit = -1;
+    bool mFodUi = false;
+    int mTouchUdfps = 0;
+    DisplayEventWatcher mWatcher;
+    UdfpsLatency mLatency;
 };
 
 static UdfpsHandler* create() {
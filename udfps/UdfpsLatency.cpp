@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "UdfpsHandler.xiaomi_sm6150"
+#define ATRACE_TAG ATRACE_TAG_HAL
+
+#include "UdfpsLatency.h"
+
+#include <android-base/logging.h>
+#include <cutils/trace.h>
+
+#include <algorithm>
+#include <sstream>
+
+static const char* const kStageNames[UdfpsLatency::STAGE_COUNT] = {
+        "fod_ui",
+        "nit",
+        "touch",
+        "acquired",
+};
+
+// atrace counters, us after finger down
+static const char* const kStageCounters[UdfpsLatency::STAGE_COUNT] = {
+        "udfps_fod_ui_us",
+        "udfps_nit_us",
+        "udfps_touch_us",
+        "udfps_acquired_us",
+};
+
+void UdfpsLatency::fingerDown(Clock::time_point when) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mActive = true;
+    mDown = when;
+    mStageUs.fill(-1);
+}
+
+void UdfpsLatency::mark(Stage stage, Clock::time_point when) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!mActive || when < mDown || mStageUs[stage] >= 0) {
+        return;
+    }
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(when - mDown).count();
+    mStageUs[stage] = us;
+    ATRACE_INT64(kStageCounters[stage], us);
+
+    if (stage == STAGE_ACQUIRED) {
+        finishLocked();
+    }
+}
+
+void UdfpsLatency::finishLocked() {
+    mActive = false;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        if (mStageUs[stage] < 0) {
+            continue;
+        }
+        Window& window = mWindows[stage];
+        window.us[window.next] = static_cast<uint32_t>(
+                std::min<int64_t>(mStageUs[stage], UINT32_MAX));
+        window.next = (window.next + 1) % UDFPS_LATENCY_WINDOW;
+        window.size = std::min<uint32_t>(window.size + 1, UDFPS_LATENCY_WINDOW);
+    }
+
+    LOG(VERBOSE) << "unlock: fod_ui " << mStageUs[STAGE_FOD_UI] << "us, nit "
+                 << mStageUs[STAGE_NIT] << "us, touch " << mStageUs[STAGE_TOUCH]
+                 << "us, acquired " << mStageUs[STAGE_ACQUIRED] << "us";
+    if (++mUnlocks % UDFPS_LATENCY_LOG_EVERY == 0) {
+        logLocked();
+    }
+}
+
+void UdfpsLatency::logLocked() {
+    std::ostringstream out;
+
+    out << "last unlocks, us after finger down p50/p90/max:";
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        const Window& window = mWindows[stage];
+        out << " " << kStageNames[stage];
+        if (window.size == 0) {
+            out << " -";
+            continue;
+        }
+        std::array<uint32_t, UDFPS_LATENCY_WINDOW> sorted = window.us;
+        std::sort(sorted.begin(), sorted.begin() + window.size);
+        out << " " << sorted[(window.size - 1) / 2] << "/" << sorted[(window.size - 1) * 9 / 10]
+            << "/" << sorted[window.size - 1];
+    }
+    LOG(INFO) << out.str();
+}
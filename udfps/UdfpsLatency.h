@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+// unlocks the percentiles are taken over
+#define UDFPS_LATENCY_WINDOW 64
+// log the percentiles after this many unlocks
+#define UDFPS_LATENCY_LOG_EVERY 16
+
+/*
+ * Stage timings of a fingerprint unlock, each taken from onFingerDown().
+ * A stage is set as an atrace counter, in us, when it completes. The
+ * timings of the last UDFPS_LATENCY_WINDOW unlocks that reached
+ * FINGERPRINT_ACQUIRED_GOOD are kept, and their percentiles are logged.
+ * Safe to call from any thread.
+ */
+class UdfpsLatency {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Stage {
+        STAGE_FOD_UI,    // fod_ui poll wakeup
+        STAGE_NIT,       // extCmd(COMMAND_NIT) returned
+        STAGE_TOUCH,     // TOUCH_UDFPS_ENABLE ioctl returned
+        STAGE_ACQUIRED,  // onAcquired(FINGERPRINT_ACQUIRED_GOOD)
+        STAGE_COUNT,
+    };
+
+    /* Start timing an unlock, an unfinished one is dropped. */
+    void fingerDown(Clock::time_point when);
+    /* Stage done at when; ignored outside an unlock, before its finger down or once set. */
+    void mark(Stage stage, Clock::time_point when);
+
+  private:
+    struct Window {
+        std::array<uint32_t, UDFPS_LATENCY_WINDOW> us;
+        uint32_t next = 0;
+        uint32_t size = 0;
+    };
+
+    void finishLocked();
+    void logLocked();
+
+    std::mutex mLock;
+    bool mActive = false;
+    Clock::time_point mDown;
+    // us after finger down, -1 while the stage is pending
+    std::array<int64_t, STAGE_COUNT> mStageUs;
+    std::array<Window, STAGE_COUNT> mWindows;
+    uint32_t mUnlocks = 0;
+};